@@ -448,11 +448,13 @@ namespace spades {
 
 		spades::ui::RadioButton@ driverOpenAL;
 		spades::ui::RadioButton@ driverYSR;
+		spades::ui::RadioButton@ driverSoft;
 		spades::ui::RadioButton@ driverNull;
 
 		spades::ui::TextViewer@ helpView;
 		StartupScreenConfigView@ configViewOpenAL;
 		StartupScreenConfigView@ configViewYSR;
+		StartupScreenConfigView@ configViewSoft;
 
 		StartupScreenAudioOpenALEditor@ editOpenAL;
 
@@ -510,11 +512,28 @@ namespace spades {
 				AddChild(e);
 				@driverYSR = e;
 			}
+			{
+				spades::ui::RadioButton e(Manager);
+				//! The name of the audio driver built into OpenSpades.
+				e.Caption = _Tr("StartupScreen", "Built-in");
+				e.Bounds = AABB2(320.0F, 0.0F, 100.0F, 24.0F);
+				e.GroupName = "driver";
+				HelpHandler(
+					helpView,
+					_Tr("StartupScreen",
+						"Uses the sound engine built into OpenSpades. It doesn't need any "
+						"external library, and features 3D audio with a simple head model, "
+						"sound obstruction, and reverb."))
+					.Watch(e);
+				@e.Activated = spades::ui::EventHandler(this.OnDriverSoft);
+				AddChild(e);
+				@driverSoft = e;
+			}
 			{
 				spades::ui::RadioButton e(Manager);
 				//! The name of audio driver that outputs no audio.
 				e.Caption = _Tr("StartupScreen", "Null");
-				e.Bounds = AABB2(320.0F, 0.0F, 100.0F, 24.0F);
+				e.Bounds = AABB2(430.0F, 0.0F, 100.0F, 24.0F);
 				e.GroupName = "driver";
 				HelpHandler(helpView, _Tr("StartupScreen", "Disables audio output.")).Watch(e);
 				@e.Activated = spades::ui::EventHandler(this.OnDriverNull);
@@ -572,6 +591,27 @@ namespace spades {
 				AddChild(cfg);
 				@configViewYSR = cfg;
 			}
+			{
+				StartupScreenConfigView cfg(Manager);
+
+				cfg.AddRow(StartupScreenConfigSliderItemEditor(
+					ui, StartupScreenConfig(ui, "s_volume"), 0, 100, 1,
+					_Tr("StartupScreen", "Volume"), "",
+					ConfigNumberFormatter(0, "%")));
+
+				cfg.AddRow(StartupScreenConfigSliderItemEditor(
+					ui, StartupScreenConfig(ui, "s_maxPolyphonics"), 16.0, 256.0, 8.0,
+					_Tr("StartupScreen", "Polyphonics"),
+					_Tr("StartupScreen", "Specifies how many sounds can be played simultaneously. "
+						"When the limit is reached, the least audible sound is replaced."),
+					ConfigNumberFormatter(0, " poly")));
+
+				cfg.Finalize();
+				cfg.SetHelpTextHandler(HelpTextHandler(this.HandleHelpText));
+				cfg.Bounds = AABB2(0.0F, 30.0F, mainWidth, size.y - 30.0F);
+				AddChild(cfg);
+				@configViewSoft = cfg;
+			}
 			
 			AddLabel(0.0F, 120.0F, 24.0F, _Tr("StartupScreen", "Output Device"));
 			{
@@ -592,6 +632,10 @@ namespace spades {
 			s_audioDriver.StringValue = "ysr";
 			LoadConfig();
 		}
+		private void OnDriverSoft(spades::ui::UIElement@) {
+			s_audioDriver.StringValue = "soft";
+			LoadConfig();
+		}
 		private void OnDriverNull(spades::ui::UIElement@) {
 			s_audioDriver.StringValue = "null";
 			LoadConfig();
@@ -602,20 +646,30 @@ namespace spades {
 				driverYSR.Check();
 				configViewOpenAL.Visible = false;
 				configViewYSR.Visible = true;
+				configViewSoft.Visible = false;
 			} else if (s_audioDriver.StringValue == "openal") {
 				driverOpenAL.Check();
 				configViewOpenAL.Visible = true;
 				configViewYSR.Visible = false;
+				configViewSoft.Visible = false;
+			} else if (s_audioDriver.StringValue == "soft") {
+				driverSoft.Check();
+				configViewOpenAL.Visible = false;
+				configViewYSR.Visible = false;
+				configViewSoft.Visible = true;
 			} else if (s_audioDriver.StringValue == "null") {
 				driverNull.Check();
 				configViewOpenAL.Visible = false;
 				configViewYSR.Visible = false;
+				configViewSoft.Visible = false;
 			}
 			driverOpenAL.Enable = ui.helper.CheckConfigCapability("s_audioDriver", "openal").length == 0;
 			driverYSR.Enable = ui.helper.CheckConfigCapability("s_audioDriver", "ysr").length == 0;
+			driverSoft.Enable = ui.helper.CheckConfigCapability("s_audioDriver", "soft").length == 0;
 			driverNull.Enable = ui.helper.CheckConfigCapability("s_audioDriver", "null").length == 0;
 			configViewOpenAL.LoadConfig();
 			configViewYSR.LoadConfig();
+			configViewSoft.LoadConfig();
 			editOpenAL.LoadConfig();
 
 			s_openalDevice.StringValue = editOpenAL.openal.StringValue;
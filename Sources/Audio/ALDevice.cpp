@@ -26,6 +26,7 @@
 
 #include "ALDevice.h"
 #include "ALFuncs.h"
+#include "AudioOcclusion.h"
 #include <Client/GameMap.h>
 #include <Client/IAudioChunk.h>
 #include <Core/AudioStream.h>
@@ -154,6 +155,7 @@ namespace spades {
 			ALuint obstructionFilter;
 
 			client::GameMap* map;
+			AudioOcclusionCache occlusion;
 
 			struct ALSrc {
 				Internal* internal;
@@ -323,16 +325,10 @@ namespace spades {
 						al::qalGetSourcefv(handle, AL_POSITION, v3);
 						Vector3 pos = {v3[0], v3[1], v3[2]};
 						ALCheckErrorPrecise();
-						Vector3 checkPos;
-						for (int x = -1; x <= 1; x++)
-						for (int y = -1; y <= 1; y++)
-						for (int z = -1; z <= 1; z++) {
-							IntVector3 hitPos;
-							checkPos = pos + MakeVector3((float)x, (float)y, (float)z) * 0.2F;
-							if (!map->CastRay(eye, (checkPos - eye).Normalize(),
-								(checkPos - eye).GetLength(), hitPos))
-								enableObstruction = false;
-						}
+						stmp::optional<bool> occluded = internal->occlusion.Lookup(pos);
+						if (!occluded)
+							occluded = IsPathOccluded(*map, eye, pos);
+						enableObstruction = *occluded;
 					} else {
 						enableObstruction = false;
 					}
@@ -570,6 +566,8 @@ namespace spades {
 				src->stereo = chunk->GetFormat() == AL_FORMAT_STEREO16;
 				src->SetParam(param);
 				src->Set3D(origin);
+				if (useEAX)
+					occlusion.AddEmitter(origin);
 				src->UpdateObstruction();
 				src->PlayBufferOneShot(chunk->GetHandle());
 			}
@@ -615,6 +613,10 @@ namespace spades {
 				al::qalListenerfv(AL_ORIENTATION, orient);
 				ALCheckError();
 
+				// obstruction is only simulated with EAX
+				if (useEAX)
+					occlusion.Update(eye);
+
 				// do reverb simulation
 				if (useEAX) {
 					float maxDistance = 40.0F;
@@ -831,6 +833,7 @@ namespace spades {
 				mp->AddRef();
 			if (oldMap)
 				oldMap->Release();
+			d->occlusion.SetGameMap(mp);
 		}
 	} // namespace audio
 } // namespace spades
\ No newline at end of file
@@ -0,0 +1,232 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "AudioOcclusion.h"
+#include <Client/GameMap.h>
+#include <Core/Debug.h>
+
+namespace spades {
+	namespace audio {
+		bool IsPathOccluded(const client::GameMap& map, const Vector3& listener,
+		                    const Vector3& emitter) {
+			// The center is the most likely to be visible, so try it first
+			static const int offsets[27][3] = {
+			  {0, 0, 0},   {-1, -1, -1}, {-1, -1, 0}, {-1, -1, 1}, {-1, 0, -1}, {-1, 0, 0},
+			  {-1, 0, 1},  {-1, 1, -1},  {-1, 1, 0},  {-1, 1, 1},  {0, -1, -1}, {0, -1, 0},
+			  {0, -1, 1},  {0, 0, -1},   {0, 0, 1},   {0, 1, -1},  {0, 1, 0},   {0, 1, 1},
+			  {1, -1, -1}, {1, -1, 0},   {1, -1, 1},  {1, 0, -1},  {1, 0, 0},   {1, 0, 1},
+			  {1, 1, -1},  {1, 1, 0},    {1, 1, 1}};
+
+			for (const auto& o : offsets) {
+				IntVector3 hitPos;
+				Vector3 checkPos =
+				  emitter + MakeVector3((float)o[0], (float)o[1], (float)o[2]) * 0.2F;
+				if (!map.CastRay(listener, (checkPos - listener).Normalize(),
+				                 (checkPos - listener).GetLength(), hitPos))
+					return false;
+			}
+			return true;
+		}
+
+		AudioOcclusionCache::AudioOcclusionCache()
+		    : map(nullptr), tick(0), needsPublish(false) {
+			for (auto& n : numReaders)
+				n = 0;
+		}
+
+		AudioOcclusionCache::~AudioOcclusionCache() { SetGameMap(nullptr); }
+
+		void AudioOcclusionCache::SetGameMap(client::GameMap* newMap) {
+			SPADES_MARK_FUNCTION();
+
+			if (map == newMap)
+				return;
+			if (map) {
+				map->RemoveListener(this);
+				map->Release();
+			}
+			map = newMap;
+			if (map) {
+				map->AddRef();
+				map->AddListener(this);
+			}
+
+			for (auto& e : entries)
+				e.second.stale = true;
+			needsPublish = true;
+		}
+
+		uint64_t AudioOcclusionCache::MakeKey(const Vector3& v) {
+			// 1/16 voxel precision, 21 bits per axis
+			auto quantize = [](float f) -> uint64_t {
+				return (uint64_t)((int64_t)std::floor(f * 16.0F) + (1 << 20)) & 0x1fffff;
+			};
+			return quantize(v.x) | (quantize(v.y) << 21) | (quantize(v.z) << 42);
+		}
+
+		void AudioOcclusionCache::AddEmitter(const Vector3& position) {
+			uint64_t key = MakeKey(position);
+			auto it = entries.find(key);
+			if (it != entries.end()) {
+				it->second.lastTick = tick;
+				return;
+			}
+
+			Entry& e = entries[key];
+			e.position = position;
+			e.listener = position;
+			e.lastTick = tick;
+			e.occluded = false;
+			e.stale = true;
+		}
+
+		void AudioOcclusionCache::Update(const Vector3& listener) {
+			SPADES_MARK_FUNCTION();
+
+			tick++;
+			RefreshLookedUp();
+
+			staleEntries.clear();
+			for (auto it = entries.begin(); it != entries.end();) {
+				Entry& e = it->second;
+				if (tick - e.lastTick > MaxEmitterAge) {
+					it = entries.erase(it);
+					needsPublish = true;
+					continue;
+				}
+				if ((e.listener - listener).GetSquaredLength() >
+				    ListenerTolerance * ListenerTolerance)
+					e.stale = true;
+				if (e.stale)
+					staleEntries.push_back(&e);
+				++it;
+			}
+
+			// Cast all rays in one batch. The map is only modified by this thread. Even a full
+			// recomputation takes tens of microseconds, so it isn't worth waiting for the
+			// shared thread pool.
+			for (Entry* e : staleEntries) {
+				e->occluded = map ? IsPathOccluded(*map, listener, e->position) : false;
+				e->listener = listener;
+				e->stale = false;
+			}
+
+			if (!staleEntries.empty())
+				needsPublish = true;
+			if (needsPublish && Publish())
+				needsPublish = false;
+		}
+
+		bool AudioOcclusionCache::Publish() {
+			int next = 1 - currentSnapshot.load();
+			if (numReaders[next].load() != 0)
+				return false;
+
+			Snapshot& snapshot = snapshots[next];
+			snapshot.clear();
+			for (const auto& e : entries)
+				snapshot.emplace_back(e.first, e.second.occluded);
+			std::sort(snapshot.begin(), snapshot.end());
+			// `RefreshLookedUp` has taken the flags of the old contents
+			lookedUp[next] = std::vector<std::atomic<bool>>(snapshot.size());
+
+			currentSnapshot.store(next);
+			return true;
+		}
+
+		stmp::optional<bool> AudioOcclusionCache::Lookup(const Vector3& emitter) const {
+			uint64_t key = MakeKey(emitter);
+
+			// Pin the current snapshot. If `Publish` started rewriting it meanwhile, the index
+			// has changed and we retry with the new one.
+			int index;
+			for (;;) {
+				index = currentSnapshot.load();
+				numReaders[index].fetch_add(1);
+				if (currentSnapshot.load() == index)
+					break;
+				numReaders[index].fetch_sub(1);
+			}
+
+			stmp::optional<bool> result;
+			const Snapshot& snapshot = snapshots[index];
+			auto it = std::lower_bound(snapshot.begin(), snapshot.end(),
+			                           std::make_pair(key, false));
+			if (it != snapshot.end() && it->first == key) {
+				result = it->second;
+				std::atomic<bool>& flag = lookedUp[index][it - snapshot.begin()];
+				if (!flag.load(std::memory_order_relaxed))
+					flag.store(true, std::memory_order_relaxed);
+			}
+
+			numReaders[index].fetch_sub(1);
+			return result;
+		}
+
+		void AudioOcclusionCache::RefreshLookedUp() {
+			// Only this thread modifies the snapshots, so the keys can be read even while a
+			// reader is using one
+			for (std::size_t i = 0; i < snapshots.size(); i++) {
+				std::vector<std::atomic<bool>>& flags = lookedUp[i];
+				for (std::size_t k = 0; k < flags.size(); k++) {
+					if (!flags[k].load(std::memory_order_relaxed) ||
+					    !flags[k].exchange(false, std::memory_order_relaxed))
+						continue;
+					auto it = entries.find(snapshots[i][k].first);
+					if (it != entries.end())
+						it->second.lastTick = tick;
+				}
+			}
+		}
+
+		void AudioOcclusionCache::Invalidate(const IntAABB3& region) {
+			for (auto& item : entries) {
+				Entry& e = item.second;
+				if (e.stale)
+					continue;
+
+				// The box of the rays, including the voxels they touch
+				Vector3 lo = MakeVector3(std::min(e.listener.x, e.position.x),
+				                         std::min(e.listener.y, e.position.y),
+				                         std::min(e.listener.z, e.position.z)) - 1.2F;
+				Vector3 hi = MakeVector3(std::max(e.listener.x, e.position.x),
+				                         std::max(e.listener.y, e.position.y),
+				                         std::max(e.listener.z, e.position.z)) + 1.2F;
+				if (hi.x < (float)region.min.x || lo.x > (float)region.max.x ||
+				    hi.y < (float)region.min.y || lo.y > (float)region.max.y ||
+				    hi.z < (float)region.min.z || lo.z > (float)region.max.z)
+					continue;
+				e.stale = true;
+			}
+		}
+
+		void AudioOcclusionCache::GameMapChanged(int x, int y, int z, client::GameMap*) {
+			Invalidate(IntAABB3(IntVector3(x, y, z), IntVector3(x + 1, y + 1, z + 1)));
+		}
+
+		void AudioOcclusionCache::GameMapChangedRegion(const IntAABB3& region,
+		                                               client::GameMap*) {
+			Invalidate(region);
+		}
+	} // namespace audio
+} // namespace spades
@@ -0,0 +1,120 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Client/IGameMapListener.h>
+#include <Core/Math.h>
+#include <Core/TMPUtils.h>
+
+namespace spades {
+	namespace client {
+		class GameMap;
+	}
+	namespace audio {
+		/**
+		 * Checks if the direct path from the listener to an emitter is obstructed by the map.
+		 * Casts rays to 27 points around the emitter and stops at the first one that isn't
+		 * blocked.
+		 */
+		bool IsPathOccluded(const client::GameMap&, const Vector3& listener,
+		                    const Vector3& emitter);
+
+		/**
+		 * Caches `IsPathOccluded` for the emitters of the playing voices so that the audio
+		 * thread doesn't have to cast rays against a map being modified by the game thread.
+		 *
+		 * The game thread registers the emitters with `AddEmitter` and calls `Update` once per
+		 * tick, which recomputes the stale results in a single batch and publishes them. An
+		 * emitter is stale when it's new, the listener has moved, or the map has changed
+		 * around the path. `Lookup` reads the last published results without locking and can
+		 * be called from any thread. An emitter stays registered while it's looked up, so the
+		 * voices of long or looping sounds keep their results.
+		 */
+		class AudioOcclusionCache : public client::IGameMapListener {
+		public:
+			AudioOcclusionCache();
+			~AudioOcclusionCache();
+
+			AudioOcclusionCache(const AudioOcclusionCache&) = delete;
+			void operator=(const AudioOcclusionCache&) = delete;
+
+			void SetGameMap(client::GameMap*);
+
+			/** Registers (or keeps alive) an emitter. The result is available after `Update`. */
+			void AddEmitter(const Vector3&);
+
+			void Update(const Vector3& listener);
+
+			/** Returns the published result, or nothing if the emitter isn't computed yet. */
+			stmp::optional<bool> Lookup(const Vector3& emitter) const;
+
+			std::size_t GetNumEmitters() const { return entries.size(); }
+
+			void GameMapChanged(int x, int y, int z, client::GameMap*) override;
+			void GameMapChangedRegion(const IntAABB3&, client::GameMap*) override;
+
+		private:
+			/** An emitter is forgotten after it isn't played or looked up for this many ticks. */
+			static constexpr int MaxEmitterAge = 600;
+			/** How far the listener can move before the results are recomputed. */
+			static constexpr float ListenerTolerance = 0.25F;
+
+			struct Entry {
+				Vector3 position;
+				/** The listener position `occluded` was computed for. */
+				Vector3 listener;
+				int lastTick;
+				bool occluded;
+				bool stale;
+			};
+
+			/** Sorted by key. Only modified while no reader is using it. */
+			using Snapshot = std::vector<std::pair<uint64_t, bool>>;
+
+			client::GameMap* map;
+			int tick;
+			bool needsPublish;
+			std::unordered_map<uint64_t, Entry> entries;
+			std::vector<Entry*> staleEntries;
+
+			std::array<Snapshot, 2> snapshots;
+			/** Set by `Lookup` for the elements of `snapshots` it found. */
+			mutable std::array<std::vector<std::atomic<bool>>, 2> lookedUp;
+			std::atomic<int> currentSnapshot{0};
+			mutable std::array<std::atomic<int>, 2> numReaders;
+
+			static uint64_t MakeKey(const Vector3&);
+
+			/** Keeps the emitters found by `Lookup` since the last call alive. */
+			void RefreshLookedUp();
+			void Invalidate(const IntAABB3&);
+			/** Returns `false` if a reader is still using the other snapshot. */
+			bool Publish();
+		};
+	} // namespace audio
+} // namespace spades
@@ -0,0 +1,262 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "AudioOcclusion.h"
+#include "SdlAudioDevice.h"
+#include "SoftDevice.h"
+#include "SoftMixer.h"
+#include <Client/GameMap.h>
+#include <Client/IAudioChunk.h>
+#include <Core/AudioStream.h>
+#include <Core/Debug.h>
+#include <Core/IAudioStream.h>
+#include <Core/Settings.h>
+
+SPADES_SETTING(s_volume);
+SPADES_SETTING(s_maxPolyphonics);
+DEFINE_SPADES_SETTING(s_softBufferSize, "512");
+
+namespace spades {
+	namespace audio {
+
+		class SoftAudioChunk : public client::IAudioChunk {
+			std::shared_ptr<const SoftSample> sample;
+
+		protected:
+			~SoftAudioChunk() {}
+
+		public:
+			SoftAudioChunk(IAudioStream& stream) : sample(SoftSample::Decode(stream)) {}
+			const std::shared_ptr<const SoftSample>& GetSample() { return sample; }
+		};
+
+		SoftDevice::SoftDevice()
+		    : gameMap(nullptr), occlusion(new AudioOcclusionCache()), roomHistoryPos(0) {
+			SPADES_MARK_FUNCTION();
+
+			SDL_AudioSpec spec;
+			spec.callback = reinterpret_cast<SDL_AudioCallback>(RenderCallback);
+			spec.userdata = this;
+			spec.format = AUDIO_F32SYS;
+			spec.freq = 44100;
+			spec.samples = (int)s_softBufferSize;
+			spec.channels = 2;
+
+			// The callback doesn't run until the device is unpaused
+			sdlAudioDevice = stmp::make_unique<SdlAudioDevice>(nullptr, SDL_FALSE, spec,
+			                                                   SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+
+			mixer = stmp::make_unique<SoftMixer>(sdlAudioDevice->spec.freq,
+			                                     std::max((int)s_maxPolyphonics, 1));
+			mixer->SetOcclusion(occlusion.get());
+			SPLog("Built-in mixer initialized: %d Hz, %d voices", sdlAudioDevice->spec.freq,
+			      std::max((int)s_maxPolyphonics, 1));
+
+			std::fill(roomHistory.begin(), roomHistory.end(), 20000.f);
+			std::fill(roomFeedbackHistory.begin(), roomFeedbackHistory.end(), 0.f);
+
+			SDL_PauseAudioDevice((*sdlAudioDevice)(), 0);
+		}
+
+		SoftDevice::~SoftDevice() {
+			// Stop the audio thread first
+			sdlAudioDevice.reset();
+
+			for (auto chunk = chunks.begin(); chunk != chunks.end(); ++chunk) {
+				chunk->second->Release();
+			}
+			if (this->gameMap)
+				this->gameMap->Release();
+		}
+
+		void SoftDevice::RenderCallback(SoftDevice* self, float* stream, int numBytes) {
+			self->mixer->Render(stream, static_cast<std::size_t>(numBytes) / 8);
+		}
+
+		client::IAudioChunk* SoftDevice::RegisterSound(const char* name) {
+			SPADES_MARK_FUNCTION();
+
+			auto it = chunks.find(name);
+			if (it == chunks.end()) {
+				std::unique_ptr<IAudioStream> stream{OpenAudioStream(name)};
+				auto* c = new SoftAudioChunk(*stream);
+				chunks[name] = c;
+				c->AddRef();
+				return c;
+			}
+			it->second->AddRef();
+			return it->second;
+		}
+
+		void SoftDevice::ClearCache() {
+			SPADES_MARK_FUNCTION();
+
+			for (const auto& chunk : chunks)
+				chunk.second->Release();
+
+			chunks.clear();
+		}
+
+		void SoftDevice::SetGameMap(client::GameMap* gameMap) {
+			SPADES_MARK_FUNCTION();
+			auto* old = this->gameMap;
+			this->gameMap = gameMap;
+			if (this->gameMap)
+				this->gameMap->AddRef();
+			if (old)
+				old->Release();
+			occlusion->SetGameMap(gameMap);
+		}
+
+		void SoftDevice::UpdateReverb(const Vector3& eye) {
+			SoftReverb::Param param;
+
+			auto* map = gameMap;
+			if (map == nullptr) {
+				param.gain = 0.0F;
+				mixer->SetReverb(param);
+				return;
+			}
+
+			// Estimate the room around the listener by casting a few rays per frame
+			float maxDistance = 40.0F;
+			for (int rays = 0; rays < 4; rays++) {
+				Vector3 rayTo = RandomAxis().Normalize();
+
+				IntVector3 hitPos;
+				bool hit = map->CastRay(eye, rayTo, maxDistance, hitPos);
+				if (hit) {
+					Vector3 hitPosf = {(float)hitPos.x, (float)hitPos.y, (float)hitPos.z};
+					roomHistory[roomHistoryPos] = (hitPosf - eye).GetLength();
+					roomFeedbackHistory[roomHistoryPos] =
+					  map->CastRay(eye, -rayTo, maxDistance, hitPos) ? 1.0F : 0.0F;
+				} else {
+					roomHistory[roomHistoryPos] = maxDistance * 2.0F;
+					roomFeedbackHistory[roomHistoryPos] = 0.0F;
+				}
+
+				roomHistoryPos++;
+				if (roomHistoryPos == (int)roomHistory.size())
+					roomHistoryPos = 0;
+			}
+
+			// monte-carlo integration
+			unsigned int rayHitCount = 0;
+			float roomVolume = 0.0F;
+			float roomArea = 0.0F;
+			float roomSize = 0.0F;
+			float feedbackness = 0.0F;
+			for (size_t i = 0; i < roomHistory.size(); i++) {
+				float dist = roomHistory[i];
+				if (dist < maxDistance) {
+					rayHitCount++;
+					roomVolume += dist * dist * dist;
+					roomArea += dist * dist;
+					roomSize += dist;
+				}
+				feedbackness += roomFeedbackHistory[i];
+			}
+			feedbackness /= (float)roomHistory.size();
+
+			if (rayHitCount > roomHistory.size() / 4) {
+				float reflections = (float)rayHitCount / (float)roomHistory.size();
+				roomVolume *= 4.0F / 3.0F * M_PI_F / (float)rayHitCount;
+				roomArea *= 4.0F * M_PI_F / (float)rayHitCount;
+				roomSize /= (float)rayHitCount;
+
+				// Sabine's formula with a fairly absorptive surface
+				param.decayTime = 0.161F * roomVolume / (roomArea * 0.4F);
+				param.preDelay = std::min(roomSize * 2.0F / 340.0F, 0.05F);
+				param.gain = 0.3F * reflections * (0.5F + 0.5F * feedbackness);
+			} else {
+				// Outdoors
+				param.decayTime = 0.3F;
+				param.preDelay = 0.02F;
+				param.gain = 0.05F;
+			}
+			param.decayTime = std::max(std::min(param.decayTime, SoftReverb::MaxLength), 0.1F);
+
+			mixer->SetReverb(param);
+		}
+
+		void SoftDevice::Respatialize(const spades::Vector3& eye, const spades::Vector3& front,
+		                              const spades::Vector3& up) {
+			SPADES_MARK_FUNCTION();
+
+			occlusion->Update(eye);
+			mixer->SetListener(eye, front, up);
+
+			// The same volume curve as the other drivers
+			int volume = (int)s_volume;
+			mixer->SetMasterGain(volume <= 0 ? 0.0F
+			                                 : powf(27.71373379F, logf((float)volume / 100.0F)));
+
+			UpdateReverb(eye);
+		}
+
+		static SoftMixer::PlayParam TranslateParam(const client::AudioParam& base) {
+			SoftMixer::PlayParam param;
+			param.volume = base.volume;
+			param.pitch = base.pitch;
+			param.referenceDistance = base.referenceDistance;
+			return param;
+		}
+
+		void SoftDevice::Play(client::IAudioChunk* c, const Vector3& origin,
+		                      const client::AudioParam& param) {
+			SPADES_MARK_FUNCTION();
+
+			auto* chunk = dynamic_cast<SoftAudioChunk*>(c);
+			if (chunk == nullptr)
+				SPRaise("Invalid chunk: null or invalid type.");
+
+			SoftMixer::PlayParam p = TranslateParam(param);
+			p.mode = SoftMixer::Mode::Absolute;
+			p.origin = origin;
+			occlusion->AddEmitter(origin);
+			mixer->Play(chunk->GetSample(), p);
+		}
+		void SoftDevice::PlayLocal(client::IAudioChunk* c, const Vector3& origin,
+		                           const client::AudioParam& param) {
+			SPADES_MARK_FUNCTION();
+
+			auto* chunk = dynamic_cast<SoftAudioChunk*>(c);
+			if (chunk == nullptr)
+				SPRaise("Invalid chunk: null or invalid type.");
+
+			SoftMixer::PlayParam p = TranslateParam(param);
+			p.mode = SoftMixer::Mode::Relative;
+			p.origin = origin;
+			mixer->Play(chunk->GetSample(), p);
+		}
+		void SoftDevice::PlayLocal(client::IAudioChunk* c, const client::AudioParam& param) {
+			SPADES_MARK_FUNCTION();
+
+			auto* chunk = dynamic_cast<SoftAudioChunk*>(c);
+			if (chunk == nullptr)
+				SPRaise("Invalid chunk: null or invalid type.");
+
+			mixer->Play(chunk->GetSample(), TranslateParam(param));
+		}
+	} // namespace audio
+} // namespace spades
@@ -0,0 +1,615 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "AudioOcclusion.h"
+#include "SoftMixer.h"
+#include <Core/Debug.h>
+#include <Core/Exception.h>
+#include <Core/IAudioStream.h>
+#include <Core/TraceProfiler.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPADES_SOFTMIXER_SSE2 1
+#include <emmintrin.h>
+#else
+#define SPADES_SOFTMIXER_SSE2 0
+#endif
+
+namespace spades {
+	namespace audio {
+		namespace {
+			/** The interaural time difference of a sound coming from the side (seconds). */
+			constexpr float MaxInterauralDelay = 0.00066F;
+			/** The cutoff frequency of the head shadow of a sound coming from the side. */
+			constexpr float HeadShadowCutoff = 2500.0F;
+			/** The cutoff frequency of a sound coming from behind. */
+			constexpr float RearCutoff = 4000.0F;
+			constexpr float OpenCutoff = 20000.0F;
+			constexpr float ObstructedCutoff = 1200.0F;
+			constexpr float ObstructedGain = 0.4F;
+			/** How fast the limiter recovers, per block. */
+			constexpr float LimiterRelease = 0.02F;
+
+			/**
+			 * Writes `BlockSize` frames linearly interpolated from `src` at `start + i * step`.
+			 * Only the first `count` frames are read from `src`. The rest are zero.
+			 */
+			void Resample(const float* src, float start, float step, std::size_t count,
+			              float* out) {
+				std::size_t i = 0;
+#if SPADES_SOFTMIXER_SSE2
+				__m128 index = _mm_set_ps(3.0F, 2.0F, 1.0F, 0.0F);
+				const __m128 startv = _mm_set1_ps(start);
+				const __m128 stepv = _mm_set1_ps(step);
+				const __m128 four = _mm_set1_ps(4.0F);
+				for (; i + 4 <= count; i += 4) {
+					__m128 pos = _mm_add_ps(startv, _mm_mul_ps(index, stepv));
+					__m128i ipos = _mm_cvttps_epi32(pos);
+					__m128 frac = _mm_sub_ps(pos, _mm_cvtepi32_ps(ipos));
+					alignas(16) std::int32_t idx[4];
+					_mm_store_si128(reinterpret_cast<__m128i*>(idx), ipos);
+					__m128 a = _mm_setr_ps(src[idx[0]], src[idx[1]], src[idx[2]], src[idx[3]]);
+					__m128 b = _mm_setr_ps(src[idx[0] + 1], src[idx[1] + 1], src[idx[2] + 1],
+					                       src[idx[3] + 1]);
+					_mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), frac)));
+					index = _mm_add_ps(index, four);
+				}
+#endif
+				for (; i < count; i++) {
+					float pos = start + (float)i * step;
+					int idx = (int)pos;
+					float frac = pos - (float)idx;
+					out[i] = src[idx] + (src[idx + 1] - src[idx]) * frac;
+				}
+				std::fill(out + count, out + SoftMixer::BlockSize, 0.0F);
+			}
+
+			/** `out[i] += in[i] * (gain + i * gainStep)` for `BlockSize` frames. */
+			void Accumulate(const float* in, float gain, float gainStep, float* out) {
+				std::size_t i = 0;
+#if SPADES_SOFTMIXER_SSE2
+				__m128 index = _mm_set_ps(3.0F, 2.0F, 1.0F, 0.0F);
+				const __m128 gainv = _mm_set1_ps(gain);
+				const __m128 stepv = _mm_set1_ps(gainStep);
+				const __m128 four = _mm_set1_ps(4.0F);
+				for (; i < SoftMixer::BlockSize; i += 4) {
+					__m128 g = _mm_add_ps(gainv, _mm_mul_ps(index, stepv));
+					__m128 sample = _mm_mul_ps(_mm_loadu_ps(in + i), g);
+					_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), sample));
+					index = _mm_add_ps(index, four);
+				}
+#endif
+				for (; i < SoftMixer::BlockSize; i++)
+					out[i] += in[i] * (gain + (float)i * gainStep);
+			}
+
+			/** A one-pole low-pass filter. */
+			void LowPass(float* samples, float coef, float& state) {
+				float y = state;
+				for (std::size_t i = 0; i < SoftMixer::BlockSize; i++) {
+					y += (samples[i] - y) * coef;
+					samples[i] = y;
+				}
+				// Flush denormals
+				state = std::fabs(y) < 1.0e-20F ? 0.0F : y;
+			}
+		} // namespace
+
+		std::shared_ptr<SoftSample> SoftSample::Decode(IAudioStream& stream) {
+			SPADES_MARK_FUNCTION();
+
+			int numChannels = stream.GetNumChannels();
+			if (numChannels < 1 || numChannels > 2) {
+				SPRaise("Unsupported channel count");
+			}
+			std::size_t bytesPerSample;
+			switch (stream.GetSampleFormat()) {
+				case IAudioStream::SignedShort: bytesPerSample = 2; break;
+				case IAudioStream::UnsignedByte: bytesPerSample = 1; break;
+				case IAudioStream::SingleFloat: bytesPerSample = 4; break;
+				default: SPRaise("Unsupported audio format");
+			}
+			if (stream.GetNumSamples() > 128 * 1024 * 1024) {
+				SPRaise("Audio data too long");
+			}
+
+			std::vector<unsigned char> bytes(static_cast<std::size_t>(stream.GetNumSamples()) *
+			                                 bytesPerSample * numChannels);
+			bytes.resize(stream.Read(bytes.data(), bytes.size()));
+
+			std::vector<float> frames(bytes.size() / bytesPerSample);
+			for (std::size_t i = 0; i < frames.size(); i++) {
+				const unsigned char* p = &bytes[i * bytesPerSample];
+				switch (stream.GetSampleFormat()) {
+					case IAudioStream::SignedShort:
+						frames[i] = (float)(std::int16_t)(p[0] | (p[1] << 8)) * (1.0F / 32768.0F);
+						break;
+					case IAudioStream::UnsignedByte:
+						frames[i] = (float)((int)p[0] - 128) * (1.0F / 128.0F);
+						break;
+					case IAudioStream::SingleFloat: std::memcpy(&frames[i], p, 4); break;
+				}
+			}
+
+			return Create(frames.data(), frames.size() / numChannels, numChannels,
+			              stream.GetSamplingFrequency());
+		}
+
+		std::shared_ptr<SoftSample> SoftSample::Create(const float* frames, std::size_t numFrames,
+		                                               int numChannels, int samplingRate) {
+			SPAssert(numChannels >= 1 && numChannels <= 2);
+			SPAssert(samplingRate > 0);
+
+			auto sample = std::make_shared<SoftSample>();
+			sample->numChannels = numChannels;
+			sample->samplingRate = samplingRate;
+			sample->numFrames = numFrames;
+			sample->data.assign((numFrames + Padding * 2) * numChannels, 0.0F);
+			for (int ch = 0; ch < numChannels; ch++) {
+				float* out = sample->data.data() + (numFrames + Padding * 2) * ch + Padding;
+				for (std::size_t i = 0; i < numFrames; i++)
+					out[i] = frames[i * numChannels + ch];
+			}
+			return sample;
+		}
+
+		struct SoftMixer::Voice {
+			/** Null if the slot is free. */
+			std::shared_ptr<const SoftSample> sample;
+			PlayParam param;
+
+			/** The source position of the first frame of the next block. */
+			double position;
+			/** The source frames advanced per output frame. */
+			double step;
+
+			/** Per-ear parameters. `current` is ramped to `target` during a block. */
+			struct Params {
+				std::array<float, 2> gain;
+				/** The delay in output frames. */
+				std::array<float, 2> delay;
+				/** The coefficient of the low-pass filter. 1 disables it. */
+				std::array<float, 2> filter;
+				float send;
+			} current, target;
+			std::array<float, 2> filterState;
+
+			/** The loudness used by the voice stealing. */
+			float loudness;
+			bool started;
+			bool fadingOut;
+			bool finished;
+		};
+
+		SoftMixer::SoftMixer(int samplingRate, std::size_t maxVoices)
+		    : samplingRate(samplingRate),
+		      maxVoices(std::max<std::size_t>(maxVoices, 1)),
+		      reverb(new SoftReverb(samplingRate)),
+		      mixLeft(BlockSize),
+		      mixRight(BlockSize),
+		      mixReverb(BlockSize),
+		      mixScratch(BlockSize),
+		      block(BlockSize * 2),
+		      blockPos(BlockSize),
+		      numActiveVoices(0),
+		      numStolenVoices(0),
+		      numDroppedVoices(0),
+		      numRenderedBlocks(0) {
+			SPADES_MARK_FUNCTION();
+
+			// Stolen voices keep their slot while fading out, so the pool has some spare slots
+			std::size_t poolSize = this->maxVoices + this->maxVoices / 4 + 4;
+			voices.resize(poolSize);
+			activeVoices.reserve(poolSize);
+
+			pending.plays.reserve(poolSize);
+			plays.reserve(poolSize);
+			pending.retiredSamples.reserve(poolSize * 4);
+			retiredSamples.reserve(poolSize * 4);
+			pending.retiredResponses.reserve(16);
+			retiredResponses.reserve(16);
+		}
+
+		SoftMixer::~SoftMixer() {}
+
+		void SoftMixer::Play(std::shared_ptr<const SoftSample> sample, const PlayParam& param) {
+			SPAssert(sample);
+
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			pending.retiredSamples.clear();
+
+			// Don't let the queue grow unbounded if the audio thread is stalled
+			if (pending.plays.size() >= voices.size()) {
+				numDroppedVoices++;
+				return;
+			}
+
+			pending.plays.push_back(PlayCommand{std::move(sample), param});
+		}
+
+		void SoftMixer::SetListener(const Vector3& eye, const Vector3& front, const Vector3& up) {
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			pending.retiredSamples.clear();
+			pending.retiredResponses.clear();
+			pending.listener.position = eye;
+			pending.listener.front = front;
+			pending.listener.up = up;
+		}
+
+		void SoftMixer::SetMasterGain(float gain) {
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			pending.masterGain = gain;
+		}
+
+		void SoftMixer::SetReverb(const SoftReverb::Param& param) {
+			SPADES_MARK_FUNCTION();
+
+			if (hasReverbParam &&
+			    std::fabs(param.decayTime - reverbParam.decayTime) < reverbParam.decayTime * 0.1F &&
+			    std::fabs(param.preDelay - reverbParam.preDelay) < 0.005F &&
+			    std::fabs(param.gain - reverbParam.gain) < 0.02F &&
+			    std::fabs(param.damping - reverbParam.damping) < 0.05F) {
+				return;
+			}
+			reverbParam = param;
+			hasReverbParam = true;
+
+			// `CreateResponse` is safe to call while the audio thread is using `reverb`
+			std::shared_ptr<const SoftReverb::Response> response;
+			if (param.gain > 0.0F)
+				response = reverb->CreateResponse(param);
+
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			pending.retiredResponses.clear();
+			pending.reverb = std::move(response);
+			pending.reverbChanged = true;
+		}
+
+		void SoftMixer::SetOcclusion(const AudioOcclusionCache* cache) {
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			pending.occlusion = cache;
+		}
+
+		auto SoftMixer::GetStatistics() const -> Statistics {
+			Statistics stats;
+			stats.numActiveVoices = numActiveVoices;
+			stats.numStolenVoices = numStolenVoices;
+			stats.numDroppedVoices = numDroppedVoices;
+			stats.numRenderedBlocks = numRenderedBlocks;
+			return stats;
+		}
+
+		void SoftMixer::FetchCommands() {
+			std::unique_lock<std::mutex> lock(pendingMutex, std::try_to_lock);
+			if (!lock.owns_lock()) {
+				// The game thread is busy. Try again in the next block.
+				return;
+			}
+
+			plays.swap(pending.plays);
+			listener = pending.listener;
+			masterGain = pending.masterGain;
+			occlusion = pending.occlusion;
+
+			if (pending.reverbChanged) {
+				reverbEnabled = pending.reverb != nullptr;
+				auto old = reverb->SetResponse(std::move(pending.reverb));
+				if (old)
+					retiredResponses.push_back(std::move(old));
+				pending.reverbChanged = false;
+			}
+
+			// Hand the objects over to the game thread so they are freed there
+			for (auto& sample : retiredSamples)
+				pending.retiredSamples.push_back(std::move(sample));
+			retiredSamples.clear();
+			for (auto& response : retiredResponses)
+				pending.retiredResponses.push_back(std::move(response));
+			retiredResponses.clear();
+		}
+
+		float SoftMixer::ComputePriority(const Voice& voice) const {
+			float bonus = 0.0F;
+			switch (voice.param.mode) {
+				case Mode::Local: bonus = 3.0F; break;
+				case Mode::Relative: bonus = 2.0F; break;
+				case Mode::Absolute: bonus = 0.0F; break;
+			}
+			double numFrames = (double)voice.sample->GetNumFrames();
+			float remaining =
+			  numFrames > 0.0 ? (float)std::max(1.0 - voice.position / numFrames, 0.0) : 0.0F;
+			return bonus + voice.loudness * (0.5F + 0.5F * remaining);
+		}
+
+		void SoftMixer::StartVoice(PlayCommand& command) {
+			Voice newVoice;
+			newVoice.sample = std::move(command.sample);
+			newVoice.param = command.param;
+			newVoice.position = 0.0;
+			newVoice.step = std::max(std::min(newVoice.param.pitch, 16.0F), 0.01F) *
+			                (double)newVoice.sample->GetSamplingRate() / (double)samplingRate;
+			newVoice.filterState.fill(0.0F);
+			newVoice.started = false;
+			newVoice.fadingOut = false;
+			newVoice.finished = false;
+			Spatialize(newVoice);
+
+			Voice* victim = nullptr;
+			if (numPlayingVoices >= maxVoices) {
+				float victimPriority = 0.0F;
+				for (Voice& voice : voices) {
+					if (!voice.sample || voice.fadingOut)
+						continue;
+					float priority = ComputePriority(voice);
+					if (!victim || priority < victimPriority) {
+						victim = &voice;
+						victimPriority = priority;
+					}
+				}
+				if (!victim || ComputePriority(newVoice) <= victimPriority) {
+					numDroppedVoices++;
+					retiredSamples.push_back(std::move(newVoice.sample));
+					return;
+				}
+				victim->fadingOut = true;
+				numPlayingVoices--;
+				numStolenVoices++;
+			}
+
+			auto it = std::find_if(voices.begin(), voices.end(),
+			                       [](const Voice& voice) { return !voice.sample; });
+			Voice* slot = it != voices.end() ? &*it : victim;
+			if (!slot) {
+				// Every spare slot is fading out
+				numDroppedVoices++;
+				retiredSamples.push_back(std::move(newVoice.sample));
+				return;
+			}
+			if (slot->sample)
+				retiredSamples.push_back(std::move(slot->sample));
+
+			*slot = std::move(newVoice);
+			numPlayingVoices++;
+		}
+
+		void SoftMixer::Spatialize(Voice& voice) {
+			const PlayParam& param = voice.param;
+			Voice::Params& target = voice.target;
+
+			float gain = param.volume;
+			float send = 0.0F;
+			bool spatialized = voice.sample->GetNumChannels() == 1;
+			bool obstructed = false;
+			Vector3 direction = MakeVector3(0.0F, 0.0F, 1.0F);
+
+			switch (param.mode) {
+				case Mode::Local: spatialized = false; break;
+				case Mode::Relative:
+					direction = param.origin;
+					send = param.volume;
+					break;
+				case Mode::Absolute: {
+					Vector3 diff = param.origin - listener.position;
+					Vector3 right = Vector3::Cross(listener.front, listener.up);
+					direction = MakeVector3(Vector3::Dot(diff, right),
+					                        Vector3::Dot(diff, listener.up),
+					                        Vector3::Dot(diff, listener.front));
+
+					// The inverse distance clamped model (same as OpenAL's default)
+					float refDistance = std::max(param.referenceDistance, 0.001F);
+					float attenuation = refDistance / std::max(diff.GetLength(), refDistance);
+					if (spatialized)
+						gain *= attenuation;
+					// The reverberant field decays slower than the direct sound
+					send = param.volume * std::sqrt(attenuation);
+
+					if (occlusion) {
+						stmp::optional<bool> occluded = occlusion->Lookup(param.origin);
+						obstructed = occluded && *occluded;
+					}
+					break;
+				}
+			}
+
+			auto coefficient = [&](float cutoff) {
+				if (cutoff >= (float)samplingRate * 0.45F)
+					return 1.0F;
+				return 1.0F - std::exp(-2.0F * M_PI_F * cutoff / (float)samplingRate);
+			};
+
+			if (!spatialized) {
+				target.gain.fill(gain);
+				target.delay.fill(0.0F);
+				target.filter.fill(1.0F);
+			} else {
+				float length = direction.GetLength();
+				direction = length > 1.0e-4F ? direction / length : MakeVector3(0.0F, 0.0F, 1.0F);
+				float pan = std::max(std::min(direction.x, 1.0F), -1.0F);
+				float side = std::fabs(pan);
+				float behind = std::max(-direction.z, 0.0F);
+				int nearEar = pan > 0.0F ? 1 : 0;
+				int farEar = 1 - nearEar;
+
+				if (obstructed)
+					gain *= ObstructedGain;
+
+				float cutoff = OpenCutoff * std::pow(RearCutoff / OpenCutoff, behind);
+				if (obstructed)
+					cutoff = std::min(cutoff, ObstructedCutoff);
+
+				target.gain[nearEar] = gain * (1.0F + 0.25F * side);
+				target.gain[farEar] = gain * (1.0F - 0.55F * side);
+				target.delay[nearEar] = 0.0F;
+				target.delay[farEar] = std::min(MaxInterauralDelay * side * (float)samplingRate,
+				                                (float)(SoftSample::Padding - 4) /
+				                                  (float)voice.step);
+				target.filter[nearEar] = coefficient(cutoff);
+				target.filter[farEar] = coefficient(
+				  std::min(cutoff, OpenCutoff * std::pow(HeadShadowCutoff / OpenCutoff, side)));
+			}
+
+			target.send = reverbEnabled ? send : 0.0F;
+			voice.loudness = gain;
+
+			if (voice.fadingOut) {
+				target.gain.fill(0.0F);
+				target.send = 0.0F;
+			}
+			if (!voice.started) {
+				voice.current = target;
+				voice.started = true;
+			}
+
+			// Limit how fast the delay changes, which shifts the pitch
+			for (int ear = 0; ear < 2; ear++) {
+				float maxChange = (float)BlockSize / 8.0F;
+				target.delay[ear] =
+				  std::max(std::min(target.delay[ear], voice.current.delay[ear] + maxChange),
+				           voice.current.delay[ear] - maxChange);
+			}
+		}
+
+		void SoftMixer::MixVoice(Voice& voice) {
+			const SoftSample& sample = *voice.sample;
+			const Voice::Params& current = voice.current;
+			const Voice::Params& target = voice.target;
+			const float invBlockSize = 1.0F / (float)BlockSize;
+			const bool stereo = sample.GetNumChannels() > 1;
+			const double limit = (double)sample.GetNumFrames() + (SoftSample::Padding - 3);
+			float* scratch = mixScratch.data();
+			float* outputs[2] = {mixLeft.data(), mixRight.data()};
+
+			for (int ear = 0; ear < 2; ear++) {
+				// Both ears of a centered voice hear the same thing
+				bool reuse = ear == 1 && !stereo && current.delay[0] == current.delay[1] &&
+				             target.delay[0] == target.delay[1] && target.filter[0] == 1.0F &&
+				             target.filter[1] == 1.0F;
+				if (!reuse) {
+					// A changing delay is a slightly different step
+					double start = voice.position - (double)current.delay[ear] * voice.step;
+					double step =
+					  voice.step *
+					  (1.0 - (double)(target.delay[ear] - current.delay[ear]) * invBlockSize);
+					double base = std::floor(start);
+					std::size_t count = 0;
+					if (limit >= start) {
+						count = (std::size_t)std::min(std::floor((limit - start) / step) + 1.0,
+						                              (double)BlockSize);
+					}
+					Resample(sample.GetChannel(stereo ? ear : 0) + (std::ptrdiff_t)base,
+					         (float)(start - base), (float)step, count, scratch);
+
+					if (target.filter[ear] < 1.0F)
+						LowPass(scratch, target.filter[ear], voice.filterState[ear]);
+				}
+
+				Accumulate(scratch, current.gain[ear],
+				           (target.gain[ear] - current.gain[ear]) * invBlockSize, outputs[ear]);
+				if (current.send > 0.0F || target.send > 0.0F) {
+					Accumulate(scratch, current.send * 0.5F,
+					           (target.send - current.send) * (0.5F * invBlockSize),
+					           mixReverb.data());
+				}
+			}
+
+			voice.position += voice.step * BlockSize;
+			voice.current = target;
+
+			float lag = std::max(target.delay[0], target.delay[1]) * (float)voice.step;
+			if (voice.fadingOut || voice.position - lag >= (double)sample.GetNumFrames())
+				voice.finished = true;
+		}
+
+		void SoftMixer::RenderBlock() {
+			SPADES_TRACE_ZONE("SoftMixer::RenderBlock");
+			FetchCommands();
+			for (PlayCommand& command : plays)
+				StartVoice(command);
+			plays.clear();
+
+			activeVoices.clear();
+			for (std::size_t i = 0; i < voices.size(); i++) {
+				if (!voices[i].sample)
+					continue;
+				Spatialize(voices[i]);
+				activeVoices.push_back(i);
+			}
+
+			std::fill(mixLeft.begin(), mixLeft.end(), 0.0F);
+			std::fill(mixRight.begin(), mixRight.end(), 0.0F);
+			std::fill(mixReverb.begin(), mixReverb.end(), 0.0F);
+			for (std::size_t i : activeVoices)
+				MixVoice(voices[i]);
+
+			reverb->Process(mixReverb.data(), mixLeft.data(), mixRight.data());
+
+			for (std::size_t i : activeVoices) {
+				Voice& voice = voices[i];
+				if (!voice.finished)
+					continue;
+				if (!voice.fadingOut)
+					numPlayingVoices--;
+				retiredSamples.push_back(std::move(voice.sample));
+			}
+
+			// Master gain and a peak limiter
+			float peak = 0.0F;
+			for (std::size_t i = 0; i < BlockSize; i++)
+				peak = std::max(peak, std::max(std::fabs(mixLeft[i]), std::fabs(mixRight[i])));
+			peak *= masterGain;
+			float desired = peak > 1.0F ? 1.0F / peak : 1.0F;
+			float nextLimiterGain = desired < limiterGain
+			                          ? desired
+			                          : limiterGain + (desired - limiterGain) * LimiterRelease;
+			float gain = limiterGain * masterGain;
+			float gainStep = (nextLimiterGain - limiterGain) * masterGain / (float)BlockSize;
+			limiterGain = nextLimiterGain;
+
+			for (std::size_t i = 0; i < BlockSize; i++) {
+				float g = gain + (float)i * gainStep;
+				block[i * 2] = std::max(std::min(mixLeft[i] * g, 1.0F), -1.0F);
+				block[i * 2 + 1] = std::max(std::min(mixRight[i] * g, 1.0F), -1.0F);
+			}
+
+			numActiveVoices = numPlayingVoices;
+			numRenderedBlocks++;
+		}
+
+		void SoftMixer::Render(float* output, std::size_t numFrames) {
+			while (numFrames > 0) {
+				if (blockPos == BlockSize) {
+					RenderBlock();
+					blockPos = 0;
+				}
+				std::size_t count = std::min<std::size_t>(numFrames, BlockSize - blockPos);
+				std::copy(block.begin() + blockPos * 2, block.begin() + (blockPos + count) * 2,
+				          output);
+				output += count * 2;
+				numFrames -= count;
+				blockPos += count;
+			}
+		}
+	} // namespace audio
+} // namespace spades
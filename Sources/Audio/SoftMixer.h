@@ -0,0 +1,218 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "SoftReverb.h"
+#include <Core/Math.h>
+
+namespace spades {
+	class IAudioStream;
+
+	namespace audio {
+		class AudioOcclusionCache;
+
+		/** Decoded PCM data in the format consumed by `SoftMixer`. Immutable. */
+		class SoftSample {
+		public:
+			/** The number of silent frames before and after the data of each channel. */
+			enum { Padding = 128 };
+
+			/** Decodes the remaining part of a mono or stereo stream. */
+			static std::shared_ptr<SoftSample> Decode(IAudioStream&);
+
+			/** Creates a sample from interleaved frames. */
+			static std::shared_ptr<SoftSample> Create(const float* frames, std::size_t numFrames,
+			                                          int numChannels, int samplingRate);
+
+			int GetNumChannels() const { return numChannels; }
+			int GetSamplingRate() const { return samplingRate; }
+			std::size_t GetNumFrames() const { return numFrames; }
+
+			/**
+			 * Returns the frames of a channel. Indices in `[-Padding, numFrames + Padding)`
+			 * are valid.
+			 */
+			const float* GetChannel(int channel) const {
+				return data.data() + (numFrames + Padding * 2) * channel + Padding;
+			}
+
+		private:
+			int numChannels;
+			int samplingRate;
+			std::size_t numFrames;
+			/** Planar. Each channel is surrounded by `Padding` zeros. */
+			std::vector<float> data;
+		};
+
+		/**
+		 * A software mixer that renders a bounded pool of voices into a stereo stream.
+		 *
+		 * The game thread queues commands with `Play`, `SetListener`, etc., and the audio
+		 * thread pulls the output with `Render`. The commands are picked up by the audio thread
+		 * once per block with a `try_lock`, so the audio thread never waits for the game
+		 * thread, and nothing is allocated or freed by the audio thread in the steady state.
+		 *
+		 * Each block, the voices are spatialized (distance attenuation, a simple head model
+		 * made of a level difference, a time difference, and a head shadow filter, and the
+		 * obstruction reported by `AudioOcclusionCache`) and mixed into a single bus. The
+		 * mixing stays on the audio thread; waiting for the thread pool would make the output
+		 * depend on what the other threads are doing.
+		 *
+		 * When the pool is full, the voice with the lowest priority (a combination of the
+		 * kind of voice, its loudness, and the remaining length) is faded out over a block to
+		 * make room, unless the new voice has an even lower priority, in which case the new one
+		 * is dropped.
+		 */
+		class SoftMixer {
+		public:
+			enum { BlockSize = SoftReverb::BlockSize };
+
+			enum class Mode {
+				/** Positioned in the world. */
+				Absolute,
+				/** Positioned relative to the listener (x = right, y = up, z = front). */
+				Relative,
+				/** Not spatialized. */
+				Local
+			};
+
+			struct PlayParam {
+				Mode mode = Mode::Local;
+				Vector3 origin = MakeVector3(0.0F, 0.0F, 0.0F);
+				float volume = 1.0F;
+				float pitch = 1.0F;
+				float referenceDistance = 1.0F;
+			};
+
+			struct Statistics {
+				std::size_t numActiveVoices;
+				std::uint64_t numStolenVoices;
+				std::uint64_t numDroppedVoices;
+				std::uint64_t numRenderedBlocks;
+			};
+
+			SoftMixer(int samplingRate, std::size_t maxVoices);
+			~SoftMixer();
+
+			SoftMixer(const SoftMixer&) = delete;
+			void operator=(const SoftMixer&) = delete;
+
+			int GetSamplingRate() const { return samplingRate; }
+
+			// These methods are called by the game thread.
+
+			void Play(std::shared_ptr<const SoftSample>, const PlayParam&);
+			void SetListener(const Vector3& eye, const Vector3& front, const Vector3& up);
+			void SetMasterGain(float);
+			/** Rebuilds the impulse response if the parameters have changed noticeably. */
+			void SetReverb(const SoftReverb::Param&);
+			/** Enables obstruction. The cache must outlive the mixer, or be reset to null. */
+			void SetOcclusion(const AudioOcclusionCache*);
+
+			Statistics GetStatistics() const;
+
+			// This method is called by the audio thread.
+
+			/** Renders `numFrames` interleaved stereo frames. */
+			void Render(float* output, std::size_t numFrames);
+
+		private:
+			struct Voice;
+
+			struct Listener {
+				Vector3 position = MakeVector3(0.0F, 0.0F, 0.0F);
+				Vector3 front = MakeVector3(0.0F, 1.0F, 0.0F);
+				Vector3 up = MakeVector3(0.0F, 0.0F, -1.0F);
+			};
+
+			struct PlayCommand {
+				std::shared_ptr<const SoftSample> sample;
+				PlayParam param;
+			};
+
+			/** The state shared by the game thread and the audio thread. */
+			struct Pending {
+				std::vector<PlayCommand> plays;
+				Listener listener;
+				float masterGain = 1.0F;
+				const AudioOcclusionCache* occlusion = nullptr;
+				std::shared_ptr<const SoftReverb::Response> reverb;
+				bool reverbChanged = false;
+				/** Released by the game thread. */
+				std::vector<std::shared_ptr<const SoftSample>> retiredSamples;
+				std::vector<std::shared_ptr<const SoftReverb::Response>> retiredResponses;
+			};
+
+			int samplingRate;
+			std::size_t maxVoices;
+
+			std::mutex pendingMutex;
+			Pending pending;
+
+			/** The last reverb parameters passed to `SetReverb`. Game thread only. */
+			SoftReverb::Param reverbParam;
+			bool hasReverbParam = false;
+
+			// The rest is owned by the audio thread.
+
+			std::vector<PlayCommand> plays;
+			std::vector<std::shared_ptr<const SoftSample>> retiredSamples;
+			std::vector<std::shared_ptr<const SoftReverb::Response>> retiredResponses;
+			Listener listener;
+			float masterGain = 1.0F;
+			float limiterGain = 1.0F;
+			const AudioOcclusionCache* occlusion = nullptr;
+
+			std::unique_ptr<SoftReverb> reverb;
+			bool reverbEnabled = false;
+
+			std::vector<Voice> voices;
+			std::vector<std::size_t> activeVoices;
+			std::size_t numPlayingVoices = 0;
+			std::vector<float> mixLeft, mixRight, mixReverb;
+			/** The resampled input of `MixVoice`. */
+			std::vector<float> mixScratch;
+
+			/** The last rendered block (interleaved) and the number of frames consumed. */
+			std::vector<float> block;
+			std::size_t blockPos;
+
+			std::atomic<std::size_t> numActiveVoices;
+			std::atomic<std::uint64_t> numStolenVoices;
+			std::atomic<std::uint64_t> numDroppedVoices;
+			std::atomic<std::uint64_t> numRenderedBlocks;
+
+			void FetchCommands();
+			void StartVoice(PlayCommand&);
+			void Spatialize(Voice&);
+			float ComputePriority(const Voice&) const;
+			void MixVoice(Voice&);
+			void RenderBlock();
+		};
+	} // namespace audio
+} // namespace spades
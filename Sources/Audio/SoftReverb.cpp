@@ -0,0 +1,205 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "SoftReverb.h"
+#include <Core/Debug.h>
+#include <Core/Math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPADES_SOFTREVERB_SSE2 1
+#include <emmintrin.h>
+#else
+#define SPADES_SOFTREVERB_SSE2 0
+#endif
+
+namespace spades {
+	namespace audio {
+		namespace {
+			/** `acc[i] += x[i] * h[i]` for complex numbers. */
+			void MultiplyAccumulate(const kiss_fft_cpx* x, const kiss_fft_cpx* h,
+			                        kiss_fft_cpx* acc, std::size_t count) {
+				std::size_t i = 0;
+#if SPADES_SOFTREVERB_SSE2
+				const __m128 sign = _mm_set_ps(1.0F, -1.0F, 1.0F, -1.0F);
+				for (; i + 2 <= count; i += 2) {
+					__m128 xv = _mm_loadu_ps(&x[i].r);
+					__m128 hv = _mm_loadu_ps(&h[i].r);
+					__m128 hr = _mm_shuffle_ps(hv, hv, _MM_SHUFFLE(2, 2, 0, 0));
+					__m128 hi = _mm_shuffle_ps(hv, hv, _MM_SHUFFLE(3, 3, 1, 1));
+					__m128 xs = _mm_shuffle_ps(xv, xv, _MM_SHUFFLE(2, 3, 0, 1));
+					__m128 prod = _mm_add_ps(_mm_mul_ps(xv, hr),
+					                         _mm_mul_ps(_mm_mul_ps(xs, hi), sign));
+					_mm_storeu_ps(&acc[i].r, _mm_add_ps(_mm_loadu_ps(&acc[i].r), prod));
+				}
+#endif
+				for (; i < count; i++) {
+					acc[i].r += x[i].r * h[i].r - x[i].i * h[i].i;
+					acc[i].i += x[i].i * h[i].r + x[i].r * h[i].i;
+				}
+			}
+		} // namespace
+
+		constexpr float SoftReverb::MaxLength;
+
+		SoftReverb::SoftReverb(int samplingRate)
+		    : samplingRate(samplingRate),
+		      maxPartitions((std::size_t)std::ceil(MaxLength * 1.1F * (float)samplingRate /
+		                                           (float)BlockSize)),
+		      inputWindow(FFTSize, 0.0F),
+		      inputSpectra(maxPartitions * FFTSize),
+		      inputSpectraPos(0),
+		      fftIn(FFTSize),
+		      fftOut(FFTSize),
+		      accumulator(FFTSize),
+		      previousOutput(FFTSize) {
+			forwardFFT = kiss_fft_alloc(FFTSize, 0, NULL, NULL);
+			inverseFFT = kiss_fft_alloc(FFTSize, 1, NULL, NULL);
+		}
+
+		SoftReverb::~SoftReverb() {
+			kiss_fft_free(forwardFFT);
+			kiss_fft_free(inverseFFT);
+		}
+
+		auto SoftReverb::CreateResponse(const Param& param) const
+		  -> std::shared_ptr<const Response> {
+			SPADES_MARK_FUNCTION();
+
+			float decayTime = std::max(std::min(param.decayTime, MaxLength), 0.05F);
+			float preDelay = std::max(std::min(param.preDelay, MaxLength * 0.1F), 0.0F);
+			float rate = (float)samplingRate;
+			std::size_t preDelayFrames = (std::size_t)(preDelay * rate);
+			std::size_t numFrames = preDelayFrames + (std::size_t)(decayTime * rate);
+
+			auto response = std::make_shared<Response>();
+			response->param = param;
+			response->numPartitions =
+			  std::min((numFrames + BlockSize - 1) / BlockSize, maxPartitions);
+			numFrames = response->numPartitions * BlockSize;
+
+			// Decaying noise. The high frequencies decay faster than the low ones.
+			std::vector<float> channels[2];
+			std::mt19937 rng{1};
+			std::uniform_real_distribution<float> noise{-1.0F, 1.0F};
+			const float lowPass = 1.0F - std::exp(-2.0F * M_PI_F * 2000.0F / rate);
+			const float lowDecay = -6.9078F / (decayTime * rate);
+			const float highDecay = lowDecay / std::max(param.damping, 0.05F);
+			double energy = 0.0;
+			for (auto& h : channels) {
+				h.assign(numFrames, 0.0F);
+				float low = 0.0F;
+				for (std::size_t i = preDelayFrames; i < numFrames; i++) {
+					float n = noise(rng);
+					low += (n - low) * lowPass;
+					float t = (float)(i - preDelayFrames);
+					h[i] = low * std::exp(lowDecay * t) + (n - low) * std::exp(highDecay * t);
+					energy += (double)h[i] * (double)h[i];
+				}
+			}
+
+			// A white input of unit power makes an output of `gain^2` power (per channel).
+			// `inverseFFT` doesn't normalize.
+			float scale = param.gain / std::sqrt(std::max((float)(energy / 2.0), 1.0e-20F)) /
+			              (float)FFTSize;
+
+			response->spectra.resize(response->numPartitions * FFTSize);
+			std::vector<kiss_fft_cpx> in(FFTSize);
+			for (std::size_t p = 0; p < response->numPartitions; p++) {
+				for (std::size_t i = 0; i < FFTSize; i++) {
+					std::size_t frame = p * BlockSize + i;
+					bool inside = i < BlockSize;
+					in[i].r = inside ? channels[0][frame] * scale : 0.0F;
+					in[i].i = inside ? channels[1][frame] * scale : 0.0F;
+				}
+				kiss_fft(forwardFFT, in.data(), &response->spectra[p * FFTSize]);
+			}
+
+			return response;
+		}
+
+		auto SoftReverb::SetResponse(std::shared_ptr<const Response> newResponse)
+		  -> std::shared_ptr<const Response> {
+			if (!response) {
+				// The input history is stale. Forget it.
+				std::fill(inputWindow.begin(), inputWindow.end(), 0.0F);
+				std::fill(inputSpectra.begin(), inputSpectra.end(), kiss_fft_cpx{0.0F, 0.0F});
+			}
+
+			// If a crossfade is pending, skip it
+			std::shared_ptr<const Response> retired = std::move(previousResponse);
+			previousResponse = std::move(response);
+			response = std::move(newResponse);
+			return retired;
+		}
+
+		void SoftReverb::Convolve(const Response& r, std::vector<kiss_fft_cpx>& out) {
+			std::fill(accumulator.begin(), accumulator.end(), kiss_fft_cpx{0.0F, 0.0F});
+			for (std::size_t p = 0; p < r.numPartitions; p++) {
+				std::size_t slot = (inputSpectraPos + maxPartitions - p) % maxPartitions;
+				MultiplyAccumulate(&inputSpectra[slot * FFTSize], &r.spectra[p * FFTSize],
+				                   accumulator.data(), FFTSize);
+			}
+			kiss_fft(inverseFFT, accumulator.data(), out.data());
+		}
+
+		void SoftReverb::Process(const float* input, float* outLeft, float* outRight) {
+			if (!response && !previousResponse)
+				return;
+
+			std::copy(inputWindow.begin() + BlockSize, inputWindow.end(), inputWindow.begin());
+			std::copy(input, input + BlockSize, inputWindow.begin() + BlockSize);
+
+			inputSpectraPos = (inputSpectraPos + 1) % maxPartitions;
+			for (std::size_t i = 0; i < FFTSize; i++) {
+				fftIn[i].r = inputWindow[i];
+				fftIn[i].i = 0.0F;
+			}
+			kiss_fft(forwardFFT, fftIn.data(), &inputSpectra[inputSpectraPos * FFTSize]);
+
+			// The second half of the circular convolution is the linear convolution
+			if (response)
+				Convolve(*response, fftOut);
+			else
+				std::fill(fftOut.begin(), fftOut.end(), kiss_fft_cpx{0.0F, 0.0F});
+
+			if (previousResponse) {
+				Convolve(*previousResponse, previousOutput);
+				for (std::size_t i = 0; i < BlockSize; i++) {
+					float fade = ((float)i + 0.5F) * (1.0F / (float)BlockSize);
+					const kiss_fft_cpx& a = previousOutput[BlockSize + i];
+					const kiss_fft_cpx& b = fftOut[BlockSize + i];
+					outLeft[i] += a.r + (b.r - a.r) * fade;
+					outRight[i] += a.i + (b.i - a.i) * fade;
+				}
+				previousResponse.reset();
+				return;
+			}
+
+			for (std::size_t i = 0; i < BlockSize; i++) {
+				outLeft[i] += fftOut[BlockSize + i].r;
+				outRight[i] += fftOut[BlockSize + i].i;
+			}
+		}
+	} // namespace audio
+} // namespace spades
@@ -0,0 +1,110 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <kiss_fft130/kiss_fft.h>
+
+namespace spades {
+	namespace audio {
+		/**
+		 * A stereo convolution reverb used by `SoftMixer`. The impulse response is a synthetic
+		 * decaying noise derived from the room estimation, and is convolved by a uniformly
+		 * partitioned overlap-save FFT convolution.
+		 *
+		 * Both output channels are computed by a single complex FFT: the impulse responses of
+		 * the left and right channels are stored as the real and imaginary parts of one
+		 * complex signal, and the input is real, so the real and imaginary parts of the
+		 * result are the two convolutions.
+		 */
+		class SoftReverb {
+		public:
+			enum { BlockSize = 256, FFTSize = BlockSize * 2 };
+
+			struct Param {
+				/** The time for the reverb to decay by 60 dB. */
+				float decayTime = 0.5F;
+				/** The delay before the reverb starts. */
+				float preDelay = 0.01F;
+				float gain = 0.0F;
+				/** The decay time of the highest frequencies, relative to `decayTime`. */
+				float damping = 0.5F;
+			};
+
+			/** The spectra of the partitions of an impulse response. Immutable. */
+			class Response {
+				friend class SoftReverb;
+				Param param;
+				std::size_t numPartitions;
+				std::vector<kiss_fft_cpx> spectra;
+
+			public:
+				const Param& GetParam() const { return param; }
+				std::size_t GetNumPartitions() const { return numPartitions; }
+			};
+
+			/** The longest impulse response. `Param::decayTime` is truncated to this. */
+			static constexpr float MaxLength = 1.5F;
+
+			explicit SoftReverb(int samplingRate);
+			~SoftReverb();
+
+			SoftReverb(const SoftReverb&) = delete;
+			void operator=(const SoftReverb&) = delete;
+
+			/** Builds an impulse response. Expensive, but can be called on any thread. */
+			std::shared_ptr<const Response> CreateResponse(const Param&) const;
+
+			/**
+			 * Switches to a new impulse response. The output of the next block crossfades from
+			 * the old one. The old one is returned so it can be destroyed outside the audio
+			 * thread.
+			 */
+			std::shared_ptr<const Response> SetResponse(std::shared_ptr<const Response>);
+
+			/** Adds the reverb of `BlockSize` samples of `input` to `outLeft` and `outRight`. */
+			void Process(const float* input, float* outLeft, float* outRight);
+
+		private:
+			int samplingRate;
+			std::size_t maxPartitions;
+			kiss_fft_cfg forwardFFT, inverseFFT;
+
+			std::shared_ptr<const Response> response;
+			/** The response being faded out by the next block. */
+			std::shared_ptr<const Response> previousResponse;
+
+			/** The last `FFTSize` input samples. */
+			std::vector<float> inputWindow;
+			/** The spectra of the last `maxPartitions` input windows, as a ring buffer. */
+			std::vector<kiss_fft_cpx> inputSpectra;
+			std::size_t inputSpectraPos;
+
+			std::vector<kiss_fft_cpx> fftIn, fftOut, accumulator, previousOutput;
+
+			/** Sums the spectra of the partitions and returns the time domain output. */
+			void Convolve(const Response&, std::vector<kiss_fft_cpx>& out);
+		};
+	} // namespace audio
+} // namespace spades
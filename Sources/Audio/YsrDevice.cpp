@@ -20,6 +20,8 @@
 
 #include <Imports/SDL.h>
 
+#include "AudioOcclusion.h"
+#include "SdlAudioDevice.h"
 #include "YsrDevice.h"
 #include <Client/GameMap.h>
 #include <Client/IAudioChunk.h>
@@ -305,34 +307,12 @@ namespace spades {
 			std::shared_ptr<YsrBuffer> GetBuffer() { return buffer; }
 		};
 
-		struct SdlAudioDevice {
-			SDL_AudioDeviceID id;
-			SDL_AudioSpec spec;
-
-			SdlAudioDevice(const char* deviceId, int isCapture, const SDL_AudioSpec& spec,
-			               int allowedChanges)
-			    : id(0) {
-				SDL_InitSubSystem(SDL_INIT_AUDIO);
-				id = SDL_OpenAudioDevice(deviceId, isCapture, &spec, &this->spec, allowedChanges);
-				if (id == 0) {
-					SPRaise("Failed to initialize the audio device: %s", SDL_GetError());
-				}
-			}
-
-			~SdlAudioDevice() {
-				if (id != 0)
-					SDL_CloseAudioDevice(id);
-			}
-
-			SDL_AudioDeviceID operator()() const { return id; }
-		};
-
 		static void DebugLog(const char* msg, void*) { SPLog("YSR Debug: %s", msg); }
 
 		YsrDevice::YsrDevice()
 		    : driver(new YsrDriver()),
 		      gameMap(nullptr),
-		      listenerPosition(MakeVector3(0, 0, 0)),
+		      occlusion(new AudioOcclusionCache()),
 		      roomHistoryPos(0) {
 			SDL_AudioSpec spec;
 			spec.callback = reinterpret_cast<SDL_AudioCallback>(RenderCallback);
@@ -391,24 +371,10 @@ namespace spades {
 			Vector3 origin(*reinterpret_cast<const YsrContext::YVec3*>(yorigin));
 			auto& result = *reinterpret_cast<YsrContext::SpatializeResult*>(_result);
 
-			// check obstruction
-			if (gameMap) {
-				Vector3 eye = listenerPosition;
-				Vector3 pos = origin;
-				Vector3 checkPos;
-				result.directGain = 0.4F;
-				for (int x = -1; x <= 1; x++)
-				for (int y = -1; y <= 1; y++)
-				for (int z = -1; z <= 1; z++) {
-					IntVector3 hitPos;
-					checkPos = pos + MakeVector3((float)x, (float)y, (float)z) * 0.2F;
-					if (!gameMap->CastRay(eye, (checkPos - eye).Normalize(),
-						(checkPos - eye).GetLength(), hitPos))
-						result.directGain = 1.0F;
-				}
-			} else {
-				result.directGain = 1.0F;
-			}
+			// check obstruction. This runs on the audio thread, so only the results computed by
+			// the game thread are used. Emitters not computed yet are treated as unobstructed.
+			stmp::optional<bool> occluded = occlusion->Lookup(origin);
+			result.directGain = (occluded && *occluded) ? 0.4F : 1.0F;
 		}
 
 		auto YsrDevice::CreateChunk(const char* name) -> YsrAudioChunk* {
@@ -457,13 +423,14 @@ namespace spades {
 				this->gameMap->AddRef();
 			if (old)
 				old->Release();
+			occlusion->SetGameMap(gameMap);
 		}
 
 		void YsrDevice::Respatialize(const spades::Vector3& eye, const spades::Vector3& front,
 		                             const spades::Vector3& up) {
 			SPADES_MARK_FUNCTION();
 
-			listenerPosition = eye;
+			occlusion->Update(eye);
 
 			YsrContext::ReverbParam reverbParam;
 			float maxDistance = 40.0F;
@@ -584,6 +551,7 @@ namespace spades {
 			if (chunk == nullptr)
 				SPRaise("Invalid chunk: null or invalid type.");
 
+			occlusion->AddEmitter(origin);
 			driver->PlayAbsolute(chunk->GetBuffer(), origin, TranslateParam(param));
 		}
 		void YsrDevice::PlayLocal(client::IAudioChunk* c, const Vector3& origin,
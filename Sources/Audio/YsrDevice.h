@@ -29,6 +29,7 @@
 namespace spades {
 	namespace audio {
 
+		class AudioOcclusionCache;
 		class YsrDriver;
 		class YsrAudioChunk;
 		struct SdlAudioDevice;
@@ -36,8 +37,12 @@ namespace spades {
 		class YsrDevice : public client::IAudioDevice {
 			std::shared_ptr<YsrDriver> driver;
 			client::GameMap* gameMap;
+			/**
+			 * Answers the obstruction queries of the spatializer running on the audio thread.
+			 * Declared before `sdlAudioDevice` so that it outlives the audio thread.
+			 */
+			std::unique_ptr<AudioOcclusionCache> occlusion;
 			std::unique_ptr<SdlAudioDevice> sdlAudioDevice;
-			Vector3 listenerPosition;
 
 			int roomHistoryPos;
 			enum { RoomHistorySize = 128 };
@@ -0,0 +1,72 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+// Replaces the global allocation functions of `spades-bench` to count heap allocations.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Benchmark.h"
+
+namespace {
+	std::atomic<std::uint64_t> numAllocations{0};
+	std::atomic<std::uint64_t> numAllocatedBytes{0};
+
+	void* Allocate(std::size_t size) {
+		numAllocations.fetch_add(1, std::memory_order_relaxed);
+		numAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+		return std::malloc(size ? size : 1);
+	}
+} // namespace
+
+namespace spades {
+	namespace bench {
+		AllocationCounters GetAllocationCounters() {
+			return AllocationCounters{numAllocations.load(std::memory_order_relaxed),
+			                          numAllocatedBytes.load(std::memory_order_relaxed)};
+		}
+	} // namespace bench
+} // namespace spades
+
+void* operator new(std::size_t size) {
+	void* p = Allocate(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](std::size_t size) {
+	void* p = Allocate(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return Allocate(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,161 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Audio/AudioOcclusion.h>
+#include <Client/GameMap.h>
+#include <Core/FileManager.h>
+#include <Core/MemoryStream.h>
+#include <Core/Stopwatch.h>
+
+using namespace spades;
+using namespace spades::audio;
+using namespace spades::client;
+
+namespace {
+	/** The obstruction test `YsrDevice::Spatialize` used to do for every voice. */
+	bool IsPathOccludedReference(const GameMap& map, const Vector3& eye, const Vector3& pos) {
+		bool occluded = true;
+		for (int x = -1; x <= 1; x++)
+			for (int y = -1; y <= 1; y++)
+				for (int z = -1; z <= 1; z++) {
+					IntVector3 hitPos;
+					Vector3 checkPos = pos + MakeVector3((float)x, (float)y, (float)z) * 0.2F;
+					if (!map.CastRay(eye, (checkPos - eye).Normalize(),
+					                 (checkPos - eye).GetLength(), hitPos))
+						occluded = false;
+				}
+		return occluded;
+	}
+
+	/** Returns a point 1.5 blocks above the ground at `(x, y)`. */
+	Vector3 AboveGround(const GameMap& map, int x, int y) {
+		int z = 0;
+		while (z < map.Depth() - 1 && !map.IsSolid(x, y, z))
+			z++;
+		return MakeVector3((float)x + 0.5F, (float)y + 0.5F, (float)z - 1.5F);
+	}
+
+	void RunMap(bench::BenchmarkContext& ctx, const std::string& prefix, GameMap& map) {
+		const int numEmitters = ctx.GetIntOption("emitters", 64);
+		const int numTicks = ctx.GetIntOption("ticks", 300);
+
+		std::mt19937 rng{1};
+		Vector3 listener = AboveGround(map, map.Width() / 2, map.Height() / 2);
+		std::vector<Vector3> emitters;
+		for (int i = 0; i < numEmitters; i++) {
+			int x = map.Width() / 2 + (int)(rng() % 81) - 40;
+			int y = map.Height() / 2 + (int)(rng() % 81) - 40;
+			emitters.push_back(AboveGround(map, x, y));
+		}
+
+		// Before: every voice casts its rays on every spatialization (once per tick here)
+		Stopwatch sw;
+		int numOccluded = 0;
+		for (int tick = 0; tick < numTicks; tick++)
+			for (const Vector3& e : emitters)
+				numOccluded += IsPathOccludedReference(map, listener, e) ? 1 : 0;
+		ctx.Report(prefix + "reference", sw.GetTime() * 1.0e6 / numTicks, "us/tick");
+		ctx.Report(prefix + "occluded", (double)numOccluded / numTicks, "emitters");
+
+		sw.Reset();
+		for (int tick = 0; tick < numTicks; tick++)
+			for (const Vector3& e : emitters)
+				IsPathOccluded(map, listener, e);
+		ctx.Report(prefix + "earlyExit", sw.GetTime() * 1.0e6 / numTicks, "us/tick");
+
+		AudioOcclusionCache cache;
+		cache.SetGameMap(&map);
+
+		// Static listener: only the first tick casts rays
+		int numMismatches = 0;
+		sw.Reset();
+		for (int tick = 0; tick < numTicks; tick++) {
+			for (const Vector3& e : emitters)
+				cache.AddEmitter(e);
+			cache.Update(listener);
+			for (const Vector3& e : emitters) {
+				stmp::optional<bool> occluded = cache.Lookup(e);
+				if (!occluded)
+					numMismatches++;
+			}
+		}
+		ctx.Report(prefix + "cachedStatic", sw.GetTime() * 1.0e6 / numTicks, "us/tick");
+
+		for (const Vector3& e : emitters) {
+			stmp::optional<bool> occluded = cache.Lookup(e);
+			if (!occluded || *occluded != IsPathOccludedReference(map, listener, e))
+				numMismatches++;
+		}
+		ctx.Report(prefix + "mismatches", numMismatches, "emitters");
+
+		// Walking listener: recomputed every few ticks
+		Vector3 walker = listener;
+		sw.Reset();
+		for (int tick = 0; tick < numTicks; tick++) {
+			walker.x += 0.1F;
+			cache.Update(walker);
+			for (const Vector3& e : emitters)
+				cache.Lookup(e);
+		}
+		ctx.Report(prefix + "cachedWalking", sw.GetTime() * 1.0e6 / numTicks, "us/tick");
+
+		// A block is placed and removed next to the listener every tick
+		IntVector3 block = (listener + MakeVector3(3.0F, 0.0F, 0.0F)).Floor();
+		bool wasSolid = map.IsSolid(block.x, block.y, block.z);
+		uint32_t color = map.GetColor(block.x, block.y, block.z);
+		sw.Reset();
+		for (int tick = 0; tick < numTicks; tick++) {
+			map.Set(block.x, block.y, block.z, (tick & 1) == 0, 0xff808080);
+			cache.Update(walker);
+			for (const Vector3& e : emitters)
+				cache.Lookup(e);
+		}
+		ctx.Report(prefix + "cachedBuilding", sw.GetTime() * 1.0e6 / numTicks, "us/tick");
+		map.Set(block.x, block.y, block.z, wasSolid, color);
+
+		// Looping voices are played once and then only looked up by the mixer. Their results
+		// must outlive the expiry of emitters that aren't played anymore.
+		int numExpired = 0;
+		for (int tick = 0; tick < 1200; tick++) {
+			cache.Update(walker);
+			for (const Vector3& e : emitters)
+				if (!cache.Lookup(e))
+					numExpired++;
+		}
+		ctx.Report(prefix + "expiredWhileLooping", numExpired, "lookups");
+		if (numExpired > 0)
+			SPRaise("%d lookups of playing voices found no result", numExpired);
+
+		cache.SetGameMap(nullptr);
+	}
+} // namespace
+
+SPADES_BENCHMARK(AudioOcclusion, "Obstruction of 64 voices, per voice vs cached batches") {
+	for (const std::string& path : ctx.GetMapFiles()) {
+		std::string data = FileManager::ReadAllBytes(path.c_str());
+		MemoryStream stream{data.data(), data.size()};
+		Handle<GameMap> map{GameMap::Load(&stream), false};
+		RunMap(ctx, path + ".", *map);
+	}
+}
@@ -0,0 +1,131 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Benchmark.h"
+#include <Core/Debug.h>
+#include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/Math.h>
+#include <json/json.h>
+
+namespace spades {
+	namespace bench {
+		namespace {
+			std::vector<BenchmarkInfo>& GetRegistry() {
+				static std::vector<BenchmarkInfo> registry;
+				return registry;
+			}
+		} // namespace
+
+		BenchmarkRegistrar::BenchmarkRegistrar(const char* name, const char* description,
+		                                       BenchmarkFunction func) {
+			GetRegistry().push_back(BenchmarkInfo{name, description, func});
+		}
+
+		std::vector<BenchmarkInfo> GetBenchmarks() {
+			std::vector<BenchmarkInfo> ret = GetRegistry();
+			std::sort(ret.begin(), ret.end(), [](const BenchmarkInfo& a, const BenchmarkInfo& b) {
+				return std::strcmp(a.name, b.name) < 0;
+			});
+			return ret;
+		}
+
+		void SectionProfile::Begin() {
+			start = GetAllocationCounters();
+			stopwatch.Reset();
+		}
+
+		void SectionProfile::End() {
+			time += stopwatch.GetTime();
+			AllocationCounters end = GetAllocationCounters();
+			numAllocations += end.count - start.count;
+			allocatedBytes += end.bytes - start.bytes;
+		}
+
+		BenchmarkContext::BenchmarkContext(std::map<std::string, std::string> options)
+		    : options{std::move(options)} {}
+
+		void BenchmarkContext::Report(const std::string& metric, double value, const char* unit) {
+			printf("%-24s %-40s %14.4f %s\n", currentBenchmark.c_str(), metric.c_str(), value,
+			       unit);
+			fflush(stdout);
+			measurements.push_back(Measurement{currentBenchmark, metric, value, unit});
+		}
+
+		void BenchmarkContext::ReportSection(const std::string& metric,
+		                                     const SectionProfile& profile, double numRuns,
+		                                     const std::string& runName) {
+			Report(metric + ".time", profile.GetTime() * 1.0e6 / numRuns, ("us/" + runName).c_str());
+			Report(metric + ".allocs", (double)profile.GetNumAllocations() / numRuns,
+			       ("allocs/" + runName).c_str());
+			Report(metric + ".bytes", (double)profile.GetAllocatedBytes() / numRuns,
+			       ("bytes/" + runName).c_str());
+		}
+
+		void BenchmarkContext::WriteJson(const std::string& path) const {
+			Json::Value root{Json::objectValue};
+			for (const auto& option : options)
+				root["options"][option.first] = option.second;
+
+			Json::Value& list = root["measurements"] = Json::Value{Json::arrayValue};
+			for (const Measurement& m : measurements) {
+				Json::Value item{Json::objectValue};
+				item["benchmark"] = m.benchmark;
+				item["metric"] = m.metric;
+				item["value"] = m.value;
+				item["unit"] = m.unit;
+				list.append(item);
+			}
+
+			std::string text = Json::StyledWriter{}.write(root);
+			FILE* f = std::fopen(path.c_str(), "wb");
+			if (!f)
+				SPRaise("Failed to open '%s' for writing", path.c_str());
+			std::fwrite(text.data(), 1, text.size(), f);
+			std::fclose(f);
+		}
+
+		std::string BenchmarkContext::GetOption(const std::string& name,
+		                                        const std::string& def) const {
+			auto it = options.find(name);
+			return it == options.end() ? def : it->second;
+		}
+
+		int BenchmarkContext::GetIntOption(const std::string& name, int def) const {
+			auto it = options.find(name);
+			return it == options.end() ? def : std::atoi(it->second.c_str());
+		}
+
+		std::vector<std::string> BenchmarkContext::GetMapFiles() const {
+			std::vector<std::string> ret;
+			for (const std::string& name : FileManager::EnumFiles("Maps")) {
+				if (name.size() > 4 && EqualsIgnoringCase(name.substr(name.size() - 4), ".vxl"))
+					ret.push_back("Maps/" + name);
+			}
+			std::sort(ret.begin(), ret.end());
+			return ret;
+		}
+	} // namespace bench
+} // namespace spades
@@ -0,0 +1,128 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Core/Stopwatch.h>
+
+namespace spades {
+	namespace bench {
+		/** The heap allocations made so far by all threads (counted by `operator new`). */
+		struct AllocationCounters {
+			std::uint64_t count;
+			std::uint64_t bytes;
+		};
+
+		AllocationCounters GetAllocationCounters();
+
+		/** Accumulates the time and the heap allocations of a code section over many runs. */
+		class SectionProfile {
+		public:
+			void Begin();
+			void End();
+
+			double GetTime() const { return time; }
+			std::uint64_t GetNumAllocations() const { return numAllocations; }
+			std::uint64_t GetAllocatedBytes() const { return allocatedBytes; }
+
+		private:
+			Stopwatch stopwatch;
+			AllocationCounters start;
+			double time = 0.0;
+			std::uint64_t numAllocations = 0;
+			std::uint64_t allocatedBytes = 0;
+		};
+
+		/**
+		 * Passed to a running benchmark. Collects the measurements and supplies the options
+		 * given on the command line.
+		 */
+		class BenchmarkContext {
+		public:
+			struct Measurement {
+				std::string benchmark;
+				std::string metric;
+				double value;
+				std::string unit;
+			};
+
+			BenchmarkContext(std::map<std::string, std::string> options);
+
+			/** Records a measurement of the currently running benchmark. */
+			void Report(const std::string& metric, double value, const char* unit);
+
+			/**
+			 * Reports the time and the allocations of a section, averaged over `numRuns` runs
+			 * of `runName` (e.g., "tick").
+			 */
+			void ReportSection(const std::string& metric, const SectionProfile&, double numRuns,
+			                   const std::string& runName);
+
+			/** Returns the value of the command line option `--name=value`, or `def`. */
+			int GetIntOption(const std::string& name, int def) const;
+			std::string GetOption(const std::string& name, const std::string& def) const;
+
+			/** Returns the paths of the bundled VXL maps in the `Maps` directory. */
+			std::vector<std::string> GetMapFiles() const;
+
+			const std::vector<Measurement>& GetMeasurements() const { return measurements; }
+
+			/** Writes the options and all measurements to a JSON file. */
+			void WriteJson(const std::string& path) const;
+
+			void SetCurrentBenchmark(const std::string& name) { currentBenchmark = name; }
+
+		private:
+			std::map<std::string, std::string> options;
+			std::vector<Measurement> measurements;
+			std::string currentBenchmark;
+		};
+
+		using BenchmarkFunction = void (*)(BenchmarkContext&);
+
+		struct BenchmarkInfo {
+			const char* name;
+			const char* description;
+			BenchmarkFunction func;
+		};
+
+		/** Returns all benchmarks registered by `SPADES_BENCHMARK`, sorted by name. */
+		std::vector<BenchmarkInfo> GetBenchmarks();
+
+		class BenchmarkRegistrar {
+		public:
+			BenchmarkRegistrar(const char* name, const char* description, BenchmarkFunction);
+		};
+	} // namespace bench
+} // namespace spades
+
+/**
+ * Defines and registers a benchmark. The body receives a `BenchmarkContext& ctx`.
+ */
+#define SPADES_BENCHMARK(name, description)                                                        \
+	static void Benchmark_##name(::spades::bench::BenchmarkContext&);                              \
+	static ::spades::bench::BenchmarkRegistrar benchmarkRegistrar_##name(#name, description,       \
+	                                                                      Benchmark_##name);       \
+	static void Benchmark_##name(::spades::bench::BenchmarkContext& ctx)
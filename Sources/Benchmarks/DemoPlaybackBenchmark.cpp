@@ -0,0 +1,761 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "InputTrace.h"
+#include <Client/GameMap.h>
+#include <Client/GameProperties.h>
+#include <Client/Grenade.h>
+#include <Client/INetClientListener.h>
+#include <Client/IWorldListener.h>
+#include <Client/NetClient.h>
+#include <Client/NetDemo.h>
+#include <Client/NetPacket.h>
+#include <Client/Player.h>
+#include <Client/Weapon.h>
+#include <Client/World.h>
+#include <Core/DeflateStream.h>
+#include <Core/DynamicMemoryStream.h>
+#include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/MemoryStream.h>
+#include <Core/Settings.h>
+
+SPADES_SETTING(cg_floatingBlockTimeBudget);
+SPADES_SETTING(cg_interpolationDelay);
+
+using namespace spades;
+using namespace spades::client;
+using namespace spades::bench;
+
+namespace {
+	class ServerPacket {
+		std::vector<char> data;
+
+	public:
+		ServerPacket(PacketType type) { data.push_back(static_cast<char>(type)); }
+
+		ServerPacket& Byte(int value) {
+			data.push_back(static_cast<char>(value));
+			return *this;
+		}
+		ServerPacket& Int(std::uint32_t value) {
+			for (int i = 0; i < 4; i++)
+				data.push_back(static_cast<char>(value >> (i * 8)));
+			return *this;
+		}
+		ServerPacket& Float(float value) {
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, 4);
+			return Int(bits);
+		}
+		ServerPacket& Vector(Vector3 v) { return Float(v.x).Float(v.y).Float(v.z); }
+		ServerPacket& IntVector(IntVector3 v) {
+			return Int((std::uint32_t)v.x).Int((std::uint32_t)v.y).Int((std::uint32_t)v.z);
+		}
+		ServerPacket& Color(IntVector3 v) { return Byte(v.z).Byte(v.y).Byte(v.x); }
+		ServerPacket& String(const std::string& str, std::size_t length = 0) {
+			data.insert(data.end(), str.begin(), str.end());
+			for (std::size_t i = str.size(); i < length; i++)
+				data.push_back(0);
+			return *this;
+		}
+		ServerPacket& Bytes(const char* bytes, std::size_t numBytes) {
+			data.insert(data.end(), bytes, bytes + numBytes);
+			return *this;
+		}
+
+		const std::vector<char>& GetData() const { return data; }
+	};
+
+	std::string Compress(const std::string& data) {
+		DynamicMemoryStream stream;
+		{
+			DeflateStream deflate(&stream, CompressModeCompress);
+			deflate.Write(data.data(), data.size());
+			deflate.DeflateEnd();
+		}
+		stream.SetPosition(0);
+		return stream.Read(static_cast<std::size_t>(stream.GetLength()));
+	}
+
+	/** The positions of the players on the server after each tick. */
+	struct GroundTruth {
+		struct Sample {
+			Vector3 position;
+			bool alive;
+		};
+
+		/** The demo time of the first tick. */
+		double startTime = 0.0;
+		int numPlayers = 0;
+		int numTicks = 0;
+		std::vector<Sample> samples;
+
+		const Sample& Get(int tick, int playerId) const {
+			return samples[tick * numPlayers + playerId];
+		}
+	};
+
+	/**
+	 * Plays a pyspades server hosting scripted players and records what it would send to a
+	 * spectating client. The players run in a server-side `World`, which decides their
+	 * positions, hits, and thrown grenades.
+	 */
+	class DemoServer : public IWorldListener {
+	public:
+		DemoServer(NetDemoWriter& writer, const std::string& mapData, const InputTrace& trace,
+		           GroundTruth& truth, double jitter)
+		    : writer(writer), mapData(mapData), trace(trace), truth(truth), jitter(jitter),
+		      rng(1), jitterRng(2) {}
+
+		void Run();
+
+		void PlayerObjectSet(int) override {}
+		void PlayerMadeFootstep(Player&) override {}
+		void PlayerJumped(Player&) override {}
+		void PlayerLanded(Player&, bool) override {}
+		void PlayerFiredWeapon(Player&) override {}
+		void PlayerEjectedBrass(Player&) override {}
+		void PlayerDryFiredWeapon(Player&) override {}
+		void PlayerReloadingWeapon(Player&) override {}
+		void PlayerReloadedWeapon(Player&) override {}
+		void PlayerChangedTool(Player&) override {}
+		void PlayerPulledGrenadePin(Player&) override {}
+		void PlayerThrewGrenade(Player& p, stmp::optional<const Grenade&>) override {
+			Vector3 dir = p.GetFront();
+			thrownGrenades.push_back({p.GetId(), p.GetEye() + dir * 0.1F, dir + p.GetVelocity(),
+			                          3.0F - p.GetGrenadeCookTime()});
+		}
+		void PlayerMissedSpade(Player&) override {}
+		void PlayerHitBlockWithSpade(Player&, Vector3, IntVector3, IntVector3) override {}
+		void PlayerKilledPlayer(Player&, Player&, KillType) override {}
+		void PlayerRestocked(Player&) override {}
+		void BulletHitPlayer(Player& hurtPlayer, HitType type, Vector3, Player& by,
+		                     std::unique_ptr<IBulletHitScanState>&) override {
+			hits.push_back({hurtPlayer.GetId(), by.GetId(), type == HitTypeHead});
+		}
+		void BulletNearPlayer(Player&) override {}
+		void BulletHitBlock(Vector3, IntVector3, IntVector3) override {}
+		void AddBulletTracer(Player&, Vector3, Vector3) override {}
+		void GrenadeExploded(const Grenade& g) override {
+			explosions.push_back(g.GetPosition().Floor());
+		}
+		void GrenadeBounced(const Grenade&) override {}
+		void GrenadeDroppedIntoWater(const Grenade&) override {}
+		void BlocksFell(std::vector<IntVector3>) override {}
+		void LocalPlayerBlockAction(IntVector3, BlockActionType) override {}
+		void LocalPlayerCreatedLineBlock(IntVector3, IntVector3) override {}
+		void LocalPlayerHurt(HurtType, Vector3) override {}
+		void LocalPlayerBuildError(BuildFailureReason) override {}
+
+	private:
+		struct ThrownGrenade {
+			int playerId;
+			Vector3 position, velocity;
+			float fuse;
+		};
+		struct Hit {
+			int victimId, killerId;
+			bool headshot;
+		};
+		struct BotState {
+			/** The tick at which the player respawns while dead. */
+			int respawnTick = 0;
+			int health = 100;
+			std::uint8_t input = 0xff, weaponInput = 0xff, tool = 0xff;
+		};
+
+		NetDemoWriter& writer;
+		const std::string& mapData;
+		const InputTrace& trace;
+		GroundTruth& truth;
+		/** The maximum delay of the world updates, in seconds. */
+		double jitter;
+		std::mt19937 rng, jitterRng;
+		double time = 0.0;
+		/** Packets are delivered in order even if delayed. */
+		double lastSendTime = 0.0;
+
+		std::unique_ptr<World> world;
+		Handle<GameMap> map;
+		IntVector3 center;
+		std::vector<BotState> bots;
+
+		std::vector<ThrownGrenade> thrownGrenades;
+		std::vector<Hit> hits;
+		std::vector<IntVector3> explosions;
+
+		void Send(const ServerPacket& packet, double delay = 0.0) {
+			const std::vector<char>& data = packet.GetData();
+			lastSendTime = std::max(time + delay, lastSendTime);
+			writer.WritePacket(lastSendTime, data.data(), data.size());
+		}
+
+		void SpawnPlayer(int id, int tick);
+		void KillPlayer(int victimId, int killerId, int killType, int tick);
+		void ApplyBlockChange(int playerId, IntVector3 position, BlockActionType action,
+		                      IntVector3 color);
+		void SendWorldUpdate();
+	};
+
+	void DemoServer::Run() {
+		{
+			MemoryStream stream{mapData.data(), mapData.size()};
+			map = Handle<GameMap>{GameMap::Load(&stream), false};
+		}
+		center = MakeIntVector3(map->Width() / 2, map->Height() / 2, 0);
+		world.reset(new World(std::make_shared<GameProperties>(ProtocolVersion::v075)));
+		world->SetMap(map);
+		world->SetListener(this);
+
+		writer.WriteConnect(time);
+
+		// The map transfer, in chunks as large as pyspades sends
+		std::string compressed = Compress(mapData);
+		Send(ServerPacket{PacketTypeMapStart}.Int((std::uint32_t)compressed.size()));
+		for (std::size_t offset = 0; offset < compressed.size(); offset += 8192) {
+			time += 0.002;
+			std::size_t numBytes = std::min<std::size_t>(8192, compressed.size() - offset);
+			Send(ServerPacket{PacketTypeMapChunk}.Bytes(compressed.data() + offset, numBytes));
+		}
+
+		// We are a spectator in the last slot, playing the TC mode with no territories
+		time += 0.01;
+		int localPlayerId = 31;
+		Send(ServerPacket{PacketTypeStateData}
+		       .Byte(localPlayerId)
+		       .Color(MakeIntVector3(128, 232, 255))
+		       .Color(MakeIntVector3(0, 0, 255))
+		       .Color(MakeIntVector3(0, 255, 0))
+		       .String("Blue", 10)
+		       .String("Green", 10)
+		       .Byte(1)
+		       .Byte(0));
+		world->GetTeam(0).color = MakeIntVector3(0, 0, 255);
+		world->GetTeam(1).color = MakeIntVector3(0, 255, 0);
+
+		int numPlayers = std::min(trace.numPlayers, localPlayerId);
+		bots.resize(numPlayers);
+		for (int i = 0; i < numPlayers; i++)
+			SpawnPlayer(i, 0);
+
+		BlockEditResolver editResolver;
+		std::vector<BlockChange> blockChanges;
+		std::size_t nextEdit = 0;
+		double startTime = time;
+
+		truth.startTime = startTime;
+		truth.numPlayers = numPlayers;
+		truth.numTicks = trace.numTicks;
+		truth.samples.reserve((std::size_t)trace.numTicks * numPlayers);
+
+		for (int tick = 0; tick < trace.numTicks; tick++) {
+			time = startTime + tick * (double)TickDuration;
+
+			for (int i = 0; i < numPlayers; i++) {
+				BotState& bot = bots[i];
+				if (!world->GetPlayer(i)) {
+					if (tick >= bot.respawnTick)
+						SpawnPlayer(i, tick);
+					continue;
+				}
+
+				Player& player = world->GetPlayer(i).value();
+				const PlayerFrame& frame = trace.GetFrame(tick, i);
+
+				// Only the changes are sent
+				PlayerInput input = frame.GetInput();
+				std::uint8_t inputBits = (input.moveForward ? 1 : 0) |
+				                         (input.moveBackward ? 2 : 0) | (input.moveLeft ? 4 : 0) |
+				                         (input.moveRight ? 8 : 0) | (input.jump ? 16 : 0) |
+				                         (input.crouch ? 32 : 0) | (input.sprint ? 128 : 0);
+				if (inputBits != bot.input) {
+					Send(ServerPacket{PacketTypeInputData}.Byte(i).Byte(inputBits));
+					bot.input = inputBits;
+				}
+				if (frame.tool != bot.tool) {
+					Send(ServerPacket{PacketTypeSetTool}.Byte(i).Byte(frame.tool));
+					player.SetTool(static_cast<Player::ToolType>(frame.tool));
+					bot.tool = frame.tool;
+				}
+				if (frame.buttons != bot.weaponInput) {
+					Send(ServerPacket{PacketTypeWeaponInput}.Byte(i).Byte(frame.buttons));
+					bot.weaponInput = frame.buttons;
+				}
+				player.SetInput(input);
+				player.SetWeaponInput(frame.GetWeaponInput());
+				player.SetOrientation(frame.GetOrientation());
+
+				Weapon& weapon = player.GetWeapon();
+				if (weapon.GetAmmo() == 0 && !weapon.IsReloading() && weapon.GetStock() > 0) {
+					Send(ServerPacket{PacketTypeWeaponReload}.Byte(i).Byte(0).Byte(0));
+					player.Reload();
+				}
+
+				Vector3 pos = player.GetPosition();
+				if (pos.z > 61.0F || std::fabs(pos.x - (float)center.x) > 96.0F ||
+				    std::fabs(pos.y - (float)center.y) > 96.0F)
+					KillPlayer(i, i, KillTypeFall, tick);
+			}
+
+			for (; nextEdit < trace.edits.size() && trace.edits[nextEdit].tick <= (unsigned)tick;
+			     nextEdit++) {
+				blockChanges.clear();
+				editResolver.Resolve(trace.edits[nextEdit], *map, blockChanges);
+				int playerId = (int)(nextEdit % numPlayers);
+				for (const BlockChange& change : blockChanges) {
+					ApplyBlockChange(playerId, change.position,
+					                 change.create ? BlockActionCreate : BlockActionTool,
+					                 change.color);
+				}
+			}
+
+			for (const ThrownGrenade& g : thrownGrenades) {
+				Send(ServerPacket{PacketTypeGrenadePacket}
+				       .Byte(g.playerId)
+				       .Float(g.fuse)
+				       .Vector(g.position)
+				       .Vector(g.velocity));
+				world->AddGrenade(
+				  stmp::make_unique<Grenade>(*world, g.position, g.velocity, g.fuse));
+			}
+			thrownGrenades.clear();
+
+			world->Advance(TickDuration);
+
+			for (const IntVector3& pos : explosions)
+				ApplyBlockChange(255, pos, BlockActionGrenade, IntVector3());
+			explosions.clear();
+
+			for (const Hit& hit : hits) {
+				if (!world->GetPlayer(hit.victimId))
+					continue;
+				BotState& bot = bots[hit.victimId];
+				bot.health -= hit.headshot ? 100 : 35;
+				if (bot.health <= 0) {
+					KillPlayer(hit.victimId, hit.killerId,
+					           hit.headshot ? KillTypeHeadshot : KillTypeWeapon, tick);
+				}
+			}
+			hits.clear();
+
+			if (tick % 300 == 150) {
+				int speaker = (int)(rng() % numPlayers);
+				if (world->GetPlayer(speaker))
+					Send(ServerPacket{PacketTypeChatMessage}.Byte(speaker).Byte(0).String("gg"));
+			}
+
+			for (int i = 0; i < numPlayers; i++) {
+				auto player = world->GetPlayer(i);
+				truth.samples.push_back({player ? player->GetPosition() : Vector3(), !!player});
+			}
+
+			// pyspades sends the positions 10 times a second
+			if (tick % 6 == 0)
+				SendWorldUpdate();
+		}
+
+		world->SetListener(nullptr);
+	}
+
+	void DemoServer::SpawnPlayer(int id, int tick) {
+		Vector3 pos = GetSpawnPosition(*map, center, id + tick);
+		int weapon = id % 3;
+		int team = id & 1;
+		const WeaponType weapons[] = {RIFLE_WEAPON, SMG_WEAPON, SHOTGUN_WEAPON};
+
+		Send(ServerPacket{PacketTypeCreatePlayer}
+		       .Byte(id)
+		       .Byte(weapon)
+		       .Byte(team)
+		       .Vector(pos + MakeVector3(0.0F, 0.0F, 2.4F))
+		       .String("Bot" + std::to_string(id)));
+		world->SetPlayer(id, stmp::make_unique<Player>(*world, id, weapons[weapon], team, pos,
+		                                               world->GetTeamColor(team)));
+
+		BotState& bot = bots[id];
+		bot.health = 100;
+		bot.input = bot.weaponInput = bot.tool = 0xff;
+	}
+
+	void DemoServer::KillPlayer(int victimId, int killerId, int killType, int tick) {
+		Send(ServerPacket{PacketTypeKillAction}
+		       .Byte(victimId)
+		       .Byte(killerId)
+		       .Byte(killType)
+		       .Byte(5));
+		// Removed on the server until it respawns
+		world->SetPlayer(victimId, nullptr);
+		bots[victimId].respawnTick = tick + 5 * 60;
+	}
+
+	void DemoServer::ApplyBlockChange(int playerId, IntVector3 position, BlockActionType action,
+	                                  IntVector3 color) {
+		if (!map->IsValidMapCoord(position.x, position.y, position.z))
+			return;
+		if (!world->GetPlayer(playerId))
+			playerId = 255;
+		Send(ServerPacket{PacketTypeBlockAction}.Byte(playerId).Byte(action).IntVector(position));
+
+		std::vector<IntVector3> cells;
+		switch (action) {
+			case BlockActionCreate:
+				if (playerId != 255)
+					color = world->GetPlayer(playerId)->GetBlockColor();
+				world->CreateBlock(position, color);
+				break;
+			case BlockActionTool: cells.push_back(position); break;
+			case BlockActionGrenade:
+				for (int x = -1; x <= 1; x++)
+					for (int y = -1; y <= 1; y++)
+						for (int z = -1; z <= 1; z++)
+							cells.push_back(position + MakeIntVector3(x, y, z));
+				break;
+			default: break;
+		}
+		if (!cells.empty())
+			world->DestroyBlock(cells);
+	}
+
+	void DemoServer::SendWorldUpdate() {
+		ServerPacket packet{PacketTypeWorldUpdate};
+		for (int i = 0; i < 32; i++) {
+			auto player = world->GetPlayer(i);
+			if (player) {
+				packet.Vector(player->GetPosition()).Vector(player->GetFront());
+			} else {
+				packet.Vector(MakeVector3(0.0F, 0.0F, 0.0F)).Vector(MakeVector3(0.0F, 0.0F, 0.0F));
+			}
+		}
+		// Unreliable packets are delayed by varying amounts in a real network
+		Send(packet, std::uniform_real_distribution<double>{0.0, jitter}(jitterRng));
+	}
+
+	std::string SynthesizeDemo(const std::string& mapData, const InputTrace& trace,
+	                           GroundTruth& truth, double jitter) {
+		// Owned by `writer`
+		auto* memory = new DynamicMemoryStream();
+		NetDemoWriter writer{std::unique_ptr<IStream>{memory}, ProtocolVersion::v075};
+
+		DemoServer server{writer, mapData, trace, truth, jitter};
+		server.Run();
+		writer.Flush();
+
+		memory->SetPosition(0);
+		return memory->Read(static_cast<std::size_t>(memory->GetLength()));
+	}
+
+	/** Stands in for `Client`. Owns the world and counts the events. */
+	class HeadlessClient : public INetClientListener, public IWorldListener {
+		std::unique_ptr<World> world;
+
+	public:
+		int numWorldUpdates = 0, numSpawns = 0, numKills = 0, numShots = 0, numBlockChanges = 0;
+		int numFallenBlocks = 0, numExplosions = 0, numMessages = 0;
+
+		~HeadlessClient() {
+			if (world)
+				world->SetListener(nullptr);
+		}
+
+		// INetClientListener
+		void SetWorld(World* w) override {
+			if (world)
+				world->SetListener(nullptr);
+			world.reset(w);
+			if (world)
+				world->SetListener(this);
+		}
+		World* GetWorld() const override { return world.get(); }
+		void MarkWorldUpdate() override { numWorldUpdates++; }
+		void PlayerSentChatMessage(Player&, bool, const std::string&) override { numMessages++; }
+		void ServerSentMessage(bool, const std::string&) override { numMessages++; }
+		void PlayerCapturedIntel(Player&) override {}
+		void PlayerPickedIntel(Player&) override {}
+		void PlayerDropIntel(Player&) override {}
+		void TeamCapturedTerritory(int, int) override {}
+		void TeamWon(int) override {}
+		void JoinedGame() override {}
+		void LocalPlayerCreated() override {}
+		void RegisterPlacedBlocks(int) override {}
+		void PlayerCreatedBlock(Player&) override { numBlockChanges++; }
+		void PlayerDestroyedBlockWithWeaponOrTool(IntVector3) override { numBlockChanges++; }
+		void PlayerDiggedBlock(IntVector3) override { numBlockChanges++; }
+		void GrenadeDestroyedBlock(IntVector3) override { numBlockChanges++; }
+		void PlayerLeaving(Player&) override {}
+		void PlayerJoinedTeam(Player&) override {}
+		void PlayerSpawned(Player&) override { numSpawns++; }
+
+		// IWorldListener
+		void PlayerObjectSet(int) override {}
+		void PlayerMadeFootstep(Player&) override {}
+		void PlayerJumped(Player&) override {}
+		void PlayerLanded(Player&, bool) override {}
+		void PlayerFiredWeapon(Player&) override { numShots++; }
+		void PlayerEjectedBrass(Player&) override {}
+		void PlayerDryFiredWeapon(Player&) override {}
+		void PlayerReloadingWeapon(Player&) override {}
+		void PlayerReloadedWeapon(Player&) override {}
+		void PlayerChangedTool(Player&) override {}
+		void PlayerPulledGrenadePin(Player&) override {}
+		void PlayerThrewGrenade(Player&, stmp::optional<const Grenade&>) override {}
+		void PlayerMissedSpade(Player&) override {}
+		void PlayerHitBlockWithSpade(Player&, Vector3, IntVector3, IntVector3) override {}
+		void PlayerKilledPlayer(Player&, Player&, KillType) override { numKills++; }
+		void PlayerRestocked(Player&) override {}
+		void BulletHitPlayer(Player&, HitType, Vector3, Player&,
+		                     std::unique_ptr<IBulletHitScanState>&) override {}
+		void BulletNearPlayer(Player&) override {}
+		void BulletHitBlock(Vector3, IntVector3, IntVector3) override {}
+		void AddBulletTracer(Player&, Vector3, Vector3) override {}
+		void GrenadeExploded(const Grenade&) override { numExplosions++; }
+		void GrenadeBounced(const Grenade&) override {}
+		void GrenadeDroppedIntoWater(const Grenade&) override {}
+		void BlocksFell(std::vector<IntVector3> blocks) override {
+			numFallenBlocks += (int)blocks.size();
+		}
+		void LocalPlayerBlockAction(IntVector3, BlockActionType) override {}
+		void LocalPlayerCreatedLineBlock(IntVector3, IntVector3) override {}
+		void LocalPlayerHurt(HurtType, Vector3) override {}
+		void LocalPlayerBuildError(BuildFailureReason) override {}
+	};
+
+	void HashBytes(std::uint64_t& hash, const void* data, std::size_t numBytes) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (std::size_t i = 0; i < numBytes; i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	}
+
+	struct PlaybackResult {
+		double duration = 0.0;
+		int numTicks = 0;
+		/** The positions of the players sampled every second. */
+		std::uint64_t playerHash = 14695981039346656037ULL;
+		/** The final state of the map. */
+		std::uint64_t mapHash = 14695981039346656037ULL;
+
+		/**
+		 * The distance between the remote players and where the server had them
+		 * `cg_interpolationDelay` ago.
+		 */
+		double meanError = 0.0, maxError = 0.0;
+		/** The mean second difference of the remote players' positions per tick. */
+		double meanJerk = 0.0;
+	};
+
+	/**
+	 * Feeds a demo through `NetClient` and `World` as fast as possible, 60 ticks per second.
+	 * Compares the players with `truth` if given.
+	 */
+	PlaybackResult Play(BenchmarkContext& ctx, const std::string& demo, bool report,
+	                    const GroundTruth* truth = nullptr) {
+		HeadlessClient client;
+		NetClient net{&client};
+		net.PlayDemo(std::unique_ptr<IStream>{new MemoryStream(demo.data(), demo.size())});
+
+		SectionProfile mapProfile, packetProfile, worldProfile;
+		PlaybackResult result;
+		int numGameTicks = 0;
+
+		struct TrackedPlayer {
+			Vector3 previous[2];
+			int numSamples = 0;
+		};
+		std::vector<TrackedPlayer> tracked(truth ? truth->numPlayers : 0);
+		double delay = std::max((float)cg_interpolationDelay, 0.0F);
+		double errorSum = 0.0, jerkSum = 0.0;
+		int numErrorSamples = 0, numJerkSamples = 0;
+
+		while (net.GetStatus() != NetClientStatusNotConnected) {
+			result.numTicks++;
+			double time = result.numTicks * (double)TickDuration;
+
+			bool connected = net.GetStatus() == NetClientStatusConnected;
+			SectionProfile& profile = connected ? packetProfile : mapProfile;
+			profile.Begin();
+			net.ProcessDemo(time);
+			profile.End();
+
+			World* world = client.GetWorld();
+			if (!world || !connected)
+				continue;
+
+			numGameTicks++;
+			worldProfile.Begin();
+			world->Advance(TickDuration);
+			worldProfile.End();
+
+			for (int i = 0; i < (int)tracked.size(); i++) {
+				auto p = world->GetPlayer(i);
+				TrackedPlayer& t = tracked[i];
+				if (!p || !p->IsAlive() || p->IsSpectator()) {
+					t.numSamples = 0;
+					continue;
+				}
+
+				Vector3 pos = p->GetPosition();
+				if (t.numSamples >= 2) {
+					jerkSum += (pos - t.previous[0] * 2.0F + t.previous[1]).GetLength();
+					numJerkSamples++;
+				}
+				t.previous[1] = t.previous[0];
+				t.previous[0] = pos;
+				t.numSamples++;
+
+				int tick = (int)std::lround((time - delay - truth->startTime) / TickDuration);
+				if (tick < 0 || tick >= truth->numTicks || !truth->Get(tick, i).alive)
+					continue;
+				double error = (pos - truth->Get(tick, i).position).GetLength();
+				errorSum += error;
+				result.maxError = std::max(result.maxError, error);
+				numErrorSamples++;
+			}
+
+			if (result.numTicks % 60 == 0) {
+				for (std::size_t i = 0; i < world->GetNumPlayerSlots(); i++) {
+					auto p = world->GetPlayer(static_cast<unsigned int>(i));
+					if (!p)
+						continue;
+					Vector3 pos = p->GetPosition();
+					HashBytes(result.playerHash, &pos, sizeof(pos));
+				}
+			}
+		}
+		result.duration = result.numTicks * (double)TickDuration;
+		result.meanError = errorSum / std::max(numErrorSamples, 1);
+		result.meanJerk = jerkSum / std::max(numJerkSamples, 1);
+
+		if (World* world = client.GetWorld()) {
+			GameMap& map = *world->GetMap();
+			for (int y = 0; y < map.Height(); y++)
+				for (int x = 0; x < map.Width(); x++) {
+					std::uint64_t solid = map.GetSolidMap(x, y);
+					HashBytes(result.mapHash, &solid, sizeof(solid));
+				}
+		}
+
+		if (report) {
+			ctx.Report("demoLength", result.duration, "s");
+			ctx.ReportSection("mapTransfer", mapProfile, 1.0, "demo");
+			ctx.ReportSection("packets", packetProfile, numGameTicks, "tick");
+			ctx.ReportSection("world", worldProfile, numGameTicks, "tick");
+			double wallTime =
+			  mapProfile.GetTime() + packetProfile.GetTime() + worldProfile.GetTime();
+			ctx.Report("realtimeFactor", result.duration / std::max(wallTime, 1.0e-9), "x");
+			ctx.Report("worldUpdates", client.numWorldUpdates, "packets");
+			ctx.Report("spawns", client.numSpawns, "events");
+			ctx.Report("kills", client.numKills, "events");
+			ctx.Report("shots", client.numShots, "events");
+			ctx.Report("blockActions", client.numBlockChanges, "events");
+			ctx.Report("fallenBlocks", client.numFallenBlocks, "blocks");
+			ctx.Report("explosions", client.numExplosions, "events");
+			ctx.Report("messages", client.numMessages, "events");
+		}
+		return result;
+	}
+
+	std::string ReadFile(const std::string& path) {
+		FILE* f = std::fopen(path.c_str(), "rb");
+		if (!f)
+			SPRaise("Failed to open '%s'", path.c_str());
+		std::string data;
+		char buffer[4096];
+		std::size_t count;
+		while ((count = std::fread(buffer, 1, sizeof(buffer), f)) > 0)
+			data.append(buffer, count);
+		std::fclose(f);
+		return data;
+	}
+} // namespace
+
+SPADES_BENCHMARK(DemoPlayback, "Headless playback of a network demo through NetClient and World") {
+	// The floating block detection must not depend on timing for the synthesis and the
+	// playback to be deterministic
+	int timeBudget = cg_floatingBlockTimeBudget;
+	cg_floatingBlockTimeBudget = 0;
+
+	std::string demo;
+	GroundTruth truth;
+	std::string demoPath = ctx.GetOption("demo", "");
+	if (!demoPath.empty()) {
+		demo = ReadFile(demoPath);
+	} else {
+		// Synthesize a demo of a busy server. The weapon spread is random, so the demos differ
+		// from run to run; use `--save-demo` and `--demo` to compare builds with the same one.
+		std::vector<std::string> maps = ctx.GetMapFiles();
+		std::string mapPath = ctx.GetOption("map", maps.empty() ? std::string() : maps.front());
+		if (mapPath.empty())
+			SPRaise("No map found");
+		std::string mapData = FileManager::ReadAllBytes(mapPath.c_str());
+
+		InputTrace trace = InputTrace::Generate(
+		  ctx.GetIntOption("players", 24), ctx.GetIntOption("seconds", 60) * 60,
+		  ctx.GetIntOption("edits", 30), MakeIntVector3(256, 256, 0),
+		  (unsigned)ctx.GetIntOption("seed", 1));
+		demo = SynthesizeDemo(mapData, trace, truth,
+		                      ctx.GetIntOption("jitter-ms", 20) / 1000.0);
+
+		std::string savePath = ctx.GetOption("save-demo", "");
+		if (!savePath.empty()) {
+			FILE* f = std::fopen(savePath.c_str(), "wb");
+			if (!f)
+				SPRaise("Failed to open '%s' for writing", savePath.c_str());
+			std::fwrite(demo.data(), 1, demo.size(), f);
+			std::fclose(f);
+		}
+	}
+	ctx.Report("demoSize", (double)demo.size() / 1024.0, "KiB");
+
+	// The positions are compared with the server's only for a synthesized demo
+	const GroundTruth* truthOrNull = truth.samples.empty() ? nullptr : &truth;
+	PlaybackResult first = Play(ctx, demo, true, truthOrNull);
+	PlaybackResult second = Play(ctx, demo, false);
+	ctx.Report("mismatches",
+	           (first.playerHash != second.playerHash ? 1 : 0) +
+	             (first.mapHash != second.mapHash ? 1 : 0),
+	           "");
+
+	if (truthOrNull) {
+		// Compare with the remote players snapped to each world update as they arrive
+		float interpolationDelay = cg_interpolationDelay;
+		cg_interpolationDelay = 0.0F;
+		PlaybackResult snapping = Play(ctx, demo, false, truthOrNull);
+		cg_interpolationDelay = interpolationDelay;
+
+		ctx.Report("snapping.meanError", snapping.meanError, "blocks");
+		ctx.Report("snapping.maxError", snapping.maxError, "blocks");
+		ctx.Report("snapping.meanJerk", snapping.meanJerk, "blocks/tick^2");
+		ctx.Report("interpolated.meanError", first.meanError, "blocks");
+		ctx.Report("interpolated.maxError", first.maxError, "blocks");
+		ctx.Report("interpolated.meanJerk", first.meanJerk, "blocks/tick^2");
+	}
+
+	cg_floatingBlockTimeBudget = timeBudget;
+}
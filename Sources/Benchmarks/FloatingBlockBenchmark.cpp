@@ -0,0 +1,228 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/GameMapWrapper.h>
+#include <Core/FileManager.h>
+#include <Core/MemoryStream.h>
+#include <Core/Stopwatch.h>
+
+using namespace spades;
+using namespace spades::client;
+
+namespace {
+	/** Builds a slab of `size`x`size`x4 blocks that is held up by a single pillar. */
+	Handle<GameMap> CreateOverhangMap(int size, std::vector<CellPos>& pillarCut) {
+		Handle<GameMap> map{new GameMap(), false};
+		const uint32_t color = 0x64808080;
+		int cx = map->Width() / 2, cy = map->Height() / 2;
+
+		for (int x = 0; x < map->Width(); x++)
+			for (int y = 0; y < map->Height(); y++)
+				map->Set(x, y, map->Depth() - 2, true, color, true);
+
+		for (int x = cx - size / 2; x < cx + size / 2; x++)
+			for (int y = cy - size / 2; y < cy + size / 2; y++)
+				for (int z = 16; z < 20; z++)
+					map->Set(x, y, z, true, color, true);
+
+		pillarCut.clear();
+		for (int x = cx - 2; x < cx + 2; x++)
+			for (int y = cy - 2; y < cy + 2; y++) {
+				for (int z = 20; z < map->Depth() - 2; z++)
+					map->Set(x, y, z, true, color, true);
+				pillarCut.emplace_back(x, y, 40);
+			}
+		return map;
+	}
+
+	/**
+	 * Finds the blocks connected to the ground by a brute-force flood fill. This is what
+	 * `GameMapWrapper` computes incrementally.
+	 */
+	std::vector<bool> FindSupportedBlocks(GameMap& map) {
+		int w = map.Width(), h = map.Height(), d = map.Depth();
+		auto index = [=](int x, int y, int z) { return ((std::size_t)x * h + y) * d + z; };
+		std::vector<bool> supported((std::size_t)w * h * d);
+		std::vector<CellPos> stack;
+
+		for (int x = 0; x < w; x++)
+			for (int y = 0; y < h; y++) {
+				supported[index(x, y, d - 1)] = true;
+				if (map.IsSolid(x, y, d - 2)) {
+					supported[index(x, y, d - 2)] = true;
+					stack.emplace_back(x, y, d - 2);
+				}
+			}
+
+		while (!stack.empty()) {
+			CellPos p = stack.back();
+			stack.pop_back();
+
+			auto visit = [&](int x, int y, int z) {
+				if (x < 0 || y < 0 || z < 0 || x >= w || y >= h || z >= d)
+					return;
+				if (supported[index(x, y, z)] || !map.IsSolid(x, y, z))
+					return;
+				supported[index(x, y, z)] = true;
+				stack.emplace_back(x, y, z);
+			};
+			visit(p.x - 1, p.y, p.z);
+			visit(p.x + 1, p.y, p.z);
+			visit(p.x, p.y - 1, p.z);
+			visit(p.x, p.y + 1, p.z);
+			visit(p.x, p.y, p.z - 1);
+			visit(p.x, p.y, p.z + 1);
+		}
+		return supported;
+	}
+} // namespace
+
+SPADES_BENCHMARK(FloatingBlocks, "Floating-block detection after destroying supporting blocks") {
+	int size = std::min(ctx.GetIntOption("size", 192), 500);
+	double timeBudget = ctx.GetIntOption("budgetUs", 2000) * 1.0e-6;
+	int numIterations = ctx.GetIntOption("iterations", 8);
+	std::vector<CellPos> pillarCut;
+
+	// A large overhang loses its only support, all at once
+	{
+		Handle<GameMap> map = CreateOverhangMap(size, pillarCut);
+		GameMapWrapper wrapper{*map};
+		wrapper.Rebuild();
+
+		Stopwatch sw;
+		std::vector<CellPos> floating = wrapper.RemoveBlocks(pillarCut);
+		ctx.Report("overhang.blocking", sw.GetTime() * 1000.0, "ms");
+		ctx.Report("overhang.floatingBlocks", (double)floating.size(), "");
+	}
+
+	// The same, but spread over frames with a time budget per frame
+	for (bool async : {false, true}) {
+		std::string prefix = async ? "overhang.async." : "overhang.sliced.";
+		Handle<GameMap> map = CreateOverhangMap(size, pillarCut);
+		GameMapWrapper wrapper{*map};
+		wrapper.Rebuild();
+
+		Stopwatch total;
+		Stopwatch sw;
+		double maxFrameTime = 0.0;
+		int numFrames = 1;
+		wrapper.BeginRemoveBlocks(pillarCut);
+		while (true) {
+			bool complete;
+			if (async) {
+				// Only the time the calling thread spends counts
+				complete = wrapper.ContinueRemoveBlocks(0.0);
+				if (!complete)
+					wrapper.ContinueRemoveBlocksAsync(timeBudget);
+			} else {
+				complete = wrapper.ContinueRemoveBlocks(timeBudget);
+			}
+			maxFrameTime = std::max(maxFrameTime, sw.GetTime());
+			if (complete)
+				break;
+
+			// Let the other thread run during the "frame"
+			Stopwatch frame;
+			while (async && frame.GetTime() < timeBudget)
+				;
+			sw.Reset();
+			numFrames++;
+		}
+		std::vector<CellPos> floating = wrapper.EndRemoveBlocks();
+
+		ctx.Report(prefix + "total", total.GetTime() * 1000.0, "ms");
+		ctx.Report(prefix + "frames", numFrames, "");
+		ctx.Report(prefix + "maxFrameTime", maxFrameTime * 1000.0, "ms");
+		ctx.Report(prefix + "floatingBlocks", (double)floating.size(), "");
+	}
+
+	// Compare the results with a brute-force flood fill after random destruction
+	for (const std::string& path : ctx.GetMapFiles()) {
+		std::string data = FileManager::ReadAllBytes(path.c_str());
+		MemoryStream stream{data.data(), data.size()};
+		Handle<GameMap> map{GameMap::Load(&stream), false};
+		GameMapWrapper wrapper{*map};
+		wrapper.Rebuild();
+
+		std::mt19937 rng{1};
+		int numMismatches = 0;
+		std::size_t numFloating = 0;
+		double time = 0.0;
+		std::vector<bool> supported = FindSupportedBlocks(*map);
+
+		for (int i = 0; i < numIterations; i++) {
+			// Cut out a random box of terrain (like a series of grenades would do) by removing
+			// its sides and bottom
+			std::vector<CellPos> cells;
+			int size = 4 + (int)(rng() % 28);
+			int x1 = (int)(rng() % (512 - size)), y1 = (int)(rng() % (512 - size));
+			int bottom = 40 + (int)(rng() % 20);
+			for (int x = x1; x < x1 + size; x++)
+				for (int y = y1; y < y1 + size; y++) {
+					bool side = x == x1 || y == y1 || x == x1 + size - 1 || y == y1 + size - 1;
+					for (int z = side ? 0 : bottom; z <= bottom; z++)
+						if (map->IsSolid(x, y, z))
+							cells.emplace_back(x, y, z);
+				}
+
+			Stopwatch sw;
+			std::vector<CellPos> floating = wrapper.RemoveBlocks(cells);
+			time += sw.GetTime();
+			numFloating += floating.size();
+
+			// Every reported block must have lost its support, and every block that lost
+			// its support must be reported
+			std::vector<bool> newSupported = FindSupportedBlocks(*map);
+			std::vector<bool> reported(supported.size());
+			auto index = [&](const CellPos& p) {
+				return ((std::size_t)p.x * map->Height() + p.y) * map->Depth() + p.z;
+			};
+			for (const CellPos& p : floating) {
+				reported[index(p)] = true;
+				if (newSupported[index(p)])
+					numMismatches++;
+			}
+			for (std::size_t j = 0; j < supported.size(); j++)
+				if (supported[j] && !newSupported[j] && !reported[j] && j % map->Depth() <
+				    (std::size_t)map->Depth() - 1) {
+					int x = (int)(j / map->Depth() / map->Height());
+					int y = (int)(j / map->Depth() % map->Height());
+					int z = (int)(j % map->Depth());
+					if (map->IsSolid(x, y, z))
+						numMismatches++;
+				}
+
+			for (const CellPos& p : floating)
+				map->Set(p.x, p.y, p.z, false, 0);
+			supported = std::move(newSupported);
+		}
+
+		ctx.Report(path + ".removeBlocks", time * 1000.0 / numIterations, "ms");
+		ctx.Report(path + ".floatingBlocks", (double)numFloating / numIterations, "");
+		ctx.Report(path + ".mismatches", numMismatches, "");
+	}
+}
@@ -0,0 +1,212 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <random>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/IGameMapListener.h>
+#include <Core/DynamicMemoryStream.h>
+#include <Core/FileManager.h>
+#include <Core/IStream.h>
+#include <Core/MemoryStream.h>
+#include <Core/Stopwatch.h>
+
+using namespace spades;
+using namespace spades::client;
+
+namespace {
+	const char* StorageModeName(GameMap::StorageMode mode) {
+		return mode == GameMap::StorageMode::Dense ? "dense" : "sparse";
+	}
+
+	std::string SnapshotOf(const GameMap& map) {
+		DynamicMemoryStream stream;
+		map.SaveSnapshot(&stream);
+		stream.SetPosition(0);
+		return stream.Read(static_cast<std::size_t>(stream.GetLength()));
+	}
+
+	/** Marks 16x16x16 chunks like `GLMapRenderer` and checks that every change is covered. */
+	class ChunkListener : public IGameMapListener {
+	public:
+		std::vector<bool> dirtyChunks = std::vector<bool>(32 * 32 * 4);
+		std::vector<IntVector3> expectedChanges;
+		int numCalls = 0;
+		int numUncovered = 0;
+
+		void GameMapChanged(int x, int y, int z, GameMap*) override {
+			numCalls++;
+			Mark(IntAABB3{IntVector3(x, y, z), IntVector3(x + 1, y + 1, z + 1)});
+		}
+
+		void GameMapChangedRegion(const IntAABB3& region, GameMap*) override {
+			numCalls++;
+			Mark(region);
+		}
+
+		/** Returns the number of expected changes not reported, and clears them. */
+		int TakeUncovered() {
+			int count = numUncovered;
+			for (const IntVector3& v : expectedChanges)
+				if (!dirtyChunks[ChunkIndex(v.x, v.y, v.z)])
+					count++;
+			expectedChanges.clear();
+			std::fill(dirtyChunks.begin(), dirtyChunks.end(), false);
+			numUncovered = 0;
+			return count;
+		}
+
+	private:
+		static int ChunkIndex(int x, int y, int z) {
+			return ((x >> 4) & 31) + (((y >> 4) & 31) << 5) + (((z >> 4) & 3) << 10);
+		}
+
+		void Mark(const IntAABB3& region) {
+			for (int cx = region.min.x >> 4; cx <= (region.max.x - 1) >> 4; cx++)
+				for (int cy = region.min.y >> 4; cy <= (region.max.y - 1) >> 4; cy++)
+					for (int cz = region.min.z >> 4; cz <= (region.max.z - 1) >> 4; cz++)
+						dirtyChunks[ChunkIndex(cx << 4, cy << 4, cz << 4)] = true;
+		}
+	};
+} // namespace
+
+SPADES_BENCHMARK(GameMapStorage, "Memory and latency of the dense and sparse GameMap storage") {
+	int numLookups = ctx.GetIntOption("lookups", 4000000);
+
+	for (const std::string& path : ctx.GetMapFiles()) {
+		std::string data = FileManager::ReadAllBytes(path.c_str());
+
+		for (auto mode : {GameMap::StorageMode::Dense, GameMap::StorageMode::Sparse}) {
+			std::string prefix = path + "/" + StorageModeName(mode) + ".";
+
+			MemoryStream stream{data.data(), data.size()};
+			Stopwatch sw;
+			Handle<GameMap> map{GameMap::Load(&stream, {}, mode), false};
+			ctx.Report(prefix + "load", sw.GetTime() * 1000.0, "ms");
+			ctx.Report(prefix + "memory", (double)map->GetMemoryUsage() / 1048576.0, "MiB");
+
+			sw.Reset();
+			DynamicMemoryStream snapshot;
+			map->Save(&snapshot);
+			ctx.Report(prefix + "save", sw.GetTime() * 1000.0, "ms");
+
+			sw.Reset();
+			Handle<GameMap> copy = map->Clone();
+			ctx.Report(prefix + "clone", sw.GetTime() * 1000.0, "ms");
+			ctx.Report(prefix + "cloneMemory", (double)copy->GetMemoryUsage() / 1048576.0, "MiB");
+			if (SnapshotOf(*copy) != SnapshotOf(*map))
+				SPRaise("The copy of %s differs from the original", path.c_str());
+			copy = Handle<GameMap>();
+
+			// Random lookups of surface voxels, like renderers do
+			std::mt19937 rng{1};
+			std::uniform_int_distribution<int> coord{0, GameMap::DefaultWidth - 1};
+			uint32_t sum = 0;
+			sw.Reset();
+			for (int i = 0; i < numLookups; ++i) {
+				int x = coord(rng), y = coord(rng);
+				uint64_t solid = map->GetSolidMap(x, y);
+				int z = 0;
+				while (z < GameMap::DefaultDepth - 1 && !((solid >> z) & 1))
+					++z;
+				sum += map->GetColor(x, y, z);
+			}
+			ctx.Report(prefix + "getColor", sw.GetTime() * 1.0e9 / numLookups, "ns");
+
+			// Block placement and destruction
+			sw.Reset();
+			for (int i = 0; i < numLookups / 16; ++i) {
+				int x = coord(rng), y = coord(rng);
+				int z = (int)(rng() % (GameMap::DefaultDepth - 2));
+				map->Set(x, y, z, (i & 1) != 0, 0x64000000 | (uint32_t)(rng() & 0xffffff), true);
+			}
+			ctx.Report(prefix + "set", sw.GetTime() * 1.0e9 / (numLookups / 16), "ns");
+
+			// The edits leave unused space in the sparse storage, which the copy drops
+			if (SnapshotOf(*map->Clone()) != SnapshotOf(*map))
+				SPRaise("The copy of the edited %s differs from the original", path.c_str());
+
+			if (sum == 0x12345678)
+				ctx.Report(prefix + "checksum", sum, "");
+		}
+	}
+}
+
+SPADES_BENCHMARK(GameMapBatch, "Listener notification per voxel vs GameMap::BeginBatch") {
+	int numActions = ctx.GetIntOption("actions", 20000);
+
+	// Grenade explosions (3x3x3 voxels) and block lines (up to 50 voxels)
+	std::mt19937 rng{1};
+	std::vector<std::vector<IntVector3>> actions;
+	for (int i = 0; i < numActions; ++i) {
+		std::vector<IntVector3> cells;
+		IntVector3 origin(1 + (int)(rng() % 509), 1 + (int)(rng() % 509), 1 + (int)(rng() % 60));
+		if (i & 1) {
+			for (int dx = -1; dx <= 1; ++dx)
+				for (int dy = -1; dy <= 1; ++dy)
+					for (int dz = -1; dz <= 1; ++dz)
+						cells.push_back(origin + IntVector3(dx, dy, dz));
+		} else {
+			int length = 1 + (int)(rng() % 50);
+			int axis = (int)(rng() % 2);
+			for (int j = 0; j < length; ++j) {
+				IntVector3 v = origin;
+				if (axis)
+					v.x = std::min(v.x + j, 511);
+				else
+					v.y = std::min(v.y + j, 511);
+				cells.push_back(v);
+			}
+		}
+		actions.push_back(std::move(cells));
+	}
+
+	for (bool batched : {false, true}) {
+		std::string prefix = batched ? "batched." : "perVoxel.";
+		Handle<GameMap> map{new GameMap(), false};
+		ChunkListener listener;
+		map->AddListener(&listener);
+		int numUncovered = 0;
+		int numChanges = 0;
+
+		Stopwatch sw;
+		for (std::size_t i = 0; i < actions.size(); ++i) {
+			bool solid = (i / 2) % 2 == 0;
+			if (batched)
+				map->BeginBatch();
+			for (const IntVector3& v : actions[i]) {
+				if (map->IsSolid(v.x, v.y, v.z) != solid) {
+					listener.expectedChanges.push_back(v);
+					numChanges++;
+				}
+				map->Set(v.x, v.y, v.z, solid, 0x64808080);
+			}
+			if (batched)
+				map->EndBatch();
+			numUncovered += listener.TakeUncovered();
+		}
+		ctx.Report(prefix + "time", sw.GetTime() * 1.0e9 / numChanges, "ns/voxel");
+		ctx.Report(prefix + "calls", (double)listener.numCalls / actions.size(), "calls/action");
+		ctx.Report(prefix + "uncovered", numUncovered, "");
+
+		map->RemoveListener(&listener);
+	}
+}
@@ -0,0 +1,389 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "InputTrace.h"
+#include <Client/GameMap.h>
+#include <Client/GameProperties.h>
+#include <Client/Grenade.h>
+#include <Client/IImage.h>
+#include <Client/IWorldListener.h>
+#include <Client/ParticleSystem.h>
+#include <Client/Player.h>
+#include <Client/Weapon.h>
+#include <Client/World.h>
+#include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/MemoryStream.h>
+
+using namespace spades;
+using namespace spades::client;
+using namespace spades::bench;
+
+namespace {
+	class NullImage : public IImage {
+	public:
+		void Update(Bitmap&, int, int) override {}
+		float GetWidth() override { return 1.0F; }
+		float GetHeight() override { return 1.0F; }
+	};
+
+	/**
+	 * Stands in for `Client`. Emits the particles `Client_LocalEnts.cpp` emits for the world
+	 * events (with `cg_particles` = 2) and counts the events.
+	 */
+	class SimulationListener : public IWorldListener {
+	public:
+		ParticleSystem particles;
+		bench::SectionProfile emitProfile;
+		/** The viewpoint used for the distance culling. */
+		Vector3 viewOrigin = MakeVector3(0.0F, 0.0F, 0.0F);
+
+		struct ThrownGrenade {
+			Vector3 position, velocity;
+			float fuse;
+		};
+		/** Grenade packets to be sent by the server. */
+		std::vector<ThrownGrenade> thrownGrenades;
+
+		int numShots = 0, numBlockHits = 0, numPlayerHits = 0, numSpadeHits = 0;
+		int numExplosions = 0, numFallenBlocks = 0;
+
+		SimulationListener(GameMap& map) : map(map), image(new NullImage(), false) {}
+
+		void PlayerObjectSet(int) override {}
+		void PlayerMadeFootstep(Player&) override {}
+		void PlayerJumped(Player&) override {}
+		void PlayerLanded(Player&, bool) override {}
+		void PlayerFiredWeapon(Player& p) override {
+			numShots++;
+			emitProfile.Begin();
+			MuzzleFire(p.GetEye() + p.GetFront() * 0.8F);
+			emitProfile.End();
+		}
+		void PlayerEjectedBrass(Player&) override {}
+		void PlayerDryFiredWeapon(Player&) override {}
+		void PlayerReloadingWeapon(Player&) override {}
+		void PlayerReloadedWeapon(Player&) override {}
+		void PlayerChangedTool(Player&) override {}
+		void PlayerPulledGrenadePin(Player&) override {}
+		void PlayerThrewGrenade(Player& p, stmp::optional<const Grenade&> g) override {
+			if (g)
+				return;
+			// Remote players' grenades come from the server, which is us
+			Vector3 dir = p.GetFront();
+			thrownGrenades.push_back(
+			  {p.GetEye() + dir * 0.1F, dir + p.GetVelocity(), 3.0F - p.GetGrenadeCookTime()});
+		}
+		void PlayerMissedSpade(Player&) override {}
+		void PlayerHitBlockWithSpade(Player&, Vector3, IntVector3 blockPos,
+		                             IntVector3 normal) override {
+			numSpadeHits++;
+			emitProfile.Begin();
+			EmitBlockFragments(MakeVector3(blockPos) + 0.5F + MakeVector3(normal) * 0.6F,
+			                   GetBlockColor(blockPos));
+			emitProfile.End();
+		}
+		void PlayerKilledPlayer(Player&, Player&, KillType) override {}
+		void PlayerRestocked(Player&) override {}
+		void BulletHitPlayer(Player&, HitType, Vector3 hitPos, Player&,
+		                     std::unique_ptr<IBulletHitScanState>&) override {
+			numPlayerHits++;
+			emitProfile.Begin();
+			Bleed(hitPos);
+			emitProfile.End();
+		}
+		void BulletNearPlayer(Player&) override {}
+		void BulletHitBlock(Vector3 hitPos, IntVector3 blockPos, IntVector3 normal) override {
+			numBlockHits++;
+			emitProfile.Begin();
+			EmitBlockFragments(hitPos + MakeVector3(normal) * 0.1F, GetBlockColor(blockPos));
+			emitProfile.End();
+		}
+		void AddBulletTracer(Player&, Vector3, Vector3) override {}
+		void GrenadeExploded(const Grenade& g) override {
+			numExplosions++;
+			emitProfile.Begin();
+			GrenadeExplosion(g.GetPosition());
+			emitProfile.End();
+		}
+		void GrenadeBounced(const Grenade&) override {}
+		void GrenadeDroppedIntoWater(const Grenade&) override {}
+		void BlocksFell(std::vector<IntVector3> blocks) override {
+			numFallenBlocks += (int)blocks.size();
+			emitProfile.Begin();
+			for (const IntVector3& pos : blocks)
+				EmitBlockDestroyFragments(pos);
+			emitProfile.End();
+		}
+		void LocalPlayerBlockAction(IntVector3, BlockActionType) override {}
+		void LocalPlayerCreatedLineBlock(IntVector3, IntVector3) override {}
+		void LocalPlayerHurt(HurtType, Vector3) override {}
+		void LocalPlayerBuildError(BuildFailureReason) override {}
+
+	private:
+		GameMap& map;
+		Handle<IImage> image;
+		std::mt19937 rng{1};
+		std::uniform_real_distribution<float> uniform{0.0F, 1.0F};
+
+		IntVector3 GetBlockColor(IntVector3 pos) {
+			return IntVectorFromColor(map.GetColor(pos.x, pos.y, pos.z));
+		}
+
+		Vector3 RandomAxis() {
+			Vector3 v;
+			do {
+				v = MakeVector3(uniform(rng), uniform(rng), uniform(rng)) * 2.0F - 1.0F;
+			} while (v.GetSquaredLength() > 1.0F || v.GetSquaredLength() < 0.01F);
+			return v.Normalize();
+		}
+
+		/** Returns the squared 2D distance from the viewpoint, or a negative value if culled. */
+		float CullDistance(const Vector3& pos) {
+			float distSqr = (pos - viewOrigin).GetSquaredLength2D();
+			return distSqr > FOG_DISTANCE_SQ ? -1.0F : distSqr;
+		}
+
+		void AddSmokes(int count, Vector3 pos, Vector4 color, float speed, float lifetime) {
+			for (int i = 0; i < count; i++) {
+				SmokeSprite particle{color, 100.0F, SmokeSprite::Type::Explosion};
+				particle.SetTrajectory(pos, RandomAxis() * speed, 1.0F, 0.0F);
+				particle.SetRotation(uniform(rng) * M_PI_F * 2.0F);
+				particle.SetRadius(0.5F + uniform(rng) * 0.2F, 2.0F);
+				particle.SetLifeTime(lifetime + uniform(rng) * lifetime, 0.06F, lifetime);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles.AddSmoke(particle);
+			}
+		}
+
+		void AddFragments(int count, Vector3 pos, Vector4 color, float speed, float distSqr) {
+			for (int i = 0; i < count; i++) {
+				ParticleSprite particle{*image, color};
+				particle.SetTrajectory(pos, RandomAxis() * speed);
+				particle.SetRadius(0.2F + uniform(rng) * uniform(rng) * 0.25F);
+				particle.SetLifeTime(3.0F, 0.0F, 1.0F);
+				if (distSqr < 16.0F * 16.0F)
+					particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+				particles.AddSprite(particle);
+			}
+		}
+
+		void EmitBlockFragments(Vector3 pos, IntVector3 col) {
+			float distSqr = CullDistance(pos);
+			if (distSqr < 0.0F)
+				return;
+			Vector4 color = MakeVector4(col.x / 255.0F, col.y / 255.0F, col.z / 255.0F, 1.0F);
+			AddFragments(4, pos, color, 8.0F, distSqr);
+			if (distSqr < 32.0F * 32.0F)
+				AddFragments(8, pos, color, 12.0F, distSqr);
+			AddSmokes(2, pos, color * 0.2F, 0.7F, 0.3F);
+		}
+
+		void EmitBlockDestroyFragments(IntVector3 pos) {
+			Vector3 origin = MakeVector3(pos) + 0.5F;
+			float distSqr = CullDistance(origin);
+			if (distSqr < 0.0F)
+				return;
+			IntVector3 col = GetBlockColor(pos);
+			AddFragments(4, origin,
+			             MakeVector4(col.x / 255.0F, col.y / 255.0F, col.z / 255.0F, 1.0F), 8.0F,
+			             distSqr);
+		}
+
+		void Bleed(Vector3 pos) {
+			float distSqr = CullDistance(pos);
+			if (distSqr < 0.0F)
+				return;
+			AddFragments(4, pos, MakeVector4(0.5F, 0.0F, 0.0F, 1.0F), 8.0F, distSqr);
+			AddSmokes(3, pos, MakeVector4(0.7F, 0.35F, 0.37F, 0.6F), 0.7F, 0.2F);
+		}
+
+		void MuzzleFire(Vector3 pos) {
+			if (CullDistance(pos) < 0.0F)
+				return;
+			AddSmokes(2, pos, MakeVector4(0.8F, 0.8F, 0.8F, 0.3F), 0.3F, 0.2F);
+			AddSmokes(4, pos, MakeVector4(1.0F, 0.6F, 0.4F, 0.2F) * 5.0F, 0.3F, 0.01F);
+		}
+
+		void GrenadeExplosion(Vector3 pos) {
+			float distSqr = CullDistance(pos);
+			if (distSqr < 0.0F)
+				return;
+			AddSmokes(16, pos, MakeVector4(0.6F, 0.6F, 0.6F, 1.0F), 2.0F, 1.0F);
+			AddSmokes(8, pos, MakeVector4(0.6F, 0.6F, 0.6F, 0.4F), 8.0F, 0.5F);
+			AddFragments(42, pos, MakeVector4(0.3F, 0.3F, 0.3F, 1.0F), 20.0F, distSqr);
+		}
+	};
+
+	struct Configuration {
+		const char* name;
+		bool weapons;
+		bool edits;
+	};
+
+	void Simulate(bench::BenchmarkContext& ctx, const std::string& mapData,
+	              const InputTrace& trace, const Configuration& config) {
+		MemoryStream stream{mapData.data(), mapData.size()};
+		Handle<GameMap> map{GameMap::Load(&stream), false};
+		IntVector3 center = MakeIntVector3(map->Width() / 2, map->Height() / 2, 0);
+
+		auto properties = std::make_shared<GameProperties>(ProtocolVersion::v075);
+		World world{properties};
+		world.SetMap(map);
+
+		SimulationListener listener{*map};
+		world.SetListener(&listener);
+
+		const WeaponType weapons[] = {RIFLE_WEAPON, SMG_WEAPON, SHOTGUN_WEAPON};
+		for (int i = 0; i < trace.numPlayers; i++) {
+			world.SetPlayer(i, stmp::make_unique<Player>(world, i, weapons[i % 3], i & 1,
+			                                              GetSpawnPosition(*map, center, i),
+			                                              MakeIntVector3(128, 128, 128)));
+		}
+
+		bench::SectionProfile inputProfile, editProfile, worldProfile, particleProfile;
+		BlockEditResolver editResolver;
+		std::vector<BlockChange> blockChanges;
+		std::size_t nextEdit = 0;
+
+		for (int tick = 0; tick < trace.numTicks; tick++) {
+			inputProfile.Begin();
+			for (int i = 0; i < trace.numPlayers; i++) {
+				Player& player = world.GetPlayer(i).value();
+				const PlayerFrame& frame = trace.GetFrame(tick, i);
+
+				player.SetInput(frame.GetInput());
+				player.SetWeaponInput(config.weapons ? frame.GetWeaponInput() : WeaponInput());
+
+				auto tool = static_cast<Player::ToolType>(frame.tool);
+				if (player.GetTool() != tool)
+					player.SetTool(tool);
+				player.SetOrientation(frame.GetOrientation());
+
+				// What the server would do
+				Weapon& weapon = player.GetWeapon();
+				if (weapon.GetAmmo() == 0 && !weapon.IsReloading())
+					player.Reload();
+				if (tick % 600 == 0)
+					player.Refill();
+				Vector3 pos = player.GetPosition();
+				if (pos.z > 61.0F || std::fabs(pos.x - (float)center.x) > 96.0F ||
+				    std::fabs(pos.y - (float)center.y) > 96.0F)
+					player.RepositionPlayer(GetSpawnPosition(*map, center, i + tick));
+			}
+			listener.viewOrigin = world.GetPlayer(0)->GetEye();
+			inputProfile.End();
+
+			// Block actions and grenades received from the server
+			editProfile.Begin();
+			for (; nextEdit < trace.edits.size() && trace.edits[nextEdit].tick <= (unsigned)tick;
+			     nextEdit++) {
+				if (!config.edits)
+					continue;
+				blockChanges.clear();
+				editResolver.Resolve(trace.edits[nextEdit], *map, blockChanges);
+				for (const BlockChange& change : blockChanges) {
+					if (change.create) {
+						world.CreateBlock(change.position, change.color);
+					} else {
+						std::vector<IntVector3> cells{change.position};
+						world.DestroyBlock(cells);
+					}
+				}
+			}
+			for (const SimulationListener::ThrownGrenade& g : listener.thrownGrenades) {
+				world.AddGrenade(
+				  stmp::make_unique<Grenade>(world, g.position, g.velocity, g.fuse));
+			}
+			listener.thrownGrenades.clear();
+			editProfile.End();
+
+			worldProfile.Begin();
+			world.Advance(TickDuration);
+			worldProfile.End();
+
+			particleProfile.Begin();
+			listener.particles.Update(TickDuration, map.GetPointerOrNull());
+			particleProfile.End();
+		}
+
+		std::string prefix = config.name;
+		double numTicks = trace.numTicks;
+		ctx.ReportSection(prefix + ".input", inputProfile, numTicks, "tick");
+		if (config.edits)
+			ctx.ReportSection(prefix + ".blockEdits", editProfile, numTicks, "tick");
+		ctx.ReportSection(prefix + ".world", worldProfile, numTicks, "tick");
+		if (config.weapons) {
+			// Included in `world`
+			ctx.ReportSection(prefix + ".effects", listener.emitProfile, numTicks, "tick");
+		}
+		ctx.ReportSection(prefix + ".particles", particleProfile, numTicks, "tick");
+
+		if (config.weapons) {
+			ctx.Report(prefix + ".shots", listener.numShots, "events");
+			ctx.Report(prefix + ".blockHits", listener.numBlockHits + listener.numSpadeHits,
+			           "events");
+			ctx.Report(prefix + ".playerHits", listener.numPlayerHits, "events");
+			ctx.Report(prefix + ".explosions", listener.numExplosions, "events");
+		}
+		if (config.edits)
+			ctx.Report(prefix + ".fallenBlocks", listener.numFallenBlocks, "blocks");
+		ctx.Report(prefix + ".sprites", (double)listener.particles.GetNumSprites(), "particles");
+
+		// Let the background search of floating blocks finish before the map goes away
+		world.SetListener(nullptr);
+	}
+} // namespace
+
+SPADES_BENCHMARK(GameSimulation, "Replaying 32 scripted players and block edits in a World") {
+	std::vector<std::string> maps = ctx.GetMapFiles();
+	std::string mapPath = ctx.GetOption("map", maps.empty() ? std::string() : maps.front());
+	if (mapPath.empty())
+		SPRaise("No map found");
+	std::string mapData = FileManager::ReadAllBytes(mapPath.c_str());
+
+	InputTrace trace;
+	std::string tracePath = ctx.GetOption("trace", "");
+	if (!tracePath.empty()) {
+		trace = InputTrace::Load(tracePath);
+	} else {
+		// The maps are 512x512 and the fight happens around the middle
+		trace = InputTrace::Generate(ctx.GetIntOption("players", 32),
+		                             ctx.GetIntOption("ticks", 1800),
+		                             ctx.GetIntOption("edits", 30), MakeIntVector3(256, 256, 0),
+		                             (unsigned)ctx.GetIntOption("seed", 1));
+	}
+	std::string savePath = ctx.GetOption("save-trace", "");
+	if (!savePath.empty())
+		trace.Save(savePath);
+
+	// Enable the subsystems one by one; the differences show their costs
+	const Configuration configs[] = {
+	  {"movement", false, false}, {"combat", true, false}, {"full", true, true}};
+	for (const Configuration& config : configs)
+		Simulate(ctx, mapData, trace, config);
+}
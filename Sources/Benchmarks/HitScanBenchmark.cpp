@@ -0,0 +1,171 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/GameProperties.h>
+#include <Client/HitScanIndex.h>
+#include <Client/Player.h>
+#include <Client/World.h>
+#include <Core/Stopwatch.h>
+
+using namespace spades;
+using namespace spades::client;
+
+namespace {
+	/** The player part of `World::WeaponRayCast`, fed one player at a time. */
+	class PlayerRayCast {
+	public:
+		PlayerRayCast(World& world, Vector3 start, Vector3 dir)
+		    : world(world), start(start), dir(dir) {}
+
+		void operator()(int i) {
+			auto p = world.GetPlayer(static_cast<unsigned int>(i));
+			if (!p || !p->IsAlive() || p->IsSpectator())
+				return;
+			if (!p->RayCastApprox(start, dir))
+				return;
+
+			Player::HitBoxes hb = p->GetHitBoxes(true);
+			Test(i, hb.head);
+			Test(i, hb.torso);
+			for (OBB3& limb : hb.limbs)
+				Test(i, limb);
+		}
+
+		/** Returns the ID of the hit player, or -1. */
+		int GetHitPlayerId() const { return hitPlayerId; }
+
+	private:
+		World& world;
+		Vector3 start, dir;
+		int hitPlayerId = -1;
+		float hitPlayerDist = 0.0F;
+
+		void Test(int i, OBB3& box) {
+			Vector3 hitPos;
+			if (box.RayCast(start, dir, &hitPos)) {
+				float dist = (hitPos - start).GetSquaredLength();
+				if (hitPlayerId < 0 || dist < hitPlayerDist) {
+					hitPlayerId = i;
+					hitPlayerDist = dist;
+				}
+			}
+		}
+	};
+} // namespace
+
+SPADES_BENCHMARK(HitScan, "Weapon ray casts against 64 players, brute force vs HitScanIndex") {
+	int numPlayers = ctx.GetIntOption("players", 64);
+	int numTicks = ctx.GetIntOption("ticks", 2000);
+	// A shotgun blast from every tenth player each tick
+	int raysPerTick = ctx.GetIntOption("rays", 8 * 6);
+
+	auto properties = std::make_shared<GameProperties>(ProtocolVersion::v075);
+	World world{properties};
+	world.SetMap(Handle<GameMap>{new GameMap(), false});
+
+	std::mt19937 rng{42};
+	std::uniform_real_distribution<float> uniform{0.0F, 1.0F};
+	auto randomPosition = [&] {
+		// Two teams around the middle of the map
+		return MakeVector3(128.0F + uniform(rng) * 256.0F, 128.0F + uniform(rng) * 256.0F,
+		                   30.0F + uniform(rng) * 20.0F);
+	};
+
+	for (int i = 0; i < numPlayers; i++) {
+		world.SetPlayer(i, stmp::make_unique<Player>(world, i, RIFLE_WEAPON, i & 1,
+		                                              randomPosition(), IntVector3()));
+	}
+
+	struct Ray {
+		Vector3 start, dir;
+	};
+	std::vector<Ray> rays(raysPerTick);
+
+	double bruteForceTime = 0.0, indexTime = 0.0, buildTime = 0.0;
+	long numHits = 0, numMismatches = 0;
+	Stopwatch sw;
+
+	for (int tick = 0; tick < numTicks; tick++) {
+		for (int i = 0; i < numPlayers; i++) {
+			Player& p = world.GetPlayer(i).value();
+			Vector3 pos = p.GetPosition();
+			pos.x += (uniform(rng) - 0.5F) * 0.4F;
+			pos.y += (uniform(rng) - 0.5F) * 0.4F;
+			p.SetPosition(pos);
+			p.SetOrientation(MakeVector3(uniform(rng) - 0.5F, uniform(rng) - 0.5F, 0.0F)
+			                   .Normalize());
+		}
+
+		// Shoot at random players with some spread
+		for (Ray& ray : rays) {
+			Player& shooter = world.GetPlayer(rng() % numPlayers).value();
+			Player& target = world.GetPlayer(rng() % numPlayers).value();
+			ray.start = shooter.GetEye();
+			Vector3 aim = target.GetEye() - ray.start;
+			aim.x += (uniform(rng) - 0.5F) * 4.0F;
+			aim.y += (uniform(rng) - 0.5F) * 4.0F;
+			aim.z += (uniform(rng) - 0.5F) * 4.0F;
+			ray.dir = aim.GetLength() > 0.01F ? aim.Normalize() : MakeVector3(1, 0, 0);
+		}
+
+		sw.Reset();
+		const HitScanIndex& index = world.GetHitScanIndex();
+		buildTime += sw.GetTime();
+
+		std::vector<int> expected;
+		sw.Reset();
+		for (const Ray& ray : rays) {
+			PlayerRayCast cast{world, ray.start, ray.dir};
+			for (int i = 0; i < static_cast<int>(world.GetNumPlayerSlots()); i++)
+				cast(i);
+			expected.push_back(cast.GetHitPlayerId());
+		}
+		bruteForceTime += sw.GetTime();
+
+		sw.Reset();
+		for (std::size_t k = 0; k < rays.size(); k++) {
+			const Ray& ray = rays[k];
+			HitScanIndex::PlayerSet candidates;
+			index.QueryRay(ray.start, ray.dir, candidates);
+			PlayerRayCast cast{world, ray.start, ray.dir};
+			candidates.ForEach([&](int i) { cast(i); });
+			int hit = cast.GetHitPlayerId();
+			if (hit >= 0)
+				numHits++;
+			if (hit != expected[k])
+				numMismatches++;
+		}
+		indexTime += sw.GetTime();
+	}
+
+	double numRays = static_cast<double>(numTicks) * raysPerTick;
+	ctx.Report("bruteForce.perRay", bruteForceTime / numRays * 1.0e9, "ns");
+	ctx.Report("index.perRay", indexTime / numRays * 1.0e9, "ns");
+	ctx.Report("index.buildPerTick", buildTime / numTicks * 1.0e6, "us");
+	ctx.Report("speedup", bruteForceTime / (indexTime + buildTime), "x");
+	ctx.Report("hitRate", numHits / numRays * 100.0, "%");
+	ctx.Report("mismatches", static_cast<double>(numMismatches), "rays");
+}
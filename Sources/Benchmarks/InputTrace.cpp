@@ -0,0 +1,320 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "InputTrace.h"
+#include <Client/GameMap.h>
+#include <Client/World.h>
+#include <Core/Exception.h>
+
+namespace spades {
+	namespace bench {
+		client::PlayerInput PlayerFrame::GetInput() const {
+			client::PlayerInput input;
+			input.moveForward = (keys & Forward) != 0;
+			input.moveBackward = (keys & Backward) != 0;
+			input.moveLeft = (keys & Left) != 0;
+			input.moveRight = (keys & Right) != 0;
+			input.jump = (keys & Jump) != 0;
+			input.crouch = (keys & Crouch) != 0;
+			input.sprint = (keys & Sprint) != 0;
+			return input;
+		}
+
+		client::WeaponInput PlayerFrame::GetWeaponInput() const {
+			client::WeaponInput input;
+			input.primary = (buttons & Primary) != 0;
+			input.secondary = (buttons & Secondary) != 0;
+			return input;
+		}
+
+		Vector3 PlayerFrame::GetOrientation() const {
+			float cp = std::cos(pitch);
+			return MakeVector3(std::cos(yaw) * cp, std::sin(yaw) * cp, std::sin(pitch));
+		}
+
+		InputTrace InputTrace::Generate(int numPlayers, int numTicks, int numEditsPerSecond,
+		                                IntVector3 center, unsigned seed) {
+			std::mt19937 rng{seed};
+			std::uniform_real_distribution<float> uniform{0.0F, 1.0F};
+
+			InputTrace trace;
+			trace.numPlayers = numPlayers;
+			trace.numTicks = numTicks;
+			trace.frames.resize((std::size_t)numPlayers * numTicks);
+
+			struct State {
+				PlayerFrame frame;
+				float yawVelocity;
+				int nextChange = 0;
+				/** The remaining ticks of the current burst of fire (or grenade cooking). */
+				int fireTicks = 0;
+			};
+			std::vector<State> states(numPlayers);
+			for (State& state : states) {
+				state.frame = PlayerFrame{};
+				state.frame.yaw = uniform(rng) * 2.0F * M_PI_F;
+			}
+
+			for (int tick = 0; tick < numTicks; tick++) {
+				for (int i = 0; i < numPlayers; i++) {
+					State& state = states[i];
+					PlayerFrame& frame = state.frame;
+
+					if (tick >= state.nextChange) {
+						state.nextChange = tick + 20 + (int)(rng() % 100);
+						frame.keys = 0;
+						if (uniform(rng) < 0.6F)
+							frame.keys |= PlayerFrame::Forward;
+						else if (uniform(rng) < 0.25F)
+							frame.keys |= PlayerFrame::Backward;
+						if (uniform(rng) < 0.25F)
+							frame.keys |= PlayerFrame::Left;
+						else if (uniform(rng) < 0.33F)
+							frame.keys |= PlayerFrame::Right;
+						if (uniform(rng) < 0.2F)
+							frame.keys |= PlayerFrame::Sprint;
+						else if (uniform(rng) < 0.05F)
+							frame.keys |= PlayerFrame::Crouch;
+						state.yawVelocity = (uniform(rng) - 0.5F) * 0.06F;
+
+						int tool = (int)(rng() % 20);
+						frame.tool = tool < 14   ? client::Player::ToolWeapon
+						             : tool < 17 ? client::Player::ToolSpade
+						             : tool < 19 ? client::Player::ToolGrenade
+						                         : client::Player::ToolBlock;
+						state.fireTicks = 0;
+					}
+
+					frame.keys &= ~PlayerFrame::Jump;
+					if (uniform(rng) < 0.01F)
+						frame.keys |= PlayerFrame::Jump;
+
+					frame.yaw += state.yawVelocity;
+					float pitch = frame.pitch + (uniform(rng) - 0.5F) * 0.05F;
+					frame.pitch = std::max(std::min(pitch, 0.5F), -0.5F);
+
+					frame.buttons = 0;
+					if (state.fireTicks > 0) {
+						state.fireTicks--;
+						frame.buttons = PlayerFrame::Primary;
+					} else if (uniform(rng) < 0.03F) {
+						state.fireTicks = 10 + (int)(rng() % 60);
+					}
+					if (frame.tool == client::Player::ToolSpade && uniform(rng) < 0.3F)
+						frame.buttons = PlayerFrame::Secondary;
+
+					trace.frames[(std::size_t)tick * numPlayers + i] = frame;
+				}
+
+				// Block edits near the fight
+				float numEdits = (float)numEditsPerSecond * TickDuration;
+				while (numEdits > 0.0F) {
+					if (uniform(rng) < numEdits) {
+						BlockEdit edit;
+						edit.tick = (std::uint32_t)tick;
+						int type = (int)(rng() % 20);
+						edit.type = type < 9    ? BlockEdit::Type::Dig
+						            : type < 17 ? BlockEdit::Type::Build
+						            : type < 19 ? BlockEdit::Type::Tower
+						                        : BlockEdit::Type::Cut;
+						edit.x = (std::uint16_t)(center.x + (int)(rng() % 97) - 48);
+						edit.y = (std::uint16_t)(center.y + (int)(rng() % 97) - 48);
+						trace.edits.push_back(edit);
+					}
+					numEdits -= 1.0F;
+				}
+			}
+
+			return trace;
+		}
+
+		namespace {
+			const char TraceMagic[8] = {'S', 'P', 'T', 'R', 'A', 'C', 'E', '1'};
+
+			void WriteUInt32(std::string& out, std::uint32_t value) {
+				for (int i = 0; i < 4; i++)
+					out.push_back((char)(value >> (i * 8)));
+			}
+
+			void WriteFloat(std::string& out, float value) {
+				std::uint32_t bits;
+				std::memcpy(&bits, &value, 4);
+				WriteUInt32(out, bits);
+			}
+
+			class TraceReader {
+				const std::string& data;
+				std::size_t pos = 0;
+
+			public:
+				TraceReader(const std::string& data) : data(data) {}
+
+				std::uint8_t ReadUInt8() {
+					if (pos >= data.size())
+						SPRaise("Unexpected end of the trace file");
+					return (std::uint8_t)data[pos++];
+				}
+				std::uint16_t ReadUInt16() {
+					std::uint16_t value = ReadUInt8();
+					return (std::uint16_t)(value | (ReadUInt8() << 8));
+				}
+				std::uint32_t ReadUInt32() {
+					std::uint32_t value = 0;
+					for (int i = 0; i < 4; i++)
+						value |= (std::uint32_t)ReadUInt8() << (i * 8);
+					return value;
+				}
+				float ReadFloat() {
+					std::uint32_t bits = ReadUInt32();
+					float value;
+					std::memcpy(&value, &bits, 4);
+					return value;
+				}
+			};
+		} // namespace
+
+		void InputTrace::Save(const std::string& path) const {
+			std::string out{TraceMagic, sizeof(TraceMagic)};
+			WriteUInt32(out, (std::uint32_t)numPlayers);
+			WriteUInt32(out, (std::uint32_t)numTicks);
+			WriteUInt32(out, (std::uint32_t)edits.size());
+			for (const PlayerFrame& frame : frames) {
+				out.push_back((char)frame.keys);
+				out.push_back((char)frame.buttons);
+				out.push_back((char)frame.tool);
+				WriteFloat(out, frame.yaw);
+				WriteFloat(out, frame.pitch);
+			}
+			for (const BlockEdit& edit : edits) {
+				WriteUInt32(out, edit.tick);
+				out.push_back((char)edit.type);
+				out.push_back((char)(edit.x & 0xff));
+				out.push_back((char)(edit.x >> 8));
+				out.push_back((char)(edit.y & 0xff));
+				out.push_back((char)(edit.y >> 8));
+			}
+
+			FILE* f = std::fopen(path.c_str(), "wb");
+			if (!f)
+				SPRaise("Failed to open '%s' for writing", path.c_str());
+			std::fwrite(out.data(), 1, out.size(), f);
+			std::fclose(f);
+		}
+
+		InputTrace InputTrace::Load(const std::string& path) {
+			FILE* f = std::fopen(path.c_str(), "rb");
+			if (!f)
+				SPRaise("Failed to open '%s'", path.c_str());
+			std::string data;
+			char buffer[4096];
+			std::size_t count;
+			while ((count = std::fread(buffer, 1, sizeof(buffer), f)) > 0)
+				data.append(buffer, count);
+			std::fclose(f);
+
+			if (data.size() < sizeof(TraceMagic) ||
+			    std::memcmp(data.data(), TraceMagic, sizeof(TraceMagic)) != 0)
+				SPRaise("'%s' is not a trace file", path.c_str());
+
+			TraceReader reader{data};
+			for (std::size_t i = 0; i < sizeof(TraceMagic); i++)
+				reader.ReadUInt8();
+
+			InputTrace trace;
+			trace.numPlayers = (int)reader.ReadUInt32();
+			trace.numTicks = (int)reader.ReadUInt32();
+			std::uint32_t numEdits = reader.ReadUInt32();
+			if (trace.numPlayers < 1 || trace.numPlayers > (int)client::NumPlayerSlots)
+				SPRaise("Invalid number of players in the trace: %d", trace.numPlayers);
+
+			trace.frames.resize((std::size_t)trace.numPlayers * trace.numTicks);
+			for (PlayerFrame& frame : trace.frames) {
+				frame.keys = reader.ReadUInt8();
+				frame.buttons = reader.ReadUInt8();
+				frame.tool = reader.ReadUInt8();
+				frame.yaw = reader.ReadFloat();
+				frame.pitch = reader.ReadFloat();
+			}
+			for (std::uint32_t i = 0; i < numEdits; i++) {
+				BlockEdit edit;
+				edit.tick = reader.ReadUInt32();
+				edit.type = (BlockEdit::Type)reader.ReadUInt8();
+				edit.x = reader.ReadUInt16();
+				edit.y = reader.ReadUInt16();
+				trace.edits.push_back(edit);
+			}
+			return trace;
+		}
+
+		void BlockEditResolver::Resolve(const BlockEdit& edit, client::GameMap& map,
+		                                std::vector<BlockChange>& out) {
+			int x = edit.x, y = edit.y;
+			if (!map.IsValidMapCoord(x + 3, y, 0) || !map.IsValidMapCoord(x, y, 0))
+				return;
+			int z = GetTopZ(map, x, y);
+			IntVector3 color = MakeIntVector3(200, 100 + (x & 63), 50 + (y & 63));
+			switch (edit.type) {
+				case BlockEdit::Type::Dig:
+					if (z < 62)
+						out.push_back({MakeIntVector3(x, y, z), false, color});
+					break;
+				case BlockEdit::Type::Build:
+					if (z > 1)
+						out.push_back({MakeIntVector3(x, y, z - 1), true, color});
+					break;
+				case BlockEdit::Type::Tower:
+					if (z > 6 && z < 64) {
+						for (int i = 1; i <= 4; i++)
+							out.push_back({MakeIntVector3(x, y, z - i), true, color});
+						for (int i = 1; i <= 3; i++)
+							out.push_back({MakeIntVector3(x + i, y, z - 4), true, color});
+						towers.push_back(MakeIntVector3(x, y, z - 1));
+					}
+					break;
+				case BlockEdit::Type::Cut:
+					if (!towers.empty()) {
+						out.push_back({towers.front(), false, color});
+						towers.pop_front();
+					}
+					break;
+			}
+		}
+
+		/** Returns the height of the topmost solid voxel of the column, or 64 if none. */
+		int GetTopZ(client::GameMap& map, int x, int y) {
+			for (int z = 0; z < 64; z++)
+				if (map.IsSolid(x, y, z))
+					return z;
+			return 64;
+		}
+
+		Vector3 GetSpawnPosition(client::GameMap& map, IntVector3 center, int index) {
+			int x = center.x + (index * 37) % 65 - 32;
+			int y = center.y + (index * 53) % 65 - 32;
+			return MakeVector3((float)x + 0.5F, (float)y + 0.5F, (float)GetTopZ(map, x, y) - 2.4F);
+		}
+	} // namespace bench
+} // namespace spades
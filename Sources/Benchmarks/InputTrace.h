@@ -0,0 +1,122 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <Client/Player.h>
+#include <Core/Math.h>
+
+namespace spades {
+	namespace client {
+		class GameMap;
+	}
+
+	namespace bench {
+		constexpr float TickDuration = 1.0F / 60.0F;
+
+		/** The input of a player in a tick. */
+		struct PlayerFrame {
+			enum {
+				Forward = 1,
+				Backward = 2,
+				Left = 4,
+				Right = 8,
+				Jump = 16,
+				Crouch = 32,
+				Sprint = 64
+			};
+			enum { Primary = 1, Secondary = 2 };
+
+			std::uint8_t keys;
+			std::uint8_t buttons;
+			/** `client::Player::ToolType` */
+			std::uint8_t tool;
+			float yaw, pitch;
+
+			client::PlayerInput GetInput() const;
+			client::WeaponInput GetWeaponInput() const;
+			Vector3 GetOrientation() const;
+		};
+
+		/** A block action. The height is resolved against the map when it's replayed. */
+		struct BlockEdit {
+			enum class Type : std::uint8_t {
+				/** Destroys the topmost block of the column. */
+				Dig,
+				/** Creates a block on top of the column. */
+				Build,
+				/** Builds a pillar with an overhang on top of the column. */
+				Tower,
+				/** Destroys the base of the oldest tower, which makes the rest of it fall. */
+				Cut
+			};
+
+			std::uint32_t tick;
+			Type type;
+			std::uint16_t x, y;
+		};
+
+		/** Synthetic player inputs and block edits. Can be saved to replay the same session. */
+		struct InputTrace {
+			int numPlayers = 0;
+			int numTicks = 0;
+			/** `frames[tick * numPlayers + player]` */
+			std::vector<PlayerFrame> frames;
+			/** Sorted by `tick`. */
+			std::vector<BlockEdit> edits;
+
+			const PlayerFrame& GetFrame(int tick, int player) const {
+				return frames[(std::size_t)tick * numPlayers + player];
+			}
+
+			static InputTrace Generate(int numPlayers, int numTicks, int numEditsPerSecond,
+			                           IntVector3 center, unsigned seed);
+			static InputTrace Load(const std::string& path);
+			void Save(const std::string& path) const;
+		};
+
+		/** A block created or destroyed by a `BlockEdit`. */
+		struct BlockChange {
+			IntVector3 position;
+			bool create;
+			IntVector3 color;
+		};
+
+		/** Turns `BlockEdit`s into block changes against the current state of a map. */
+		class BlockEditResolver {
+			/** The bases of the towers built so far, the oldest first. */
+			std::deque<IntVector3> towers;
+
+		public:
+			void Resolve(const BlockEdit&, client::GameMap&, std::vector<BlockChange>& out);
+		};
+
+		/** Returns the height of the topmost solid voxel of the column, or 64 if none. */
+		int GetTopZ(client::GameMap&, int x, int y);
+
+		/** Returns the `index`-th spawn point of the scripted players around `center`. */
+		Vector3 GetSpawnPosition(client::GameMap&, IntVector3 center, int index);
+	} // namespace bench
+} // namespace spades
@@ -0,0 +1,125 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <map>
+#include <string>
+
+#include "Benchmark.h"
+#include <Core/Debug.h>
+#include <Core/DirectoryFileSystem.h>
+#include <Core/FileManager.h>
+#include <Core/Settings.h>
+
+#ifndef SPADES_BENCH_RESOURCE_DIR
+#define SPADES_BENCH_RESOURCE_DIR "./Resources"
+#endif
+
+namespace {
+	void PrintUsage(const char* argv0) {
+		printf("usage: %s [--list] [--resources=DIR] [--threads=N] [--json=FILE] "
+		       "[--OPTION=VALUE ...] [BENCHMARK ...]\n\n",
+		       argv0);
+		printf("Runs the named benchmarks, or all of them if none are specified.\n");
+		printf("--json writes the measurements to FILE as well.\n");
+	}
+
+	void PrintList() {
+		for (const auto& info : spades::bench::GetBenchmarks())
+			printf("%-24s %s\n", info.name, info.description);
+	}
+} // namespace
+
+int main(int argc, char** argv) {
+	using namespace spades;
+
+	// `SPRaise` needs the backtrace
+	reflection::Backtrace::StartBacktrace();
+
+	std::map<std::string, std::string> options;
+	std::vector<std::string> selected;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h") {
+			PrintUsage(argv[0]);
+			return 0;
+		} else if (arg == "--list") {
+			PrintList();
+			return 0;
+		} else if (arg.compare(0, 2, "--") == 0) {
+			auto eq = arg.find('=');
+			if (eq == std::string::npos)
+				options[arg.substr(2)] = "1";
+			else
+				options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+		} else {
+			selected.push_back(arg);
+		}
+	}
+
+	auto threadsIt = options.find("threads");
+	if (threadsIt != options.end()) {
+		Settings::ItemHandle{"core_numDispatchQueueThreads", nullptr} = threadsIt->second;
+		Settings::ItemHandle{"r_swNumThreads", nullptr} = threadsIt->second;
+	}
+
+	auto resIt = options.find("resources");
+	std::string resourceDir =
+	  resIt == options.end() ? std::string(SPADES_BENCH_RESOURCE_DIR) : resIt->second;
+	FileManager::AddFileSystem(new DirectoryFileSystem(resourceDir, false));
+
+	bench::BenchmarkContext context{options};
+
+	int numRun = 0;
+	for (const auto& info : bench::GetBenchmarks()) {
+		if (!selected.empty() &&
+		    std::find(selected.begin(), selected.end(), info.name) == selected.end())
+			continue;
+
+		context.SetCurrentBenchmark(info.name);
+		try {
+			info.func(context);
+		} catch (const std::exception& ex) {
+			fprintf(stderr, "%s: failed: %s\n", info.name, ex.what());
+			return 1;
+		}
+		++numRun;
+	}
+
+	if (numRun == 0) {
+		fprintf(stderr, "No matching benchmarks. Use --list to see the available ones.\n");
+		return 1;
+	}
+
+	auto jsonIt = options.find("json");
+	if (jsonIt != options.end()) {
+		try {
+			context.WriteJson(jsonIt->second);
+		} catch (const std::exception& ex) {
+			fprintf(stderr, "%s\n", ex.what());
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,274 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Core/FileManager.h>
+#include <Core/MemoryStream.h>
+#include <Core/Stopwatch.h>
+#include <Core/ThreadPool.h>
+#include <Draw/MapChunkMesher.h>
+
+using namespace spades;
+using namespace spades::client;
+using namespace spades::draw;
+
+namespace {
+	typedef MapChunkMesher::Vertex Vertex;
+	typedef MapChunkMesher::Mesh Mesh;
+
+	/** The mesher `GLMapChunk` used to have, which tests every voxel and its neighbors. */
+	class ReferenceMesher {
+		const GameMap& map;
+		bool water;
+		Mesh& mesh;
+
+		bool IsSolid(int x, int y, int z) {
+			if (z < 0)
+				return false;
+			if (z >= 64)
+				return true;
+			x &= 511;
+			y &= 511;
+			return map.IsSolid(x, y, (z == 63) ? (water ? 62 : 63) : z);
+		}
+
+		uint8_t calcAOID(int x, int y, int z, int ux, int uy, int uz, int vx, int vy, int vz) {
+			int v = 0;
+			if (IsSolid(x - ux, y - uy, z - uz))
+				v |= 1;
+			if (IsSolid(x + ux, y + uy, z + uz))
+				v |= 1 << 1;
+			if (IsSolid(x - vx, y - vy, z - vz))
+				v |= 1 << 2;
+			if (IsSolid(x + vx, y + vy, z + vz))
+				v |= 1 << 3;
+			if (IsSolid(x - ux + vx, y - uy + vy, z - uz + vz))
+				v |= 1 << 4;
+			if (IsSolid(x - ux - vx, y - uy - vy, z - uz - vz))
+				v |= 1 << 5;
+			if (IsSolid(x + ux + vx, y + uy + vy, z + uz + vz))
+				v |= 1 << 6;
+			if (IsSolid(x + ux - vx, y + uy - vy, z + uz - vz))
+				v |= 1 << 7;
+			return (uint8_t)v;
+		}
+
+		void EmitVertex(int x, int y, int z, int aoX, int aoY, int aoZ, int ux, int uy, int vx,
+		                int vy, uint32_t color, int nx, int ny, int nz) {
+			int uz = (ux == 0 && uy == 0) ? 1 : 0;
+			int vz = (vx == 0 && vy == 0) ? 1 : 0;
+			unsigned int aoID = calcAOID(aoX, aoY, aoZ, ux, uy, uz, vx, vy, vz);
+
+			Vertex inst;
+			inst.pad = inst.pad2 = inst.pad3 = 0;
+			if (nz == 1 || ny == 1)
+				inst.shading = 0;
+			else if (nx == 1 || nx == -1)
+				inst.shading = 0;
+			else if (nz == -1)
+				inst.shading = 220;
+			else
+				inst.shading = 255;
+
+			inst.colorRed = (uint8_t)(color);
+			inst.colorGreen = (uint8_t)(color >> 8);
+			inst.colorBlue = (uint8_t)(color >> 16);
+			inst.nx = nx;
+			inst.ny = ny;
+			inst.nz = nz;
+			inst.sx = (x << 1) + ux + vx;
+			inst.sy = (y << 1) + uy + vy;
+			inst.sz = (z << 1) + uz + vz;
+
+			unsigned int aoTexX = (aoID & 15) * 16;
+			unsigned int aoTexY = (aoID >> 4) * 16;
+
+			uint16_t idx = (uint16_t)mesh.vertices.size();
+			const int offsets[4][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+			for (const auto& o : offsets) {
+				inst.x = x + ux * o[0] + vx * o[1];
+				inst.y = y + uy * o[0] + vy * o[1];
+				inst.z = z + uz * o[0] + vz * o[1];
+				inst.aoX = aoTexX + 15 * o[0];
+				inst.aoY = aoTexY + 15 * o[1];
+				mesh.vertices.push_back(inst);
+			}
+
+			const int quadIndices[6] = {0, 1, 2, 1, 3, 2};
+			for (int i : quadIndices)
+				mesh.indices.push_back(idx + i);
+		}
+
+	public:
+		ReferenceMesher(const GameMap& map, bool water, Mesh& mesh)
+		    : map(map), water(water), mesh(mesh) {}
+
+		void Build(int cx, int cy, int cz) {
+			const int size = MapChunkMesher::Size;
+			mesh.Clear();
+			for (int x = 0; x < size; x++)
+				for (int y = 0; y < size; y++)
+					for (int z = 0; z < size; z++) {
+						int xx = x + cx * size, yy = y + cy * size, zz = z + cz * size;
+						if (!IsSolid(xx, yy, zz))
+							continue;
+
+						uint32_t col = map.GetColor(xx, yy, zz);
+						int health = col >> 24;
+						if (health < 100) {
+							col &= 0xFFFFFF;
+							col &= 0xFEFEFE;
+							col >>= 1;
+						}
+
+						if (!IsSolid(xx, yy, zz + 1))
+							EmitVertex(x + 1, y, z + 1, xx, yy, zz + 1, -1, 0, 0, 1, col, 0, 0, 1);
+						if (!IsSolid(xx, yy, zz - 1))
+							EmitVertex(x, y, z, xx, yy, zz - 1, 1, 0, 0, 1, col, 0, 0, -1);
+						if (!IsSolid(xx - 1, yy, zz))
+							EmitVertex(x, y + 1, z, xx - 1, yy, zz, 0, 0, 0, -1, col, -1, 0, 0);
+						if (!IsSolid(xx + 1, yy, zz))
+							EmitVertex(x + 1, y, z, xx + 1, yy, zz, 0, 0, 0, 1, col, 1, 0, 0);
+						if (!IsSolid(xx, yy - 1, zz))
+							EmitVertex(x, y, z, xx, yy - 1, zz, 0, 0, 1, 0, col, 0, -1, 0);
+						if (!IsSolid(xx, yy + 1, zz))
+							EmitVertex(x + 1, y + 1, z, xx, yy + 1, zz, 0, 0, -1, 0, col, 0, 1, 0);
+					}
+		}
+	};
+
+	bool IsSameMesh(const Mesh& a, const Mesh& b) {
+		if (a.vertices.size() != b.vertices.size() || a.indices != b.indices)
+			return false;
+		for (std::size_t i = 0; i < a.vertices.size(); i++) {
+			const Vertex &p = a.vertices[i], &q = b.vertices[i];
+			if (std::tie(p.x, p.y, p.z, p.aoX, p.aoY, p.colorRed, p.colorGreen, p.colorBlue,
+			             p.shading, p.nx, p.ny, p.nz, p.sx, p.sy, p.sz) !=
+			    std::tie(q.x, q.y, q.z, q.aoX, q.aoY, q.colorRed, q.colorGreen, q.colorBlue,
+			             q.shading, q.nx, q.ny, q.nz, q.sx, q.sy, q.sz))
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Splits the quads of a mesh into unit faces, keyed by the normal and the minimum corner,
+	 * so that merged and unmerged meshes can be compared.
+	 */
+	typedef std::tuple<int, int, int, int, int, int> UnitFace;
+	void CollectUnitFaces(const Mesh& mesh, std::map<UnitFace, uint32_t>& faces) {
+		faces.clear();
+		for (std::size_t i = 0; i + 3 < mesh.vertices.size(); i += 4) {
+			const Vertex& v0 = mesh.vertices[i];
+			const Vertex& v1 = mesh.vertices[i + 1];
+			const Vertex& v2 = mesh.vertices[i + 2];
+			int u[3] = {v1.x - v0.x, v1.y - v0.y, v1.z - v0.z};
+			int v[3] = {v2.x - v0.x, v2.y - v0.y, v2.z - v0.z};
+			int lenU = std::abs(u[0] + u[1] + u[2]), lenV = std::abs(v[0] + v[1] + v[2]);
+			for (int k = 0; k < 3; k++) {
+				u[k] /= lenU;
+				v[k] /= lenV;
+			}
+			uint32_t color = v0.colorRed | (v0.colorGreen << 8) | (v0.colorBlue << 16);
+			for (int a = 0; a < lenU; a++)
+				for (int b = 0; b < lenV; b++) {
+					int corner[3];
+					for (int k = 0; k < 3; k++)
+						corner[k] = (&v0.x)[k] + u[k] * a + v[k] * b +
+						            std::min(u[k], 0) + std::min(v[k], 0);
+					faces[std::make_tuple(v0.nx, v0.ny, v0.nz, corner[0], corner[1],
+					                      corner[2])] = color;
+				}
+		}
+	}
+
+	void RunMap(bench::BenchmarkContext& ctx, const std::string& prefix, const GameMap& map) {
+		const int chunkW = map.Width() / MapChunkMesher::Size;
+		const int chunkH = map.Height() / MapChunkMesher::Size;
+		const int chunkD = map.Depth() / MapChunkMesher::Size;
+		const int numChunks = chunkW * chunkH * chunkD;
+
+		std::vector<Mesh> reference(numChunks), bitmask(numChunks), greedy(numChunks);
+
+		Stopwatch sw;
+		for (int i = 0; i < numChunks; i++) {
+			ReferenceMesher mesher{map, true, reference[i]};
+			mesher.Build(i / (chunkH * chunkD), (i / chunkD) % chunkH, i % chunkD);
+		}
+		ctx.Report(prefix + "reference", sw.GetTime() * 1000.0, "ms");
+
+		MapChunkMesher mesher{map, true, false};
+		sw.Reset();
+		for (int i = 0; i < numChunks; i++)
+			mesher.Build(i / (chunkH * chunkD), (i / chunkD) % chunkH, i % chunkD, bitmask[i]);
+		ctx.Report(prefix + "bitmask", sw.GetTime() * 1000.0, "ms");
+
+		sw.Reset();
+		ParallelFor(numChunks, 16, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; i++)
+				mesher.Build((int)i / (chunkH * chunkD), ((int)i / chunkD) % chunkH,
+				             (int)i % chunkD, bitmask[i]);
+		});
+		ctx.Report(prefix + "bitmaskParallel", sw.GetTime() * 1000.0, "ms");
+
+		MapChunkMesher greedyMesher{map, true, true};
+		sw.Reset();
+		for (int i = 0; i < numChunks; i++)
+			greedyMesher.Build(i / (chunkH * chunkD), (i / chunkD) % chunkH, i % chunkD,
+			                   greedy[i]);
+		ctx.Report(prefix + "greedy", sw.GetTime() * 1000.0, "ms");
+
+		int numMismatches = 0, numCoverageMismatches = 0;
+		std::size_t numQuads = 0, numGreedyQuads = 0;
+		std::map<UnitFace, uint32_t> referenceFaces, greedyFaces;
+		for (int i = 0; i < numChunks; i++) {
+			if (!IsSameMesh(reference[i], bitmask[i]))
+				numMismatches++;
+
+			CollectUnitFaces(reference[i], referenceFaces);
+			CollectUnitFaces(greedy[i], greedyFaces);
+			if (referenceFaces != greedyFaces)
+				numCoverageMismatches++;
+
+			numQuads += reference[i].vertices.size() / 4;
+			numGreedyQuads += greedy[i].vertices.size() / 4;
+		}
+		ctx.Report(prefix + "mismatches", numMismatches, "chunks");
+		ctx.Report(prefix + "greedyCoverageMismatches", numCoverageMismatches, "chunks");
+		ctx.Report(prefix + "quads", (double)numQuads, "quads");
+		ctx.Report(prefix + "greedyQuads", (double)numGreedyQuads, "quads");
+	}
+} // namespace
+
+SPADES_BENCHMARK(MapChunkMesher, "Meshing map chunks, per voxel vs bitmask vs greedy") {
+	for (const std::string& path : ctx.GetMapFiles()) {
+		std::string data = FileManager::ReadAllBytes(path.c_str());
+		MemoryStream stream{data.data(), data.size()};
+		Handle<GameMap> map{GameMap::Load(&stream), false};
+		RunMap(ctx, path + ".", *map);
+	}
+}
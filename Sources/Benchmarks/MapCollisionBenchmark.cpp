@@ -0,0 +1,127 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/MapCollision.h>
+#include <Core/Exception.h>
+#include <Core/Stopwatch.h>
+
+using namespace spades;
+using namespace spades::client;
+
+namespace {
+	/** The collision test as written in each entity before `CollideWithMap`. */
+	MapCollision ReferenceCollision(const GameMap& map, const Vector3& oldPos,
+	                                const Vector3& newPos) {
+		IntVector3 lp = newPos.Floor();
+		if (!map.ClipWorld(lp.x, lp.y, lp.z))
+			return MapCollision::None;
+
+		IntVector3 lp2 = oldPos.Floor();
+		if (lp.z != lp2.z &&
+		    ((lp.x == lp2.x && lp.y == lp2.y) || !map.ClipWorld(lp.x, lp.y, lp2.z)))
+			return MapCollision::BounceZ;
+		else if (lp.x != lp2.x &&
+		         ((lp.y == lp2.y && lp.z == lp2.z) || !map.ClipWorld(lp2.x, lp.y, lp.z)))
+			return MapCollision::BounceX;
+		else if (lp.y != lp2.y &&
+		         ((lp.x == lp2.x && lp.z == lp2.z) || !map.ClipWorld(lp.x, lp2.y, lp.z)))
+			return MapCollision::BounceY;
+		return MapCollision::Stuck;
+	}
+} // namespace
+
+SPADES_BENCHMARK(MapCollision, "Testing moving points against the map, one by one vs batched") {
+	std::size_t numPoints = (std::size_t)ctx.GetIntOption("points", 16384);
+	int numIterations = ctx.GetIntOption("iterations", 200);
+
+	// Hilly terrain with pillars. Also has points outside the map and near the water
+	Handle<GameMap> map{new GameMap(), false};
+	for (int x = 0; x < map->Width(); x++) {
+		for (int y = 0; y < map->Height(); y++) {
+			int height = 40 + (int)(8.0F * sinf(x * 0.05F) * cosf(y * 0.07F));
+			if ((x * 31 + y * 17) % 97 == 0)
+				height = 20;
+			for (int z = height; z < map->Depth(); z++)
+				map->Set(x, y, z, true, 0x64808080, true);
+		}
+	}
+
+	std::mt19937 rng{1};
+	std::uniform_real_distribution<float> uniform{0.0F, 1.0F};
+	std::vector<float> oldPos[3], newPos[3];
+	for (int axis = 0; axis < 3; axis++) {
+		oldPos[axis].resize(numPoints);
+		newPos[axis].resize(numPoints);
+	}
+	for (std::size_t i = 0; i < numPoints; i++) {
+		float pos[] = {uniform(rng) * 540.0F - 14.0F, uniform(rng) * 540.0F - 14.0F,
+		               uniform(rng) * 72.0F - 6.0F};
+		for (int axis = 0; axis < 3; axis++) {
+			if (i % 8 == 0)
+				pos[axis] = floorf(pos[axis]); // exactly on a block boundary
+			oldPos[axis][i] = pos[axis];
+			newPos[axis][i] = pos[axis] + (uniform(rng) - 0.5F) * 1.5F;
+		}
+	}
+
+	const float* oldArrays[] = {oldPos[0].data(), oldPos[1].data(), oldPos[2].data()};
+	const float* newArrays[] = {newPos[0].data(), newPos[1].data(), newPos[2].data()};
+
+	std::vector<MapCollision> reference(numPoints), batched(numPoints), single(numPoints);
+
+	Stopwatch sw;
+	for (int k = 0; k < numIterations; k++) {
+		for (std::size_t i = 0; i < numPoints; i++) {
+			reference[i] = ReferenceCollision(
+			  *map, MakeVector3(oldPos[0][i], oldPos[1][i], oldPos[2][i]),
+			  MakeVector3(newPos[0][i], newPos[1][i], newPos[2][i]));
+		}
+	}
+	ctx.Report("reference", sw.GetTime() * 1.0e9 / (numPoints * numIterations), "ns/point");
+
+	sw.Reset();
+	for (int k = 0; k < numIterations; k++)
+		CollideWithMap(*map, numPoints, oldArrays, newArrays, batched.data());
+	ctx.Report("batched", sw.GetTime() * 1.0e9 / (numPoints * numIterations), "ns/point");
+
+	for (std::size_t i = 0; i < numPoints; i++) {
+		single[i] = CollideWithMap(*map, MakeVector3(oldPos[0][i], oldPos[1][i], oldPos[2][i]),
+		                           MakeVector3(newPos[0][i], newPos[1][i], newPos[2][i]));
+	}
+
+	std::size_t numHits = 0, numMismatches = 0;
+	for (std::size_t i = 0; i < numPoints; i++) {
+		if (reference[i] != MapCollision::None)
+			numHits++;
+		if (batched[i] != reference[i] || single[i] != reference[i])
+			numMismatches++;
+	}
+	ctx.Report("hits", (double)numHits, "points");
+	ctx.Report("mismatches", (double)numMismatches, "points");
+	if (numMismatches != 0)
+		SPRaise("CollideWithMap disagrees with the reference on %d points",
+		        static_cast<int>(numMismatches));
+}
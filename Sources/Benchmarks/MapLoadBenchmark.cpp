@@ -0,0 +1,160 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <memory>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/GameMapLoader.h>
+#include <Client/GameMapWrapper.h>
+#include <Core/DeflateStream.h>
+#include <Core/DynamicMemoryStream.h>
+#include <Core/FileManager.h>
+#include <Core/MemoryStream.h>
+#include <Core/Stopwatch.h>
+#include <Core/ThreadPool.h>
+
+using namespace spades;
+using namespace spades::client;
+
+namespace {
+	std::string Compress(const std::string& data) {
+		DynamicMemoryStream stream;
+		{
+			DeflateStream deflate(&stream, CompressModeCompress);
+			deflate.Write(data.data(), data.size());
+			deflate.DeflateEnd();
+		}
+		stream.SetPosition(0);
+		return stream.Read(static_cast<std::size_t>(stream.GetLength()));
+	}
+
+	int CountMismatches(GameMap& a, GameMap& b) {
+		int count = 0;
+		for (int x = 0; x < a.Width(); x++)
+			for (int y = 0; y < a.Height(); y++) {
+				uint64_t solid = a.GetSolidMap(x, y);
+				if (solid != b.GetSolidMap(x, y)) {
+					count++;
+					continue;
+				}
+				for (int z = 0; z < a.Depth(); z++) {
+					if (((solid >> z) & 1) && a.GetColor(x, y, z) != b.GetColor(x, y, z)) {
+						count++;
+						break;
+					}
+				}
+			}
+		return count;
+	}
+} // namespace
+
+SPADES_BENCHMARK(MapLoad, "Map decoding from a buffer, the network, and the cache") {
+	int numIterations = std::max(1, ctx.GetIntOption("iterations", 3));
+	// The size of the map data packets sent by the server
+	int chunkSize = std::max(1, ctx.GetIntOption("chunk", 8192));
+
+	ctx.Report("threads", ThreadPool::GetInstance().GetNumParticipants(), "");
+
+	for (const std::string& path : ctx.GetMapFiles()) {
+		std::string data = FileManager::ReadAllBytes(path.c_str());
+		std::string compressed = Compress(data);
+		std::string prefix = path + ".";
+
+		// Decoding uncompressed data that is already in memory
+		Handle<GameMap> reference;
+		Stopwatch sw;
+		for (int i = 0; i < numIterations; i++) {
+			MemoryStream stream{data.data(), data.size()};
+			reference = Handle<GameMap>{GameMap::Load(&stream), false};
+		}
+		ctx.Report(prefix + "load", sw.GetTime() * 1000.0 / numIterations, "ms");
+
+		sw.Reset();
+		for (int i = 0; i < numIterations; i++) {
+			GameMapWrapper wrapper{*reference};
+			wrapper.Rebuild();
+		}
+		ctx.Report(prefix + "rebuild", sw.GetTime() * 1000.0 / numIterations, "ms");
+
+		// The time until the world can be created after the last packet arrives. The packets
+		// arrive as fast as possible, so this is the worst case for the streaming decoder.
+		Handle<GameMap> streamed;
+		double totalTime = 0.0, tailTime = 0.0;
+		for (int i = 0; i < numIterations; i++) {
+			sw.Reset();
+			GameMapLoader loader;
+			for (std::size_t pos = 0; pos < compressed.size(); pos += chunkSize) {
+				std::size_t size = std::min<std::size_t>(chunkSize, compressed.size() - pos);
+				loader.AddRawChunk(compressed.data() + pos, size);
+			}
+
+			Stopwatch tail;
+			loader.MarkEOF();
+			loader.WaitComplete();
+			std::unique_ptr<GameMapWrapper> wrapper;
+			streamed = loader.TakeGameMap(&wrapper);
+			tailTime += tail.GetTime();
+			totalTime += sw.GetTime();
+		}
+		ctx.Report(prefix + "stream", totalTime * 1000.0 / numIterations, "ms");
+		ctx.Report(prefix + "streamTail", tailTime * 1000.0 / numIterations, "ms");
+		ctx.Report(prefix + "mismatches", CountMismatches(*reference, *streamed), "columns");
+
+		// A hit in `MapCache`
+		DynamicMemoryStream snapshot;
+		reference->SaveSnapshot(&snapshot);
+		ctx.Report(prefix + "snapshotSize", (double)snapshot.GetLength() / 1048576.0, "MiB");
+
+		// What `MapCache::Store` costs the game thread; the file is written in background
+		sw.Reset();
+		for (int i = 0; i < numIterations; i++) {
+			DynamicMemoryStream stream;
+			reference->SaveSnapshot(&stream);
+		}
+		ctx.Report(prefix + "snapshotSave", sw.GetTime() * 1000.0 / numIterations, "ms");
+
+		Handle<GameMap> restored;
+		sw.Reset();
+		for (int i = 0; i < numIterations; i++) {
+			snapshot.SetPosition(0);
+			restored = Handle<GameMap>{GameMap::LoadSnapshot(&snapshot), false};
+		}
+		ctx.Report(prefix + "snapshotLoad", sw.GetTime() * 1000.0 / numIterations, "ms");
+		ctx.Report(prefix + "snapshotMismatches", CountMismatches(*reference, *restored),
+		           "columns");
+
+		// From memory, like a mapped cache entry that is in the page cache
+		std::size_t snapshotSize = static_cast<std::size_t>(snapshot.GetLength());
+		std::vector<uint64_t> mapped((snapshotSize + 7) / 8);
+		snapshot.SetPosition(0);
+		snapshot.Read(mapped.data(), snapshotSize);
+		sw.Reset();
+		for (int i = 0; i < numIterations; i++) {
+			restored = Handle<GameMap>{
+			  GameMap::LoadSnapshot(reinterpret_cast<const char*>(mapped.data()), snapshotSize),
+			  false};
+		}
+		ctx.Report(prefix + "snapshotLoadMapped", sw.GetTime() * 1000.0 / numIterations, "ms");
+		ctx.Report(prefix + "snapshotMappedMismatches", CountMismatches(*reference, *restored),
+		           "columns");
+	}
+}
@@ -0,0 +1,243 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <enet/enet.h>
+
+#include "Benchmark.h"
+#include <Client/NetIOThread.h>
+#include <Core/Exception.h>
+#include <Core/Stopwatch.h>
+#include <Core/Thread.h>
+
+using namespace spades;
+using namespace spades::client;
+using namespace spades::bench;
+
+namespace {
+	/**
+	 * A loopback server that streams map chunks and world updates to the client, and
+	 * measures how long the client's packets took to arrive. The client's packets carry
+	 * the time they were created at.
+	 */
+	class LoopbackServer : public Thread {
+	public:
+		LoopbackServer(Stopwatch& clock) : clock(clock) {
+			ENetAddress address;
+			address.host = ENET_HOST_ANY;
+			address.port = 0;
+			host = enet_host_create(&address, 1, 1, 0, 0);
+			if (!host)
+				SPRaise("Failed to create the server host");
+			enet_host_compress_with_range_coder(host);
+			enet_socket_get_address(host->socket, &address);
+			port = address.port;
+
+			// A map chunk is hardly compressible; a world update is
+			chunk.resize(8192);
+			unsigned int seed = 1;
+			for (char& c : chunk) {
+				seed = seed * 1103515245 + 12345;
+				c = static_cast<char>(seed >> 16);
+			}
+			worldUpdate.resize(1 + 32 * 24);
+			for (std::size_t i = 0; i < worldUpdate.size(); i++)
+				worldUpdate[i] = static_cast<char>(i / 24);
+		}
+		~LoopbackServer() { enet_host_destroy(host); }
+
+		enet_uint16 GetPort() const { return port; }
+
+		void Run() override {
+			ENetPeer* client = nullptr;
+			double nextSend = 0.0;
+			while (!stopRequested.load(std::memory_order_acquire)) {
+				ENetEvent event;
+				int result = enet_host_service(host, &event, 1);
+				while (result > 0) {
+					if (event.type == ENET_EVENT_TYPE_CONNECT) {
+						client = event.peer;
+					} else if (event.type == ENET_EVENT_TYPE_RECEIVE) {
+						double sent;
+						std::memcpy(&sent, event.packet->data + 1, sizeof(double));
+						double latency = clock.GetTime() - sent;
+						totalLatency += latency;
+						maxLatency = std::max(maxLatency, latency);
+						numReceived++;
+						enet_packet_destroy(event.packet);
+					}
+					result = enet_host_check_events(host, &event);
+				}
+
+				double time = clock.GetTime();
+				if (client && streaming.load(std::memory_order_acquire) && time >= nextSend) {
+					nextSend = time + 0.01;
+					enet_peer_send(client, 0,
+					               enet_packet_create(chunk.data(), chunk.size(),
+					                                  ENET_PACKET_FLAG_RELIABLE));
+					enet_peer_send(client, 0,
+					               enet_packet_create(worldUpdate.data(), worldUpdate.size(),
+					                                  ENET_PACKET_FLAG_RELIABLE));
+				}
+			}
+		}
+
+		std::atomic<bool> stopRequested{false};
+		std::atomic<bool> streaming{false};
+
+		// Read after the thread exited
+		double totalLatency = 0.0;
+		double maxLatency = 0.0;
+		int numReceived = 0;
+
+	private:
+		Stopwatch& clock;
+		ENetHost* host;
+		enet_uint16 port;
+		std::vector<char> chunk;
+		std::vector<char> worldUpdate;
+	};
+
+	ENetPacket* CreateStampedPacket(Stopwatch& clock) {
+		char data[1 + sizeof(double)];
+		data[0] = 3; // InputData
+		double time = clock.GetTime();
+		std::memcpy(data + 1, &time, sizeof(double));
+		return enet_packet_create(data, sizeof(data), ENET_PACKET_FLAG_RELIABLE);
+	}
+
+	void BusyWait(Stopwatch& clock, double until) {
+		while (clock.GetTime() < until)
+			std::this_thread::yield();
+	}
+} // namespace
+
+SPADES_BENCHMARK(NetIOThread, "Game-thread network cost and input latency with NetIOThread") {
+	int numFrames = ctx.GetIntOption("frames", 300);
+	double frameTime = ctx.GetIntOption("frame-ms", 16) * 1.0e-3;
+	int hitchInterval = ctx.GetIntOption("hitch-interval", 30);
+	double hitchTime = ctx.GetIntOption("hitch-ms", 100) * 1.0e-3;
+
+	enet_initialize();
+
+	Stopwatch clock;
+	for (int threaded = 0; threaded < 2; threaded++) {
+		const char* prefix = threaded ? "ioThread" : "inline";
+
+		LoopbackServer server{clock};
+		server.Start();
+
+		ENetHost* host = enet_host_create(NULL, 1, 1, 100000, 100000);
+		if (!host)
+			SPRaise("Failed to create the client host");
+		enet_host_compress_with_range_coder(host);
+
+		ENetAddress address;
+		enet_address_set_host(&address, "127.0.0.1");
+		address.port = server.GetPort();
+		ENetPeer* peer = enet_host_connect(host, &address, 1, 3);
+
+		std::unique_ptr<NetIOThread> ioThread;
+		if (threaded)
+			ioThread.reset(new NetIOThread(host, peer, 1.0 / 120.0));
+
+		// The client's part of one frame: handle the received events and send the input
+		SectionProfile networkProfile;
+		std::uint64_t numBytesReceived = 0;
+		auto doFrame = [&]() {
+			networkProfile.Begin();
+			if (ioThread) {
+				NetIOEvent event;
+				while (ioThread->Poll(event)) {
+					if (event.packet) {
+						numBytesReceived += event.packet->dataLength;
+						enet_packet_destroy(event.packet);
+					}
+				}
+				ioThread->Send(CreateStampedPacket(clock));
+			} else {
+				ENetEvent event;
+				while (enet_host_service(host, &event, 0) > 0) {
+					if (event.type == ENET_EVENT_TYPE_RECEIVE) {
+						numBytesReceived += event.packet->dataLength;
+						enet_packet_destroy(event.packet);
+					}
+				}
+				enet_peer_send(peer, 0, CreateStampedPacket(clock));
+			}
+			networkProfile.End();
+		};
+
+		bool connected = false;
+		if (ioThread) {
+			NetIOEvent event;
+			connected = ioThread->Poll(event, 5000) && event.type == NetIOEventType::Connect;
+		} else {
+			ENetEvent event;
+			connected = enet_host_service(host, &event, 5000) > 0 &&
+			            event.type == ENET_EVENT_TYPE_CONNECT;
+		}
+		if (!connected)
+			SPRaise("Failed to connect to the loopback server");
+
+		server.streaming.store(true, std::memory_order_release);
+
+		double startTime = clock.GetTime();
+		double frameStart = startTime;
+		for (int i = 0; i < numFrames; i++) {
+			doFrame();
+			// The rest of the frame (rendering etc.), sometimes a hitch
+			bool hitch = hitchInterval > 0 && i % hitchInterval == hitchInterval - 1;
+			frameStart += hitch ? hitchTime : frameTime;
+			BusyWait(clock, frameStart);
+		}
+		double elapsed = clock.GetTime() - startTime;
+		server.streaming.store(false, std::memory_order_release);
+
+		// Let the last inputs arrive
+		for (int i = 0; i < 20; i++) {
+			doFrame();
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		server.stopRequested.store(true, std::memory_order_release);
+		server.Join();
+
+		ctx.ReportSection(std::string(prefix) + ".network", networkProfile, numFrames + 20,
+		                  "frame");
+		ctx.Report(std::string(prefix) + ".downlink", numBytesReceived / elapsed / 1024.0,
+		           "KiB/s");
+		if (server.numReceived > 0) {
+			ctx.Report(std::string(prefix) + ".sendLatency.mean",
+			           server.totalLatency / server.numReceived * 1.0e3, "ms");
+			ctx.Report(std::string(prefix) + ".sendLatency.max", server.maxLatency * 1.0e3,
+			           "ms");
+		}
+
+		ioThread.reset();
+		enet_peer_disconnect_now(peer, 0);
+		enet_host_destroy(host);
+	}
+}
@@ -0,0 +1,141 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <enet/enet.h>
+
+#include "Benchmark.h"
+#include <Client/NetPacket.h>
+
+using namespace spades;
+using namespace spades::client;
+using namespace spades::bench;
+
+namespace {
+	/** Builds a `WorldUpdate` packet of a full 32-player server as ENet would receive it. */
+	std::vector<char> MakeWorldUpdate() {
+		std::vector<char> data;
+		data.push_back(static_cast<char>(PacketTypeWorldUpdate));
+		for (int i = 0; i < 32 * 6; i++) {
+			float f = static_cast<float>(i) * 0.5f;
+			char bytes[4];
+			std::memcpy(bytes, &f, 4);
+			data.insert(data.end(), bytes, bytes + 4);
+		}
+		return data;
+	}
+
+	float ReadWorldUpdate(NetPacketReader& r) {
+		float sum = 0.f;
+		while (r.GetNumRemainingBytes() >= 24) {
+			Vector3 pos = r.ReadVector3();
+			Vector3 front = r.ReadVector3();
+			sum += pos.x + front.z;
+		}
+		return sum;
+	}
+
+	void WriteInputs(NetPacketWriter& w, int i) {
+		w.WriteByte(static_cast<uint8_t>(i));
+		w.WriteVector3(Vector3(static_cast<float>(i), 1.f, 2.f));
+	}
+
+	/** The `NetPacketWriter` implementation prior to the pooled buffers. */
+	ENetPacket* CreateCopiedPacket(int i) {
+		std::vector<char> data;
+		data.push_back(static_cast<char>(PacketTypePositionData));
+		for (int k = 0; k < 13; k++)
+			data.push_back(static_cast<char>(i + k));
+		return enet_packet_create(data.data(), data.size(), ENET_PACKET_FLAG_RELIABLE);
+	}
+} // namespace
+
+SPADES_BENCHMARK(NetPackets, "Receiving and sending packets through NetPacketReader/Writer") {
+	int numIterations = ctx.GetIntOption("iterations", 200000);
+	std::vector<char> worldUpdate = MakeWorldUpdate();
+	volatile float sink = 0.f;
+
+	// `ENetHost` hands us the received packet, which the reader used to copy into a vector
+	SectionProfile copyProfile, borrowProfile;
+	for (int i = 0; i < numIterations; i++) {
+		ENetPacket* packet = enet_packet_create(worldUpdate.data(), worldUpdate.size(), 0);
+
+		copyProfile.Begin();
+		{
+			std::vector<char> copy(packet->data, packet->data + packet->dataLength);
+			enet_packet_destroy(packet);
+			NetPacketReader r{copy.data(), copy.size()};
+			sink = sink + ReadWorldUpdate(r);
+		}
+		copyProfile.End();
+
+		packet = enet_packet_create(worldUpdate.data(), worldUpdate.size(), 0);
+
+		borrowProfile.Begin();
+		{
+			NetPacketReader r{packet};
+			sink = sink + ReadWorldUpdate(r);
+		}
+		borrowProfile.End();
+	}
+	ctx.ReportSection("receive.copied", copyProfile, numIterations, "packet");
+	ctx.ReportSection("receive.borrowed", borrowProfile, numIterations, "packet");
+
+	// Packets received during the map transfer are kept until the world is created
+	SectionProfile saveProfile;
+	std::vector<NetPacketReader> saved;
+	saved.reserve(256);
+	for (int i = 0; i < numIterations; i++) {
+		ENetPacket* packet = enet_packet_create(worldUpdate.data(), worldUpdate.size(), 0);
+
+		saveProfile.Begin();
+		{
+			NetPacketReader r{packet};
+			saved.push_back(r.Detach());
+		}
+		saveProfile.End();
+
+		if (saved.size() == 256)
+			saved.clear();
+	}
+	saved.clear();
+	ctx.ReportSection("receive.saved", saveProfile, numIterations, "packet");
+
+	// ENet destroys a sent packet after it's acknowledged
+	SectionProfile oldSendProfile, sendProfile;
+	for (int i = 0; i < numIterations; i++) {
+		oldSendProfile.Begin();
+		enet_packet_destroy(CreateCopiedPacket(i));
+		oldSendProfile.End();
+
+		sendProfile.Begin();
+		{
+			NetPacketWriter w{PacketTypePositionData};
+			WriteInputs(w, i);
+			enet_packet_destroy(w.CreatePacket());
+		}
+		sendProfile.End();
+	}
+	ctx.ReportSection("send.copied", oldSendProfile, numIterations, "packet");
+	ctx.ReportSection("send.pooled", sendProfile, numIterations, "packet");
+}
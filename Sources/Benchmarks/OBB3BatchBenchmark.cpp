@@ -0,0 +1,134 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Core/Exception.h>
+#include <Core/Math.h>
+#include <Core/Stopwatch.h>
+
+using namespace spades;
+
+namespace {
+	const char* GetKernelName(OBB3Batch::Kernel kernel) {
+		switch (kernel) {
+			case OBB3Batch::Kernel::Scalar: return "scalar";
+			case OBB3Batch::Kernel::SSE2: return "sse2";
+			case OBB3Batch::Kernel::AVX: return "avx";
+		}
+		return "unknown";
+	}
+
+	bool IsSameFloat(float a, float b) { return std::memcmp(&a, &b, sizeof(float)) == 0; }
+} // namespace
+
+SPADES_BENCHMARK(OBB3Batch, "Ray vs hitbox kernels of OBB3Batch, checked against OBB3::RayCast") {
+	// The hitboxes of 64 players
+	int numBoxes = ctx.GetIntOption("boxes", 64 * 5);
+	int numRays = ctx.GetIntOption("rays", 20000);
+
+	std::mt19937 rng{1};
+	std::uniform_real_distribution<float> uniform{-1.0F, 1.0F};
+
+	// Hitbox-like boxes: rotated and scaled, clustered so that many rays hit something
+	OBB3Batch batch;
+	for (int i = 0; i < numBoxes; i++) {
+		Vector3 pos = MakeVector3(uniform(rng), uniform(rng), uniform(rng)) * 8.0F;
+		Matrix4 m = Matrix4::Translate(pos) *
+		            Matrix4::Rotate(MakeVector3(0, 0, 1), uniform(rng) * M_PI_F) *
+		            Matrix4::Rotate(MakeVector3(1, 0, 0), uniform(rng) * M_PI_F * 0.5F);
+		batch.Add(m * AABB3(-0.4F, -0.2F, 0.0F, 0.8F + uniform(rng) * 0.2F, 0.4F, 0.9F));
+	}
+
+	struct Ray {
+		Vector3 start, dir;
+	};
+	std::vector<Ray> rays(numRays);
+	for (std::size_t i = 0; i < rays.size(); i++) {
+		Ray& ray = rays[i];
+		ray.start = MakeVector3(uniform(rng), uniform(rng), uniform(rng)) * 16.0F;
+		Vector3 target = MakeVector3(uniform(rng), uniform(rng), uniform(rng)) * 8.0F;
+		switch (i % 8) {
+			case 0:
+				// Start inside a box
+				ray.start = (batch[i % batch.GetCount()].m * MakeVector3(0.5F, 0.5F, 0.5F)).GetXYZ();
+				break;
+			case 1:
+				// Axis-aligned, so some dot products are exactly zero
+				target = ray.start;
+				target.x += 1.0F;
+				break;
+		}
+		ray.dir = (target - ray.start).Normalize();
+	}
+
+	// Reference: `OBB3::RayCast` on each box
+	std::vector<OBB3Batch::RayCastResult> expected(rays.size() * batch.GetCount());
+	Stopwatch sw;
+	for (std::size_t i = 0; i < rays.size(); i++) {
+		for (std::size_t k = 0; k < batch.GetCount(); k++) {
+			OBB3 box = batch[k];
+			auto& result = expected[i * batch.GetCount() + k];
+			result.hit = box.RayCast(rays[i].start, rays[i].dir, &result.hitPos);
+		}
+	}
+	double numTests = static_cast<double>(rays.size()) * batch.GetCount();
+	ctx.Report("obb3.perBox", sw.GetTime() / numTests * 1.0e9, "ns");
+
+	const OBB3Batch::Kernel kernels[] = {OBB3Batch::Kernel::Scalar, OBB3Batch::Kernel::SSE2,
+	                                      OBB3Batch::Kernel::AVX};
+	std::vector<OBB3Batch::RayCastResult> results(batch.GetCount());
+	for (OBB3Batch::Kernel kernel : kernels) {
+		if (!OBB3Batch::IsKernelSupported(kernel))
+			continue;
+
+		std::string name = GetKernelName(kernel);
+		long numMismatches = 0, numHits = 0;
+		double time = 0.0;
+		for (std::size_t i = 0; i < rays.size(); i++) {
+			sw.Reset();
+			batch.RayCast(rays[i].start, rays[i].dir, results.data(), kernel);
+			time += sw.GetTime();
+
+			for (std::size_t k = 0; k < batch.GetCount(); k++) {
+				const auto& a = results[k];
+				const auto& b = expected[i * batch.GetCount() + k];
+				if (a.hit != b.hit) {
+					numMismatches++;
+				} else if (a.hit) {
+					numHits++;
+					if (!IsSameFloat(a.hitPos.x, b.hitPos.x) ||
+					    !IsSameFloat(a.hitPos.y, b.hitPos.y) ||
+					    !IsSameFloat(a.hitPos.z, b.hitPos.z))
+						numMismatches++;
+				}
+			}
+		}
+		ctx.Report(name + ".perBox", time / numTests * 1.0e9, "ns");
+		ctx.Report(name + ".hitRate", numHits / numTests * 100.0, "%");
+		ctx.Report(name + ".mismatches", static_cast<double>(numMismatches), "boxes");
+		if (numMismatches != 0)
+			SPRaise("%s kernel disagrees with OBB3::RayCast on %ld boxes", name.c_str(),
+			        numMismatches);
+	}
+}
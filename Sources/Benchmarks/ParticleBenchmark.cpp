@@ -0,0 +1,248 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cmath>
+#include <list>
+#include <memory>
+#include <random>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/IImage.h>
+#include <Client/ILocalEntity.h>
+#include <Client/ParticleSystem.h>
+#include <Core/Exception.h>
+#include <Core/Stopwatch.h>
+#include <Core/TMPUtils.h>
+
+using namespace spades;
+using namespace spades::client;
+
+namespace {
+	class NullImage : public IImage {
+	public:
+		void Update(Bitmap&, int, int) override {}
+		float GetWidth() override { return 1.0F; }
+		float GetHeight() override { return 1.0F; }
+	};
+
+	/**
+	 * The reference for `ParticleSystem`: one local entity per particle, updated like
+	 * `ParticleSpriteEntity::Update` was before `ParticleSystem` replaced it.
+	 *
+	 * `Update` is a frozen snapshot of that function and must not be changed to follow
+	 * `ParticleSystem`; it is what the new code is checked against.
+	 */
+	class LegacyParticle : public ILocalEntity {
+	public:
+		Handle<GameMap> map;
+		ParticleSprite state;
+		float time = 0.0F;
+
+		LegacyParticle(GameMap& map, const ParticleSprite& state) : map(&map), state(state) {}
+
+		bool Update(float dt) override {
+			time += dt;
+			if (time > state.lifetime)
+				return false;
+
+			Vector3 lastPos = state.position;
+			Vector3& position = state.position;
+			Vector3& velocity = state.velocity;
+
+			position += velocity * dt;
+			velocity.z += 32.0F * dt * state.gravityScale;
+
+			if (state.blockHitAction != BlockHitAction::Ignore && map) {
+				IntVector3 lp = position.Floor();
+				if (map->ClipWorld(lp.x, lp.y, lp.z)) {
+					if (state.blockHitAction == BlockHitAction::Delete) {
+						return false;
+					} else {
+						IntVector3 lp2 = lastPos.Floor();
+						if (lp.z != lp2.z && ((lp.x == lp2.x && lp.y == lp2.y) ||
+						                      !map->ClipWorld(lp.x, lp.y, lp2.z)))
+							velocity.z = -velocity.z;
+						else if (lp.x != lp2.x && ((lp.y == lp2.y && lp.z == lp2.z) ||
+						                           !map->ClipWorld(lp2.x, lp.y, lp.z)))
+							velocity.x = -velocity.x;
+						else if (lp.y != lp2.y && ((lp.x == lp2.x && lp.z == lp2.z) ||
+						                           !map->ClipWorld(lp.x, lp2.y, lp.z)))
+							velocity.y = -velocity.y;
+
+						position = lastPos;
+						velocity *= 0.46F;
+						state.radius *= 0.75F;
+					}
+				}
+			}
+
+			if (state.radiusVelocity != 0.0F)
+				state.radius += state.radiusVelocity * dt;
+			if (state.rotationVelocity != 0.0F)
+				state.angle += state.rotationVelocity * dt;
+			if (state.velocityDamp != 1.0F)
+				velocity *= powf(state.velocityDamp, dt);
+			if (state.radiusDamp != 1.0F)
+				state.radiusVelocity *= powf(state.radiusDamp, dt);
+			return true;
+		}
+	};
+
+	/** Generates the fragments of grenade explosions, like `Client::GrenadeExplosion`. */
+	class ExplosionGenerator {
+		std::mt19937 rng{1};
+		std::uniform_real_distribution<float> uniform{0.0F, 1.0F};
+		IImage& image;
+
+		Vector3 RandomAxis() {
+			Vector3 v;
+			do {
+				v = MakeVector3(uniform(rng), uniform(rng), uniform(rng)) * 2.0F - 1.0F;
+			} while (v.GetSquaredLength() > 1.0F || v.GetSquaredLength() < 0.01F);
+			return v.Normalize();
+		}
+
+	public:
+		ExplosionGenerator(IImage& image) : image(image) {}
+
+		template <class F> void Generate(F emit) {
+			Vector3 pos = MakeVector3(64.0F + uniform(rng) * 384.0F,
+			                          64.0F + uniform(rng) * 384.0F, 50.0F + uniform(rng) * 10.0F);
+			for (int i = 0; i < 64; i++) {
+				ParticleSprite particle{image, MakeVector4(0.3F, 0.3F, 0.3F, 1.0F)};
+				Vector3 dir = RandomAxis();
+				float radius = 0.3F + uniform(rng) * uniform(rng) * 0.3F;
+				particle.SetTrajectory(pos + dir * 0.2F, dir * 20.0F, 0.1F + radius * 3.0F);
+				particle.SetRadius(radius);
+				particle.SetLifeTime(3.5F + uniform(rng) * 2.0F, 0.0F, 1.0F);
+				particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+				emit(particle);
+			}
+		}
+	};
+} // namespace
+
+SPADES_BENCHMARK(Particles, "Updating grenade fragments, one entity each vs ParticleSystem") {
+	// A grenade every `frames / explosions` frames, each lasting for about 300 frames
+	int numExplosions = ctx.GetIntOption("explosions", 600);
+	int numFrames = ctx.GetIntOption("frames", 1200);
+	const float dt = 1.0F / 60.0F;
+
+	Handle<GameMap> map{new GameMap(), false};
+	for (int x = 0; x < map->Width(); x++)
+		for (int y = 0; y < map->Height(); y++)
+			for (int z = 56; z < map->Depth(); z++)
+				map->Set(x, y, z, true, 0x64808080, true);
+	for (int i = 0; i < 4096; i++) {
+		// Some obstacles to bounce off
+		int x = (int)((i * 7919u) % 512u), y = (int)((i * 104729u) % 512u);
+		for (int z = 40; z < 56; z++)
+			map->Set(x, y, z, true, 0x64808080, true);
+	}
+
+	Handle<IImage> image{new NullImage(), false};
+	double maxPositionError = 0.0;
+	std::size_t maxCount = 0;
+
+	// The old local entity list
+	std::list<std::unique_ptr<ILocalEntity>> entities;
+	std::vector<Vector3> legacyPositions;
+	{
+		ExplosionGenerator generator{*image};
+		double spawnTime = 0.0, updateTime = 0.0;
+		std::size_t numSpawned = 0;
+		for (int frame = 0; frame < numFrames; frame++) {
+			Stopwatch sw;
+			if ((long)frame * numExplosions / numFrames !=
+			    (long)(frame + 1) * numExplosions / numFrames) {
+				generator.Generate([&](const ParticleSprite& p) {
+					entities.emplace_back(stmp::make_unique<LegacyParticle>(*map, p));
+					numSpawned++;
+				});
+			}
+			spawnTime += sw.GetTime();
+
+			sw.Reset();
+			for (auto it = entities.begin(); it != entities.end();) {
+				if (!(*it)->Update(dt))
+					it = entities.erase(it);
+				else
+					++it;
+			}
+			updateTime += sw.GetTime();
+			maxCount = std::max(maxCount, entities.size());
+		}
+		for (const auto& ent : entities)
+			legacyPositions.push_back(static_cast<LegacyParticle&>(*ent).state.position);
+
+		ctx.Report("entities.spawn", spawnTime * 1.0e9 / numSpawned, "ns/particle");
+		ctx.Report("entities.update", updateTime * 1000.0 / numFrames, "ms/frame");
+	}
+	entities.clear();
+
+	{
+		ParticleSystem particles;
+		ExplosionGenerator generator{*image};
+		double spawnTime = 0.0, updateTime = 0.0;
+		std::size_t numSpawned = 0;
+		for (int frame = 0; frame < numFrames; frame++) {
+			Stopwatch sw;
+			if ((long)frame * numExplosions / numFrames !=
+			    (long)(frame + 1) * numExplosions / numFrames) {
+				generator.Generate([&](const ParticleSprite& p) {
+					particles.AddSprite(p);
+					numSpawned++;
+				});
+			}
+			spawnTime += sw.GetTime();
+
+			sw.Reset();
+			particles.Update(dt, map.GetPointerOrNull());
+			updateTime += sw.GetTime();
+		}
+
+		ctx.Report("particleSystem.spawn", spawnTime * 1.0e9 / numSpawned, "ns/particle");
+		ctx.Report("particleSystem.update", updateTime * 1000.0 / numFrames, "ms/frame");
+
+		// Both should produce the same particles in the same order (unless the pool overflows)
+		ctx.Report("peakCount", (double)maxCount, "");
+		if (maxCount > ParticleSystem::MaxSprites)
+			ctx.Report("overflow", (double)(maxCount - ParticleSystem::MaxSprites), "");
+		ctx.Report("countMismatch",
+		           std::fabs((double)particles.GetNumSprites() - (double)legacyPositions.size()),
+		           "");
+		std::size_t count = std::min(particles.GetNumSprites(), legacyPositions.size());
+		for (std::size_t i = 0; i < count; i++) {
+			Vector3 diff = particles.GetSpritePosition(i) - legacyPositions[i];
+			maxPositionError = std::max(maxPositionError, (double)diff.GetLength());
+		}
+		ctx.Report("maxPositionError", maxPositionError, "");
+
+		// The pool drops new particles while it is full, which the entity list doesn't
+		if (maxCount <= ParticleSystem::MaxSprites &&
+		    (particles.GetNumSprites() != legacyPositions.size() || maxPositionError != 0.0)) {
+			SPRaise("ParticleSystem diverges from the entity update: %d vs %d particles, "
+			        "position error %f",
+			        static_cast<int>(particles.GetNumSprites()),
+			        static_cast<int>(legacyPositions.size()), maxPositionError);
+		}
+	}
+}
@@ -0,0 +1,178 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Core/DirectoryFileSystem.h>
+#include <Core/FileManager.h>
+#include <Core/IStream.h>
+#include <Core/MemoryStream.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+#include <Draw/RadiosityBaker.h>
+#include <Draw/RadiosityCache.h>
+
+using namespace spades;
+using namespace spades::client;
+using namespace spades::draw;
+
+SPADES_SETTING(r_radiosityCacheSize);
+
+namespace {
+	const int chunkVoxels =
+	  RadiosityBaker::ChunkSize * RadiosityBaker::ChunkSize * RadiosityBaker::ChunkSize;
+
+	/** Bakes a chunk with `RadiosityBaker::Evaluate`, one voxel at a time. */
+	void BakeChunkReference(const RadiosityBaker& baker, int cx, int cy, int cz,
+	                        RadiosityBaker::ChunkData& data) {
+		const int size = RadiosityBaker::ChunkSize;
+		for (int z = 0; z < size; z++)
+			for (int y = 0; y < size; y++)
+				for (int x = 0; x < size; x++) {
+					IntVector3 pos = IntVector3::Make(cx * size + x, cy * size + y, cz * size + z);
+					RadiosityBaker::Result res = baker.Evaluate(pos);
+					data.flat[z][y][x] = baker.EncodeValue(res.base);
+					data.x[z][y][x] = baker.EncodeValue(res.x);
+					data.y[z][y][x] = baker.EncodeValue(res.y);
+					data.z[z][y][x] = baker.EncodeValue(res.z);
+				}
+	}
+
+	int CountMismatches(const RadiosityBaker::ChunkData& a, const RadiosityBaker::ChunkData& b) {
+		const uint32_t* p = &a.flat[0][0][0];
+		const uint32_t* q = &b.flat[0][0][0];
+		int count = 0;
+		for (std::size_t i = 0; i < sizeof(a) / sizeof(uint32_t); i++)
+			if (p[i] != q[i])
+				count++;
+		return count;
+	}
+
+	void RunMap(bench::BenchmarkContext& ctx, const std::string& prefix, GameMap& map) {
+		int numSampleChunks = ctx.GetIntOption("chunks", 48);
+		bool full = ctx.GetIntOption("full", 0) != 0;
+		std::string cacheDir = ctx.GetOption("cacheDir", "");
+
+		Stopwatch sw;
+		std::vector<uint32_t> bitmap;
+		RadiosityBaker::GenerateShadowBitmap(map, bitmap);
+		ctx.Report(prefix + "shadowMap", sw.GetTime() * 1000.0, "ms");
+
+		const int chunkW = map.Width() / RadiosityBaker::ChunkSize;
+		const int chunkH = map.Height() / RadiosityBaker::ChunkSize;
+		const int chunkD = map.Depth() / RadiosityBaker::ChunkSize;
+
+		// Compare the SIMD bake with the reference on random chunks (with both encodings)
+		std::mt19937 rng{1};
+		double referenceTime = 0.0, bakeTime = 0.0;
+		int numMismatches = 0;
+		RadiosityBaker::ChunkData reference, baked;
+		for (int highPrecision = 0; highPrecision < 2; highPrecision++) {
+			RadiosityBaker baker{bitmap.data(), map.Width(), map.Height(), highPrecision != 0};
+			for (int i = 0; i < numSampleChunks; i++) {
+				int cx = (int)(rng() % chunkW), cy = (int)(rng() % chunkH);
+				int cz = (int)(rng() % chunkD);
+
+				sw.Reset();
+				BakeChunkReference(baker, cx, cy, cz, reference);
+				referenceTime += sw.GetTime();
+
+				sw.Reset();
+				baker.BakeChunk(cx, cy, cz, baked);
+				bakeTime += sw.GetTime();
+
+				numMismatches += CountMismatches(reference, baked);
+			}
+		}
+		double numVoxels = 2.0 * numSampleChunks * chunkVoxels;
+		ctx.Report(prefix + "reference", referenceTime * 1.0e9 / numVoxels, "ns/voxel");
+		ctx.Report(prefix + "bakeChunk", bakeTime * 1.0e9 / numVoxels, "ns/voxel");
+		ctx.Report(prefix + "mismatches", numMismatches, "voxels");
+
+		if (!full && cacheDir.empty())
+			return;
+
+		// The whole map, in parallel
+		RadiosityBaker baker{bitmap.data(), map.Width(), map.Height(), false};
+		std::vector<RadiosityBaker::ChunkData> chunks;
+		sw.Reset();
+		baker.BakeAll(map.Depth(), chunks);
+		ctx.Report(prefix + "bakeAll", sw.GetTime() * 1000.0, "ms");
+
+		if (cacheDir.empty())
+			return;
+
+		// Round trip through the cache
+		FileManager::PrependFileSystem(new DirectoryFileSystem(cacheDir, true));
+		uint32_t key = RadiosityCache::ComputeKey(bitmap, false);
+
+		std::vector<const RadiosityBaker::ChunkData*> source;
+		for (const auto& chunk : chunks)
+			source.push_back(&chunk);
+		sw.Reset();
+		RadiosityCache::Store(key, source);
+		ctx.Report(prefix + "cacheStore", sw.GetTime() * 1000.0, "ms");
+
+		std::vector<RadiosityBaker::ChunkData> loadedChunks(chunks.size());
+		std::vector<RadiosityBaker::ChunkData*> destination;
+		for (auto& chunk : loadedChunks)
+			destination.push_back(&chunk);
+		sw.Reset();
+		bool loaded = RadiosityCache::Load(key, destination);
+		ctx.Report(prefix + "cacheLoad", sw.GetTime() * 1000.0, "ms");
+
+		int numCacheMismatches = loaded ? 0 : -1;
+		for (std::size_t i = 0; loaded && i < chunks.size(); i++)
+			numCacheMismatches += CountMismatches(chunks[i], loadedChunks[i]);
+		ctx.Report(prefix + "cacheMismatches", numCacheMismatches, "voxels");
+
+		// With room for two entries, storing a third one evicts the one used least recently,
+		// even though the loaded one was stored first
+		char path[64];
+		std::sprintf(path, "RadiosityCache/%08x.rad", key);
+		uint64_t entrySize = FileManager::OpenForReading(path)->GetLength();
+		int oldCacheSize = r_radiosityCacheSize;
+		r_radiosityCacheSize = static_cast<int>((entrySize * 5 / 2) >> 20);
+		RadiosityCache::Store(key ^ 1, source);
+		RadiosityCache::Load(key, destination);
+		RadiosityCache::Store(key ^ 2, source);
+		r_radiosityCacheSize = oldCacheSize;
+
+		bool keptLoaded = FileManager::FileExists(path);
+		std::sprintf(path, "RadiosityCache/%08x.rad", key ^ 1);
+		bool keptUnused = FileManager::FileExists(path);
+		ctx.Report(prefix + "cacheKeptLoaded", keptLoaded ? 1 : 0, "");
+		if (!keptLoaded || keptUnused)
+			SPRaise("The radiosity cache didn't evict the least recently used entry");
+	}
+} // namespace
+
+SPADES_BENCHMARK(Radiosity, "Baking the radiosity of maps, per voxel vs SIMD chunks") {
+	for (const std::string& path : ctx.GetMapFiles()) {
+		std::string data = FileManager::ReadAllBytes(path.c_str());
+		MemoryStream stream{data.data(), data.size()};
+		Handle<GameMap> map{GameMap::Load(&stream), false};
+		RunMap(ctx, path + ".", *map);
+	}
+}
@@ -0,0 +1,231 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/IImage.h>
+#include <Client/IRenderer.h>
+#include <Client/SceneDefinition.h>
+#include <Core/Bitmap.h>
+#include <Core/CpuID.h>
+#include <Core/Exception.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+#include <Core/Strings.h>
+#include <Draw/SWFeatureLevel.h>
+#include <Draw/SWOffscreenPort.h>
+#include <Draw/SWRenderer.h>
+
+SPADES_SETTING(r_dlights);
+
+using namespace spades;
+using namespace spades::bench;
+using namespace spades::client;
+using draw::SWFeatureLevel;
+
+namespace {
+	struct Scene {
+		Handle<GameMap> map;
+		int width, height;
+		int numLights, numQuads, numFrames;
+	};
+
+	/** Pillars in front of the camera so that the depth buffer, fog and lights vary. */
+	Handle<GameMap> MakeMap() {
+		Handle<GameMap> map{new GameMap(), false};
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<int> coord(-48, 48);
+		std::uniform_int_distribution<std::uint32_t> color(0, 0xffffff);
+		for (int i = 0; i < 400; i++) {
+			int x = 256 + 8 + (coord(rng) + 48), y = 256 + coord(rng);
+			int top = 20 + (coord(rng) + 48) / 4;
+			std::uint32_t c = color(rng);
+			for (int z = top; z < 63; z++)
+				map->Set(x, y, z, true, c);
+		}
+		return map;
+	}
+
+	/** A texture with transparent, translucent and opaque texels. */
+	Handle<Bitmap> MakeQuadBitmap(std::mt19937& rng, int size) {
+		auto bmp = Handle<Bitmap>::New(size, size);
+		std::uniform_int_distribution<std::uint32_t> color(0, 0xffffff), alpha(0, 255);
+		for (int i = 0; i < size * size; i++) {
+			std::uint32_t a = i % 5 == 0 ? 0 : i % 5 == 1 ? 255 : alpha(rng);
+			bmp->GetPixels()[i] = color(rng) | a << 24;
+		}
+		return bmp;
+	}
+
+	Handle<Bitmap> RenderScene(const Scene& scene, SWFeatureLevel level, double& outTime) {
+		auto port = Handle<draw::SWOffscreenPort>::New(scene.width, scene.height);
+		auto renderer = Handle<draw::SWRenderer>::New(port.Cast<draw::SWPort>(), level);
+		renderer->Init();
+		renderer->SetGameMap(*scene.map);
+		renderer->SetFogColor(MakeVector3(0.5F, 0.6F, 0.8F));
+
+		std::mt19937 quadRng(3);
+		Handle<IImage> quadImages[] = {renderer->CreateImage(*MakeQuadBitmap(quadRng, 32)),
+		                               renderer->CreateImage(*MakeQuadBitmap(quadRng, 16))};
+		// drawn as solid quads by the SIMD levels. the scalar level doesn't support null
+		// images.
+		auto whiteBitmap = Handle<Bitmap>::New(4, 4);
+		std::fill_n(whiteBitmap->GetPixels(), 16, 0xffffffff);
+		auto whiteImage = renderer->CreateImage(*whiteBitmap);
+
+		float pitch = 0.3F;
+		SceneDefinition def;
+		def.viewportLeft = def.viewportTop = 0;
+		def.viewportWidth = scene.width;
+		def.viewportHeight = scene.height;
+		def.fovY = 1.2F;
+		def.fovX = 2.0F * std::atan(std::tan(def.fovY * 0.5F) * scene.width / scene.height);
+		def.viewOrigin = MakeVector3(250.5F, 256.5F, 30.5F);
+		def.viewAxis[0] = MakeVector3(0, 1, 0);
+		def.viewAxis[1] = MakeVector3(std::sin(pitch), 0, -std::cos(pitch));
+		def.viewAxis[2] = MakeVector3(std::cos(pitch), 0, std::sin(pitch));
+		def.zNear = 0.05F;
+		def.zFar = 130.0F;
+		def.skipWorld = false;
+
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+		Handle<Bitmap> result;
+		Stopwatch sw;
+		for (int frame = 0; frame < scene.numFrames; frame++) {
+			renderer->StartScene(def);
+			for (int i = 0; i < scene.numLights; i++) {
+				DynamicLightParam light;
+				light.origin = def.viewOrigin + MakeVector3(4.0F + unit(rng) * 40.0F,
+				                                            (unit(rng) - 0.5F) * 40.0F,
+				                                            unit(rng) * 20.0F);
+				light.radius = 4.0F + unit(rng) * 12.0F;
+				light.color = MakeVector3(unit(rng), unit(rng), unit(rng));
+				renderer->AddLight(light);
+			}
+			renderer->EndScene();
+
+			// textured and solid HUD quads over the world
+			for (int i = 0; i < scene.numQuads; i++) {
+				float x = unit(rng) * scene.width, y = unit(rng) * scene.height;
+				float w = 1.0F + unit(rng) * 200.0F, h = 1.0F + unit(rng) * 60.0F;
+				renderer->SetColorAlphaPremultiplied(
+				  MakeVector4(unit(rng), unit(rng), unit(rng), 1.0F) * unit(rng));
+				if (i % 4 == 0)
+					renderer->DrawImage(*whiteImage, AABB2(x, y, w, h));
+				else
+					renderer->DrawImage(*quadImages[i % 2], AABB2(x, y, w, h));
+			}
+
+			renderer->FrameDone();
+			if (frame == scene.numFrames - 1) {
+				outTime = sw.GetTime();
+				result = renderer->ReadBitmap();
+			}
+			renderer->Flip();
+		}
+
+		renderer->Shutdown();
+		return result;
+	}
+
+	/** Returns the largest difference of a color channel. */
+	int Compare(Bitmap& a, Bitmap& b, int& outNumMismatches) {
+		int maxDiff = 0;
+		outNumMismatches = 0;
+		std::size_t numPixels = static_cast<std::size_t>(a.GetWidth() * a.GetHeight());
+		for (std::size_t i = 0; i < numPixels; i++) {
+			std::uint32_t c1 = a.GetPixels()[i], c2 = b.GetPixels()[i];
+			if (c1 == c2)
+				continue;
+			outNumMismatches++;
+			for (int shift = 0; shift < 24; shift += 8) {
+				int d1 = static_cast<int>((c1 >> shift) & 0xff);
+				int d2 = static_cast<int>((c2 >> shift) & 0xff);
+				maxDiff = std::max(maxDiff, std::abs(d1 - d2));
+			}
+		}
+		return maxDiff;
+	}
+} // namespace
+
+SPADES_BENCHMARK(SWFeatureLevel, "Map, fog, lights and images of each SW renderer feature level") {
+	Scene scene;
+	scene.map = MakeMap();
+	scene.width = ctx.GetIntOption("width", 1280);
+	scene.height = ctx.GetIntOption("height", 720);
+	scene.numLights = ctx.GetIntOption("lights", 32);
+	scene.numQuads = ctx.GetIntOption("quads", 300);
+	scene.numFrames = ctx.GetIntOption("frames", 10);
+
+	std::string oldDlights = r_dlights;
+	r_dlights = 1;
+
+	double time = 0.0;
+	auto reference = RenderScene(scene, SWFeatureLevel::None, time);
+	ctx.Report("None.frame", time / scene.numFrames * 1.0e3, "ms");
+
+	// `tolerance` is the largest allowed channel difference, or -1 to only report it
+	std::string failure;
+	auto check = [&](const std::string& prefix, SWFeatureLevel level, Bitmap& expected,
+	                 int tolerance) {
+		auto image = RenderScene(scene, level, time);
+		ctx.Report(prefix + ".frame", time / scene.numFrames * 1.0e3, "ms");
+
+		int numMismatches;
+		int maxDiff = Compare(expected, *image, numMismatches);
+		ctx.Report(prefix + ".mismatchingPixels", numMismatches, "pixels");
+		ctx.Report(prefix + ".maxChannelDiff", maxDiff, "levels");
+		if (tolerance >= 0 && maxDiff > tolerance && failure.empty()) {
+			failure = Format("{0} differs from its reference by {1} levels in {2} pixels "
+			                 "(tolerance: {3})",
+			                 prefix, maxDiff, numMismatches, tolerance);
+		}
+		return image;
+	};
+
+#if ENABLE_SSE2
+	// Only informative: the SSE2 map renderer shades faces differently, and the SSE2 fog
+	// rounds its factor
+	auto sse2 = check("SSE2", SWFeatureLevel::SSE2, *reference, -1);
+#if ENABLE_AVX2
+	// AVX2 must match SSE2 exactly
+	if (CpuID().Supports(CpuFeature::AVX2))
+		check("AVX2", SWFeatureLevel::AVX2, *sse2, 0);
+	else
+		ctx.Report("AVX2.skipped", 1, "");
+#endif
+#endif
+#if ENABLE_NEON
+	// NEON mirrors the scalar math, but the compiler may fuse its multiply-adds
+	check("NEON", SWFeatureLevel::NEON, *reference, 2);
+#endif
+
+	r_dlights = oldDlights;
+
+	if (!failure.empty())
+		SPRaise("%s", failure.c_str());
+}
@@ -0,0 +1,175 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Client/IImage.h>
+#include <Client/SceneDefinition.h>
+#include <Core/Bitmap.h>
+#include <Core/Exception.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+#include <Draw/SWOffscreenPort.h>
+#include <Draw/SWRenderer.h>
+
+SPADES_SETTING(r_swDeferredImages);
+
+using namespace spades;
+using namespace spades::bench;
+using namespace spades::client;
+
+namespace {
+	Handle<Bitmap> MakeSpriteBitmap(std::mt19937& rng, int size) {
+		auto bmp = Handle<Bitmap>::New(size, size);
+		std::uniform_int_distribution<std::uint32_t> color(0, 0xffffff);
+		std::uint32_t base = color(rng);
+		float r = size * 0.5F;
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				// soft round blob, like the smoke and spark textures
+				float dx = (x + 0.5F - r) / r, dy = (y + 0.5F - r) / r;
+				float a = std::max(0.0F, 1.0F - std::sqrt(dx * dx + dy * dy));
+				auto alpha = static_cast<std::uint32_t>(a * 255.0F);
+				bmp->GetPixels()[x + y * size] = (base ^ (x * 0x10305)) | (alpha << 24);
+			}
+		}
+		return bmp;
+	}
+
+	struct Scene {
+		int width, height;
+		int numSprites, numQuads, numFrames;
+		unsigned int seed;
+	};
+
+	/**
+	 * Renders `scene.numFrames` frames of sprites and HUD quads and returns the last one.
+	 * Both modes see exactly the same draw calls.
+	 */
+	Handle<Bitmap> RenderScene(const Scene& scene, bool deferred, double& outTime) {
+		r_swDeferredImages = deferred ? 1 : 0;
+
+		auto port = Handle<draw::SWOffscreenPort>::New(scene.width, scene.height);
+		auto renderer = Handle<draw::SWRenderer>::New(port.Cast<draw::SWPort>());
+		renderer->Init();
+
+		std::mt19937 rng(scene.seed);
+		std::vector<Handle<IImage>> images;
+		for (int i = 0; i < 8; i++) {
+			images.push_back(renderer->CreateImage(*MakeSpriteBitmap(rng, 32)));
+		}
+		// updated mid-frame like the glyph atlas of a font
+		auto atlas = renderer->CreateImage(*MakeSpriteBitmap(rng, 64));
+		auto atlasPatch = MakeSpriteBitmap(rng, 16);
+
+		SceneDefinition def;
+		def.viewportLeft = def.viewportTop = 0;
+		def.viewportWidth = scene.width;
+		def.viewportHeight = scene.height;
+		def.fovY = 1.0F;
+		def.fovX = 2.0F * std::atan(std::tan(def.fovY * 0.5F) * scene.width / scene.height);
+		def.viewOrigin = MakeVector3(0, 0, 0);
+		def.viewAxis[0] = MakeVector3(1, 0, 0);
+		def.viewAxis[1] = MakeVector3(0, 0, -1);
+		def.viewAxis[2] = MakeVector3(0, 1, 0);
+		def.zNear = 0.05F;
+		def.zFar = 130.0F;
+		def.skipWorld = false;
+
+		std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+		Handle<Bitmap> result;
+		Stopwatch sw;
+		for (int frame = 0; frame < scene.numFrames; frame++) {
+			renderer->StartScene(def);
+			for (int i = 0; i < scene.numSprites; i++) {
+				float depth = 2.0F + unit(rng) * 60.0F;
+				Vector3 center = MakeVector3((unit(rng) - 0.5F) * depth * 1.2F, depth,
+				                             (unit(rng) - 0.5F) * depth * 0.7F);
+				renderer->SetColorAlphaPremultiplied(
+				  MakeVector4(unit(rng), unit(rng), unit(rng), 1.0F) * unit(rng));
+				renderer->AddSprite(*images[i % images.size()], center,
+				                    0.2F + unit(rng) * 3.0F, unit(rng) * 6.28F);
+			}
+			renderer->EndScene();
+
+			for (int i = 0; i < scene.numQuads; i++) {
+				float x = unit(rng) * scene.width, y = unit(rng) * scene.height;
+				float w = 4.0F + unit(rng) * 120.0F, h = 4.0F + unit(rng) * 40.0F;
+				renderer->SetColorAlphaPremultiplied(MakeVector4(1, 1, 1, 1) * unit(rng));
+				if (i % 7 == 0) {
+					renderer->DrawImage(nullptr, AABB2(x, y, w, h));
+				} else if (i % 3 == 0) {
+					renderer->DrawImage(*atlas, AABB2(x, y, w, h));
+				} else {
+					renderer->DrawImage(*images[i % images.size()], AABB2(x, y, w, h));
+				}
+				if (i == scene.numQuads / 2) {
+					atlas->Update(*atlasPatch, 16, 16);
+				}
+			}
+
+			renderer->FrameDone();
+			if (frame == scene.numFrames - 1) {
+				outTime = sw.GetTime();
+				result = renderer->ReadBitmap();
+			}
+			renderer->Flip();
+		}
+
+		renderer->Shutdown();
+		return result;
+	}
+} // namespace
+
+SPADES_BENCHMARK(SWImageRenderer, "Immediate vs. tile-binned deferred sprite rasterization") {
+	Scene scene;
+	scene.width = ctx.GetIntOption("width", 1280);
+	scene.height = ctx.GetIntOption("height", 720);
+	scene.numSprites = ctx.GetIntOption("sprites", 4000);
+	scene.numQuads = ctx.GetIntOption("quads", 1000);
+	scene.numFrames = ctx.GetIntOption("frames", 20);
+	scene.seed = static_cast<unsigned int>(ctx.GetIntOption("seed", 1));
+
+	std::string oldSetting = r_swDeferredImages;
+
+	double immediateTime = 0.0, deferredTime = 0.0;
+	auto immediate = RenderScene(scene, false, immediateTime);
+	auto deferred = RenderScene(scene, true, deferredTime);
+
+	r_swDeferredImages = oldSetting;
+
+	ctx.Report("immediate.frame", immediateTime / scene.numFrames * 1.0e3, "ms");
+	ctx.Report("deferred.frame", deferredTime / scene.numFrames * 1.0e3, "ms");
+
+	// binning must not change a single pixel
+	int numMismatches = 0;
+	std::size_t numPixels = static_cast<std::size_t>(scene.width * scene.height);
+	for (std::size_t i = 0; i < numPixels; i++) {
+		if (immediate->GetPixels()[i] != deferred->GetPixels()[i])
+			numMismatches++;
+	}
+	ctx.Report("mismatchingPixels", numMismatches, "pixels");
+	if (numMismatches != 0)
+		SPRaise("Deferred image rendering differs from immediate in %d pixels", numMismatches);
+}
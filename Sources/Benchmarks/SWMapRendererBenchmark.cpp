@@ -0,0 +1,246 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/IRenderer.h>
+#include <Client/SceneDefinition.h>
+#include <Core/Bitmap.h>
+#include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/MemoryStream.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+#include <Draw/SWOffscreenPort.h>
+#include <Draw/SWRenderer.h>
+
+SPADES_SETTING(r_swReprojection);
+SPADES_SETTING(r_swTargetFrameTime);
+SPADES_SETTING(r_swUndersampling);
+
+using namespace spades;
+using namespace spades::bench;
+using namespace spades::client;
+
+namespace {
+	enum class CameraPath {
+		/** Standing still. */
+		Still,
+		/** Looking around without moving. */
+		Turn,
+		/** Standing still while a wall in front of the camera is dug through. */
+		Dig,
+		/** Walking forward; nothing can be reprojected. */
+		Walk
+	};
+
+	struct Path {
+		const char* name;
+		CameraPath path;
+	};
+
+	SceneDefinition MakeCamera(CameraPath path, int frame, int width, int height) {
+		Vector3 eye = MakeVector3(256.5F, 256.5F, 20.5F);
+		float yaw = 0.3F, pitch = 0.15F;
+		switch (path) {
+			case CameraPath::Still:
+			case CameraPath::Dig: break;
+			case CameraPath::Turn:
+				yaw += frame * 0.02F;
+				pitch += std::sin(frame * 0.1F) * 0.1F;
+				break;
+			case CameraPath::Walk:
+				eye += MakeVector3(std::cos(yaw), std::sin(yaw), 0) * (frame * 0.15F);
+				break;
+		}
+
+		Vector3 front = MakeVector3(std::cos(yaw) * std::cos(pitch),
+		                            std::sin(yaw) * std::cos(pitch), std::sin(pitch));
+		Vector3 right = Vector3::Cross(front, MakeVector3(0, 0, -1)).Normalize();
+		Vector3 up = Vector3::Cross(right, front);
+
+		SceneDefinition def;
+		def.viewportLeft = def.viewportTop = 0;
+		def.viewportWidth = width;
+		def.viewportHeight = height;
+		def.fovY = 1.2F;
+		def.fovX = 2.0F * std::atan(std::tan(def.fovY * 0.5F) * width / height);
+		def.viewOrigin = eye;
+		def.viewAxis[0] = right;
+		def.viewAxis[1] = up;
+		def.viewAxis[2] = front;
+		def.zNear = 0.05F;
+		def.zFar = 130.0F;
+		def.skipWorld = false;
+		def.time = static_cast<unsigned int>(frame * 16);
+		return def;
+	}
+
+	Handle<draw::SWRenderer> MakeRenderer(GameMap& map, draw::SWOffscreenPort& port) {
+		auto renderer = Handle<draw::SWRenderer>::New(Handle<draw::SWPort>(port));
+		renderer->Init();
+		renderer->SetGameMap(map);
+		renderer->SetFogColor(MakeVector3(0.5F, 0.6F, 0.8F));
+		renderer->SetFogDistance(128.0F);
+		return renderer;
+	}
+
+	void RenderFrame(draw::SWRenderer& renderer, const SceneDefinition& def) {
+		renderer.StartScene(def);
+		renderer.EndScene();
+		renderer.FrameDone();
+		renderer.Flip();
+	}
+} // namespace
+
+SPADES_BENCHMARK(SWMapRenderer,
+                 "Map line reprojection and adaptive undersampling along camera paths") {
+	std::vector<std::string> maps = ctx.GetMapFiles();
+	std::string mapPath = ctx.GetOption("map", maps.empty() ? std::string() : maps.front());
+	if (mapPath.empty())
+		SPRaise("No map found");
+	std::string mapData = FileManager::ReadAllBytes(mapPath.c_str());
+	MemoryStream stream{mapData.data(), mapData.size()};
+	Handle<GameMap> map{GameMap::Load(&stream), false};
+
+	int width = ctx.GetIntOption("width", 1280);
+	int height = ctx.GetIntOption("height", 720);
+	int numFrames = ctx.GetIntOption("frames", 60);
+	int targetTime = ctx.GetIntOption("target", 12);
+
+	std::string oldReprojection = r_swReprojection;
+	std::string oldTargetTime = r_swTargetFrameTime;
+	std::string oldUndersampling = r_swUndersampling;
+	r_swTargetFrameTime = 0;
+	r_swUndersampling = 1;
+
+	// The same frames with and without reprojection, rendered in lockstep so that both
+	// renderers see the same map edits
+	const Path paths[] = {{"still", CameraPath::Still},
+	                      {"turn", CameraPath::Turn},
+	                      {"dig", CameraPath::Dig},
+	                      {"walk", CameraPath::Walk}};
+	for (const Path& path : paths) {
+		auto tracedPort = Handle<draw::SWOffscreenPort>::New(width, height);
+		auto reprojectedPort = Handle<draw::SWOffscreenPort>::New(width, height);
+		auto traced = MakeRenderer(*map, *tracedPort);
+		auto reprojected = MakeRenderer(*map, *reprojectedPort);
+
+		double tracedTime = 0.0, reprojectedTime = 0.0;
+		unsigned long long numLines = 0, numBuiltLines = 0;
+		long long numMismatches = 0, numBaselineMismatches = 0;
+		for (int frame = 0; frame < numFrames; frame++) {
+			SceneDefinition def = MakeCamera(path.path, frame, width, height);
+			if (path.path == CameraPath::Dig) {
+				// remove a voxel in the lower part of the view
+				Vector3 dir = def.viewAxis[2] - def.viewAxis[1] * 0.4F +
+				              def.viewAxis[0] * ((frame % 8) * 0.1F - 0.4F);
+				for (float t = 0.0F; t < 100.0F; t += 0.05F) {
+					IntVector3 p = (def.viewOrigin + dir * t).Floor();
+					if (map->IsSolidWrapped(p.x, p.y, p.z)) {
+						if (p.z < GameMap::DefaultDepth - 2)
+							map->Set(p.x & (map->Width() - 1), p.y & (map->Height() - 1), p.z, false,
+							         0);
+						break;
+					}
+				}
+			}
+
+			r_swReprojection = 0;
+			RenderFrame(*traced, def);
+			r_swReprojection = 1;
+			RenderFrame(*reprojected, def);
+
+			// A pixel's depth is off if it's further than 1% from the traced one. The
+			// reprojecting renderer traces its lines with margins, so they are sampled
+			// differently at silhouettes even when nothing is reused; the first frame, which
+			// has nothing to reproject, measures that
+			long long numDepthMismatches = 0;
+			const float* a = traced->GetDepthBuffer().data();
+			const float* b = reprojected->GetDepthBuffer().data();
+			for (int i = 0; i < width * height; i++) {
+				if (std::fabs(a[i] - b[i]) > a[i] * 0.01F)
+					numDepthMismatches++;
+			}
+			if (frame == 0) {
+				numBaselineMismatches = numDepthMismatches;
+				continue;
+			}
+			numMismatches += numDepthMismatches;
+
+			tracedTime += traced->GetLastFrameStatistics().map;
+			const auto& st = reprojected->GetLastFrameStatistics();
+			reprojectedTime += st.map;
+			numLines += st.mapLines;
+			numBuiltLines += st.mapLinesBuilt;
+		}
+		traced->Shutdown();
+		reprojected->Shutdown();
+
+		int numMeasured = std::max(numFrames - 1, 1);
+		std::string prefix = path.name;
+		ctx.Report(prefix + ".traced.map", tracedTime / numMeasured * 1.0e3, "ms");
+		ctx.Report(prefix + ".reprojected.map", reprojectedTime / numMeasured * 1.0e3, "ms");
+		ctx.Report(prefix + ".linesTraced",
+		           numLines ? static_cast<double>(numBuiltLines) / numLines * 100.0 : 0.0, "%");
+		double mismatches = static_cast<double>(numMismatches) / numMeasured / (width * height);
+		double baseline = static_cast<double>(numBaselineMismatches) / (width * height);
+		ctx.Report(prefix + ".depthMismatches", mismatches * 100.0, "%");
+		ctx.Report(prefix + ".baselineDepthMismatches", baseline * 100.0, "%");
+		if (mismatches > baseline + 0.01)
+			SPRaise("Reprojected depths of the %s path are off in %.2f%% of the pixels "
+			        "(%.2f%% without reprojection)",
+			        path.name, mismatches * 100.0, baseline * 100.0);
+	}
+
+	// Adaptive undersampling while walking, which defeats reprojection
+	{
+		r_swReprojection = 1;
+		r_swTargetFrameTime = targetTime;
+		auto port = Handle<draw::SWOffscreenPort>::New(width, height);
+		auto renderer = MakeRenderer(*map, *port);
+
+		double totalTime = 0.0;
+		int numOverTarget = 0, sumUndersampling = 0;
+		for (int frame = 0; frame < numFrames; frame++) {
+			Stopwatch sw;
+			RenderFrame(*renderer, MakeCamera(CameraPath::Walk, frame, width, height));
+			double time = sw.GetTime();
+			totalTime += time;
+			if (time * 1.0e3 > targetTime)
+				numOverTarget++;
+			sumUndersampling += renderer->GetLastFrameStatistics().mapUndersampling;
+		}
+		renderer->Shutdown();
+
+		ctx.Report("adaptive.frame", totalTime / numFrames * 1.0e3, "ms");
+		ctx.Report("adaptive.framesOverTarget", numOverTarget, "frames");
+		ctx.Report("adaptive.undersampling",
+		           static_cast<double>(sumUndersampling) / numFrames, "x");
+	}
+
+	r_swReprojection = oldReprojection;
+	r_swTargetFrameTime = oldTargetTime;
+	r_swUndersampling = oldUndersampling;
+}
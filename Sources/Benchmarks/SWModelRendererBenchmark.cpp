@@ -0,0 +1,176 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/IModel.h>
+#include <Client/IRenderer.h>
+#include <Client/SceneDefinition.h>
+#include <Core/Bitmap.h>
+#include <Core/Exception.h>
+#include <Core/Stopwatch.h>
+#include <Draw/SWFeatureLevel.h>
+#include <Draw/SWOffscreenPort.h>
+#include <Draw/SWRenderer.h>
+
+using namespace spades;
+using namespace spades::bench;
+using namespace spades::client;
+using draw::SWFeatureLevel;
+
+namespace {
+	struct Scene {
+		Handle<GameMap> map;
+		int width, height;
+		int numPlayers, numFrames;
+	};
+
+	struct Result {
+		Handle<Bitmap> image;
+		double frameTime;
+		double modelTime;
+	};
+
+	/**
+	 * A crowd of players in rows in front of the camera, turning around a bit more every
+	 * frame. The nearest rows cover the farther ones, so most voxels fail the depth test.
+	 */
+	Result RenderScene(const Scene& scene, SWFeatureLevel level) {
+		auto port = Handle<draw::SWOffscreenPort>::New(scene.width, scene.height);
+		auto renderer = Handle<draw::SWRenderer>::New(port.Cast<draw::SWPort>(), level);
+		renderer->Init();
+		renderer->SetGameMap(*scene.map);
+		// No visible fog, which rounds differently on each feature level
+		renderer->SetFogColor(MakeVector3(0, 0, 0));
+		renderer->SetFogDistance(1.0e5F);
+
+		const char* const modelNames[] = {"Models/Player/Torso.kv6", "Models/Player/Head.kv6",
+		                                  "Models/Player/Leg.kv6", "Models/Player/Arms.kv6"};
+		std::vector<Handle<IModel>> models;
+		for (const char* name : modelNames)
+			models.push_back(renderer->RegisterModel(name));
+
+		SceneDefinition def;
+		def.viewportLeft = def.viewportTop = 0;
+		def.viewportWidth = scene.width;
+		def.viewportHeight = scene.height;
+		def.fovY = 1.2F;
+		def.fovX = 2.0F * std::atan(std::tan(def.fovY * 0.5F) * scene.width / scene.height);
+		// Looking a bit up into the empty map, so that only the sky is behind the crowd:
+		// the map renderer's feature levels shade faces differently
+		float pitch = 0.35F;
+		def.viewOrigin = MakeVector3(240.5F, 256.5F, 20.0F);
+		def.viewAxis[0] = MakeVector3(0, 1, 0);
+		def.viewAxis[1] = MakeVector3(std::sin(pitch), 0, -std::cos(pitch));
+		def.viewAxis[2] = MakeVector3(std::cos(pitch), 0, -std::sin(pitch));
+		def.zNear = 0.05F;
+		def.zFar = 130.0F;
+		def.skipWorld = false;
+
+		const int playersPerRow = 8;
+		Result result;
+		result.frameTime = 0.0;
+		result.modelTime = 0.0;
+		for (int frame = 0; frame < scene.numFrames; frame++) {
+			Stopwatch sw;
+			renderer->StartScene(def);
+			for (int i = 0; i < scene.numPlayers; i++) {
+				int row = i / playersPerRow, column = i % playersPerRow;
+				Vector3 pos = def.viewOrigin +
+				              MakeVector3(2.5F + row * 1.5F,
+				                          (column - (playersPerRow - 1) * 0.5F) * 1.2F +
+				                            (row & 1) * 0.6F,
+				                          0.5F);
+				float yaw = static_cast<float>(i) * 0.7F + static_cast<float>(frame) * 0.05F;
+				Matrix4 body =
+				  Matrix4::Translate(pos) * Matrix4::Rotate(MakeVector3(0, 0, 1), yaw);
+
+				ModelRenderParam param;
+				param.customColor = MakeVector3((i & 1) ? 0.8F : 0.1F, 0.2F,
+				                                (i & 1) ? 0.1F : 0.8F);
+				for (std::size_t k = 0; k < models.size(); k++) {
+					param.matrix = body * Matrix4::Translate(0, 0, -0.6F * k) *
+					               Matrix4::Scale(0.1F);
+					renderer->RenderModel(*models[k], param);
+				}
+			}
+			renderer->EndScene();
+			renderer->FrameDone();
+			if (frame == scene.numFrames - 1)
+				result.image = renderer->ReadBitmap();
+			renderer->Flip();
+
+			// The first frame warms up the caches and the map renderer's state
+			if (frame == 0)
+				continue;
+			result.frameTime += sw.GetTime();
+			result.modelTime += renderer->GetLastFrameStatistics().models;
+		}
+
+		renderer->Shutdown();
+		int numMeasured = std::max(scene.numFrames - 1, 1);
+		result.frameTime /= numMeasured;
+		result.modelTime /= numMeasured;
+		return result;
+	}
+
+	int CountMismatches(Bitmap& a, Bitmap& b) {
+		int count = 0;
+		std::size_t numPixels = static_cast<std::size_t>(a.GetWidth() * a.GetHeight());
+		for (std::size_t i = 0; i < numPixels; i++) {
+			if (a.GetPixels()[i] != b.GetPixels()[i])
+				count++;
+		}
+		return count;
+	}
+} // namespace
+
+SPADES_BENCHMARK(SWModelRenderer, "Voxel model splatting of a crowd of players") {
+	Scene scene;
+	scene.map.Set(new GameMap(), false);
+	for (int x = 0; x < GameMap::DefaultWidth; x++)
+		for (int y = 0; y < GameMap::DefaultHeight; y++)
+			scene.map->Set(x, y, 0, false, 0);
+	scene.width = ctx.GetIntOption("width", 1280);
+	scene.height = ctx.GetIntOption("height", 720);
+	scene.numPlayers = ctx.GetIntOption("players", 64);
+	scene.numFrames = ctx.GetIntOption("frames", 30);
+
+	auto reference = RenderScene(scene, SWFeatureLevel::None);
+	ctx.Report("None.frame", reference.frameTime * 1.0e3, "ms");
+	ctx.Report("None.models", reference.modelTime * 1.0e3, "ms");
+
+#if ENABLE_SSE2
+	// SSE2 must match the scalar path exactly
+	auto sse2 = RenderScene(scene, SWFeatureLevel::SSE2);
+	ctx.Report("SSE2.frame", sse2.frameTime * 1.0e3, "ms");
+	ctx.Report("SSE2.models", sse2.modelTime * 1.0e3, "ms");
+	int numMismatches = CountMismatches(*reference.image, *sse2.image);
+	ctx.Report("SSE2.mismatchingPixels", numMismatches, "pixels");
+	if (numMismatches != 0)
+		SPRaise("SSE2 model rendering differs from the scalar path in %d pixels",
+		        numMismatches);
+#endif
+}
@@ -0,0 +1,236 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Client/GameMap.h>
+#include <Client/IModel.h>
+#include <Client/IRenderer.h>
+#include <Client/SceneDefinition.h>
+#include <Core/Bitmap.h>
+#include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/MemoryStream.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+#include <Draw/SWOffscreenPort.h>
+#include <Draw/SWRenderer.h>
+
+SPADES_SETTING(r_dlights);
+
+using namespace spades;
+using namespace spades::bench;
+using namespace spades::client;
+
+namespace {
+	/** Returns the Z coordinate of the topmost solid voxel of a column. */
+	int GetGroundZ(GameMap& map, int x, int y) {
+		for (int z = 0; z < GameMap::DefaultDepth - 1; z++) {
+			if (map.IsSolid(x, y, z))
+				return z;
+		}
+		return GameMap::DefaultDepth - 1;
+	}
+
+	/**
+	 * The camera flies a circle around the middle of the map, looking slightly down
+	 * towards the center, so every frame sees a different mix of near and far terrain.
+	 */
+	SceneDefinition MakeCamera(int frame, int numFrames, int width, int height) {
+		float angle = static_cast<float>(frame) / static_cast<float>(numFrames) * M_PI_F * 2.0F;
+		Vector3 center = MakeVector3(256.0F, 256.0F, 40.0F);
+		Vector3 eye = MakeVector3(256.0F + std::cos(angle) * 96.0F,
+		                          256.0F + std::sin(angle) * 96.0F, 20.0F);
+
+		Vector3 front = (center - eye).Normalize();
+		Vector3 right = Vector3::Cross(front, MakeVector3(0, 0, -1)).Normalize();
+		Vector3 up = Vector3::Cross(right, front);
+
+		SceneDefinition def;
+		def.viewportLeft = def.viewportTop = 0;
+		def.viewportWidth = width;
+		def.viewportHeight = height;
+		def.fovY = 1.2F;
+		def.fovX = 2.0F * std::atan(std::tan(def.fovY * 0.5F) * width / height);
+		def.viewOrigin = eye;
+		def.viewAxis[0] = right;
+		def.viewAxis[1] = up;
+		def.viewAxis[2] = front;
+		def.zNear = 0.05F;
+		def.zFar = 130.0F;
+		def.skipWorld = false;
+		def.time = static_cast<unsigned int>(frame * 16);
+		return def;
+	}
+
+	Handle<Bitmap> MakeSpriteBitmap(int size) {
+		auto bmp = Handle<Bitmap>::New(size, size);
+		float r = size * 0.5F;
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				float dx = (x + 0.5F - r) / r, dy = (y + 0.5F - r) / r;
+				float a = std::max(0.0F, 1.0F - std::sqrt(dx * dx + dy * dy));
+				auto alpha = static_cast<std::uint32_t>(a * 255.0F);
+				bmp->GetPixels()[x + y * size] = 0xffffffU | (alpha << 24);
+			}
+		}
+		return bmp;
+	}
+
+	struct Stage {
+		const char* name;
+		double draw::SWRenderer::FrameStatistics::*field;
+	};
+} // namespace
+
+SPADES_BENCHMARK(SWRenderer, "CPU-only frames of a map flythrough through an offscreen port") {
+	std::vector<std::string> maps = ctx.GetMapFiles();
+	std::string mapPath = ctx.GetOption("map", maps.empty() ? std::string() : maps.front());
+	if (mapPath.empty())
+		SPRaise("No map found");
+	std::string mapData = FileManager::ReadAllBytes(mapPath.c_str());
+	MemoryStream stream{mapData.data(), mapData.size()};
+	Handle<GameMap> map{GameMap::Load(&stream), false};
+
+	int width = ctx.GetIntOption("width", 1280);
+	int height = ctx.GetIntOption("height", 720);
+	int numFrames = ctx.GetIntOption("frames", 60);
+	int numPlayers = ctx.GetIntOption("players", 16);
+	int numSprites = ctx.GetIntOption("sprites", 300);
+	int numLights = ctx.GetIntOption("lights", 8);
+	int numImages = ctx.GetIntOption("images", 200);
+
+	std::string oldDlights = r_dlights;
+	r_dlights = 1;
+
+	auto port = Handle<draw::SWOffscreenPort>::New(width, height);
+	auto renderer = Handle<draw::SWRenderer>::New(port.Cast<draw::SWPort>());
+	renderer->Init();
+	renderer->SetGameMap(*map);
+	renderer->SetFogColor(MakeVector3(0.5F, 0.6F, 0.8F));
+	renderer->SetFogDistance(128.0F);
+
+	// Players standing around the middle of the map
+	const char* const modelNames[] = {"Models/Player/Torso.kv6", "Models/Player/Head.kv6",
+	                                  "Models/Player/Leg.kv6", "Models/Player/Arms.kv6"};
+	std::vector<Handle<IModel>> models;
+	for (const char* name : modelNames)
+		models.push_back(renderer->RegisterModel(name));
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+	std::vector<Vector3> playerPositions;
+	for (int i = 0; i < numPlayers; i++) {
+		int x = 256 + static_cast<int>((unit(rng) - 0.5F) * 64.0F);
+		int y = 256 + static_cast<int>((unit(rng) - 0.5F) * 64.0F);
+		playerPositions.push_back(MakeVector3(x + 0.5F, y + 0.5F, GetGroundZ(*map, x, y) - 1.5F));
+	}
+
+	auto spriteImage = renderer->CreateImage(*MakeSpriteBitmap(32));
+	auto hudImage = renderer->CreateImage(*MakeSpriteBitmap(64));
+
+	// The first frames warm up the caches and the map renderer's state
+	int numWarmupFrames = std::min(5, numFrames);
+	std::vector<double> frameTimes;
+	draw::SWRenderer::FrameStatistics total;
+	for (int frame = -numWarmupFrames; frame < numFrames; frame++) {
+		std::mt19937 frameRng(static_cast<unsigned int>(frame + numWarmupFrames));
+		Stopwatch sw;
+
+		renderer->StartScene(MakeCamera(std::max(frame, 0), numFrames, width, height));
+		for (const Vector3& pos : playerPositions) {
+			for (std::size_t i = 0; i < models.size(); i++) {
+				ModelRenderParam param;
+				param.matrix = Matrix4::Translate(pos + MakeVector3(0, 0, -0.6F * i)) *
+				               Matrix4::Scale(0.1F);
+				renderer->RenderModel(*models[i], param);
+			}
+		}
+		for (int i = 0; i < numSprites; i++) {
+			// smoke and debris around the players
+			const Vector3& pos = playerPositions[i % playerPositions.size()];
+			Vector3 offset = MakeVector3(unit(frameRng) - 0.5F, unit(frameRng) - 0.5F,
+			                             -unit(frameRng)) * 6.0F;
+			renderer->SetColorAlphaPremultiplied(MakeVector4(0.6F, 0.6F, 0.6F, 1.0F) * 0.5F);
+			renderer->AddSprite(*spriteImage, pos + offset, 0.5F + unit(frameRng) * 2.0F,
+			                    unit(frameRng) * 6.28F);
+		}
+		for (int i = 0; i < numLights; i++) {
+			DynamicLightParam light;
+			light.origin = playerPositions[i % playerPositions.size()] + MakeVector3(0, 0, -2);
+			light.radius = 8.0F;
+			light.color = MakeVector3(1.0F, 0.8F, 0.5F);
+			renderer->AddLight(light);
+		}
+		renderer->EndScene();
+
+		// HUD
+		for (int i = 0; i < numImages; i++) {
+			float x = unit(frameRng) * width, y = unit(frameRng) * height;
+			renderer->SetColorAlphaPremultiplied(MakeVector4(1, 1, 1, 1) * 0.7F);
+			renderer->DrawImage(*hudImage, AABB2(x, y, 8.0F + unit(frameRng) * 64.0F,
+			                                     8.0F + unit(frameRng) * 32.0F));
+		}
+		renderer->FrameDone();
+		renderer->Flip();
+
+		if (frame < 0)
+			continue;
+		frameTimes.push_back(sw.GetTime());
+
+		const auto& st = renderer->GetLastFrameStatistics();
+		total.map += st.map;
+		total.models += st.models;
+		total.lights += st.lights;
+		total.fog += st.fog;
+		total.sprites += st.sprites;
+		total.images += st.images;
+	}
+
+	renderer->Shutdown();
+	r_dlights = oldDlights;
+
+	if (frameTimes.empty())
+		return;
+
+	double sum = 0.0;
+	for (double t : frameTimes)
+		sum += t;
+	std::sort(frameTimes.begin(), frameTimes.end());
+	ctx.Report("frame.mean", sum / frameTimes.size() * 1.0e3, "ms");
+	ctx.Report("frame.p95", frameTimes[frameTimes.size() * 95 / 100] * 1.0e3, "ms");
+
+	const Stage stages[] = {{"map", &draw::SWRenderer::FrameStatistics::map},
+	                        {"models", &draw::SWRenderer::FrameStatistics::models},
+	                        {"lights", &draw::SWRenderer::FrameStatistics::lights},
+	                        {"fog", &draw::SWRenderer::FrameStatistics::fog},
+	                        {"sprites", &draw::SWRenderer::FrameStatistics::sprites},
+	                        {"images", &draw::SWRenderer::FrameStatistics::images}};
+	for (const Stage& stage : stages) {
+		ctx.Report(std::string("stage.") + stage.name,
+		           total.*(stage.field) / frameTimes.size() * 1.0e3, "ms");
+	}
+	ctx.Report("frames", port->GetNumSwaps(), "frames");
+}
@@ -0,0 +1,202 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include <Audio/SoftMixer.h>
+#include <Audio/SoftReverb.h>
+#include <Core/Stopwatch.h>
+
+using namespace spades;
+using namespace spades::audio;
+
+namespace {
+	constexpr int SamplingRate = 44100;
+	/** The size of the callback buffer of the audio device. */
+	constexpr std::size_t CallbackSize = 512;
+
+	/** A decaying noise burst mixed with a tone, like a gunshot or a footstep. */
+	std::shared_ptr<SoftSample> MakeSample(float length, float frequency, unsigned seed) {
+		std::mt19937 rng{seed};
+		std::uniform_real_distribution<float> noise{-1.0F, 1.0F};
+		std::vector<float> frames((std::size_t)(length * 22050.0F));
+		for (std::size_t i = 0; i < frames.size(); i++) {
+			float t = (float)i / 22050.0F;
+			float tone = std::sin(t * frequency * 2.0F * M_PI_F);
+			frames[i] = (noise(rng) * 0.5F + tone * 0.5F) * std::exp(-t * 4.0F / length);
+		}
+		return SoftSample::Create(frames.data(), frames.size(), 1, 22050);
+	}
+
+	struct Scenario {
+		int numVoices;
+		/** The sounds started per 60 Hz tick. */
+		int playsPerTick;
+		bool reverb;
+		float seconds;
+	};
+
+	/** Renders `scenario` offline and returns the output. */
+	std::vector<float> Render(const Scenario& scenario, SoftMixer::Statistics& stats,
+	                          double& elapsed) {
+		std::vector<std::shared_ptr<SoftSample>> samples;
+		for (unsigned i = 0; i < 8; i++)
+			samples.push_back(MakeSample(0.3F + (float)i * 0.25F, 200.0F + (float)i * 90.0F, i));
+
+		SoftMixer mixer{SamplingRate, (std::size_t)scenario.numVoices};
+		mixer.SetListener(MakeVector3(256.0F, 256.0F, 30.0F), MakeVector3(0.0F, 1.0F, 0.0F),
+		                  MakeVector3(0.0F, 0.0F, -1.0F));
+		if (scenario.reverb) {
+			SoftReverb::Param param;
+			param.decayTime = 1.2F;
+			param.gain = 0.25F;
+			mixer.SetReverb(param);
+		}
+
+		std::mt19937 rng{1};
+		std::uniform_real_distribution<float> offset{-40.0F, 40.0F};
+		std::uniform_real_distribution<float> pitch{0.8F, 1.25F};
+
+		std::size_t numFrames = (std::size_t)(scenario.seconds * (float)SamplingRate);
+		std::vector<float> output(numFrames * 2);
+		std::size_t framesPerTick = SamplingRate / 60;
+		std::size_t nextTick = 0;
+
+		Stopwatch sw;
+		for (std::size_t pos = 0; pos < numFrames; pos += CallbackSize) {
+			// The game thread, interleaved with the audio callback
+			while (nextTick <= pos) {
+				for (int i = 0; i < scenario.playsPerTick; i++) {
+					SoftMixer::PlayParam param;
+					param.mode = SoftMixer::Mode::Absolute;
+					param.origin = MakeVector3(256.0F + offset(rng), 256.0F + offset(rng), 30.0F);
+					param.pitch = pitch(rng);
+					mixer.Play(samples[rng() % samples.size()], param);
+				}
+				nextTick += framesPerTick;
+			}
+			mixer.Render(&output[pos * 2], std::min(CallbackSize, numFrames - pos));
+		}
+		elapsed = sw.GetTime();
+		stats = mixer.GetStatistics();
+		return output;
+	}
+
+	void RunScenario(bench::BenchmarkContext& ctx, const std::string& name,
+	                 const Scenario& scenario) {
+		SoftMixer::Statistics stats;
+		double elapsed;
+		std::vector<float> output = Render(scenario, stats, elapsed);
+
+		ctx.Report(name + ".realtimeFactor", scenario.seconds / elapsed, "x");
+		ctx.Report(name + ".blockTime",
+		           elapsed * 1.0e6 / (double)std::max<std::uint64_t>(stats.numRenderedBlocks, 1),
+		           "us/block");
+		ctx.Report(name + ".stolen", (double)stats.numStolenVoices, "voices");
+		ctx.Report(name + ".dropped", (double)stats.numDroppedVoices, "voices");
+
+		double power = 0.0;
+		for (float sample : output)
+			power += (double)sample * (double)sample;
+		ctx.Report(name + ".rms", std::sqrt(power / (double)output.size()), "");
+
+		// The output must not depend on the timing or the number of threads
+		SoftMixer::Statistics stats2;
+		std::vector<float> output2 = Render(scenario, stats2, elapsed);
+		std::size_t numMismatches = 0;
+		for (std::size_t i = 0; i < output.size(); i++)
+			if (output[i] != output2[i])
+				numMismatches++;
+		ctx.Report(name + ".mismatches", (double)numMismatches, "samples");
+	}
+} // namespace
+
+SPADES_BENCHMARK(SoftMixer, "Offline rendering of the built-in mixer through a null sink") {
+	Scenario scenario;
+	scenario.numVoices = ctx.GetIntOption("voices", 64);
+	scenario.playsPerTick = ctx.GetIntOption("plays", 2);
+	scenario.reverb = false;
+	scenario.seconds = (float)ctx.GetIntOption("seconds", 10);
+
+	RunScenario(ctx, "dry", scenario);
+
+	scenario.reverb = true;
+	RunScenario(ctx, "reverb", scenario);
+
+	// Four times as many sounds as the pool can hold
+	scenario.playsPerTick *= 4;
+	RunScenario(ctx, "overload", scenario);
+
+	// Latency: the time from `Play` to the first audible frame, with the mixer's block
+	// boundary at a random phase relative to the callback
+	{
+		auto click = MakeSample(0.05F, 1000.0F, 42);
+		SoftMixer mixer{SamplingRate, 16};
+		std::vector<float> buffer(CallbackSize * 2);
+		double totalLatency = 0.0;
+		const int numTrials = 64;
+		for (int trial = 0; trial < numTrials; trial++) {
+			// Render a few frames to shift the block phase
+			mixer.Render(buffer.data(), (std::size_t)(trial * 37) % CallbackSize + 1);
+			mixer.Play(click, SoftMixer::PlayParam());
+			std::size_t latency = 0;
+			bool found = false;
+			while (!found && latency < (std::size_t)SamplingRate) {
+				mixer.Render(buffer.data(), CallbackSize);
+				for (std::size_t i = 0; i < CallbackSize && !found; i++) {
+					if (buffer[i * 2] != 0.0F)
+						found = true;
+					else
+						latency++;
+				}
+			}
+			totalLatency += (double)latency;
+
+			// Let the click and the limiter settle
+			for (int i = 0; i < 16; i++)
+				mixer.Render(buffer.data(), CallbackSize);
+		}
+		ctx.Report("latency", totalLatency / numTrials * 1000.0 / SamplingRate, "ms");
+		ctx.Report("latency.callback", (double)CallbackSize * 1000.0 / SamplingRate, "ms");
+	}
+
+	// The cost of the reverb alone, with the longest impulse response
+	{
+		SoftReverb reverb{SamplingRate};
+		SoftReverb::Param param;
+		param.decayTime = SoftReverb::MaxLength;
+		param.gain = 0.3F;
+
+		Stopwatch sw;
+		reverb.SetResponse(reverb.CreateResponse(param));
+		ctx.Report("reverb.build", sw.GetTime() * 1.0e3, "ms");
+
+		std::vector<float> input(SoftReverb::BlockSize, 0.5F);
+		std::vector<float> left(SoftReverb::BlockSize), right(SoftReverb::BlockSize);
+		const int numBlocks = 2000;
+		sw.Reset();
+		for (int i = 0; i < numBlocks; i++)
+			reverb.Process(input.data(), left.data(), right.data());
+		ctx.Report("reverb.process", sw.GetTime() * 1.0e6 / numBlocks, "us/block");
+	}
+}
@@ -0,0 +1,113 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "Benchmark.h"
+#include <Core/ConcurrentDispatch.h>
+#include <Core/Stopwatch.h>
+#include <Core/ThreadPool.h>
+
+using namespace spades;
+
+namespace {
+	/** The `InvokeParallel2` implementation prior to `ThreadPool`. */
+	template <class F> void InvokeWithConcurrentDispatch(F f, unsigned int numThreads) {
+		std::array<std::unique_ptr<ConcurrentDispatch>, 32> disp;
+		for (auto i = 1U; i < numThreads; i++) {
+			auto ff = [i, &f, numThreads]() { f(i, numThreads); };
+			disp[i] = std::unique_ptr<ConcurrentDispatch>(
+			  static_cast<ConcurrentDispatch*>(new FunctionDispatch<decltype(ff)>(ff)));
+			disp[i]->Start();
+		}
+		f(0, numThreads);
+		for (auto i = 1U; i < numThreads; i++)
+			disp[i]->Join();
+	}
+
+	template <class F> void InvokeWithThreadPool(F f, unsigned int numThreads) {
+		ParallelFor(numThreads, 1, [&f, numThreads](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; i++)
+				f(static_cast<unsigned int>(i), numThreads);
+		});
+	}
+} // namespace
+
+SPADES_BENCHMARK(ThreadPoolDispatch, "Per-call overhead of InvokeParallel2-style dispatch") {
+	int numIterations = ctx.GetIntOption("iterations", 20000);
+	unsigned int numParts = static_cast<unsigned int>(ctx.GetIntOption("parts", 4));
+	// SWRenderer dispatches fog, map line building, map rendering and dynamic lights
+	const int callsPerFrame = 5;
+
+	ctx.Report("participants", ThreadPool::GetInstance().GetNumParticipants(), "threads");
+
+	std::atomic<unsigned int> sink{0};
+	auto emptyTask = [&](unsigned int i, unsigned int) {
+		sink.fetch_add(i, std::memory_order_relaxed);
+	};
+
+	Stopwatch sw;
+	for (int i = 0; i < numIterations; ++i)
+		InvokeWithConcurrentDispatch(emptyTask, numParts);
+	double oldTime = sw.GetTime() / numIterations;
+	ctx.Report("concurrentDispatch.perCall", oldTime * 1.0e6, "us");
+	ctx.Report("concurrentDispatch.perFrame", oldTime * callsPerFrame * 1.0e6, "us");
+
+	sw.Reset();
+	for (int i = 0; i < numIterations; ++i)
+		InvokeWithThreadPool(emptyTask, numParts);
+	double newTime = sw.GetTime() / numIterations;
+	ctx.Report("threadPool.perCall", newTime * 1.0e6, "us");
+	ctx.Report("threadPool.perFrame", newTime * callsPerFrame * 1.0e6, "us");
+
+	// Fine-grained loop with stealing
+	std::size_t count = static_cast<std::size_t>(ctx.GetIntOption("count", 1 << 20));
+	auto fineLoop = [&] {
+		ParallelFor(count, 4096, [&](std::size_t begin, std::size_t end) {
+			unsigned int local = 0;
+			for (std::size_t k = begin; k < end; k++)
+				local += static_cast<unsigned int>(k * k);
+			sink.fetch_add(local, std::memory_order_relaxed);
+		});
+	};
+	sw.Reset();
+	for (int i = 0; i < numIterations / 100; ++i)
+		fineLoop();
+	ctx.Report("threadPool.parallelFor", sw.GetTime() / (numIterations / 100) * 1.0e3, "ms");
+
+	// The same loop submitted by two threads at once, like the renderer and the radiosity
+	// baker. Each submitter helps the other's loop while waiting for its turn
+	sw.Reset();
+	{
+		auto otherThread = [&] {
+			for (int i = 0; i < numIterations / 100; ++i)
+				fineLoop();
+		};
+		FunctionDispatch<decltype(otherThread)> other{otherThread};
+		other.Start();
+		for (int i = 0; i < numIterations / 100; ++i)
+			fineLoop();
+		other.Join();
+	}
+	ctx.Report("threadPool.contendedParallelFor",
+	           sw.GetTime() / (numIterations / 100 * 2) * 1.0e3, "ms");
+}
@@ -0,0 +1,91 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <atomic>
+#include <string>
+
+#include "Benchmark.h"
+#include <Core/DynamicMemoryStream.h>
+#include <Core/Stopwatch.h>
+#include <Core/ThreadPool.h>
+#include <Core/TraceProfiler.h>
+#include <json/json.h>
+
+using namespace spades;
+using namespace spades::bench;
+
+namespace {
+	std::atomic<unsigned int> sink{0};
+
+	/** Nested zones as cheap as possible so that the profiler's own cost dominates. */
+	void RunZones(int numIterations) {
+		for (int i = 0; i < numIterations; i++) {
+			SPADES_TRACE_ZONE("Outer");
+			{
+				SPADES_TRACE_ZONE("Inner");
+				sink.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+} // namespace
+
+SPADES_BENCHMARK(TraceProfiler, "Cost of trace zones and saving a Chrome trace") {
+	int numIterations = ctx.GetIntOption("iterations", 1000000);
+	int numZones = numIterations * 2;
+
+	Stopwatch sw;
+	RunZones(numIterations);
+	ctx.Report("idle.perZone", sw.GetTime() / numZones * 1.0e9, "ns");
+
+	trace::Start();
+	sw.Reset();
+	RunZones(numIterations);
+	ctx.Report("recording.perZone", sw.GetTime() / numZones * 1.0e9, "ns");
+
+	// All workers record at once, as the software renderer's parts do
+	std::size_t numParts = ThreadPool::GetInstance().GetNumParticipants();
+	sw.Reset();
+	ParallelFor(numParts, 1, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; i++)
+			RunZones(numIterations / static_cast<int>(numParts));
+	});
+	ctx.Report("recordingParallel.perZone", sw.GetTime() / numZones * 1.0e9, "ns");
+	trace::Stop();
+
+	DynamicMemoryStream stream;
+	sw.Reset();
+	trace::Save(stream);
+	ctx.Report("save", sw.GetTime() * 1.0e3, "ms");
+	ctx.Report("traceSize", (double)stream.GetLength() / (1024.0 * 1024.0), "MiB");
+
+	// Make sure the output is a valid trace
+	stream.SetPosition(0);
+	std::string json = stream.Read(static_cast<std::size_t>(stream.GetLength()));
+	Json::Value root;
+	Json::Reader reader;
+	int numEvents = 0;
+	if (reader.parse(json, root, false)) {
+		for (const Json::Value& event : root["traceEvents"]) {
+			if (event["ph"].asString() == "X")
+				numEvents++;
+		}
+	}
+	ctx.Report("savedZones", numEvents, "zones");
+}
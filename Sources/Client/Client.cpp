@@ -29,6 +29,7 @@
 #include <Core/IStream.h>
 #include <Core/Settings.h>
 #include <Core/Strings.h>
+#include <Core/TraceProfiler.h>
 
 #include "IAudioChunk.h"
 #include "IAudioDevice.h"
@@ -46,7 +47,7 @@
 
 #include "BloodMarks.h"
 #include "Corpse.h"
-#include "SmokeSpriteEntity.h"
+#include "ParticleSystem.h"
 
 #include "GameMap.h"
 #include "Weapon.h"
@@ -62,6 +63,7 @@ DEFINE_SPADES_SETTING(cg_skipDeadPlayersWhenDead, "1");
 DEFINE_SPADES_SETTING(cg_ignorePrivateMessages, "0");
 DEFINE_SPADES_SETTING(cg_ignoreChatMessages, "0");
 DEFINE_SPADES_SETTING(cg_smallFont, "0");
+DEFINE_SPADES_SETTING(cg_recordDemo, "0");
 
 SPADES_SETTING(cg_playerName);
 SPADES_SETTING(cg_centerMessageSmallFont);
@@ -86,7 +88,6 @@ namespace spades {
 		      timeSinceInit(0.0F),
 		      hasLastTool(false),
 		      lastPosSentTime(0.0F),
-		      lastOriSentTime(0.0F),
 		      lastAliveTime(0.0F),
 		      lastRespawnCount(0),
 		      lastHitTime(0.0F),
@@ -154,6 +155,7 @@ namespace spades {
 				audioDev.GetPointerOrNull(), fontManager.GetPointerOrNull(), this);
 
 			bloodMarks = stmp::make_unique<BloodMarks>(*this);
+			particles = stmp::make_unique<ParticleSystem>();
 
 			renderer->SetGameMap(nullptr);
 		}
@@ -266,7 +268,7 @@ namespace spades {
 		/** Initiate an initialization which likely to take some time */
 		void Client::DoInit() {
 			renderer->Init();
-			SmokeSpriteEntity::Preload(renderer.GetPointerOrNull());
+			particles->Preload(*renderer);
 
 			// load images
 			renderer->RegisterImage("Gfx/Bullet/7.62mm.png");
@@ -440,10 +442,21 @@ namespace spades {
 			} catch (const std::exception& ex) {
 				SPLog("Failed to open netlog file '%s' (%s)", logFn.c_str(), ex.what());
 			}
+
+			if (cg_recordDemo) {
+				const std::string demoFn = "Demos/" + fn2 + ".demo";
+				try {
+					net->StartRecording(FileManager::OpenForWriting(demoFn.c_str()));
+					SPLog("Demo recording started at '%s'", demoFn.c_str());
+				} catch (const std::exception& ex) {
+					SPLog("Failed to open demo file '%s' (%s)", demoFn.c_str(), ex.what());
+				}
+			}
 		}
 
 		void Client::RunFrame(float dt) {
 			SPADES_MARK_FUNCTION();
+			SPADES_TRACE_ZONE("Client::RunFrame");
 
 			fpsCounter.MarkFrame();
 
@@ -28,6 +28,7 @@
 
 #include "ClientCameraMode.h"
 #include "ILocalEntity.h"
+#include "INetClientListener.h"
 #include "IRenderer.h"
 #include "IWorldListener.h"
 #include "MumbleLink.h"
@@ -66,9 +67,10 @@ namespace spades {
 		class TCProgressView;
 		class ClientPlayer;
 		class BloodMarks;
+		class ParticleSystem;
 		class ClientUI;
 
-		class Client : public IWorldListener, public gui::View {
+		class Client : public IWorldListener, public INetClientListener, public gui::View {
 			friend class ScoreboardView;
 			friend class LimboView;
 			friend class MapView;
@@ -150,7 +152,6 @@ namespace spades {
 			Vector3 lastPosSent;
 			Vector3 lastFrontSent;
 			float lastPosSentTime;
-			float lastOriSentTime;
 			float lastHurtTime;
 			float lastAliveTime;
 			int lastRespawnCount;
@@ -363,6 +364,7 @@ namespace spades {
 			float mapReceivingProgressSmoothed = 0.0F;
 
 			std::list<std::unique_ptr<ILocalEntity>> localEntities;
+			std::unique_ptr<ParticleSystem> particles;
 			std::list<std::unique_ptr<Corpse>> corpses;
 			Corpse* lastLocalCorpse;
 			unsigned int corpseSoftLimit;
@@ -482,13 +484,14 @@ namespace spades {
 			Handle<gui::ConsoleCommandCandidateIterator>
 			AutocompleteCommandName(const std::string& name) override;
 
-			void SetWorld(World*);
-			World* GetWorld() const { return world.get(); }
+			void SetWorld(World*) override;
+			World* GetWorld() const override { return world.get(); }
 			void AddLocalEntity(std::unique_ptr<ILocalEntity>&& ent) {
 				localEntities.emplace_back(std::move(ent));
 			}
+			ParticleSystem& GetParticleSystem() { return *particles; }
 
-			void MarkWorldUpdate();
+			void MarkWorldUpdate() override;
 
 			IRenderer& GetRenderer() { return *renderer; }
 			SceneDefinition GetLastSceneDef() { return lastSceneDef; }
@@ -499,25 +502,25 @@ namespace spades {
 			bool WantsToBeClosed() override;
 			bool IsMuted();
 
-			void PlayerSentChatMessage(Player&, bool global, const std::string&);
-			void ServerSentMessage(bool system, const std::string&);
-
-			void PlayerCapturedIntel(Player&);
-			void PlayerPickedIntel(Player&);
-			void PlayerDropIntel(Player&);
-			void TeamCapturedTerritory(int teamId, int territoryId);
-			void TeamWon(int);
-			void JoinedGame();
-			void LocalPlayerCreated();
-			void RegisterPlacedBlocks(int c) { placedBlocks += c; };
-			void PlayerCreatedBlock(Player&);
+			void PlayerSentChatMessage(Player&, bool global, const std::string&) override;
+			void ServerSentMessage(bool system, const std::string&) override;
+
+			void PlayerCapturedIntel(Player&) override;
+			void PlayerPickedIntel(Player&) override;
+			void PlayerDropIntel(Player&) override;
+			void TeamCapturedTerritory(int teamId, int territoryId) override;
+			void TeamWon(int) override;
+			void JoinedGame() override;
+			void LocalPlayerCreated() override;
+			void RegisterPlacedBlocks(int c) override { placedBlocks += c; };
+			void PlayerCreatedBlock(Player&) override;
 			void PlayBlockDestroySound(Vector3);
-			void PlayerDestroyedBlockWithWeaponOrTool(IntVector3);
-			void PlayerDiggedBlock(IntVector3);
-			void GrenadeDestroyedBlock(IntVector3);
-			void PlayerLeaving(Player&);
-			void PlayerJoinedTeam(Player&);
-			void PlayerSpawned(Player&);
+			void PlayerDestroyedBlockWithWeaponOrTool(IntVector3) override;
+			void PlayerDiggedBlock(IntVector3) override;
+			void GrenadeDestroyedBlock(IntVector3) override;
+			void PlayerLeaving(Player&) override;
+			void PlayerJoinedTeam(Player&) override;
+			void PlayerSpawned(Player&) override;
 
 			// IWorldListener begin
 			void PlayerObjectSet(int) override;
@@ -39,6 +39,7 @@
 #include "NetClient.h"
 #include <Core/Bitmap.h>
 #include <Core/Settings.h>
+#include <Core/TraceProfiler.h>
 #include <ScriptBindings/IBlockSkin.h>
 #include <ScriptBindings/IGrenadeSkin.h>
 #include <ScriptBindings/ISpadeSkin.h>
@@ -337,6 +338,7 @@ namespace spades {
 		}
 
 		void ClientPlayer::Update(float dt) {
+			SPADES_TRACE_ZONE("ClientPlayer::Update");
 			time += dt;
 
 			bool isLocalPlayer = player.IsLocalPlayer();
@@ -605,6 +607,7 @@ namespace spades {
 		}
 
 		void ClientPlayer::AddToSceneFirstPersonView() {
+			SPADES_TRACE_ZONE("ClientPlayer::AddToSceneFirstPersonView");
 			Player& p = player;
 			Weapon& w = p.GetWeapon();
 			IRenderer& renderer = client.GetRenderer();
@@ -951,6 +954,7 @@ namespace spades {
 		}
 
 		void ClientPlayer::AddToSceneThirdPersonView() {
+			SPADES_TRACE_ZONE("ClientPlayer::AddToSceneThirdPersonView");
 			Player& p = player;
 			Weapon& w = p.GetWeapon();
 			IRenderer& renderer = client.GetRenderer();
@@ -1293,6 +1297,18 @@ namespace spades {
 			float maxDistance = 40.0F;
 			GameMap& map = *client.map;
 
+			// The rays are cast from the eye, so the estimation only changes when the player
+			// moves or the map is modified (automatic weapons fire several times a second)
+			AmbienceCache& cache = ambienceCache;
+			if (cache.valid && cache.map == &map && cache.mapRevision == map.GetRevision() &&
+			    (cache.eye - rayFrom).GetSquaredLength() < 0.25F * 0.25F) {
+				AmbienceInfo result;
+				result.room = cache.room;
+				result.distance = (viewOrigin - rayFrom).GetLength();
+				result.size = cache.size;
+				return result;
+			}
+
 			// uniformly distributed random unit vectors
 			const Vector3 directions[24] = {
 			  {-0.4806003057749437F, -0.42909622618705534F, 0.7647874049440525F},
@@ -1375,6 +1391,13 @@ namespace spades {
 			result.room *= std::max(0.0F, std::min((result.size - 0.1F) * 4.0F, 1.0F));
 			result.room *= 1.0F - result.size * 0.3F;
 
+			cache.valid = true;
+			cache.map = &map;
+			cache.mapRevision = map.GetRevision();
+			cache.eye = rayFrom;
+			cache.room = result.room;
+			cache.size = result.size;
+
 			return result;
 		}
 
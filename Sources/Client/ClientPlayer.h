@@ -32,6 +32,7 @@ namespace spades {
 
 	namespace client {
 		class Client;
+		class GameMap;
 		class IRenderer;
 		class IAudioDevice;
 		class SandboxedRenderer;
@@ -83,6 +84,19 @@ namespace spades {
 			struct AmbienceInfo;
 			AmbienceInfo ComputeAmbience();
 
+			/**
+			 * The room estimation of the last `ComputeAmbience`, reused while the eye stays
+			 * close and the map doesn't change.
+			 */
+			struct AmbienceCache {
+				bool valid = false;
+				const GameMap* map;
+				uint32_t mapRevision;
+				Vector3 eye;
+				float room, size;
+			};
+			AmbienceCache ambienceCache;
+
 			// TODO: Naming convention violation
 			asIScriptObject* initScriptFactory(ScriptFunction& creator, 
 				IRenderer& renderer, IAudioDevice& audio);
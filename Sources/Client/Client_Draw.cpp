@@ -29,6 +29,7 @@
 #include <Core/FileManager.h>
 #include <Core/Settings.h>
 #include <Core/Strings.h>
+#include <Core/TraceProfiler.h>
 
 #include "CTFGameMode.h"
 #include "CenterMessageView.h"
@@ -1511,6 +1512,7 @@ namespace spades {
 
 		void Client::Draw2D() {
 			SPADES_MARK_FUNCTION();
+			SPADES_TRACE_ZONE("Client::Draw2D");
 
 			if (GetWorld())
 				Draw2DWithWorld();
@@ -35,8 +35,7 @@
 #include "BloodMarks.h"
 #include "Corpse.h"
 #include "ILocalEntity.h"
-#include "ParticleSpriteEntity.h"
-#include "SmokeSpriteEntity.h"
+#include "ParticleSystem.h"
 
 #include "GameMap.h"
 #include "Weapon.h"
@@ -68,6 +67,7 @@ namespace spades {
 
 			damageIndicators.clear();
 			localEntities.clear();
+			particles->Clear();
 			bloodMarks->Clear();
 		}
 
@@ -159,13 +159,13 @@ namespace spades {
 			Vector4 color = ConvertColorRGBA(IntVectorFromColor(col));
 
 			for (int i = 0; i < 4; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
-				ent->SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 8.0F);
-				ent->SetRadius(0.4F);
-				ent->SetLifeTime(3.0F, 0.0F, 1.0F);
+				ParticleSprite particle{*img, color};
+				particle.SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 8.0F);
+				particle.SetRadius(0.4F);
+				particle.SetLifeTime(3.0F, 0.0F, 1.0F);
 				if (distSqr < 16.0F * 16.0F || bounce)
-					ent->SetBlockHitAction(BlockHitAction::BounceWeak);
-				localEntities.emplace_back(std::move(ent));
+					particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+				particles->AddSprite(particle);
 			}
 
 			if ((int)cg_particles < 2)
@@ -173,25 +173,25 @@ namespace spades {
 
 			color = MakeVector4(0.7F, 0.35F, 0.37F, 0.6F);
 			for (int i = 0; i < 2; i++) {
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 100.0F,
-					SmokeSpriteEntity::Type::Explosion);
-				ent->SetTrajectory(pos, RandomAxis() * 0.7F, 0.8F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.5F + SampleRandomFloat() * SampleRandomFloat() * 0.2F, 2.0F);
-				ent->SetLifeTime(0.2F + SampleRandomFloat() * 0.2F, 0.06F, 0.2F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				SmokeSprite particle{color, 100.0F, SmokeSprite::Type::Explosion};
+				particle.SetTrajectory(pos, RandomAxis() * 0.7F, 0.8F, 0.0F);
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.5F + SampleRandomFloat() * SampleRandomFloat() * 0.2F, 2.0F);
+				particle.SetLifeTime(0.2F + SampleRandomFloat() * 0.2F, 0.06F, 0.2F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 
 			color.w *= 0.1F;
 			{
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 40.0F);
-				ent->SetTrajectory(pos, RandomAxis() * 0.7F, 0.8F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.7F + SampleRandomFloat() * SampleRandomFloat() * 0.2F, 2.0F, 0.1F);
-				ent->SetLifeTime(0.8F + SampleRandomFloat() * 0.4F, 0.06F, 1.0F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				SmokeSprite particle{color, 40.0F};
+				particle.SetTrajectory(pos, RandomAxis() * 0.7F, 0.8F, 0.0F);
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.7F + SampleRandomFloat() * SampleRandomFloat() * 0.2F, 2.0F,
+				                   0.1F);
+				particle.SetLifeTime(0.8F + SampleRandomFloat() * 0.4F, 0.06F, 1.0F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 		}
 
@@ -229,14 +229,14 @@ namespace spades {
 			Vector4 color = ConvertColorRGBA(col);
 
 			for (int i = 0; i < 4; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
+				ParticleSprite particle{*img, color};
 				Vector3 dir = RandomAxis() + velBias * 0.5F;
-				ent->SetTrajectory(pos + dir * 0.2F, dir * 8.0F);
-				ent->SetRadius(0.4F);
-				ent->SetLifeTime(3.0F, 0.0F, 1.0F);
+				particle.SetTrajectory(pos + dir * 0.2F, dir * 8.0F);
+				particle.SetRadius(0.4F);
+				particle.SetLifeTime(3.0F, 0.0F, 1.0F);
 				if (distSqr < 16.0F * 16.0F)
-					ent->SetBlockHitAction(BlockHitAction::BounceWeak);
-				localEntities.emplace_back(std::move(ent));
+					particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+				particles->AddSprite(particle);
 			}
 
 			if ((int)cg_particles < 2)
@@ -244,27 +244,27 @@ namespace spades {
 
 			if (distSqr < 32.0F * 32.0F) {
 				for (int i = 0; i < 8; i++) {
-					auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
-					ent->SetTrajectory(pos, RandomAxis() * 12.0F, 1.0F, 0.9F);
-					ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-					ent->SetRadius(0.2F + SampleRandomFloat() * SampleRandomFloat() * 0.25F);
-					ent->SetLifeTime(3.0F, 0.0F, 1.0F);
+					ParticleSprite particle{*img, color};
+					particle.SetTrajectory(pos, RandomAxis() * 12.0F, 1.0F, 0.9F);
+					particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+					particle.SetRadius(0.2F + SampleRandomFloat() * SampleRandomFloat() * 0.25F);
+					particle.SetLifeTime(3.0F, 0.0F, 1.0F);
 					if (distSqr < 16.0F * 16.0F)
-						ent->SetBlockHitAction(BlockHitAction::BounceWeak);
-					localEntities.emplace_back(std::move(ent));
+						particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+					particles->AddSprite(particle);
 				}
 			}
 
 			color += (MakeVector4(1, 1, 1, 1) - color) * 0.2F;
 			color.w *= 0.2F;
 			for (int i = 0; i < 2; i++) {
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 100.0F);
-				ent->SetTrajectory(pos, RandomAxis() * 0.7F, 1.0F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.2F, 0.8F);
-				ent->SetLifeTime(0.3F + SampleRandomFloat() * 0.3F, 0.06F, 0.4F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				SmokeSprite particle{color, 100.0F};
+				particle.SetTrajectory(pos, RandomAxis() * 0.7F, 1.0F, 0.0F);
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.2F, 0.8F);
+				particle.SetLifeTime(0.3F + SampleRandomFloat() * 0.3F, 0.06F, 0.4F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 		}
 
@@ -289,13 +289,13 @@ namespace spades {
 			Vector4 color = ConvertColorRGBA(IntVectorFromColor(col));
 
 			for (int i = 0; i < 4; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
-				ent->SetTrajectory(origin, RandomAxis() * 8.0F);
-				ent->SetRadius(0.4F);
-				ent->SetLifeTime(3.0F, 0.0F, 1.0F);
+				ParticleSprite particle{*img, color};
+				particle.SetTrajectory(origin, RandomAxis() * 8.0F);
+				particle.SetRadius(0.4F);
+				particle.SetLifeTime(3.0F, 0.0F, 1.0F);
 				if (distSqr < 16.0F * 16.0F)
-					ent->SetBlockHitAction(BlockHitAction::BounceWeak);
-				localEntities.emplace_back(std::move(ent));
+					particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+				particles->AddSprite(particle);
 			}
 		}
 
@@ -323,27 +323,26 @@ namespace spades {
 
 			// rapid smoke
 			for (int i = 0; i < 2; i++) {
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 120.0F,
-					SmokeSpriteEntity::Type::Explosion);
-				ent->SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 0.3F, 1.0F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.4F, 3.0F, 0.0000005F);
-				ent->SetLifeTime(0.2F + SampleRandomFloat() * 0.1F, 0.0F, 0.3F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				SmokeSprite particle{color, 120.0F, SmokeSprite::Type::Explosion};
+				particle.SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 0.3F, 1.0F, 0.0F);
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.4F, 3.0F, 0.0000005F);
+				particle.SetLifeTime(0.2F + SampleRandomFloat() * 0.1F, 0.0F, 0.3F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 
 			// fire smoke
 			color = MakeVector4(1.0F, 0.6F, 0.4F, 0.2F) * 5.0F;
 			for (int i = 0; i < 4; i++) {
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 120.0F,
-					SmokeSpriteEntity::Type::Explosion);
-				ent->SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 0.3F, 1.0F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.2F + SampleRandomFloat() * SampleRandomFloat() * 0.3F, 3.0F, 0.0000005F);
-				ent->SetLifeTime(0.01F + SampleRandomFloat() * 0.02F, 0.0F, 0.01F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				SmokeSprite particle{color, 120.0F, SmokeSprite::Type::Explosion};
+				particle.SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 0.3F, 1.0F, 0.0F);
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.2F + SampleRandomFloat() * SampleRandomFloat() * 0.3F, 3.0F,
+				                   0.0000005F);
+				particle.SetLifeTime(0.01F + SampleRandomFloat() * 0.02F, 0.0F, 0.01F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 		}
 
@@ -397,15 +396,15 @@ namespace spades {
 			Vector4 color = ConvertColorRGBA(IntVectorFromColor(col));
 
 			for (int i = 0; i < 64; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
+				ParticleSprite particle{*img, color};
 				Vector3 dir = RandomAxis() + velBias * 0.5F;
 				float radius = 0.3F + SampleRandomFloat() * SampleRandomFloat() * 0.3F;
-				ent->SetTrajectory(pos + dir * 0.2F, dir * 20.0F, 0.1F + radius * 3.0F);
-				ent->SetRadius(radius);
-				ent->SetLifeTime(3.5F + SampleRandomFloat() * 2.0F, 0.0F, 1.0F);
+				particle.SetTrajectory(pos + dir * 0.2F, dir * 20.0F, 0.1F + radius * 3.0F);
+				particle.SetRadius(radius);
+				particle.SetLifeTime(3.5F + SampleRandomFloat() * 2.0F, 0.0F, 1.0F);
 				if (distSqr < 16.0F * 16.0F)
-					ent->SetBlockHitAction(BlockHitAction::BounceWeak);
-				localEntities.emplace_back(std::move(ent));
+					particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+				particles->AddSprite(particle);
 			}
 
 			if (particleMode < 2)
@@ -413,46 +412,52 @@ namespace spades {
 
 			// rapid smoke
 			for (int i = 0; i < 4; i++) {
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 60.0F,
-					SmokeSpriteEntity::Type::Explosion);
-				ent->SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 2.0F, 1.0F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.4F, 2.0F, 0.2F);
-				ent->SetLifeTime(1.8F + SampleRandomFloat() * 0.1F, 0.0F, 0.2F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				SmokeSprite particle{color, 60.0F, SmokeSprite::Type::Explosion};
+				particle.SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 2.0F, 1.0F, 0.0F);
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.4F, 2.0F,
+				                   0.2F);
+				particle.SetLifeTime(1.8F + SampleRandomFloat() * 0.1F, 0.0F, 0.2F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 
 			// slow smoke
 			color.w = 0.25F;
 			for (int i = 0; i < 8; i++) {
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 30.0F);
-				ent->SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
+				SmokeSprite particle{color, 30.0F};
+				particle.SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
 				               SampleRandomFloat() - SampleRandomFloat(),
 				               (SampleRandomFloat() - SampleRandomFloat()) * 0.2F)) * 2.0F, 1.0F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(1.5F + SampleRandomFloat() * SampleRandomFloat() * 0.8F, 0.2F);
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(1.5F + SampleRandomFloat() * SampleRandomFloat() * 0.8F, 0.2F);
 				switch (particleMode) {
-					case 1: ent->SetLifeTime(0.8F + SampleRandomFloat() * 1.0F, 0.1F, 8.0F); break;
-					case 2: ent->SetLifeTime(1.5F + SampleRandomFloat() * 2.0F, 0.1F, 8.0F); break;
+					case 1:
+						particle.SetLifeTime(0.8F + SampleRandomFloat() * 1.0F, 0.1F, 8.0F);
+						break;
+					case 2:
+						particle.SetLifeTime(1.5F + SampleRandomFloat() * 2.0F, 0.1F, 8.0F);
+						break;
 					case 3:
-					default: ent->SetLifeTime(2.0F + SampleRandomFloat() * 5.0F, 0.1F, 8.0F); break;
+					default:
+						particle.SetLifeTime(2.0F + SampleRandomFloat() * 5.0F, 0.1F, 8.0F);
+						break;
 				}
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 
 			// fire smoke
 			color = MakeVector4(1, 0.7F, 0.4F, 0.2F) * 5.0F;
 			for (int i = 0; i < 4; i++) {
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 120.0F,
-					SmokeSpriteEntity::Type::Explosion);
-				ent->SetTrajectory(pos, (RandomAxis() + velBias) * 6.0F, 1.0F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.3F + SampleRandomFloat() * SampleRandomFloat() * 0.4F, 3.0F, 0.1F);
-				ent->SetLifeTime(0.18F + SampleRandomFloat() * 0.03F, 0.0F, 0.1F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				SmokeSprite particle{color, 120.0F, SmokeSprite::Type::Explosion};
+				particle.SetTrajectory(pos, (RandomAxis() + velBias) * 6.0F, 1.0F, 0.0F);
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.3F + SampleRandomFloat() * SampleRandomFloat() * 0.4F, 3.0F,
+				                   0.1F);
+				particle.SetLifeTime(0.18F + SampleRandomFloat() * 0.03F, 0.0F, 0.1F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 		}
 
@@ -480,15 +485,15 @@ namespace spades {
 			Vector4 color = ConvertColorRGBA(IntVectorFromColor(col));
 
 			for (int i = 0; i < 64; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
+				ParticleSprite particle{*img, color};
 				Vector3 dir = RandomAxis() + velBias * 0.5F;
 				float radius = 0.3F + SampleRandomFloat() * SampleRandomFloat() * 0.3F;
-				ent->SetTrajectory(pos + dir * 0.2F, dir * 16.0F, 0.1F + radius * 3.0F);
-				ent->SetRadius(radius);
-				ent->SetLifeTime(3.5F + SampleRandomFloat() * 2.0F, 0.0F, 1.0F);
+				particle.SetTrajectory(pos + dir * 0.2F, dir * 16.0F, 0.1F + radius * 3.0F);
+				particle.SetRadius(radius);
+				particle.SetLifeTime(3.5F + SampleRandomFloat() * 2.0F, 0.0F, 1.0F);
 				if (distSqr < 16.0F * 16.0F)
-					ent->SetBlockHitAction(BlockHitAction::BounceWeak);
-				localEntities.emplace_back(std::move(ent));
+					particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+				particles->AddSprite(particle);
 			}
 
 			if ((int)cg_particles < 2)
@@ -498,41 +503,42 @@ namespace spades {
 			img = renderer->RegisterImage("Textures/WaterExpl.png");
 			color = MakeVector4(0.95F, 0.95F, 0.95F, 0.6F);
 			for (int i = 0; i < 7; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
-				ent->SetTrajectory(pos, (MakeVector3(0.0F, 0.0F, -SampleRandomFloat() * 7.0F)) * 2.5F, 0.3F);
-				ent->SetRadius(1.2F + SampleRandomFloat() * SampleRandomFloat() * 0.4F, 0.6F);
-				ent->SetLifeTime(2.0F + SampleRandomFloat() * 0.3F, 0.1F, 0.2F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				ParticleSprite particle{*img, color};
+				particle.SetTrajectory(
+				  pos, (MakeVector3(0.0F, 0.0F, -SampleRandomFloat() * 7.0F)) * 2.5F, 0.3F);
+				particle.SetRadius(1.2F + SampleRandomFloat() * SampleRandomFloat() * 0.4F, 0.6F);
+				particle.SetLifeTime(2.0F + SampleRandomFloat() * 0.3F, 0.1F, 0.2F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSprite(particle);
 			}
 
 			// water2
 			img = renderer->RegisterImage("Textures/Fluid.png");
 			color.w = 0.9F;
 			for (int i = 0; i < 16; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
-				ent->SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
+				ParticleSprite particle{*img, color};
+				particle.SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
 				                                     SampleRandomFloat() - SampleRandomFloat(),
 				                                     -SampleRandomFloat() * 7.0F)) * 3.5F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.3F, 0.5F);
-				ent->SetLifeTime(2.0F + SampleRandomFloat() * 0.3F, 0.1F, 0.2F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.3F, 0.5F);
+				particle.SetLifeTime(2.0F + SampleRandomFloat() * 0.3F, 0.1F, 0.2F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSprite(particle);
 			}
 
 			// slow smoke
 			color.w = 0.3F;
 			for (int i = 0; i < 4; i++) {
-				auto ent = stmp::make_unique<SmokeSpriteEntity>(*this, color, 10.0F);
-				ent->SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
+				SmokeSprite particle{color, 10.0F};
+				particle.SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
 				               SampleRandomFloat() - SampleRandomFloat(),
 				               (SampleRandomFloat() - SampleRandomFloat()) * 0.2F)) * 2.0F, 1.0F, 0.0F);
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(1.5F + SampleRandomFloat() * SampleRandomFloat() * 0.6F, 0.2F);
-				ent->SetLifeTime(2.0F + SampleRandomFloat() * 0.3F, 0.2F, 1.5F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				localEntities.emplace_back(std::move(ent));
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(1.5F + SampleRandomFloat() * SampleRandomFloat() * 0.6F, 0.2F);
+				particle.SetLifeTime(2.0F + SampleRandomFloat() * 0.3F, 0.2F, 1.5F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particles->AddSmoke(particle);
 			}
 
 			// TODO: wave?
@@ -555,13 +561,13 @@ namespace spades {
 			Vector4 color = ConvertColorRGBA(col);
 
 			for (int i = 0; i < 4; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
-				ent->SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 8.0F);
-				ent->SetRadius(0.4F);
-				ent->SetLifeTime(3.0F, 0.0F, 1.0F);
+				ParticleSprite particle{*img, color};
+				particle.SetTrajectory(pos, (RandomAxis() + velBias * 0.5F) * 8.0F);
+				particle.SetRadius(0.4F);
+				particle.SetLifeTime(3.0F, 0.0F, 1.0F);
 				if (distSqr < 16.0F * 16.0F)
-					ent->SetBlockHitAction(BlockHitAction::BounceWeak);
-				localEntities.emplace_back(std::move(ent));
+					particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+				particles->AddSprite(particle);
 			}
 
 			if ((int)cg_particles < 2)
@@ -573,29 +579,30 @@ namespace spades {
 			img = renderer->RegisterImage("Textures/WaterExpl.png");
 			color = MakeVector4(0.95F, 0.95F, 0.95F, 0.3F);
 			for (int i = 0; i < 2; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
-				ent->SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
+				ParticleSprite particle{*img, color};
+				particle.SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
 				                                SampleRandomFloat() - SampleRandomFloat(),
 				                                -SampleRandomFloat() * 7.0F)), 0.3F, 0.6F);
-				ent->SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.4F, 0.7F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				ent->SetLifeTime(3.0F + SampleRandomFloat() * 0.3F, 0.1F, 0.6F);
-				localEntities.emplace_back(std::move(ent));
+				particle.SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.4F, 0.7F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particle.SetLifeTime(3.0F + SampleRandomFloat() * 0.3F, 0.1F, 0.6F);
+				particles->AddSprite(particle);
 			}
 
 			// water2
 			img = renderer->RegisterImage("Textures/Fluid.png");
 			color.w = 0.9F;
 			for (int i = 0; i < 6; i++) {
-				auto ent = stmp::make_unique<ParticleSpriteEntity>(*this, img, color);
-				ent->SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
+				ParticleSprite particle{*img, color};
+				particle.SetTrajectory(pos, (MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
 				                                SampleRandomFloat() - SampleRandomFloat(),
 				                                -SampleRandomFloat() * 16.0F)));
-				ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-				ent->SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.6F, 0.6F);
-				ent->SetBlockHitAction(BlockHitAction::Ignore);
-				ent->SetLifeTime(3.0F + SampleRandomFloat() * 0.3F, SampleRandomFloat() * 0.3F, 0.6F);
-				localEntities.emplace_back(std::move(ent));
+				particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+				particle.SetRadius(0.6F + SampleRandomFloat() * SampleRandomFloat() * 0.6F, 0.6F);
+				particle.SetBlockHitAction(BlockHitAction::Ignore);
+				particle.SetLifeTime(3.0F + SampleRandomFloat() * 0.3F, SampleRandomFloat() * 0.3F,
+				                     0.6F);
+				particles->AddSprite(particle);
 			}
 
 			// TODO: wave?
@@ -24,6 +24,7 @@
 #include <Core/ConcurrentDispatch.h>
 #include <Core/Settings.h>
 #include <Core/Strings.h>
+#include <Core/TraceProfiler.h>
 
 #include "BloodMarks.h"
 #include "CTFGameMode.h"
@@ -34,6 +35,7 @@
 
 #include "ClientPlayer.h"
 #include "ILocalEntity.h"
+#include "ParticleSystem.h"
 
 #include "GameMap.h"
 #include "Grenade.h"
@@ -574,6 +576,7 @@ namespace spades {
 
 		void Client::DrawScene() {
 			SPADES_MARK_FUNCTION();
+			SPADES_TRACE_ZONE("Client::DrawScene");
 
 			renderer->StartScene(lastSceneDef);
 
@@ -601,6 +604,7 @@ namespace spades {
 
 				for (const auto& ent : localEntities)
 					ent->Render3D();
+				particles->Render3D(*renderer);
 
 				bloodMarks->Draw();
 
@@ -24,6 +24,7 @@
 #include <Core/ConcurrentDispatch.h>
 #include <Core/Settings.h>
 #include <Core/Strings.h>
+#include <Core/TraceProfiler.h>
 
 #include "IAudioChunk.h"
 #include "IAudioDevice.h"
@@ -38,6 +39,7 @@
 #include "HurtRingView.h"
 #include "ILocalEntity.h"
 #include "MapView.h"
+#include "ParticleSystem.h"
 #include "Tracer.h"
 
 #include "GameMap.h"
@@ -205,6 +207,7 @@ namespace spades {
 
 		void Client::UpdateWorld(float dt) {
 			SPADES_MARK_FUNCTION();
+			SPADES_TRACE_ZONE("Client::UpdateWorld");
 
 			stmp::optional<Player&> maybePlayer = world->GetLocalPlayer();
 
@@ -298,6 +301,7 @@ namespace spades {
 				for (const auto& it : its)
 					localEntities.erase(it);
 			}
+			particles->Update(dt, map.GetPointerOrNull());
 
 			bloodMarks->Update(dt);
 			corpseDispatch.Join();
@@ -561,10 +565,9 @@ namespace spades {
 					net->SendPosition(curPos);
 				}
 
-				// send orientation packet - 120 per second
+				// send orientation packet - coalesced to 120 per second by `NetClient`
 				Vector3 curFront = player.GetFront();
-				if (curFront != lastFrontSent && time - lastOriSentTime > (1.0F / 120.0F)) {
-					lastOriSentTime = time;
+				if (curFront != lastFrontSent) {
 					lastFrontSent = curFront;
 					net->SendOrientation(curFront);
 				}
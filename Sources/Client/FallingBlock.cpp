@@ -27,8 +27,8 @@
 #include "IAudioChunk.h"
 #include "IAudioDevice.h"
 #include "IRenderer.h"
-#include "ParticleSpriteEntity.h"
-#include "SmokeSpriteEntity.h"
+#include "MapCollision.h"
+#include "ParticleSystem.h"
 #include "World.h"
 #include <Core/Debug.h>
 #include <Core/Exception.h>
@@ -170,24 +170,23 @@ namespace spades {
 							Vector3 p3 = p2 + vmAxis3 * (float)z;
 
 							for (int i = 0; i < 4; i++) {
-								auto ent = stmp::make_unique<ParticleSpriteEntity>(
-									*client, img.GetPointerOrNull(), color);
-								ent->SetTrajectory(p3, RandomAxis() * 4.0F, 1.0F, 0.6F);
-								ent->SetRadius(0.4F + getRandom() * getRandom() * 0.1F);
-								ent->SetLifeTime(2.0F, 0.0F, 1.0F);
+								ParticleSprite particle{*img, color};
+								particle.SetTrajectory(p3, RandomAxis() * 4.0F, 1.0F, 0.6F);
+								particle.SetRadius(0.4F + getRandom() * getRandom() * 0.1F);
+								particle.SetLifeTime(2.0F, 0.0F, 1.0F);
 								if (usePrecisePhysics)
-									ent->SetBlockHitAction(BlockHitAction::BounceWeak);
-								client->AddLocalEntity(std::move(ent));
+									particle.SetBlockHitAction(BlockHitAction::BounceWeak);
+								client->GetParticleSystem().AddSprite(particle);
 							}
 
 							if (particleMode >= 2) {
-								auto ent = stmp::make_unique<SmokeSpriteEntity>(*client, color, 70.0F);
-								ent->SetTrajectory(p3, RandomAxis() * 0.2F, 1.0F, 0.0F);
-								ent->SetRotation(getRandom() * M_PI_F * 2.0F);
-								ent->SetRadius(1.0F, 0.5F);
-								ent->SetBlockHitAction(BlockHitAction::Ignore);
-								ent->SetLifeTime(1.0F + getRandom() * 0.5F, 0.0F, 1.0F);
-								client->AddLocalEntity(std::move(ent));
+								SmokeSprite particle{color, 70.0F};
+								particle.SetTrajectory(p3, RandomAxis() * 0.2F, 1.0F, 0.0F);
+								particle.SetRotation(getRandom() * M_PI_F * 2.0F);
+								particle.SetRadius(1.0F, 0.5F);
+								particle.SetBlockHitAction(BlockHitAction::Ignore);
+								particle.SetLifeTime(1.0F + getRandom() * 0.5F, 0.0F, 1.0F);
+								client->GetParticleSystem().AddSmoke(particle);
 							}
 						}
 					}
@@ -212,29 +211,20 @@ namespace spades {
 			velocity.z += fsynctics * 32.0F;
 
 			// Collision
-			IntVector3 lp = matrix.GetOrigin().Floor();
-
 			const Handle<GameMap>& map = client->GetWorld()->GetMap();
 			SPAssert(map);
 
 			int ret = 0;
-			if (map->ClipWorld(lp.x, lp.y, lp.z)) {
+			MapCollision collision =
+			  CollideWithMap(*map, lastMat.GetOrigin(), matrix.GetOrigin());
+			if (collision != MapCollision::None) {
 				ret = 1; // hit a wall
 				if (fabsf(velocity.x) > BOUNCE_SOUND_THRESHOLD ||
 				    fabsf(velocity.y) > BOUNCE_SOUND_THRESHOLD ||
 				    fabsf(velocity.z) > BOUNCE_SOUND_THRESHOLD)
 					ret = 2; // play sound
 
-				IntVector3 lp2 = lastMat.GetOrigin().Floor();
-				if (lp.z != lp2.z && ((lp.x == lp2.x && lp.y == lp2.y)
-					|| !map->ClipWorld(lp.x, lp.y, lp2.z)))
-					velocity.z = -velocity.z;
-				else if (lp.x != lp2.x && ((lp.y == lp2.y && lp.z == lp2.z)
-					|| !map->ClipWorld(lp2.x, lp.y, lp.z)))
-					velocity.x = -velocity.x;
-				else if (lp.y != lp2.y && ((lp.x == lp2.x && lp.z == lp2.z)
-					|| !map->ClipWorld(lp.x, lp2.y, lp.z)))
-					velocity.y = -velocity.y;
+				ReflectVelocity(collision, velocity);
 
 				matrix = lastMat; // set back to old position
 				velocity *= 0.46F; // lose some velocity due to friction
@@ -22,14 +22,19 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <vector>
 
 #include "GameMap.h"
+#include "GameMapDecoder.h"
 #include <Core/Debug.h>
 #include <Core/Exception.h>
 #include <Core/FileManager.h>
 #include <Core/IStream.h>
-#include <Core/RandomAccessAdaptor.h>
+#include <Core/Settings.h>
+#include <Core/TMPUtils.h>
+
+DEFINE_SPADES_SETTING(cg_sparseMapStorage, "1");
 
 namespace spades {
 	namespace client {
@@ -44,30 +49,221 @@ namespace spades {
 			return (u.c & 0xFFFFFF) | (100UL << 24);
 		}
 
-		GameMap::GameMap() {
+		GameMap::StorageMode GameMap::GetDefaultStorageMode() {
+			return cg_sparseMapStorage ? StorageMode::Sparse : StorageMode::Dense;
+		}
+
+		GameMap::GameMap(StorageMode mode) {
 			SPADES_MARK_FUNCTION();
 
 			for (int x = 0; x < DefaultWidth; x++)
-			for (int y = 0; y < DefaultHeight; y++) {
-				solidMap[x][y] = 1; // ground only
+				for (int y = 0; y < DefaultHeight; y++)
+					solidMap[x][y] = 1; // ground only
+
+			if (mode == StorageMode::Dense) {
+				colorMap.reset(new uint32_t[DefaultWidth * DefaultHeight * DefaultDepth]);
+				for (int x = 0; x < DefaultWidth; x++)
+				for (int y = 0; y < DefaultHeight; y++)
 				for (int z = 0; z < DefaultDepth; z++) {
 					uint32_t col = GetDirtColor(x, y, z);
-					colorMap[x][y][z] = swapColor(col);
+					colorMap[ColorIndex(x, y, z)] = swapColor(col);
 				}
+			} else {
+				// Empty columns; `GetImplicitColor` supplies the dirt colors
+				sparseColumns.reset(new ColorColumn[DefaultWidth * DefaultHeight]());
 			}
 		}
 		GameMap::~GameMap() { SPADES_MARK_FUNCTION(); }
 
+		std::size_t GameMap::GetMemoryUsage() const {
+			std::size_t size = sizeof(*this);
+			if (colorMap)
+				size += sizeof(uint32_t) * DefaultWidth * DefaultHeight * DefaultDepth;
+			if (sparseColumns)
+				size += sizeof(ColorColumn) * DefaultWidth * DefaultHeight;
+			size += sparseColors.capacity() * sizeof(uint32_t);
+			return size;
+		}
+
+		bool GameMap::SetSparseColor(int x, int y, int z, uint32_t color) {
+			ColorColumn& column = sparseColumns[(std::size_t)x * DefaultHeight + y];
+			uint64_t bit = 1ULL << z;
+			uint32_t index = (uint32_t)PopCount64(column.mask & (bit - 1));
+
+			if (column.mask & bit) {
+				uint32_t& cell = sparseColors[column.offset + index];
+				if (cell == color)
+					return false;
+				cell = color;
+				return true;
+			}
+
+			if (color == GetImplicitColor(x, y, z)) {
+				// No need to store it
+				return false;
+			}
+
+			uint32_t count = (uint32_t)PopCount64(column.mask);
+			if (count == column.capacity) {
+				if (column.capacity == 0) {
+					// Start a new column at the end of the pool
+					column.offset = (uint32_t)sparseColors.size();
+				}
+
+				if (column.offset + column.capacity == sparseColors.size()) {
+					// This column is at the end of the pool; grow it in place. This is always
+					// the case while `Load` is filling the columns in order.
+					sparseColors.push_back(0);
+					column.capacity++;
+				} else {
+					// Relocate the column to the end of the pool with some headroom
+					uint32_t newCapacity = std::min<uint32_t>(count * 2, DefaultDepth);
+					uint32_t newOffset = (uint32_t)sparseColors.size();
+					sparseColors.resize(sparseColors.size() + newCapacity);
+					std::copy(sparseColors.begin() + column.offset,
+					          sparseColors.begin() + column.offset + count,
+					          sparseColors.begin() + newOffset);
+					sparseColorsUnused += column.capacity;
+					column.offset = newOffset;
+					column.capacity = newCapacity;
+				}
+			}
+
+			uint32_t* colors = sparseColors.data() + column.offset;
+			std::copy_backward(colors + index, colors + count, colors + count + 1);
+			colors[index] = color;
+			column.mask |= bit;
+
+			if (sparseColorsUnused > sparseColors.size() / 2 && sparseColors.size() > 65536)
+				CompactSparseColors();
+
+			return true;
+		}
+
+		void GameMap::RemoveSparseColor(int x, int y, int z) {
+			ColorColumn& column = sparseColumns[(std::size_t)x * DefaultHeight + y];
+			uint64_t bit = 1ULL << z;
+			if (!(column.mask & bit))
+				return;
+
+			uint32_t index = (uint32_t)PopCount64(column.mask & (bit - 1));
+			uint32_t count = (uint32_t)PopCount64(column.mask);
+			uint32_t* colors = sparseColors.data() + column.offset;
+			std::copy(colors + index + 1, colors + count, colors + index);
+			column.mask &= ~bit;
+		}
+
+		void GameMap::CompactSparseColors() {
+			SPADES_MARK_FUNCTION();
+
+			std::vector<uint32_t> newColors;
+			newColors.reserve(sparseColors.size() - sparseColorsUnused);
+
+			for (std::size_t i = 0; i < DefaultWidth * DefaultHeight; i++) {
+				ColorColumn& column = sparseColumns[i];
+				uint32_t count = (uint32_t)PopCount64(column.mask);
+				uint32_t newOffset = (uint32_t)newColors.size();
+				newColors.insert(newColors.end(), sparseColors.begin() + column.offset,
+				                 sparseColors.begin() + column.offset + count);
+				column.offset = newOffset;
+				column.capacity = count;
+			}
+
+			sparseColors.swap(newColors);
+			sparseColorsUnused = 0;
+		}
+
+		Handle<GameMap> GameMap::Clone() const {
+			SPADES_MARK_FUNCTION();
+
+			// An empty sparse map is cheap to construct, unlike a dense one
+			auto map = Handle<GameMap>::New(StorageMode::Sparse);
+			std::memcpy(map->solidMap, solidMap, sizeof(solidMap));
+
+			if (colorMap) {
+				const std::size_t numVoxels = DefaultWidth * DefaultHeight * DefaultDepth;
+				map->sparseColumns.reset();
+				map->colorMap.reset(new uint32_t[numVoxels]);
+				std::memcpy(map->colorMap.get(), colorMap.get(), numVoxels * sizeof(uint32_t));
+				return map;
+			}
+
+			std::vector<uint32_t>& newColors = map->sparseColors;
+			newColors.reserve(sparseColors.size() - sparseColorsUnused);
+			for (std::size_t i = 0; i < DefaultWidth * DefaultHeight; i++) {
+				const ColorColumn& column = sparseColumns[i];
+				uint32_t count = (uint32_t)PopCount64(column.mask);
+				map->sparseColumns[i] = ColorColumn{column.mask, (uint32_t)newColors.size(), count};
+				newColors.insert(newColors.end(), sparseColors.begin() + column.offset,
+				                 sparseColors.begin() + column.offset + count);
+			}
+			return map;
+		}
+
 		void GameMap::AddListener(spades::client::IGameMapListener* l) {
 			std::lock_guard<std::mutex> _guard{listenersMutex};
-			listeners.push_back(l);
+			const ListenerList* current = listeners.load(std::memory_order_relaxed);
+			auto newList = current ? stmp::make_unique<ListenerList>(*current)
+			                       : stmp::make_unique<ListenerList>();
+			newList->push_back(l);
+			listeners.store(newList.get(), std::memory_order_release);
+			listenerLists.push_back(std::move(newList));
 		}
 
 		void GameMap::RemoveListener(spades::client::IGameMapListener* l) {
 			std::lock_guard<std::mutex> _guard{listenersMutex};
-			auto it = std::find(listeners.begin(), listeners.end(), l);
-			if (it != listeners.end())
-				listeners.erase(it);
+			const ListenerList* current = listeners.load(std::memory_order_relaxed);
+			if (!current || std::find(current->begin(), current->end(), l) == current->end())
+				return;
+
+			auto newList = stmp::make_unique<ListenerList>(*current);
+			newList->erase(std::find(newList->begin(), newList->end(), l));
+			listeners.store(newList.get(), std::memory_order_release);
+			listenerLists.push_back(std::move(newList));
+		}
+
+		void GameMap::NotifyChanged(int x, int y, int z) {
+			if (batchDepth > 0) {
+				IntAABB3 grownRegion = batchRegion;
+				grownRegion += IntVector3(x, y, z);
+
+				// Don't let far apart changes (e.g., two distant block actions in the same tick)
+				// merge into a huge box that would make the listeners update a lot more than
+				// needed. Report what we have so far and start a new region instead.
+				if (!batchRegion.IsEmpty() && grownRegion.GetVolume() > MaxBatchRegionVolume) {
+					NotifyChangedRegion(batchRegion);
+					grownRegion = IntAABB3::Empty();
+					grownRegion += IntVector3(x, y, z);
+				}
+
+				batchRegion = grownRegion;
+				return;
+			}
+
+			const ListenerList* list = listeners.load(std::memory_order_acquire);
+			if (!list)
+				return;
+			for (auto* l : *list)
+				l->GameMapChanged(x, y, z, this);
+		}
+
+		void GameMap::NotifyChangedRegion(const IntAABB3& region) {
+			const ListenerList* list = listeners.load(std::memory_order_acquire);
+			if (!list)
+				return;
+			for (auto* l : *list)
+				l->GameMapChangedRegion(region, this);
+		}
+
+		void GameMap::EndBatch() {
+			SPAssert(batchDepth > 0);
+			if (--batchDepth > 0)
+				return;
+
+			IntAABB3 region = batchRegion;
+			batchRegion = IntAABB3::Empty();
+			if (!region.IsEmpty())
+				NotifyChangedRegion(region);
 		}
 
 		static void WriteColor(std::vector<char>& buffer, int color) {
@@ -77,6 +273,176 @@ namespace spades {
 			buffer.push_back((char)(color >> 24));
 		}
 
+		namespace {
+			struct SnapshotHeader {
+				char magic[8];
+				uint32_t version;
+				uint32_t width, height, depth;
+				uint32_t numColors;
+				uint32_t reserved;
+			};
+
+			const char snapshotMagic[8] = {'S', 'P', 'M', 'A', 'P', 'S', 'N', 'P'};
+			const uint32_t snapshotVersion = 1;
+
+			/** The size of a snapshot with every voxel colored. */
+			const uint64_t MaxSnapshotSize =
+			  sizeof(SnapshotHeader) +
+			  static_cast<uint64_t>(GameMap::DefaultWidth) * GameMap::DefaultHeight *
+			    (sizeof(uint64_t) * 2 + GameMap::DefaultDepth * sizeof(uint32_t));
+
+			void ReadExactly(IStream* stream, void* data, std::size_t numBytes) {
+				if (stream->Read(data, numBytes) != numBytes)
+					SPRaise("The map snapshot is truncated");
+			}
+		} // namespace
+
+		void GameMap::SaveSnapshot(spades::IStream* stream) const {
+			SPADES_MARK_FUNCTION();
+
+			const std::size_t numColumns = DefaultWidth * DefaultHeight;
+			std::vector<uint64_t> colorMasks(numColumns);
+			std::vector<uint32_t> colors;
+
+			if (colorMap) {
+				// Store the surface voxels, which is what a VXL file would contain
+				colors.reserve(numColumns * 4);
+				for (int x = 0; x < DefaultWidth; x++) {
+					for (int y = 0; y < DefaultHeight; y++) {
+						uint64_t solid = solidMap[x][y];
+						uint64_t air = ~solid;
+						uint64_t exposed = (air << 1) | (air >> 1);
+						if (x > 0)
+							exposed |= ~solidMap[x - 1][y];
+						if (x < DefaultWidth - 1)
+							exposed |= ~solidMap[x + 1][y];
+						if (y > 0)
+							exposed |= ~solidMap[x][y - 1];
+						if (y < DefaultHeight - 1)
+							exposed |= ~solidMap[x][y + 1];
+
+						uint64_t mask = solid & exposed;
+						colorMasks[x * DefaultHeight + y] = mask;
+						for (uint64_t bits = mask; bits; bits &= bits - 1) {
+							int z = CountTrailingZeros64(bits);
+							colors.push_back(colorMap[ColorIndex(x, y, z)]);
+						}
+					}
+				}
+			} else {
+				colors.reserve(sparseColors.size() - sparseColorsUnused);
+				for (std::size_t i = 0; i < numColumns; i++) {
+					const ColorColumn& column = sparseColumns[i];
+					uint32_t count = static_cast<uint32_t>(PopCount64(column.mask));
+					colorMasks[i] = column.mask;
+					colors.insert(colors.end(), sparseColors.begin() + column.offset,
+					              sparseColors.begin() + column.offset + count);
+				}
+			}
+
+			SnapshotHeader header;
+			std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+			header.version = snapshotVersion;
+			header.width = DefaultWidth;
+			header.height = DefaultHeight;
+			header.depth = DefaultDepth;
+			header.numColors = static_cast<uint32_t>(colors.size());
+			header.reserved = 0;
+
+			stream->Write(&header, sizeof(header));
+			stream->Write(solidMap, sizeof(solidMap));
+			stream->Write(colorMasks.data(), colorMasks.size() * sizeof(uint64_t));
+			stream->Write(colors.data(), colors.size() * sizeof(uint32_t));
+		}
+
+		GameMap* GameMap::LoadSnapshot(spades::IStream* stream, StorageMode mode) {
+			SPADES_MARK_FUNCTION();
+
+			// Read it into a buffer aligned like a mapped file
+			uint64_t length = stream->GetLength() - stream->GetPosition();
+			if (length > MaxSnapshotSize)
+				SPRaise("The map snapshot is corrupted");
+			std::vector<uint64_t> buffer((static_cast<std::size_t>(length) + 7) / 8);
+			ReadExactly(stream, buffer.data(), static_cast<std::size_t>(length));
+			return LoadSnapshot(reinterpret_cast<const char*>(buffer.data()),
+			                    static_cast<std::size_t>(length), mode);
+		}
+
+		GameMap* GameMap::LoadSnapshot(const char* data, std::size_t size, StorageMode mode) {
+			SPADES_MARK_FUNCTION();
+
+			if (reinterpret_cast<std::uintptr_t>(data) % alignof(uint64_t) != 0)
+				SPInvalidArgument("data");
+
+			SnapshotHeader header;
+			if (size < sizeof(header))
+				SPRaise("The map snapshot is truncated");
+			std::memcpy(&header, data, sizeof(header));
+			if (std::memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0 ||
+			    header.version != snapshotVersion) {
+				SPRaise("Unrecognized map snapshot format");
+			}
+			if (header.width != DefaultWidth || header.height != DefaultHeight ||
+			    header.depth != DefaultDepth) {
+				SPRaise("Unsupported map snapshot dimensions: %dx%dx%d", (int)header.width,
+				        (int)header.height, (int)header.depth);
+			}
+
+			// bound the size computation below before trusting the header
+			if (header.numColors >
+			    static_cast<uint64_t>(DefaultWidth) * DefaultHeight * DefaultDepth) {
+				SPRaise("The map snapshot is corrupted");
+			}
+
+			const std::size_t numColumns = DefaultWidth * DefaultHeight;
+			if (size < sizeof(header) + numColumns * sizeof(uint64_t) * 2 +
+			             header.numColors * sizeof(uint32_t)) {
+				SPRaise("The map snapshot is truncated");
+			}
+			const uint64_t* solid = reinterpret_cast<const uint64_t*>(data + sizeof(header));
+			const uint64_t* colorMasks = solid + numColumns;
+			const uint32_t* colors = reinterpret_cast<const uint32_t*>(colorMasks + numColumns);
+
+			// Only solid voxels have a color
+			std::size_t numMaskedColors = 0;
+			for (std::size_t i = 0; i < numColumns; i++) {
+				if (colorMasks[i] & ~solid[i])
+					SPRaise("The map snapshot is corrupted");
+				numMaskedColors += PopCount64(colorMasks[i]);
+			}
+			if (numMaskedColors != header.numColors)
+				SPRaise("The map snapshot is corrupted");
+
+			auto map = Handle<GameMap>::New(mode);
+			std::memcpy(map->solidMap, solid, sizeof(map->solidMap));
+
+			if (map->colorMap) {
+				const uint32_t* color = colors;
+				for (int x = 0; x < DefaultWidth; x++) {
+					for (int y = 0; y < DefaultHeight; y++) {
+						uint64_t mask = colorMasks[x * DefaultHeight + y];
+						for (uint64_t bits = mask; bits; bits &= bits - 1) {
+							int z = CountTrailingZeros64(bits);
+							map->colorMap[ColorIndex(x, y, z)] = *(color++);
+						}
+					}
+				}
+			} else {
+				uint32_t offset = 0;
+				for (std::size_t i = 0; i < numColumns; i++) {
+					ColorColumn& column = map->sparseColumns[i];
+					uint32_t count = static_cast<uint32_t>(PopCount64(colorMasks[i]));
+					column.mask = colorMasks[i];
+					column.offset = count ? offset : 0;
+					column.capacity = count;
+					offset += count;
+				}
+				map->sparseColors.assign(colors, colors + header.numColors);
+			}
+
+			return std::move(map).Unmanage();
+		}
+
 		// base on pysnip
 		void GameMap::Save(spades::IStream* stream) {
 			int w = Width();
@@ -159,19 +525,6 @@ namespace spades {
 			return IsSolid((int)x, (int)y, sz);
 		}
 
-		bool GameMap::ClipWorld(int x, int y, int z) const {
-			if (x < 0 || x >= DefaultWidth || y < 0 || y >= DefaultHeight || z < 0)
-				return 0;
-			int sz = (int)z;
-			if (sz == DefaultDepth - 1)
-				sz = DefaultDepth - 2;
-			else if (sz >= DefaultDepth - 1)
-				return 1;
-			else if (sz < 0)
-				return 0;
-			return IsSolid((int)x, (int)y, sz);
-		}
-
 		bool GameMap::ClipBox(float x, float y, float z) const {
 			SPAssert(!std::isnan(x));
 			SPAssert(!std::isnan(y));
@@ -380,79 +733,28 @@ namespace spades {
 			return result;
 		}
 
-		GameMap* GameMap::Load(spades::IStream* stream, std::function<void(int)> onProgress) {
+		GameMap* GameMap::Load(spades::IStream* stream, std::function<void(int)> onProgress,
+		                       StorageMode mode) {
 			SPADES_MARK_FUNCTION();
 
-			RandomAccessAdaptor view{*stream};
-
-			size_t pos = 0;
-
-			auto map = Handle<GameMap>::New();
+			GameMapDecoder decoder{mode};
 
 			if (onProgress)
 				onProgress(0);
 
-			for (int y = 0; y < DefaultHeight; y++) {
-				for (int x = 0; x < DefaultWidth; x++) {
-					map->solidMap[x][y] = 0xFFFFFFFFFFFFFFFFULL;
+			std::vector<char> chunk(65536);
+			while (!decoder.IsDataComplete()) {
+				std::size_t numBytes = stream->Read(chunk.data(), chunk.size());
+				if (numBytes == 0)
+					break;
 
-					int z = 0;
-					for (;;) {
-						// Read a block ahead in attempt to minimize the number of calls to
-						// `IStream::Read`
-						view.Prefetch(pos + DefaultWidth);
-
-						int number_4byte_chunks = view.Read<int8_t>(pos);
-						int top_color_start = view.Read<int8_t>(pos + 1);
-						int top_color_end = view.Read<int8_t>(pos + 2); // inclusive
-
-						for (int i = z; i < top_color_start; i++)
-							map->Set(x, y, i, false, 0, true);
-
-						size_t colorOffset = pos + 4;
-						for (z = top_color_start; z <= top_color_end; z++) {
-							uint32_t col = swapColor(view.Read<uint32_t>(colorOffset));
-							map->Set(x, y, z, true, col, true);
-							colorOffset += 4;
-						}
-
-						if (top_color_end == DefaultDepth - 2)
-							map->Set(x, y, DefaultDepth - 1, true, map->GetColor(x, y, DefaultDepth - 2), true);
-
-						int len_bottom = top_color_end - top_color_start + 1;
-
-						// check for end of data marker
-						if (number_4byte_chunks == 0) {
-							// infer ACTUAL number of 4-byte chunks from the length of the color data
-							pos += 4 * (len_bottom + 1);
-							break;
-						}
-
-						// infer the number of bottom colors in next span from chunk length
-						int len_top = (number_4byte_chunks - 1) - len_bottom;
-
-						// now skip the v pointer past the data to the beginning of the next span
-						pos += (int)view.Read<int8_t>(pos) * 4;
+				decoder.Feed(chunk.data(), numBytes);
 
-						int bottom_color_end = view.Read<int8_t>(pos + 3); // aka air start
-						int bottom_color_start = bottom_color_end - len_top;
-
-						for (z = bottom_color_start; z < bottom_color_end; z++) {
-							uint32_t col = swapColor(view.Read<uint32_t>(colorOffset));
-							map->Set(x, y, z, true, col, true);
-							colorOffset += 4;
-						}
-
-						if (bottom_color_end == DefaultDepth - 1)
-							map->Set(x, y, DefaultDepth - 1, true, map->GetColor(x, y, DefaultDepth - 2), true);
-					}
-
-					if (onProgress)
-						onProgress(x + y * DefaultHeight + 1);
-				}
+				if (onProgress)
+					onProgress(decoder.GetNumReceivedColumns());
 			}
 
-			return std::move(map).Unmanage();
+			return decoder.Finish().Unmanage();
 		}
 	} // namespace client
 } // namespace spades
\ No newline at end of file
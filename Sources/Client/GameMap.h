@@ -21,10 +21,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
-#include <list>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <Core/Debug.h>
 #include <Core/Math.h>
@@ -36,6 +38,8 @@ namespace spades {
 	class IStream;
 	namespace client {
 		class GameMap : public RefCountedObject {
+			friend class GameMapDecoder;
+
 		protected:
 			~GameMap();
 
@@ -46,20 +50,66 @@ namespace spades {
 				DefaultHeight = 512,
 				DefaultDepth = 64 // should be <= 64
 			};
-			GameMap();
+
+			/**
+			 * Specifies how voxel colors are stored.
+			 */
+			enum class StorageMode {
+				/** A color for every voxel (64 MiB). Fastest `GetColor`. */
+				Dense,
+				/**
+				 * Colors are stored only for the voxels that were given one explicitly (usually
+				 * the surface voxels of a VXL map), packed per column. Other solid voxels report
+				 * a procedural dirt color.
+				 */
+				Sparse
+			};
+
+			/** Returns the storage mode selected by `cg_sparseMapStorage`. */
+			static StorageMode GetDefaultStorageMode();
+
+			GameMap(StorageMode mode = GetDefaultStorageMode());
 
 			/**
 			 * Construct a `GameMap` from VOXLAP5 terrain data supplied by the specified stream.
+			 * The columns are decoded in parallel by `GameMapDecoder`.
 			 *
-			 * @param onProgress Called whenever a new column (a set of voxels with the same X and Y
-			 *                   coordinates) is loaded from the stream. The parameter indicates
-			 *					 the number of columns loaded
+			 * @param onProgress Called whenever new columns (sets of voxels with the same X and Y
+			 *                   coordinates) are read from the stream. The parameter indicates
+			 *					 the number of columns read
 			 *					 (up to `DefaultWidth * DefaultHeight`).
 			 */
-			static GameMap* Load(IStream*, std::function<void(int)> onProgress = {});
+			static GameMap* Load(IStream*, std::function<void(int)> onProgress = {},
+			                     StorageMode mode = GetDefaultStorageMode());
 
 			void Save(IStream*);
 
+			/**
+			 * Writes the voxels in an uncompressed format that can be loaded by `LoadSnapshot`
+			 * without any parsing. Used by `MapCache`.
+			 *
+			 * After a header, the file has the following arrays with no padding between them,
+			 * so it can also be memory-mapped:
+			 *
+			 *  - `uint64_t solid[DefaultWidth * DefaultHeight]`, indexed by `x * DefaultHeight + y`
+			 *  - `uint64_t colorMasks[DefaultWidth * DefaultHeight]`: the voxels with a color
+			 *  - `uint32_t colors[numColors]`, in the ascending order of the column index and Z
+			 *
+			 * The colors of the other solid voxels are procedurally generated on load. A map
+			 * using the dense storage writes the colors of its surface voxels.
+			 */
+			void SaveSnapshot(IStream*) const;
+
+			/** Reads the data written by `SaveSnapshot`. */
+			static GameMap* LoadSnapshot(IStream*, StorageMode mode = GetDefaultStorageMode());
+
+			/**
+			 * Reads the data written by `SaveSnapshot` from memory, such as a mapped file,
+			 * without copying the arrays first. `data` must be aligned to 8 bytes.
+			 */
+			static GameMap* LoadSnapshot(const char* data, std::size_t size,
+			                             StorageMode mode = GetDefaultStorageMode());
+
 			int Width() const { return DefaultWidth; }
 			int Height() const { return DefaultHeight; }
 			int Depth() const { return DefaultDepth; }
@@ -123,11 +173,13 @@ namespace spades {
 			/** @return 0xHHBBGGRR where HH is health (up to 100) */
 			inline uint32_t GetColor(int x, int y, int z) const {
 				SPAssert(IsValidMapCoord(x, y, z));
-				return colorMap[x][y][z];
+				if (colorMap)
+					return colorMap[ColorIndex(x, y, z)];
+				return GetSparseColor(x, y, z);
 			}
 
 			inline uint32_t GetColorWrapped(int x, int y, int z) const {
-				return colorMap[x & (Width() - 1)][y & (Height() - 1)][z & (Depth() - 1)];
+				return GetColor(x & (Width() - 1), y & (Height() - 1), z & (Depth() - 1));
 			}
 
 			inline void Set(int x, int y, int z, bool solid, uint32_t color, bool unsafe = false) {
@@ -145,23 +197,84 @@ namespace spades {
 					solidMap[x][y] = value;
 				}
 
-				if (solid && color != colorMap[x][y][z]) {
-					changed = true;
-					colorMap[x][y][z] = color;
+				if (solid) {
+					if (colorMap) {
+						uint32_t& cell = colorMap[ColorIndex(x, y, z)];
+						if (color != cell) {
+							changed = true;
+							cell = color;
+						}
+					} else if (SetSparseColor(x, y, z, color)) {
+						changed = true;
+					}
+				} else if (!colorMap) {
+					// The color of an air voxel is never observed
+					RemoveSparseColor(x, y, z);
 				}
 
-				if (!unsafe && changed) {
-					std::lock_guard<std::mutex> guard{listenersMutex};
-					for (auto* l : listeners)
-						l->GameMapChanged(x, y, z, this);
+				if (changed) {
+					revision++;
+					if (!unsafe)
+						NotifyChanged(x, y, z);
 				}
 			}
 
+			/** Incremented by every change to the map. Can be used to validate caches. */
+			uint32_t GetRevision() const { return revision; }
+
+			StorageMode GetStorageMode() const {
+				return colorMap ? StorageMode::Dense : StorageMode::Sparse;
+			}
+
+			/** Returns the approximate number of bytes used to store the voxel data. */
+			std::size_t GetMemoryUsage() const;
+
+			/**
+			 * Creates a copy of the voxels in the same storage mode. The sparse colors are
+			 * compacted in the copy. The listeners are not copied.
+			 *
+			 * Must not race with the modification of this map.
+			 */
+			Handle<GameMap> Clone() const;
+
+			/**
+			 * Adds a listener. The listeners are notified without locking, so `RemoveListener`
+			 * must not race with the modification of the map.
+			 */
 			void AddListener(IGameMapListener*);
 			void RemoveListener(IGameMapListener*);
 
+			/**
+			 * Starts a batch of changes. Until the matching `EndBatch`, the listeners are not
+			 * notified of each changed voxel. Instead, the bounding box of the changes is reported
+			 * by `IGameMapListener::GameMapChangedRegion`, usually in a single call by `EndBatch`.
+			 * Batches can be nested. A batch must be started and ended by the thread modifying the
+			 * map.
+			 */
+			void BeginBatch() { batchDepth++; }
+			void EndBatch();
+
+			/** Calls `BeginBatch` on construction and `EndBatch` on destruction. */
+			class BatchScope {
+				GameMap& map;
+
+			public:
+				BatchScope(GameMap& map) : map(map) { map.BeginBatch(); }
+				~BatchScope() { map.EndBatch(); }
+				BatchScope(const BatchScope&) = delete;
+				void operator=(const BatchScope&) = delete;
+			};
+
 			bool ClipBox(int x, int y, int z) const;
-			bool ClipWorld(int x, int y, int z) const;
+			inline bool ClipWorld(int x, int y, int z) const {
+				if (x < 0 || x >= Width() || y < 0 || y >= Height() || z < 0)
+					return false;
+				if (z == Depth() - 1)
+					z = Depth() - 2;
+				else if (z >= Depth() - 1)
+					return true;
+				return ((GetSolidMap(x, y) >> (uint64_t)z) & 1ULL) != 0;
+			}
 			bool ClipBox(float x, float y, float z) const;
 			bool ClipWorld(float x, float y, float z) const;
 
@@ -206,10 +319,87 @@ namespace spades {
 			}
 
 		private:
+			/**
+			 * A column of the sparse color storage. The colors of the voxels whose bits are set
+			 * in `mask` are stored in `sparseColors[offset...]` in the ascending order of Z.
+			 */
+			struct ColorColumn {
+				uint64_t mask;
+				uint32_t offset;
+				uint32_t capacity;
+			};
+
+			static inline std::size_t ColorIndex(int x, int y, int z) {
+				return ((std::size_t)x * DefaultHeight + (std::size_t)y) * DefaultDepth +
+				       (std::size_t)z;
+			}
+
+			/** The color reported for a solid voxel without an explicitly stored color. */
+			inline uint32_t GetImplicitColor(int x, int y, int z) const {
+				int j = groundCols[(z >> 3) + 1];
+				int i = groundCols[(z >> 3)];
+				i += ((j - i) * (z & 7)) >> 3;
+				i += 4 * (abs((x & 7) - 4) << 16 | abs((y & 7) - 4) << 8 | abs((z & 7) - 4));
+
+				// Deterministic replacement for `rand() % 7` used by `GetDirtColor`
+				uint32_t hash = (uint32_t)x * 73856093U ^ (uint32_t)y * 19349663U ^
+				                (uint32_t)z * 83492791U;
+				i += 0x10101 * (int)((hash >> 8) % 7);
+
+				uint32_t col = (uint32_t)i;
+				return ((col & 0xFF) << 16) | (col & 0xFF00) | ((col >> 16) & 0xFF) |
+				       (100U << 24);
+			}
+
+			inline uint32_t GetSparseColor(int x, int y, int z) const {
+				const ColorColumn& column = sparseColumns[(std::size_t)x * DefaultHeight + y];
+				uint64_t bit = 1ULL << z;
+				if (column.mask & bit)
+					return sparseColors[column.offset + PopCount64(column.mask & (bit - 1))];
+				return GetImplicitColor(x, y, z);
+			}
+
+			/** @return `true` if the color was changed. */
+			bool SetSparseColor(int x, int y, int z, uint32_t color);
+			void RemoveSparseColor(int x, int y, int z);
+			void CompactSparseColors();
+
 			uint64_t solidMap[DefaultWidth][DefaultHeight];
-			uint32_t colorMap[DefaultWidth][DefaultHeight][DefaultDepth];
-			std::list<IGameMapListener*> listeners;
+
+			/** Dense color storage. `nullptr` if the sparse storage is in use. */
+			std::unique_ptr<uint32_t[]> colorMap;
+
+			/** Sparse color storage, indexed by `x * DefaultHeight + y`. */
+			std::unique_ptr<ColorColumn[]> sparseColumns;
+			std::vector<uint32_t> sparseColors;
+			/** The number of elements in `sparseColors` not owned by any column. */
+			std::size_t sparseColorsUnused = 0;
+
+			/**
+			 * The maximum number of voxels in a region reported by a batch. When a change in a
+			 * batch would grow the region beyond this, the region is reported early.
+			 */
+			static constexpr int64_t MaxBatchRegionVolume = 32 * 32 * 32;
+
+			void NotifyChanged(int x, int y, int z);
+			void NotifyChangedRegion(const IntAABB3&);
+
+			/** Immutable once published; `AddListener` and `RemoveListener` replace it. */
+			using ListenerList = std::vector<IGameMapListener*>;
+			std::atomic<const ListenerList*> listeners{nullptr};
+			/**
+			 * Every list published to `listeners`. The replaced ones are kept until the map is
+			 * destroyed because a notification might still be iterating over them. (Listeners
+			 * are only added or removed when a renderer or an audio device is attached.)
+			 */
+			std::vector<std::unique_ptr<const ListenerList>> listenerLists;
+			/** Serializes `AddListener` and `RemoveListener`. */
 			std::mutex listenersMutex;
+
+			int batchDepth = 0;
+			IntAABB3 batchRegion = IntAABB3::Empty();
+
+			uint32_t revision = 0;
 		};
 	} // namespace client
 } // namespace spades
\ No newline at end of file
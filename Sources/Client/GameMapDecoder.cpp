@@ -0,0 +1,326 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "GameMapDecoder.h"
+#include <Core/Debug.h>
+#include <Core/Exception.h>
+#include <Core/Math.h>
+#include <Core/ThreadPool.h>
+
+namespace spades {
+	namespace client {
+		namespace {
+			enum {
+				Width = GameMap::DefaultWidth,
+				Height = GameMap::DefaultHeight,
+				Depth = GameMap::DefaultDepth
+			};
+
+			/** Converts a VXL color (0xAARRGGBB) to the `GameMap` format. */
+			inline uint32_t ConvertColor(uint32_t col) {
+				return ((col & 0xFF) << 16) | (col & 0xFF00) | ((col >> 16) & 0xFF) |
+				       (100U << 24);
+			}
+
+			/** Returns a mask of the Z coordinates `[begin, end)`. `end` must be `<= 64`. */
+			inline uint64_t RangeMask(int begin, int end) {
+				if (begin >= end)
+					return 0;
+				uint64_t upper = end >= 64 ? ~0ULL : (1ULL << end) - 1;
+				return upper & ~((1ULL << begin) - 1);
+			}
+		} // namespace
+
+		GameMapDecoder::GameMapDecoder(GameMap::StorageMode mode)
+		    : map{Handle<GameMap>::New(mode)} {
+			SPADES_MARK_FUNCTION();
+
+			if (mode == GameMap::StorageMode::Sparse) {
+				// A typical map has a few surface voxels per column
+				map->sparseColors.reserve(Width * Height * 4);
+			}
+		}
+
+		GameMapDecoder::~GameMapDecoder() { SPADES_MARK_FUNCTION(); }
+
+		void GameMapDecoder::Feed(const char* bytes, std::size_t numBytes) {
+			SPADES_MARK_FUNCTION();
+
+			if (IsDataComplete()) {
+				// Trailing data is ignored
+				return;
+			}
+
+			buffer.insert(buffer.end(), bytes, bytes + numBytes);
+
+			std::size_t end;
+			while (!IsDataComplete() && ScanColumn(scanPos, end)) {
+				columnOffsets.push_back(scanPos);
+				scanPos = end;
+				numScannedColumns++;
+			}
+
+			// Wait for enough rows to keep all threads busy unless it's the last batch
+			int numCompleteRows = numScannedColumns / Width;
+			int batchRows = RowsPerBand * ThreadPool::GetInstance().GetNumParticipants();
+			if (numCompleteRows - numDecodedRows >= batchRows ||
+			    (IsDataComplete() && numDecodedRows < Height)) {
+				DecodeRows(numCompleteRows);
+			}
+		}
+
+		Handle<GameMap> GameMapDecoder::Finish() {
+			SPADES_MARK_FUNCTION();
+
+			if (!IsDataComplete()) {
+				SPRaise("The map data is truncated: only %d of %d columns were received",
+				        numScannedColumns, Width * Height);
+			}
+
+			if (numDecodedRows < Height)
+				DecodeRows(Height);
+
+			if (map->GetStorageMode() == GameMap::StorageMode::Sparse)
+				map->sparseColors.shrink_to_fit();
+
+			std::vector<char>().swap(buffer);
+			bands.clear();
+
+			return map;
+		}
+
+		bool GameMapDecoder::ScanColumn(std::size_t pos, std::size_t& outEnd) const {
+			const std::size_t size = buffer.size();
+			for (;;) {
+				if (pos + 4 > size)
+					return false;
+
+				int numChunks = (int8_t)buffer[pos];
+				int topColorStart = (int8_t)buffer[pos + 1];
+				int topColorEnd = (int8_t)buffer[pos + 2]; // inclusive
+				int lenBottom = topColorEnd - topColorStart + 1;
+
+				// Reject spans that would make the decoder write outside the column or read
+				// outside the column data
+				bool valid = topColorStart >= 0 && topColorEnd < Depth && lenBottom >= 0;
+				if (valid && numChunks == 0) {
+					// End of the column
+					std::size_t end = pos + 4 * (lenBottom + 1);
+					if (end > size)
+						return false;
+					outEnd = end;
+					return true;
+				}
+
+				valid = valid && numChunks >= lenBottom + 1;
+				if (valid) {
+					int lenTop = (numChunks - 1) - lenBottom;
+					pos += numChunks * 4;
+					if (pos + 4 > size)
+						return false;
+
+					int bottomColorEnd = (int8_t)buffer[pos + 3];
+					valid = bottomColorEnd <= Depth && bottomColorEnd - lenTop >= 0;
+				}
+
+				if (!valid) {
+					SPRaise("Malformed map data in column (%d, %d)", numScannedColumns % Width,
+					        numScannedColumns / Width);
+				}
+			}
+		}
+
+		void GameMapDecoder::DecodeRows(int endRow) {
+			SPADES_MARK_FUNCTION();
+
+			SPAssert(endRow * Width <= numScannedColumns);
+			SPAssert(endRow > numDecodedRows);
+
+			std::size_t numBands = (endRow - numDecodedRows + RowsPerBand - 1) / RowsPerBand;
+			if (bands.size() < numBands)
+				bands.resize(numBands);
+			for (std::size_t i = 0; i < numBands; i++) {
+				Band& band = bands[i];
+				band.firstRow = numDecodedRows + static_cast<int>(i) * RowsPerBand;
+				band.numRows = std::min<int>(RowsPerBand, endRow - band.firstRow);
+			}
+
+			ParallelFor(numBands, 1, [this](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; i++)
+					DecodeBand(bands[i]);
+			});
+
+			if (map->GetStorageMode() == GameMap::StorageMode::Sparse) {
+				// Append the bands' colors to the pool in order
+				std::vector<uint32_t>& pool = map->sparseColors;
+				for (std::size_t i = 0; i < numBands; i++) {
+					const Band& band = bands[i];
+					uint32_t offset = static_cast<uint32_t>(pool.size());
+					for (int y = band.firstRow, k = 0; y < band.firstRow + band.numRows; y++) {
+						for (int x = 0; x < Width; x++, k++) {
+							GameMap::ColorColumn& column =
+							  map->sparseColumns[(std::size_t)x * Height + y];
+							uint64_t mask = band.colorMasks[k];
+							uint32_t count = static_cast<uint32_t>(PopCount64(mask));
+							column.mask = mask;
+							column.offset = count ? offset : 0;
+							column.capacity = count;
+							offset += count;
+						}
+					}
+					pool.insert(pool.end(), band.colors.begin(), band.colors.end());
+				}
+			}
+
+			// Discard the decoded data
+			std::size_t numColumns = static_cast<std::size_t>(endRow - numDecodedRows) * Width;
+			std::size_t consumed =
+			  numColumns < columnOffsets.size() ? columnOffsets[numColumns] : scanPos;
+			columnOffsets.erase(columnOffsets.begin(), columnOffsets.begin() + numColumns);
+			for (std::size_t& offset : columnOffsets)
+				offset -= consumed;
+			buffer.erase(buffer.begin(), buffer.begin() + consumed);
+			scanPos -= consumed;
+
+			numDecodedRows = endRow;
+		}
+
+		void GameMapDecoder::DecodeBand(Band& band) {
+			GameMap& m = *map;
+			bool sparse = m.GetStorageMode() == GameMap::StorageMode::Sparse;
+			std::size_t firstColumn =
+			  static_cast<std::size_t>(band.firstRow - numDecodedRows) * Width;
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+
+			band.colorMasks.clear();
+			band.colors.clear();
+
+			Column column;
+			for (int y = band.firstRow, k = 0; y < band.firstRow + band.numRows; y++) {
+				for (int x = 0; x < Width; x++, k++) {
+					DecodeColumn(data + columnOffsets[firstColumn + k], x, y, column);
+
+					m.solidMap[x][y] = column.solid;
+
+					if (!sparse) {
+						uint32_t* colors = &m.colorMap[GameMap::ColorIndex(x, y, 0)];
+						for (uint64_t bits = column.written; bits; bits &= bits - 1) {
+							int z = CountTrailingZeros64(bits);
+							colors[z] = column.colors[z];
+						}
+						continue;
+					}
+
+					// The colors of air voxels are not stored, and neither are the ones
+					// equal to the implicit color (like `GameMap::SetSparseColor` does)
+					uint64_t mask = 0;
+					for (uint64_t bits = column.written & column.solid; bits; bits &= bits - 1) {
+						int z = CountTrailingZeros64(bits);
+						if (column.colors[z] == m.GetImplicitColor(x, y, z))
+							continue;
+						mask |= 1ULL << z;
+						band.colors.push_back(column.colors[z]);
+					}
+					band.colorMasks.push_back(mask);
+				}
+			}
+		}
+
+		void GameMapDecoder::DecodeColumn(const uint8_t* data, int x, int y,
+		                                  Column& column) const {
+			// This replicates the original `GameMap::Load`, which called `GameMap::Set` for
+			// every voxel. `ScanColumn` has already validated the span headers.
+			uint64_t solid = ~0ULL;
+			uint64_t written = 0;
+			uint32_t* colors = column.colors;
+
+			// The color of the voxel at `z` as seen by `GameMap::GetColor`. The sparse storage
+			// forgets the color of a voxel that became air.
+			bool sparse = map->GetStorageMode() == GameMap::StorageMode::Sparse;
+			auto getColor = [&](int z) {
+				uint64_t stored = sparse ? written & solid : written;
+				return ((stored >> z) & 1) ? colors[z] : map->GetColor(x, y, z);
+			};
+			auto readColor = [&](std::size_t offset) {
+				uint32_t col;
+				std::memcpy(&col, data + offset, 4);
+				return ConvertColor(col);
+			};
+
+			std::size_t pos = 0;
+			int z = 0;
+			for (;;) {
+				int numChunks = (int8_t)data[pos];
+				int topColorStart = (int8_t)data[pos + 1];
+				int topColorEnd = (int8_t)data[pos + 2]; // inclusive
+
+				solid &= ~RangeMask(z, topColorStart);
+
+				std::size_t colorOffset = pos + 4;
+				for (z = topColorStart; z <= topColorEnd; z++) {
+					colors[z] = readColor(colorOffset);
+					solid |= 1ULL << z;
+					written |= 1ULL << z;
+					colorOffset += 4;
+				}
+
+				if (topColorEnd == Depth - 2) {
+					colors[Depth - 1] = getColor(Depth - 2);
+					solid |= 1ULL << (Depth - 1);
+					written |= 1ULL << (Depth - 1);
+				}
+
+				int lenBottom = topColorEnd - topColorStart + 1;
+
+				// check for end of data marker
+				if (numChunks == 0)
+					break;
+
+				// infer the number of bottom colors in next span from chunk length
+				int lenTop = (numChunks - 1) - lenBottom;
+
+				// now skip the v pointer past the data to the beginning of the next span
+				pos += numChunks * 4;
+
+				int bottomColorEnd = (int8_t)data[pos + 3]; // aka air start
+				int bottomColorStart = bottomColorEnd - lenTop;
+
+				for (z = bottomColorStart; z < bottomColorEnd; z++) {
+					colors[z] = readColor(colorOffset);
+					solid |= 1ULL << z;
+					written |= 1ULL << z;
+					colorOffset += 4;
+				}
+
+				if (bottomColorEnd == Depth - 1) {
+					colors[Depth - 1] = getColor(Depth - 2);
+					solid |= 1ULL << (Depth - 1);
+					written |= 1ULL << (Depth - 1);
+				}
+			}
+
+			column.solid = solid;
+			column.written = written;
+		}
+	} // namespace client
+} // namespace spades
@@ -0,0 +1,129 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GameMap.h"
+#include <Core/RefCountedObject.h>
+
+namespace spades {
+	namespace client {
+		/**
+		 * Decodes VOXLAP5 terrain data that arrives in pieces, e.g., from a decompressor
+		 * that is fed over the network.
+		 *
+		 * The incoming data is scanned for column boundaries, which only requires reading
+		 * the span headers. Once a batch of complete rows (columns with the same Y
+		 * coordinate) is located, the rows are split into bands that are decoded in parallel
+		 * on the `ThreadPool`. Rows are completed in the ascending order of Y, so a consumer
+		 * can start processing the decoded part of the map (see
+		 * `GameMapWrapper::RebuildRows`) before the rest of the data has arrived.
+		 *
+		 * This class is not thread-safe.
+		 */
+		class GameMapDecoder {
+		public:
+			GameMapDecoder(GameMap::StorageMode mode = GameMap::GetDefaultStorageMode());
+			~GameMapDecoder();
+
+			GameMapDecoder(const GameMapDecoder&) = delete;
+			void operator=(const GameMapDecoder&) = delete;
+
+			/**
+			 * Appends decompressed data. Complete rows might be decoded before this method
+			 * returns. Throws an exception if the data is malformed.
+			 */
+			void Feed(const char* bytes, std::size_t numBytes);
+
+			/** Returns the number of columns whose data has completely arrived. */
+			int GetNumReceivedColumns() const { return numScannedColumns; }
+
+			/** Returns `true` if the data of all columns has arrived. */
+			bool IsDataComplete() const {
+				return numScannedColumns == GameMap::DefaultWidth * GameMap::DefaultHeight;
+			}
+
+			/** Returns the number of rows decoded into `GetGameMap()` so far. */
+			int GetNumDecodedRows() const { return numDecodedRows; }
+
+			/**
+			 * Returns the map being decoded. Only the rows `[0, GetNumDecodedRows())` have
+			 * their final contents.
+			 */
+			GameMap& GetGameMap() { return *map; }
+
+			/**
+			 * Decodes the remaining rows and returns the map. Throws an exception if the data
+			 * is truncated.
+			 */
+			Handle<GameMap> Finish();
+
+		private:
+			enum { RowsPerBand = 4 };
+
+			/** The decoder's output for a range of rows. */
+			struct Band {
+				int firstRow, numRows;
+				/** The sparse storage only: `ColorColumn::mask` of each column. */
+				std::vector<uint64_t> colorMasks;
+				/** The sparse storage only: the colors stored by the columns, in order. */
+				std::vector<uint32_t> colors;
+			};
+
+			/** The voxels of a column. */
+			struct Column {
+				uint64_t solid;
+				/** The voxels that were assigned a color. */
+				uint64_t written;
+				uint32_t colors[GameMap::DefaultDepth];
+			};
+
+			/**
+			 * Finds the end of the column starting at `buffer[pos]`. Returns `false` if the
+			 * column is not complete yet.
+			 */
+			bool ScanColumn(std::size_t pos, std::size_t& outEnd) const;
+
+			/** Decodes the rows `[numDecodedRows, endRow)`, which must be scanned. */
+			void DecodeRows(int endRow);
+			void DecodeBand(Band&);
+			void DecodeColumn(const uint8_t* data, int x, int y, Column&) const;
+
+			Handle<GameMap> map;
+
+			/** The received data starting at the first column not decoded yet. */
+			std::vector<char> buffer;
+			/** The offset of the first column not scanned yet. */
+			std::size_t scanPos = 0;
+			/** The offsets of the columns scanned but not decoded yet. */
+			std::vector<std::size_t> columnOffsets;
+
+			int numScannedColumns = 0;
+			int numDecodedRows = 0;
+
+			/** Reused between batches to avoid reallocation. */
+			std::vector<Band> bands;
+		};
+	} // namespace client
+} // namespace spades
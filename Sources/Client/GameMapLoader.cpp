@@ -19,9 +19,14 @@
  */
 
 #include <exception>
+#include <vector>
+
+#include <zlib.h>
 
 #include "GameMap.h"
+#include "GameMapDecoder.h"
 #include "GameMapLoader.h"
+#include "GameMapWrapper.h"
 #include <Core/Debug.h>
 #include <Core/DeflateStream.h>
 #include <Core/Exception.h>
@@ -36,6 +41,7 @@ namespace spades {
 			// The following fields are mutually exclusive.
 			std::exception_ptr exceptionThrown;
 			Handle<GameMap> gameMap;
+			std::unique_ptr<GameMapWrapper> gameMapWrapper;
 		};
 
 		struct GameMapLoader::Decoder : public IRunnable {
@@ -53,10 +59,30 @@ namespace spades {
 				try {
 					DeflateStream inflate(rawDataReader.get(), CompressModeDecompress, false);
 
-					GameMap* gameMapPtr =
-					  GameMap::Load(&inflate, [this](int x) { HandleProgress(x); });
-
-					result->gameMap = Handle<GameMap>{gameMapPtr, false};
+					GameMapDecoder decoder;
+					auto wrapper = stmp::make_unique<GameMapWrapper>(decoder.GetGameMap());
+					wrapper->BeginRebuild();
+
+					uLong checksum = crc32(0L, Z_NULL, 0);
+					std::vector<char> chunk(16384);
+					while (!decoder.IsDataComplete()) {
+						std::size_t numBytes = inflate.Read(chunk.data(), chunk.size());
+						if (numBytes == 0)
+							break;
+
+						checksum = crc32(checksum, reinterpret_cast<const Bytef*>(chunk.data()),
+						                 static_cast<uInt>(numBytes));
+						decoder.Feed(chunk.data(), numBytes);
+						HandleProgress(decoder.GetNumReceivedColumns());
+
+						// Process the decoded rows while the rest is still arriving
+						wrapper->RebuildRows(decoder.GetNumDecodedRows());
+					}
+
+					result->gameMap = decoder.Finish();
+					wrapper->RebuildRows(decoder.GetNumDecodedRows());
+					result->gameMapWrapper = std::move(wrapper);
+					parent.dataChecksum = static_cast<uint32_t>(checksum);
 				} catch (...) {
 					// Capture the current exception
 					result->exceptionThrown = std::current_exception();
@@ -71,7 +97,8 @@ namespace spades {
 			}
 		};
 
-		GameMapLoader::GameMapLoader() : progressCell{0} {
+		GameMapLoader::GameMapLoader()
+		    : progressCell{0}, rawDataChecksum{static_cast<uint32_t>(crc32(0L, Z_NULL, 0))} {
 			SPADES_MARK_FUNCTION();
 
 			auto pipe = CreatePipeStream();
@@ -85,9 +112,23 @@ namespace spades {
 			decodingThread->Start();
 		}
 
+		GameMapLoader::GameMapLoader(Handle<GameMap> cachedMap)
+		    : progressCell{512 * 512}, fromCache{true}, rawDataChecksum{0} {
+			SPADES_MARK_FUNCTION();
+
+			SPAssert(cachedMap);
+
+			auto result = stmp::make_unique<Result>();
+			result->gameMap = std::move(cachedMap);
+			resultCell.store(std::move(result));
+		}
+
 		GameMapLoader::~GameMapLoader() {
 			SPADES_MARK_FUNCTION();
 
+			if (fromCache)
+				return;
+
 			// Hang up the writer. This causes the decoder thread to exit gracefully.
 			rawDataWriter.reset();
 
@@ -101,6 +142,8 @@ namespace spades {
 			if (!rawDataWriter)
 				SPRaise("The raw data channel is already closed.");
 			rawDataWriter->Write(bytes, numBytes);
+			rawDataChecksum = static_cast<uint32_t>(crc32(
+			  rawDataChecksum, reinterpret_cast<const Bytef*>(bytes), static_cast<uInt>(numBytes)));
 		}
 
 		void GameMapLoader::MarkEOF() {
@@ -116,7 +159,8 @@ namespace spades {
 		void GameMapLoader::WaitComplete() {
 			SPADES_MARK_FUNCTION();
 
-			decodingThread->Join();
+			if (decodingThread)
+				decodingThread->Join();
 
 			SPAssert(IsComplete());
 		}
@@ -125,7 +169,9 @@ namespace spades {
 			return static_cast<float>(progressCell.load(std::memory_order_relaxed)) / (512 * 512);
 		}
 
-		Handle<GameMap> GameMapLoader::TakeGameMap() {
+		uint32_t GameMapLoader::GetDataChecksum() const { return dataChecksum; }
+
+		Handle<GameMap> GameMapLoader::TakeGameMap(std::unique_ptr<GameMapWrapper>* outWrapper) {
 			SPADES_MARK_FUNCTION();
 
 			SPAssert(IsComplete());
@@ -134,6 +180,8 @@ namespace spades {
 			SPAssert(result);
 
 			if (result->gameMap) {
+				if (outWrapper)
+					*outWrapper = std::move(result->gameMapWrapper);
 				return std::move(result->gameMap);
 			} else {
 				std::rethrow_exception(result->exceptionThrown);
@@ -30,14 +30,24 @@ namespace spades {
 
 	namespace client {
 		class GameMap;
+		class GameMapWrapper;
 
 		/**
 		 * A streaming map loader that can decode a game map in a streaming fashion and
 		 * report the progress based on the incomplete decoded data.
+		 *
+		 * The decoding thread hands the decompressed data to `GameMapDecoder` and computes the
+		 * connectivity (`GameMapWrapper`) of the rows decoded so far while waiting for more
+		 * data.
 		 */
 		class GameMapLoader {
 		public:
 			GameMapLoader();
+			/**
+			 * Constructs a loader that is already complete with a map that was loaded from
+			 * `MapCache`. No data should be added to it.
+			 */
+			explicit GameMapLoader(Handle<GameMap> cachedMap);
 			~GameMapLoader();
 
 			GameMapLoader(const GameMapLoader&) = delete;
@@ -71,6 +81,18 @@ namespace spades {
 			 */
 			float GetProgress();
 
+			/** Returns `true` if the loader was constructed with a cached map. */
+			bool IsFromCache() const { return fromCache; }
+
+			/** Returns the CRC32 of the data added by `AddRawChunk` so far. */
+			uint32_t GetRawDataChecksum() const { return rawDataChecksum; }
+
+			/**
+			 * Returns the CRC32 of the decompressed map data. Only valid after the decoding
+			 * completed successfully.
+			 */
+			uint32_t GetDataChecksum() const;
+
 			/**
 			 * Gets the loaded `GameMap` and takes the ownership of it.
 			 *
@@ -78,8 +100,11 @@ namespace spades {
 			 *
 			 * If an exception occured while decoding the map, the exception will be rethrown when
 			 * this method is called.
+			 *
+			 * @param outWrapper If not null, receives a `GameMapWrapper` for the map whose
+			 *                   connectivity is already computed.
 			 */
-			Handle<GameMap> TakeGameMap();
+			Handle<GameMap> TakeGameMap(std::unique_ptr<GameMapWrapper>* outWrapper = nullptr);
 
 		private:
 			struct Decoder;
@@ -99,6 +124,11 @@ namespace spades {
 
 			/** The cell for receiving the decode result. */
 			stmp::atomic_unique_ptr<Result> resultCell;
+
+			bool fromCache = false;
+			uint32_t rawDataChecksum;
+			/** Written by the decoding thread before `resultCell`. */
+			uint32_t dataChecksum = 0;
 		};
 
 	} // namespace client
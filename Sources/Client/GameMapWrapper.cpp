@@ -18,20 +18,59 @@
 
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
-#include <deque>
-#include <queue>
-#include <set>
 #include <vector>
 
 #include "GameMap.h"
 #include "GameMapWrapper.h"
+#include <Core/ConcurrentDispatch.h>
 #include <Core/Debug.h>
 #include <Core/Stopwatch.h>
+#include <Core/TMPUtils.h>
 
 namespace spades {
 	namespace client {
-		GameMapWrapper::GameMapWrapper(GameMap& mp) : map(mp) {
+		namespace {
+			/** The number of cells processed between two checks of the time budget. */
+			constexpr std::size_t RemovalSliceCells = 256;
+		} // namespace
+
+		class GameMapWrapper::RemovalDispatch : public ConcurrentDispatch {
+			GameMapWrapper& wrapper;
+			double timeBudget;
+
+		public:
+			std::atomic<bool> done{false};
+			RemovalDispatch(GameMapWrapper& wrapper, double timeBudget)
+			    : ConcurrentDispatch("GameMapWrapper::RemovalDispatch"),
+			      wrapper(wrapper),
+			      timeBudget(timeBudget) {}
+			void Run() override {
+				SPADES_MARK_FUNCTION();
+
+				wrapper.ProcessRemoval(timeBudget);
+
+				done = true;
+			}
+		};
+
+		GameMapWrapper::CellQueue::CellQueue(std::size_t initialCapacity) {
+			SPAssert((initialCapacity & (initialCapacity - 1)) == 0);
+			buffer.resize(initialCapacity);
+		}
+
+		void GameMapWrapper::CellQueue::Grow() {
+			// Unwrap the elements so they stay contiguous in the larger buffer
+			std::vector<CellPos> newBuffer(buffer.size() * 2);
+			for (std::size_t i = 0; i < count; i++)
+				newBuffer[i] = buffer[(head + i) & (buffer.size() - 1)];
+			buffer.swap(newBuffer);
+			head = 0;
+		}
+
+		GameMapWrapper::GameMapWrapper(GameMap& mp) : map(mp), queue(65536) {
 			SPADES_MARK_FUNCTION();
 
 			width = mp.Width();
@@ -40,68 +79,122 @@ namespace spades {
 			// TODO: `stmp::make_unique` doesn't support array initialization yet
 			linkMap.reset(new uint8_t[width * height * depth]);
 			memset(linkMap.get(), 0, width * height * depth);
+			visitedMap.resize((GetCellIndex(width - 1, height - 1, depth - 1) >> 6) + 1);
 		}
 
-		GameMapWrapper::~GameMapWrapper() { SPADES_MARK_FUNCTION(); }
+		GameMapWrapper::~GameMapWrapper() {
+			SPADES_MARK_FUNCTION();
+
+			JoinRemovalDispatch();
+		}
 
 		void GameMapWrapper::Rebuild() {
 			SPADES_MARK_FUNCTION();
 
 			Stopwatch stopwatch;
 
-			GameMap& m = map;
+			BeginRebuild();
+			RebuildRows(height);
+
+			SPLog("%.3f msecs to rebuild", stopwatch.GetTime() * 1000.0);
+		}
+
+		void GameMapWrapper::BeginRebuild() {
+			SPADES_MARK_FUNCTION();
+			SPAssert(!removingBlocks);
+
 			memset(linkMap.get(), 0, width * height * depth);
+			numRebuiltRows = 0;
+		}
+
+		void GameMapWrapper::RebuildRows(int numRows) {
+			SPADES_MARK_FUNCTION();
+
+			SPAssert(numRows <= height);
+			if (numRows <= numRebuiltRows)
+				return;
+
+			GameMap& m = map;
+			int firstRow = numRebuiltRows;
+			numRebuiltRows = numRows;
+
+			SPAssert(queue.empty());
 
 			for (int x = 0; x < width; x++)
-			for (int y = 0; y < height; y++)
+			for (int y = firstRow; y < numRows; y++)
 				SetLink(x, y, depth - 1, Root);
 
-			std::deque<CellPos> queue(width * height * 2);
+			// The cells in the new rows might be connected via the last row processed so far.
+			// The search can also reach the cells in the old rows that were not connected
+			// before.
+			if (firstRow > 0) {
+				int y = firstRow - 1;
+				for (int x = 0; x < width; x++)
+				for (int z = 0; z < depth - 1; z++)
+				if (GetLink(x, y, z) != Invalid && m.IsSolid(x, y + 1, z))
+					queue.push_back(CellPos(x, y, z));
+			}
 
 			for (int x = 0; x < width; x++)
-			for (int y = 0; y < height; y++)
+			for (int y = firstRow; y < numRows; y++)
 			if (m.IsSolid(x, y, depth - 2)) {
 				SetLink(x, y, depth - 2, PositiveZ);
 				queue.push_back(CellPos(x, y, depth - 2));
 			}
 
-			while (!queue.empty()) {
-				CellPos p = queue.front();
-				queue.pop_front();
+			PropagateLinks(numRows);
+		}
+
+		bool GameMapWrapper::PropagateLinks(int numRows, std::size_t maxCells) {
+			GameMap& m = map;
+
+			for (std::size_t i = 0; i < maxCells; i++) {
+				if (queue.empty())
+					return true;
+
+				CellPos p = queue.pop_front();
 
 				int x = p.x, y = p.y, z = p.z;
+				LinkType thisLink = GetLink(x, y, z);
 
-				if (p.x > 0 && m.IsSolid(x - 1, y, z) && GetLink(x - 1, y, z) == Invalid) {
+				if (p.x > 0 && m.IsSolid(x - 1, y, z) && GetLink(x - 1, y, z) == Invalid &&
+				    thisLink != NegativeX) {
 					SetLink(x - 1, y, z, PositiveX);
 					queue.push_back(CellPos(x - 1, y, z));
 				}
-				if (p.x < width - 1 && m.IsSolid(x + 1, y, z) && GetLink(x + 1, y, z) == Invalid) {
+				if (p.x < width - 1 && m.IsSolid(x + 1, y, z) && GetLink(x + 1, y, z) == Invalid &&
+				    thisLink != PositiveX) {
 					SetLink(x + 1, y, z, NegativeX);
 					queue.push_back(CellPos(x + 1, y, z));
 				}
-				if (p.y > 0 && m.IsSolid(x, y - 1, z) && GetLink(x, y - 1, z) == Invalid) {
+				if (p.y > 0 && m.IsSolid(x, y - 1, z) && GetLink(x, y - 1, z) == Invalid &&
+				    thisLink != NegativeY) {
 					SetLink(x, y - 1, z, PositiveY);
 					queue.push_back(CellPos(x, y - 1, z));
 				}
-				if (p.y < height - 1 && m.IsSolid(x, y + 1, z) && GetLink(x, y + 1, z) == Invalid) {
+				if (p.y < numRows - 1 && m.IsSolid(x, y + 1, z) &&
+				    GetLink(x, y + 1, z) == Invalid && thisLink != PositiveY) {
 					SetLink(x, y + 1, z, NegativeY);
 					queue.push_back(CellPos(x, y + 1, z));
 				}
-				if (p.z > 0 && m.IsSolid(x, y, z - 1) && GetLink(x, y, z - 1) == Invalid) {
+				if (p.z > 0 && m.IsSolid(x, y, z - 1) && GetLink(x, y, z - 1) == Invalid &&
+				    thisLink != NegativeZ) {
 					SetLink(x, y, z - 1, PositiveZ);
 					queue.push_back(CellPos(x, y, z - 1));
 				}
-				if (p.z < depth - 1 && m.IsSolid(x, y, z + 1) && GetLink(x, y, z + 1) == Invalid) {
+				if (p.z < depth - 1 && m.IsSolid(x, y, z + 1) && GetLink(x, y, z + 1) == Invalid &&
+				    thisLink != PositiveZ) {
 					SetLink(x, y, z + 1, NegativeZ);
 					queue.push_back(CellPos(x, y, z + 1));
 				}
 			}
 
-			SPLog("%.3f msecs to rebuild", stopwatch.GetTime() * 1000.0);
+			return queue.empty();
 		}
 
 		void GameMapWrapper::AddBlock(int x, int y, int z, uint32_t color) {
 			SPADES_MARK_FUNCTION();
+			SPAssert(!removingBlocks);
 
 			GameMap& m = map;
 
@@ -146,48 +239,9 @@ namespace spades {
 				return;
 			// if there's invalid block around this block,
 			// rebuild tree
-			std::deque<CellPos> queue;
+			SPAssert(queue.empty());
 			queue.push_back(CellPos(x, y, z));
-			while (!queue.empty()) {
-				CellPos p = queue.front();
-				queue.pop_front();
-
-				int x = p.x, y = p.y, z = p.z;
-				SPAssert(m.IsSolid(x, y, z));
-
-				LinkType thisLink = GetLink(x, y, z);
-
-				if (p.x > 0 && m.IsSolid(x - 1, y, z) && GetLink(x - 1, y, z) == Invalid &&
-				    thisLink != NegativeX) {
-					SetLink(x - 1, y, z, PositiveX);
-					queue.push_back(CellPos(x - 1, y, z));
-				}
-				if (p.x < width - 1 && m.IsSolid(x + 1, y, z) && GetLink(x + 1, y, z) == Invalid &&
-				    thisLink != PositiveX) {
-					SetLink(x + 1, y, z, NegativeX);
-					queue.push_back(CellPos(x + 1, y, z));
-				}
-				if (p.y > 0 && m.IsSolid(x, y - 1, z) && GetLink(x, y - 1, z) == Invalid &&
-				    thisLink != NegativeY) {
-					SetLink(x, y - 1, z, PositiveY);
-					queue.push_back(CellPos(x, y - 1, z));
-				}
-				if (p.y < height - 1 && m.IsSolid(x, y + 1, z) && GetLink(x, y + 1, z) == Invalid &&
-				    thisLink != PositiveY) {
-					SetLink(x, y + 1, z, NegativeY);
-					queue.push_back(CellPos(x, y + 1, z));
-				}
-				if (p.z > 0 && m.IsSolid(x, y, z - 1) && GetLink(x, y, z - 1) == Invalid &&
-				    thisLink != NegativeZ) {
-					SetLink(x, y, z - 1, PositiveZ);
-					queue.push_back(CellPos(x, y, z - 1));
-				}
-				if (p.z < depth - 1 && m.IsSolid(x, y, z + 1) && GetLink(x, y, z + 1) == Invalid &&
-				    thisLink != PositiveZ) {
-					SetLink(x, y, z + 1, NegativeZ);
-					queue.push_back(CellPos(x, y, z + 1));
-				}
-			}
+			PropagateLinks(height);
 		}
 
 		template <typename T> static inline bool EqualTwoCond(T a, T b, T c, bool cond) {
@@ -197,161 +251,191 @@ namespace spades {
 		std::vector<CellPos> GameMapWrapper::RemoveBlocks(const std::vector<CellPos>& cells) {
 			SPADES_MARK_FUNCTION();
 
-			if (cells.empty())
-				return std::vector<CellPos>();
-
-			GameMap& m = map;
+			BeginRemoveBlocks(cells);
+			return EndRemoveBlocks();
+		}
 
-			// solid, but unlinked cells
-			std::vector<CellPos> unlinkedCells;
-			std::deque<CellPos> queue;
+		void GameMapWrapper::BeginRemoveBlocks(const std::vector<CellPos>& cells) {
+			SPADES_MARK_FUNCTION();
+			SPAssert(!removingBlocks);
+
+			// The search only reads the map, so it can run on another thread. Modify the map
+			// here so the listeners are notified on this thread.
+			for (const CellPos& pos : cells)
+				map.Set(pos.x, pos.y, pos.z, false, 0);
+
+			removal.cells = cells;
+			removal.nextCell = 0;
+			removal.unlinkedCells.clear();
+			removal.phase = RemovalPhase::Unlink;
+			removingBlocks = true;
+		}
 
-			// unlink children
-			for (size_t i = 0; i < cells.size(); i++) {
-				CellPos pos = cells[i];
-				m.Set(pos.x, pos.y, pos.z, false, 0);
-				// if(GetLink(pos.x, pos.y, pos.z) == Invalid){
-				// this block is already disconnected.
-				// }
-
-				if (GetLink(pos.x, pos.y, pos.z) == Marked)
-					continue;
+		bool GameMapWrapper::ContinueRemoveBlocks(double timeBudget) {
+			SPADES_MARK_FUNCTION();
+			SPAssert(removingBlocks);
 
-				SPAssert(GetLink(pos.x, pos.y, pos.z) != Root);
+			JoinRemovalDispatch();
+			return ProcessRemoval(timeBudget);
+		}
 
-				SetLink(pos.x, pos.y, pos.z, Invalid);
-				queue.push_back(pos);
+		void GameMapWrapper::ContinueRemoveBlocksAsync(double timeBudget) {
+			SPADES_MARK_FUNCTION();
+			SPAssert(removingBlocks);
 
-				while (!queue.empty()) {
-					pos = queue.front();
-					queue.pop_front();
+			JoinRemovalDispatch();
+			if (removal.phase == RemovalPhase::Complete)
+				return;
 
-					if (m.IsSolid(pos.x, pos.y, pos.z))
-						unlinkedCells.push_back(pos);
-					// don't "continue;" when non-solid
+			removalDispatch = stmp::make_unique<RemovalDispatch>(*this, timeBudget);
+			removalDispatch->Start();
+		}
 
-					int x = pos.x, y = pos.y, z = pos.z;
-					if (x > 0 && EqualTwoCond(GetLink(x - 1, y, z), PositiveX, Invalid,
-					                          m.IsSolid(x - 1, y, z))) {
-						SetLink(x - 1, y, z, Marked);
-						queue.push_back(CellPos(x - 1, y, z));
-					}
-					if (x < width - 1 && EqualTwoCond(GetLink(x + 1, y, z), NegativeX, Invalid,
-					                                  m.IsSolid(x + 1, y, z))) {
-						SetLink(x + 1, y, z, Marked);
-						queue.push_back(CellPos(x + 1, y, z));
-					}
-					if (y > 0 && EqualTwoCond(GetLink(x, y - 1, z), PositiveY, Invalid,
-					                          m.IsSolid(x, y - 1, z))) {
-						SetLink(x, y - 1, z, Marked);
-						queue.push_back(CellPos(x, y - 1, z));
-					}
-					if (y < height - 1 && EqualTwoCond(GetLink(x, y + 1, z), NegativeY, Invalid,
-					                                   m.IsSolid(x, y + 1, z))) {
-						SetLink(x, y + 1, z, Marked);
-						queue.push_back(CellPos(x, y + 1, z));
-					}
-					if (z > 0 && EqualTwoCond(GetLink(x, y, z - 1), PositiveZ, Invalid,
-					                          m.IsSolid(x, y, z - 1))) {
-						SetLink(x, y, z - 1, Marked);
-						queue.push_back(CellPos(x, y, z - 1));
-					}
-					if (z < depth - 1 && EqualTwoCond(GetLink(x, y, z + 1), NegativeZ, Invalid,
-					                                  m.IsSolid(x, y, z + 1))) {
-						SetLink(x, y, z + 1, Marked);
-						queue.push_back(CellPos(x, y, z + 1));
-					}
-				}
-			}
+		std::vector<CellPos> GameMapWrapper::EndRemoveBlocks() {
+			SPADES_MARK_FUNCTION();
+			SPAssert(removingBlocks);
 
-			// remove "visited" mark
-			for (const auto& pos : unlinkedCells) {
-				if (GetLink(pos.x, pos.y, pos.z) == Marked)
-					SetLink(pos.x, pos.y, pos.z, Invalid);
-			}
+			JoinRemovalDispatch();
+			ProcessRemoval(-1.0);
+			SPAssert(removal.phase == RemovalPhase::Complete);
 
-			SPAssert(queue.empty());
+			GameMap& m = map;
+			std::vector<CellPos> floatingBlocks;
+			floatingBlocks.reserve(removal.unlinkedCells.size());
 
-			// start relinking
-			for (const auto& pos : unlinkedCells) {
-				int x = pos.x, y = pos.y, z = pos.z;
-				if (!m.IsSolid(x, y, z)) {
-					// notice: (x,y,z) may be air, so
-					// don't use SPAssert()
+			for (const auto& p : removal.unlinkedCells) {
+				if (!m.IsSolid(p.x, p.y, p.z))
 					continue;
-				}
+				if (GetLink(p.x, p.y, p.z) == Invalid)
+					floatingBlocks.push_back(p);
+			}
 
-				LinkType newLink = Invalid;
-				if (z < depth - 1 && GetLink(x, y, z + 1) != Invalid) {
-					newLink = PositiveZ;
-				} else if (x > 0 && GetLink(x - 1, y, z) != Invalid) {
-					newLink = NegativeX;
-				} else if (x < width - 1 && GetLink(x + 1, y, z) != Invalid) {
-					newLink = PositiveX;
-				} else if (y > 0 && GetLink(x, y - 1, z) != Invalid) {
-					newLink = NegativeY;
-				} else if (y < height - 1 && GetLink(x, y + 1, z) != Invalid) {
-					newLink = PositiveY;
-				} else if (z > 0 && GetLink(x, y, z - 1) != Invalid) {
-					newLink = NegativeZ;
-				}
+			removal.phase = RemovalPhase::Idle;
+			removingBlocks = false;
 
-				if (newLink != Invalid) {
-					SetLink(x, y, z, newLink);
-					queue.push_back(pos);
-				}
+			return floatingBlocks;
+		}
+
+		void GameMapWrapper::JoinRemovalDispatch() {
+			if (removalDispatch) {
+				removalDispatch->Join();
+				removalDispatch.reset();
 			}
+		}
 
-			while (!queue.empty()) {
-				CellPos p = queue.front();
-				queue.pop_front();
+		bool GameMapWrapper::ProcessRemoval(double timeBudget) {
+			SPADES_MARK_FUNCTION();
 
-				int x = p.x, y = p.y, z = p.z;
-				LinkType thisLink = GetLink(x, y, z);
+			GameMap& m = map;
+			Stopwatch stopwatch;
+			std::vector<CellPos>& cells = removal.cells;
+			std::vector<CellPos>& unlinkedCells = removal.unlinkedCells;
 
-				if (p.x > 0 && m.IsSolid(x - 1, y, z) && GetLink(x - 1, y, z) == Invalid &&
-				    thisLink != NegativeX) {
-					SetLink(x - 1, y, z, PositiveX);
-					queue.push_back(CellPos(x - 1, y, z));
-				}
-				if (p.x < width - 1 && m.IsSolid(x + 1, y, z) && GetLink(x + 1, y, z) == Invalid &&
-				    thisLink != PositiveX) {
-					SetLink(x + 1, y, z, NegativeX);
-					queue.push_back(CellPos(x + 1, y, z));
-				}
-				if (p.y > 0 && m.IsSolid(x, y - 1, z) && GetLink(x, y - 1, z) == Invalid &&
-				    thisLink != NegativeY) {
-					SetLink(x, y - 1, z, PositiveY);
-					queue.push_back(CellPos(x, y - 1, z));
-				}
-				if (p.y < height - 1 && m.IsSolid(x, y + 1, z) && GetLink(x, y + 1, z) == Invalid &&
-				    thisLink != PositiveY) {
-					SetLink(x, y + 1, z, NegativeY);
-					queue.push_back(CellPos(x, y + 1, z));
-				}
-				if (p.z > 0 && m.IsSolid(x, y, z - 1) && GetLink(x, y, z - 1) == Invalid &&
-				    thisLink != NegativeZ) {
-					SetLink(x, y, z - 1, PositiveZ);
-					queue.push_back(CellPos(x, y, z - 1));
-				}
-				if (p.z < depth - 1 && m.IsSolid(x, y, z + 1) && GetLink(x, y, z + 1) == Invalid &&
-				    thisLink != PositiveZ) {
-					SetLink(x, y, z + 1, NegativeZ);
-					queue.push_back(CellPos(x, y, z + 1));
+			auto isOutOfTime = [&] {
+				return timeBudget >= 0.0 && stopwatch.GetTime() >= timeBudget;
+			};
+
+			// unlink children
+			while (removal.phase == RemovalPhase::Unlink) {
+				for (std::size_t i = 0; i < RemovalSliceCells; i++) {
+					if (queue.empty()) {
+						if (removal.nextCell == cells.size()) {
+							removal.nextCell = 0;
+							removal.phase = RemovalPhase::Relink;
+							break;
+						}
+
+						CellPos pos = cells[removal.nextCell++];
+						if (IsVisited(pos.x, pos.y, pos.z))
+							continue;
+
+						SPAssert(GetLink(pos.x, pos.y, pos.z) != Root);
+
+						SetLink(pos.x, pos.y, pos.z, Invalid);
+						SetVisited(pos.x, pos.y, pos.z, true);
+						unlinkedCells.push_back(pos);
+						queue.push_back(pos);
+					}
+
+					CellPos pos = queue.pop_front();
+
+					// Visit the cells linked from this one, and the unlinked solid cells, which
+					// can be linked from this one if it's still solid. The visited cells
+					// become unlinked. (This cell might be air, but don't skip it.)
+					int x = pos.x, y = pos.y, z = pos.z;
+					auto visit = [&](int x, int y, int z, LinkType link) {
+						if (IsVisited(x, y, z) ||
+						    !EqualTwoCond(GetLink(x, y, z), link, Invalid, m.IsSolid(x, y, z)))
+							return;
+						SetLink(x, y, z, Invalid);
+						SetVisited(x, y, z, true);
+						unlinkedCells.push_back(CellPos(x, y, z));
+						queue.push_back(CellPos(x, y, z));
+					};
+					if (x > 0)
+						visit(x - 1, y, z, PositiveX);
+					if (x < width - 1)
+						visit(x + 1, y, z, NegativeX);
+					if (y > 0)
+						visit(x, y - 1, z, PositiveY);
+					if (y < height - 1)
+						visit(x, y + 1, z, NegativeY);
+					if (z > 0)
+						visit(x, y, z - 1, PositiveZ);
+					if (z < depth - 1)
+						visit(x, y, z + 1, NegativeZ);
 				}
+
+				if (isOutOfTime())
+					return false;
 			}
 
-			std::vector<CellPos> floatingBlocks;
-			floatingBlocks.reserve(unlinkedCells.size());
+			// start relinking
+			while (removal.phase == RemovalPhase::Relink) {
+				if (removal.nextCell < unlinkedCells.size()) {
+					std::size_t end =
+					  std::min(removal.nextCell + RemovalSliceCells, unlinkedCells.size());
+					for (; removal.nextCell < end; removal.nextCell++) {
+						const CellPos& pos = unlinkedCells[removal.nextCell];
+						int x = pos.x, y = pos.y, z = pos.z;
+						SetVisited(x, y, z, false);
+
+						if (!m.IsSolid(x, y, z)) {
+							// notice: (x,y,z) may be air, so
+							// don't use SPAssert()
+							continue;
+						}
+
+						LinkType newLink = Invalid;
+						if (z < depth - 1 && GetLink(x, y, z + 1) != Invalid) {
+							newLink = PositiveZ;
+						} else if (x > 0 && GetLink(x - 1, y, z) != Invalid) {
+							newLink = NegativeX;
+						} else if (x < width - 1 && GetLink(x + 1, y, z) != Invalid) {
+							newLink = PositiveX;
+						} else if (y > 0 && GetLink(x, y - 1, z) != Invalid) {
+							newLink = NegativeY;
+						} else if (y < height - 1 && GetLink(x, y + 1, z) != Invalid) {
+							newLink = PositiveY;
+						} else if (z > 0 && GetLink(x, y, z - 1) != Invalid) {
+							newLink = NegativeZ;
+						}
+
+						if (newLink != Invalid) {
+							SetLink(x, y, z, newLink);
+							queue.push_back(pos);
+						}
+					}
+				} else if (PropagateLinks(height, RemovalSliceCells)) {
+					removal.phase = RemovalPhase::Complete;
+					break;
+				}
 
-			for (const auto& p : unlinkedCells) {
-				if (!m.IsSolid(p.x, p.y, p.z))
-					continue;
-				if (GetLink(p.x, p.y, p.z) == Invalid)
-					floatingBlocks.push_back(p);
+				if (isOutOfTime())
+					return false;
 			}
 
-			return floatingBlocks;
+			return true;
 		}
 	} // namespace client
-} // namespace spades
\ No newline at end of file
+} // namespace spades
@@ -24,6 +24,8 @@
 #include <memory>
 #include <vector>
 
+#include <Core/Debug.h>
+
 namespace spades {
 	namespace client {
 		class GameMap;
@@ -73,6 +75,41 @@ namespace spades {
 			friend class Client; // FIXME: for debug
 		public:
 		private:
+			class RemovalDispatch;
+
+			/**
+			 * A FIFO queue of cells backed by a ring buffer. The storage is kept between
+			 * searches, so it's only reallocated when a search needs more than ever before.
+			 */
+			class CellQueue {
+				std::vector<CellPos> buffer;
+				std::size_t head = 0, count = 0;
+
+				void Grow();
+
+			public:
+				CellQueue(std::size_t initialCapacity);
+
+				bool empty() const { return count == 0; }
+				std::size_t size() const { return count; }
+				void clear() { head = count = 0; }
+
+				void push_back(const CellPos& pos) {
+					if (count == buffer.size())
+						Grow();
+					buffer[(head + count) & (buffer.size() - 1)] = pos;
+					count++;
+				}
+
+				CellPos pop_front() {
+					SPAssert(count > 0);
+					CellPos pos = buffer[head];
+					head = (head + 1) & (buffer.size() - 1);
+					count--;
+					return pos;
+				}
+			};
+
 			GameMap& map;
 
 			/** Each element represents where this cell is connected from. */
@@ -86,12 +123,37 @@ namespace spades {
 				NegativeY,
 				PositiveY,
 				NegativeZ,
-				PositiveZ,
-				Marked
+				PositiveZ
 			};
 
 			int width, height, depth;
 
+			/** The number of rows (cells with the same Y coordinate) covered by `linkMap`. */
+			int numRebuiltRows = 0;
+
+			CellQueue queue;
+
+			/** One bit per cell. Marks the cells visited while unlinking the removed blocks. */
+			std::vector<uint64_t> visitedMap;
+
+			enum class RemovalPhase { Idle, Unlink, Relink, Complete };
+
+			/** The state of the search started by `BeginRemoveBlocks`. */
+			struct Removal {
+				RemovalPhase phase = RemovalPhase::Idle;
+				/** The removed blocks. */
+				std::vector<CellPos> cells;
+				/** The index of the next element of `cells` (or `unlinkedCells`) to process. */
+				std::size_t nextCell = 0;
+				/** The cells disconnected by the removal. Some of them might be air. */
+				std::vector<CellPos> unlinkedCells;
+			} removal;
+			/** Only accessed by the owner thread, unlike `removal`. */
+			bool removingBlocks = false;
+
+			/** Runs the search on a background thread, one time slice at a time. */
+			std::unique_ptr<RemovalDispatch> removalDispatch;
+
 			inline LinkType GetLink(int x, int y, int z) {
 				return (LinkType)linkMap[(x * height + y) * depth + z];
 			}
@@ -99,6 +161,34 @@ namespace spades {
 				linkMap[(x * height + y) * depth + z] = l;
 			}
 
+			inline std::size_t GetCellIndex(int x, int y, int z) const {
+				return ((std::size_t)x * height + y) * depth + z;
+			}
+			inline bool IsVisited(int x, int y, int z) const {
+				std::size_t i = GetCellIndex(x, y, z);
+				return (visitedMap[i >> 6] >> (i & 63)) & 1;
+			}
+			inline void SetVisited(int x, int y, int z, bool visited) {
+				std::size_t i = GetCellIndex(x, y, z);
+				if (visited)
+					visitedMap[i >> 6] |= 1ULL << (i & 63);
+				else
+					visitedMap[i >> 6] &= ~(1ULL << (i & 63));
+			}
+
+			/**
+			 * Propagates the links from the cells in `queue` to the unlinked solid cells in the
+			 * rows `[0, numRows)`. Stops after processing `maxCells` cells. Returns `true` if
+			 * `queue` became empty.
+			 */
+			bool PropagateLinks(int numRows, std::size_t maxCells = SIZE_MAX);
+
+			/** Waits until the time slice running on the background thread completes. */
+			void JoinRemovalDispatch();
+
+			/** Advances the search for up to `timeBudget` seconds. */
+			bool ProcessRemoval(double timeBudget);
+
 		public:
 			GameMapWrapper(GameMap&);
 			~GameMapWrapper();
@@ -110,7 +200,54 @@ namespace spades {
 			 * This function, however, doesn't remove floating blocks. */
 			std::vector<CellPos> RemoveBlocks(const std::vector<CellPos>&);
 
+			/**
+			 * Removes the specified blocks and starts searching for the blocks that are not
+			 * connected to the ground anymore. The search is advanced by `ContinueRemoveBlocks`
+			 * or `ContinueRemoveBlocksAsync`, and its result is retrieved by `EndRemoveBlocks`.
+			 *
+			 * Until then, the caller must not call `AddBlock` or change which cells of the map
+			 * are solid. (Changing the colors is fine.)
+			 */
+			void BeginRemoveBlocks(const std::vector<CellPos>&);
+
+			/** Returns `true` if `BeginRemoveBlocks` was called, but `EndRemoveBlocks` wasn't. */
+			bool IsRemovingBlocks() const { return removingBlocks; }
+
+			/**
+			 * Advances the search for floating blocks on the calling thread for up to
+			 * `timeBudget` seconds (measured coarsely, so a zero budget still makes some
+			 * progress). Waits for `ContinueRemoveBlocksAsync` first. Returns `true` if the
+			 * search is complete.
+			 */
+			bool ContinueRemoveBlocks(double timeBudget);
+
+			/**
+			 * Advances the search for floating blocks on a background thread for up to
+			 * `timeBudget` seconds. Returns immediately.
+			 */
+			void ContinueRemoveBlocksAsync(double timeBudget);
+
+			/**
+			 * Completes the search for floating blocks and returns them. This function doesn't
+			 * remove floating blocks.
+			 */
+			std::vector<CellPos> EndRemoveBlocks();
+
+			/** Recomputes the connectivity of the entire map. */
 			void Rebuild();
+
+			/**
+			 * Starts recomputing the connectivity incrementally, in the ascending order of Y
+			 * coordinates. Used to process a map while it's still being decoded.
+			 */
+			void BeginRebuild();
+
+			/**
+			 * Extends the connectivity computed since `BeginRebuild` to the rows `[0, numRows)`.
+			 * The contents of these rows must not change until the rebuild is complete. The
+			 * result after processing all rows is equivalent to that of `Rebuild`.
+			 */
+			void RebuildRows(int numRows);
 		};
 	} // namespace client
 } // namespace spades
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include "Grenade.h"
 #include "GameMap.h"
 #include "IWorldListener.h"
+#include "MapCollision.h"
 #include "PhysicsConstants.h"
 #include "World.h"
 #include <Core/Debug.h>
@@ -97,22 +98,15 @@ namespace spades {
 			if (lp.z >= 63 && lp2.z < 63)
 				ret = -1; // under water
 
-			if (m->ClipWorld(lp.x, lp.y, lp.z)) {
+			MapCollision collision = CollideWithMap(*m, oldPos, position);
+			if (collision != MapCollision::None) {
 				ret = 1; // hit a wall
 				if (fabsf(velocity.x) > BOUNCE_SOUND_THRESHOLD ||
 				    fabsf(velocity.y) > BOUNCE_SOUND_THRESHOLD ||
 				    fabsf(velocity.z) > BOUNCE_SOUND_THRESHOLD)
 					ret = 2; // play sound
 
-				if (lp.z != lp2.z && ((lp.x == lp2.x && lp.y == lp2.y)
-					|| !m->ClipWorld(lp.x, lp.y, lp2.z)))
-					velocity.z = -velocity.z;
-				else if (lp.x != lp2.x && ((lp.y == lp2.y && lp.z == lp2.z)
-					|| !m->ClipWorld(lp2.x, lp.y, lp.z)))
-					velocity.x = -velocity.x;
-				else if (lp.y != lp2.y && ((lp.x == lp2.x && lp.z == lp2.z)
-					|| !m->ClipWorld(lp.x, lp2.y, lp.z)))
-					velocity.y = -velocity.y;
+				ReflectVelocity(collision, velocity);
 
 				position = oldPos; // set back to old position
 				velocity *= 0.36F; // lose some velocity due to friction
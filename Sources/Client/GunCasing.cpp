@@ -24,7 +24,8 @@
 #include "IAudioChunk.h"
 #include "IAudioDevice.h"
 #include "IRenderer.h"
-#include "ParticleSpriteEntity.h"
+#include "MapCollision.h"
+#include "ParticleSystem.h"
 #include "World.h"
 #include <Core/Settings.h>
 
@@ -104,25 +105,31 @@ namespace spades {
 
 					int splats = SampleRandomInt(0, 2);
 					for (int i = 0; i < splats; i++) {
-						auto ent = stmp::make_unique<ParticleSpriteEntity>(*client, img, col);
-						ent->SetTrajectory(pt, MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
-															SampleRandomFloat() - SampleRandomFloat(),
-															-SampleRandomFloat()) * 2.0F, 1.0F, 0.4F);
-						ent->SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
-						ent->SetRadius(0.1F + SampleRandomFloat() * SampleRandomFloat() * 0.1F);
-						ent->SetLifeTime(2.0F, 0.0F, 1.0F);
-						client->AddLocalEntity(std::move(ent));
+						ParticleSprite particle{*img, col};
+						particle.SetTrajectory(pt,
+						                       MakeVector3(SampleRandomFloat() - SampleRandomFloat(),
+						                                   SampleRandomFloat() - SampleRandomFloat(),
+						                                   -SampleRandomFloat()) *
+						                         2.0F,
+						                       1.0F, 0.4F);
+						particle.SetRotation(SampleRandomFloat() * M_PI_F * 2.0F);
+						particle.SetRadius(0.1F + SampleRandomFloat() * SampleRandomFloat() * 0.1F);
+						particle.SetLifeTime(2.0F, 0.0F, 1.0F);
+						client->GetParticleSystem().AddSprite(particle);
 					}
 				}
 
 				return false;
 			}
 
-			if (m->ClipWorld(lp.x, lp.y, lp.z)) { // hit a wall
-				IntVector3 lp2 = lastMat.GetOrigin().Floor();
-				if (lp.z != lp2.z &&
-				    ((lp.x == lp2.x && lp.y == lp2.y) || !m->ClipWorld(lp.x, lp.y, lp2.z))) {
-					velocity.z = -velocity.z;
+			MapCollision collision = CollideWithMap(*m, lastMat.GetOrigin(), matrix.GetOrigin());
+			if (collision == MapCollision::Stuck)
+				return false;
+
+			if (collision != MapCollision::None) { // hit a wall
+				ReflectVelocity(collision, velocity);
+				if (collision == MapCollision::BounceZ) {
+					IntVector3 lp2 = lastMat.GetOrigin().Floor();
 					if (lp2.z < lp.z) { // ground hit
 						if (dropSound) {
 							if (!client->IsMuted() && distSqr < 40.0F * 40.0F) {
@@ -135,14 +142,7 @@ namespace spades {
 							dropSound = NULL;
 						}
 					}
-				} else if (lp.x != lp2.x &&
-				           ((lp.y == lp2.y && lp.z == lp2.z) || !m->ClipWorld(lp2.x, lp.y, lp.z)))
-					velocity.x = -velocity.x;
-				else if (lp.y != lp2.y &&
-				         ((lp.x == lp2.x && lp.z == lp2.z) || !m->ClipWorld(lp.x, lp2.y, lp.z)))
-					velocity.y = -velocity.y;
-				else
-					return false;
+				}
 
 				matrix = lastMat; // set back to old position
 				velocity *= 0.46F; // lose some velocity due to friction
@@ -0,0 +1,183 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "HitScanIndex.h"
+#include "PhysicsConstants.h"
+#include "Player.h"
+#include "World.h"
+#include <Core/Debug.h>
+
+namespace spades {
+	namespace client {
+		namespace {
+			/** Extra margin to make up for the rounding errors. */
+			constexpr float Margin = 0.5F;
+		} // namespace
+
+		HitScanIndex::HitScanIndex() : cellStart(GridSize * GridSize + 1, 0), dirty(true) {
+			static_assert(NumPlayerSlots <= MaxPlayers, "Too many player slots for HitScanIndex");
+		}
+
+		void HitScanIndex::Build(World& world) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			struct Entry {
+				int minX, minY, maxX, maxY;
+			};
+			Entry entries[MaxPlayers];
+			bool present[MaxPlayers];
+
+			outsiders = PlayerSet();
+			std::fill(cellStart.begin(), cellStart.end(), 0);
+
+			const float radius = MaxTolerance + Slack + Margin;
+			const float limit = static_cast<float>(GridSize * CellSize);
+
+			// Count the number of entries per cell
+			for (int i = 0; i < static_cast<int>(world.GetNumPlayerSlots()); i++) {
+				auto maybePlayer = world.GetPlayer(static_cast<unsigned int>(i));
+				present[i] = false;
+				if (!maybePlayer) {
+					// Any movement invalidates the index
+					positions[i] = MakeVector3(NAN, NAN, NAN);
+					continue;
+				}
+
+				Vector3 pos = maybePlayer->GetPosition();
+				positions[i] = pos;
+				if (!(pos.x - radius >= 0.0F && pos.y - radius >= 0.0F &&
+				      pos.x + radius < limit && pos.y + radius < limit)) {
+					// Also catches NaN
+					outsiders.Add(i);
+					continue;
+				}
+
+				Entry& e = entries[i];
+				e.minX = static_cast<int>((pos.x - radius) / CellSize);
+				e.minY = static_cast<int>((pos.y - radius) / CellSize);
+				e.maxX = static_cast<int>((pos.x + radius) / CellSize);
+				e.maxY = static_cast<int>((pos.y + radius) / CellSize);
+				present[i] = true;
+
+				for (int y = e.minY; y <= e.maxY; y++)
+					for (int x = e.minX; x <= e.maxX; x++)
+						cellStart[y * GridSize + x + 1]++;
+			}
+
+			for (std::size_t i = 1; i < cellStart.size(); i++)
+				cellStart[i] += cellStart[i - 1];
+
+			cellPlayers.resize(cellStart.back());
+
+			// Fill the cells. Players end up in the ascending order in each cell
+			std::vector<uint32_t>& cursor = cellStart;
+			for (int i = 0; i < static_cast<int>(world.GetNumPlayerSlots()); i++) {
+				if (!present[i])
+					continue;
+				const Entry& e = entries[i];
+				for (int y = e.minY; y <= e.maxY; y++)
+					for (int x = e.minX; x <= e.maxX; x++)
+						cellPlayers[cursor[y * GridSize + x]++] = static_cast<uint8_t>(i);
+			}
+
+			// `cursor[i]` now points at the end of cell `i`, which is the start of cell `i + 1`
+			for (std::size_t i = cellStart.size() - 1; i > 0; i--)
+				cellStart[i] = cellStart[i - 1];
+			cellStart[0] = 0;
+
+			dirty = false;
+		}
+
+		void HitScanIndex::QueryRay(const Vector3& start, const Vector3& dir,
+		                            PlayerSet& out) const {
+			SPADES_MARK_FUNCTION_DEBUG();
+			SPAssert(!dirty);
+
+			out = outsiders;
+
+			// Convert the 2D projection of the ray to the cell space. The closest point to a
+			// player passing `RayCastApprox` is less than `FOG_DISTANCE + MaxTolerance` away
+			// from `start` horizontally.
+			float ox = start.x / CellSize, oy = start.y / CellSize;
+			float dx = dir.x, dy = dir.y;
+			float length = (FOG_DISTANCE + MaxTolerance + Margin) / CellSize;
+
+			float len2D = std::sqrt(dx * dx + dy * dy);
+			if (len2D < 1.0e-6F) {
+				dx = dy = 0.0F;
+				length = 0.0F;
+			} else {
+				dx /= len2D;
+				dy /= len2D;
+			}
+
+			// Clip the segment to the grid
+			float t0 = 0.0F, t1 = length;
+			const float size = static_cast<float>(GridSize);
+			auto clip = [&](float o, float d) {
+				if (d == 0.0F)
+					return o >= 0.0F && o < size;
+				float a = (0.0F - o) / d, b = (size - o) / d;
+				if (a > b)
+					std::swap(a, b);
+				t0 = std::max(t0, a);
+				t1 = std::min(t1, b);
+				return t0 <= t1;
+			};
+			if (!clip(ox, dx) || !clip(oy, dy))
+				return;
+
+			// Amanatides-Woo traversal
+			float px = ox + dx * t0, py = oy + dy * t0;
+			int cx = std::min(std::max(static_cast<int>(std::floor(px)), 0), GridSize - 1);
+			int cy = std::min(std::max(static_cast<int>(std::floor(py)), 0), GridSize - 1);
+			int stepX = dx > 0.0F ? 1 : -1, stepY = dy > 0.0F ? 1 : -1;
+			float deltaX = dx != 0.0F ? std::fabs(1.0F / dx) : INFINITY;
+			float deltaY = dy != 0.0F ? std::fabs(1.0F / dy) : INFINITY;
+			float nextX = dx != 0.0F ? t0 + ((dx > 0.0F ? cx + 1 - px : px - cx) * deltaX)
+			                         : INFINITY;
+			float nextY = dy != 0.0F ? t0 + ((dy > 0.0F ? cy + 1 - py : py - cy) * deltaY)
+			                         : INFINITY;
+
+			while (true) {
+				int cell = cy * GridSize + cx;
+				for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+					out.Add(cellPlayers[k]);
+
+				if (nextX < nextY) {
+					if (nextX > t1)
+						break;
+					cx += stepX;
+					nextX += deltaX;
+				} else {
+					if (nextY > t1)
+						break;
+					cy += stepY;
+					nextY += deltaY;
+				}
+				if (cx < 0 || cy < 0 || cx >= GridSize || cy >= GridSize)
+					break;
+			}
+		}
+	} // namespace client
+} // namespace spades
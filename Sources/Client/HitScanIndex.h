@@ -0,0 +1,121 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <Core/Math.h>
+
+namespace spades {
+	namespace client {
+		class World;
+
+		/**
+		 * A broad-phase for weapon ray casts against players: a uniform 2D grid over the map
+		 * with each player registered in the cells overlapping a square around its position.
+		 * A ray query visits the cells along the ray and returns the players that may pass
+		 * `Player::RayCastApprox`, so the narrow phase only has to look at those.
+		 */
+		class HitScanIndex {
+		public:
+			enum {
+				MaxPlayers = 256,
+				CellSize = 16,
+				GridSize = 512 / CellSize,
+			};
+
+			/** The largest `RayCastApprox` tolerance a query may use. */
+			static constexpr float MaxTolerance = 3.0F;
+
+			/**
+			 * How far a player can move horizontally from the position it was registered at
+			 * before the index has to be rebuilt.
+			 */
+			static constexpr float Slack = 1.0F;
+
+			/** A set of player IDs. Iterated in ascending order. */
+			class PlayerSet {
+			public:
+				PlayerSet() : words{} {}
+
+				void Add(int id) { words[id >> 6] |= 1ULL << (id & 63); }
+				bool Contains(int id) const { return (words[id >> 6] >> (id & 63)) & 1; }
+
+				void UnionWith(const PlayerSet& o) {
+					for (int i = 0; i < NumWords; i++)
+						words[i] |= o.words[i];
+				}
+
+				template <class F> void ForEach(F f) const {
+					for (int i = 0; i < NumWords; i++) {
+						uint64_t w = words[i];
+						while (w) {
+							f((i << 6) + CountTrailingZeros64(w));
+							w &= w - 1;
+						}
+					}
+				}
+
+			private:
+				enum { NumWords = MaxPlayers / 64 };
+				uint64_t words[NumWords];
+			};
+
+			HitScanIndex();
+
+			/** Registers the positions of all players in `world`. */
+			void Build(World& world);
+
+			/** Returns `true` if `Build` must be called before the next query. */
+			bool IsDirty() const { return dirty; }
+			void Invalidate() { dirty = true; }
+
+			/**
+			 * Notifies that the player `id` has moved to `pos`. Invalidates the index if
+			 * the player went out of the region it is registered in.
+			 */
+			void PlayerMoved(int id, const Vector3& pos) {
+				const Vector3& old = positions[id];
+				if (!(std::fabs(pos.x - old.x) <= Slack && std::fabs(pos.y - old.y) <= Slack))
+					dirty = true;
+			}
+
+			/**
+			 * Collects the players that a ray starting at `start` with the normalized direction
+			 * `dir` may pass within `MaxTolerance` of, up to `FOG_DISTANCE` away horizontally.
+			 * Always a superset of the players passing `Player::RayCastApprox`.
+			 */
+			void QueryRay(const Vector3& start, const Vector3& dir, PlayerSet& out) const;
+
+		private:
+			/** `cellStart[i]..cellStart[i + 1]` is the range of `cellPlayers` in cell `i`. */
+			std::vector<uint32_t> cellStart;
+			std::vector<uint8_t> cellPlayers;
+			/** Players not entirely inside the grid. Always returned by queries. */
+			PlayerSet outsiders;
+			/** The positions the players were registered at. */
+			Vector3 positions[MaxPlayers];
+			bool dirty;
+		};
+	} // namespace client
+} // namespace spades
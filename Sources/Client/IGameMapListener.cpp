@@ -18,4 +18,16 @@
 
  */
 
-#include "IGameMapListener.h"
\ No newline at end of file
+#include "IGameMapListener.h"
+#include <Core/Math.h>
+
+namespace spades {
+	namespace client {
+		void IGameMapListener::GameMapChangedRegion(const IntAABB3& region, GameMap* map) {
+			for (int x = region.min.x; x < region.max.x; x++)
+				for (int y = region.min.y; y < region.max.y; y++)
+					for (int z = region.min.z; z < region.max.z; z++)
+						GameMapChanged(x, y, z, map);
+		}
+	} // namespace client
+} // namespace spades
\ No newline at end of file
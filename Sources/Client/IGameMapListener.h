@@ -21,11 +21,19 @@
 #pragma once
 
 namespace spades {
+	class IntAABB3;
 	namespace client {
 		class GameMap;
 		class IGameMapListener {
 		public:
 			virtual void GameMapChanged(int x, int y, int z, GameMap*) = 0;
+
+			/**
+			 * Called once at the end of a batch of changes (`GameMap::BeginBatch`) with a box
+			 * containing all of the changed voxels. The default implementation calls
+			 * `GameMapChanged` for every voxel in the box.
+			 */
+			virtual void GameMapChangedRegion(const IntAABB3&, GameMap*);
 		};
 	} // namespace client
 } // namespace spades
\ No newline at end of file
@@ -0,0 +1,268 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include "GameMap.h"
+#include "MapCache.h"
+#include <Core/ConcurrentDispatch.h>
+#include <Core/Debug.h>
+#include <Core/DynamicMemoryStream.h>
+#include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/IStream.h>
+#include <Core/MappedFile.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+
+DEFINE_SPADES_SETTING(cg_mapCache, "1");
+DEFINE_SPADES_SETTING(cg_mapCacheSize, "256");
+
+namespace spades {
+	namespace client {
+		namespace {
+			const char* const cacheDirectory = "MapCache/";
+			const char* const indexFileName = "MapCache/Index.txt";
+
+			std::string GetPath(const std::string& fileName) { return cacheDirectory + fileName; }
+		} // namespace
+
+		MapCache& MapCache::GetInstance() {
+			static MapCache instance;
+			return instance;
+		}
+
+		Handle<GameMap> MapCache::Load(uint32_t key) {
+			SPADES_MARK_FUNCTION();
+
+			if (!cg_mapCache)
+				return {};
+
+			std::lock_guard<std::mutex> lock{mutex};
+			LoadIndex();
+
+			int index = FindEntry(key);
+			if (index < 0)
+				return {};
+
+			Entry& entry = entries[index];
+			std::string path = GetPath(entry.fileName);
+			try {
+				Stopwatch sw;
+				Handle<GameMap> map;
+				if (auto file = FileManager::MapForReading(path.c_str())) {
+					map.Set(GameMap::LoadSnapshot(file->GetData(), file->GetSize()), false);
+				} else {
+					auto stream = FileManager::OpenForReading(path.c_str());
+					map.Set(GameMap::LoadSnapshot(stream.get()), false);
+				}
+				SPLog("Loaded the map %08x from the cache in %.3f msecs", key,
+				      sw.GetTime() * 1000.0);
+
+				entry.lastUsed = ++useCounter;
+				SaveIndex();
+				return map;
+			} catch (const std::exception& ex) {
+				SPLog("Failed to load the cached map '%s', removing it: %s", path.c_str(),
+				      ex.what());
+				RemoveEntry(index);
+				SaveIndex();
+				return {};
+			}
+		}
+
+		MapCache::~MapCache() {
+			if (storeDispatch)
+				storeDispatch->Join();
+		}
+
+		void MapCache::Store(const GameMap& map, const std::vector<uint32_t>& keys) {
+			SPADES_MARK_FUNCTION();
+
+			if (!cg_mapCache || keys.empty())
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+				LoadIndex();
+
+				for (uint32_t key : keys) {
+					if (FindEntry(key) >= 0)
+						return;
+				}
+			}
+
+			// Only the serialization happens on the calling thread
+			auto snapshot = std::make_shared<DynamicMemoryStream>();
+			map.SaveSnapshot(snapshot.get());
+
+			if (storeDispatch)
+				storeDispatch->Join();
+			auto write = [this, snapshot, keys] { WriteEntry(*snapshot, keys); };
+			storeDispatch.reset(new FunctionDispatch<decltype(write)>(write));
+			storeDispatch->Start();
+		}
+
+		void MapCache::WriteEntry(IStream& snapshot, const std::vector<uint32_t>& keys) {
+			SPADES_MARK_FUNCTION();
+
+			char buf[16];
+			std::sprintf(buf, "%08x.snp", keys.front());
+			Entry entry;
+			entry.fileName = buf;
+			entry.keys = keys;
+
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+
+				// Replace an entry whose file name collides with the new one
+				for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+					if (entries[i].fileName == entry.fileName) {
+						RemoveEntry(i);
+						break;
+					}
+				}
+			}
+
+			std::string path = GetPath(entry.fileName);
+			try {
+				auto stream = FileManager::OpenForWriting(path.c_str());
+				snapshot.SetPosition(0);
+				stream->Write(snapshot.Read(static_cast<std::size_t>(snapshot.GetLength())));
+				entry.size = stream->GetPosition();
+			} catch (const std::exception& ex) {
+				SPLog("Failed to store the map in the cache: %s", ex.what());
+				FileManager::RemoveFile(path.c_str());
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock{mutex};
+			uint64_t maxSize = static_cast<uint64_t>(std::max(0, (int)cg_mapCacheSize)) << 20;
+			if (entry.size > maxSize) {
+				FileManager::RemoveFile(path.c_str());
+				return;
+			}
+
+			entry.lastUsed = ++useCounter;
+			Evict(maxSize - entry.size);
+			entries.push_back(std::move(entry));
+			SaveIndex();
+
+			SPLog("Stored the map %08x in the cache", keys.front());
+		}
+
+		void MapCache::LoadIndex() {
+			if (indexLoaded)
+				return;
+			indexLoaded = true;
+
+			if (!FileManager::FileExists(indexFileName))
+				return;
+
+			std::string text;
+			try {
+				text = FileManager::ReadAllBytes(indexFileName);
+			} catch (const std::exception& ex) {
+				SPLog("Failed to read the map cache index: %s", ex.what());
+				return;
+			}
+
+			// Each line: <file name> <size> <last used> <key>[,<key>...]
+			std::istringstream lines{text};
+			std::string line;
+			while (std::getline(lines, line)) {
+				std::istringstream fields{line};
+				Entry entry;
+				std::string keys;
+				if (!(fields >> entry.fileName >> entry.size >> entry.lastUsed >> keys))
+					continue;
+
+				std::istringstream keyFields{keys};
+				std::string key;
+				while (std::getline(keyFields, key, ',')) {
+					unsigned long value = std::strtoul(key.c_str(), nullptr, 16);
+					entry.keys.push_back(static_cast<uint32_t>(value));
+				}
+
+				if (entry.keys.empty() || !FileManager::FileExists(GetPath(entry.fileName).c_str()))
+					continue;
+
+				useCounter = std::max(useCounter, entry.lastUsed);
+				entries.push_back(std::move(entry));
+			}
+		}
+
+		void MapCache::SaveIndex() {
+			std::string text;
+			char buf[64];
+			for (const Entry& entry : entries) {
+				std::sprintf(buf, " %" PRIu64 " %" PRIu64 " ", entry.size, entry.lastUsed);
+				text += entry.fileName;
+				text += buf;
+				for (std::size_t i = 0; i < entry.keys.size(); i++) {
+					std::sprintf(buf, i ? ",%08x" : "%08x", entry.keys[i]);
+					text += buf;
+				}
+				text += '\n';
+			}
+
+			try {
+				auto stream = FileManager::OpenForWriting(indexFileName);
+				stream->Write(text);
+			} catch (const std::exception& ex) {
+				SPLog("Failed to write the map cache index: %s", ex.what());
+			}
+		}
+
+		int MapCache::FindEntry(uint32_t key) {
+			for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+				const std::vector<uint32_t>& keys = entries[i].keys;
+				if (std::find(keys.begin(), keys.end(), key) != keys.end())
+					return i;
+			}
+			return -1;
+		}
+
+		void MapCache::RemoveEntry(int index) {
+			FileManager::RemoveFile(GetPath(entries[index].fileName).c_str());
+			entries.erase(entries.begin() + index);
+		}
+
+		void MapCache::Evict(uint64_t maxSize) {
+			uint64_t totalSize = 0;
+			for (const Entry& entry : entries)
+				totalSize += entry.size;
+
+			while (totalSize > maxSize && !entries.empty()) {
+				auto it = std::min_element(entries.begin(), entries.end(),
+				                           [](const Entry& a, const Entry& b) {
+					                           return a.lastUsed < b.lastUsed;
+				                           });
+				SPLog("Evicting the cached map '%s'", it->fileName.c_str());
+				totalSize -= it->size;
+				RemoveEntry(static_cast<int>(it - entries.begin()));
+			}
+		}
+	} // namespace client
+} // namespace spades
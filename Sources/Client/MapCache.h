@@ -0,0 +1,99 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Core/RefCountedObject.h>
+
+namespace spades {
+	class ConcurrentDispatch;
+	class IStream;
+
+	namespace client {
+		class GameMap;
+
+		/**
+		 * An on-disk cache of decoded maps, keyed by checksums of the map data.
+		 *
+		 * Each entry is stored in `MapCache/` in the format written by
+		 * `GameMap::SaveSnapshot`, so a cache hit involves neither decompression nor VXL
+		 * parsing. Entries are loaded by mapping the file and written on a background
+		 * thread. The total size of the entries is bounded by `cg_mapCacheSize` (in MiB),
+		 * and the least recently used entries are evicted first. The usage order survives
+		 * restarts through an index file.
+		 *
+		 * I/O errors are logged and treated like cache misses.
+		 */
+		class MapCache {
+		public:
+			static MapCache& GetInstance();
+
+			/** Returns a map stored with the given key, or a null handle. */
+			Handle<GameMap> Load(uint32_t key);
+
+			/**
+			 * Stores a map under the given keys (e.g., the checksums of the compressed and
+			 * decompressed map data). Does nothing if an entry already has one of the keys.
+			 *
+			 * The map is serialized before returning, but the file is written later.
+			 */
+			void Store(const GameMap&, const std::vector<uint32_t>& keys);
+
+		private:
+			struct Entry {
+				std::string fileName;
+				uint64_t size;
+				/** A larger value means more recently used. */
+				uint64_t lastUsed;
+				std::vector<uint32_t> keys;
+			};
+
+			MapCache() = default;
+			~MapCache();
+
+			void LoadIndex();
+			void SaveIndex();
+
+			/** @return The index of the entry, or `-1`. */
+			int FindEntry(uint32_t key);
+			void RemoveEntry(int index);
+
+			/** Writes a snapshot and adds it to the index. Called by `storeDispatch`. */
+			void WriteEntry(IStream& snapshot, const std::vector<uint32_t>& keys);
+
+			/** Removes the least recently used entries until the total size is `maxSize`. */
+			void Evict(uint64_t maxSize);
+
+			std::mutex mutex;
+			std::vector<Entry> entries;
+			uint64_t useCounter = 0;
+			bool indexLoaded = false;
+
+			/** Writing the last stored entry. Only accessed by the thread calling `Store`. */
+			std::unique_ptr<ConcurrentDispatch> storeDispatch;
+		};
+	} // namespace client
+} // namespace spades
@@ -0,0 +1,120 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "MapCollision.h"
+#include "GameMap.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPADES_MAPCOLLISION_SSE2 1
+#include <emmintrin.h>
+#else
+#define SPADES_MAPCOLLISION_SSE2 0
+#endif
+
+namespace spades {
+	namespace client {
+		namespace {
+			/** `lp` and `lp2` are the cells containing the new and old positions. */
+			inline MapCollision Classify(const GameMap& map, const IntVector3& lp,
+			                             const IntVector3& lp2) {
+				if (!map.ClipWorld(lp.x, lp.y, lp.z))
+					return MapCollision::None;
+
+				if (lp.z != lp2.z &&
+				    ((lp.x == lp2.x && lp.y == lp2.y) || !map.ClipWorld(lp.x, lp.y, lp2.z)))
+					return MapCollision::BounceZ;
+				else if (lp.x != lp2.x &&
+				         ((lp.y == lp2.y && lp.z == lp2.z) || !map.ClipWorld(lp2.x, lp.y, lp.z)))
+					return MapCollision::BounceX;
+				else if (lp.y != lp2.y &&
+				         ((lp.x == lp2.x && lp.z == lp2.z) || !map.ClipWorld(lp.x, lp2.y, lp.z)))
+					return MapCollision::BounceY;
+				return MapCollision::Stuck;
+			}
+
+#if SPADES_MAPCOLLISION_SSE2
+			/** Computes `(int)floorf(v)` for each element. */
+			inline __m128i FloorSSE2(__m128 v) {
+				__m128i t = _mm_cvttps_epi32(v);
+				// The truncation rounded negative numbers up; subtract one from those
+				return _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(t), v)));
+			}
+#endif
+		} // namespace
+
+		MapCollision CollideWithMap(const GameMap& map, const Vector3& oldPos,
+		                            const Vector3& newPos) {
+			return Classify(map, newPos.Floor(), oldPos.Floor());
+		}
+
+		void CollideWithMap(const GameMap& map, std::size_t count, const float* const oldPos[3],
+		                    const float* const newPos[3], MapCollision* results) {
+			std::size_t i = 0;
+
+#if SPADES_MAPCOLLISION_SSE2
+			const __m128i minusOne = _mm_set1_epi32(-1);
+			const __m128i width = _mm_set1_epi32(map.Width());
+			const __m128i height = _mm_set1_epi32(map.Height());
+
+			for (; i + 4 <= count; i += 4) {
+				__m128i x = FloorSSE2(_mm_loadu_ps(newPos[0] + i));
+				__m128i y = FloorSSE2(_mm_loadu_ps(newPos[1] + i));
+				__m128i z = FloorSSE2(_mm_loadu_ps(newPos[2] + i));
+
+				// `ClipWorld` is false outside the map except below the bottom, so most points
+				// (e.g., those in the air outside the map) are rejected without a lookup
+				__m128i inside = _mm_and_si128(_mm_cmpgt_epi32(x, minusOne),
+				                               _mm_cmplt_epi32(x, width));
+				inside = _mm_and_si128(inside, _mm_and_si128(_mm_cmpgt_epi32(y, minusOne),
+				                                             _mm_cmplt_epi32(y, height)));
+				inside = _mm_and_si128(inside, _mm_cmpgt_epi32(z, minusOne));
+				int lanes = _mm_movemask_ps(_mm_castsi128_ps(inside));
+
+				for (int k = 0; k < 4; k++)
+					results[i + k] = MapCollision::None;
+				if (lanes == 0)
+					continue;
+
+				alignas(16) int32_t cells[6][4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(cells[0]), x);
+				_mm_store_si128(reinterpret_cast<__m128i*>(cells[1]), y);
+				_mm_store_si128(reinterpret_cast<__m128i*>(cells[2]), z);
+				for (int axis = 0; axis < 3; axis++)
+					_mm_store_si128(reinterpret_cast<__m128i*>(cells[3 + axis]),
+					                FloorSSE2(_mm_loadu_ps(oldPos[axis] + i)));
+
+				for (int k = 0; k < 4; k++) {
+					if (!(lanes & (1 << k)))
+						continue;
+					IntVector3 lp = IntVector3::Make(cells[0][k], cells[1][k], cells[2][k]);
+					IntVector3 lp2 = IntVector3::Make(cells[3][k], cells[4][k], cells[5][k]);
+					results[i + k] = Classify(map, lp, lp2);
+				}
+			}
+#endif
+
+			for (; i < count; i++) {
+				results[i] = CollideWithMap(
+				  map, MakeVector3(oldPos[0][i], oldPos[1][i], oldPos[2][i]),
+				  MakeVector3(newPos[0][i], newPos[1][i], newPos[2][i]));
+			}
+		}
+	} // namespace client
+} // namespace spades
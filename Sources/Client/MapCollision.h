@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Core/Math.h>
+
+namespace spades {
+	namespace client {
+		class GameMap;
+
+		/**
+		 * The result of moving a point through the map for one step. See `CollideWithMap`.
+		 */
+		enum class MapCollision : uint8_t {
+			/** The point is not inside a solid block. */
+			None,
+			/** The point entered a block through a face perpendicular to the axis. */
+			BounceX,
+			BounceY,
+			BounceZ,
+			/** The point entered a block, but the face it passed through couldn't be found. */
+			Stuck
+		};
+
+		/**
+		 * Tests a point that moved from `oldPos` to `newPos` against the blocks of `map`
+		 * (using the semantics of `GameMap::ClipWorld`) and finds the axis along which it
+		 * should bounce back. This is the collision test shared by the physics of thrown and
+		 * falling objects.
+		 */
+		MapCollision CollideWithMap(const GameMap& map, const Vector3& oldPos,
+		                            const Vector3& newPos);
+
+		/**
+		 * Performs `CollideWithMap` for `count` points, whose coordinates are given as arrays
+		 * (`oldPos[axis][i]` and `newPos[axis][i]`), and stores the results to `results`.
+		 * The block lookups are done in batches using SIMD instructions if available.
+		 */
+		void CollideWithMap(const GameMap& map, std::size_t count, const float* const oldPos[3],
+		                    const float* const newPos[3], MapCollision* results);
+
+		/** Reverses the component of `velocity` along the axis of the collision, if any. */
+		inline void ReflectVelocity(MapCollision collision, Vector3& velocity) {
+			switch (collision) {
+				case MapCollision::BounceX: velocity.x = -velocity.x; break;
+				case MapCollision::BounceY: velocity.y = -velocity.y; break;
+				case MapCollision::BounceZ: velocity.z = -velocity.z; break;
+				default: break;
+			}
+		}
+	} // namespace client
+} // namespace spades
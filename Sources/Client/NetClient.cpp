@@ -26,17 +26,20 @@
 #include <enet/enet.h>
 
 #include "CTFGameMode.h"
-#include "Client.h"
 #include "GameMap.h"
 #include "GameMapLoader.h"
+#include "MapCache.h"
 #include "GameProperties.h"
 #include "Grenade.h"
+#include "INetClientListener.h"
 #include "NetClient.h"
+#include "NetDemo.h"
+#include "NetIOThread.h"
+#include "NetPacket.h"
 #include "Player.h"
 #include "TCGameMode.h"
 #include "Weapon.h"
 #include "World.h"
-#include <Core/CP437.h>
 #include <Core/Debug.h>
 #include <Core/DeflateStream.h>
 #include <Core/Exception.h>
@@ -45,8 +48,10 @@
 #include <Core/Settings.h>
 #include <Core/Strings.h>
 #include <Core/TMPUtils.h>
+#include <Core/TraceProfiler.h>
 
-DEFINE_SPADES_SETTING(cg_unicode, "1");
+SPADES_SETTING(cg_unicode);
+SPADES_SETTING(cg_interpolationDelay);
 
 DEFINE_SPADES_SETTING(cg_defaultBlockColorR, "111");
 DEFINE_SPADES_SETTING(cg_defaultBlockColorG, "111");
@@ -57,50 +62,10 @@ namespace spades {
 	namespace client {
 
 		namespace {
-			const char UTFSign = -1;
+			/** The maximum rate of the orientation packets. */
+			constexpr double OrientationInterval = 1.0 / 120.0;
 
 			enum { BLUE_FLAG = 0, GREEN_FLAG = 1, BLUE_BASE = 2, GREEN_BASE = 3 };
-			enum PacketType {
-				PacketTypePositionData = 0,			// C2S2P
-				PacketTypeOrientationData = 1,		// C2S2P
-				PacketTypeWorldUpdate = 2,			// S2C
-				PacketTypeInputData = 3,			// C2S2P
-				PacketTypeWeaponInput = 4,			// C2S2P
-				PacketTypeHitPacket = 5,			// C2S
-				PacketTypeSetHP = 5,				// S2C
-				PacketTypeGrenadePacket = 6,		// C2S2P
-				PacketTypeSetTool = 7,				// C2S2P
-				PacketTypeSetColour = 8,			// C2S2P
-				PacketTypeExistingPlayer = 9,		// C2S2P
-				PacketTypeShortPlayerData = 10,		// S2C
-				PacketTypeMoveObject = 11,			// S2C
-				PacketTypeCreatePlayer = 12,		// S2C
-				PacketTypeBlockAction = 13,			// C2S2P
-				PacketTypeBlockLine = 14,			// C2S2P
-				PacketTypeStateData = 15,			// S2C
-				PacketTypeKillAction = 16,			// S2C
-				PacketTypeChatMessage = 17,			// C2S2P
-				PacketTypeMapStart = 18,			// S2C
-				PacketTypeMapChunk = 19,			// S2C
-				PacketTypePlayerLeft = 20,			// S2P
-				PacketTypeTerritoryCapture = 21,	// S2P
-				PacketTypeProgressBar = 22,			// S2P
-				PacketTypeIntelCapture = 23,		// S2P
-				PacketTypeIntelPickup = 24,			// S2P
-				PacketTypeIntelDrop = 25,			// S2P
-				PacketTypeRestock = 26,				// S2P
-				PacketTypeFogColour = 27,			// S2C
-				PacketTypeWeaponReload = 28,		// C2S2P
-				PacketTypeChangeTeam = 29,			// C2S2P
-				PacketTypeChangeWeapon = 30,		// C2S2P
-				PacketTypeMapCached = 31,			// S2C
-				PacketTypeHandShakeInit = 31,		// S2C
-				PacketTypeHandShakeReturn = 32,		// C2S
-				PacketTypeVersionGet = 33,			// S2C
-				PacketTypeVersionSend = 34,			// C2S
-				PacketTypeExtensionInfo = 60,
-				PacketTypePlayerProperties = 64,
-			};
 
 			enum class VersionInfoPropertyId : std::uint8_t {
 				ApplicationNameAndVersion = 0,
@@ -116,262 +81,10 @@ namespace spades {
 			ClientFeatureFlags1& operator|=(ClientFeatureFlags1& a, ClientFeatureFlags1 b) {
 				return a = a | b;
 			}
-
-			std::string EncodeString(std::string str) {
-				auto str2 = CP437::Encode(str, -1);
-				if (!cg_unicode)
-					return str2; // ignore fallbacks
-
-				// some fallbacks; always use UTF8
-				if (str2.find(-1) != std::string::npos)
-					str.insert(0, &UTFSign, 1);
-				else
-					str = str2;
-
-				return str;
-			}
-
-			std::string DecodeString(std::string s) {
-				if (s.size() > 0 && s[0] == UTFSign)
-					return s.substr(1);
-
-				return CP437::Decode(s);
-			}
 		} // namespace
 
-		class NetPacketReader {
-			std::vector<char> data;
-			size_t pos;
-
-		public:
-			NetPacketReader(ENetPacket* packet) {
-				SPADES_MARK_FUNCTION();
-
-				data.resize(packet->dataLength);
-				memcpy(data.data(), packet->data, packet->dataLength);
-				enet_packet_destroy(packet);
-				pos = 1;
-			}
-
-			NetPacketReader(const std::vector<char> inData) {
-				data = inData;
-				pos = 1;
-			}
-
-			unsigned int GetTypeRaw() { return static_cast<unsigned int>(data[0]); }
-			PacketType GetType() { return static_cast<PacketType>(GetTypeRaw()); }
-
-			uint32_t ReadInt() {
-				SPADES_MARK_FUNCTION();
-
-				uint32_t value = 0;
-				if (pos + 4 > data.size())
-					SPRaise("Received packet truncated");
-
-				value |= ((uint32_t)(uint8_t)data[pos++]);
-				value |= ((uint32_t)(uint8_t)data[pos++]) << 8;
-				value |= ((uint32_t)(uint8_t)data[pos++]) << 16;
-				value |= ((uint32_t)(uint8_t)data[pos++]) << 24;
-				return value;
-			}
-
-			uint16_t ReadShort() {
-				SPADES_MARK_FUNCTION();
-
-				uint32_t value = 0;
-				if (pos + 2 > data.size())
-					SPRaise("Received packet truncated");
-
-				value |= ((uint32_t)(uint8_t)data[pos++]);
-				value |= ((uint32_t)(uint8_t)data[pos++]) << 8;
-				return (uint16_t)value;
-			}
-
-			uint8_t ReadByte() {
-				SPADES_MARK_FUNCTION();
-
-				if (pos >= data.size())
-					SPRaise("Received packet truncated");
-
-				return (uint8_t)data[pos++];
-			}
-
-			float ReadFloat() {
-				SPADES_MARK_FUNCTION();
-				union {
-					float f;
-					uint32_t v;
-				};
-				v = ReadInt();
-				return f;
-			}
-
-			IntVector3 ReadIntColor() {
-				SPADES_MARK_FUNCTION();
-				IntVector3 col;
-				col.z = ReadByte(); // B
-				col.y = ReadByte(); // G
-				col.x = ReadByte(); // R
-				return col;
-			}
-			IntVector3 ReadIntVector3() {
-				SPADES_MARK_FUNCTION();
-				IntVector3 v;
-				v.x = ReadInt();
-				v.y = ReadInt();
-				v.z = ReadInt();
-				return v;
-			}
-			Vector3 ReadVector3() {
-				SPADES_MARK_FUNCTION();
-				Vector3 v;
-				v.x = ReadFloat();
-				v.y = ReadFloat();
-				v.z = ReadFloat();
-				return v;
-			}
-
-			std::size_t GetPosition() { return data.size(); }
-			std::size_t GetNumRemainingBytes() { return data.size() - pos; }
-			std::vector<char> GetData() { return data; }
-
-			std::string ReadData(size_t siz) {
-				if (pos + siz > data.size())
-					SPRaise("Received packet truncated");
-
-				std::string s = std::string(data.data() + pos, siz);
-				pos += siz;
-				return s;
-			}
-			std::string ReadRemainingData() {
-				return std::string(data.data() + pos, data.size() - pos);
-			}
-
-			std::string ReadString(size_t siz) {
-				SPADES_MARK_FUNCTION_DEBUG();
-				// convert to C string once so that null-chars are removed
-				return DecodeString(ReadData(siz).c_str());
-			}
-			std::string ReadRemainingString() {
-				SPADES_MARK_FUNCTION_DEBUG();
-				// convert to C string once so that null-chars are removed
-				return DecodeString(ReadRemainingData().c_str());
-			}
-
-			void DumpDebug() {
-#if 1
-				char buf[1024];
-				std::string str;
-				sprintf(buf, "Packet 0x%02x [len=%d]", (int)GetType(), (int)data.size());
-				str = buf;
-				int bytes = (int)data.size();
-				if (bytes > 64)
-					bytes = 64;
-
-				for (int i = 0; i < bytes; i++) {
-					sprintf(buf, " %02x", (unsigned int)(unsigned char)data[i]);
-					str += buf;
-				}
-
-				SPLog("%s", str.c_str());
-#endif
-			}
-		};
-
-		class NetPacketWriter {
-			std::vector<char> data;
-
-		public:
-			NetPacketWriter(PacketType type) { data.push_back(type); }
-
-			void WriteByte(uint8_t v) {
-				SPADES_MARK_FUNCTION_DEBUG();
-				data.push_back(v);
-			}
-			void WriteShort(uint16_t v) {
-				SPADES_MARK_FUNCTION_DEBUG();
-				data.push_back((char)(v));
-				data.push_back((char)(v >> 8));
-			}
-			void WriteInt(uint32_t v) {
-				SPADES_MARK_FUNCTION_DEBUG();
-				data.push_back((char)(v));
-				data.push_back((char)(v >> 8));
-				data.push_back((char)(v >> 16));
-				data.push_back((char)(v >> 24));
-			}
-			void WriteFloat(float v) {
-				SPADES_MARK_FUNCTION_DEBUG();
-				union {
-					float f;
-					uint32_t i;
-				};
-				f = v;
-				WriteInt(i);
-			}
-
-			void WriteColor(IntVector3 v) {
-				WriteByte((uint8_t)v.z); // B
-				WriteByte((uint8_t)v.y); // G
-				WriteByte((uint8_t)v.x); // R
-			}
-			void WriteIntVector3(IntVector3 v) {
-				WriteInt((uint32_t)v.x);
-				WriteInt((uint32_t)v.y);
-				WriteInt((uint32_t)v.z);
-			}
-			void WriteVector3(const Vector3& v) {
-				WriteFloat(v.x);
-				WriteFloat(v.y);
-				WriteFloat(v.z);
-			}
-
-			void WriteString(std::string str) {
-				str = EncodeString(str);
-				data.insert(data.end(), str.begin(), str.end());
-			}
-
-			void WriteString(const std::string& str, size_t fillLen) {
-				WriteString(str.substr(0, fillLen));
-				size_t sz = str.size();
-				while (sz < fillLen) {
-					WriteByte((uint8_t)0);
-					sz++;
-				}
-			}
-
-			std::size_t GetPosition() { return data.size(); }
-
-			void Update(std::size_t position, std::uint8_t newValue) {
-				SPADES_MARK_FUNCTION_DEBUG();
-
-				if (position >= data.size()) {
-					SPRaise("Invalid write (%d should be less than %d)",
-						(int)position, (int)data.size());
-				}
-
-				data[position] = static_cast<char>(newValue);
-			}
-
-			void Update(std::size_t position, std::uint32_t newValue) {
-				SPADES_MARK_FUNCTION_DEBUG();
-
-				if (position + 4 > data.size()) {
-					SPRaise("Invalid write (%d should be less than or equal to %d)",
-					        (int)(position + 4), (int)data.size());
-				}
-
-				// Assuming the target platform is little endian and supports
-				// unaligned memory access...
-				*reinterpret_cast<std::uint32_t*>(data.data() + position) = newValue;
-			}
-
-			ENetPacket* CreatePacket(int flag = ENET_PACKET_FLAG_RELIABLE) {
-				return enet_packet_create(data.data(), data.size(), flag);
-			}
-		};
-
-		NetClient::NetClient(Client* c) : client(c), host(nullptr), peer(nullptr) {
+		NetClient::NetClient(INetClientListener* listener)
+		    : listener(listener), host(nullptr), peer(nullptr) {
 			SPADES_MARK_FUNCTION();
 
 			enet_initialize();
@@ -400,7 +113,7 @@ namespace spades {
 
 			std::fill(savedPlayerTeam.begin(), savedPlayerTeam.end(), -1);
 
-			bandwidthMonitor.reset(new BandwidthMonitor(host));
+			bandwidthMonitor.reset(new BandwidthMonitor());
 		}
 		NetClient::~NetClient() {
 			SPADES_MARK_FUNCTION();
@@ -439,6 +152,8 @@ namespace spades {
 			if (peer == NULL)
 				SPRaise("Failed to create ENet peer");
 
+			ioThread.reset(new NetIOThread(host, peer, OrientationInterval));
+
 			properties.reset(new GameProperties(hostname.GetProtocolVersion()));
 
 			status = NetClientStatusConnecting;
@@ -448,9 +163,23 @@ namespace spades {
 		void NetClient::Disconnect() {
 			SPADES_MARK_FUNCTION();
 
+			if (demoReader) {
+				demoReader.reset();
+				nextDemoEvent.reset();
+				status = NetClientStatusNotConnected;
+				statusString = _Tr("NetClient", "Not connected");
+				savedPackets.clear();
+				return;
+			}
+
 			if (!peer)
 				return;
 
+			StopRecording();
+
+			// Take back the host from the I/O thread
+			ioThread.reset();
+
 			enet_peer_disconnect(peer, 0);
 			status = NetClientStatusNotConnected;
 			statusString = _Tr("NetClient", "Not connected");
@@ -486,7 +215,10 @@ namespace spades {
 			if (status == NetClientStatusNotConnected)
 				return -1;
 
-			auto rtt = peer->roundTripTime;
+			if (!ioThread)
+				return -1;
+
+			auto rtt = ioThread->GetRoundTripTime();
 			if (rtt == 0)
 				return -1;
 			return static_cast<int>(rtt);
@@ -494,153 +226,250 @@ namespace spades {
 
 		void NetClient::DoEvents(int timeout) {
 			SPADES_MARK_FUNCTION();
+			SPADES_TRACE_ZONE("NetClient::DoEvents");
 
 			if (status == NetClientStatusNotConnected)
 				return;
 
-			if (bandwidthMonitor)
-				bandwidthMonitor->Update();
+			if (demoReader) {
+				ProcessDemo(demoStopwatch.GetTime());
+				return;
+			}
 
-			ENetEvent event;
-			while (enet_host_service(host, &event, timeout) > 0) {
-				if (event.type == ENET_EVENT_TYPE_DISCONNECT) {
-					if (GetWorld())
-						client->SetWorld(NULL);
+			if (!ioThread)
+				return;
 
-					enet_peer_reset(peer);
-					peer = NULL;
-					status = NetClientStatusNotConnected;
+			if (bandwidthMonitor)
+				bandwidthMonitor->Update(ioThread->GetNumBytesSent(),
+				                         ioThread->GetNumBytesReceived());
 
-					std::string reasonStr = DisconnectReasonString(event.data);
-					SPLog("Disconnected (data = 0x%08x)", (unsigned int)event.data);
-					statusString = "Disconnected: " + reasonStr;
-					SPRaise("Disconnected: %s", reasonStr.c_str());
-				}
+			NetIOEvent event;
+			while (ioThread && ioThread->Poll(event, timeout)) {
+				// Record the time the event was received at, not when it's handled
+				double demoTime = demoStopwatch.GetTime() - (ioThread->GetTime() - event.time);
 
-				stmp::optional<NetPacketReader> readerOrNone;
-				if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-					readerOrNone.reset(event.packet);
-					auto& reader = readerOrNone.value();
-
-					try {
-						if (HandleHandshakePackets(reader))
-							continue;
-					} catch (const std::exception& ex) {
-						int type = reader.GetType();
-						reader.DumpDebug();
-						SPRaise("Exception while handling packet type 0x%08x:\n%s", type, ex.what());
-					}
+				switch (event.type) {
+					case NetIOEventType::Connect:
+						if (demoWriter)
+							demoWriter->WriteConnect(demoTime);
+						HandleConnect();
+						break;
+					case NetIOEventType::Receive: {
+						NetPacketReader reader{event.packet};
+						if (demoWriter) {
+							demoWriter->WritePacket(demoTime, event.packet->data,
+							                        event.packet->dataLength);
+						}
+						HandlePacket(reader);
+					} break;
+					case NetIOEventType::Disconnect:
+						if (demoWriter)
+							demoWriter->WriteDisconnect(demoTime, event.reason);
+						HandleDisconnect(event.reason);
+						break;
+					case NetIOEventType::None: break;
 				}
+			}
+		}
 
-				if (status == NetClientStatusConnecting) {
-					if (event.type == ENET_EVENT_TYPE_CONNECT) {
-						statusString = _Tr("NetClient", "Awaiting for state");
-					} else if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-						auto& reader = readerOrNone.value();
-						reader.DumpDebug();
-						if (reader.GetType() != PacketTypeMapStart)
-							SPRaise("Unexpected packet: %d", (int)reader.GetType());
-
-						auto mapSize = reader.ReadInt();
-						SPLog("Map size advertised by the server: %lu", (unsigned long)mapSize);
+		void NetClient::HandleConnect() {
+			if (status == NetClientStatusConnecting)
+				statusString = _Tr("NetClient", "Awaiting for state");
+		}
 
-						mapLoader.reset(new GameMapLoader());
-						mapLoadMonitor.reset(new MapDownloadMonitor(*mapLoader));
+		void NetClient::HandleDisconnect(std::uint32_t reason) {
+			if (GetWorld())
+				listener->SetWorld(NULL);
 
-						status = NetClientStatusReceivingMap;
-						statusString = _Tr("NetClient", "Loading snapshot");
-					}
-				} else if (status == NetClientStatusReceivingMap) {
-					SPAssert(mapLoader);
+			ioThread.reset();
+			if (peer)
+				enet_peer_reset(peer);
+			peer = NULL;
+			demoWriter.reset();
+			demoReader.reset();
+			nextDemoEvent.reset();
+			status = NetClientStatusNotConnected;
 
-					if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-						auto& reader = readerOrNone.value();
+			std::string reasonStr = DisconnectReasonString(reason);
+			SPLog("Disconnected (data = 0x%08x)", (unsigned int)reason);
+			statusString = "Disconnected: " + reasonStr;
+			SPRaise("Disconnected: %s", reasonStr.c_str());
+		}
 
-						if (reader.GetType() == PacketTypeMapChunk) {
-							std::vector<char> dt = reader.GetData();
+		void NetClient::HandlePacket(NetPacketReader& reader) {
+			SPADES_MARK_FUNCTION();
 
-							mapLoader->AddRawChunk(dt.data() + 1, dt.size() - 1);
-							mapLoadMonitor->AccumulateBytes(
-							  static_cast<unsigned int>(dt.size() - 1));
-						} else {
-							reader.DumpDebug();
-
-							// The actual size of the map data cannot be known beforehand because
-							// of compression. This means we must detect the end of the map
-							// transfer in another way.
-							//
-							// We do this by checking for a StateData packet, which is sent
-							// directly after the map transfer completes.
-							//
-							// A number of other packets can also be received while loading the map:
-							//
-							//  - World update packets (WorldUpdate, ExistingPlayer, and
-							//    CreatePlayer) for the current round. We must store such packets
-							//    temporarily and process them later when a `World` is created.
-							//
-							//  - Leftover reload packet from the previous round. This happens when
-							//    you initiate the reload action and a map change occurs before it
-							//    is completed. In pyspades, sending a reload packet is implemented
-							//    by registering a callback function to the Twisted reactor. This
-							//    callback function sends a reload packet, but it does not check if
-							//    the current game round is finished, nor is it unregistered on a
-							//    map change.
-							//
-							//    Such a reload packet would not (and should not) have any effect on
-							//    the current round. Also, an attempt to process it would result in
-							//    an "invalid player ID" exception, so we simply drop it during
-							//    map load sequence.
-							//
-
-							if (reader.GetType() == PacketTypeStateData) {
-								status = NetClientStatusConnected;
-								statusString = _Tr("NetClient", "Connected");
-
-								try {
-									MapLoaded();
-								} catch (const std::exception& ex) {
-									if (strstr(ex.what(), "File truncated") ||
-									    strstr(ex.what(), "EOF reached")) {
-										SPLog("Map decoder returned error:\n%s", ex.what());
-										Disconnect();
-										statusString = _Tr("NetClient", "Error");
-										throw;
-									}
-								} catch (...) {
-									Disconnect();
-									statusString = _Tr("NetClient", "Error");
-									throw;
-								}
+			try {
+				if (HandleHandshakePackets(reader))
+					return;
+			} catch (const std::exception& ex) {
+				int type = reader.GetType();
+				reader.DumpDebug();
+				SPRaise("Exception while handling packet type 0x%08x:\n%s", type, ex.what());
+			}
 
-								HandleGamePacket(reader);
-							} else if (reader.GetType() == PacketTypeWeaponReload) {
-								// Drop the reload packet. Pyspades does not
-								// cancel the reload packets on map change and
-								// they would cause an error if we would
-								// process them
-							} else {
-								// Save the packet for later
-								savedPackets.push_back(reader.GetData());
-							}
-						}
+			if (status == NetClientStatusConnecting) {
+				reader.DumpDebug();
+				if (reader.GetType() != PacketTypeMapStart)
+					SPRaise("Unexpected packet: %d", (int)reader.GetType());
+
+				MapStarted(reader);
+			} else if (status == NetClientStatusReceivingMap) {
+				SPAssert(mapLoader);
+
+				if (reader.GetType() == PacketTypeMapChunk) {
+					// A server that doesn't honor MapCached still sends the map, which we
+					// already have
+					if (!mapLoader->IsFromCache()) {
+						std::size_t numBytes = reader.GetNumRemainingBytes();
+						mapLoader->AddRawChunk(reader.PeekRemainingData(), numBytes);
+						mapLoadMonitor->AccumulateBytes(static_cast<unsigned int>(numBytes));
 					}
-				} else if (status == NetClientStatusConnected) {
-					if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-						auto& reader = readerOrNone.value();
+				} else {
+					reader.DumpDebug();
+
+					// The actual size of the map data cannot be known beforehand because
+					// of compression. This means we must detect the end of the map
+					// transfer in another way.
+					//
+					// We do this by checking for a StateData packet, which is sent
+					// directly after the map transfer completes.
+					//
+					// A number of other packets can also be received while loading the map:
+					//
+					//  - World update packets (WorldUpdate, ExistingPlayer, and
+					//    CreatePlayer) for the current round. We must store such packets
+					//    temporarily and process them later when a `World` is created.
+					//
+					//  - Leftover reload packet from the previous round. This happens when
+					//    you initiate the reload action and a map change occurs before it
+					//    is completed. In pyspades, sending a reload packet is implemented
+					//    by registering a callback function to the Twisted reactor. This
+					//    callback function sends a reload packet, but it does not check if
+					//    the current game round is finished, nor is it unregistered on a
+					//    map change.
+					//
+					//    Such a reload packet would not (and should not) have any effect on
+					//    the current round. Also, an attempt to process it would result in
+					//    an "invalid player ID" exception, so we simply drop it during
+					//    map load sequence.
+					//
+
+					if (reader.GetType() == PacketTypeStateData) {
+						status = NetClientStatusConnected;
+						statusString = _Tr("NetClient", "Connected");
 
 						try {
-							HandleGamePacket(reader);
+							MapLoaded();
 						} catch (const std::exception& ex) {
-							int type = reader.GetType();
-							reader.DumpDebug();
-							SPRaise("Exception while handling packet type 0x%08x:\n%s", type, ex.what());
+							if (strstr(ex.what(), "File truncated") ||
+							    strstr(ex.what(), "EOF reached")) {
+								SPLog("Map decoder returned error:\n%s", ex.what());
+								Disconnect();
+								statusString = _Tr("NetClient", "Error");
+								throw;
+							}
+						} catch (...) {
+							Disconnect();
+							statusString = _Tr("NetClient", "Error");
+							throw;
 						}
+
+						HandleGamePacket(reader);
+					} else if (reader.GetType() == PacketTypeWeaponReload) {
+						// Drop the reload packet. Pyspades does not
+						// cancel the reload packets on map change and
+						// they would cause an error if we would
+						// process them
+					} else {
+						// Save the packet for later
+						savedPackets.push_back(reader.Detach());
+					}
+				}
+			} else if (status == NetClientStatusConnected) {
+				try {
+					HandleGamePacket(reader);
+				} catch (const std::exception& ex) {
+					int type = reader.GetType();
+					reader.DumpDebug();
+					SPRaise("Exception while handling packet type 0x%08x:\n%s", type, ex.what());
+				}
+			}
+		}
+
+		void NetClient::StartRecording(std::unique_ptr<IStream> stream) {
+			SPADES_MARK_FUNCTION();
+
+			SPAssert(status == NetClientStatusConnecting);
+			SPAssert(!demoReader);
+
+			demoWriter.reset(
+			  new NetDemoWriter(std::move(stream), static_cast<ProtocolVersion>(protocolVersion)));
+			demoStopwatch.Reset();
+		}
+
+		void NetClient::StopRecording() {
+			if (!demoWriter)
+				return;
+			SPLog("Demo recording stopped (%llu bytes)",
+			      static_cast<unsigned long long>(demoWriter->GetNumBytesWritten()));
+			demoWriter.reset();
+		}
+
+		void NetClient::PlayDemo(std::unique_ptr<IStream> stream) {
+			SPADES_MARK_FUNCTION();
+
+			Disconnect();
+			SPAssert(status == NetClientStatusNotConnected);
+
+			std::unique_ptr<NetDemoReader> reader{new NetDemoReader(std::move(stream))};
+			ProtocolVersion version = reader->GetProtocolVersion();
+			SPLog("Playing a demo recorded with the protocol version %d", (int)version);
+
+			savedPackets.clear();
+			demoReader = std::move(reader);
+			nextDemoEvent.reset();
+			demoStopwatch.Reset();
+
+			protocolVersion = static_cast<int>(version);
+			properties.reset(new GameProperties(version));
+
+			status = NetClientStatusConnecting;
+			statusString = _Tr("NetClient", "Playing demo");
+		}
+
+		void NetClient::ProcessDemo(double time) {
+			SPADES_MARK_FUNCTION();
+
+			while (demoReader) {
+				if (!nextDemoEvent) {
+					NetDemoEvent event;
+					if (!demoReader->ReadEvent(event)) {
+						SPLog("End of the demo");
+						Disconnect();
+						statusString = _Tr("NetClient", "End of demo");
+						return;
 					}
+					nextDemoEvent = std::move(event);
+				}
+				if (nextDemoEvent->time > time)
+					return;
+
+				NetDemoEvent event = std::move(nextDemoEvent.value());
+				nextDemoEvent.reset();
+
+				switch (event.type) {
+					case NetDemoEventType::Connect: HandleConnect(); break;
+					case NetDemoEventType::Packet: {
+						NetPacketReader reader{event.data.data(), event.data.size()};
+						HandlePacket(reader);
+					} break;
+					case NetDemoEventType::Disconnect: HandleDisconnect(event.reason); break;
 				}
 			}
 		}
 
-		stmp::optional<World&> NetClient::GetWorld() { return client->GetWorld(); }
+		stmp::optional<World&> NetClient::GetWorld() { return listener->GetWorld(); }
 
 		stmp::optional<Player&> NetClient::GetPlayerOrNull(int pId) {
 			SPADES_MARK_FUNCTION();
@@ -773,7 +602,11 @@ namespace spades {
 					if (protocolVersion == 4)
 						bytesPerEntry++;
 
-					client->MarkWorldUpdate();
+					listener->MarkWorldUpdate();
+
+					float snapshotTime = 0.0F;
+					if (GetWorld())
+						snapshotTime = worldUpdateClock.Stamp(GetWorld()->GetSmoothTime());
 
 					int entries = static_cast<int>(r.GetPosition() / bytesPerEntry);
 					for (int i = 0; i < entries; i++) {
@@ -799,8 +632,13 @@ namespace spades {
 								auto p = GetWorld()->GetPlayer(idx);
 								if (p && p != GetWorld()->GetLocalPlayer()
 									&& p->IsAlive() && !p->IsSpectator()) {
-									p->RepositionPlayer(pos);
-									p->SetOrientation(front);
+									if ((float)cg_interpolationDelay > 0.0F) {
+										// Applied by `World::UpdatePlayer`
+										p->AddSnapshot({snapshotTime, pos, front});
+									} else {
+										p->RepositionPlayer(pos);
+										p->SetOrientation(front);
+									}
 								}
 							}
 						}
@@ -1001,17 +839,17 @@ namespace spades {
 						blockColor.z = Clamp((int)cg_defaultBlockColorB, 0, 255);
 						pRef.SetHeldBlockColor(blockColor);
 
-						client->LocalPlayerCreated();
+						listener->LocalPlayerCreated();
 						lastPlayerInput = 0xFFFFFFFF;
 						lastWeaponInput = 0xFFFFFFFF;
 						SendHeldBlockColor(); // ensure block color synchronized
 					} else {
 						if (savedPlayerTeam[pId] != team) {
-							client->PlayerJoinedTeam(pRef);
+							listener->PlayerJoinedTeam(pRef);
 							savedPlayerTeam[pId] = team;
 						}
 					}
-					client->PlayerSpawned(pRef);
+					listener->PlayerSpawned(pRef);
 				} break;
 				case PacketTypeBlockAction: {
 					stmp::optional<Player&> p = GetPlayerOrNull(r.ReadByte());
@@ -1027,28 +865,28 @@ namespace spades {
 							if (!GetWorld()->GetMap()->IsSolidWrapped(pos.x, pos.y, pos.z)) {
 								p->UseBlocks(1);
 								if (p->IsLocalPlayer())
-									client->RegisterPlacedBlocks(1);
+									listener->RegisterPlacedBlocks(1);
 							}
-							client->PlayerCreatedBlock(*p);
+							listener->PlayerCreatedBlock(*p);
 						}
 					} else if (action == BlockActionTool) {
 						cells.push_back(pos);
 						GetWorld()->DestroyBlock(cells);
 						if (p && p->IsToolSpade())
 							p->GotBlock();
-						client->PlayerDestroyedBlockWithWeaponOrTool(pos);
+						listener->PlayerDestroyedBlockWithWeaponOrTool(pos);
 					} else if (action == BlockActionDig) {
 						for (int z = -1; z <= 1; z++)
 							cells.push_back(MakeIntVector3(pos.x, pos.y, pos.z + z));
 						GetWorld()->DestroyBlock(cells);
-						client->PlayerDiggedBlock(pos);
+						listener->PlayerDiggedBlock(pos);
 					} else if (action == BlockActionGrenade) {
 						for (int x = -1; x <= 1; x++)
 						for (int y = -1; y <= 1; y++)
 						for (int z = -1; z <= 1; z++)
 							cells.push_back(MakeIntVector3(pos.x + x, pos.y + y, pos.z + z));
 						GetWorld()->DestroyBlock(cells);
-						client->GrenadeDestroyedBlock(pos);
+						listener->GrenadeDestroyedBlock(pos);
 					}
 				} break;
 				case PacketTypeBlockLine: {
@@ -1069,8 +907,8 @@ namespace spades {
 						int blocks = static_cast<int>(cells.size());
 						p->UseBlocks(blocks);
 						if (p->IsLocalPlayer())
-							client->RegisterPlacedBlocks(blocks);
-						client->PlayerCreatedBlock(*p);
+							listener->RegisterPlacedBlocks(blocks);
+						listener->PlayerCreatedBlock(*p);
 					}
 				} break;
 				case PacketTypeStateData:
@@ -1151,7 +989,7 @@ namespace spades {
 
 							GetWorld()->SetMode(std::move(tc));
 						}
-						client->JoinedGame();
+						listener->JoinedGame();
 					}
 					break;
 				case PacketTypeKillAction: {
@@ -1196,41 +1034,31 @@ namespace spades {
 							return;
 						}
 
-						client->ServerSentMessage(false, msg);
+						listener->ServerSentMessage(false, msg);
 
 						// Speculate the best game properties based on the server generated messages
 						properties->HandleServerMessage(msg);
 					} else if (type == ChatTypeAll || type == ChatTypeTeam) {
 						stmp::optional<Player&> p = GetPlayerOrNull(playerId);
 						if (p) {
-							client->PlayerSentChatMessage(*p, (type == ChatTypeAll), msg);
+							listener->PlayerSentChatMessage(*p, (type == ChatTypeAll), msg);
 						} else {
-							client->ServerSentMessage((type == ChatTypeTeam), msg);
+							listener->ServerSentMessage((type == ChatTypeTeam), msg);
 						}
 					}
 				} break;
 				case PacketTypeMapStart: {
 					// next map!
-					if (protocolVersion == 4)
-						SendMapCached();
-
-					client->SetWorld(NULL);
+					listener->SetWorld(NULL);
 
-					auto mapSize = r.ReadInt();
-					SPLog("Map size advertised by the server: %lu", (unsigned long)mapSize);
-
-					mapLoader.reset(new GameMapLoader());
-					mapLoadMonitor.reset(new MapDownloadMonitor(*mapLoader));
-
-					status = NetClientStatusReceivingMap;
-					statusString = _Tr("NetClient", "Loading snapshot");
+					MapStarted(r);
 				} break;
 				case PacketTypeMapChunk: SPRaise("Unexpected: received Map Chunk while game");
 				case PacketTypePlayerLeft: {
 					int pId = r.ReadByte();
 					Player& p = GetPlayer(pId);
 
-					client->PlayerLeaving(p);
+					listener->PlayerLeaving(p);
 					GetWorld()->GetPlayerPersistent(pId).score = 0;
 
 					savedPlayerTeam[pId] = -1;
@@ -1259,7 +1087,7 @@ namespace spades {
 							territoryId, numTerritories - 1);
 					}
 
-					client->TeamCapturedTerritory(state, territoryId);
+					listener->TeamCapturedTerritory(state, territoryId);
 
 					TCGameMode::Territory& t = tc.GetTerritory(territoryId);
 					t.ownerTeamId = state;
@@ -1269,7 +1097,7 @@ namespace spades {
 					t.capturingTeamId = -1;
 
 					if (winning)
-						client->TeamWon(state);
+						listener->TeamWon(state);
 				} break;
 				case PacketTypeProgressBar: {
 					int territoryId = r.ReadByte();
@@ -1325,13 +1153,13 @@ namespace spades {
 					team.score++;
 					team.hasIntel = false;
 
-					client->PlayerCapturedIntel(p);
+					listener->PlayerCapturedIntel(p);
 					GetWorld()->GetPlayerPersistent(pId).score += 10;
 
 					bool winning = r.ReadByte() != 0;
 					if (winning) {
 						ctf.ResetIntelHoldingStatus(cg_resetTeamScore);
-						client->TeamWon(teamId);
+						listener->TeamWon(teamId);
 					}
 				} break;
 				case PacketTypeIntelPickup: {
@@ -1351,7 +1179,7 @@ namespace spades {
 					CTFGameMode::Team& team = ctf.GetTeam(p.GetTeamId());
 					team.hasIntel = true;
 					team.carrierId = pId;
-					client->PlayerPickedIntel(p);
+					listener->PlayerPickedIntel(p);
 				} break;
 				case PacketTypeIntelDrop: {
 					stmp::optional<IGameMode&> mode = GetWorld()->GetMode();
@@ -1369,7 +1197,7 @@ namespace spades {
 					auto& ctf = dynamic_cast<CTFGameMode&>(mode.value());
 					ctf.GetTeam(teamId).hasIntel = false;
 					ctf.GetTeam(1 - teamId).flagPos = r.ReadVector3();
-					client->PlayerDropIntel(p);
+					listener->PlayerDropIntel(p);
 				} break;
 				case PacketTypeRestock: {
 					int pId = r.ReadByte(); // skip player id
@@ -1464,7 +1292,7 @@ namespace spades {
 				}
 
 				w.Update(lengthLabel, (uint8_t)(w.GetPosition() - beginLabel));
-				enet_peer_send(peer, 0, w.CreatePacket());
+				SendPacket(w);
 			}
 		}
 
@@ -1487,7 +1315,7 @@ namespace spades {
 			w.WriteInt((uint32_t)score);
 			w.WriteColor(GetWorld()->GetTeamColor(team));
 			w.WriteString(name, 16);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendPosition(spades::Vector3 v) {
@@ -1495,7 +1323,7 @@ namespace spades {
 
 			NetPacketWriter w(PacketTypePositionData);
 			w.WriteVector3(v);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendOrientation(spades::Vector3 v) {
@@ -1503,7 +1331,10 @@ namespace spades {
 
 			NetPacketWriter w(PacketTypeOrientationData);
 			w.WriteVector3(v);
-			enet_peer_send(peer, 0, w.CreatePacket());
+
+			// Sent at a fixed rate by the I/O thread
+			if (ioThread)
+				ioThread->SendCoalesced(w.CreatePacket());
 		}
 
 		void NetClient::SendPlayerInput(PlayerInput inp) {
@@ -1527,7 +1358,7 @@ namespace spades {
 			NetPacketWriter w(PacketTypeInputData);
 			w.WriteByte((uint8_t)GetLocalPlayer().GetId());
 			w.WriteByte(bits);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendWeaponInput(WeaponInput inp) {
@@ -1543,7 +1374,7 @@ namespace spades {
 			NetPacketWriter w(PacketTypeWeaponInput);
 			w.WriteByte((uint8_t)GetLocalPlayer().GetId());
 			w.WriteByte(bits);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendHit(int targetPlayerId, HitType type) {
@@ -1559,7 +1390,7 @@ namespace spades {
 				case HitTypeMelee: w.WriteByte((uint8_t)4); break;
 				default: SPInvalidEnum("type", type);
 			}
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendGrenade(const Grenade& g) {
@@ -1570,7 +1401,7 @@ namespace spades {
 			w.WriteFloat(g.GetFuse());
 			w.WriteVector3(g.GetPosition());
 			w.WriteVector3(g.GetVelocity());
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendTool() {
@@ -1586,7 +1417,7 @@ namespace spades {
 				case Player::ToolGrenade: w.WriteByte((uint8_t)3); break;
 				default: SPInvalidEnum("tool", type);
 			}
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendHeldBlockColor() {
@@ -1595,7 +1426,7 @@ namespace spades {
 			NetPacketWriter w(PacketTypeSetColour);
 			w.WriteByte((uint8_t)GetLocalPlayer().GetId());
 			w.WriteColor(GetLocalPlayer().GetBlockColor());
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendBlockAction(spades::IntVector3 v, BlockActionType type) {
@@ -1611,7 +1442,7 @@ namespace spades {
 				default: SPInvalidEnum("type", type);
 			}
 			w.WriteIntVector3(v);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendBlockLine(spades::IntVector3 v1, spades::IntVector3 v2) {
@@ -1621,7 +1452,7 @@ namespace spades {
 			w.WriteByte((uint8_t)GetLocalPlayer().GetId());
 			w.WriteIntVector3(v1);
 			w.WriteIntVector3(v2);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendChat(std::string text, bool global) {
@@ -1632,7 +1463,7 @@ namespace spades {
 			w.WriteByte((uint8_t)(global ? 0 : 1));
 			w.WriteString(text);
 			w.WriteByte((uint8_t)0);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendReload() {
@@ -1642,7 +1473,7 @@ namespace spades {
 			w.WriteByte((uint8_t)GetLocalPlayer().GetId());
 			w.WriteByte((uint8_t)0); // clip_ammo; not used?
 			w.WriteByte((uint8_t)0); // reserve_ammo; not used?
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendTeamChange(int team) {
@@ -1651,7 +1482,7 @@ namespace spades {
 			NetPacketWriter w(PacketTypeChangeTeam);
 			w.WriteByte((uint8_t)GetLocalPlayer().GetId());
 			w.WriteByte((uint8_t)team);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendWeaponChange(WeaponType wType) {
@@ -1660,20 +1491,19 @@ namespace spades {
 			NetPacketWriter w(PacketTypeChangeWeapon);
 			w.WriteByte((uint8_t)GetLocalPlayer().GetId());
 			w.WriteByte((uint8_t)wType);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
-		void NetClient::SendMapCached() {
+		void NetClient::SendMapCached(bool cached) {
 			SPADES_MARK_FUNCTION();
 
 			// The AoS 0.76 protocol allows the client to load a map from a local cache
 			// if possible. After receiving MapStart, the client should respond with
 			// MapCached to indicate whether the map with a given checksum exists in the
-			// cache or not. We didn't implement a local cache, so we always ask the
-			// server to send fresh map data.
+			// cache or not. If it does, the server skips the map transfer.
 			NetPacketWriter w(PacketTypeMapCached);
-			w.WriteByte((uint8_t)0);
-			enet_peer_send(peer, 0, w.CreatePacket());
+			w.WriteByte((uint8_t)(cached ? 1 : 0));
+			SendPacket(w);
 		}
 
 		void NetClient::SendHandShakeValid(int challenge) {
@@ -1683,7 +1513,7 @@ namespace spades {
 			w.WriteInt((uint32_t)challenge);
 
 			SPLog("Sending hand shake back.");
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendVersion() {
@@ -1700,7 +1530,7 @@ namespace spades {
 			w.WriteString(osInfo);
 
 			SPLog("Sending version back.");
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
 		}
 
 		void NetClient::SendSupportedExtensions() {
@@ -1714,7 +1544,44 @@ namespace spades {
 			}
 
 			SPLog("Sending extension support.");
-			enet_peer_send(peer, 0, w.CreatePacket());
+			SendPacket(w);
+		}
+
+		void NetClient::SendPacket(NetPacketWriter& w) {
+			// Nothing is sent while playing a demo
+			if (!ioThread)
+				return;
+
+			ioThread->Send(w.CreatePacket());
+		}
+
+		void NetClient::MapStarted(NetPacketReader& r) {
+			SPADES_MARK_FUNCTION();
+
+			auto mapSize = r.ReadInt();
+			SPLog("Map size advertised by the server: %lu", (unsigned long)mapSize);
+
+			Handle<GameMap> cachedMap;
+			if (protocolVersion == 4) {
+				uint32_t checksum = r.ReadInt();
+				std::string mapName = r.ReadRemainingString();
+				SPLog("Map checksum advertised by the server: %08x (%s)", checksum,
+				      mapName.c_str());
+
+				// A demo must contain the map transfer, so don't use the cache for one
+				if (!demoWriter && !demoReader)
+					cachedMap = MapCache::GetInstance().Load(checksum);
+				SendMapCached(static_cast<bool>(cachedMap));
+			}
+
+			if (cachedMap)
+				mapLoader.reset(new GameMapLoader(std::move(cachedMap)));
+			else
+				mapLoader.reset(new GameMapLoader());
+			mapLoadMonitor.reset(new MapDownloadMonitor(*mapLoader));
+
+			status = NetClientStatusReceivingMap;
+			statusString = _Tr("NetClient", "Loading snapshot");
 		}
 
 		void NetClient::MapLoaded() {
@@ -1728,18 +1595,26 @@ namespace spades {
 			mapLoadMonitor.reset();
 
 			SPLog("Waiting for the game map decoding to complete...");
-			mapLoader->MarkEOF();
+			if (!mapLoader->IsFromCache())
+				mapLoader->MarkEOF();
 			mapLoader->WaitComplete();
-			GameMap* map = mapLoader->TakeGameMap().Unmanage();
+			std::unique_ptr<GameMapWrapper> mapWrapper;
+			GameMap* map = mapLoader->TakeGameMap(&mapWrapper).Unmanage();
 			SPLog("The game map was decoded successfully.");
 
+			if (!mapLoader->IsFromCache() && !demoReader) {
+				// The server might identify the map by either checksum
+				MapCache::GetInstance().Store(
+				  *map, {mapLoader->GetRawDataChecksum(), mapLoader->GetDataChecksum()});
+			}
+
 			// now initialize world
 			World* w = new World(properties);
-			w->SetMap(map);
+			w->SetMap(map, std::move(mapWrapper));
 			map->Release();
 			SPLog("World initialized.");
 
-			client->SetWorld(w);
+			listener->SetWorld(w);
 
 			SPAssert(GetWorld());
 
@@ -1749,10 +1624,8 @@ namespace spades {
 
 			// do saved packets
 			try {
-				for (const auto& packets : savedPackets) {
-					NetPacketReader r(packets);
+				for (auto& r : savedPackets)
 					HandleGamePacket(r);
-				}
 				savedPackets.clear();
 				SPLog("Done.");
 			} catch (...) {
@@ -1778,17 +1651,24 @@ namespace spades {
 			return statusString;
 		}
 
-		NetClient::BandwidthMonitor::BandwidthMonitor(ENetHost* host)
-		    : host(host), lastDown(0.0), lastUp(0.0) {
+		NetClient::BandwidthMonitor::BandwidthMonitor()
+		    : lastDown(0.0), lastUp(0.0), lastTotalSent(0), lastTotalReceived(0) {
 			sw.Reset();
 		}
 
-		void NetClient::BandwidthMonitor::Update() {
+		void NetClient::BandwidthMonitor::Update(std::uint64_t totalSent,
+		                                         std::uint64_t totalReceived) {
+			// The totals restart from zero on a new connection
+			if (totalSent < lastTotalSent || totalReceived < lastTotalReceived) {
+				lastTotalSent = totalSent;
+				lastTotalReceived = totalReceived;
+				sw.Reset();
+			}
 			if (sw.GetTime() > 0.5) {
-				lastUp = host->totalSentData / sw.GetTime();
-				lastDown = host->totalReceivedData / sw.GetTime();
-				host->totalSentData = 0;
-				host->totalReceivedData = 0;
+				lastUp = (totalSent - lastTotalSent) / sw.GetTime();
+				lastDown = (totalReceived - lastTotalReceived) / sw.GetTime();
+				lastTotalSent = totalSent;
+				lastTotalReceived = totalReceived;
 				sw.Reset();
 			}
 		}
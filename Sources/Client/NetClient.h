@@ -28,12 +28,16 @@
 #include <unordered_map>
 #include <vector>
 
+#include "NetDemo.h"
+#include "NetPacket.h"
 #include "PhysicsConstants.h"
 #include "Player.h"
+#include "PlayerSnapshotBuffer.h"
 #include <Core/Debug.h>
 #include <Core/Math.h>
 #include <Core/ServerAddress.h>
 #include <Core/Stopwatch.h>
+#include <Core/TMPUtils.h>
 #include <Core/VersionInfo.h>
 #include <OpenSpades.h>
 
@@ -44,7 +48,8 @@ typedef _ENetPeer ENetPeer;
 
 namespace spades {
 	namespace client {
-		class Client;
+		class INetClientListener;
+		class NetIOThread;
 		class Player;
 		enum NetClientStatus {
 			NetClientStatusNotConnected = 0,
@@ -61,8 +66,6 @@ namespace spades {
 		};
 
 		class World;
-		class NetPacketReader;
-		class NetPacketWriter;
 		struct PlayerInput;
 		struct WeaponInput;
 		class Grenade;
@@ -70,10 +73,12 @@ namespace spades {
 		class GameMapLoader;
 
 		class NetClient {
-			Client* client;
+			INetClientListener* listener;
 			NetClientStatus status;
 			ENetHost* host;
 			ENetPeer* peer;
+			/** Services `host` while connected. `host` and `peer` must not be used meanwhile. */
+			std::unique_ptr<NetIOThread> ioThread;
 			std::string statusString;
 
 			class MapDownloadMonitor {
@@ -106,16 +111,18 @@ namespace spades {
 			  {ExtensionTypeKickReason, 1}};
 
 			class BandwidthMonitor {
-				ENetHost* host;
 				Stopwatch sw;
 				double lastDown;
 				double lastUp;
+				std::uint64_t lastTotalSent;
+				std::uint64_t lastTotalReceived;
 
 			public:
-				BandwidthMonitor(ENetHost*);
+				BandwidthMonitor();
 				double GetDownlinkBps() { return lastDown * 8.0; }
 				double GetUplinkBps() { return lastUp * 8.0; }
-				void Update();
+				/** Takes the numbers of bytes transferred since the connection started. */
+				void Update(std::uint64_t totalSent, std::uint64_t totalReceived);
 			};
 
 			std::unique_ptr<BandwidthMonitor> bandwidthMonitor;
@@ -124,7 +131,10 @@ namespace spades {
 			std::vector<Vector3> savedPlayerFront;
 			std::vector<int> savedPlayerTeam;
 
-			std::vector<std::vector<char>> savedPackets;
+			std::vector<NetPacketReader> savedPackets;
+
+			/** Stamps the world updates for the interpolation of the remote players. */
+			SnapshotClock worldUpdateClock;
 
 			unsigned int lastPlayerInput;
 			unsigned int lastWeaponInput;
@@ -132,6 +142,17 @@ namespace spades {
 			// used for some scripts including Arena
 			IntVector3 temporaryPlayerBlockColor;
 
+			/** Measures the time since the start of the recording or the playback. */
+			Stopwatch demoStopwatch;
+			std::unique_ptr<NetDemoWriter> demoWriter;
+			std::unique_ptr<NetDemoReader> demoReader;
+			/** The next event of `demoReader`, which is not due yet. */
+			stmp::optional<NetDemoEvent> nextDemoEvent;
+
+			void HandleConnect();
+			void HandlePacket(NetPacketReader&);
+			void HandleDisconnect(std::uint32_t reason);
+
 			bool HandleHandshakePackets(NetPacketReader&);
 			void HandleExtensionPacket(NetPacketReader&);
 			void HandleGamePacket(NetPacketReader&);
@@ -144,15 +165,18 @@ namespace spades {
 			std::string customKickReasonString;
 			std::string DisconnectReasonString(uint32_t);
 
+			/** Handles `MapStart`, which starts the transfer of a new map. */
+			void MapStarted(NetPacketReader&);
 			void MapLoaded();
 
-			void SendMapCached();
+			void SendMapCached(bool cached);
 			void SendVersion();
 			void SendVersionEnhanced(const std::set<std::uint8_t>& propertyIds);
 			void SendSupportedExtensions();
+			void SendPacket(NetPacketWriter&);
 
 		public:
-			NetClient(Client*);
+			NetClient(INetClientListener*);
 			~NetClient();
 
 			NetClientStatus GetStatus() { return status; }
@@ -183,6 +207,28 @@ namespace spades {
 
 			void DoEvents(int timeout = 0);
 
+			/**
+			 * Starts writing the events received from the server to a demo file. Must be called
+			 * after `Connect` and before the first `DoEvents`.
+			 */
+			void StartRecording(std::unique_ptr<IStream>);
+			void StopRecording();
+			bool IsRecording() { return static_cast<bool>(demoWriter); }
+
+			/**
+			 * Plays a demo file instead of connecting to a server. `DoEvents` replays the events
+			 * in real time, and `ProcessDemo` as fast as the caller wants. Nothing is sent.
+			 */
+			void PlayDemo(std::unique_ptr<IStream>);
+			bool IsPlayingDemo() { return static_cast<bool>(demoReader); }
+
+			/**
+			 * Handles the events of the demo being played up to `time`, which is measured from
+			 * the start of the demo in seconds. The status changes to
+			 * `NetClientStatusNotConnected` at the end of the demo.
+			 */
+			void ProcessDemo(double time);
+
 			void SendJoin(int team, WeaponType, std::string name, int score);
 			void SendPosition(Vector3);
 			void SendOrientation(Vector3);
@@ -0,0 +1,188 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "NetDemo.h"
+#include <Core/Debug.h>
+#include <Core/Exception.h>
+#include <Core/IStream.h>
+
+namespace spades {
+	namespace client {
+		namespace {
+			const char DemoSignature[8] = {'S', 'P', 'D', 'E', 'M', 'O', '0', '1'};
+
+			/** Packets beyond this size are certainly a corruption. */
+			constexpr std::uint64_t MaxPacketSize = 1 << 24;
+
+			/** The buffered events are written when they exceed this size... */
+			constexpr std::size_t FlushSize = 64 * 1024;
+			/** ...or span this many milliseconds. */
+			constexpr std::uint64_t FlushInterval = 1000;
+		} // namespace
+
+		NetDemoWriter::NetDemoWriter(std::unique_ptr<IStream> stream, ProtocolVersion version)
+		    : stream(std::move(stream)) {
+			SPADES_MARK_FUNCTION();
+
+			buffer.assign(DemoSignature, DemoSignature + sizeof(DemoSignature));
+			buffer.push_back(static_cast<char>(version));
+			Flush();
+		}
+
+		NetDemoWriter::~NetDemoWriter() {
+			try {
+				Flush();
+			} catch (const std::exception& ex) {
+				SPLog("Failed to write the end of the demo: %s", ex.what());
+			}
+		}
+
+		void NetDemoWriter::WriteVarInt(std::uint64_t value) {
+			while (value >= 0x80) {
+				buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+				value >>= 7;
+			}
+			buffer.push_back(static_cast<char>(value));
+		}
+
+		void NetDemoWriter::WriteHeader(double time, NetDemoEventType type) {
+			auto timeMillis = static_cast<std::uint64_t>(std::max(time, 0.0) * 1000.0);
+			// The clock shouldn't go backward, but never write a negative delta
+			timeMillis = std::max(timeMillis, lastTime);
+			WriteVarInt(timeMillis - lastTime);
+			lastTime = timeMillis;
+			buffer.push_back(static_cast<char>(type));
+		}
+
+		void NetDemoWriter::Flush() {
+			if (!buffer.empty())
+				stream->Write(buffer.data(), buffer.size());
+			buffer.clear();
+			lastFlushTime = lastTime;
+		}
+
+		void NetDemoWriter::FlushIfNeeded() {
+			if (buffer.size() >= FlushSize || lastTime - lastFlushTime >= FlushInterval)
+				Flush();
+		}
+
+		void NetDemoWriter::WriteConnect(double time) {
+			WriteHeader(time, NetDemoEventType::Connect);
+			FlushIfNeeded();
+		}
+
+		void NetDemoWriter::WritePacket(double time, const void* data, std::size_t numBytes) {
+			WriteHeader(time, NetDemoEventType::Packet);
+			WriteVarInt(numBytes);
+			const char* bytes = static_cast<const char*>(data);
+			buffer.insert(buffer.end(), bytes, bytes + numBytes);
+			FlushIfNeeded();
+		}
+
+		void NetDemoWriter::WriteDisconnect(double time, std::uint32_t reason) {
+			WriteHeader(time, NetDemoEventType::Disconnect);
+			WriteVarInt(reason);
+			Flush();
+		}
+
+		std::uint64_t NetDemoWriter::GetNumBytesWritten() {
+			return stream->GetPosition() + buffer.size();
+		}
+
+		NetDemoReader::NetDemoReader(std::unique_ptr<IStream> stream) : stream(std::move(stream)) {
+			SPADES_MARK_FUNCTION();
+
+			char signature[sizeof(DemoSignature)];
+			if (this->stream->Read(signature, sizeof(signature)) != sizeof(signature) ||
+			    std::memcmp(signature, DemoSignature, sizeof(signature)) != 0)
+				SPRaise("Not a demo file");
+
+			int version = this->stream->ReadByte();
+			switch (version) {
+				case static_cast<int>(ProtocolVersion::v075):
+				case static_cast<int>(ProtocolVersion::v076):
+					protocolVersion = static_cast<ProtocolVersion>(version);
+					break;
+				default: SPRaise("Unsupported protocol version in the demo: %d", version);
+			}
+		}
+
+		NetDemoReader::~NetDemoReader() {}
+
+		bool NetDemoReader::ReadVarInt(std::uint64_t& value) {
+			value = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				int b = stream->ReadByte();
+				if (b < 0) {
+					if (shift == 0)
+						return false;
+					SPRaise("Demo file truncated");
+				}
+				value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+				if (!(b & 0x80))
+					return true;
+			}
+			SPRaise("Invalid varint in the demo file");
+		}
+
+		bool NetDemoReader::ReadEvent(NetDemoEvent& event) {
+			SPADES_MARK_FUNCTION();
+
+			std::uint64_t delta;
+			if (!ReadVarInt(delta))
+				return false;
+			lastTime += delta;
+			event.time = static_cast<double>(lastTime) / 1000.0;
+
+			int type = stream->ReadByte();
+			std::uint64_t value;
+			switch (type) {
+				case static_cast<int>(NetDemoEventType::Connect):
+					event.type = NetDemoEventType::Connect;
+					break;
+				case static_cast<int>(NetDemoEventType::Packet):
+					event.type = NetDemoEventType::Packet;
+					if (!ReadVarInt(value))
+						SPRaise("Demo file truncated");
+					// An empty packet is recorded as is and rejected by `NetPacketReader`, like
+					// it was when it was received
+					if (value > MaxPacketSize)
+						SPRaise("Invalid packet size in the demo file: %llu",
+						        static_cast<unsigned long long>(value));
+					event.data.resize(static_cast<std::size_t>(value));
+					if (stream->Read(event.data.data(), event.data.size()) != event.data.size())
+						SPRaise("Demo file truncated");
+					break;
+				case static_cast<int>(NetDemoEventType::Disconnect):
+					event.type = NetDemoEventType::Disconnect;
+					if (!ReadVarInt(value))
+						SPRaise("Demo file truncated");
+					event.reason = static_cast<std::uint32_t>(value);
+					break;
+				case -1: SPRaise("Demo file truncated");
+				default: SPRaise("Invalid event type in the demo file: %d", type);
+			}
+			return true;
+		}
+	} // namespace client
+} // namespace spades
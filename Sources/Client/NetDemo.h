@@ -0,0 +1,107 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Core/ServerAddress.h>
+
+namespace spades {
+	class IStream;
+
+	namespace client {
+		enum class NetDemoEventType : std::uint8_t { Connect = 0, Packet = 1, Disconnect = 2 };
+
+		/** A network event received by `NetClient`. */
+		struct NetDemoEvent {
+			/** The time since the start of the recording, in seconds. */
+			double time = 0.0;
+			NetDemoEventType type = NetDemoEventType::Packet;
+			/** The raw packet for `Packet`. */
+			std::vector<char> data;
+			/** The reason code for `Disconnect`. */
+			std::uint32_t reason = 0;
+		};
+
+		/**
+		 * Writes the events received from a server to a demo file.
+		 *
+		 * A demo file starts with an 8-byte signature and the protocol version, followed by
+		 * events. Each event is encoded as the time since the previous one in milliseconds
+		 * (varint), the event type (one byte), and the payload: a varint length and the packet
+		 * for `Packet`, a varint reason code for `Disconnect`. The map transfer is stored as it
+		 * was received, so no further compression is done.
+		 *
+		 * Events are buffered and written in batches, at least once per second of recording,
+		 * so the recording doesn't cost a write per packet. The stream only ever receives
+		 * whole events, so an interrupted recording still ends at an event boundary.
+		 */
+		class NetDemoWriter {
+			std::unique_ptr<IStream> stream;
+			std::uint64_t lastTime = 0;
+			std::uint64_t lastFlushTime = 0;
+			std::vector<char> buffer;
+
+			void WriteVarInt(std::uint64_t);
+			void WriteHeader(double time, NetDemoEventType);
+			void FlushIfNeeded();
+
+		public:
+			NetDemoWriter(std::unique_ptr<IStream> stream, ProtocolVersion);
+			~NetDemoWriter();
+
+			void WriteConnect(double time);
+			void WritePacket(double time, const void* data, std::size_t numBytes);
+			void WriteDisconnect(double time, std::uint32_t reason);
+
+			/** Writes the buffered events to the stream. */
+			void Flush();
+
+			/** Returns the size of the recording, including the buffered events. */
+			std::uint64_t GetNumBytesWritten();
+		};
+
+		class NetDemoReader {
+			std::unique_ptr<IStream> stream;
+			ProtocolVersion protocolVersion;
+			std::uint64_t lastTime = 0;
+
+			/** Returns `false` if the stream ended before the first byte. */
+			bool ReadVarInt(std::uint64_t&);
+
+		public:
+			/** Reads the header of a demo file. Raises an exception if it's not a demo file. */
+			NetDemoReader(std::unique_ptr<IStream> stream);
+			~NetDemoReader();
+
+			ProtocolVersion GetProtocolVersion() const { return protocolVersion; }
+
+			/**
+			 * Reads the next event.
+			 *
+			 * @return `false` if the end of the demo was reached.
+			 */
+			bool ReadEvent(NetDemoEvent&);
+		};
+	} // namespace client
+} // namespace spades
@@ -0,0 +1,226 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <chrono>
+#include <thread>
+
+#include <enet/enet.h>
+
+#include "NetIOThread.h"
+#include <Core/Debug.h>
+#include <Core/Thread.h>
+#include <Core/TraceProfiler.h>
+
+namespace spades {
+	namespace client {
+		namespace {
+			/** How long `enet_host_service` may block waiting for incoming packets. */
+			constexpr enet_uint32 ServiceTimeoutMillis = 1;
+
+			/** The capacity of the queues. A full queue stalls the producer. */
+			constexpr std::size_t QueueCapacity = 4096;
+
+			void SleepBriefly() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+		} // namespace
+
+		class NetIOThread::ServiceThread : public Thread {
+		public:
+			ServiceThread(NetIOThread& owner) : owner{owner} {}
+			void Run() override {
+				SPADES_MARK_FUNCTION();
+				trace::SetThreadName("Network");
+				owner.Run();
+			}
+
+		private:
+			NetIOThread& owner;
+		};
+
+		NetIOThread::NetIOThread(ENetHost* host, ENetPeer* peer, double coalescedInterval)
+		    : host{host},
+		      peer{peer},
+		      coalescedInterval{coalescedInterval},
+		      incoming{QueueCapacity},
+		      outgoing{QueueCapacity},
+		      coalesced{nullptr},
+		      lastCoalescedTime{-coalescedInterval},
+		      stopRequested{false},
+		      roundTripTime{0},
+		      numBytesSent{0},
+		      numBytesReceived{0},
+		      numPacketsSent{0},
+		      totalSendDelay{0} {
+			SPADES_MARK_FUNCTION();
+
+			thread.reset(new ServiceThread(*this));
+			thread->Start();
+		}
+
+		NetIOThread::~NetIOThread() {
+			SPADES_MARK_FUNCTION();
+
+			stopRequested.store(true, std::memory_order_release);
+			thread->Join();
+			thread.reset();
+
+			NetIOEvent event;
+			while (incoming.TryPop(event)) {
+				if (event.packet)
+					enet_packet_destroy(event.packet);
+			}
+			if (ENetPacket* packet = coalesced.exchange(nullptr))
+				enet_packet_destroy(packet);
+		}
+
+		bool NetIOThread::Poll(NetIOEvent& event, int timeout) {
+			if (incoming.TryPop(event))
+				return true;
+			if (timeout <= 0)
+				return false;
+
+			Stopwatch sw;
+			while (sw.GetTime() * 1000.0 < timeout) {
+				SleepBriefly();
+				if (incoming.TryPop(event))
+					return true;
+			}
+			return false;
+		}
+
+		void NetIOThread::Send(ENetPacket* packet) {
+			OutgoingPacket item;
+			item.time = GetTime();
+
+			// Keep the order with the coalesced packet
+			if ((item.packet = coalesced.exchange(nullptr))) {
+				while (!outgoing.TryPush(item))
+					std::this_thread::yield();
+			}
+
+			item.packet = packet;
+			while (!outgoing.TryPush(item))
+				std::this_thread::yield();
+		}
+
+		void NetIOThread::SendCoalesced(ENetPacket* packet) {
+			if (ENetPacket* superseded = coalesced.exchange(packet))
+				enet_packet_destroy(superseded);
+		}
+
+		double NetIOThread::GetMeanSendDelay() const {
+			std::uint64_t count = numPacketsSent.load(std::memory_order_relaxed);
+			if (count == 0)
+				return 0.0;
+			return static_cast<double>(totalSendDelay.load(std::memory_order_relaxed)) / count *
+			       1.0e-6;
+		}
+
+		void NetIOThread::SendNow(ENetPacket* packet, double queuedTime) {
+			if (enet_peer_send(peer, 0, packet) < 0) {
+				// Not connected (yet or anymore)
+				enet_packet_destroy(packet);
+				return;
+			}
+
+			if (queuedTime >= 0.0) {
+				auto delay = static_cast<std::uint64_t>((GetTime() - queuedTime) * 1.0e6);
+				totalSendDelay.fetch_add(delay, std::memory_order_relaxed);
+				numPacketsSent.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		void NetIOThread::FlushOutgoing() {
+			OutgoingPacket item;
+			while (outgoing.TryPop(item))
+				SendNow(item.packet, item.time);
+		}
+
+		void NetIOThread::FlushCoalesced() {
+			double time = GetTime();
+			if (time - lastCoalescedTime < coalescedInterval)
+				return;
+			if (ENetPacket* packet = coalesced.exchange(nullptr)) {
+				SendNow(packet, -1.0);
+				lastCoalescedTime = time;
+			}
+		}
+
+		void NetIOThread::Run() {
+			// An event that didn't fit in the queue
+			NetIOEvent pending;
+
+			while (!stopRequested.load(std::memory_order_acquire)) {
+				FlushOutgoing();
+				FlushCoalesced();
+
+				if (pending.type != NetIOEventType::None) {
+					if (!incoming.TryPush(pending)) {
+						// The game thread is lagging behind. Stop receiving until it catches up.
+						enet_host_flush(host);
+						SleepBriefly();
+						continue;
+					}
+					pending = NetIOEvent{};
+				}
+
+				ENetEvent event;
+				int result = enet_host_service(host, &event, ServiceTimeoutMillis);
+				while (result > 0) {
+					NetIOEvent e;
+					e.time = GetTime();
+					switch (event.type) {
+						case ENET_EVENT_TYPE_CONNECT: e.type = NetIOEventType::Connect; break;
+						case ENET_EVENT_TYPE_RECEIVE:
+							e.type = NetIOEventType::Receive;
+							e.packet = event.packet;
+							break;
+						case ENET_EVENT_TYPE_DISCONNECT:
+							e.type = NetIOEventType::Disconnect;
+							e.reason = event.data;
+							break;
+						default: break;
+					}
+					if (e.type != NetIOEventType::None && !incoming.TryPush(e)) {
+						pending = e;
+						break;
+					}
+					result = enet_host_check_events(host, &event);
+				}
+				if (result < 0) {
+					// A socket error. Don't spin.
+					SleepBriefly();
+				}
+
+				roundTripTime.store(peer->roundTripTime, std::memory_order_relaxed);
+				numBytesSent.fetch_add(host->totalSentData, std::memory_order_relaxed);
+				numBytesReceived.fetch_add(host->totalReceivedData, std::memory_order_relaxed);
+				host->totalSentData = 0;
+				host->totalReceivedData = 0;
+			}
+
+			// Hand over what was queued before the stop to ENet
+			FlushOutgoing();
+			enet_host_flush(host);
+
+			if (pending.packet)
+				enet_packet_destroy(pending.packet);
+		}
+	} // namespace client
+} // namespace spades
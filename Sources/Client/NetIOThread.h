@@ -0,0 +1,145 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <Core/SPSCQueue.h>
+#include <Core/Stopwatch.h>
+
+struct _ENetHost;
+struct _ENetPeer;
+struct _ENetPacket;
+typedef _ENetHost ENetHost;
+typedef _ENetPeer ENetPeer;
+typedef _ENetPacket ENetPacket;
+
+namespace spades {
+	namespace client {
+		enum class NetIOEventType : std::uint8_t { None, Connect, Receive, Disconnect };
+
+		struct NetIOEvent {
+			NetIOEventType type = NetIOEventType::None;
+			/** The received packet for `Receive`. The receiver takes the ownership. */
+			ENetPacket* packet = nullptr;
+			/** The reason code for `Disconnect`. */
+			std::uint32_t reason = 0;
+			/** When the event was received, measured by `NetIOThread::GetTime`. */
+			double time = 0.0;
+		};
+
+		/**
+		 * Services an `ENetHost` on a dedicated thread so that receiving, sending, and the range
+		 * coder don't run on the game thread, and outgoing packets leave within a millisecond
+		 * instead of waiting for the next frame.
+		 *
+		 * The host and the peer are exclusively used by the thread until this object is
+		 * destroyed. Events and outgoing packets are exchanged through lock-free queues; all
+		 * other methods must be called by the single thread that owns this object.
+		 */
+		class NetIOThread {
+		public:
+			/**
+			 * Starts servicing `host`.
+			 *
+			 * @param coalescedInterval The minimum interval between the packets sent by
+			 *                          `SendCoalesced`, in seconds.
+			 */
+			NetIOThread(ENetHost* host, ENetPeer* peer, double coalescedInterval);
+			/** Stops the thread and destroys the packets that are still queued. */
+			~NetIOThread();
+
+			NetIOThread(const NetIOThread&) = delete;
+			void operator=(const NetIOThread&) = delete;
+
+			/**
+			 * Retrieves the next received event, waiting for up to `timeout` milliseconds.
+			 *
+			 * @return `false` if no event was received in time.
+			 */
+			bool Poll(NetIOEvent& event, int timeout = 0);
+
+			/** Queues a packet to be sent to the peer on channel 0. Takes its ownership. */
+			void Send(ENetPacket* packet);
+
+			/**
+			 * Sends a packet that supersedes the previous one sent by this method, such as the
+			 * player's orientation. It's sent at a fixed rate no matter how often this is
+			 * called; a packet that was not sent yet is replaced. Packets queued later by `Send`
+			 * are never sent before it.
+			 */
+			void SendCoalesced(ENetPacket* packet);
+
+			/** The time since the thread was started, in seconds. */
+			double GetTime() { return stopwatch.GetTime(); }
+
+			/** The last round trip time measured by ENet, in milliseconds. */
+			std::uint32_t GetRoundTripTime() const {
+				return roundTripTime.load(std::memory_order_relaxed);
+			}
+			std::uint64_t GetNumBytesSent() const {
+				return numBytesSent.load(std::memory_order_relaxed);
+			}
+			std::uint64_t GetNumBytesReceived() const {
+				return numBytesReceived.load(std::memory_order_relaxed);
+			}
+			/** The mean time outgoing packets spent in the queue, in seconds. */
+			double GetMeanSendDelay() const;
+
+		private:
+			class ServiceThread;
+
+			struct OutgoingPacket {
+				ENetPacket* packet = nullptr;
+				/** When the packet was queued, measured by `GetTime`. */
+				double time = 0.0;
+			};
+
+			ENetHost* const host;
+			ENetPeer* const peer;
+			const double coalescedInterval;
+			Stopwatch stopwatch;
+
+			SPSCQueue<NetIOEvent> incoming;
+			SPSCQueue<OutgoingPacket> outgoing;
+			/** The packet sent by `SendCoalesced` that is waiting for its turn. */
+			std::atomic<ENetPacket*> coalesced;
+			double lastCoalescedTime;
+
+			std::atomic<bool> stopRequested;
+			std::atomic<std::uint32_t> roundTripTime;
+			std::atomic<std::uint64_t> numBytesSent;
+			std::atomic<std::uint64_t> numBytesReceived;
+			std::atomic<std::uint64_t> numPacketsSent;
+			/** The sum of the queueing delays of the packets sent, in microseconds. */
+			std::atomic<std::uint64_t> totalSendDelay;
+
+			std::unique_ptr<ServiceThread> thread;
+
+			void Run();
+			void SendNow(ENetPacket*, double queuedTime);
+			void FlushOutgoing();
+			void FlushCoalesced();
+		};
+	} // namespace client
+} // namespace spades
@@ -0,0 +1,224 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cstdio>
+#include <mutex>
+
+#include <enet/enet.h>
+
+#include "NetPacket.h"
+#include <Core/CP437.h>
+#include <Core/Settings.h>
+#include <Core/TMPUtils.h>
+
+DEFINE_SPADES_SETTING(cg_unicode, "1");
+
+namespace spades {
+	namespace client {
+		namespace {
+			const char UTFSign = -1;
+
+			/**
+			 * Recycles the buffers of sent packets. ENet releases a packet when it's
+			 * acknowledged, which can happen on any thread that services the host.
+			 */
+			class PacketBufferPool {
+				enum {
+					MaxNumBuffers = 64,
+					/** Larger buffers are freed so that a rare big packet doesn't pin memory. */
+					MaxBufferCapacity = 4096,
+				};
+
+				std::mutex mutex;
+				std::vector<std::unique_ptr<std::vector<char>>> buffers;
+
+			public:
+				std::unique_ptr<std::vector<char>> Acquire() {
+					{
+						std::lock_guard<std::mutex> lock{mutex};
+						if (!buffers.empty()) {
+							auto buffer = std::move(buffers.back());
+							buffers.pop_back();
+							return buffer;
+						}
+					}
+					auto buffer = stmp::make_unique<std::vector<char>>();
+					buffer->reserve(64);
+					return buffer;
+				}
+
+				void Release(std::unique_ptr<std::vector<char>> buffer) {
+					if (buffer->capacity() > MaxBufferCapacity)
+						return;
+					buffer->clear();
+
+					std::lock_guard<std::mutex> lock{mutex};
+					if (buffers.size() < MaxNumBuffers)
+						buffers.push_back(std::move(buffer));
+				}
+			};
+
+			PacketBufferPool& GetPacketBufferPool() {
+				// Never destroyed; packets might be released during the static destruction
+				static PacketBufferPool* pool = new PacketBufferPool();
+				return *pool;
+			}
+
+			void ReleasePooledPacketData(ENetPacket* packet) {
+				std::unique_ptr<std::vector<char>> buffer{
+				  static_cast<std::vector<char>*>(packet->userData)};
+				packet->userData = nullptr;
+				GetPacketBufferPool().Release(std::move(buffer));
+			}
+		} // namespace
+
+		std::string EncodeString(std::string str) {
+			auto str2 = CP437::Encode(str, -1);
+			if (!cg_unicode)
+				return str2; // ignore fallbacks
+
+			// some fallbacks; always use UTF8
+			if (str2.find(-1) != std::string::npos)
+				str.insert(0, &UTFSign, 1);
+			else
+				str = str2;
+
+			return str;
+		}
+
+		std::string DecodeString(std::string s) {
+			if (s.size() > 0 && s[0] == UTFSign)
+				return s.substr(1);
+
+			return CP437::Decode(s);
+		}
+
+		NetPacketReader::NetPacketReader(ENetPacket* packet)
+		    : packet{packet},
+		      data{reinterpret_cast<const char*>(packet->data)},
+		      size{packet->dataLength},
+		      pos{1} {
+			if (size == 0) {
+				enet_packet_destroy(packet);
+				SPRaise("Received an empty packet");
+			}
+		}
+
+		NetPacketReader::NetPacketReader(const char* bytes, std::size_t numBytes)
+		    : packet{nullptr}, data{bytes}, size{numBytes}, pos{1} {
+			if (size == 0)
+				SPRaise("Received an empty packet");
+		}
+
+		NetPacketReader::NetPacketReader(NetPacketReader&& other)
+		    : packet{other.packet}, data{other.data}, size{other.size}, pos{other.pos} {
+			other.packet = nullptr;
+		}
+
+		NetPacketReader::~NetPacketReader() {
+			if (packet)
+				enet_packet_destroy(packet);
+		}
+
+		NetPacketReader& NetPacketReader::operator=(NetPacketReader&& other) {
+			if (this != &other) {
+				if (packet)
+					enet_packet_destroy(packet);
+				packet = other.packet;
+				data = other.data;
+				size = other.size;
+				pos = other.pos;
+				other.packet = nullptr;
+			}
+			return *this;
+		}
+
+		NetPacketReader NetPacketReader::Detach() {
+			ENetPacket* owned = packet;
+			if (owned)
+				packet = nullptr;
+			else
+				owned = enet_packet_create(data, size, 0);
+			if (!owned)
+				SPRaise("Failed to allocate a packet");
+			return NetPacketReader{owned};
+		}
+
+		void NetPacketReader::DumpDebug() {
+#if 1
+			char buf[1024];
+			std::string str;
+			sprintf(buf, "Packet 0x%02x [len=%d]", (int)GetType(), (int)size);
+			str = buf;
+			int bytes = (int)size;
+			if (bytes > 64)
+				bytes = 64;
+
+			for (int i = 0; i < bytes; i++) {
+				sprintf(buf, " %02x", (unsigned int)(unsigned char)data[i]);
+				str += buf;
+			}
+
+			SPLog("%s", str.c_str());
+#endif
+		}
+
+		NetPacketWriter::NetPacketWriter(PacketType type)
+		    : data{GetPacketBufferPool().Acquire()} {
+			data->push_back(type);
+		}
+
+		NetPacketWriter::~NetPacketWriter() {
+			if (data)
+				GetPacketBufferPool().Release(std::move(data));
+		}
+
+		void NetPacketWriter::WriteString(std::string str) {
+			str = EncodeString(str);
+			data->insert(data->end(), str.begin(), str.end());
+		}
+
+		void NetPacketWriter::WriteString(const std::string& str, size_t fillLen) {
+			WriteString(str.substr(0, fillLen));
+			size_t sz = str.size();
+			while (sz < fillLen) {
+				WriteByte((uint8_t)0);
+				sz++;
+			}
+		}
+
+		ENetPacket* NetPacketWriter::CreatePacket() {
+			return CreatePacket(ENET_PACKET_FLAG_RELIABLE);
+		}
+
+		ENetPacket* NetPacketWriter::CreatePacket(int flags) {
+			SPAssert(data);
+
+			ENetPacket* packet = enet_packet_create(data->data(), data->size(),
+			                                        flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+			if (!packet)
+				SPRaise("Failed to allocate a packet");
+
+			packet->userData = data.release();
+			packet->freeCallback = ReleasePooledPacketData;
+			return packet;
+		}
+	} // namespace client
+} // namespace spades
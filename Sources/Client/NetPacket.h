@@ -0,0 +1,316 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Core/Debug.h>
+#include <Core/Exception.h>
+#include <Core/Math.h>
+
+struct _ENetPacket;
+typedef _ENetPacket ENetPacket;
+
+namespace spades {
+	namespace client {
+		enum PacketType {
+			PacketTypePositionData = 0,			// C2S2P
+			PacketTypeOrientationData = 1,		// C2S2P
+			PacketTypeWorldUpdate = 2,			// S2C
+			PacketTypeInputData = 3,			// C2S2P
+			PacketTypeWeaponInput = 4,			// C2S2P
+			PacketTypeHitPacket = 5,			// C2S
+			PacketTypeSetHP = 5,				// S2C
+			PacketTypeGrenadePacket = 6,		// C2S2P
+			PacketTypeSetTool = 7,				// C2S2P
+			PacketTypeSetColour = 8,			// C2S2P
+			PacketTypeExistingPlayer = 9,		// C2S2P
+			PacketTypeShortPlayerData = 10,		// S2C
+			PacketTypeMoveObject = 11,			// S2C
+			PacketTypeCreatePlayer = 12,		// S2C
+			PacketTypeBlockAction = 13,			// C2S2P
+			PacketTypeBlockLine = 14,			// C2S2P
+			PacketTypeStateData = 15,			// S2C
+			PacketTypeKillAction = 16,			// S2C
+			PacketTypeChatMessage = 17,			// C2S2P
+			PacketTypeMapStart = 18,			// S2C
+			PacketTypeMapChunk = 19,			// S2C
+			PacketTypePlayerLeft = 20,			// S2P
+			PacketTypeTerritoryCapture = 21,	// S2P
+			PacketTypeProgressBar = 22,			// S2P
+			PacketTypeIntelCapture = 23,		// S2P
+			PacketTypeIntelPickup = 24,			// S2P
+			PacketTypeIntelDrop = 25,			// S2P
+			PacketTypeRestock = 26,				// S2P
+			PacketTypeFogColour = 27,			// S2C
+			PacketTypeWeaponReload = 28,		// C2S2P
+			PacketTypeChangeTeam = 29,			// C2S2P
+			PacketTypeChangeWeapon = 30,		// C2S2P
+			PacketTypeMapCached = 31,			// S2C
+			PacketTypeHandShakeInit = 31,		// S2C
+			PacketTypeHandShakeReturn = 32,		// C2S
+			PacketTypeVersionGet = 33,			// S2C
+			PacketTypeVersionSend = 34,			// C2S
+			PacketTypeExtensionInfo = 60,
+			PacketTypePlayerProperties = 64,
+		};
+
+		/** Converts a string to the encoding used on the wire (CP437 or UTF-8). */
+		std::string EncodeString(std::string);
+		std::string DecodeString(std::string);
+
+		/**
+		 * Reads the fields of a received packet.
+		 *
+		 * The reader doesn't copy the packet. It either owns the `ENetPacket` it was constructed
+		 * with, or borrows a buffer that must outlive it.
+		 */
+		class NetPacketReader {
+			ENetPacket* packet;
+			const char* data;
+			std::size_t size;
+			std::size_t pos;
+
+		public:
+			/** Takes the ownership of `packet`. */
+			explicit NetPacketReader(ENetPacket* packet);
+			/** Reads a packet stored in `bytes`, which must outlive the reader. */
+			NetPacketReader(const char* bytes, std::size_t numBytes);
+			NetPacketReader(NetPacketReader&&);
+			~NetPacketReader();
+
+			NetPacketReader(const NetPacketReader&) = delete;
+			void operator=(const NetPacketReader&) = delete;
+			NetPacketReader& operator=(NetPacketReader&&);
+
+			/**
+			 * Returns a reader of the same packet that owns the packet data, so the packet can
+			 * be processed later. Moves the owned `ENetPacket` if there is one, and copies a
+			 * borrowed buffer otherwise. This reader must not be used afterwards.
+			 */
+			NetPacketReader Detach();
+
+			unsigned int GetTypeRaw() { return static_cast<unsigned int>(data[0]); }
+			PacketType GetType() { return static_cast<PacketType>(GetTypeRaw()); }
+
+			uint32_t ReadInt() {
+				SPADES_MARK_FUNCTION_DEBUG();
+
+				uint32_t value = 0;
+				if (pos + 4 > size)
+					SPRaise("Received packet truncated");
+
+				value |= ((uint32_t)(uint8_t)data[pos++]);
+				value |= ((uint32_t)(uint8_t)data[pos++]) << 8;
+				value |= ((uint32_t)(uint8_t)data[pos++]) << 16;
+				value |= ((uint32_t)(uint8_t)data[pos++]) << 24;
+				return value;
+			}
+
+			uint16_t ReadShort() {
+				SPADES_MARK_FUNCTION_DEBUG();
+
+				uint32_t value = 0;
+				if (pos + 2 > size)
+					SPRaise("Received packet truncated");
+
+				value |= ((uint32_t)(uint8_t)data[pos++]);
+				value |= ((uint32_t)(uint8_t)data[pos++]) << 8;
+				return (uint16_t)value;
+			}
+
+			uint8_t ReadByte() {
+				SPADES_MARK_FUNCTION_DEBUG();
+
+				if (pos >= size)
+					SPRaise("Received packet truncated");
+
+				return (uint8_t)data[pos++];
+			}
+
+			float ReadFloat() {
+				SPADES_MARK_FUNCTION_DEBUG();
+				union {
+					float f;
+					uint32_t v;
+				};
+				v = ReadInt();
+				return f;
+			}
+
+			IntVector3 ReadIntColor() {
+				SPADES_MARK_FUNCTION_DEBUG();
+				IntVector3 col;
+				col.z = ReadByte(); // B
+				col.y = ReadByte(); // G
+				col.x = ReadByte(); // R
+				return col;
+			}
+			IntVector3 ReadIntVector3() {
+				SPADES_MARK_FUNCTION_DEBUG();
+				IntVector3 v;
+				v.x = ReadInt();
+				v.y = ReadInt();
+				v.z = ReadInt();
+				return v;
+			}
+			Vector3 ReadVector3() {
+				SPADES_MARK_FUNCTION_DEBUG();
+				Vector3 v;
+				v.x = ReadFloat();
+				v.y = ReadFloat();
+				v.z = ReadFloat();
+				return v;
+			}
+
+			std::size_t GetPosition() { return size; }
+			std::size_t GetNumRemainingBytes() { return size - pos; }
+
+			/**
+			 * Returns the unread part of the packet without copying or consuming it. Valid
+			 * while the reader is alive.
+			 */
+			const char* PeekRemainingData() { return data + pos; }
+
+			std::string ReadData(size_t siz) {
+				if (pos + siz > size)
+					SPRaise("Received packet truncated");
+
+				std::string s = std::string(data + pos, siz);
+				pos += siz;
+				return s;
+			}
+			std::string ReadRemainingData() { return std::string(data + pos, size - pos); }
+
+			std::string ReadString(size_t siz) {
+				SPADES_MARK_FUNCTION_DEBUG();
+				// convert to C string once so that null-chars are removed
+				return DecodeString(ReadData(siz).c_str());
+			}
+			std::string ReadRemainingString() {
+				SPADES_MARK_FUNCTION_DEBUG();
+				// convert to C string once so that null-chars are removed
+				return DecodeString(ReadRemainingData().c_str());
+			}
+
+			void DumpDebug();
+		};
+
+		/**
+		 * Serializes a packet to be sent.
+		 *
+		 * The packet is built in a buffer taken from a pool, which `CreatePacket` hands to ENet
+		 * as it is. The buffer returns to the pool when ENet destroys the packet.
+		 */
+		class NetPacketWriter {
+			std::unique_ptr<std::vector<char>> data;
+
+		public:
+			NetPacketWriter(PacketType type);
+			NetPacketWriter(NetPacketWriter&&) = default;
+			~NetPacketWriter();
+
+			void WriteByte(uint8_t v) {
+				SPADES_MARK_FUNCTION_DEBUG();
+				data->push_back(v);
+			}
+			void WriteShort(uint16_t v) {
+				SPADES_MARK_FUNCTION_DEBUG();
+				data->push_back((char)(v));
+				data->push_back((char)(v >> 8));
+			}
+			void WriteInt(uint32_t v) {
+				SPADES_MARK_FUNCTION_DEBUG();
+				data->push_back((char)(v));
+				data->push_back((char)(v >> 8));
+				data->push_back((char)(v >> 16));
+				data->push_back((char)(v >> 24));
+			}
+			void WriteFloat(float v) {
+				SPADES_MARK_FUNCTION_DEBUG();
+				union {
+					float f;
+					uint32_t i;
+				};
+				f = v;
+				WriteInt(i);
+			}
+
+			void WriteColor(IntVector3 v) {
+				WriteByte((uint8_t)v.z); // B
+				WriteByte((uint8_t)v.y); // G
+				WriteByte((uint8_t)v.x); // R
+			}
+			void WriteIntVector3(IntVector3 v) {
+				WriteInt((uint32_t)v.x);
+				WriteInt((uint32_t)v.y);
+				WriteInt((uint32_t)v.z);
+			}
+			void WriteVector3(const Vector3& v) {
+				WriteFloat(v.x);
+				WriteFloat(v.y);
+				WriteFloat(v.z);
+			}
+
+			void WriteString(std::string str);
+			void WriteString(const std::string& str, size_t fillLen);
+
+			std::size_t GetPosition() { return data->size(); }
+
+			void Update(std::size_t position, std::uint8_t newValue) {
+				SPADES_MARK_FUNCTION_DEBUG();
+
+				if (position >= data->size()) {
+					SPRaise("Invalid write (%d should be less than %d)",
+						(int)position, (int)data->size());
+				}
+
+				(*data)[position] = static_cast<char>(newValue);
+			}
+
+			void Update(std::size_t position, std::uint32_t newValue) {
+				SPADES_MARK_FUNCTION_DEBUG();
+
+				if (position + 4 > data->size()) {
+					SPRaise("Invalid write (%d should be less than or equal to %d)",
+					        (int)(position + 4), (int)data->size());
+				}
+
+				// Assuming the target platform is little endian and supports
+				// unaligned memory access...
+				*reinterpret_cast<std::uint32_t*>(data->data() + position) = newValue;
+			}
+
+			/**
+			 * Creates an `ENetPacket` that refers to the serialized data without copying it.
+			 * The writer is empty afterwards and must not be used again.
+			 *
+			 * @param flags `ENetPacketFlag`. `ENET_PACKET_FLAG_RELIABLE` if omitted.
+			 */
+			ENetPacket* CreatePacket();
+			ENetPacket* CreatePacket(int flags);
+		};
+	} // namespace client
+} // namespace spades
@@ -0,0 +1,325 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "GameMap.h"
+#include "IImage.h"
+#include "IRenderer.h"
+#include "ParticleSystem.h"
+#include <Core/Debug.h>
+
+namespace spades {
+	namespace client {
+		ParticleSystem::SpritePool::SpritePool(std::size_t capacity)
+		    : posX(capacity),
+		      posY(capacity),
+		      posZ(capacity),
+		      velX(capacity),
+		      velY(capacity),
+		      velZ(capacity),
+		      radius(capacity),
+		      radiusVelocity(capacity),
+		      angle(capacity),
+		      rotationVelocity(capacity),
+		      velocityDamp(capacity),
+		      radiusDamp(capacity),
+		      gravityScale(capacity),
+		      time(capacity),
+		      lifetime(capacity),
+		      fadeInDuration(capacity),
+		      fadeOutDuration(capacity),
+		      color(capacity),
+		      blockHitAction(capacity),
+		      additive(capacity),
+		      image(capacity),
+		      lastPosX(capacity),
+		      lastPosY(capacity),
+		      lastPosZ(capacity),
+		      collision(capacity) {}
+
+		void ParticleSystem::SpritePool::Add(const ParticleSprite& p, uint16_t imageIndex) {
+			SPAssert(count < GetCapacity());
+			std::size_t i = count++;
+			posX[i] = p.position.x;
+			posY[i] = p.position.y;
+			posZ[i] = p.position.z;
+			velX[i] = p.velocity.x;
+			velY[i] = p.velocity.y;
+			velZ[i] = p.velocity.z;
+			radius[i] = p.radius;
+			radiusVelocity[i] = p.radiusVelocity;
+			angle[i] = p.angle;
+			rotationVelocity[i] = p.rotationVelocity;
+			velocityDamp[i] = p.velocityDamp;
+			radiusDamp[i] = p.radiusDamp;
+			gravityScale[i] = p.gravityScale;
+			time[i] = 0.0F;
+			lifetime[i] = p.lifetime;
+			fadeInDuration[i] = p.fadeInDuration;
+			fadeOutDuration[i] = p.fadeOutDuration;
+			color[i] = p.color;
+			blockHitAction[i] = p.blockHitAction;
+			additive[i] = p.additive;
+			image[i] = imageIndex;
+		}
+
+		void ParticleSystem::SpritePool::Advance(float dt, GameMap* map) {
+			for (std::size_t i = 0; i < count; i++) {
+				time[i] += dt;
+
+				lastPosX[i] = posX[i];
+				lastPosY[i] = posY[i];
+				lastPosZ[i] = posZ[i];
+
+				posX[i] += velX[i] * dt;
+				posY[i] += velY[i] * dt;
+				posZ[i] += velZ[i] * dt;
+				velZ[i] += 32.0F * dt * gravityScale[i];
+			}
+
+			if (map) {
+				const float* lastPos[] = {lastPosX.data(), lastPosY.data(), lastPosZ.data()};
+				const float* pos[] = {posX.data(), posY.data(), posZ.data()};
+				CollideWithMap(*map, count, lastPos, pos, collision.data());
+			} else {
+				std::fill(collision.begin(), collision.begin() + count, MapCollision::None);
+			}
+		}
+
+		bool ParticleSystem::SpritePool::Resolve(std::size_t i, float dt) {
+			if (time[i] > lifetime[i])
+				return false;
+
+			Vector3 velocity{velX[i], velY[i], velZ[i]};
+
+			if (blockHitAction[i] != BlockHitAction::Ignore &&
+			    collision[i] != MapCollision::None) {
+				if (blockHitAction[i] == BlockHitAction::Delete)
+					return false;
+
+				ReflectVelocity(collision[i], velocity);
+
+				// set back to old position
+				posX[i] = lastPosX[i];
+				posY[i] = lastPosY[i];
+				posZ[i] = lastPosZ[i];
+				velocity *= 0.46F; // lose some velocity due to friction
+				radius[i] *= 0.75F;
+			}
+
+			// radius
+			if (radiusVelocity[i] != 0.0F)
+				radius[i] += radiusVelocity[i] * dt;
+			if (rotationVelocity[i] != 0.0F)
+				angle[i] += rotationVelocity[i] * dt;
+			if (velocityDamp[i] != 1.0F)
+				velocity *= powf(velocityDamp[i], dt);
+			if (radiusDamp[i] != 1.0F)
+				radiusVelocity[i] *= powf(radiusDamp[i], dt);
+
+			velX[i] = velocity.x;
+			velY[i] = velocity.y;
+			velZ[i] = velocity.z;
+			return true;
+		}
+
+		void ParticleSystem::SpritePool::Move(std::size_t from, std::size_t to) {
+			posX[to] = posX[from];
+			posY[to] = posY[from];
+			posZ[to] = posZ[from];
+			velX[to] = velX[from];
+			velY[to] = velY[from];
+			velZ[to] = velZ[from];
+			radius[to] = radius[from];
+			radiusVelocity[to] = radiusVelocity[from];
+			angle[to] = angle[from];
+			rotationVelocity[to] = rotationVelocity[from];
+			velocityDamp[to] = velocityDamp[from];
+			radiusDamp[to] = radiusDamp[from];
+			gravityScale[to] = gravityScale[from];
+			time[to] = time[from];
+			lifetime[to] = lifetime[from];
+			fadeInDuration[to] = fadeInDuration[from];
+			fadeOutDuration[to] = fadeOutDuration[from];
+			color[to] = color[from];
+			blockHitAction[to] = blockHitAction[from];
+			additive[to] = additive[from];
+			image[to] = image[from];
+		}
+
+		Vector4 ParticleSystem::SpritePool::GetColor(std::size_t i) const {
+			float fade = 1.0F;
+			if (time[i] < fadeInDuration[i])
+				fade *= time[i] / fadeInDuration[i];
+			if (time[i] > lifetime[i] - fadeOutDuration[i])
+				fade *= (lifetime[i] - time[i]) / fadeOutDuration[i];
+
+			Vector4 col = color[i];
+			col.w *= fade;
+
+			// premultiplied alpha!
+			col.x *= col.w;
+			col.y *= col.w;
+			col.z *= col.w;
+
+			if (additive[i])
+				col.w = 0.0F;
+
+			return col;
+		}
+
+		ParticleSystem::SmokePool::SmokePool(std::size_t capacity)
+		    : SpritePool(capacity), frame(capacity), fps(capacity), type(capacity) {}
+
+		void ParticleSystem::SmokePool::Add(const SmokeSprite& p) {
+			std::size_t i = count;
+			SpritePool::Add(p, 0);
+			frame[i] = 0.0F;
+			fps[i] = p.fps;
+			type[i] = p.type;
+		}
+
+		void ParticleSystem::SmokePool::Move(std::size_t from, std::size_t to) {
+			SpritePool::Move(from, to);
+			frame[to] = frame[from];
+			fps[to] = fps[from];
+			type[to] = type[from];
+		}
+
+		ParticleSystem::ParticleSystem() : sprites(MaxSprites), smokes(MaxSmokes) {}
+
+		ParticleSystem::~ParticleSystem() {}
+
+		void ParticleSystem::AddSprite(const ParticleSprite& p) {
+			if (sprites.count == sprites.GetCapacity())
+				return;
+
+			SPAssert(p.image);
+
+			std::size_t imageIndex = 0;
+			while (imageIndex < images.size() && images[imageIndex].GetPointerOrNull() != p.image)
+				imageIndex++;
+			if (imageIndex == images.size()) {
+				// Only a few distinct images are used, so this rarely allocates
+				SPAssert(imageIndex <= UINT16_MAX);
+				images.push_back(Handle<IImage>{p.image});
+			}
+
+			sprites.Add(p, static_cast<uint16_t>(imageIndex));
+		}
+
+		void ParticleSystem::AddSmoke(const SmokeSprite& p) {
+			if (smokes.count == smokes.GetCapacity())
+				return;
+
+			smokes.Add(p);
+		}
+
+		void ParticleSystem::Clear() {
+			sprites.count = 0;
+			smokes.count = 0;
+			images.clear();
+		}
+
+		void ParticleSystem::Update(float dt, GameMap* map) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			sprites.Advance(dt, map);
+
+			std::size_t numAlive = 0;
+			for (std::size_t i = 0; i < sprites.count; i++) {
+				if (!sprites.Resolve(i, dt))
+					continue;
+				if (i != numAlive)
+					sprites.Move(i, numAlive);
+				numAlive++;
+			}
+			sprites.count = numAlive;
+
+			smokes.Advance(dt, map);
+
+			numAlive = 0;
+			for (std::size_t i = 0; i < smokes.count; i++) {
+				float& frame = smokes.frame[i];
+				frame += dt * smokes.fps[i];
+				if (smokes.type[i] == SmokeSprite::Type::Steady) {
+					frame = fmodf(frame, (float)NumSteadySmokeFrames);
+				} else if (frame > (float)(NumExplosionSmokeFrames - 1)) {
+					continue;
+				}
+
+				if (!smokes.Resolve(i, dt))
+					continue;
+				if (i != numAlive)
+					smokes.Move(i, numAlive);
+				numAlive++;
+			}
+			smokes.count = numAlive;
+		}
+
+		void ParticleSystem::Preload(IRenderer& r) {
+			if (smokeImagesRenderer == &r)
+				return;
+
+			for (int i = 0; i < NumSteadySmokeFrames; i++) {
+				char buf[256];
+				sprintf(buf, "Textures/Smoke1/%03d.png", i);
+				steadySmokeImages[i] = r.RegisterImage(buf);
+			}
+			for (int i = 0; i < NumExplosionSmokeFrames; i++) {
+				char buf[256];
+				sprintf(buf, "Textures/Smoke2/%03d.png", i);
+				explosionSmokeImages[i] = r.RegisterImage(buf);
+			}
+
+			smokeImagesRenderer = &r;
+		}
+
+		void ParticleSystem::Render3D(IRenderer& r) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			for (std::size_t i = 0; i < sprites.count; i++) {
+				r.SetColorAlphaPremultiplied(sprites.GetColor(i));
+				r.AddSprite(*images[sprites.image[i]],
+				            MakeVector3(sprites.posX[i], sprites.posY[i], sprites.posZ[i]),
+				            sprites.radius[i], sprites.angle[i]);
+			}
+
+			if (smokes.count == 0)
+				return;
+
+			Preload(r);
+
+			for (std::size_t i = 0; i < smokes.count; i++) {
+				int frame = (int)floorf(smokes.frame[i]);
+				IImage& image = smokes.type[i] == SmokeSprite::Type::Steady
+				                  ? *steadySmokeImages[frame]
+				                  : *explosionSmokeImages[frame];
+
+				r.SetColorAlphaPremultiplied(smokes.GetColor(i));
+				r.AddSprite(image, MakeVector3(smokes.posX[i], smokes.posY[i], smokes.posZ[i]),
+				            smokes.radius[i], smokes.angle[i]);
+			}
+		}
+	} // namespace client
+} // namespace spades
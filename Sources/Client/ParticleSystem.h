@@ -0,0 +1,206 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "MapCollision.h"
+#include <Core/Math.h>
+#include <Core/RefCountedObject.h>
+
+namespace spades {
+	namespace client {
+		class GameMap;
+		class IImage;
+		class IRenderer;
+
+		enum class BlockHitAction { Delete, Ignore, BounceWeak };
+
+		/** The initial state of a sprite particle. See `ParticleSystem::AddSprite`. */
+		struct ParticleSprite {
+			IImage* image;
+			Vector4 color;
+			bool additive = false;
+			BlockHitAction blockHitAction = BlockHitAction::Delete;
+
+			Vector3 position = MakeVector3(0, 0, 0);
+			Vector3 velocity = MakeVector3(0, 0, 0); // unit/sec
+			float radius = 1.0F, radiusVelocity = 0.0F;  // unit/sec
+			float angle = 0.0F, rotationVelocity = 0.0F; // radian/sec
+
+			float velocityDamp = 1.0F;
+			float radiusDamp = 1.0F;
+			float gravityScale = 1.0F;
+
+			float lifetime = 1.0F;
+			float fadeInDuration = 0.1F;
+			float fadeOutDuration = 0.5F;
+
+			ParticleSprite(IImage& img, Vector4 col) : image(&img), color(col) {}
+
+			void SetAdditive(bool b) { additive = b; }
+			void SetLifeTime(float lifeTime, float fadeIn, float fadeOut) {
+				lifetime = lifeTime;
+				fadeInDuration = fadeIn;
+				fadeOutDuration = fadeOut;
+			}
+			void SetTrajectory(Vector3 initialPos, Vector3 initialVel, float velDamp = 1.0F,
+			                   float gravScale = 1.0F) {
+				position = initialPos;
+				velocity = initialVel;
+				velocityDamp = velDamp;
+				gravityScale = gravScale;
+			}
+			void SetRotation(float initialAng, float angleVel = 0.0F) {
+				angle = initialAng;
+				rotationVelocity = angleVel;
+			}
+			void SetRadius(float initialRad, float radiusVel = 0.0F, float radDamp = 1.0F) {
+				radius = initialRad;
+				radiusVelocity = radiusVel;
+				radiusDamp = radDamp;
+			}
+			void SetBlockHitAction(BlockHitAction act) { blockHitAction = act; }
+
+		protected:
+			ParticleSprite(Vector4 col) : image(nullptr), color(col) {}
+		};
+
+		/**
+		 * The initial state of a smoke particle, which is a sprite particle showing an animated
+		 * smoke texture. See `ParticleSystem::AddSmoke`.
+		 */
+		struct SmokeSprite : ParticleSprite {
+			enum class Type { Steady, Explosion };
+
+			float fps;
+			Type type;
+
+			SmokeSprite(Vector4 col, float fps, Type type = Type::Steady)
+			    : ParticleSprite(col), fps(fps), type(type) {}
+		};
+
+		/**
+		 * Simulates and draws short-lived sprite particles (debris, smoke, splashes, etc.).
+		 *
+		 * Each kind of particle is stored in its own pool, which is a structure of arrays
+		 * allocated up front. A pool is updated by moving every particle, testing them against
+		 * the map in a single batch (see `CollideWithMap`), and then a loop resolving the
+		 * collisions and compacting the live particles in place (keeping the drawing order).
+		 * Adding a particle never allocates memory; it's dropped if the pool is full.
+		 */
+		class ParticleSystem {
+		public:
+			enum { MaxSprites = 16384, MaxSmokes = 4096 };
+
+			ParticleSystem();
+			~ParticleSystem();
+
+			void AddSprite(const ParticleSprite&);
+			void AddSmoke(const SmokeSprite&);
+
+			/** Removes all particles. */
+			void Clear();
+
+			/** Advances the simulation. `map` can be null. */
+			void Update(float dt, GameMap* map);
+
+			/** Registers the images used by smoke particles. */
+			void Preload(IRenderer&);
+
+			void Render3D(IRenderer&);
+
+			std::size_t GetNumSprites() const { return sprites.count; }
+			std::size_t GetNumSmokes() const { return smokes.count; }
+
+			/** Returns the position of the `i`-th sprite particle, in the order of addition. */
+			Vector3 GetSpritePosition(std::size_t i) const {
+				return MakeVector3(sprites.posX[i], sprites.posY[i], sprites.posZ[i]);
+			}
+
+		private:
+			enum { NumSteadySmokeFrames = 180, NumExplosionSmokeFrames = 48 };
+
+			struct SpritePool {
+				std::size_t count = 0;
+
+				std::vector<float> posX, posY, posZ;
+				std::vector<float> velX, velY, velZ;
+				std::vector<float> radius, radiusVelocity;
+				std::vector<float> angle, rotationVelocity;
+				std::vector<float> velocityDamp, radiusDamp, gravityScale;
+				std::vector<float> time, lifetime, fadeInDuration, fadeOutDuration;
+				std::vector<Vector4> color;
+				std::vector<BlockHitAction> blockHitAction;
+				std::vector<uint8_t> additive;
+				/** An index into `ParticleSystem::images`. Unused by smoke particles. */
+				std::vector<uint16_t> image;
+
+				// Scratch space for `Advance`
+				std::vector<float> lastPosX, lastPosY, lastPosZ;
+				std::vector<MapCollision> collision;
+
+				SpritePool(std::size_t capacity);
+
+				std::size_t GetCapacity() const { return posX.size(); }
+
+				/** Stores a new particle at `count`. */
+				void Add(const ParticleSprite&, uint16_t imageIndex);
+
+				/** Moves all particles and tests them against the map. `map` can be null. */
+				void Advance(float dt, GameMap* map);
+
+				/**
+				 * Finishes advancing a particle after `Advance`. Returns `false` if it should be
+				 * removed.
+				 */
+				bool Resolve(std::size_t i, float dt);
+
+				void Move(std::size_t from, std::size_t to);
+
+				/** Returns the premultiplied color of a particle. */
+				Vector4 GetColor(std::size_t i) const;
+			};
+
+			struct SmokePool : SpritePool {
+				std::vector<float> frame, fps;
+				std::vector<SmokeSprite::Type> type;
+
+				SmokePool(std::size_t capacity);
+
+				void Add(const SmokeSprite&);
+				void Move(std::size_t from, std::size_t to);
+			};
+
+			SpritePool sprites;
+			SmokePool smokes;
+
+			/** The images used by `sprites`. */
+			std::vector<Handle<IImage>> images;
+
+			IRenderer* smokeImagesRenderer = nullptr;
+			std::array<Handle<IImage>, NumSteadySmokeFrames> steadySmokeImages;
+			std::array<Handle<IImage>, NumExplosionSmokeFrames> explosionSmokeImages;
+		};
+	} // namespace client
+} // namespace spades
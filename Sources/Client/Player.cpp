@@ -24,8 +24,10 @@
 #include "GameMap.h"
 #include "GameMapWrapper.h"
 #include "Grenade.h"
+#include "HitScanIndex.h"
 #include "HitTestDebugger.h"
 #include "IWorldListener.h"
+#include "MapCollision.h"
 #include "PhysicsConstants.h"
 #include "Weapon.h"
 #include "World.h"
@@ -227,9 +229,8 @@ namespace spades {
 				}
 			} else if (tool == ToolWeapon && isLocal) {
 				weapon->SetShooting(newInput.primary);
-			} else {
-				SPAssert(false);
 			}
+			// The weapon and grenade inputs of remote players are applied by `Update`
 
 			weapInput = newInput;
 		}
@@ -311,6 +312,7 @@ namespace spades {
 			SPADES_MARK_FUNCTION();
 
 			position = eye = v;
+			world.PlayerMoved(*this);
 		}
 
 		void Player::SetVelocity(const spades::Vector3& v) {
@@ -369,6 +371,7 @@ namespace spades {
 			const float secondaryDelay = GetToolSecondaryDelay(tool);
 
 			MovePlayer(dt);
+			world.PlayerMoved(*this);
 
 			if (tool == ToolSpade) {
 				if (weapInput.primary) {
@@ -576,25 +579,42 @@ namespace spades {
 				HitBodyPart hitPart = HitBodyPart::None;
 				hitTag_t hitFlag = hit_None;
 
-				for (size_t i = 0; i < world.GetNumPlayerSlots(); i++) {
-					// TODO: This is a repeated pattern, add something like
-					// `World::GetExistingPlayerRange()` returning a range
+				HitScanIndex::PlayerSet candidates;
+				world.GetHitScanIndex().QueryRay(muzzle, dir, candidates);
+
+				hitBoxBatch.Clear();
+				hitBoxOwners.clear();
+				candidates.ForEach([&](int i) {
 					auto maybeOther = world.GetPlayer(static_cast<unsigned int>(i));
 					if (maybeOther == this || !maybeOther)
-						continue;
+						return;
 
 					Player& other = maybeOther.value();
 					if (!other.IsAlive() || other.IsSpectator())
-						continue; // filter deads/spectators
+						return; // filter deads/spectators
 					if (other.RayCastApprox(muzzle, dir)) {
 						nearPlayer = true;
 					} else {
-						continue; // quickly reject players unlikely to be hit
+						return; // quickly reject players unlikely to be hit
 					}
 
+					hitBoxBatch.Append(other.GetHitBoxBatch(interp)); // interpolated
+					hitBoxOwners.push_back(&other);
+				});
+
+				hitBoxResults.resize(hitBoxBatch.GetCount());
+				hitBoxBatch.RayCast(muzzle, dir, hitBoxResults.data());
+
+				for (std::size_t k = 0; k < hitBoxOwners.size(); k++) {
+					Player& other = *hitBoxOwners[k];
+					auto rayCast = [&](int box, Vector3* hitPos) {
+						const auto& result = hitBoxResults[k * HitBoxBatchSize + box];
+						*hitPos = result.hitPos;
+						return result.hit;
+					};
+
 					Vector3 hitPos;
-					HitBoxes hb = other.GetHitBoxes(interp); // interpolated
-					if (hb.head.RayCast(muzzle, dir, &hitPos)) {
+					if (rayCast(HitBoxBatchHead, &hitPos)) {
 						float const dist = (hitPos - muzzle).GetLength2D();
 						if (!hitPlayer || dist < hitPlayerDist2D || hitPart == HitBodyPart::Arms) {
 							if (hitPlayer != other) {
@@ -609,7 +629,7 @@ namespace spades {
 						}
 					}
 
-					if (hb.torso.RayCast(muzzle, dir, &hitPos)) {
+					if (rayCast(HitBoxBatchTorso, &hitPos)) {
 						float const dist = (hitPos - muzzle).GetLength2D();
 						if (!hitPlayer || dist < hitPlayerDist2D || hitPart == HitBodyPart::Arms) {
 							if (hitPlayer != other) {
@@ -625,7 +645,7 @@ namespace spades {
 					}
 
 					for (int j = 0; j < 2; j++) {
-						if (hb.limbs[j].RayCast(muzzle, dir, &hitPos)) {
+						if (rayCast(HitBoxBatchLimbs + j, &hitPos)) {
 							float const dist = (hitPos - muzzle).GetLength2D();
 							if (!hitPlayer || dist < hitPlayerDist2D) {
 								if (hitPlayer != other) {
@@ -648,7 +668,7 @@ namespace spades {
 					if (hitPart == HitBodyPart::Head || hitPart == HitBodyPart::Torso)
 						continue;
 
-					if (hb.limbs[2].RayCast(muzzle, dir, &hitPos)) {
+					if (rayCast(HitBoxBatchLimbs + 2, &hitPos)) {
 						float const dist = (hitPos - muzzle).GetLength2D();
 						if (!hitPlayer || dist < hitPlayerDist2D) {
 							if (hitPlayer != other) {
@@ -838,23 +858,28 @@ namespace spades {
 			stmp::optional<Player&> hitPlayer;
 
 			if (!dig) {
-				for (size_t i = 0; i < world.GetNumPlayerSlots(); i++) {
+				HitScanIndex::PlayerSet candidates;
+				world.GetHitScanIndex().QueryRay(muzzle, dir, candidates);
+
+				candidates.ForEach([&](int i) {
+					if (hitPlayer)
+						return;
+
 					auto maybeOther = world.GetPlayer(static_cast<unsigned int>(i));
 					if (maybeOther == this || !maybeOther)
-						continue;
+						return;
 
 					Player& other = maybeOther.value();
 					if (!other.IsAlive() || other.IsSpectator())
-						continue; // filter deads/spectators
+						return; // filter deads/spectators
 					if ((other.GetEye() - muzzle).GetSquaredLength() >
 					    (MELEE_DISTANCE * MELEE_DISTANCE))
-						continue; // skip players outside attack range
+						return; // skip players outside attack range
 					if (!other.RayCastApprox(muzzle, dir))
-						continue; // quickly reject players unlikely to be hit
+						return; // quickly reject players unlikely to be hit
 
 					hitPlayer = other;
-					break;
-				}
+				});
 			}
 
 			IntVector3 outBlockPos = mapResult.hitBlock;
@@ -1066,19 +1091,9 @@ namespace spades {
 			SPAssert(map);
 
 			// Collision
-			IntVector3 lp = position.Floor();
-
-			if (map->ClipWorld(lp.x, lp.y, lp.z)) {
-				IntVector3 lp2 = oldPos.Floor();
-				if (lp.z != lp2.z && ((lp.x == lp2.x && lp.y == lp2.y)
-					|| !map->ClipWorld(lp.x, lp.y, lp2.z)))
-					velocity.z = -velocity.z;
-				else if (lp.x != lp2.x && ((lp.y == lp2.y && lp.z == lp2.z)
-					|| !map->ClipWorld(lp2.x, lp.y, lp.z)))
-					velocity.x = -velocity.x;
-				else if (lp.y != lp2.y && ((lp.x == lp2.x && lp.z == lp2.z)
-					|| !map->ClipWorld(lp.x, lp2.y, lp.z)))
-					velocity.y = -velocity.y;
+			MapCollision collision = CollideWithMap(*map, oldPos, position);
+			if (collision != MapCollision::None) {
+				ReflectVelocity(collision, velocity);
 
 				position = oldPos; // set back to old position
 				velocity *= 0.36F; // lose some velocity due to friction
@@ -1234,6 +1249,30 @@ namespace spades {
 				eye.z += (f + f2) / f2;
 		}
 
+		void Player::AddSnapshot(const PlayerSnapshot& snapshot) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			if (!snapshots.IsEmpty()) {
+				const PlayerSnapshot& newest = snapshots.GetNewest();
+				// Don't interpolate across a teleport or a long gap
+				if ((snapshot.position - newest.position).GetSquaredLength() > 20.0F * 20.0F ||
+				    snapshot.time - newest.time > 1.0F)
+					snapshots.Clear();
+			}
+			snapshots.Push(snapshot);
+		}
+
+		void Player::ApplySnapshots(float time, float maxExtrapolation) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			Vector3 pos, front;
+			if (!snapshots.Sample(time, maxExtrapolation, pos, front))
+				return;
+
+			RepositionPlayer(pos);
+			SetOrientation(front);
+		}
+
 		bool Player::IsReadyToUseTool() {
 			SPADES_MARK_FUNCTION_DEBUG();
 			switch (tool) {
@@ -1328,9 +1367,20 @@ namespace spades {
 		Player::HitBoxes Player::GetHitBoxes(bool interpolate) {
 			SPADES_MARK_FUNCTION_DEBUG();
 
-			Player::HitBoxes hb;
-
+			// Weapon ray casts ask for the same hitboxes many times per tick
 			Vector3 o = GetFront(interpolate);
+			Vector3 origin = GetOrigin();
+			HitBoxCache& cache = hitBoxCache[interpolate ? 1 : 0];
+			if (cache.valid && cache.front == o && cache.origin == origin &&
+			    cache.crouch == input.crouch && cache.sprint == input.sprint)
+				return cache.hitBoxes;
+
+			Player::HitBoxes& hb = cache.hitBoxes;
+			cache.valid = true;
+			cache.front = o;
+			cache.origin = origin;
+			cache.crouch = input.crouch;
+			cache.sprint = input.sprint;
 
 			float yaw = atan2f(o.y, o.x) + M_PI_F * 0.5F;
 			float pitch = -atan2f(o.z, o.GetLength2D());
@@ -1342,7 +1392,7 @@ namespace spades {
 				armPitch = std::max(armPitch, -M_PI_F * 0.5F) * 0.9F;
 
 			// lower axis
-			Matrix4 const lower = Matrix4::Translate(GetOrigin())
+			Matrix4 const lower = Matrix4::Translate(origin)
 				* Matrix4::Rotate(MakeVector3(0, 0, 1), yaw);
 			Matrix4 const torso = lower
 				* Matrix4::Translate(0, 0, -(input.crouch ? 0.5F : 1.0F));
@@ -1367,9 +1417,20 @@ namespace spades {
 				hb.head = head * AABB3(-0.3F, -0.3F, -0.6F, 0.6F, 0.6F, 0.6F);
 			}
 
+			cache.batch.Clear();
+			cache.batch.Add(hb.head);
+			cache.batch.Add(hb.torso);
+			for (const OBB3& limb : hb.limbs)
+				cache.batch.Add(limb);
+
 			return hb;
 		}
 
+		const OBB3Batch& Player::GetHitBoxBatch(bool interpolate) {
+			GetHitBoxes(interpolate);
+			return hitBoxCache[interpolate ? 1 : 0].batch;
+		}
+
 		Weapon& Player::GetWeapon() {
 			SPADES_MARK_FUNCTION();
 			SPAssert(weapon);
@@ -22,8 +22,10 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "PhysicsConstants.h"
+#include "PlayerSnapshotBuffer.h"
 #include <Core/Math.h>
 
 namespace spades {
@@ -75,6 +77,8 @@ namespace spades {
 			Vector3 orientation;
 			Vector3 orientationSmoothed;
 			Vector3 eye;
+			/** The poses received from the server, for remote players. */
+			PlayerSnapshotBuffer snapshots;
 			PlayerInput input;
 			WeaponInput weapInput;
 			bool airborne;
@@ -129,6 +133,21 @@ namespace spades {
 
 			float respawnTime;
 
+			struct HitBoxCache {
+				bool valid = false;
+				Vector3 front, origin;
+				bool crouch, sprint;
+				HitBoxes hitBoxes;
+				OBB3Batch batch;
+			};
+			/** Indexed by `interpolate` of `GetHitBoxes`. */
+			HitBoxCache hitBoxCache[2];
+
+			/** Scratch buffers of `FireWeapon`, kept to avoid allocations per shot. */
+			OBB3Batch hitBoxBatch;
+			std::vector<Player*> hitBoxOwners;
+			std::vector<OBB3Batch::RayCastResult> hitBoxResults;
+
 			void MoveCorpse(float fsynctics);
 			void MovePlayer(float fsynctics);
 			void BoxClipMove(float fsynctics);
@@ -195,6 +214,13 @@ namespace spades {
 			bool IsWalking() { return input.moveForward || input.moveBackward || input.moveLeft || input.moveRight; }
 
 			void RepositionPlayer(const Vector3&);
+			/** Records a pose received from the server. See `PlayerSnapshotBuffer`. */
+			void AddSnapshot(const PlayerSnapshot&);
+			/**
+			 * Moves the player to the pose at `time` computed from the snapshots. Does
+			 * nothing if there are none.
+			 */
+			void ApplySnapshots(float time, float maxExtrapolation);
 			void SetPosition(const Vector3&);
 			void SetOrientation(const Vector3&);
 			void SetVelocity(const Vector3&);
@@ -251,6 +277,17 @@ namespace spades {
 			// hit tests
 			HitBoxes GetHitBoxes(bool interpolate);
 
+			/** The order of the boxes in `GetHitBoxBatch`. */
+			enum {
+				HitBoxBatchHead = 0,
+				HitBoxBatchTorso,
+				HitBoxBatchLimbs, // 3 boxes
+				HitBoxBatchSize = HitBoxBatchLimbs + 3
+			};
+
+			/** Returns the boxes of `GetHitBoxes` as a batch for `OBB3Batch::RayCast`. */
+			const OBB3Batch& GetHitBoxBatch(bool interpolate);
+
 			/** Does approximated ray casting.
 			 * @param dir normalized direction vector.
 			 * @return true if ray may hit the player. */
@@ -0,0 +1,111 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+
+#include "PlayerSnapshotBuffer.h"
+
+namespace spades {
+	namespace client {
+		void PlayerSnapshotBuffer::Push(const PlayerSnapshot& snapshot) {
+			PlayerSnapshot entry = snapshot;
+			if (count > 0)
+				entry.time = std::max(entry.time, GetNewest().time);
+
+			if (count == Capacity) {
+				first = (first + 1) % Capacity;
+				count--;
+			}
+			entries[(first + count) % Capacity] = entry;
+			count++;
+		}
+
+		bool PlayerSnapshotBuffer::Sample(float time, float maxExtrapolation,
+		                                  Vector3& outPosition, Vector3& outOrientation) const {
+			if (count == 0)
+				return false;
+
+			const PlayerSnapshot& oldest = Get(0);
+			if (time <= oldest.time) {
+				outPosition = oldest.position;
+				outOrientation = oldest.orientation;
+				return true;
+			}
+
+			const PlayerSnapshot& newest = GetNewest();
+			if (time >= newest.time) {
+				outPosition = newest.position;
+				outOrientation = newest.orientation;
+				if (count >= 2) {
+					const PlayerSnapshot& previous = Get(count - 2);
+					float interval = newest.time - previous.time;
+					if (interval > 0.0F) {
+						float extrapolation = std::min(time - newest.time, maxExtrapolation);
+						outPosition += (newest.position - previous.position) *
+						               (extrapolation / interval);
+					}
+				}
+				return true;
+			}
+
+			// `oldest.time < time < newest.time`; the recent ones are more likely
+			unsigned int i = count - 1;
+			while (Get(i - 1).time > time)
+				i--;
+
+			const PlayerSnapshot& a = Get(i - 1);
+			const PlayerSnapshot& b = Get(i);
+			float frac = (time - a.time) / (b.time - a.time);
+			outPosition = Mix(a.position, b.position, frac);
+			outOrientation = Mix(a.orientation, b.orientation, frac);
+			if (outOrientation.GetSquaredLength() > 1.0e-8F)
+				outOrientation = outOrientation.Normalize() * Mix(a.orientation.GetLength(),
+				                                                  b.orientation.GetLength(), frac);
+			return true;
+		}
+
+		float SnapshotClock::Stamp(float arrivalTime) {
+			float elapsed = arrivalTime - lastArrivalTime;
+			if (!valid || elapsed < 0.0F || elapsed > 1.0F) {
+				// A new world, or a stall long enough for the players to be reset anyway
+				valid = true;
+				numIntervals = -1;
+				lastArrivalTime = lastStamp = arrivalTime;
+				return arrivalTime;
+			}
+			lastArrivalTime = arrivalTime;
+
+			// The first snapshot may have been sent in the middle of the server's period
+			if (++numIntervals == 0) {
+				lastStamp = arrivalTime;
+				return arrivalTime;
+			}
+			interval = Mix(interval, elapsed, std::max(1.0F / (float)numIntervals, 0.1F));
+
+			// Never ahead of the arrival, but drift toward it slowly so that an increase of
+			// the latency is followed
+			float stamp = std::min(lastStamp + interval, arrivalTime);
+			stamp = Mix(stamp, arrivalTime, 0.05F);
+
+			lastStamp = stamp;
+			return stamp;
+		}
+	} // namespace client
+} // namespace spades
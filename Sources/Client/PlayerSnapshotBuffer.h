@@ -0,0 +1,98 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <array>
+
+#include <Core/Math.h>
+
+namespace spades {
+	namespace client {
+		/** A pose of a remote player received with `WorldUpdate`. */
+		struct PlayerSnapshot {
+			/** `World::GetSmoothTime` when the snapshot was received. */
+			float time;
+			Vector3 position;
+			Vector3 orientation;
+		};
+
+		/**
+		 * The latest snapshots of a remote player. The player is displayed a little in the
+		 * past by interpolating between them, so it moves smoothly even if the server sends
+		 * only 10-20 updates per second. If the snapshots stop arriving, the last movement is
+		 * extrapolated for a limited time.
+		 *
+		 * The snapshots are stored in a fixed-size ring buffer. The oldest one is dropped
+		 * when a new one arrives while the buffer is full.
+		 */
+		class PlayerSnapshotBuffer {
+		public:
+			enum { Capacity = 16 };
+
+			void Clear() { count = 0; }
+			bool IsEmpty() const { return count == 0; }
+			unsigned int GetCount() const { return count; }
+
+			/** `i = 0` is the oldest one. */
+			const PlayerSnapshot& Get(unsigned int i) const {
+				return entries[(first + i) % Capacity];
+			}
+			const PlayerSnapshot& GetNewest() const { return Get(count - 1); }
+
+			/** Adds a snapshot. Its time must not precede the newest one's. */
+			void Push(const PlayerSnapshot&);
+
+			/**
+			 * Computes the pose at `time`. Clamps to the oldest snapshot, and extrapolates the
+			 * velocity between the two newest snapshots for up to `maxExtrapolation` seconds
+			 * past the newest one.
+			 *
+			 * @return `false` if the buffer is empty.
+			 */
+			bool Sample(float time, float maxExtrapolation, Vector3& outPosition,
+			            Vector3& outOrientation) const;
+
+		private:
+			std::array<PlayerSnapshot, Capacity> entries;
+			unsigned int first = 0;
+			unsigned int count = 0;
+		};
+
+		/**
+		 * Computes the times to stamp periodic snapshots with. The arrival times are
+		 * disturbed by the network jitter, which would make the interpolated movement uneven.
+		 * This assumes the snapshots are sent at a steady rate and follows the least delayed
+		 * ones instead.
+		 */
+		class SnapshotClock {
+		public:
+			float Stamp(float arrivalTime);
+
+		private:
+			bool valid = false;
+			float lastArrivalTime = 0.0F;
+			float lastStamp = 0.0F;
+			/** The mean interval of the snapshots, estimated from `numIntervals` ones. */
+			float interval = 0.0F;
+			int numIntervals = 0;
+		};
+	} // namespace client
+} // namespace spades
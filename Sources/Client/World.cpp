@@ -19,6 +19,7 @@
 
  */
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <deque>
@@ -27,6 +28,7 @@
 #include "GameMapWrapper.h"
 #include "GameProperties.h"
 #include "Grenade.h"
+#include "HitScanIndex.h"
 #include "HitTestDebugger.h"
 #include "IGameMode.h"
 #include "IWorldListener.h"
@@ -37,8 +39,13 @@
 #include <Core/FileManager.h>
 #include <Core/IStream.h>
 #include <Core/Settings.h>
+#include <Core/TraceProfiler.h>
 
 DEFINE_SPADES_SETTING(cg_debugHitTest, "0");
+DEFINE_SPADES_SETTING(cg_floatingBlockTimeBudget, "4");
+// How far in the past remote players are displayed, in seconds. 0 disables the interpolation.
+DEFINE_SPADES_SETTING(cg_interpolationDelay, "0.1");
+DEFINE_SPADES_SETTING(cg_maxExtrapolation, "0.1");
 
 SPADES_SETTING(cg_orientationSmoothing);
 
@@ -46,7 +53,7 @@ namespace spades {
 	namespace client {
 
 		World::World(const std::shared_ptr<GameProperties>& gameProperties)
-		    : gameProperties{gameProperties} {
+		    : gameProperties{gameProperties}, hitScanIndex{stmp::make_unique<HitScanIndex>()} {
 			SPADES_MARK_FUNCTION();
 		}
 		World::~World() { SPADES_MARK_FUNCTION(); }
@@ -61,6 +68,9 @@ namespace spades {
 		}
 
 		void World::UpdatePlayer(float dt, bool locked) {
+			if (!locked)
+				smoothTime += dt;
+
 			for (const auto& p : players) {
 				if (p && !p->IsSpectator()) {
 					if (locked) {
@@ -70,10 +80,25 @@ namespace spades {
 					}
 				}
 			}
+
+			// Override the simulated poses of the remote players with the server's, so that
+			// they are displayed and hit where the server had them `cg_interpolationDelay` ago
+			float delay = cg_interpolationDelay;
+			if (delay > 0.0F) {
+				float maxExtrapolation = cg_maxExtrapolation;
+				for (const auto& p : players) {
+					if (p && !p->IsLocalPlayer() && p->IsAlive() && !p->IsSpectator())
+						p->ApplySnapshots(smoothTime - delay, maxExtrapolation);
+				}
+			}
+
+			// Rebuild the broad-phase once for the tick rather than on the first ray cast
+			GetHitScanIndex();
 		}
 
 		void World::Advance(float dt) {
 			SPADES_MARK_FUNCTION();
+			SPADES_TRACE_ZONE("World::Advance");
 
 			ApplyBlockActions();
 
@@ -105,9 +130,12 @@ namespace spades {
 				grenades.erase(it);
 
 			time += dt;
+			smoothTime = std::max(smoothTime, time);
 		}
 
-		void World::SetMap(Handle<GameMap> newMap) {
+		void World::SetMap(Handle<GameMap> newMap) { SetMap(std::move(newMap), nullptr); }
+
+		void World::SetMap(Handle<GameMap> newMap, std::unique_ptr<GameMapWrapper> newWrapper) {
 			if (map == newMap)
 				return;
 
@@ -118,8 +146,12 @@ namespace spades {
 
 			map = newMap;
 			if (map) {
-				mapWrapper = stmp::make_unique<GameMapWrapper>(*map);
-				mapWrapper->Rebuild();
+				if (newWrapper) {
+					mapWrapper = std::move(newWrapper);
+				} else {
+					mapWrapper = stmp::make_unique<GameMapWrapper>(*map);
+					mapWrapper->Rebuild();
+				}
 			}
 		}
 
@@ -133,10 +165,21 @@ namespace spades {
 			SPADES_MARK_FUNCTION();
 
 			players.at(i) = std::move(p);
+			hitScanIndex->Invalidate();
 			if (listener)
 				listener->PlayerObjectSet(i);
 		}
 
+		const HitScanIndex& World::GetHitScanIndex() {
+			if (hitScanIndex->IsDirty())
+				hitScanIndex->Build(*this);
+			return *hitScanIndex;
+		}
+
+		void World::PlayerMoved(Player& p) {
+			hitScanIndex->PlayerMoved(p.GetId(), p.GetPosition());
+		}
+
 		void World::SetMode(std::unique_ptr<IGameMode> m) { mode = std::move(m); }
 
 		void World::MarkBlockForRegeneration(const IntVector3& blockLocation) {
@@ -223,25 +266,66 @@ namespace spades {
 		}
 
 		void World::ApplyBlockActions() {
-			for (const auto& creation : createdBlocks) {
-				const auto& pos = creation.first;
-				const auto& col = creation.second;
-				uint32_t color = IntVectorToColor(col) | (100UL << 24);
-				color = map->GetColorJit(color); // jit the colour
-				if (map->IsSolid(pos.x, pos.y, pos.z)) {
-					map->Set(pos.x, pos.y, pos.z, true, color);
-					continue;
+			bool hasBlockActions = !createdBlocks.empty() || !destroyedBlocks.empty();
+			double timeBudget = std::max((float)cg_floatingBlockTimeBudget, 0.0F) / 1000.0;
+
+			if (mapWrapper && mapWrapper->IsRemovingBlocks()) {
+				// The search for floating blocks started in a previous frame is still running.
+				// The solidity of the map must not change until it completes, so finish it
+				// now if there are more block actions to apply.
+				if (!hasBlockActions && !mapWrapper->ContinueRemoveBlocks(0.0)) {
+					mapWrapper->ContinueRemoveBlocksAsync(timeBudget);
+					return;
 				}
-				mapWrapper->AddBlock(pos.x, pos.y, pos.z, color);
+				DropFloatingBlocks(mapWrapper->EndRemoveBlocks());
 			}
 
-			std::vector<CellPos> cells;
-			for (const auto& cell : destroyedBlocks) {
-				if (!map->IsSolid(cell.x, cell.y, cell.z))
-					continue;
-				cells.emplace_back(cell);
+			if (!hasBlockActions)
+				return;
+
+			{
+				// Notify the listeners of all changes at once
+				GameMap::BatchScope batch{*map};
+
+				for (const auto& creation : createdBlocks) {
+					const auto& pos = creation.first;
+					const auto& col = creation.second;
+					uint32_t color = IntVectorToColor(col) | (100UL << 24);
+					color = map->GetColorJit(color); // jit the colour
+					if (map->IsSolid(pos.x, pos.y, pos.z)) {
+						map->Set(pos.x, pos.y, pos.z, true, color);
+						continue;
+					}
+					mapWrapper->AddBlock(pos.x, pos.y, pos.z, color);
+				}
+
+				std::vector<CellPos> cells;
+				for (const auto& cell : destroyedBlocks) {
+					if (!map->IsSolid(cell.x, cell.y, cell.z))
+						continue;
+					cells.emplace_back(cell);
+				}
+				mapWrapper->BeginRemoveBlocks(cells);
+			}
+
+			createdBlocks.clear();
+			destroyedBlocks.clear();
+
+			// Most searches complete within the budget. If it takes longer (e.g., a large
+			// structure lost its support), continue on a background thread in the following
+			// frames so they don't stall.
+			if (timeBudget > 0.0 && !mapWrapper->ContinueRemoveBlocks(timeBudget)) {
+				mapWrapper->ContinueRemoveBlocksAsync(timeBudget);
+				return;
 			}
-			cells = mapWrapper->RemoveBlocks(cells);
+			DropFloatingBlocks(mapWrapper->EndRemoveBlocks());
+		}
+
+		void World::DropFloatingBlocks(const std::vector<CellPos>& cells) {
+			if (cells.empty())
+				return;
+
+			GameMap::BatchScope batch{*map};
 
 			std::vector<IntVector3> cells2;
 			for (const auto& cluster : ClusterizeBlocks(cells)) {
@@ -254,9 +338,6 @@ namespace spades {
 				if (listener)
 					listener->BlocksFell(cells2);
 			}
-
-			createdBlocks.clear();
-			destroyedBlocks.clear();
 		}
 
 		void World::CreateBlock(spades::IntVector3 pos, spades::IntVector3 color) {
@@ -383,19 +464,35 @@ namespace spades {
 
 			bool interp = cg_orientationSmoothing;
 
-			for (int i = 0; i < (int)players.size(); i++) {
+			HitScanIndex::PlayerSet candidates;
+			GetHitScanIndex().QueryRay(startPos, dir, candidates);
+
+			// Test the hitboxes of the players near the ray at once
+			hitBoxBatch.Clear();
+			hitBoxOwners.clear();
+			candidates.ForEach([&](int i) {
 				const auto& p = players[i];
 				if (!p || (excludePlayerId && *excludePlayerId == i))
-					continue;
+					return;
 
 				if (!p->IsAlive() || p->IsSpectator())
-					continue; // filter deads/spectators
+					return; // filter deads/spectators
 				if (!p->RayCastApprox(startPos, dir))
-					continue; // quickly reject players unlikely to be hit
+					return; // quickly reject players unlikely to be hit
+
+				hitBoxBatch.Append(p->GetHitBoxBatch(interp)); // interpolated
+				hitBoxOwners.push_back(i);
+			});
+
+			hitBoxResults.resize(hitBoxBatch.GetCount());
+			hitBoxBatch.RayCast(startPos, dir, hitBoxResults.data());
+
+			for (std::size_t k = 0; k < hitBoxOwners.size(); k++) {
+				int i = hitBoxOwners[k];
+				const OBB3Batch::RayCastResult* hb = &hitBoxResults[k * Player::HitBoxBatchSize];
 
-				Vector3 hitPos;
-				Player::HitBoxes hb = p->GetHitBoxes(interp); // interpolated
-				if (hb.head.RayCast(startPos, dir, &hitPos)) {
+				if (hb[Player::HitBoxBatchHead].hit) {
+					Vector3 hitPos = hb[Player::HitBoxBatchHead].hitPos;
 					float const dist = (hitPos - startPos).GetSquaredLength();
 					if (!hitPlayerId || dist < hitPlayerDist) {
 						if (hitPlayerId != i) {
@@ -408,7 +505,8 @@ namespace spades {
 					}
 				}
 
-				if (hb.torso.RayCast(startPos, dir, &hitPos)) {
+				if (hb[Player::HitBoxBatchTorso].hit) {
+					Vector3 hitPos = hb[Player::HitBoxBatchTorso].hitPos;
 					float const dist = (hitPos - startPos).GetSquaredLength();
 					if (!hitPlayerId || dist < hitPlayerDist) {
 						if (hitPlayerId != i) {
@@ -422,7 +520,8 @@ namespace spades {
 				}
 
 				for (int j = 0; j < 3; j++) {
-					if (hb.limbs[j].RayCast(startPos, dir, &hitPos)) {
+					if (hb[Player::HitBoxBatchLimbs + j].hit) {
+						Vector3 hitPos = hb[Player::HitBoxBatchLimbs + j].hitPos;
 						float const dist = (hitPos - startPos).GetSquaredLength();
 						if (!hitPlayerId || dist < hitPlayerDist) {
 							if (hitPlayerId != i) {
@@ -46,6 +46,7 @@ namespace spades {
 		class IGameMode;
 		class Client; // FIXME: for debug
 		class HitTestDebugger;
+		class HitScanIndex;
 		struct GameProperties;
 
 		constexpr std::size_t NumPlayerSlots = 256;
@@ -71,6 +72,8 @@ namespace spades {
 			Handle<GameMap> map;
 			std::unique_ptr<GameMapWrapper> mapWrapper;
 			float time = 0.0F;
+			/** See `GetSmoothTime`. */
+			float smoothTime = 0.0F;
 			IntVector3 fogColor;
 			Team teams[3];
 
@@ -82,6 +85,12 @@ namespace spades {
 
 			std::list<std::unique_ptr<Grenade>> grenades;
 			std::unique_ptr<HitTestDebugger> hitTestDebugger;
+			std::unique_ptr<HitScanIndex> hitScanIndex;
+
+			/** Scratch buffers of `WeaponRayCast`, kept to avoid allocations per ray. */
+			OBB3Batch hitBoxBatch;
+			std::vector<int> hitBoxOwners;
+			std::vector<OBB3Batch::RayCastResult> hitBoxResults;
 
 			std::unordered_map<CellPos, spades::IntVector3, CellPosHash> createdBlocks;
 			std::unordered_set<CellPos, CellPosHash> destroyedBlocks;
@@ -91,6 +100,8 @@ namespace spades {
 			  damagedBlocksQueueMap;
 
 			void ApplyBlockActions();
+			/** Removes the blocks found by `GameMapWrapper` and makes them fall. */
+			void DropFloatingBlocks(const std::vector<CellPos>&);
 
 		public:
 			World(const std::shared_ptr<GameProperties>&);
@@ -99,11 +110,21 @@ namespace spades {
 			GameMapWrapper& GetMapWrapper() { return *mapWrapper; }
 			float GetTime() { return time; }
 			int GetTimeMS() { return (int)(time * 1000); }
+			/**
+			 * `GetTime` plus the time `UpdatePlayer(dt, false)` advanced since the last tick.
+			 * The snapshots of the remote players are received and displayed in this time.
+			 */
+			float GetSmoothTime() { return smoothTime; }
 
 			/** Returns a non-null reference to `GameProperties`. */
 			const std::shared_ptr<GameProperties>& GetGameProperties() { return gameProperties; }
 
 			void SetMap(Handle<GameMap>);
+			/**
+			 * Sets the map along with a `GameMapWrapper` that was already built for it (e.g.,
+			 * by `GameMapLoader` while the map was being received).
+			 */
+			void SetMap(Handle<GameMap>, std::unique_ptr<GameMapWrapper>);
 
 			IntVector3 GetFogColor() { return fogColor; }
 			void SetFogColor(IntVector3 v) { fogColor = v; }
@@ -127,6 +148,15 @@ namespace spades {
 
 			void SetPlayer(int i, std::unique_ptr<Player> p);
 
+			/**
+			 * Returns the broad-phase for ray casts against players, rebuilding it if some
+			 * player has moved too far since it was built.
+			 */
+			const HitScanIndex& GetHitScanIndex();
+
+			/** Must be called whenever the position of the player changes. */
+			void PlayerMoved(Player&);
+
 			/**
 			 * Get the object containing data specific to the current game mode.
 			 * Can be `{}` if the game mode is not specified yet.
@@ -49,7 +49,7 @@
 
 DEFINE_SPADES_SETTING(core_numDispatchQueueThreads, "auto");
 
-static int GetNumCores() {
+int spades::GetNumCores() {
 #ifdef WIN32
 	SYSTEM_INFO sysinfo;
 	GetSystemInfo(&sysinfo);
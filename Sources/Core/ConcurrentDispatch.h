@@ -31,6 +31,9 @@ namespace spades {
 	class SynchronizedQueue;
 	class ConcurrentDispatch;
 
+	/** Returns the number of the available logical processors. */
+	int GetNumCores();
+
 	class DispatchQueue {
 		friend class ConcurrentDispatch;
 		SynchronizedQueue *internal;
@@ -55,8 +55,11 @@ namespace spades {
 			featureEcx = ar[2];
 			featureEdx = ar[3];
 
-			// xsave/osxsave
-			if ((featureEcx & (1U << 28)) && (featureEcx & 26) && (featureEcx & 27)) {
+			// avx, xsave and osxsave
+			featureXcr0Avx = false;
+			featureXcr0Avx512 = false;
+			if ((featureEcx & (1U << 28)) && (featureEcx & (1U << 26)) &&
+			    (featureEcx & (1U << 27))) {
 				auto x = xcr0();
 				featureXcr0Avx = ((x & 6) == 6);
 				featureXcr0Avx512 = ((x & 224) == 224);
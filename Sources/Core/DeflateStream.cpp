@@ -115,6 +115,10 @@ namespace spades {
 			SPRaise("State is invalid");
 		}
 
+		// Flush the data that hasn't been compressed yet
+		if (!buffer.empty())
+			CompressBuffer();
+
 		char outputBuffer[chunkSize];
 
 		zstream.avail_in = 0;
@@ -18,6 +18,7 @@
 
  */
 
+#include <cstdio>
 #include <sys/stat.h>
 
 #ifdef WIN32
@@ -35,6 +36,7 @@
 
 #include "Debug.h"
 #include "Exception.h"
+#include "MappedFile.h"
 #include "SdlFileStream.h"
 
 namespace spades {
@@ -198,4 +200,22 @@ namespace spades {
 		}
 		return false;
 	}
-} // namespace spades
\ No newline at end of file
+
+	bool DirectoryFileSystem::RemoveFile(const char* fn) {
+		SPADES_MARK_FUNCTION();
+		if (!canWrite)
+			return false;
+
+		std::string path = PathToPhysical(fn);
+#ifdef WIN32
+		return DeleteFileW(Utf8ToWString(path.c_str()).c_str()) != 0;
+#else
+		return remove(path.c_str()) == 0;
+#endif
+	}
+
+	std::unique_ptr<MappedFile> DirectoryFileSystem::MapForReading(const char* fn) {
+		SPADES_MARK_FUNCTION();
+		return stmp::make_unique<MappedFile>(PathToPhysical(fn));
+	}
+} // namespace spades
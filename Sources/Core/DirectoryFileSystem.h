@@ -40,5 +40,7 @@ namespace spades {
 		std::unique_ptr<IStream> OpenForReading(const char*) override;
 		std::unique_ptr<IStream> OpenForWriting(const char*) override;
 		bool FileExists(const char*) override;
+		bool RemoveFile(const char*) override;
+		std::unique_ptr<MappedFile> MapForReading(const char*) override;
 	};
 } // namespace spades
\ No newline at end of file
@@ -26,6 +26,7 @@
 #include "FileManager.h"
 #include "IFileSystem.h"
 #include "IStream.h"
+#include "MappedFile.h"
 
 namespace spades {
 	static std::list<IFileSystem*> g_fileSystems;
@@ -94,6 +95,30 @@ namespace spades {
 		return false;
 	}
 
+	bool FileManager::RemoveFile(const char* fn) {
+		SPADES_MARK_FUNCTION();
+		if (!fn)
+			SPInvalidArgument("fn");
+
+		for (auto* fs : g_fileSystems) {
+			if (fs->FileExists(fn))
+				return fs->RemoveFile(fn);
+		}
+		return false;
+	}
+
+	std::unique_ptr<MappedFile> FileManager::MapForReading(const char* fn) {
+		SPADES_MARK_FUNCTION();
+		if (!fn)
+			SPInvalidArgument("fn");
+
+		for (auto* fs : g_fileSystems) {
+			if (fs->FileExists(fn))
+				return fs->MapForReading(fn);
+		}
+		SPFileNotFound(fn);
+	}
+
 	void FileManager::AddFileSystem(spades::IFileSystem* fs) {
 		SPADES_MARK_FUNCTION();
 		AppendFileSystem(fs);
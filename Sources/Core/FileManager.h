@@ -27,6 +27,7 @@
 namespace spades {
 	class IStream;
 	class IFileSystem;
+	class MappedFile;
 	class FileManager {
 		FileManager() {}
 
@@ -34,6 +35,13 @@ namespace spades {
 		static std::unique_ptr<IStream> OpenForReading(const char*);
 		static std::unique_ptr<IStream> OpenForWriting(const char*);
 		static bool FileExists(const char*);
+		/** Removes a file from the first file system containing it. */
+		static bool RemoveFile(const char*);
+		/**
+		 * Maps a file from the first file system containing it.
+		 * @return null if that file system can't map files.
+		 */
+		static std::unique_ptr<MappedFile> MapForReading(const char*);
 		static void AddFileSystem(IFileSystem*);
 		static void AppendFileSystem(IFileSystem*);
 		static void PrependFileSystem(IFileSystem*);
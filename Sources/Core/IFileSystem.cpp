@@ -19,5 +19,8 @@
  */
 
 #include "IFileSystem.h"
+#include "MappedFile.h"
 
-namespace spades {}
\ No newline at end of file
+namespace spades {
+	std::unique_ptr<MappedFile> IFileSystem::MapForReading(const char*) { return nullptr; }
+} // namespace spades
\ No newline at end of file
@@ -26,6 +26,7 @@
 
 namespace spades {
 	class IStream;
+	class MappedFile;
 	class IFileSystem {
 	public:
 		virtual ~IFileSystem() {}
@@ -33,5 +34,9 @@ namespace spades {
 		virtual std::unique_ptr<IStream> OpenForReading(const char*) = 0;
 		virtual std::unique_ptr<IStream> OpenForWriting(const char*) = 0;
 		virtual bool FileExists(const char*) = 0;
+		/** @return `true` if the file was removed. Read-only file systems return `false`. */
+		virtual bool RemoveFile(const char*) { return false; }
+		/** @return A mapping of the file, or null if the file system can't map files. */
+		virtual std::unique_ptr<MappedFile> MapForReading(const char*);
 	};
 } // namespace spades
\ No newline at end of file
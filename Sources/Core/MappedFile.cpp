@@ -0,0 +1,121 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifdef WIN32
+#include <algorithm>
+
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Debug.h"
+#include "Exception.h"
+#include "MappedFile.h"
+
+namespace spades {
+
+#ifdef WIN32
+	MappedFile::MappedFile(const std::string& path)
+	    : data(nullptr), size(0), handle(nullptr) {
+		SPADES_MARK_FUNCTION();
+
+		int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+		std::wstring widePath(static_cast<std::size_t>(std::max(length, 1)), L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], length);
+
+		HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			SPRaise("Failed to open %s for mapping: 0x%08x", path.c_str(), (int)GetLastError());
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize)) {
+			DWORD err = GetLastError();
+			CloseHandle(file);
+			SPRaise("Failed to get the size of %s: 0x%08x", path.c_str(), (int)err);
+		}
+		size = static_cast<std::size_t>(fileSize.QuadPart);
+		if (size == 0) {
+			CloseHandle(file);
+			return;
+		}
+
+		// The mapping keeps the file open
+		handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (!handle)
+			SPRaise("Failed to map %s: 0x%08x", path.c_str(), (int)GetLastError());
+
+		data = static_cast<const char*>(MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0));
+		if (!data) {
+			DWORD err = GetLastError();
+			CloseHandle(handle);
+			SPRaise("Failed to map %s: 0x%08x", path.c_str(), (int)err);
+		}
+	}
+
+	MappedFile::~MappedFile() {
+		SPADES_MARK_FUNCTION();
+
+		if (data)
+			UnmapViewOfFile(data);
+		if (handle)
+			CloseHandle(handle);
+	}
+#else
+	MappedFile::MappedFile(const std::string& path)
+	    : data(nullptr), size(0), handle(nullptr) {
+		SPADES_MARK_FUNCTION();
+
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			SPRaise("Failed to open %s for mapping", path.c_str());
+
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			close(fd);
+			SPRaise("Failed to get the size of %s", path.c_str());
+		}
+		size = static_cast<std::size_t>(st.st_size);
+		if (size == 0) {
+			close(fd);
+			return;
+		}
+
+		// The mapping keeps the file open
+		void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (addr == MAP_FAILED)
+			SPRaise("Failed to map %s", path.c_str());
+		data = static_cast<const char*>(addr);
+	}
+
+	MappedFile::~MappedFile() {
+		SPADES_MARK_FUNCTION();
+
+		if (data)
+			munmap(const_cast<char*>(data), size);
+	}
+#endif
+} // namespace spades
@@ -1,5 +1,5 @@
 /*
- Copyright (c) 2013 yvt
+ Copyright (c) 2026 OpenSpades developers
 
  This file is part of OpenSpades.
 
@@ -20,28 +20,25 @@
 
 #pragma once
 
-#include "ParticleSpriteEntity.h"
+#include <cstddef>
+#include <string>
 
 namespace spades {
-	namespace client {
-		class IImage;
-		class IRenderer;
-		class SmokeSpriteEntity : public ParticleSpriteEntity {
-		public:
-			enum class Type { Steady, Explosion };
-
-		private:
-			float frame;
-			float fps;
-			Type type;
-			static IImage& GetSequence(int i, IRenderer* r, Type);
-
-		public:
-			SmokeSpriteEntity(Client& cli, Vector4 color, float fps, Type type = Type::Steady);
-
-			static void Preload(IRenderer*);
-
-			bool Update(float dt) override;
-		};
-	} // namespace client
-} // namespace spades
\ No newline at end of file
+	/** A read-only memory mapping of a whole file. */
+	class MappedFile {
+		const char* data;
+		std::size_t size;
+		void* handle;
+
+	public:
+		/** Maps the file at a native path. */
+		MappedFile(const std::string& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		void operator=(const MappedFile&) = delete;
+
+		const char* GetData() const { return data; }
+		std::size_t GetSize() const { return size; }
+	};
+} // namespace spades
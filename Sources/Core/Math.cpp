@@ -22,9 +22,22 @@
 #include <new>
 
 #include "Math.h"
+#include <Core/CpuID.h>
 #include <Core/Debug.h>
 #include <Core/ThreadLocalStorage.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPADES_OBB3BATCH_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SPADES_TARGET_AVX __attribute__((target("avx")))
+#else
+#define SPADES_TARGET_AVX
+#endif
+#else
+#define SPADES_OBB3BATCH_X86 0
+#endif
+
 namespace spades {
 	namespace {
 		std::random_device r_device;
@@ -466,6 +479,293 @@ namespace spades {
 		return ab;
 	}
 
+	namespace {
+		// Field offsets in an `OBB3Batch` block
+		enum {
+			FieldAxis = 0,     // 3 axes x 3 components
+			FieldOrigin = 9,   // 3 components
+			FieldSqLength = 12, // squared length of 3 axes
+			FieldInverse = 15, // `m.InversedFast()`, 3 rows x 4 columns
+		};
+
+		/** The other two axes tested by the plane hit test of each axis, in `OBB3::RayCast`. */
+		const int planeOtherAxes[3][2] = {{1, 2}, {0, 2}, {0, 1}};
+
+#if SPADES_OBB3BATCH_X86
+		// The kernels below replicate the exact sequence of floating-point operations of
+		// `OBB3::operator&&` and `OBB3::RayCast`, so do not reorder them. (This also assumes
+		// the compiler doesn't contract them into FMAs, which it won't unless told to target
+		// FMA-capable CPUs.)
+
+		inline __m128 LoadFieldSSE2(const float* block, int field) {
+			return _mm_loadu_ps(block + field * OBB3Batch::BlockSize);
+		}
+
+		inline __m128 DotSSE2(const __m128* a, const __m128* b) {
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])),
+			                  _mm_mul_ps(a[2], b[2]));
+		}
+
+		void RayCastSSE2(const float* block, const Vector3& start, const Vector3& dir,
+		                 int& outHits, float (&outPos)[3][4]) {
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0F);
+			const __m128 st[3] = {_mm_set1_ps(start.x), _mm_set1_ps(start.y),
+			                      _mm_set1_ps(start.z)};
+			const __m128 d[3] = {_mm_set1_ps(dir.x), _mm_set1_ps(dir.y), _mm_set1_ps(dir.z)};
+
+			// inside?
+			__m128 inside = _mm_cmpeq_ps(zero, zero);
+			for (int r = 0; r < 3; r++) {
+				__m128 v = _mm_mul_ps(LoadFieldSSE2(block, FieldInverse + r * 4), st[0]);
+				v = _mm_add_ps(v, _mm_mul_ps(LoadFieldSSE2(block, FieldInverse + r * 4 + 1), st[1]));
+				v = _mm_add_ps(v, _mm_mul_ps(LoadFieldSSE2(block, FieldInverse + r * 4 + 2), st[2]));
+				v = _mm_add_ps(v, LoadFieldSSE2(block, FieldInverse + r * 4 + 3));
+				inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmplt_ps(v, one)));
+			}
+
+			__m128 axis[3][3], sqLength[3], origin[3], s[3], e[3];
+			for (int k = 0; k < 3; k++) {
+				for (int c = 0; c < 3; c++)
+					axis[k][c] = LoadFieldSSE2(block, FieldAxis + k * 3 + c);
+				sqLength[k] = LoadFieldSSE2(block, FieldSqLength + k);
+				origin[k] = LoadFieldSSE2(block, FieldOrigin + k);
+				s[k] = _mm_sub_ps(st[k], origin[k]);
+				e[k] = _mm_add_ps(s[k], d[k]);
+			}
+
+			// Plane hit tests. The first one passing wins
+			__m128 found = inside;
+			__m128 pos[3] = {st[0], st[1], st[2]};
+			for (int k = 0; k < 3; k++) {
+				__m128 startp = DotSSE2(s, axis[k]);
+				__m128 endp = DotSSE2(e, axis[k]);
+				__m128 nearHit = _mm_div_ps(startp, _mm_sub_ps(startp, endp));
+				__m128 farHit = _mm_div_ps(_mm_sub_ps(sqLength[k], startp), _mm_sub_ps(endp, startp));
+				__m128 front = _mm_cmplt_ps(startp, endp);
+				__m128 hit = _mm_or_ps(_mm_and_ps(front, nearHit), _mm_andnot_ps(front, farHit));
+
+				__m128 p[3];
+				for (int c = 0; c < 3; c++)
+					p[c] = _mm_add_ps(s[c], _mm_mul_ps(d[c], hit));
+
+				int u = planeOtherAxes[k][0], w = planeOtherAxes[k][1];
+				__m128 ud = DotSSE2(p, axis[u]);
+				__m128 wd = DotSSE2(p, axis[w]);
+				__m128 valid = _mm_and_ps(_mm_cmpneq_ps(DotSSE2(d, axis[k]), zero), _mm_cmpge_ps(hit, zero));
+				valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(ud, zero), _mm_cmpge_ps(wd, zero)));
+				valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmple_ps(ud, sqLength[u]),
+				                                     _mm_cmple_ps(wd, sqLength[w])));
+				valid = _mm_andnot_ps(found, valid);
+
+				for (int c = 0; c < 3; c++) {
+					__m128 q = _mm_add_ps(p[c], origin[c]);
+					pos[c] = _mm_or_ps(_mm_and_ps(valid, q), _mm_andnot_ps(valid, pos[c]));
+				}
+				found = _mm_or_ps(found, valid);
+			}
+
+			outHits = _mm_movemask_ps(found);
+			for (int c = 0; c < 3; c++)
+				_mm_storeu_ps(outPos[c], pos[c]);
+		}
+
+		SPADES_TARGET_AVX inline __m256 LoadFieldAVX(const float* block, int field) {
+			return _mm256_loadu_ps(block + field * OBB3Batch::BlockSize);
+		}
+
+		SPADES_TARGET_AVX inline __m256 DotAVX(const __m256* a, const __m256* b) {
+			return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[0], b[0]), _mm256_mul_ps(a[1], b[1])),
+			                     _mm256_mul_ps(a[2], b[2]));
+		}
+
+		SPADES_TARGET_AVX
+		void RayCastAVX(const float* block, const Vector3& start, const Vector3& dir,
+		                int& outHits, float (&outPos)[3][8]) {
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 one = _mm256_set1_ps(1.0F);
+			const __m256 st[3] = {_mm256_set1_ps(start.x), _mm256_set1_ps(start.y),
+			                      _mm256_set1_ps(start.z)};
+			const __m256 d[3] = {_mm256_set1_ps(dir.x), _mm256_set1_ps(dir.y),
+			                     _mm256_set1_ps(dir.z)};
+
+			// inside?
+			__m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+			for (int r = 0; r < 3; r++) {
+				__m256 v = _mm256_mul_ps(LoadFieldAVX(block, FieldInverse + r * 4), st[0]);
+				v = _mm256_add_ps(v, _mm256_mul_ps(LoadFieldAVX(block, FieldInverse + r * 4 + 1), st[1]));
+				v = _mm256_add_ps(v, _mm256_mul_ps(LoadFieldAVX(block, FieldInverse + r * 4 + 2), st[2]));
+				v = _mm256_add_ps(v, LoadFieldAVX(block, FieldInverse + r * 4 + 3));
+				inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ),
+				                                             _mm256_cmp_ps(v, one, _CMP_LT_OQ)));
+			}
+
+			__m256 axis[3][3], sqLength[3], origin[3], s[3], e[3];
+			for (int k = 0; k < 3; k++) {
+				for (int c = 0; c < 3; c++)
+					axis[k][c] = LoadFieldAVX(block, FieldAxis + k * 3 + c);
+				sqLength[k] = LoadFieldAVX(block, FieldSqLength + k);
+				origin[k] = LoadFieldAVX(block, FieldOrigin + k);
+				s[k] = _mm256_sub_ps(st[k], origin[k]);
+				e[k] = _mm256_add_ps(s[k], d[k]);
+			}
+
+			// Plane hit tests. The first one passing wins
+			__m256 found = inside;
+			__m256 pos[3] = {st[0], st[1], st[2]};
+			for (int k = 0; k < 3; k++) {
+				__m256 startp = DotAVX(s, axis[k]);
+				__m256 endp = DotAVX(e, axis[k]);
+				__m256 nearHit = _mm256_div_ps(startp, _mm256_sub_ps(startp, endp));
+				__m256 farHit =
+				  _mm256_div_ps(_mm256_sub_ps(sqLength[k], startp), _mm256_sub_ps(endp, startp));
+				__m256 front = _mm256_cmp_ps(startp, endp, _CMP_LT_OQ);
+				__m256 hit = _mm256_blendv_ps(farHit, nearHit, front);
+
+				__m256 p[3];
+				for (int c = 0; c < 3; c++)
+					p[c] = _mm256_add_ps(s[c], _mm256_mul_ps(d[c], hit));
+
+				int u = planeOtherAxes[k][0], w = planeOtherAxes[k][1];
+				__m256 ud = DotAVX(p, axis[u]);
+				__m256 wd = DotAVX(p, axis[w]);
+				__m256 valid = _mm256_and_ps(_mm256_cmp_ps(DotAVX(d, axis[k]), zero, _CMP_NEQ_UQ),
+				                             _mm256_cmp_ps(hit, zero, _CMP_GE_OQ));
+				valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(ud, zero, _CMP_GE_OQ),
+				                                           _mm256_cmp_ps(wd, zero, _CMP_GE_OQ)));
+				valid = _mm256_and_ps(valid,
+				                      _mm256_and_ps(_mm256_cmp_ps(ud, sqLength[u], _CMP_LE_OQ),
+				                                    _mm256_cmp_ps(wd, sqLength[w], _CMP_LE_OQ)));
+				valid = _mm256_andnot_ps(found, valid);
+
+				for (int c = 0; c < 3; c++)
+					pos[c] = _mm256_blendv_ps(pos[c], _mm256_add_ps(p[c], origin[c]), valid);
+				found = _mm256_or_ps(found, valid);
+			}
+
+			outHits = _mm256_movemask_ps(found);
+			for (int c = 0; c < 3; c++)
+				_mm256_storeu_ps(outPos[c], pos[c]);
+		}
+#endif
+	} // namespace
+
+	void OBB3Batch::Clear() {
+		boxes.clear();
+		blocks.clear();
+	}
+
+	void OBB3Batch::Add(const OBB3& box) {
+		std::size_t index = boxes.size();
+		boxes.push_back(box);
+		if (index % BlockSize == 0)
+			blocks.resize(blocks.size() + BlockSize * NumFields, 0.0F);
+
+		const Matrix4& m = box.m;
+		for (int k = 0; k < 3; k++) {
+			Vector3 axis = m.GetAxis(k);
+			*GetField(index, FieldAxis + k * 3) = axis.x;
+			*GetField(index, FieldAxis + k * 3 + 1) = axis.y;
+			*GetField(index, FieldAxis + k * 3 + 2) = axis.z;
+			*GetField(index, FieldSqLength + k) = axis.GetSquaredLength();
+			*GetField(index, FieldOrigin + k) = m.m[12 + k];
+		}
+
+		Matrix4 inv = m.InversedFast();
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 4; c++)
+				*GetField(index, FieldInverse + r * 4 + c) = inv.m[c * 4 + r];
+	}
+
+	void OBB3Batch::Append(const OBB3Batch& other) {
+		for (std::size_t i = 0; i < other.boxes.size(); i++) {
+			std::size_t index = boxes.size();
+			boxes.push_back(other.boxes[i]);
+			if (index % BlockSize == 0)
+				blocks.resize(blocks.size() + BlockSize * NumFields, 0.0F);
+
+			const float* src = &other.blocks[(i / BlockSize) * (BlockSize * NumFields) + i % BlockSize];
+			for (int f = 0; f < NumFields; f++)
+				*GetField(index, f) = src[f * BlockSize];
+		}
+	}
+
+	bool OBB3Batch::IsKernelSupported(Kernel kernel) {
+		switch (kernel) {
+			case Kernel::Scalar: return true;
+#if SPADES_OBB3BATCH_X86
+			case Kernel::SSE2: return true;
+			case Kernel::AVX: {
+				static bool supported = CpuID().Supports(CpuFeature::AVX);
+				return supported;
+			}
+#else
+			case Kernel::SSE2:
+			case Kernel::AVX: return false;
+#endif
+		}
+		return false;
+	}
+
+	OBB3Batch::Kernel OBB3Batch::GetBestKernel() {
+		if (IsKernelSupported(Kernel::AVX))
+			return Kernel::AVX;
+		if (IsKernelSupported(Kernel::SSE2))
+			return Kernel::SSE2;
+		return Kernel::Scalar;
+	}
+
+	void OBB3Batch::RayCast(const Vector3& start, const Vector3& dir,
+	                        RayCastResult* results) const {
+		static Kernel const kernel = GetBestKernel();
+		RayCast(start, dir, results, kernel);
+	}
+
+	void OBB3Batch::RayCast(const Vector3& start, const Vector3& dir, RayCastResult* results,
+	                        Kernel kernel) const {
+		SPAssert(IsKernelSupported(kernel));
+
+		const std::size_t count = boxes.size();
+
+#if SPADES_OBB3BATCH_X86
+		if (kernel != Kernel::Scalar) {
+			for (std::size_t base = 0; base < count; base += BlockSize) {
+				const float* block = &blocks[(base / BlockSize) * (BlockSize * NumFields)];
+				std::size_t numLanes = std::min<std::size_t>(count - base, BlockSize);
+				int hits;
+				float pos[3][BlockSize];
+
+				if (kernel == Kernel::AVX) {
+					RayCastAVX(block, start, dir, hits, pos);
+				} else {
+					// Two halves of the block
+					hits = 0;
+					for (std::size_t half = 0; half * 4 < numLanes; half++) {
+						int halfHits;
+						float halfPos[3][4];
+						RayCastSSE2(block + half * 4, start, dir, halfHits, halfPos);
+						for (int c = 0; c < 3; c++)
+							std::copy(halfPos[c], halfPos[c] + 4, pos[c] + half * 4);
+						hits |= halfHits << (half * 4);
+					}
+				}
+
+				for (std::size_t i = 0; i < numLanes; i++) {
+					RayCastResult& result = results[base + i];
+					result.hit = (hits >> i) & 1;
+					result.hitPos = MakeVector3(pos[0][i], pos[1][i], pos[2][i]);
+				}
+			}
+			return;
+		}
+#endif
+
+		for (std::size_t i = 0; i < count; i++) {
+			OBB3 box = boxes[i];
+			results[i].hit = box.RayCast(start, dir, &results[i].hitPos);
+		}
+	}
+
 	Vector3 Line3::Project(Vector3 v, bool supposeUnbounded) {
 		Vector3 delta = v2 - v1;
 		Vector3 direction = delta.Normalize();
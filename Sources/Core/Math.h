@@ -777,6 +777,56 @@ namespace spades {
 		}
 	};
 
+	/** An axis-aligned box of integer coordinates, e.g., voxels. `max` is exclusive. */
+	class IntAABB3 {
+	public:
+		IntVector3 min, max;
+
+		IntAABB3() {}
+		IntAABB3(IntVector3 minVector, IntVector3 maxVector) : min(minVector), max(maxVector) {}
+
+		/** Returns an empty box that becomes the first point added by `+=`. */
+		static IntAABB3 Empty() {
+			return IntAABB3(IntVector3(INT32_MAX, INT32_MAX, INT32_MAX),
+			                IntVector3(INT32_MIN, INT32_MIN, INT32_MIN));
+		}
+
+		bool IsEmpty() const { return min.x >= max.x || min.y >= max.y || min.z >= max.z; }
+
+		/** Returns the number of voxels in the box. */
+		int64_t GetVolume() const {
+			if (IsEmpty())
+				return 0;
+			return int64_t(max.x - min.x) * int64_t(max.y - min.y) * int64_t(max.z - min.z);
+		}
+
+		bool Contains(const IntVector3& v) const {
+			return v.x >= min.x && v.y >= min.y && v.z >= min.z && v.x < max.x && v.y < max.y &&
+			       v.z < max.z;
+		}
+
+		/** Extends the box to include the unit cube at `v`. */
+		void operator+=(const IntVector3& v) {
+			min.x = std::min(min.x, v.x);
+			min.y = std::min(min.y, v.y);
+			min.z = std::min(min.z, v.z);
+			max.x = std::max(max.x, v.x + 1);
+			max.y = std::max(max.y, v.y + 1);
+			max.z = std::max(max.z, v.z + 1);
+		}
+
+		void operator+=(const IntAABB3& b) {
+			if (b.IsEmpty())
+				return;
+			min.x = std::min(min.x, b.min.x);
+			min.y = std::min(min.y, b.min.y);
+			min.z = std::min(min.z, b.min.z);
+			max.x = std::max(max.x, b.max.x);
+			max.y = std::max(max.y, b.max.y);
+			max.z = std::max(max.z, b.max.z);
+		}
+	};
+
 #pragma mark - Oriented Bounding Box
 
 	class OBB3 {
@@ -798,6 +848,52 @@ namespace spades {
 
 	static inline OBB3 operator*(const Matrix4& m, const OBB3& b) { return OBB3(m * b.m); }
 
+	/**
+	 * A set of `OBB3`s stored in the structure-of-arrays layout so that a ray can be tested
+	 * against several boxes at once with SIMD instructions. The results are bit-exact with
+	 * `OBB3::RayCast` on each box.
+	 */
+	class OBB3Batch {
+	public:
+		enum class Kernel { Scalar, SSE2, AVX };
+
+		struct RayCastResult {
+			bool hit;
+			/** Only valid if `hit` is `true`. */
+			Vector3 hitPos;
+		};
+
+		void Clear();
+		void Add(const OBB3&);
+		void Append(const OBB3Batch&);
+
+		std::size_t GetCount() const { return boxes.size(); }
+		const OBB3& operator[](std::size_t i) const { return boxes[i]; }
+
+		/**
+		 * Casts a ray against every box, storing the result for the `i`-th box in
+		 * `results[i]`. Uses the best kernel supported by the CPU.
+		 */
+		void RayCast(const Vector3& start, const Vector3& dir, RayCastResult* results) const;
+		void RayCast(const Vector3& start, const Vector3& dir, RayCastResult* results,
+		             Kernel) const;
+
+		static bool IsKernelSupported(Kernel);
+		static Kernel GetBestKernel();
+
+		enum { BlockSize = 8, NumFields = 27 };
+
+	private:
+		std::vector<OBB3> boxes;
+		/** For each group of `BlockSize` boxes, `NumFields` arrays of `BlockSize` floats. */
+		std::vector<float> blocks;
+
+		float* GetField(std::size_t index, int field) {
+			return &blocks[(index / BlockSize) * (BlockSize * NumFields) + field * BlockSize +
+			               index % BlockSize];
+		}
+	};
+
 #pragma mark - Quaternion for Spatial Rotations
 
 	struct Quaternion {
@@ -915,6 +1011,27 @@ namespace spades {
 		vec.resize(vec.size() - 1);
 	}
 
+	/** Returns the number of set bits in `v`. */
+	static inline int PopCount64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_popcountll(v);
+#else
+		v = v - ((v >> 1) & 0x5555555555555555ULL);
+		v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+		v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		return (int)((v * 0x0101010101010101ULL) >> 56);
+#endif
+	}
+
+	/** Returns the index of the lowest set bit of `v`. `v` must not be zero. */
+	static inline int CountTrailingZeros64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll(v);
+#else
+		return PopCount64((v & (0 - v)) - 1);
+#endif
+	}
+
 	float SmoothStep(float);
 	float Mix(float a, float b, float frac);
 	Vector2 Mix(const Vector2& a, const Vector2& b, float frac);
@@ -0,0 +1,96 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace spades {
+	/**
+	 * A bounded lock-free queue with one producer thread and one consumer thread.
+	 *
+	 * `T` must be default constructible and move assignable. A popped element is left in its
+	 * moved-from state in the ring buffer.
+	 */
+	template <class T> class SPSCQueue {
+	public:
+		/** @param capacity The maximum number of elements. Rounded up to a power of two. */
+		explicit SPSCQueue(std::size_t capacity) {
+			std::size_t size = 1;
+			while (size < capacity)
+				size <<= 1;
+			mask = size - 1;
+			items.reset(new T[size]);
+		}
+
+		SPSCQueue(const SPSCQueue&) = delete;
+		void operator=(const SPSCQueue&) = delete;
+
+		/** Called by the producer. Returns `false` and leaves `item` intact if full. */
+		bool TryPush(T& item) {
+			std::size_t tail = producer.index.load(std::memory_order_relaxed);
+			if (tail - producer.cachedOther > mask) {
+				producer.cachedOther = consumer.index.load(std::memory_order_acquire);
+				if (tail - producer.cachedOther > mask)
+					return false;
+			}
+			items[tail & mask] = std::move(item);
+			producer.index.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Called by the consumer. Returns `false` if empty. */
+		bool TryPop(T& item) {
+			std::size_t head = consumer.index.load(std::memory_order_relaxed);
+			if (head == consumer.cachedOther) {
+				consumer.cachedOther = producer.index.load(std::memory_order_acquire);
+				if (head == consumer.cachedOther)
+					return false;
+			}
+			item = std::move(items[head & mask]);
+			consumer.index.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Called by the consumer. */
+		bool IsEmpty() const {
+			return consumer.index.load(std::memory_order_relaxed) ==
+			       producer.index.load(std::memory_order_acquire);
+		}
+
+	private:
+		std::unique_ptr<T[]> items;
+		std::size_t mask;
+
+		// The producer's and the consumer's fields are kept on separate cache lines. (Padding
+		// instead of `alignas` because the queue is usually heap-allocated.)
+		struct Side {
+			char padding[64];
+			/** Written by this side. */
+			std::atomic<std::size_t> index{0};
+			/** The last seen index of the other side. */
+			std::size_t cachedOther = 0;
+		};
+		Side producer;
+		Side consumer;
+	};
+} // namespace spades
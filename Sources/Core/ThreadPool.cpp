@@ -0,0 +1,237 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__i386__) || defined(_M_IX86) || defined(__amd64__) || defined(__x86_64__) ||         \
+  defined(_M_X64)
+#include <xmmintrin.h>
+#define SPADES_SPIN_PAUSE() _mm_pause()
+#else
+#define SPADES_SPIN_PAUSE() std::this_thread::yield()
+#endif
+
+#include "ConcurrentDispatch.h"
+#include "Debug.h"
+#include "Settings.h"
+#include "Thread.h"
+#include "ThreadLocalStorage.h"
+#include "ThreadPool.h"
+#include "TraceProfiler.h"
+
+SPADES_SETTING(core_numDispatchQueueThreads);
+
+namespace spades {
+	namespace {
+		/** How many times an idle worker polls for a new loop before sleeping. */
+		constexpr int NumSpinIterations = 4000;
+
+		ThreadLocalStorage<ThreadPool> currentWorkerPool("currentWorkerPool");
+	} // namespace
+
+	class ThreadPool::WorkerThread : public Thread {
+	public:
+		WorkerThread(ThreadPool& pool, std::size_t participant)
+		    : pool{pool}, participant{participant} {}
+		void Run() override {
+			SPADES_MARK_FUNCTION();
+			currentWorkerPool = &pool;
+			trace::SetThreadName("Worker " + std::to_string(participant));
+			pool.WorkerMain(participant);
+		}
+
+	private:
+		ThreadPool& pool;
+		std::size_t participant;
+	};
+
+	ThreadPool& ThreadPool::GetInstance() {
+		static ThreadPool* instance = nullptr;
+		static std::once_flag initFlag;
+		std::call_once(initFlag, [] {
+			int cnt = GetNumCores();
+			if (!("auto" == core_numDispatchQueueThreads)) {
+				cnt = core_numDispatchQueueThreads;
+			}
+			cnt = std::max(1, std::min(cnt, static_cast<int>(MaxParticipants)));
+			// Intentionally leaked; the workers might still be sleeping at exit
+			instance = new ThreadPool(cnt);
+		});
+		return *instance;
+	}
+
+	ThreadPool::ThreadPool(int numThreads) {
+		SPADES_MARK_FUNCTION();
+
+		SPLog("Creating a thread pool with %d worker thread(s)", numThreads - 1);
+		for (int i = 1; i < numThreads; i++) {
+			workers.emplace_back(new WorkerThread(*this, static_cast<std::size_t>(i)));
+			workers.back()->Start();
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock{wakeMutex};
+			exiting = true;
+		}
+		wakeCond.notify_all();
+		workers.clear();
+	}
+
+	void ThreadPool::Run(std::size_t count, std::size_t grain, TaskFunction func, void* context) {
+		if (count == 0)
+			return;
+		grain = std::max<std::size_t>(grain, 1);
+
+		if (workers.empty() || count <= grain || currentWorkerPool.GetPointer() == this) {
+			// Not worth or not possible to parallelize
+			for (std::size_t i = 0; i < count; i += grain)
+				func(context, i, std::min(i + grain, count));
+			return;
+		}
+
+		std::unique_lock<std::mutex> submitLock{submitMutex, std::defer_lock};
+		if (!submitLock.try_lock()) {
+			// Another thread's loop is running. Help it finish, then queue behind it
+			SPADES_TRACE_ZONE("Thread Pool Wait");
+			HelpRunningLoop();
+			submitLock.lock();
+		}
+
+		// Wait for the stragglers of the last loop (they will find it closed and leave)
+		while (numActive.load() != 0)
+			SPADES_SPIN_PAUSE();
+
+		std::size_t numSlots = std::min<std::size_t>(workers.size() + 1, (count + grain - 1) / grain);
+		for (std::size_t i = 0; i < numSlots; i++) {
+			slots[i].next.store(count * i / numSlots, std::memory_order_relaxed);
+			slots[i].end = count * (i + 1) / numSlots;
+		}
+		jobFunction = func;
+		jobContext = context;
+		jobGrain = grain;
+		jobNumSlots = numSlots;
+		jobException = nullptr;
+		numRemaining.store(count, std::memory_order_relaxed);
+
+		std::size_t generation = (state.load() >> 1) + 1;
+		bool wake;
+		{
+			std::lock_guard<std::mutex> lock{wakeMutex};
+			state.store((generation << 1) | 1);
+			wake = numSleeping > 0;
+		}
+		if (wake)
+			wakeCond.notify_all();
+
+		// A loop nested in `func` must not wait for this one
+		currentWorkerPool = this;
+		Participate(0);
+		currentWorkerPool = nullptr;
+
+		while (numRemaining.load(std::memory_order_acquire) != 0)
+			SPADES_SPIN_PAUSE();
+
+		// Close the job. Wait until no workers can be touching `slots` or `context`
+		state.store(generation << 1);
+		while (numActive.load() != 0)
+			SPADES_SPIN_PAUSE();
+
+		if (jobException) {
+			std::exception_ptr ex = jobException;
+			jobException = nullptr;
+			std::rethrow_exception(ex);
+		}
+	}
+
+	void ThreadPool::HelpRunningLoop() {
+		// Same as a worker joining a loop
+		numActive.fetch_add(1);
+		if (state.load() & 1) {
+			currentWorkerPool = this;
+			Participate(0);
+			currentWorkerPool = nullptr;
+		}
+		numActive.fetch_sub(1);
+	}
+
+	void ThreadPool::Participate(std::size_t participant) {
+		const std::size_t numSlots = jobNumSlots;
+		const std::size_t grain = jobGrain;
+
+		// Start with our own slot, then steal from the others
+		for (std::size_t k = 0; k < numSlots; k++) {
+			Slot& slot = slots[(participant + k) % numSlots];
+			while (true) {
+				std::size_t begin = slot.next.fetch_add(grain, std::memory_order_relaxed);
+				if (begin >= slot.end)
+					break;
+				std::size_t end = std::min(begin + grain, slot.end);
+
+				try {
+					jobFunction(jobContext, begin, end);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock{exceptionMutex};
+					if (!jobException)
+						jobException = std::current_exception();
+				}
+
+				numRemaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+			}
+		}
+	}
+
+	void ThreadPool::WorkerMain(std::size_t participant) {
+		std::size_t lastGeneration = 0;
+
+		while (true) {
+			// Wait for a new loop
+			std::size_t s = state.load(std::memory_order_acquire);
+			for (int i = 0; i < NumSpinIterations && !((s & 1) && (s >> 1) != lastGeneration);
+			     i++) {
+				SPADES_SPIN_PAUSE();
+				s = state.load(std::memory_order_acquire);
+			}
+
+			if (!((s & 1) && (s >> 1) != lastGeneration)) {
+				std::unique_lock<std::mutex> lock{wakeMutex};
+				numSleeping++;
+				wakeCond.wait(lock, [&] {
+					s = state.load();
+					return exiting || ((s & 1) && (s >> 1) != lastGeneration);
+				});
+				numSleeping--;
+				if (exiting)
+					return;
+			}
+
+			// Announce that we might touch the job state, and check it's still open
+			numActive.fetch_add(1);
+			s = state.load();
+			if ((s & 1) && (s >> 1) != lastGeneration) {
+				Participate(participant);
+				lastGeneration = s >> 1;
+			}
+			numActive.fetch_sub(1);
+		}
+	}
+} // namespace spades
@@ -0,0 +1,140 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace spades {
+	class Thread;
+
+	/**
+	 * A persistent pool of worker threads for data-parallel loops.
+	 *
+	 * Unlike `ConcurrentDispatch`, submitting work does not allocate. The index range of a
+	 * `ParallelFor` is split evenly between the participants (the calling thread and the
+	 * workers). A participant that runs out of work steals chunks of `grain` indices from
+	 * the others. Idle workers spin for a short while before going to sleep so that
+	 * back-to-back loops within a frame don't pay the cost of a wakeup.
+	 *
+	 * The pool is sized by `core_numDispatchQueueThreads`.
+	 */
+	class ThreadPool {
+	public:
+		/** A participant index never exceeds this value. */
+		enum { MaxParticipants = 64 };
+
+		static ThreadPool& GetInstance();
+
+		/** Returns the number of threads executing a loop, including the calling thread. */
+		int GetNumParticipants() const { return static_cast<int>(workers.size()) + 1; }
+
+		/**
+		 * Calls `fn(begin, end)` for disjoint subranges covering `[0, count)` and blocks
+		 * until all of them are done. Each subrange has at most `grain` elements.
+		 *
+		 * If called from within a loop on this pool, the loop is run serially on the calling
+		 * thread. If another thread is running a loop, the calling thread helps it finish and
+		 * then waits for its turn.
+		 *
+		 * An exception thrown by `fn` is rethrown after all subranges are complete.
+		 */
+		template <class F> void ParallelFor(std::size_t count, std::size_t grain, F&& fn) {
+			using FunctionType = typename std::remove_reference<F>::type;
+			Run(count, grain,
+			    [](void* context, std::size_t begin, std::size_t end) {
+				    (*static_cast<FunctionType*>(context))(begin, end);
+			    },
+			    const_cast<void*>(static_cast<const void*>(&fn)));
+		}
+
+		~ThreadPool();
+
+	private:
+		using TaskFunction = void (*)(void* context, std::size_t begin, std::size_t end);
+
+		class WorkerThread;
+
+		/**
+		 * A contiguous range initially assigned to one participant. Padded to avoid false
+		 * sharing (`alignas` is not honored by `new` before C++17).
+		 */
+		struct Slot {
+			std::atomic<std::size_t> next;
+			std::size_t end;
+			char padding[64 - sizeof(std::size_t) * 2];
+		};
+
+		ThreadPool(int numThreads);
+
+		void Run(std::size_t count, std::size_t grain, TaskFunction, void* context);
+
+		/** Participates in the loop currently running, if any. */
+		void HelpRunningLoop();
+
+		/** Claims and executes chunks until no work is left. */
+		void Participate(std::size_t participant);
+
+		void WorkerMain(std::size_t participant);
+
+		std::vector<std::unique_ptr<WorkerThread>> workers;
+
+		/** Serializes the submission of loops. */
+		std::mutex submitMutex;
+
+		// Wakeup of the sleeping workers
+		std::mutex wakeMutex;
+		std::condition_variable wakeCond;
+		int numSleeping = 0;
+		bool exiting = false;
+
+		/**
+		 * `(generation << 1) | open`. Workers only touch the job state below while the
+		 * open bit is set.
+		 */
+		std::atomic<std::size_t> state{0};
+		/** The number of workers that might be touching the job state. */
+		std::atomic<int> numActive{0};
+		/** The number of indices not executed yet. */
+		std::atomic<std::size_t> numRemaining{0};
+
+		TaskFunction jobFunction = nullptr;
+		void* jobContext = nullptr;
+		std::size_t jobGrain = 1;
+		std::size_t jobNumSlots = 0;
+		Slot slots[MaxParticipants];
+
+		std::mutex exceptionMutex;
+		std::exception_ptr jobException;
+	};
+
+	/** Shorthand for `ThreadPool::GetInstance().ParallelFor(...)`. */
+	template <class F> inline void ParallelFor(std::size_t count, std::size_t grain, F&& fn) {
+		ThreadPool::GetInstance().ParallelFor(count, grain, std::forward<F>(fn));
+	}
+} // namespace spades
@@ -0,0 +1,219 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "IStream.h"
+#include "ThreadLocalStorage.h"
+#include "TraceProfiler.h"
+
+namespace spades {
+	namespace trace {
+		namespace detail {
+			std::atomic<bool> recording{false};
+		}
+
+		namespace {
+			/** The number of zones kept per thread. About 1.5 MiB, allocated on first use. */
+			constexpr std::uint64_t BufferCapacity = 1 << 16;
+
+			// Read by `Save` while being written; see `RecordZone`
+			struct Event {
+				std::atomic<const char*> name;
+				std::atomic<std::uint64_t> begin;
+				std::atomic<std::uint64_t> end;
+			};
+
+			struct ThreadBuffer {
+				/** Guarded by `Registry::mutex`. */
+				int id;
+				std::string name;
+
+				std::atomic<Event*> events{nullptr};
+				std::atomic<std::uint64_t> numEvents{0};
+			};
+
+			struct Registry {
+				std::mutex mutex;
+				std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+				std::atomic<std::uint64_t> startTime{0};
+			};
+
+			Registry& GetRegistry() {
+				// Intentionally leaked; threads might still record at exit
+				static Registry* registry = new Registry();
+				return *registry;
+			}
+
+			ThreadLocalStorage<ThreadBuffer> currentBuffer("traceBuffer");
+
+			ThreadBuffer& GetCurrentBuffer() {
+				ThreadBuffer* buffer = currentBuffer.GetPointer();
+				if (!buffer) {
+					// The buffers outlive their threads so that the zones can still be saved
+					Registry& registry = GetRegistry();
+					std::lock_guard<std::mutex> lock(registry.mutex);
+					registry.buffers.emplace_back(new ThreadBuffer());
+					buffer = registry.buffers.back().get();
+					buffer->id = static_cast<int>(registry.buffers.size());
+					buffer->name = "Thread " + std::to_string(buffer->id);
+					currentBuffer = buffer;
+				}
+				return *buffer;
+			}
+
+			void AppendEscaped(std::string& out, const std::string& str) {
+				for (char c : str) {
+					if (c == '"' || c == '\\') {
+						out += '\\';
+						out += c;
+					} else if (static_cast<unsigned char>(c) < 0x20) {
+						char buf[8];
+						std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+						out += buf;
+					} else {
+						out += c;
+					}
+				}
+			}
+		} // namespace
+
+		void Start() {
+			GetRegistry().startTime.store(GetTimestamp());
+			detail::recording.store(true);
+		}
+
+		void Stop() { detail::recording.store(false); }
+
+		void SetThreadName(const std::string& name) {
+			ThreadBuffer& buffer = GetCurrentBuffer();
+			std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+			buffer.name = name;
+		}
+
+		std::uint64_t GetTimestamp() {
+			auto time = std::chrono::steady_clock::now().time_since_epoch();
+			return static_cast<std::uint64_t>(
+			  std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+		}
+
+		void RecordZone(const char* name, std::uint64_t begin, std::uint64_t end) {
+			ThreadBuffer& buffer = GetCurrentBuffer();
+			Event* events = buffer.events.load(std::memory_order_relaxed);
+			if (!events) {
+				events = new Event[BufferCapacity];
+				buffer.events.store(events, std::memory_order_release);
+			}
+
+			// As in a seqlock: the slot is overwritten only after the previous count was
+			// published, so `Save` can tell which of the copied events might be torn
+			std::uint64_t index = buffer.numEvents.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			Event& event = events[index % BufferCapacity];
+			event.name.store(name, std::memory_order_relaxed);
+			event.begin.store(begin, std::memory_order_relaxed);
+			event.end.store(end, std::memory_order_relaxed);
+			buffer.numEvents.store(index + 1, std::memory_order_release);
+		}
+
+		void Save(IStream& stream) {
+			Registry& registry = GetRegistry();
+			std::uint64_t startTime = registry.startTime.load();
+
+			struct ThreadInfo {
+				ThreadBuffer* buffer;
+				int id;
+				std::string name;
+			};
+			std::vector<ThreadInfo> threads;
+			{
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				for (const auto& buffer : registry.buffers)
+					threads.push_back({buffer.get(), buffer->id, buffer->name});
+			}
+
+			std::string out = "{\"traceEvents\":[\n";
+			bool first = true;
+			char buf[256];
+			struct Copy {
+				const char* name;
+				std::uint64_t begin, end;
+			};
+			std::vector<Copy> copies;
+
+			for (const ThreadInfo& thread : threads) {
+				out += first ? "" : ",\n";
+				first = false;
+				out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+				out += std::to_string(thread.id);
+				out += ",\"args\":{\"name\":\"";
+				AppendEscaped(out, thread.name);
+				out += "\"}}";
+
+				ThreadBuffer& buffer = *thread.buffer;
+				Event* events = buffer.events.load(std::memory_order_acquire);
+				if (!events)
+					continue;
+
+				std::uint64_t end = buffer.numEvents.load(std::memory_order_acquire);
+				std::uint64_t begin = end > BufferCapacity ? end - BufferCapacity : 0;
+				copies.clear();
+				for (std::uint64_t i = begin; i < end; i++) {
+					const Event& event = events[i % BufferCapacity];
+					copies.push_back({event.name.load(std::memory_order_relaxed),
+					                  event.begin.load(std::memory_order_relaxed),
+					                  event.end.load(std::memory_order_relaxed)});
+				}
+
+				// Skip the ones the thread might have overwritten while we were copying
+				std::atomic_thread_fence(std::memory_order_acquire);
+				std::uint64_t newEnd = buffer.numEvents.load(std::memory_order_relaxed);
+				std::uint64_t validBegin =
+				  newEnd >= BufferCapacity ? newEnd - BufferCapacity + 1 : 0;
+
+				for (std::uint64_t i = std::max(begin, validBegin); i < end; i++) {
+					const Copy& copy = copies[i - begin];
+					if (copy.begin < startTime)
+						continue;
+					out += ",\n{\"name\":\"";
+					AppendEscaped(out, copy.name);
+					std::snprintf(buf, sizeof(buf),
+					              "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+					              thread.id, (double)(copy.begin - startTime) / 1000.0,
+					              (double)(copy.end - copy.begin) / 1000.0);
+					out += buf;
+
+					if (out.size() > 65536) {
+						stream.Write(out);
+						out.clear();
+					}
+				}
+			}
+
+			out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+			stream.Write(out);
+		}
+	} // namespace trace
+} // namespace spades
@@ -0,0 +1,82 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace spades {
+	class IStream;
+
+	/**
+	 * A low-overhead CPU profiler recording scoped zones on any thread, which can be saved as
+	 * a Chrome trace (viewable in `chrome://tracing` and Perfetto).
+	 *
+	 * Each thread records into its own ring buffer without locking, so the newest few seconds
+	 * of every thread are available when `Save` is called. A zone costs one relaxed atomic
+	 * load while not recording.
+	 */
+	namespace trace {
+		namespace detail {
+			extern std::atomic<bool> recording;
+		}
+
+		/** Starts recording. The zones recorded before are discarded. */
+		void Start();
+		void Stop();
+		inline bool IsRecording() { return detail::recording.load(std::memory_order_relaxed); }
+
+		/** Names the calling thread in the saved traces. */
+		void SetThreadName(const std::string&);
+
+		/** Writes the recorded zones of all threads as a Chrome trace JSON. */
+		void Save(IStream&);
+
+		/** @return The current time in nanoseconds. */
+		std::uint64_t GetTimestamp();
+
+		/** `name` must outlive the profiler, e.g., a string literal. */
+		void RecordZone(const char* name, std::uint64_t begin, std::uint64_t end);
+
+		class Zone {
+			const char* name = nullptr;
+			std::uint64_t begin = 0;
+
+		public:
+			explicit Zone(const char* zoneName) {
+				if (IsRecording()) {
+					name = zoneName;
+					begin = GetTimestamp();
+				}
+			}
+			~Zone() {
+				if (name)
+					RecordZone(name, begin, GetTimestamp());
+			}
+			Zone(const Zone&) = delete;
+			void operator=(const Zone&) = delete;
+		};
+	} // namespace trace
+} // namespace spades
+
+/** Records the rest of the current scope as a zone named `name`. */
+#define SPADES_TRACE_ZONE(name) ::spades::trace::Zone traceZone { name }
@@ -166,6 +166,17 @@ namespace spades {
 			           z + RayLength);
 		}
 
+		void GLAmbientShadowRenderer::GameMapChangedRegion(const IntAABB3& region,
+		                                                   client::GameMap* map) {
+			SPADES_MARK_FUNCTION_DEBUG();
+			if (map != this->map.GetPointerOrNull())
+				return;
+
+			Invalidate(region.min.x - RayLength, region.min.y - RayLength,
+			           region.min.z - RayLength, region.max.x - 1 + RayLength,
+			           region.max.y - 1 + RayLength, region.max.z - 1 + RayLength);
+		}
+
 		void GLAmbientShadowRenderer::Invalidate(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) {
 			SPADES_MARK_FUNCTION_DEBUG();
 			if (minZ < 0)
@@ -97,6 +97,7 @@ namespace spades {
 			float Evaluate(IntVector3);
 
 			void GameMapChanged(int x, int y, int z, client::GameMap*);
+			void GameMapChangedRegion(const IntAABB3&, client::GameMap*);
 
 			void Update();
 
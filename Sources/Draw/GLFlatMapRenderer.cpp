@@ -92,6 +92,19 @@ namespace spades {
 			chunkInvalid[chunkId] = true;
 		}
 
+		void GLFlatMapRenderer::GameMapChangedRegion(const IntAABB3& region, client::GameMap& map) {
+			if (this->map.GetPointerOrNull() != &map)
+				return;
+
+			int cx1 = std::max(region.min.x, 0) >> ChunkBits;
+			int cy1 = std::max(region.min.y, 0) >> ChunkBits;
+			int cx2 = (std::min(region.max.x, map.Width()) - 1) >> ChunkBits;
+			int cy2 = (std::min(region.max.y, map.Height()) - 1) >> ChunkBits;
+			for (int chunkY = cy1; chunkY <= cy2; chunkY++)
+				for (int chunkX = cx1; chunkX <= cx2; chunkX++)
+					chunkInvalid[chunkX + chunkY * chunkCols] = true;
+		}
+
 		void GLFlatMapRenderer::UpdateChunks() {
 			for (size_t i = 0; i < chunkInvalid.size(); i++) {
 				if (!chunkInvalid[i])
@@ -52,6 +52,7 @@ namespace spades {
 			void Draw(const AABB2& dest, const AABB2& src);
 			void UpdateChunks();
 			void GameMapChanged(int x, int y, int z, client::GameMap&);
+			void GameMapChangedRegion(const IntAABB3&, client::GameMap&);
 		};
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
@@ -77,11 +77,8 @@ namespace spades {
 					device.DeleteBuffer(iBuffer);
 					iBuffer = 0;
 				}
-				std::vector<Vertex> i;
-				i.swap(vertices);
-
-				std::vector<uint16_t> i2;
-				i2.swap(indices);
+				MapChunkMesher::Mesh m;
+				std::swap(m, mesh);
 			} else {
 				needsUpdate = true;
 			}
@@ -89,203 +86,54 @@ namespace spades {
 			realized = b;
 		}
 
-		uint8_t GLMapChunk::calcAOID(int x, int y, int z,
-			int ux, int uy, int uz, int vx, int vy, int vz) {
-			int v = 0;
-			if (IsSolid(x - ux, y - uy, z - uz))
-				v |= 1;
-			if (IsSolid(x + ux, y + uy, z + uz))
-				v |= 1 << 1;
-			if (IsSolid(x - vx, y - vy, z - vz))
-				v |= 1 << 2;
-			if (IsSolid(x + vx, y + vy, z + vz))
-				v |= 1 << 3;
-			if (IsSolid(x - ux + vx, y - uy + vy, z - uz + vz))
-				v |= 1 << 4;
-			if (IsSolid(x - ux - vx, y - uy - vy, z - uz - vz))
-				v |= 1 << 5;
-			if (IsSolid(x + ux + vx, y + uy + vy, z + uz + vz))
-				v |= 1 << 6;
-			if (IsSolid(x + ux - vx, y + uy - vy, z + uz - vz))
-				v |= 1 << 7;
-			return (uint8_t)v;
-		}
-
-		/**
-		 * @param aoX Global X coordinate of the cell to evaluate ambient occlusion.
-		 * @param aoY Global Y coordinate of the cell to evaluate ambient occlusion.
-		 * @param aoZ Global Z coordinate of the cell to evaluate ambient occlusion.
-		 * @param x Chunk local X coordinate
-		 * @param y Chunk local Y coordinate
-		 * @param z Chunk local Z coordinate
-		 */
-		void GLMapChunk::EmitVertex(int x, int y, int z, int aoX, int aoY, int aoZ,
-			int ux, int uy, int vx, int vy, uint32_t color, int nx, int ny, int nz) {
-			SPADES_MARK_FUNCTION_DEBUG();
-
-			int uz = (ux == 0 && uy == 0) ? 1 : 0;
-			int vz = (vx == 0 && vy == 0) ? 1 : 0;
-			
-			// evaluate ambient occlusion
-			unsigned int aoID = calcAOID(aoX, aoY, aoZ, ux, uy, uz, vx, vy, vz);
-
-			Vertex inst;
-			if (nz == 1 || ny == 1)
-				inst.shading = 0;
-			else if (nx == 1 || nx == -1)
-				inst.shading = 0; // 50;
-			else if (nz == -1)
-				inst.shading = 220;
-			else
-				inst.shading = 255;
-
-			inst.x = x;
-			inst.y = y;
-			inst.z = z;
-
-			inst.colorRed = (uint8_t)(color);
-			inst.colorGreen = (uint8_t)(color >> 8);
-			inst.colorBlue = (uint8_t)(color >> 16);
-
-			inst.nx = nx;
-			inst.ny = ny;
-			inst.nz = nz;
-
-			// fixed position to avoid self-shadow glitch
-			inst.sx = (x << 1) + ux + vx;
-			inst.sy = (y << 1) + uy + vy;
-			inst.sz = (z << 1) + uz + vz;
-
-			unsigned int aoTexX = (aoID & 15) * 16;
-			unsigned int aoTexY = (aoID >> 4) * 16;
-
-			uint16_t idx = (uint16_t)vertices.size();
-			inst.x = x;
-			inst.y = y;
-			inst.z = z;
-			inst.aoX = aoTexX;
-			inst.aoY = aoTexY;
-			vertices.push_back(inst);
-
-			inst.x = x + ux;
-			inst.y = y + uy;
-			inst.z = z + uz;
-			inst.aoX = aoTexX + 15;
-			inst.aoY = aoTexY;
-			vertices.push_back(inst);
-
-			inst.x = x + vx;
-			inst.y = y + vy;
-			inst.z = z + vz;
-			inst.aoX = aoTexX;
-			inst.aoY = aoTexY + 15;
-			vertices.push_back(inst);
-
-			inst.x = x + ux + vx;
-			inst.y = y + uy + vy;
-			inst.z = z + uz + vz;
-			inst.aoX = aoTexX + 15;
-			inst.aoY = aoTexY + 15;
-			vertices.push_back(inst);
-
-			indices.push_back(idx);
-			indices.push_back(idx + 1);
-			indices.push_back(idx + 2);
-			indices.push_back(idx + 1);
-			indices.push_back(idx + 3);
-			indices.push_back(idx + 2);
+		void GLMapChunk::BuildMesh(const MapChunkMesher& mesher) {
+			mesher.Build(chunkX, chunkY, chunkZ, mesh);
 		}
 
-		bool GLMapChunk::IsSolid(int x, int y, int z) {
-			if (z < 0)
-				return false;
-			if (z >= 64)
-				return true;
-
-			// FIXME: variable map size
-			x &= 511;
-			y &= 511;
-
-			return map->IsSolid(x, y, (z == 63)
-				? (renderer.renderer.GetSettings().r_water ? 62 : 63) : z);
-		}
-
-		void GLMapChunk::Update() {
+		void GLMapChunk::UploadMesh() {
 			SPADES_MARK_FUNCTION();
 
-			vertices.clear();
-			indices.clear();
-			if (buffer) {
-				device.DeleteBuffer(buffer);
-				buffer = 0;
-			}
-			if (iBuffer) {
-				device.DeleteBuffer(iBuffer);
-				iBuffer = 0;
-			}
+			needsUpdate = false;
 
-			int rchunkX = chunkX * Size;
-			int rchunkY = chunkY * Size;
-			int rchunkZ = chunkZ * Size;
-
-			int x, y, z;
-			for (x = 0; x < Size; x++) {
-				for (y = 0; y < Size; y++) {
-					for (z = 0; z < Size; z++) {
-						int xx = x + rchunkX;
-						int yy = y + rchunkY;
-						int zz = z + rchunkZ;
-
-						if (!IsSolid(xx, yy, zz))
-							continue;
-
-						uint32_t col = map->GetColor(xx, yy, zz);
-
-						// damaged block?
-						int health = col >> 24;
-						if (health < 100) {
-							col &= 0xFFFFFF;
-							col &= 0xFEFEFE;
-							col >>= 1;
-						}
-
-						if (!IsSolid(xx, yy, zz + 1))
-							EmitVertex(x + 1, y, z + 1, xx, yy, zz + 1, -1, 0, 0, 1, col, 0, 0, 1);
-						if (!IsSolid(xx, yy, zz - 1))
-							EmitVertex(x, y, z, xx, yy, zz - 1, 1, 0, 0, 1, col, 0, 0, -1);
-						if (!IsSolid(xx - 1, yy, zz))
-							EmitVertex(x, y + 1, z, xx - 1, yy, zz, 0, 0, 0, -1, col, -1, 0, 0);
-						if (!IsSolid(xx + 1, yy, zz))
-							EmitVertex(x + 1, y, z, xx + 1, yy, zz, 0, 0, 0, 1, col, 1, 0, 0);
-						if (!IsSolid(xx, yy - 1, zz))
-							EmitVertex(x, y, z, xx, yy - 1, zz, 0, 0, 1, 0, col, 0, -1, 0);
-						if (!IsSolid(xx, yy + 1, zz))
-							EmitVertex(x + 1, y + 1, z, xx, yy + 1, zz, 0, 0, -1, 0, col, 0, 1, 0);
-					}
+			if (mesh.vertices.empty()) {
+				if (buffer) {
+					device.DeleteBuffer(buffer);
+					buffer = 0;
+				}
+				if (iBuffer) {
+					device.DeleteBuffer(iBuffer);
+					iBuffer = 0;
 				}
-			}
-
-			if (vertices.size() == 0)
 				return;
+			}
 
-			buffer = device.GenBuffer();
+			// reuse the buffer objects; only their contents change
+			if (!buffer)
+				buffer = device.GenBuffer();
 			device.BindBuffer(IGLDevice::ArrayBuffer, buffer);
 
 			device.BufferData(IGLDevice::ArrayBuffer,
-			                  static_cast<IGLDevice::Sizei>(vertices.size() * sizeof(Vertex)),
-			                  vertices.data(), IGLDevice::DynamicDraw);
+			                  static_cast<IGLDevice::Sizei>(mesh.vertices.size() * sizeof(Vertex)),
+			                  mesh.vertices.data(), IGLDevice::DynamicDraw);
 
-			if (!indices.empty()) {
+			if (!iBuffer)
 				iBuffer = device.GenBuffer();
-				device.BindBuffer(IGLDevice::ArrayBuffer, iBuffer);
+			device.BindBuffer(IGLDevice::ArrayBuffer, iBuffer);
 
-				device.BufferData(IGLDevice::ArrayBuffer,
-				                  static_cast<IGLDevice::Sizei>(indices.size() * sizeof(uint16_t)),
-				                  indices.data(), IGLDevice::DynamicDraw);
-			}
+			device.BufferData(
+			  IGLDevice::ArrayBuffer,
+			  static_cast<IGLDevice::Sizei>(mesh.indices.size() * sizeof(uint16_t)),
+			  mesh.indices.data(), IGLDevice::DynamicDraw);
 			device.BindBuffer(IGLDevice::ArrayBuffer, 0);
 		}
 
+		void GLMapChunk::Update() {
+			SPADES_MARK_FUNCTION();
+
+			BuildMesh(renderer.CreateMesher());
+			UploadMesh();
+		}
+
 		void GLMapChunk::RenderDepthPass() {
 			SPADES_MARK_FUNCTION();
 
@@ -340,7 +188,8 @@ namespace spades {
 
 			device.BindBuffer(IGLDevice::ArrayBuffer, 0);
 			device.BindBuffer(IGLDevice::ElementArrayBuffer, iBuffer);
-			device.DrawElements(IGLDevice::Triangles, static_cast<IGLDevice::Sizei>(indices.size()),
+			device.DrawElements(IGLDevice::Triangles,
+			                    static_cast<IGLDevice::Sizei>(mesh.indices.size()),
 			                    IGLDevice::UnsignedShort, NULL);
 			device.BindBuffer(IGLDevice::ElementArrayBuffer, 0);
 		}
@@ -420,7 +269,8 @@ namespace spades {
 
 			device.BindBuffer(IGLDevice::ArrayBuffer, 0);
 			device.BindBuffer(IGLDevice::ElementArrayBuffer, iBuffer);
-			device.DrawElements(IGLDevice::Triangles, static_cast<IGLDevice::Sizei>(indices.size()),
+			device.DrawElements(IGLDevice::Triangles,
+			                    static_cast<IGLDevice::Sizei>(mesh.indices.size()),
 			                    IGLDevice::UnsignedShort, NULL);
 			device.BindBuffer(IGLDevice::ElementArrayBuffer, 0);
 		}
@@ -495,7 +345,7 @@ namespace spades {
 					continue;
 
 				device.DrawElements(IGLDevice::Triangles,
-				                    static_cast<IGLDevice::Sizei>(indices.size()),
+				                    static_cast<IGLDevice::Sizei>(mesh.indices.size()),
 				                    IGLDevice::UnsignedShort, NULL);
 			}
 
@@ -24,6 +24,7 @@
 
 #include "GLDynamicLight.h"
 #include "IGLDevice.h"
+#include "MapChunkMesher.h"
 #include <Client/GameMap.h>
 #include <Client/IRenderer.h>
 #include <Core/Math.h>
@@ -33,23 +34,7 @@ namespace spades {
 		class GLMapRenderer;
 		class IGLDevice;
 		class GLMapChunk {
-			struct Vertex {
-				uint8_t x, y, z;
-				uint8_t pad;
-
-				uint16_t aoX, aoY;
-
-				uint8_t colorRed;
-				uint8_t colorGreen;
-				uint8_t colorBlue;
-				uint8_t shading;
-
-				int8_t nx, ny, nz;
-				uint8_t pad2;
-
-				int8_t sx, sy, sz;
-				uint8_t pad3;
-			};
+			typedef MapChunkMesher::Vertex Vertex;
 
 			GLMapRenderer& renderer;
 			IGLDevice& device;
@@ -60,21 +45,13 @@ namespace spades {
 			Vector3 centerPos;
 			float radius;
 
-			std::vector<Vertex> vertices;
-			std::vector<uint16_t> indices;
+			MapChunkMesher::Mesh mesh;
 			IGLDevice::UInteger buffer;
 			IGLDevice::UInteger iBuffer;
 
 			bool needsUpdate;
 			bool realized;
 
-			uint8_t calcAOID(int x, int y, int z, int ux, int uy, int uz, int vx, int vy, int vz);
-
-			void EmitVertex(int aoX, int aoY, int aoZ, int x, int y, int z, int ux, int uy, int vx,
-			                int vy, uint32_t color, int nx, int ny, int nz);
-
-			bool IsSolid(int x, int y, int z);
-
 			void Update();
 
 		public:
@@ -83,6 +60,12 @@ namespace spades {
 			~GLMapChunk();
 
 			void SetNeedsUpdate() { needsUpdate = true; }
+			bool NeedsUpdate() const { return realized && needsUpdate; }
+
+			/** Regenerates the mesh. Doesn't use GL, and can be called on any thread. */
+			void BuildMesh(const MapChunkMesher&);
+			/** Uploads the mesh generated by `BuildMesh` and clears `NeedsUpdate()`. */
+			void UploadMesh();
 
 			void SetRealized(bool);
 
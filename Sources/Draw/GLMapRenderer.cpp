@@ -33,6 +33,7 @@
 #include <Client/GameMap.h>
 #include <Core/Debug.h>
 #include <Core/Settings.h>
+#include <Core/ThreadPool.h>
 
 namespace spades {
 	namespace draw {
@@ -115,6 +116,23 @@ namespace spades {
 			}
 		}
 
+		void GLMapRenderer::GameMapChangedRegion(const IntAABB3& region, client::GameMap* map) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			// Update the same chunks as `GameMapChanged` would do for every voxel in the
+			// region, i.e., the ones overlapping with the region inflated by one voxel
+			int cx1 = (region.min.x - 1) >> GLMapChunk::SizeBits;
+			int cy1 = (region.min.y - 1) >> GLMapChunk::SizeBits;
+			int cz1 = std::max(region.min.z - 1, 0) >> GLMapChunk::SizeBits;
+			int cx2 = region.max.x >> GLMapChunk::SizeBits;
+			int cy2 = region.max.y >> GLMapChunk::SizeBits;
+			int cz2 = std::min(region.max.z >> GLMapChunk::SizeBits, numChunkDepth - 1);
+			for (int cx = cx1; cx <= cx2; cx++)
+			for (int cy = cy1; cy <= cy2; cy++)
+			for (int cz = cz1; cz <= cz2; cz++)
+				GetChunk(cx & (numChunkWidth - 1), cy & (numChunkHeight - 1), cz)->SetNeedsUpdate();
+		}
+
 		void GLMapRenderer::RealizeChunks(spades::Vector3 eye) {
 			SPADES_MARK_FUNCTION();
 
@@ -130,9 +148,37 @@ namespace spades {
 			}
 		}
 
+		MapChunkMesher GLMapRenderer::CreateMesher() {
+			GLSettings& settings = renderer.GetSettings();
+			return MapChunkMesher(*gameMap, settings.r_water ? true : false,
+			                      settings.r_mapGreedyMeshing);
+		}
+
+		void GLMapRenderer::UpdateChunks() {
+			SPADES_MARK_FUNCTION();
+
+			std::vector<GLMapChunk*> chunksToUpdate;
+			for (int i = 0; i < numChunks; i++)
+				if (chunks[i]->NeedsUpdate())
+					chunksToUpdate.push_back(chunks[i]);
+			if (chunksToUpdate.empty())
+				return;
+
+			// The map is only modified by the main thread, so it stays intact while meshing
+			MapChunkMesher mesher = CreateMesher();
+			ParallelFor(chunksToUpdate.size(), 1, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; i++)
+					chunksToUpdate[i]->BuildMesh(mesher);
+			});
+
+			for (GLMapChunk* c : chunksToUpdate)
+				c->UploadMesh();
+		}
+
 		void GLMapRenderer::Realize() {
 			GLProfiler::Context profiler(renderer.GetGLProfiler(), "Map Chunks");
 			RealizeChunks(renderer.GetSceneDef().viewOrigin);
+			UpdateChunks();
 		}
 
 		void GLMapRenderer::Prerender() {
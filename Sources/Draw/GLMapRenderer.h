@@ -22,6 +22,7 @@
 
 #include "GLDynamicLight.h"
 #include "IGLDevice.h"
+#include "MapChunkMesher.h"
 #include <Client/IGameMapListener.h>
 #include <Client/IRenderer.h>
 #include <Core/Math.h>
@@ -69,6 +70,10 @@ namespace spades {
 			}
 
 			void RealizeChunks(Vector3 eye);
+			/** Meshes the realized chunks that need an update in parallel, and uploads them. */
+			void UpdateChunks();
+
+			MapChunkMesher CreateMesher();
 
 			void DrawColumnDepth(int cx, int cy, int cz, Vector3 eye);
 			void DrawColumnSunlight(int cx, int cy, int cz, Vector3 eye);
@@ -84,6 +89,7 @@ namespace spades {
 			static void PreloadShaders(GLRenderer&);
 
 			void GameMapChanged(int x, int y, int z, client::GameMap*);
+			void GameMapChangedRegion(const IntAABB3&, client::GameMap*);
 
 			client::GameMap* GetMap() { return gameMap; }
 
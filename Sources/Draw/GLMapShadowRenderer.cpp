@@ -23,6 +23,7 @@
 #include "GLRadiosityRenderer.h"
 #include "GLRenderer.h"
 #include "IGLDevice.h"
+#include "RadiosityBaker.h"
 #include <Client/GameMap.h>
 #include <Core/Debug.h>
 
@@ -99,7 +100,9 @@ namespace spades {
 				for (int j = 0; j < 32; j++) {
 					pixels[j] = GeneratePixel(x + j, y);
 					if (bitmap[bitmapPixelPosBase + j] != pixels[j]) {
-						if (radiosity) {
+						// The radiosity renderer checks the initial generation against the
+						// shadow map its cached chunks were baked for by itself
+						if (radiosity && bitmap[bitmapPixelPosBase + j] != 0xffffffffUL) {
 							int dist = pixels[j] >> 24;
 							radiosity->GameMapChanged(x + j, (y + dist) & (h - 1), dist, map);
 
@@ -174,47 +177,8 @@ namespace spades {
 			}
 		}
 
-		static uint32_t BuildPixel(int distance, uint32_t color, bool side) {
-			int r = (uint8_t)(color);
-			int g = (uint8_t)(color >> 8);
-			int b = (uint8_t)(color >> 16);
-
-			r >>= 2;
-			g >>= 2;
-			b >>= 2;
-
-			SPAssert(r < 64);
-			SPAssert(g < 64);
-			SPAssert(b < 64);
-			SPAssert(r >= 0);
-			SPAssert(g >= 0);
-			SPAssert(b >= 0);
-
-			int ex1 = side ? 1 : 0, ex2 = 0, ex3 = 0;
-
-			return r + (g << 8) + (b << 16) + (distance << 24) + (ex1 << 7) + (ex2 << 15) +
-			       (ex3 << 23);
-		}
-
 		uint32_t GLMapShadowRenderer::GeneratePixel(int x, int y) {
-			for (int z = 0; z < d; z++) {
-				// z-plane hit
-				if (map->IsSolid(x, y, z) && z < 63) {
-					return BuildPixel(z, map->GetColor(x, y, z), false);
-					// return (uint8_t)z;
-				}
-
-				y = y + 1;
-				if (y == h)
-					y = 0;
-
-				// y-plane hit
-				if (map->IsSolid(x, y, z) && z < 63) {
-					return BuildPixel(z + 1, map->GetColor(x, y, z), true);
-					// return (uint8_t)z + 1;
-				}
-			}
-			return BuildPixel(64, map->GetColor(x, y == h ? 0 : y, 63), false);
+			return RadiosityBaker::GenerateShadowPixel(*map, x, y);
 		}
 
 		void GLMapShadowRenderer::MarkUpdate(int x, int y) {
@@ -227,5 +191,16 @@ namespace spades {
 			MarkUpdate(x, y - z);
 			MarkUpdate(x, y - z - 1);
 		}
+
+		void GLMapShadowRenderer::GameMapChangedRegion(const IntAABB3 &region,
+		                                               client::GameMap *m) {
+			// The union of the rows marked by `GameMapChanged` for every voxel in the region
+			int minY = region.min.y - (region.max.z - 1) - 1;
+			int maxY = std::min((region.max.y - 1) - region.min.z, minY + h - 1);
+			int maxX = std::min(region.max.x, region.min.x + w);
+			for (int y = minY; y <= maxY; y++)
+				for (int x = region.min.x; x < maxX; x++)
+					MarkUpdate(x, y);
+		}
 	} // namespace draw
 } // namespace spades
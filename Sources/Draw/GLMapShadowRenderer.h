@@ -26,6 +26,7 @@
 #include "IGLDevice.h"
 
 namespace spades {
+	class IntAABB3;
 	namespace client {
 		class GameMap;
 	}
@@ -60,6 +61,7 @@ namespace spades {
 			~GLMapShadowRenderer();
 
 			void GameMapChanged(int x, int y, int z, client::GameMap*);
+			void GameMapChangedRegion(const IntAABB3&, client::GameMap*);
 
 			void Update();
 
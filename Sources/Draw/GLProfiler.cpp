@@ -27,6 +27,8 @@
 #include <ctime>
 #include <functional>
 #include <list>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
 #include "GLProfiler.h"
@@ -52,6 +54,34 @@ namespace spades {
 				auto duration = chrono::high_resolution_clock::now() - startTimePoint;
 				return chrono::duration_cast<chrono::milliseconds>(duration).count() / 1000000.0;
 			}
+
+			/**
+			 * Returns the phase name format without its formatted part, e.g. "Slice" for
+			 * "Slice %d / %d". The returned names live until the program exits, as
+			 * `trace::RecordZone` requires.
+			 */
+			const char* GetTraceZoneName(const char* format) {
+				static std::mutex mutex;
+				static std::unordered_map<const char*, std::string> names;
+
+				std::lock_guard<std::mutex> lock{mutex};
+				auto it = names.find(format);
+				if (it == names.end()) {
+					std::string name = format;
+					std::size_t end = name.find('%');
+					if (end != std::string::npos) {
+						// drop a bracketed argument list, too
+						std::size_t bracket = name.find_last_of("[(", end);
+						if (bracket != std::string::npos)
+							end = bracket;
+						name.resize(end);
+						while (!name.empty() && name.back() == ' ')
+							name.pop_back();
+					}
+					it = names.emplace(format, std::move(name)).first;
+				}
+				return it->second.c_str();
+			}
 		} // namespace
 
 		struct GLProfiler::Measurement {
@@ -551,7 +581,9 @@ namespace spades {
 		}
 
 		GLProfiler::Context::Context(GLProfiler& profiler, const char* format, ...)
-		    : m_profiler{profiler}, m_active{false} {
+		    : m_profiler{profiler},
+		      m_active{false},
+		      m_traceZone{trace::IsRecording() ? GetTraceZoneName(format) : format} {
 			SPADES_MARK_FUNCTION_DEBUG();
 
 			if (!profiler.m_active)
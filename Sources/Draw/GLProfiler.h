@@ -27,6 +27,7 @@
 
 #include "IGLDevice.h"
 #include <Core/Stopwatch.h>
+#include <Core/TraceProfiler.h>
 
 namespace spades {
 	namespace client {
@@ -86,9 +87,18 @@ namespace spades {
 
 			void DrawResult();
 
+			/**
+			 * Measures a phase for the overlay while `r_debugTiming` is enabled, and records
+			 * its CPU time as a trace zone while `trace::IsRecording()`.
+			 *
+			 * `format` must be a string literal. The trace zone is named after its part
+			 * before the first conversion, without the arguments, so that every slice or
+			 * light count shows up as the same zone (e.g. "Slice" for "Slice %d / %d").
+			 */
 			class Context {
 				GLProfiler& m_profiler;
 				bool m_active;
+				trace::Zone m_traceZone;
 
 			public:
 				Context(GLProfiler& profiler, const char* format, ...);
@@ -20,14 +20,17 @@
 
 #include <atomic>
 #include <cstdlib>
+#include <utility>
 
 #include "GLMapShadowRenderer.h"
 #include "GLRadiosityRenderer.h"
 #include "GLRenderer.h"
+#include "RadiosityCache.h"
 #include <Client/GameMap.h>
 
 #include <Core/ConcurrentDispatch.h>
 #include <Core/Settings.h>
+#include <Core/ThreadPool.h>
 #if defined(__APPLE__)
 #if defined(__x86_64__)
 #include <xmmintrin.h>
@@ -41,15 +44,24 @@
 namespace spades {
 	namespace draw {
 		class GLRadiosityRenderer::UpdateDispatch : public ConcurrentDispatch {
+		public:
+			enum class Task { UpdateDirtyChunks, LoadCache, StoreCache };
+
+		private:
 			GLRadiosityRenderer& renderer;
+			Task task;
 
 		public:
 			std::atomic<bool> done{false};
-			UpdateDispatch(GLRadiosityRenderer& r) : renderer(r) {}
+			UpdateDispatch(GLRadiosityRenderer& r, Task task) : renderer(r), task(task) {}
 			void Run() override {
 				SPADES_MARK_FUNCTION();
 
-				renderer.UpdateDirtyChunks();
+				switch (task) {
+					case Task::UpdateDirtyChunks: renderer.UpdateDirtyChunks(); break;
+					case Task::LoadCache: renderer.LoadCache(); break;
+					case Task::StoreCache: renderer.StoreCache(); break;
+				}
 
 				done = true;
 			}
@@ -69,20 +81,9 @@ namespace spades {
 
 			chunks = std::vector<Chunk>{static_cast<std::size_t>(chunkW * chunkH * chunkD)};
 
-			for (const auto& c : chunks) {
-				uint32_t* data;
-
-				data = (uint32_t*)c.dataFlat;
-				std::fill(data, data + ChunkSize * ChunkSize * ChunkSize, 0x20080200);
-
-				data = (uint32_t*)c.dataX;
-				std::fill(data, data + ChunkSize * ChunkSize * ChunkSize, 0x20080200);
-
-				data = (uint32_t*)c.dataY;
-				std::fill(data, data + ChunkSize * ChunkSize * ChunkSize, 0x20080200);
-
-				data = (uint32_t*)c.dataZ;
-				std::fill(data, data + ChunkSize * ChunkSize * ChunkSize, 0x20080200);
+			for (auto& c : chunks) {
+				uint32_t* data = &c.data.flat[0][0][0];
+				std::fill(data, data + sizeof(c.data) / sizeof(uint32_t), 0x20080200);
 			}
 
 			for (int x = 0; x < chunkW; x++)
@@ -139,6 +140,17 @@ namespace spades {
 			dispatch = NULL;
 
 			SPLog("Chunk texture initialized");
+
+			const bool highPrecision = (int)settings.r_radiosity >= 2;
+			GLMapShadowRenderer* shadowmap = renderer.mapShadowRenderer;
+			baker.reset(new RadiosityBaker(shadowmap->bitmap.data(), w, h, highPrecision));
+
+			cacheStored = true;
+			loadingCache = RadiosityCache::IsEnabled();
+			if (loadingCache) {
+				dispatch = new UpdateDispatch(*this, UpdateDispatch::Task::LoadCache);
+				dispatch->Start();
+			}
 		}
 
 		GLRadiosityRenderer::~GLRadiosityRenderer() {
@@ -155,117 +167,14 @@ namespace spades {
 			device.DeleteTexture(textureZ);
 		}
 
-		GLRadiosityRenderer::Result GLRadiosityRenderer::Evaluate(IntVector3 ipos) {
-			SPADES_MARK_FUNCTION_DEBUG();
-
-			GLRadiosityRenderer::Result result;
-			result.base = MakeVector3(0, 0, 0);
-			result.x = MakeVector3(0, 0, 0);
-			result.y = MakeVector3(0, 0, 0);
-			result.z = MakeVector3(0, 0, 0);
-
-			Vector3 pos = MakeVector3(ipos) + 0.5F;
-
-			GLMapShadowRenderer* shadowmap = renderer.mapShadowRenderer;
-			uint32_t* bitmap = shadowmap->bitmap.data();
-			int centerX = ipos.x;
-			int centerY = ipos.y - ipos.z;
-			const int yMask = h - 1;
-			const int pitch = w;
-
-			for (int x = -Envelope; x <= Envelope; x++) {
-				uint32_t* column = bitmap + ((centerX + x) & (w - 1));
-				for (int y = -Envelope; y <= Envelope; y++) {
-					uint32_t pixel = column[pitch * ((centerY + y) & yMask)];
-					int depth = pixel >> 24;
-
-					// shadowmap pixel's world coord
-					int wx = centerX + x;
-					int wy = centerY + y + depth;
-					int wz = depth;
-
-					// if true, this is negative-y faced plane
-					// if false, this is negative-z faced plane
-					bool isSide = (pixel & 0x80) != 0;
-
-					// direction dependent process
-					Vector3 center; // center of face
-					Vector3 diff;   // pos - center
-					float diffDot;  // dot(diff, normal)
-					if (isSide) {
-						// normal cull
-						if (wy <= ipos.y)
-							continue;
-
-						center.x = wx + 0.5F;
-						center.y = (float)wy;
-						center.z = wz - 0.5F;
-
-						diff = pos - center;
-						diffDot = -diff.y;
-					} else {
-						if (wz <= ipos.z)
-							continue;
-
-						center.x = wx + 0.5F;
-						center.y = wy + 0.5F;
-						center.z = (float)wz;
-
-						diff = pos - center;
-						diffDot = -diff.z;
-					}
-
-					SPAssert(diffDot >= 0.0F);
-
-					float diffLen = diff.GetLength();
-					float invDiffLen = 1.0F / diffLen;
-					float invDiffLenSmooth = 1.0F / ((diffLen) + 0.4F);
-
-					// fall-off because of direciton
-					float intensity = diffDot * invDiffLen;
-
-					// 1/(r^2) distance fall-off
-					intensity *= invDiffLenSmooth;
-					intensity *= invDiffLenSmooth;
-
-					// normalize
-					Vector3 normDiff = diff * -invDiffLen;
-
-					// extract shadowmap color
-					float red = static_cast<float>((pixel) & 0x3F);
-					float green = static_cast<float>((pixel >> 8) & 0x3F);
-					float blue = static_cast<float>((pixel >> 16) & 0x3F);
-
-					Vector3 color = {red, green, blue};
-					color *= intensity;
-
-					// add to result
-					result.base += color;
-					result.x += color * normDiff.x;
-					result.y += color * normDiff.y;
-					result.z += color * normDiff.z;
-
-					SPAssert(!std::isnan(intensity));
-					SPAssert(intensity >= 0.0F);
-					SPAssert(red >= 0.0F && red < 64.0F);
-					SPAssert(green >= 0.0F && green < 64.0F);
-					SPAssert(blue >= 0.0F && blue < 64.0F);
-				}
-			}
-
-			float scale = 0.1F / 64.0F;
-			result.base *= scale;
-			result.x *= scale;
-			result.y *= scale;
-			result.z *= scale;
-
-			return result;
-		}
-
 		void GLRadiosityRenderer::GameMapChanged(int x, int y, int z, client::GameMap* map) {
 			SPADES_MARK_FUNCTION_DEBUG();
 			if (map != this->map)
 				return;
+			// `LoadCache` is writing the chunks. The changes are found by comparing the shadow
+			// maps once it's done.
+			if (loadingCache)
+				return;
 
 			Invalidate(x - Envelope, y - Envelope, z - Envelope, x + Envelope, y + Envelope,
 			           z + Envelope);
@@ -331,14 +240,65 @@ namespace spades {
 			return cnt;
 		}
 
+		void GLRadiosityRenderer::InvalidateStaleCachedChunks() {
+			SPADES_MARK_FUNCTION();
+
+			// The map may have changed since `LoadCache` generated its shadow map. The changes
+			// during the load weren't reported, and neither is the initial generation of the
+			// live shadow map.
+			const std::vector<uint32_t>& bitmap = renderer.mapShadowRenderer->bitmap;
+			SPAssert(bitmap.size() == cachedShadowBitmap.size());
+			for (int y = 0; y < h; y++) {
+				for (int x = 0; x < w; x++) {
+					uint32_t oldPixel = cachedShadowBitmap[x + y * w];
+					uint32_t newPixel = bitmap[x + y * w];
+					if (oldPixel == newPixel)
+						continue;
+
+					int dist = newPixel >> 24;
+					GameMapChanged(x, (y + dist) & (h - 1), dist, map);
+
+					dist = oldPixel >> 24;
+					GameMapChanged(x, (y + dist) & (h - 1), dist, map);
+				}
+			}
+
+			std::vector<uint32_t>().swap(cachedShadowBitmap);
+		}
+
 		void GLRadiosityRenderer::Update() {
-			if (GetNumDirtyChunks() > 0 && (dispatch == NULL || dispatch->done.load())) {
-				if (dispatch) {
-					dispatch->Join();
-					delete dispatch;
+			if (loadingCache) {
+				// Nothing is baked or uploaded until then
+				if (!dispatch->done.load())
+					return;
+				loadingCache = false;
+			}
+
+			if (!cachedShadowBitmap.empty())
+				InvalidateStaleCachedChunks();
+
+			if (dispatch == NULL || dispatch->done.load()) {
+				bool storeCache = false;
+				int numDirtyChunks = GetNumDirtyChunks();
+				if (numDirtyChunks == 0 && !cacheStored) {
+					// The bake is complete. Store it unless the map has changed since it was
+					// loaded
+					std::vector<uint32_t>& bitmap = renderer.mapShadowRenderer->bitmap;
+					storeCache = RadiosityCache::ComputeKey(bitmap, baker->IsHighPrecision()) ==
+					             cacheKey;
+					cacheStored = true;
+				}
+
+				if (numDirtyChunks > 0 || storeCache) {
+					if (dispatch) {
+						dispatch->Join();
+						delete dispatch;
+					}
+					dispatch = new UpdateDispatch(
+					  *this, storeCache ? UpdateDispatch::Task::StoreCache
+					                    : UpdateDispatch::Task::UpdateDirtyChunks);
+					dispatch->Start();
 				}
-				dispatch = new UpdateDispatch(*this);
-				dispatch->Start();
 			}
 
 			int cnt = 0;
@@ -355,25 +315,25 @@ namespace spades {
 					device.TexSubImage3D(IGLDevice::Texture3D, 0, c.cx * ChunkSize,
 					                     c.cy * ChunkSize, c.cz * ChunkSize, ChunkSize, ChunkSize,
 					                     ChunkSize, IGLDevice::BGRA,
-					                     IGLDevice::UnsignedInt2101010Rev, c.dataFlat);
+					                     IGLDevice::UnsignedInt2101010Rev, c.data.flat);
 
 					device.BindTexture(IGLDevice::Texture3D, textureX);
 					device.TexSubImage3D(IGLDevice::Texture3D, 0, c.cx * ChunkSize,
 					                     c.cy * ChunkSize, c.cz * ChunkSize, ChunkSize, ChunkSize,
 					                     ChunkSize, IGLDevice::BGRA,
-					                     IGLDevice::UnsignedInt2101010Rev, c.dataX);
+					                     IGLDevice::UnsignedInt2101010Rev, c.data.x);
 
 					device.BindTexture(IGLDevice::Texture3D, textureY);
 					device.TexSubImage3D(IGLDevice::Texture3D, 0, c.cx * ChunkSize,
 					                     c.cy * ChunkSize, c.cz * ChunkSize, ChunkSize, ChunkSize,
 					                     ChunkSize, IGLDevice::BGRA,
-					                     IGLDevice::UnsignedInt2101010Rev, c.dataY);
+					                     IGLDevice::UnsignedInt2101010Rev, c.data.y);
 
 					device.BindTexture(IGLDevice::Texture3D, textureZ);
 					device.TexSubImage3D(IGLDevice::Texture3D, 0, c.cx * ChunkSize,
 					                     c.cy * ChunkSize, c.cz * ChunkSize, ChunkSize, ChunkSize,
 					                     ChunkSize, IGLDevice::BGRA,
-					                     IGLDevice::UnsignedInt2101010Rev, c.dataZ);
+					                     IGLDevice::UnsignedInt2101010Rev, c.data.z);
 				}
 			}
 		}
@@ -420,82 +380,64 @@ namespace spades {
 				}
 			}
 
-			// limit update count per frame
-			for (int i = 0; i < 8; i++) {
-				if (numDirtyChunks <= 0)
-					break;
-
+			// limit update count per frame. Each participant of the thread pool bakes 8 chunks
+			int maxChunks = 8 * ThreadPool::GetInstance().GetNumParticipants();
+			std::vector<Chunk*> chunksToUpdate;
+			while (numDirtyChunks > 0 && static_cast<int>(chunksToUpdate.size()) < maxChunks) {
 				int idx = SampleRandomInt(0, numDirtyChunks - 1);
-				Chunk& c = chunks[dirtyChunkIds[idx]];
+				chunksToUpdate.push_back(&chunks[dirtyChunkIds[idx]]);
 
 				// remove from list (fast)
 				if (idx < numDirtyChunks - 1)
 					std::swap(dirtyChunkIds[idx], dirtyChunkIds[numDirtyChunks - 1]);
 				numDirtyChunks--;
+			}
 
-				UpdateChunk(c.cx, c.cy, c.cz);
+			// One chunk per participant at a time, so that the renderer's loops don't wait for
+			// all of them
+			std::size_t numParticipants = ThreadPool::GetInstance().GetNumParticipants();
+			for (std::size_t first = 0; first < chunksToUpdate.size(); first += numParticipants) {
+				std::size_t count = std::min(numParticipants, chunksToUpdate.size() - first);
+				ParallelFor(count, 1, [&](std::size_t begin, std::size_t end) {
+					for (std::size_t i = begin; i < end; i++) {
+						Chunk& c = *chunksToUpdate[first + i];
+						UpdateChunk(c.cx, c.cy, c.cz);
+					}
+				});
 			}
 		}
 
-		float GLRadiosityRenderer::CompressDynamicRange(float v) {
-			if ((int)settings.r_radiosity >= 2)
-				return v;
-			if (v >= 0.0F)
-				return sqrtf(v);
-			else
-				return -sqrtf(-v);
+		void GLRadiosityRenderer::LoadCache() {
+			// The shadow map isn't generated until the first frame, so compute it here. The map
+			// may be modified meanwhile, but then the shadow maps differ and the affected
+			// chunks are invalidated.
+			std::vector<uint32_t> bitmap;
+			RadiosityBaker::GenerateShadowBitmap(*map, bitmap);
+			cacheKey = RadiosityCache::ComputeKey(bitmap, baker->IsHighPrecision());
+
+			std::vector<RadiosityBaker::ChunkData*> data;
+			for (Chunk& c : chunks)
+				data.push_back(&c.data);
+
+			// On failure, the chunks may be partially overwritten, but they are never uploaded
+			// before being baked as a whole
+			cacheStored = RadiosityCache::Load(cacheKey, data);
+			if (!cacheStored)
+				return;
+
+			for (Chunk& c : chunks) {
+				c.dirty = false;
+				c.transferDone = false;
+			}
+			cachedShadowBitmap = std::move(bitmap);
 		}
 
-		uint32_t GLRadiosityRenderer::EncodeValue(Vector3 vec) {
-			float v;
-			int iv;
-			unsigned int out = 0xC0000000;
-
-			vec.x = CompressDynamicRange(vec.x);
-			vec.y = CompressDynamicRange(vec.y);
-			vec.z = CompressDynamicRange(vec.z);
-
-			vec *= 0.5F;
-			vec += 0.5F;
-			vec *= 1022.0F / 1023.0F;
-
-			v = vec.x * 1023.0F + 0.5F;
-			if (v > 1023.2F)
-				v = 1023.2F;
-			if (v < 0.0F)
-				v = 0.0F;
-			iv = (unsigned int)v;
-			if (iv > 1023)
-				iv = 1023;
-			if (iv < 0)
-				iv = 0;
-			out |= iv << 20;
-
-			v = vec.y * 1023.0F + 0.5F;
-			if (v > 1023.2F)
-				v = 1023.2F;
-			if (v < 0.0F)
-				v = 0.0F;
-			iv = (unsigned int)v;
-			if (iv > 1023)
-				iv = 1023;
-			if (iv < 0)
-				iv = 0;
-			out |= iv << 10;
-
-			v = vec.z * 1023.0F + 0.5F;
-			if (v > 1023.2F)
-				v = 1023.2F;
-			if (v < 0.0F)
-				v = 0.0F;
-			iv = (unsigned int)v;
-			if (iv > 1023)
-				iv = 1023;
-			if (iv < 0)
-				iv = 0;
-			out |= iv;
-
-			return (uint32_t)out;
+		void GLRadiosityRenderer::StoreCache() {
+			// Only the dispatch thread modifies the chunk data
+			std::vector<const RadiosityBaker::ChunkData*> data;
+			for (const Chunk& c : chunks)
+				data.push_back(&c.data);
+			RadiosityCache::Store(cacheKey, data);
 		}
 
 		void GLRadiosityRenderer::UpdateChunk(int cx, int cy, int cz) {
@@ -503,24 +445,8 @@ namespace spades {
 			if (!c.dirty)
 				return;
 
-			int originX = cx * ChunkSize;
-			int originY = cy * ChunkSize;
-			int originZ = cz * ChunkSize;
-
-			for (int z = c.dirtyMinZ; z <= c.dirtyMaxZ; z++)
-			for (int y = c.dirtyMinY; y <= c.dirtyMaxY; y++)
-			for (int x = c.dirtyMinX; x <= c.dirtyMaxX; x++) {
-				IntVector3 pos;
-				pos.x = (x + originX);
-				pos.y = (y + originY);
-				pos.z = (z + originZ);
-
-				Result res = Evaluate(pos);
-				c.dataFlat[z][y][x] = EncodeValue(res.base);
-				c.dataX[z][y][x] = EncodeValue(res.x);
-				c.dataY[z][y][x] = EncodeValue(res.y);
-				c.dataZ[z][y][x] = EncodeValue(res.z);
-			}
+			baker->BakeChunk(cx, cy, cz, IntVector3::Make(c.dirtyMinX, c.dirtyMinY, c.dirtyMinZ),
+			                 IntVector3::Make(c.dirtyMaxX, c.dirtyMaxY, c.dirtyMaxZ), c.data);
 
 			c.dirty = false;
 			c.transferDone = false;
@@ -22,9 +22,11 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "IGLDevice.h"
+#include "RadiosityBaker.h"
 #include <Core/Debug.h>
 #include <Core/Math.h>
 
@@ -38,10 +40,12 @@ namespace spades {
 		class GLSettings;
 		class GLRadiosityRenderer {
 
-			typedef uint32_t VoxelType;
-
 			class UpdateDispatch;
-			enum { ChunkSize = 16, ChunkSizeBits = 4, Envelope = 6 };
+			enum {
+				ChunkSize = RadiosityBaker::ChunkSize,
+				ChunkSizeBits = RadiosityBaker::ChunkSizeBits,
+				Envelope = RadiosityBaker::Envelope
+			};
 			GLRenderer &renderer;
 			IGLDevice &device;
 			GLSettings &settings;
@@ -49,10 +53,7 @@ namespace spades {
 
 			struct Chunk {
 				int cx, cy, cz;
-				VoxelType dataFlat[ChunkSize][ChunkSize][ChunkSize];
-				VoxelType dataX[ChunkSize][ChunkSize][ChunkSize];
-				VoxelType dataY[ChunkSize][ChunkSize][ChunkSize];
-				VoxelType dataZ[ChunkSize][ChunkSize][ChunkSize];
+				RadiosityBaker::ChunkData data;
 				bool dirty = true;
 				int dirtyMinX = 0, dirtyMaxX = ChunkSize - 1;
 				int dirtyMinY = 0, dirtyMaxY = ChunkSize - 1;
@@ -71,6 +72,27 @@ namespace spades {
 
 			std::vector<Chunk> chunks;
 
+			std::unique_ptr<RadiosityBaker> baker;
+
+			/**
+			 * The `RadiosityCache` key of the map when it was loaded. The bake is stored in the
+			 * cache once it's complete, unless the map changed.
+			 */
+			uint32_t cacheKey;
+			bool cacheStored;
+
+			/**
+			 * `true` until `LoadCache` has finished on `dispatch`. The chunks belong to it
+			 * meanwhile.
+			 */
+			bool loadingCache;
+
+			/**
+			 * The shadow map the loaded cache entry was baked for. It's compared against the
+			 * live shadow map on the first update after loading, then released.
+			 */
+			std::vector<uint32_t> cachedShadowBitmap;
+
 			inline Chunk &GetChunk(int cx, int cy, int cz) {
 				SPAssert(cx >= 0);
 				SPAssert(cx < chunkW);
@@ -91,22 +113,18 @@ namespace spades {
 			void UpdateChunk(int cx, int cy, int cz);
 			void UpdateDirtyChunks();
 			int GetNumDirtyChunks();
+			void InvalidateStaleCachedChunks();
 
-			uint32_t EncodeValue(Vector3 vec);
-			float CompressDynamicRange(float v);
+			/** Computes `cacheKey`, and loads the cache entry into the chunks if it exists. */
+			void LoadCache();
+			void StoreCache();
 
 			UpdateDispatch *dispatch;
 
 		public:
-			struct Result {
-				Vector3 base, x, y, z;
-			};
-
 			GLRadiosityRenderer(GLRenderer &renderer, client::GameMap *map);
 			~GLRadiosityRenderer();
 
-			Result Evaluate(IntVector3);
-
 			void GameMapChanged(int x, int y, int z, client::GameMap *);
 
 			void Update();
@@ -1326,6 +1326,19 @@ namespace spades {
 				ambientShadowRenderer->GameMapChanged(x, y, z, map);
 		}
 
+		void GLRenderer::GameMapChangedRegion(const IntAABB3& region, client::GameMap* map) {
+			if (mapRenderer)
+				mapRenderer->GameMapChangedRegion(region, map);
+			if (flatMapRenderer)
+				flatMapRenderer->GameMapChangedRegion(region, *map);
+			if (mapShadowRenderer)
+				mapShadowRenderer->GameMapChangedRegion(region, map);
+			if (waterRenderer)
+				waterRenderer->GameMapChangedRegion(region, map);
+			if (ambientShadowRenderer)
+				ambientShadowRenderer->GameMapChangedRegion(region, map);
+		}
+
 		bool GLRenderer::BoxFrustrumCull(const AABB3& box) {
 			if (renderingMirror) {
 				// reflect
@@ -241,6 +241,7 @@ namespace spades {
 			bool IsRenderingMirror() const { return renderingMirror; }
 
 			void GameMapChanged(int x, int y, int z, client::GameMap*) override;
+			void GameMapChangedRegion(const IntAABB3&, client::GameMap*) override;
 
 			const client::SceneDefinition& GetSceneDef() const { return sceneDef; }
 
@@ -49,6 +49,7 @@ DEFINE_SPADES_SETTING(r_hdrGamma, "2.2");
 DEFINE_SPADES_SETTING(r_highPrec, "1");
 DEFINE_SPADES_SETTING(r_lensFlare, "1");
 DEFINE_SPADES_SETTING(r_lensFlareDynamic, "1");
+DEFINE_SPADES_SETTING(r_mapGreedyMeshing, "0");
 DEFINE_SPADES_SETTING(r_maxAnisotropy, "8");
 DEFINE_SPADES_SETTING(r_modelShadows, "1");
 DEFINE_SPADES_SETTING(r_multisamples, "0");
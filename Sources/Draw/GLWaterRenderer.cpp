@@ -952,5 +952,15 @@ namespace spades {
 				return;
 			MarkUpdate(x, y);
 		}
+
+		void GLWaterRenderer::GameMapChangedRegion(const IntAABB3& region, client::GameMap* map) {
+			if (map != this->map)
+				return;
+			if (region.max.z <= 63)
+				return;
+			for (int y = region.min.y; y < region.max.y; y++)
+				for (int x = region.min.x; x < region.max.x; x++)
+					MarkUpdate(x, y);
+		}
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
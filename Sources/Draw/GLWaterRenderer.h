@@ -26,6 +26,7 @@
 #include "IGLDevice.h"
 
 namespace spades {
+	class IntAABB3;
 	namespace client {
 		class GameMap;
 	}
@@ -83,6 +84,7 @@ namespace spades {
 			void Update(float dt);
 
 			void GameMapChanged(int x, int y, int z, client::GameMap *);
+			void GameMapChangedRegion(const IntAABB3 &, client::GameMap *);
 
 			IGLDevice::UInteger GetOcclusionQuery() { return occlusionQuery; }
 		};
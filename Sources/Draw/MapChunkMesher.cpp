@@ -0,0 +1,315 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <array>
+#include <memory>
+
+#include "MapChunkMesher.h"
+#include <Client/GameMap.h>
+#include <Core/Debug.h>
+
+namespace spades {
+	namespace draw {
+		namespace {
+			/** A face direction, in the order the faces of a voxel are emitted. */
+			struct FaceDirection {
+				/** The first vertex, relative to the voxel. */
+				int origin[3];
+				/** The edges of the face. `normal` is also the offset of the AO cell. */
+				int u[3], v[3];
+				int normal[3];
+				uint8_t shading;
+			};
+
+			const FaceDirection faceDirections[6] = {
+			  {{1, 0, 1}, {-1, 0, 0}, {0, 1, 0}, {0, 0, 1}, 0},
+			  {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, -1}, 220},
+			  {{0, 1, 0}, {0, 0, 1}, {0, -1, 0}, {-1, 0, 0}, 0},
+			  {{1, 0, 0}, {0, 0, 1}, {0, 1, 0}, {1, 0, 0}, 0},
+			  {{0, 0, 0}, {0, 0, 1}, {1, 0, 0}, {0, -1, 0}, 255},
+			  {{1, 1, 0}, {0, 0, 1}, {-1, 0, 0}, {0, 1, 0}, 0},
+			};
+
+			/** Cells below the map are empty, and cells above the map are solid. */
+			inline bool TestBit(uint64_t column, int z) {
+				if (z < 0)
+					return false;
+				if (z >= 64)
+					return true;
+				return ((column >> z) & 1) != 0;
+			}
+
+			/**
+			 * The solid map around a column. `columns[dx + 1][dy + 1]` is the column at
+			 * `(x + dx, y + dy)`.
+			 */
+			struct ColumnNeighborhood {
+				uint64_t columns[3][3];
+
+				bool IsSolid(int dx, int dy, int z) const {
+					return TestBit(columns[dx + 1][dy + 1], z);
+				}
+
+				/** The bit order matches the tiles of the ambient occlusion texture. */
+				uint8_t GetAOID(int x, int y, int z, const int* u, const int* v) const {
+					int ao = 0;
+					if (IsSolid(x - u[0], y - u[1], z - u[2]))
+						ao |= 1;
+					if (IsSolid(x + u[0], y + u[1], z + u[2]))
+						ao |= 1 << 1;
+					if (IsSolid(x - v[0], y - v[1], z - v[2]))
+						ao |= 1 << 2;
+					if (IsSolid(x + v[0], y + v[1], z + v[2]))
+						ao |= 1 << 3;
+					if (IsSolid(x - u[0] + v[0], y - u[1] + v[1], z - u[2] + v[2]))
+						ao |= 1 << 4;
+					if (IsSolid(x - u[0] - v[0], y - u[1] - v[1], z - u[2] - v[2]))
+						ao |= 1 << 5;
+					if (IsSolid(x + u[0] + v[0], y + u[1] + v[1], z + u[2] + v[2]))
+						ao |= 1 << 6;
+					if (IsSolid(x + u[0] - v[0], y + u[1] - v[1], z + u[2] - v[2]))
+						ao |= 1 << 7;
+					return (uint8_t)ao;
+				}
+			};
+
+			/**
+			 * Emits a quad spanning `origin + [0, 1] * edgeU + [0, 1] * edgeV`.
+			 * @param origin Chunk local coordinate of the first vertex.
+			 */
+			void EmitQuad(MapChunkMesher::Mesh& mesh, const int* origin, const int* edgeU,
+			              const int* edgeV, unsigned int aoID, uint32_t color,
+			              const FaceDirection& dir) {
+				MapChunkMesher::Vertex inst;
+				inst.pad = inst.pad2 = inst.pad3 = 0;
+				inst.shading = dir.shading;
+
+				inst.colorRed = (uint8_t)(color);
+				inst.colorGreen = (uint8_t)(color >> 8);
+				inst.colorBlue = (uint8_t)(color >> 16);
+
+				inst.nx = dir.normal[0];
+				inst.ny = dir.normal[1];
+				inst.nz = dir.normal[2];
+
+				// fixed position to avoid self-shadow glitch
+				inst.sx = (origin[0] << 1) + edgeU[0] + edgeV[0];
+				inst.sy = (origin[1] << 1) + edgeU[1] + edgeV[1];
+				inst.sz = (origin[2] << 1) + edgeU[2] + edgeV[2];
+
+				unsigned int aoTexX = (aoID & 15) * 16;
+				unsigned int aoTexY = (aoID >> 4) * 16;
+
+				uint16_t idx = (uint16_t)mesh.vertices.size();
+				for (int i = 0; i < 4; i++) {
+					int su = i & 1, sv = i >> 1;
+					inst.x = origin[0] + edgeU[0] * su + edgeV[0] * sv;
+					inst.y = origin[1] + edgeU[1] * su + edgeV[1] * sv;
+					inst.z = origin[2] + edgeU[2] * su + edgeV[2] * sv;
+					inst.aoX = aoTexX + 15 * su;
+					inst.aoY = aoTexY + 15 * sv;
+					mesh.vertices.push_back(inst);
+				}
+
+				mesh.indices.push_back(idx);
+				mesh.indices.push_back(idx + 1);
+				mesh.indices.push_back(idx + 2);
+				mesh.indices.push_back(idx + 1);
+				mesh.indices.push_back(idx + 3);
+				mesh.indices.push_back(idx + 2);
+			}
+
+			/**
+			 * Collects the faces without ambient occlusion so they can be merged into larger
+			 * quads. A cell holds `color | 1 << 24` or zero if there's no face to merge.
+			 */
+			class GreedyFaceGrid {
+				enum { Size = MapChunkMesher::Size };
+				std::vector<uint32_t> cells;
+				/** The faces added to `cells`, as `(dir, x, y, z)`. */
+				std::vector<std::array<int8_t, 4>> faces;
+
+				static std::size_t Index(int dir, int x, int y, int z) {
+					return (((std::size_t)dir * Size + x) * Size + y) * Size + z;
+				}
+
+			public:
+				GreedyFaceGrid() : cells(6 * Size * Size * Size, 0) {}
+
+				void Add(int dir, int x, int y, int z, uint32_t color) {
+					cells[Index(dir, x, y, z)] = (color & 0xffffff) | (1U << 24);
+					faces.push_back({{(int8_t)dir, (int8_t)x, (int8_t)y, (int8_t)z}});
+				}
+
+				void Emit(MapChunkMesher::Mesh& mesh) {
+					// faces already merged into a rectangle are skipped by `EmitRect`
+					for (const auto& f : faces)
+						EmitRect(mesh, f[0], faceDirections[f[0]], f[1], f[2], f[3]);
+				}
+
+			private:
+				uint32_t& At(int dir, int x, int y, int z, int steps, const int* step) {
+					return cells[Index(dir, x + step[0] * steps, y + step[1] * steps,
+					                   z + step[2] * steps)];
+				}
+
+				static bool IsInside(int x, int y, int z) {
+					return x >= 0 && y >= 0 && z >= 0 && x < Size && y < Size && z < Size;
+				}
+
+				/** Grows a rectangle from the cell along `u` first, then along `v`. */
+				void EmitRect(MapChunkMesher::Mesh& mesh, int dir, const FaceDirection& fd,
+				              int x, int y, int z) {
+					uint32_t key = cells[Index(dir, x, y, z)];
+					if (key == 0)
+						return;
+
+					const int* u = fd.u;
+					const int* v = fd.v;
+
+					int lenU = 1;
+					while (IsInside(x + u[0] * lenU, y + u[1] * lenU, z + u[2] * lenU) &&
+					       At(dir, x, y, z, lenU, u) == key)
+						lenU++;
+
+					int lenV = 1;
+					for (;; lenV++) {
+						int rx = x + v[0] * lenV, ry = y + v[1] * lenV, rz = z + v[2] * lenV;
+						if (!IsInside(rx, ry, rz))
+							break;
+						int i = 0;
+						while (i < lenU && At(dir, rx, ry, rz, i, u) == key)
+							i++;
+						if (i < lenU)
+							break;
+					}
+
+					for (int j = 0; j < lenV; j++) {
+						int rx = x + v[0] * j, ry = y + v[1] * j, rz = z + v[2] * j;
+						for (int i = 0; i < lenU; i++)
+							At(dir, rx, ry, rz, i, u) = 0;
+					}
+
+					int origin[3] = {x + fd.origin[0], y + fd.origin[1], z + fd.origin[2]};
+					int edgeU[3] = {u[0] * lenU, u[1] * lenU, u[2] * lenU};
+					int edgeV[3] = {v[0] * lenV, v[1] * lenV, v[2] * lenV};
+					EmitQuad(mesh, origin, edgeU, edgeV, 0, key, fd);
+				}
+			};
+		} // namespace
+
+		MapChunkMesher::MapChunkMesher(const client::GameMap& map, bool water, bool greedy)
+		    : map(map), water(water), greedy(greedy) {}
+
+		uint64_t MapChunkMesher::GetColumn(int x, int y) const {
+			// FIXME: variable map size
+			uint64_t column = map.GetSolidMapWrapped(x, y);
+			if (water) {
+				// the water surface is drawn by `GLWaterRenderer`; draw the bottom layer
+				// as the layer above it
+				column &= ~(1ULL << 63);
+				column |= ((column >> 62) & 1ULL) << 63;
+			}
+			return column;
+		}
+
+		void MapChunkMesher::Build(int cx, int cy, int cz, Mesh& mesh) const {
+			SPADES_MARK_FUNCTION();
+
+			mesh.Clear();
+
+			std::unique_ptr<GreedyFaceGrid> grid;
+			if (greedy)
+				grid.reset(new GreedyFaceGrid());
+
+			int rchunkX = cx * Size;
+			int rchunkY = cy * Size;
+			int rchunkZ = cz * Size;
+			const uint64_t chunkMask = 0xffffULL << rchunkZ;
+
+			ColumnNeighborhood nb;
+			for (int x = 0; x < Size; x++) {
+				for (int y = 0; y < Size; y++) {
+					int xx = x + rchunkX;
+					int yy = y + rchunkY;
+
+					for (int dx = 0; dx < 3; dx++)
+						for (int dy = 0; dy < 3; dy++)
+							nb.columns[dx][dy] = GetColumn(xx + dx - 1, yy + dy - 1);
+
+					// the exposed faces of every voxel in the column, in the order of
+					// `faceDirections`
+					const uint64_t column = nb.columns[1][1];
+					uint64_t exposed[6] = {
+					  column & ~((column >> 1) | (1ULL << 63)),
+					  column & ~(column << 1),
+					  column & ~nb.columns[0][1],
+					  column & ~nb.columns[2][1],
+					  column & ~nb.columns[1][0],
+					  column & ~nb.columns[1][2],
+					};
+
+					uint64_t any = 0;
+					for (uint64_t e : exposed)
+						any |= e;
+					any &= chunkMask;
+
+					uint64_t bits = any >> rchunkZ;
+					for (int z = 0; bits != 0; z++, bits >>= 1) {
+						if (!(bits & 1))
+							continue;
+
+						int zz = z + rchunkZ;
+						uint32_t col = map.GetColor(xx, yy, zz);
+
+						// damaged block?
+						int health = col >> 24;
+						if (health < 100) {
+							col &= 0xFFFFFF;
+							col &= 0xFEFEFE;
+							col >>= 1;
+						}
+
+						for (int dir = 0; dir < 6; dir++) {
+							if (!((exposed[dir] >> zz) & 1))
+								continue;
+
+							const FaceDirection& fd = faceDirections[dir];
+							const int* n = fd.normal;
+							unsigned int aoID = nb.GetAOID(n[0], n[1], zz + n[2], fd.u, fd.v);
+
+							if (grid && aoID == 0) {
+								grid->Add(dir, x, y, z, col);
+								continue;
+							}
+
+							int origin[3] = {x + fd.origin[0], y + fd.origin[1],
+							                 z + fd.origin[2]};
+							EmitQuad(mesh, origin, fd.u, fd.v, aoID, col, fd);
+						}
+					}
+				}
+			}
+
+			if (grid)
+				grid->Emit(mesh);
+		}
+	} // namespace draw
+} // namespace spades
@@ -0,0 +1,92 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace spades {
+	namespace client {
+		class GameMap;
+	}
+	namespace draw {
+		/**
+		 * Builds the vertex and index buffers of a map chunk rendered by `GLMapChunk`.
+		 *
+		 * The mesher finds the exposed faces with bit operations on the solid map columns
+		 * instead of testing every voxel and its six neighbors. It only reads the map and
+		 * doesn't use GL, so chunks can be meshed on worker threads as long as the map isn't
+		 * modified meanwhile.
+		 */
+		class MapChunkMesher {
+		public:
+			enum { Size = 16, SizeBits = 4 };
+
+			struct Vertex {
+				uint8_t x, y, z;
+				uint8_t pad;
+
+				uint16_t aoX, aoY;
+
+				uint8_t colorRed;
+				uint8_t colorGreen;
+				uint8_t colorBlue;
+				uint8_t shading;
+
+				int8_t nx, ny, nz;
+				uint8_t pad2;
+
+				int8_t sx, sy, sz;
+				uint8_t pad3;
+			};
+
+			struct Mesh {
+				std::vector<Vertex> vertices;
+				std::vector<uint16_t> indices;
+
+				void Clear() {
+					vertices.clear();
+					indices.clear();
+				}
+			};
+
+			/**
+			 * @param water `true` if the water surface is rendered separately (`r_water`), in
+			 *              which case the bottom layer of the map is drawn as the layer above.
+			 * @param greedy `true` to merge the adjacent coplanar faces with the same color and
+			 *               without ambient occlusion into larger quads. This reduces the
+			 *               vertex count a lot, but the merged faces share a single shadow
+			 *               sampling position.
+			 */
+			MapChunkMesher(const client::GameMap&, bool water, bool greedy);
+
+			/** Replaces the contents of `mesh` with the mesh of the chunk `(cx, cy, cz)`. */
+			void Build(int cx, int cy, int cz, Mesh& mesh) const;
+
+		private:
+			const client::GameMap& map;
+			bool water;
+			bool greedy;
+
+			uint64_t GetColumn(int x, int y) const;
+		};
+	} // namespace draw
+} // namespace spades
@@ -0,0 +1,440 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cmath>
+
+#include "RadiosityBaker.h"
+#include <Client/GameMap.h>
+#include <Core/Debug.h>
+#include <Core/ThreadPool.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPADES_RADIOSITY_SSE2 1
+#include <emmintrin.h>
+#else
+#define SPADES_RADIOSITY_SSE2 0
+#endif
+
+namespace spades {
+	namespace draw {
+		namespace {
+			uint32_t BuildShadowPixel(int distance, uint32_t color, bool side) {
+				int r = (uint8_t)(color);
+				int g = (uint8_t)(color >> 8);
+				int b = (uint8_t)(color >> 16);
+
+				r >>= 2;
+				g >>= 2;
+				b >>= 2;
+
+				SPAssert(r < 64);
+				SPAssert(g < 64);
+				SPAssert(b < 64);
+				SPAssert(r >= 0);
+				SPAssert(g >= 0);
+				SPAssert(b >= 0);
+
+				int ex1 = side ? 1 : 0, ex2 = 0, ex3 = 0;
+
+				return r + (g << 8) + (b << 16) + (distance << 24) + (ex1 << 7) + (ex2 << 15) +
+				       (ex3 << 23);
+			}
+
+			const float resultScale = 0.1F / 64.0F;
+		} // namespace
+
+		RadiosityBaker::RadiosityBaker(const uint32_t* shadowBitmap, int width, int height,
+		                               bool highPrecision)
+		    : bitmap(shadowBitmap), w(width), h(height), highPrecision(highPrecision) {
+			// The window lookups wrap around with masks
+			SPAssert((w & (w - 1)) == 0);
+			SPAssert((h & (h - 1)) == 0);
+		}
+
+		RadiosityBaker::Result RadiosityBaker::Evaluate(IntVector3 ipos) const {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			Result result;
+			result.base = MakeVector3(0, 0, 0);
+			result.x = MakeVector3(0, 0, 0);
+			result.y = MakeVector3(0, 0, 0);
+			result.z = MakeVector3(0, 0, 0);
+
+			Vector3 pos = MakeVector3(ipos) + 0.5F;
+
+			int centerX = ipos.x;
+			int centerY = ipos.y - ipos.z;
+			const int yMask = h - 1;
+			const int pitch = w;
+
+			for (int x = -Envelope; x <= Envelope; x++) {
+				const uint32_t* column = bitmap + ((centerX + x) & (w - 1));
+				for (int y = -Envelope; y <= Envelope; y++) {
+					uint32_t pixel = column[pitch * ((centerY + y) & yMask)];
+					int depth = pixel >> 24;
+
+					// shadowmap pixel's world coord
+					int wx = centerX + x;
+					int wy = centerY + y + depth;
+					int wz = depth;
+
+					// if true, this is negative-y faced plane
+					// if false, this is negative-z faced plane
+					bool isSide = (pixel & 0x80) != 0;
+
+					// direction dependent process
+					Vector3 center; // center of face
+					Vector3 diff;   // pos - center
+					float diffDot;  // dot(diff, normal)
+					if (isSide) {
+						// normal cull
+						if (wy <= ipos.y)
+							continue;
+
+						center.x = wx + 0.5F;
+						center.y = (float)wy;
+						center.z = wz - 0.5F;
+
+						diff = pos - center;
+						diffDot = -diff.y;
+					} else {
+						if (wz <= ipos.z)
+							continue;
+
+						center.x = wx + 0.5F;
+						center.y = wy + 0.5F;
+						center.z = (float)wz;
+
+						diff = pos - center;
+						diffDot = -diff.z;
+					}
+
+					SPAssert(diffDot >= 0.0F);
+
+					float diffLen = diff.GetLength();
+					float invDiffLen = 1.0F / diffLen;
+					float invDiffLenSmooth = 1.0F / ((diffLen) + 0.4F);
+
+					// fall-off because of direciton
+					float intensity = diffDot * invDiffLen;
+
+					// 1/(r^2) distance fall-off
+					intensity *= invDiffLenSmooth;
+					intensity *= invDiffLenSmooth;
+
+					// normalize
+					Vector3 normDiff = diff * -invDiffLen;
+
+					// extract shadowmap color
+					float red = static_cast<float>((pixel) & 0x3F);
+					float green = static_cast<float>((pixel >> 8) & 0x3F);
+					float blue = static_cast<float>((pixel >> 16) & 0x3F);
+
+					Vector3 color = {red, green, blue};
+					color *= intensity;
+
+					// add to result
+					result.base += color;
+					result.x += color * normDiff.x;
+					result.y += color * normDiff.y;
+					result.z += color * normDiff.z;
+
+					SPAssert(!std::isnan(intensity));
+					SPAssert(intensity >= 0.0F);
+				}
+			}
+
+			result.base *= resultScale;
+			result.x *= resultScale;
+			result.y *= resultScale;
+			result.z *= resultScale;
+
+			return result;
+		}
+
+		float RadiosityBaker::CompressDynamicRange(float v) const {
+			if (highPrecision)
+				return v;
+			if (v >= 0.0F)
+				return sqrtf(v);
+			else
+				return -sqrtf(-v);
+		}
+
+		uint32_t RadiosityBaker::EncodeValue(Vector3 vec) const {
+			float v;
+			int iv;
+			unsigned int out = 0xC0000000;
+
+			vec.x = CompressDynamicRange(vec.x);
+			vec.y = CompressDynamicRange(vec.y);
+			vec.z = CompressDynamicRange(vec.z);
+
+			vec *= 0.5F;
+			vec += 0.5F;
+			vec *= 1022.0F / 1023.0F;
+
+			v = vec.x * 1023.0F + 0.5F;
+			if (v > 1023.2F)
+				v = 1023.2F;
+			if (v < 0.0F)
+				v = 0.0F;
+			iv = (unsigned int)v;
+			if (iv > 1023)
+				iv = 1023;
+			if (iv < 0)
+				iv = 0;
+			out |= iv << 20;
+
+			v = vec.y * 1023.0F + 0.5F;
+			if (v > 1023.2F)
+				v = 1023.2F;
+			if (v < 0.0F)
+				v = 0.0F;
+			iv = (unsigned int)v;
+			if (iv > 1023)
+				iv = 1023;
+			if (iv < 0)
+				iv = 0;
+			out |= iv << 10;
+
+			v = vec.z * 1023.0F + 0.5F;
+			if (v > 1023.2F)
+				v = 1023.2F;
+			if (v < 0.0F)
+				v = 0.0F;
+			iv = (unsigned int)v;
+			if (iv > 1023)
+				iv = 1023;
+			if (iv < 0)
+				iv = 0;
+			out |= iv;
+
+			return (uint32_t)out;
+		}
+
+		void RadiosityBaker::Store(ChunkData& data, int x, int y, int z,
+		                           const Result& res) const {
+			data.flat[z][y][x] = EncodeValue(res.base);
+			data.x[z][y][x] = EncodeValue(res.x);
+			data.y[z][y][x] = EncodeValue(res.y);
+			data.z[z][y][x] = EncodeValue(res.z);
+		}
+
+#if SPADES_RADIOSITY_SSE2
+		void RadiosityBaker::BakeFourVoxels(IntVector3 origin, int x, int y, int z,
+		                                    ChunkData& data) const {
+			// Each lane evaluates one voxel with the same sequence of floating-point operations
+			// as `Evaluate`, so do not reorder them. Culled samples are masked out of the sums,
+			// which doesn't change the result because adding zero is exact.
+			const __m128i laneIndex = _mm_set_epi32(3, 2, 1, 0);
+			const __m128 half = _mm_set1_ps(0.5F);
+			const __m128 one = _mm_set1_ps(1.0F);
+			const __m128 smoothing = _mm_set1_ps(0.4F);
+			const __m128 signBit = _mm_set1_ps(-0.0F);
+			const __m128i colorMask = _mm_set1_epi32(0x3F);
+			const __m128i sideBit = _mm_set1_epi32(0x80);
+
+			IntVector3 ipos = IntVector3::Make(origin.x + x, origin.y + y, origin.z + z);
+			__m128i ix = _mm_add_epi32(_mm_set1_epi32(ipos.x), laneIndex);
+			__m128 posX = _mm_add_ps(_mm_cvtepi32_ps(ix), half);
+			__m128 posY = _mm_set1_ps((float)ipos.y + 0.5F);
+			__m128 posZ = _mm_set1_ps((float)ipos.z + 0.5F);
+			__m128i iposY = _mm_set1_epi32(ipos.y);
+			__m128i iposZ = _mm_set1_epi32(ipos.z);
+
+			__m128 sum[4][3];
+			for (auto& v : sum)
+				v[0] = v[1] = v[2] = _mm_setzero_ps();
+
+			const int centerY = ipos.y - ipos.z;
+			const int yMask = h - 1;
+
+			for (int dx = -Envelope; dx <= Envelope; dx++) {
+				int column = (ipos.x + dx) & (w - 1);
+
+				// center of face. x is `wx + 0.5F` regardless of the direction
+				__m128 faceX = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(ix, _mm_set1_epi32(dx))),
+				                          half);
+				__m128 diffX = _mm_sub_ps(posX, faceX);
+
+				for (int dy = -Envelope; dy <= Envelope; dy++) {
+					const uint32_t* row = bitmap + w * ((centerY + dy) & yMask);
+					__m128i pixel;
+					if (column <= w - 4) {
+						pixel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + column));
+					} else {
+						pixel = _mm_set_epi32(row[(column + 3) & (w - 1)],
+						                      row[(column + 2) & (w - 1)],
+						                      row[(column + 1) & (w - 1)], row[column]);
+					}
+
+					__m128i depth = _mm_srli_epi32(pixel, 24);
+					__m128i wy = _mm_add_epi32(_mm_set1_epi32(centerY + dy), depth);
+					const __m128i& wz = depth;
+					__m128i isSide = _mm_cmpeq_epi32(_mm_and_si128(pixel, sideBit), sideBit);
+
+					// normal cull
+					__m128i visible = _mm_or_si128(
+					  _mm_and_si128(isSide, _mm_cmpgt_epi32(wy, iposY)),
+					  _mm_andnot_si128(isSide, _mm_cmpgt_epi32(wz, iposZ)));
+					if (_mm_movemask_epi8(visible) == 0)
+						continue;
+					__m128 side = _mm_castsi128_ps(isSide);
+
+					__m128 fwy = _mm_cvtepi32_ps(wy);
+					__m128 fwz = _mm_cvtepi32_ps(wz);
+					__m128 faceY = _mm_or_ps(_mm_and_ps(side, fwy),
+					                         _mm_andnot_ps(side, _mm_add_ps(fwy, half)));
+					__m128 faceZ = _mm_or_ps(_mm_and_ps(side, _mm_sub_ps(fwz, half)),
+					                         _mm_andnot_ps(side, fwz));
+					__m128 diffY = _mm_sub_ps(posY, faceY);
+					__m128 diffZ = _mm_sub_ps(posZ, faceZ);
+					__m128 diffDot = _mm_xor_ps(
+					  _mm_or_ps(_mm_and_ps(side, diffY), _mm_andnot_ps(side, diffZ)), signBit);
+
+					__m128 diffLen = _mm_sqrt_ps(
+					  _mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY)),
+					             _mm_mul_ps(diffZ, diffZ)));
+					__m128 invDiffLen = _mm_div_ps(one, diffLen);
+					__m128 invDiffLenSmooth = _mm_div_ps(one, _mm_add_ps(diffLen, smoothing));
+
+					__m128 intensity = _mm_mul_ps(diffDot, invDiffLen);
+					intensity = _mm_mul_ps(intensity, invDiffLenSmooth);
+					intensity = _mm_mul_ps(intensity, invDiffLenSmooth);
+
+					__m128 negInvDiffLen = _mm_xor_ps(invDiffLen, signBit);
+					__m128 normDiff[3] = {_mm_mul_ps(diffX, negInvDiffLen),
+					                      _mm_mul_ps(diffY, negInvDiffLen),
+					                      _mm_mul_ps(diffZ, negInvDiffLen)};
+
+					__m128 mask = _mm_castsi128_ps(visible);
+					__m128 color[3];
+					for (int c = 0; c < 3; c++) {
+						__m128i channel = _mm_and_si128(_mm_srli_epi32(pixel, c * 8), colorMask);
+						color[c] = _mm_and_ps(_mm_mul_ps(_mm_cvtepi32_ps(channel), intensity),
+						                      mask);
+					}
+
+					for (int c = 0; c < 3; c++) {
+						sum[0][c] = _mm_add_ps(sum[0][c], color[c]);
+						for (int k = 0; k < 3; k++)
+							sum[1 + k][c] =
+							  _mm_add_ps(sum[1 + k][c], _mm_mul_ps(color[c], normDiff[k]));
+					}
+				}
+			}
+
+			const __m128 scale = _mm_set1_ps(resultScale);
+			alignas(16) float values[4][3][4];
+			for (int k = 0; k < 4; k++)
+				for (int c = 0; c < 3; c++)
+					_mm_store_ps(values[k][c], _mm_mul_ps(sum[k][c], scale));
+
+			for (int lane = 0; lane < 4; lane++) {
+				Result res;
+				Vector3* fields[] = {&res.base, &res.x, &res.y, &res.z};
+				for (int k = 0; k < 4; k++) {
+					*fields[k] = MakeVector3(values[k][0][lane], values[k][1][lane],
+					                         values[k][2][lane]);
+				}
+				Store(data, x + lane, y, z, res);
+			}
+		}
+#else
+		void RadiosityBaker::BakeFourVoxels(IntVector3 origin, int x, int y, int z,
+		                                    ChunkData& data) const {
+			for (int lane = 0; lane < 4; lane++) {
+				IntVector3 pos =
+				  IntVector3::Make(origin.x + x + lane, origin.y + y, origin.z + z);
+				Store(data, x + lane, y, z, Evaluate(pos));
+			}
+		}
+#endif
+
+		void RadiosityBaker::BakeChunk(int cx, int cy, int cz, IntVector3 min, IntVector3 max,
+		                               ChunkData& data) const {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			IntVector3 origin = IntVector3::Make(cx, cy, cz) * (int)ChunkSize;
+
+			for (int z = min.z; z <= max.z; z++)
+				for (int y = min.y; y <= max.y; y++) {
+					int x = min.x;
+					for (; x + 3 <= max.x; x += 4)
+						BakeFourVoxels(origin, x, y, z, data);
+					for (; x <= max.x; x++) {
+						IntVector3 pos = origin + IntVector3::Make(x, y, z);
+						Store(data, x, y, z, Evaluate(pos));
+					}
+				}
+		}
+
+		void RadiosityBaker::BakeAll(int depth, std::vector<ChunkData>& chunks) const {
+			SPADES_MARK_FUNCTION();
+
+			int chunkW = w / ChunkSize, chunkH = h / ChunkSize, chunkD = depth / ChunkSize;
+			chunks.resize(static_cast<std::size_t>(chunkW * chunkH * chunkD));
+
+			ParallelFor(chunks.size(), 1, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; i++) {
+					int cz = static_cast<int>(i % chunkD);
+					int cx = static_cast<int>(i / chunkD) % chunkW;
+					int cy = static_cast<int>(i / chunkD) / chunkW;
+					BakeChunk(cx, cy, cz, chunks[i]);
+				}
+			});
+		}
+
+		uint32_t RadiosityBaker::GenerateShadowPixel(const client::GameMap& map, int x, int y) {
+			const int h = map.Height(), d = map.Depth();
+			for (int z = 0; z < d; z++) {
+				// z-plane hit
+				if (map.IsSolid(x, y, z) && z < 63) {
+					return BuildShadowPixel(z, map.GetColor(x, y, z), false);
+				}
+
+				y = y + 1;
+				if (y == h)
+					y = 0;
+
+				// y-plane hit
+				if (map.IsSolid(x, y, z) && z < 63) {
+					return BuildShadowPixel(z + 1, map.GetColor(x, y, z), true);
+				}
+			}
+			return BuildShadowPixel(64, map.GetColor(x, y == h ? 0 : y, 63), false);
+		}
+
+		void RadiosityBaker::GenerateShadowBitmap(const client::GameMap& map,
+		                                          std::vector<uint32_t>& bitmap) {
+			SPADES_MARK_FUNCTION();
+
+			const int w = map.Width(), h = map.Height();
+			bitmap.resize(static_cast<std::size_t>(w * h));
+
+			ParallelFor(static_cast<std::size_t>(h), 8, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t y = begin; y < end; y++)
+					for (int x = 0; x < w; x++)
+						bitmap[y * w + x] = GenerateShadowPixel(map, x, static_cast<int>(y));
+			});
+		}
+	} // namespace draw
+} // namespace spades
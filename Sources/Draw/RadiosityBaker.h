@@ -0,0 +1,111 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <Core/Math.h>
+
+namespace spades {
+	namespace client {
+		class GameMap;
+	}
+	namespace draw {
+		/**
+		 * Computes the indirect lighting stored in the textures of `GLRadiosityRenderer`. Each
+		 * voxel gathers the light reflected by the pixels of the terrain shadow map (generated
+		 * by `GLMapShadowRenderer`) in a `(2 * Envelope + 1)^2` window around it.
+		 *
+		 * The baker only reads the shadow map and doesn't use GL, so it can be used on any
+		 * thread, or headless.
+		 */
+		class RadiosityBaker {
+		public:
+			enum { ChunkSize = 16, ChunkSizeBits = 4, Envelope = 6 };
+
+			struct Result {
+				Vector3 base, x, y, z;
+			};
+
+			/** The encoded values of a chunk, in the texel order of the radiosity textures. */
+			struct ChunkData {
+				uint32_t flat[ChunkSize][ChunkSize][ChunkSize];
+				uint32_t x[ChunkSize][ChunkSize][ChunkSize];
+				uint32_t y[ChunkSize][ChunkSize][ChunkSize];
+				uint32_t z[ChunkSize][ChunkSize][ChunkSize];
+			};
+
+			/**
+			 * @param shadowBitmap The shadow map of a `width` x `height` map. It's not copied,
+			 *                     and may be modified between bakes.
+			 * @param highPrecision `true` to encode the values for the `RGB10A2` textures used
+			 *                      by `r_radiosity 2`.
+			 */
+			RadiosityBaker(const uint32_t* shadowBitmap, int width, int height,
+			               bool highPrecision);
+
+			/** Evaluates a single voxel. `BakeChunk` produces bit-exact results. */
+			Result Evaluate(IntVector3) const;
+
+			uint32_t EncodeValue(Vector3) const;
+
+			bool IsHighPrecision() const { return highPrecision; }
+
+			/**
+			 * Bakes the voxels in the box `[min, max]` (inclusive, in the coordinates relative
+			 * to the chunk) of the chunk `(cx, cy, cz)`. Uses SIMD instructions if available.
+			 */
+			void BakeChunk(int cx, int cy, int cz, IntVector3 min, IntVector3 max,
+			               ChunkData&) const;
+
+			/** Bakes a whole chunk. */
+			void BakeChunk(int cx, int cy, int cz, ChunkData& data) const {
+				BakeChunk(cx, cy, cz, IntVector3::Make(0, 0, 0),
+				          IntVector3::Make(ChunkSize - 1, ChunkSize - 1, ChunkSize - 1), data);
+			}
+
+			/**
+			 * Bakes every chunk of a map with the given depth in parallel. The chunk
+			 * `(cx, cy, cz)` is stored in `chunks[(cx + cy * chunkW) * chunkD + cz]`.
+			 */
+			void BakeAll(int depth, std::vector<ChunkData>& chunks) const;
+
+			/** Computes a pixel of the shadow map of `GLMapShadowRenderer`. */
+			static uint32_t GenerateShadowPixel(const client::GameMap&, int x, int y);
+
+			/** Computes the whole shadow map of a map in parallel. */
+			static void GenerateShadowBitmap(const client::GameMap&, std::vector<uint32_t>&);
+
+		private:
+			const uint32_t* bitmap;
+			int w, h;
+			bool highPrecision;
+
+			float CompressDynamicRange(float v) const;
+
+			/** Evaluates and stores the voxels `(x, y, z)` through `(x + 3, y, z)`. */
+			void BakeFourVoxels(IntVector3 origin, int x, int y, int z, ChunkData&) const;
+
+			void Store(ChunkData&, int x, int y, int z, const Result&) const;
+		};
+	} // namespace draw
+} // namespace spades
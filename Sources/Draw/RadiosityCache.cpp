@@ -0,0 +1,295 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include <zlib.h>
+
+#include "RadiosityCache.h"
+#include <Core/Debug.h>
+#include <Core/DeflateStream.h>
+#include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/IStream.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+
+DEFINE_SPADES_SETTING(r_radiosityCache, "1");
+DEFINE_SPADES_SETTING(r_radiosityCacheSize, "512");
+
+namespace spades {
+	namespace draw {
+		namespace {
+			const char* const cacheDirectory = "RadiosityCache";
+			const char* const usageFileName = "RadiosityCache/Usage.txt";
+
+			struct Header {
+				char magic[8];
+				uint32_t version;
+				uint32_t numChunks;
+				/** Orders the entries missing from the usage file. */
+				uint64_t storedAt;
+			};
+
+			const char headerMagic[8] = {'S', 'P', 'R', 'A', 'D', 'B', 'A', 'K'};
+			// Increment when the output of `RadiosityBaker` changes
+			const uint32_t headerVersion = 1;
+
+			/** Serializes `Store`, the eviction, and the updates of the usage file. */
+			std::mutex storeMutex;
+
+			/** The last use of each entry by key, from a counter incremented on every use. */
+			using UsageMap = std::map<uint32_t, uint64_t>;
+
+			std::string GetPath(uint32_t key) {
+				char buf[64];
+				std::sprintf(buf, "%s/%08x.rad", cacheDirectory, key);
+				return buf;
+			}
+
+			void ReadExactly(IStream& stream, void* data, std::size_t size) {
+				if (stream.Read(data, size) < size)
+					SPRaise("Unexpected end of file");
+			}
+
+			Header ReadHeader(IStream& stream) {
+				Header header;
+				ReadExactly(stream, &header, sizeof(header));
+				if (std::memcmp(header.magic, headerMagic, sizeof(header.magic)) != 0 ||
+				    header.version != headerVersion) {
+					SPRaise("Unrecognized radiosity cache format");
+				}
+				return header;
+			}
+
+			UsageMap ReadUsage() {
+				UsageMap usage;
+				if (!FileManager::FileExists(usageFileName))
+					return usage;
+
+				std::string text;
+				try {
+					text = FileManager::ReadAllBytes(usageFileName);
+				} catch (const std::exception& ex) {
+					SPLog("Failed to read the radiosity cache usage: %s", ex.what());
+					return usage;
+				}
+
+				// Each line: <key> <last used>
+				std::istringstream lines{text};
+				std::string line;
+				while (std::getline(lines, line)) {
+					std::istringstream fields{line};
+					std::string key;
+					uint64_t lastUsed;
+					if (!(fields >> key >> lastUsed))
+						continue;
+					usage[static_cast<uint32_t>(std::strtoul(key.c_str(), nullptr, 16))] = lastUsed;
+				}
+				return usage;
+			}
+
+			void WriteUsage(const UsageMap& usage) {
+				std::string text;
+				char buf[64];
+				for (const auto& item : usage) {
+					std::sprintf(buf, "%08x %" PRIu64 "\n", item.first, item.second);
+					text += buf;
+				}
+
+				try {
+					auto stream = FileManager::OpenForWriting(usageFileName);
+					stream->Write(text);
+				} catch (const std::exception& ex) {
+					SPLog("Failed to write the radiosity cache usage: %s", ex.what());
+				}
+			}
+
+			/** Makes the entry the most recently used one. Requires `storeMutex`. */
+			void MarkUsed(uint32_t key) {
+				UsageMap usage = ReadUsage();
+				uint64_t counter = 0;
+				for (const auto& item : usage)
+					counter = std::max(counter, item.second);
+				usage[key] = counter + 1;
+				WriteUsage(usage);
+			}
+
+			/**
+			 * Removes the least recently used entries until the total size is `maxSize`.
+			 * Requires `storeMutex`.
+			 */
+			void Evict(uint64_t maxSize) {
+				struct Entry {
+					std::string path;
+					uint32_t key;
+					uint64_t size;
+					uint64_t lastUsed;
+					uint64_t storedAt;
+				};
+				std::vector<Entry> entries;
+				uint64_t totalSize = 0;
+				UsageMap usage = ReadUsage();
+				UsageMap remainingUsage;
+
+				for (const std::string& name : FileManager::EnumFiles(cacheDirectory)) {
+					if (name.size() < 4 || name.compare(name.size() - 4, 4, ".rad") != 0)
+						continue;
+
+					Entry entry;
+					entry.path = std::string(cacheDirectory) + "/" + name;
+					entry.key = static_cast<uint32_t>(std::strtoul(name.c_str(), nullptr, 16));
+					auto it = usage.find(entry.key);
+					entry.lastUsed = it == usage.end() ? 0 : it->second;
+					try {
+						auto stream = FileManager::OpenForReading(entry.path.c_str());
+						entry.size = stream->GetLength();
+						entry.storedAt = ReadHeader(*stream).storedAt;
+					} catch (const std::exception& ex) {
+						SPLog("Removing the unreadable radiosity cache entry '%s': %s",
+						      entry.path.c_str(), ex.what());
+						FileManager::RemoveFile(entry.path.c_str());
+						continue;
+					}
+					totalSize += entry.size;
+					entries.push_back(std::move(entry));
+				}
+
+				std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+					if (a.lastUsed != b.lastUsed)
+						return a.lastUsed < b.lastUsed;
+					return a.storedAt < b.storedAt;
+				});
+
+				for (const Entry& entry : entries) {
+					if (totalSize <= maxSize) {
+						if (entry.lastUsed != 0)
+							remainingUsage[entry.key] = entry.lastUsed;
+						continue;
+					}
+					SPLog("Evicting the radiosity cache entry '%s'", entry.path.c_str());
+					FileManager::RemoveFile(entry.path.c_str());
+					totalSize -= entry.size;
+				}
+
+				// Also forgets the entries removed by other means
+				if (remainingUsage != usage)
+					WriteUsage(remainingUsage);
+			}
+		} // namespace
+
+		bool RadiosityCache::IsEnabled() { return r_radiosityCache; }
+
+		uint32_t RadiosityCache::ComputeKey(const std::vector<uint32_t>& shadowBitmap,
+		                                    bool highPrecision) {
+			uLong checksum = crc32(0L, Z_NULL, 0);
+			checksum = crc32(checksum, reinterpret_cast<const Bytef*>(shadowBitmap.data()),
+			                 static_cast<uInt>(shadowBitmap.size() * sizeof(uint32_t)));
+
+			// The encoding depends on the precision
+			Bytef precision = highPrecision ? 1 : 0;
+			checksum = crc32(checksum, &precision, 1);
+			return static_cast<uint32_t>(checksum);
+		}
+
+		bool RadiosityCache::Load(uint32_t key,
+		                          const std::vector<RadiosityBaker::ChunkData*>& chunks) {
+			SPADES_MARK_FUNCTION();
+
+			if (!IsEnabled())
+				return false;
+
+			std::string path = GetPath(key);
+			if (!FileManager::FileExists(path.c_str()))
+				return false;
+
+			try {
+				Stopwatch sw;
+				auto stream = FileManager::OpenForReading(path.c_str());
+				Header header = ReadHeader(*stream);
+				if (header.numChunks != chunks.size())
+					SPRaise("Chunk count mismatch");
+
+				DeflateStream inflate(stream.get(), CompressModeDecompress);
+				for (RadiosityBaker::ChunkData* chunk : chunks)
+					ReadExactly(inflate, chunk, sizeof(RadiosityBaker::ChunkData));
+
+				SPLog("Loaded the baked radiosity %08x from the cache in %.3f msecs", key,
+				      sw.GetTime() * 1000.0);
+			} catch (const std::exception& ex) {
+				SPLog("Failed to load the cached radiosity '%s', removing it: %s", path.c_str(),
+				      ex.what());
+				FileManager::RemoveFile(path.c_str());
+				return false;
+			}
+
+			std::lock_guard<std::mutex> lock{storeMutex};
+			MarkUsed(key);
+			return true;
+		}
+
+		void RadiosityCache::Store(uint32_t key,
+		                           const std::vector<const RadiosityBaker::ChunkData*>& chunks) {
+			SPADES_MARK_FUNCTION();
+
+			if (!IsEnabled())
+				return;
+
+			std::lock_guard<std::mutex> lock{storeMutex};
+
+			std::string path = GetPath(key);
+			try {
+				Stopwatch sw;
+				auto stream = FileManager::OpenForWriting(path.c_str());
+
+				Header header;
+				std::memcpy(header.magic, headerMagic, sizeof(header.magic));
+				header.version = headerVersion;
+				header.numChunks = static_cast<uint32_t>(chunks.size());
+				header.storedAt = static_cast<uint64_t>(std::time(nullptr));
+				stream->Write(&header, sizeof(header));
+
+				DeflateStream deflate(stream.get(), CompressModeCompress);
+				for (const RadiosityBaker::ChunkData* chunk : chunks)
+					deflate.Write(chunk, sizeof(RadiosityBaker::ChunkData));
+				deflate.DeflateEnd();
+
+				SPLog("Stored the baked radiosity %08x in the cache (%llu bytes) in %.3f msecs",
+				      key, static_cast<unsigned long long>(stream->GetPosition()),
+				      sw.GetTime() * 1000.0);
+			} catch (const std::exception& ex) {
+				SPLog("Failed to store the baked radiosity in the cache: %s", ex.what());
+				FileManager::RemoveFile(path.c_str());
+				return;
+			}
+
+			MarkUsed(key);
+			Evict(static_cast<uint64_t>(std::max(0, (int)r_radiosityCacheSize)) << 20);
+		}
+	} // namespace draw
+} // namespace spades
@@ -0,0 +1,62 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RadiosityBaker.h"
+
+namespace spades {
+	namespace draw {
+		/**
+		 * An on-disk cache of fully baked radiosity, so that rejoining a server with the same
+		 * map doesn't need to bake it again.
+		 *
+		 * A bake only depends on the shadow map it was computed from, so the entries are keyed
+		 * by a checksum of the shadow map (see `ComputeKey`). Each entry is stored in
+		 * `RadiosityCache/`, compressed with deflate. The total size of the entries is bounded
+		 * by `r_radiosityCacheSize` (in MiB), and the least recently stored or loaded entries
+		 * are evicted first. The usage order is kept in `RadiosityCache/Usage.txt`.
+		 * `r_radiosityCache 0` disables the cache.
+		 *
+		 * I/O errors are logged and treated like cache misses.
+		 */
+		class RadiosityCache {
+		public:
+			static bool IsEnabled();
+
+			static uint32_t ComputeKey(const std::vector<uint32_t>& shadowBitmap,
+			                           bool highPrecision);
+
+			/**
+			 * Reads the bake stored with the given key into `chunks` (in the order used by
+			 * `RadiosityBaker::BakeAll`). Returns `false` if there's no such entry. The
+			 * contents of `chunks` are unspecified in that case.
+			 */
+			static bool Load(uint32_t key, const std::vector<RadiosityBaker::ChunkData*>& chunks);
+
+			/** Stores a fully baked map with the given key, replacing an existing entry. */
+			static void Store(uint32_t key,
+			                  const std::vector<const RadiosityBaker::ChunkData*>& chunks);
+		};
+	} // namespace draw
+} // namespace spades
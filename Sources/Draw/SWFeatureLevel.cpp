@@ -29,6 +29,10 @@ namespace spades {
 #if ENABLE_SSE2
 		SWFeatureLevel DetectFeatureLevel() {
 			CpuID cpuid;
+#if ENABLE_AVX2
+			if (cpuid.Supports(CpuFeature::AVX2))
+				return SWFeatureLevel::AVX2;
+#endif
 			if (cpuid.Supports(CpuFeature::SSE2))
 				return SWFeatureLevel::SSE2;
 
@@ -37,6 +41,10 @@ namespace spades {
 		}
 #elif ENABLE_SSE
 		SWFeatureLevel DetectFeatureLevel() { return SWFeatureLevel::SSE; }
+#elif ENABLE_NEON
+		// NEON is mandatory on AArch64, and 32-bit ARM builds only enable it when the
+		// compiler targets it
+		SWFeatureLevel DetectFeatureLevel() { return SWFeatureLevel::NEON; }
 #else
 		SWFeatureLevel DetectFeatureLevel() { return SWFeatureLevel::None; }
 #endif
@@ -54,6 +54,31 @@
 #include <emmintrin.h>
 #endif
 
+// AVX2 kernels are compiled per function and selected at runtime, so the rest of the
+// renderer doesn't need to be built with AVX2 enabled
+#if ENABLE_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#define ENABLE_AVX2 1
+#define SPADES_TARGET_AVX2 __attribute__((target("avx2")))
+#elif ENABLE_SSE2 && defined(_MSC_VER)
+#define ENABLE_AVX2 1
+#define SPADES_TARGET_AVX2
+#endif
+
+#ifndef ENABLE_AVX2
+#define ENABLE_AVX2 0
+#endif
+
+#if ENABLE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ENABLE_NEON 1
+#include <arm_neon.h>
+#else
+#define ENABLE_NEON 0
+#endif
+
 #include <Core/ConcurrentDispatch.h>
 #include <Core/Debug.h>
 #include <algorithm>
@@ -74,6 +99,12 @@ namespace spades {
 #endif
 #if ENABLE_SSE2
 			SSE2,
+#endif
+#if ENABLE_AVX2
+			AVX2,
+#endif
+#if ENABLE_NEON
+			NEON,
 #endif
 		};
 
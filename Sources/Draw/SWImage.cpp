@@ -19,6 +19,7 @@
  */
 
 #include "SWImage.h"
+#include "SWImageRenderer.h"
 #include <Core/FileManager.h>
 #include <Core/IStream.h>
 
@@ -46,6 +47,7 @@ namespace spades {
 		    : ew(m.GetWidth()),
 		      eh(m.GetHeight()),
 		      isWhite(false),
+		      pendingRenderer(nullptr),
 		      w(static_cast<float>(m.GetWidth())),
 		      h(static_cast<float>(m.GetHeight())),
 		      iw(1.f / w),
@@ -73,6 +75,7 @@ namespace spades {
 		    : ew(w),
 		      eh(h),
 		      isWhite(false),
+		      pendingRenderer(nullptr),
 		      w(static_cast<float>(ew)),
 		      h(static_cast<float>(eh)),
 		      iw(1.f / w),
@@ -88,6 +91,11 @@ namespace spades {
 				SPRaise("Out of range.");
 			}
 
+			// the deferred polygons must see the old contents
+			if (pendingRenderer) {
+				pendingRenderer->Flush();
+			}
+
 			{
 				int bw = inBmp.GetWidth();
 				int bh = inBmp.GetHeight();
@@ -27,6 +27,8 @@
 
 namespace spades {
 	namespace draw {
+		class SWImageRenderer;
+
 		class SWImage : public client::IImage {
 			// Handle<Bitmap> rawBmp;
 
@@ -35,6 +37,9 @@ namespace spades {
 
 			bool isWhite;
 
+			/** The renderer with deferred polygons sampling this image, if any. */
+			SWImageRenderer *pendingRenderer;
+
 			float w, h;
 			float iw, ih;
 
@@ -53,6 +58,8 @@ namespace spades {
 
 			void Update(Bitmap &, int x, int y) override;
 
+			void SetPendingRenderer(SWImageRenderer *r) { pendingRenderer = r; }
+
 			float GetWidth() override { return w; }
 			float GetHeight() override { return h; }
 			float GetInvWidth() { return iw; }
@@ -18,28 +18,166 @@
 
  */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+
 #include "SWImageRenderer.h"
 #include "SWImage.h"
+#include "SWUtils.h"
 #include <Core/Bitmap.h>
+#include <Core/TraceProfiler.h>
 
 namespace spades {
 	namespace draw {
 		SWImageRenderer::SWImageRenderer(SWFeatureLevel lvl)
-		    : shader(ShaderType::Image), featureLevel(lvl) {}
-
-		SWImageRenderer::~SWImageRenderer() {}
+		    : shader(ShaderType::Image),
+		      featureLevel(lvl),
+		      deferred(false),
+		      numTilesX(0),
+		      numTilesY(0) {}
+
+		SWImageRenderer::~SWImageRenderer() {
+			for (auto& p : polygons) {
+				if (p.image) {
+					p.image->SetPendingRenderer(nullptr);
+				}
+			}
+		}
 
 		void SWImageRenderer::SetFramebuffer(spades::Bitmap* bmp) {
+			Flush();
 			this->frame = bmp;
 			if (bmp) {
 				fbSize4 = MakeVector4(static_cast<float>(bmp->GetWidth()) * 0.5F,
 				                      static_cast<float>(bmp->GetHeight()) * -0.5F, 1.0F, 1.0F);
 				fbCenter4 = MakeVector4(static_cast<float>(bmp->GetWidth()) * 0.5F,
 				                        static_cast<float>(bmp->GetHeight()) * 0.5F, 0.0F, 0.0F);
+
+				numTilesX = (bmp->GetWidth() + TileSize - 1) / TileSize;
+				numTilesY = (bmp->GetHeight() + TileSize - 1) / TileSize;
+				tiles.resize(static_cast<std::size_t>(numTilesX * numTilesY));
+			}
+		}
+
+		void SWImageRenderer::SetDepthBuffer(float* f) {
+			if (f != depthBuffer) {
+				Flush();
+			}
+			depthBuffer = f;
+		}
+
+		void SWImageRenderer::SetDeferred(bool b) {
+			if (!b) {
+				Flush();
+			}
+			deferred = b;
+		}
+
+		SWImageRenderer::RasterTarget SWImageRenderer::GetFullTarget() {
+			RasterTarget t;
+			t.pixels = frame->GetPixels();
+			t.depthBuffer = depthBuffer;
+			t.stride = frame->GetWidth();
+			t.minX = 0;
+			t.minY = 0;
+			t.maxX = frame->GetWidth();
+			t.maxY = frame->GetHeight();
+			t.pixelsDrawn = 0;
+			return t;
+		}
+
+		void SWImageRenderer::Submit(RasterizeFunction rasterize, SWImage* img, const Vertex& v1,
+		                             const Vertex& v2, const Vertex& v3) {
+			if (!deferred) {
+				RasterTarget t = GetFullTarget();
+				rasterize(img, v1, v2, v3, t);
+				pixelsDrawn += t.pixelsDrawn;
+				return;
+			}
+
+			// conservative bounding box in tiles
+			float fMinX = std::min(std::min(v1.position.x, v2.position.x), v3.position.x);
+			float fMinY = std::min(std::min(v1.position.y, v2.position.y), v3.position.y);
+			float fMaxX = std::max(std::max(v1.position.x, v2.position.x), v3.position.x);
+			float fMaxY = std::max(std::max(v1.position.y, v2.position.y), v3.position.y);
+			if (!(fMinX < fMaxX) || !(fMinY < fMaxY)) {
+				// degenerate, or NaN
+				return;
+			}
+
+			int w = frame->GetWidth(), h = frame->GetHeight();
+			int minX = static_cast<int>(std::max(std::floor(fMinX) - 1.0F, 0.0F));
+			int minY = static_cast<int>(std::max(std::floor(fMinY) - 1.0F, 0.0F));
+			int maxX = static_cast<int>(std::min(std::ceil(fMaxX) + 1.0F, static_cast<float>(w)));
+			int maxY = static_cast<int>(std::min(std::ceil(fMaxY) + 1.0F, static_cast<float>(h)));
+			if (minX >= maxX || minY >= maxY) {
+				return;
+			}
+
+			auto index = static_cast<std::uint32_t>(polygons.size());
+			polygons.push_back(DeferredPolygon{rasterize, Handle<SWImage>(img), v1, v2, v3});
+			if (img) {
+				img->SetPendingRenderer(this);
+			}
+
+			int tx1 = minX / TileSize, tx2 = (maxX - 1) / TileSize;
+			int ty1 = minY / TileSize, ty2 = (maxY - 1) / TileSize;
+			for (int ty = ty1; ty <= ty2; ty++) {
+				for (int tx = tx1; tx <= tx2; tx++) {
+					tiles[static_cast<std::size_t>(tx + ty * numTilesX)].push_back(index);
+				}
+			}
+		}
+
+		void SWImageRenderer::Flush() {
+			if (polygons.empty()) {
+				return;
+			}
+			SPADES_TRACE_ZONE("SWImageRenderer::Flush");
+
+			std::atomic<int> nextTile{0};
+			std::array<unsigned long long, 32> threadPixels;
+			threadPixels.fill(0);
+			const int numTiles = numTilesX * numTilesY;
+			const RasterTarget full = GetFullTarget();
+
+			InvokeParallel2(
+			  [&](unsigned int th, unsigned int) {
+				  RasterTarget t = full;
+				  int tile;
+				  while ((tile = nextTile.fetch_add(1)) < numTiles) {
+					  auto& bin = tiles[static_cast<std::size_t>(tile)];
+					  if (bin.empty()) {
+						  continue;
+					  }
+
+					  t.minX = (tile % numTilesX) * TileSize;
+					  t.minY = (tile / numTilesX) * TileSize;
+					  t.maxX = std::min(t.minX + TileSize, full.maxX);
+					  t.maxY = std::min(t.minY + TileSize, full.maxY);
+					  for (std::uint32_t index : bin) {
+						  const DeferredPolygon& p = polygons[index];
+						  p.rasterize(p.image.GetPointerOrNull(), p.v1, p.v2, p.v3, t);
+					  }
+					  bin.clear();
+				  }
+				  threadPixels[th] = t.pixelsDrawn;
+			  },
+			  "SWImageRenderer::Flush");
+
+			for (unsigned long long n : threadPixels) {
+				pixelsDrawn += n;
 			}
+			for (auto& p : polygons) {
+				if (p.image) {
+					p.image->SetPendingRenderer(nullptr);
+				}
+			}
+			polygons.clear();
 		}
 
-		void SWImageRenderer::SetDepthBuffer(float* f) { depthBuffer = f; }
 		void SWImageRenderer::SetShaderType(ShaderType type) { shader = type; }
 		void SWImageRenderer::SetZRange(float zNear, float) {
 			// currently zNear is ignored...
@@ -227,6 +365,193 @@ namespace spades {
 		};
 #endif
 
+#pragma mark - Wide Spans
+
+#if ENABLE_AVX2
+		namespace {
+			/**
+			 * Draws a span of a textured polygon like the SSE2 renderer without depth test,
+			 * four pixels at a time, and returns the number of pixels drawn. `u` and `v`
+			 * are advanced by as many steps. `out` must be at an even X coordinate, and
+			 * `dither` is the row of the dither map or null.
+			 */
+			SPADES_TARGET_AVX2 int DrawTexturedSpanAVX2(uint32_t* out, int count, int64_t& u,
+			                                            int64_t& v, int64_t stepU, int64_t stepV,
+			                                            const uint32_t* tpixels, int tw, int th,
+			                                            __m128i mulCol, const int16_t* dither) {
+				// the counters of four pixels, wrapping like `_mm_add_epi64`
+				auto uStep = static_cast<uint64_t>(stepU), vStep = static_cast<uint64_t>(stepV);
+				auto u4 = _mm256_add_epi64(_mm256_set1_epi64x(u),
+				                           _mm256_setr_epi64x(0, uStep, uStep * 2, uStep * 3));
+				auto v4 = _mm256_add_epi64(_mm256_set1_epi64x(v),
+				                           _mm256_setr_epi64x(0, vStep, vStep * 2, vStep * 3));
+				auto u4Step = _mm256_set1_epi64x(uStep * 4);
+				auto v4Step = _mm256_set1_epi64x(vStep * 4);
+
+				auto ditherU = _mm256_setzero_si256(), ditherV = _mm256_setzero_si256();
+				if (dither) {
+					ditherU = _mm256_setr_epi64x(dither[0], dither[2], dither[0], dither[2]);
+					ditherV = _mm256_setr_epi64x(dither[1], dither[3], dither[1], dither[3]);
+				}
+				auto uvMask = _mm256_set1_epi64x(texUVScaleInt - 1);
+				auto tw4 = _mm256_set1_epi64x(tw), th4 = _mm256_set1_epi64x(th);
+				auto mulCol4 = _mm256_broadcastsi128_si256(mulCol);
+
+				int x = 0;
+				for (; x + 4 <= count; x += 4) {
+					// the integer parts, with the upper halves ignored like the SSE2 path
+					auto ui = _mm256_and_si256(
+					  _mm256_add_epi64(_mm256_srli_epi64(u4, 32), ditherU), uvMask);
+					auto vi = _mm256_and_si256(
+					  _mm256_add_epi64(_mm256_srli_epi64(v4, 32), ditherV), uvMask);
+					ui = _mm256_srli_epi64(_mm256_mul_epu32(ui, tw4), texUVScaleBits);
+					vi = _mm256_srli_epi64(_mm256_mul_epu32(vi, th4), texUVScaleBits);
+					auto index = _mm256_add_epi64(ui, _mm256_mul_epu32(vi, tw4));
+					auto tex = _mm256_i64gather_epi32(reinterpret_cast<const int*>(tpixels),
+					                                  index, 4);
+					u4 = _mm256_add_epi64(u4, u4Step);
+					v4 = _mm256_add_epi64(v4, v4Step);
+
+					// the blending of `drawPixel2`, [u8.8 x 4 x 4]
+					auto tcol = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(tex), mulCol4);
+					auto invAlpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(tcol, 0xff), 0xff);
+					invAlpha = _mm256_srli_epi16(invAlpha, 8);
+					invAlpha = _mm256_add_epi16(invAlpha, _mm256_srli_epi16(invAlpha, 7));
+					invAlpha = _mm256_sub_epi16(_mm256_set1_epi16(0x100), invAlpha);
+
+					auto* dest = reinterpret_cast<__m128i*>(out + x);
+					auto dcol = _mm256_cvtepu8_epi16(_mm_loadu_si128(dest));
+					dcol = _mm256_adds_epu16(_mm256_mullo_epi16(dcol, invAlpha), tcol);
+					dcol = _mm256_srli_epi16(dcol, 8);
+					dcol = _mm256_permute4x64_epi64(_mm256_packus_epi16(dcol, dcol), 0x08);
+					_mm_storeu_si128(dest, _mm256_castsi256_si128(dcol));
+				}
+
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(&u), _mm256_castsi256_si128(u4));
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(&v), _mm256_castsi256_si128(v4));
+				return x;
+			}
+
+			/**
+			 * Blends a span of a solid polygon like the SSE2 renderer without depth test,
+			 * eight pixels at a time, and returns the number of pixels drawn. `color` is
+			 * `[u8.8 x 4 x 2]`.
+			 */
+			SPADES_TARGET_AVX2 int FillSpanAVX2(uint32_t* out, int count, __m128i color,
+			                                    __m128i invAlpha) {
+				auto color8 = _mm256_broadcastsi128_si256(color);
+				auto invAlpha8 = _mm256_broadcastsi128_si256(invAlpha);
+				auto zero = _mm256_setzero_si256();
+
+				int x = 0;
+				for (; x + 8 <= count; x += 8) {
+					auto* dest = reinterpret_cast<__m256i*>(out + x);
+					auto dcol = _mm256_loadu_si256(dest);
+					auto dcol1 = _mm256_unpacklo_epi8(dcol, zero);
+					auto dcol2 = _mm256_unpackhi_epi8(dcol, zero);
+					dcol1 = _mm256_adds_epu16(_mm256_mullo_epi16(dcol1, invAlpha8), color8);
+					dcol2 = _mm256_adds_epu16(_mm256_mullo_epi16(dcol2, invAlpha8), color8);
+					dcol1 = _mm256_srli_epi16(dcol1, 8);
+					dcol2 = _mm256_srli_epi16(dcol2, 8);
+					_mm256_storeu_si256(dest, _mm256_packus_epi16(dcol1, dcol2));
+				}
+				return x;
+			}
+		} // namespace
+#endif
+
+#if ENABLE_NEON
+		namespace {
+			/**
+			 * Draws a span of a textured polygon like the scalar renderer without depth
+			 * test, four pixels at a time, and returns the number of pixels drawn. `u` and
+			 * `v` are advanced by as many steps. `dither` is the row of the dither map or
+			 * null, and `odd` tells whether `out` is at an odd X coordinate.
+			 */
+			int DrawTexturedSpanNEON(uint32_t* out, int count, int64_t& u, int64_t& v,
+			                         int64_t stepU, int64_t stepV, const uint32_t* tpixels,
+			                         int tw, int th, unsigned int mulR, unsigned int mulG,
+			                         unsigned int mulB, unsigned int mulA, const int16_t* dither,
+			                         bool odd) {
+				// the counters of two pixels, wrapping like the scalar path
+				auto uStep = static_cast<uint64_t>(stepU), vStep = static_cast<uint64_t>(stepV);
+				int64x2_t u2 = vaddq_s64(vdupq_n_s64(u), vcombine_s64(vcreate_s64(0),
+				                                                       vcreate_s64(uStep)));
+				int64x2_t v2 = vaddq_s64(vdupq_n_s64(v), vcombine_s64(vcreate_s64(0),
+				                                                       vcreate_s64(vStep)));
+				int64x2_t u2Step = vdupq_n_s64(static_cast<int64_t>(uStep * 2));
+				int64x2_t v2Step = vdupq_n_s64(static_cast<int64_t>(vStep * 2));
+
+				int32_t ditherData[8] = {};
+				if (dither) {
+					for (int i = 0; i < 4; i++) {
+						int k = ((i + (odd ? 1 : 0)) & 1) * 2;
+						ditherData[i] = dither[k];
+						ditherData[i + 4] = dither[k + 1];
+					}
+				}
+				int32x4_t ditherU = vld1q_s32(ditherData);
+				int32x4_t ditherV = vld1q_s32(ditherData + 4);
+				auto uvMask = vdupq_n_u32(texUVScaleInt - 1);
+				auto tw4 = vdupq_n_u32(static_cast<uint32_t>(tw));
+				auto th4 = vdupq_n_u32(static_cast<uint32_t>(th));
+				auto mask = vdupq_n_u32(0xff);
+				auto mulR4 = vdupq_n_u32(mulR), mulG4 = vdupq_n_u32(mulG);
+				auto mulB4 = vdupq_n_u32(mulB), mulA4 = vdupq_n_u32(mulA);
+
+				int x = 0;
+				for (; x + 4 <= count; x += 4) {
+					// the integer parts of the counters
+					int64x2_t uNext = vaddq_s64(u2, u2Step), vNext = vaddq_s64(v2, v2Step);
+					int32x4_t ui = vcombine_s32(vshrn_n_s64(u2, 32), vshrn_n_s64(uNext, 32));
+					int32x4_t vi = vcombine_s32(vshrn_n_s64(v2, 32), vshrn_n_s64(vNext, 32));
+					u2 = vaddq_s64(uNext, u2Step);
+					v2 = vaddq_s64(vNext, v2Step);
+					uint32x4_t tu = vandq_u32(vreinterpretq_u32_s32(vaddq_s32(ui, ditherU)), uvMask);
+					uint32x4_t tv = vandq_u32(vreinterpretq_u32_s32(vaddq_s32(vi, ditherV)), uvMask);
+					tu = vshrq_n_u32(vmulq_u32(tu, tw4), texUVScaleBits);
+					tv = vshrq_n_u32(vmulq_u32(tv, th4), texUVScaleBits);
+
+					uint32_t index[4], texels[4];
+					vst1q_u32(index, vmlaq_u32(tu, tv, tw4));
+					for (int i = 0; i < 4; i++)
+						texels[i] = tpixels[index[i]];
+					uint32x4_t tex = vld1q_u32(texels);
+
+					// the blending of `drawPixel`. textures are already premultiplied.
+					uint32x4_t ta = vshrq_n_u32(tex, 24);
+					ta = vaddq_u32(ta, vshrq_n_u32(ta, 7));
+					ta = vshrq_n_u32(vmulq_u32(ta, mulA4), 8);
+					uint32x4_t invA = vsubq_u32(vdupq_n_u32(256), ta);
+					uint32x4_t tr = vshrq_n_u32(vmulq_u32(vandq_u32(tex, mask), mulR4), 8);
+					uint32x4_t tg =
+					  vshrq_n_u32(vmulq_u32(vandq_u32(vshrq_n_u32(tex, 8), mask), mulG4), 8);
+					uint32x4_t tb =
+					  vshrq_n_u32(vmulq_u32(vandq_u32(vshrq_n_u32(tex, 16), mask), mulB4), 8);
+
+					uint32x4_t dest = vld1q_u32(out + x);
+					uint32x4_t dr = vshrq_n_u32(vmulq_u32(vandq_u32(dest, mask), invA), 8);
+					uint32x4_t dg =
+					  vshrq_n_u32(vmulq_u32(vandq_u32(vshrq_n_u32(dest, 8), mask), invA), 8);
+					uint32x4_t db =
+					  vshrq_n_u32(vmulq_u32(vandq_u32(vshrq_n_u32(dest, 16), mask), invA), 8);
+
+					uint32x4_t result = vminq_u32(vaddq_u32(tr, dr), mask);
+					result = vorrq_u32(result, vshlq_n_u32(vminq_u32(vaddq_u32(tg, dg), mask), 8));
+					result = vorrq_u32(result, vshlq_n_u32(vminq_u32(vaddq_u32(tb, db), mask), 16));
+
+					// fully transparent texels leave the destination untouched
+					result = vbslq_u32(vceqq_u32(tex, vdupq_n_u32(0)), dest, result);
+					vst1q_u32(out + x, result);
+				}
+
+				u = vgetq_lane_s64(u2, 0);
+				v = vgetq_lane_s64(v2, 0);
+				return x;
+			}
+		} // namespace
+#endif
+
 #pragma mark - Polygon Renderer Main
 
 		template <SWFeatureLevel level, bool needTransform,
@@ -237,26 +562,23 @@ namespace spades {
 			static_assert(!ndc, "Denormalize pass was not selected");
 
 			static void DrawPolygonInternalInner(SWImage* img, const Vertex& v1, const Vertex& v2,
-			                                     const Vertex& v3, SWImageRenderer& r) {
+			                                     const Vertex& v3, RasterTarget& t) {
 				// TODO: support null image
 
-				Bitmap& fb = *r.frame;
-
-				if (v3.position.y <= 0.f) {
+				if (v3.position.y <= static_cast<float>(t.minY)) {
 					// viewport cull
 					return;
 				}
 
-				const int fbW = fb.GetWidth();
-				const int fbH = fb.GetHeight();
-				uint32_t* const bmp = fb.GetPixels();
+				const int fbW = t.stride;
+				uint32_t* const bmp = t.pixels;
 
-				if (v1.position.y >= static_cast<float>(fbH)) {
+				if (v1.position.y >= static_cast<float>(t.maxY)) {
 					// viewport cull
 					return;
 				}
 
-				float* const depthBuffer = r.depthBuffer;
+				float* const depthBuffer = t.depthBuffer;
 				if (depthTest) {
 					SPAssert(depthBuffer != nullptr);
 				}
@@ -276,9 +598,9 @@ namespace spades {
 					return; // area cull
 				if (y1 == y3)
 					return; // area cull
-				if (std::min(std::min(x1, x2), x3) >= fbW)
+				if (std::min(std::min(x1, x2), x3) >= t.maxX)
 					return; // viewport cull
-				if (std::max(std::max(x1, x2), x3) <= 0)
+				if (std::max(std::max(x1, x2), x3) <= t.minX)
 					return; // viewport cull
 
 				auto convertColor = [](float v) {
@@ -359,7 +681,8 @@ namespace spades {
 					dest = outR | (outG << 8) | (outB << 16);
 				};
 
-				auto drawScanline = [tw, th, tpixels, bmp, fbW, depthBuffer, &drawPixel, &r,
+				auto drawScanline = [tw, th, tpixels, bmp, fbW, depthBuffer, mulR, mulG, mulB, mulA,
+				                     &drawPixel, &t,
 				                     &ditherMap](int y, int x1, int x2, const SWImageVarying& vary1,
 				                                 const SWImageVarying& vary2, float z1, float z2) {
 					uint32_t* out = bmp + (y * fbW);
@@ -370,16 +693,30 @@ namespace spades {
 					SPAssert(x1 < x2);
 					int width = x2 - x1;
 					SWImageGouraudInterpolator<level> vary(vary1, vary2, width);
-					int minX = std::max(x1, 0);
-					int maxX = std::min(x2, fbW);
+					int minX = std::max(x1, t.minX);
+					int maxX = std::min(x2, t.maxX);
+					if (minX >= maxX)
+						return; // outside the scissor rect
 					vary.MoveNext(minX - x1);
 					out += minX;
 					if (depthTest) {
 						depthOut += minX;
 					}
-					r.pixelsDrawn += maxX - minX;
+					t.pixelsDrawn += maxX - minX;
 					auto* ditherMap2 = ditherMap + ((y & 1) << 2);
-					for (int x = minX; x < maxX; x++) {
+					int x = minX;
+#if ENABLE_NEON
+					if (level == SWFeatureLevel::NEON && !depthTest) {
+						x += DrawTexturedSpanNEON(out, maxX - minX, vary.u.fp.counter,
+						                          vary.v.fp.counter, vary.u.fp.step,
+						                          vary.v.fp.step, tpixels, tw, th, mulR, mulG,
+						                          mulB, mulA,
+						                          linearInterpolate ? ditherMap2 : nullptr,
+						                          (minX & 1) != 0);
+						out += x - minX;
+					}
+#endif
+					for (; x < maxX; x++) {
 						auto vr = vary.GetCurrent();
 						unsigned int u = static_cast<unsigned int>(vr.u);
 						unsigned int v = static_cast<unsigned int>(vr.v);
@@ -411,8 +748,9 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x1, x2, y2 - y1);
 					SWImageGouraudInterpolator<level> shortSpan(v1, v2, y2 - y1);
-					int minY = std::max(0, y1);
-					int maxY = std::min(fbH, y2);
+					// don't let the long span skip past y2 when the upper half is clipped away
+					int minY = std::min(std::max(t.minY, y1), y2);
+					int maxY = std::min(t.maxY, y2);
 					shortSpanX.MoveNext(minY - y1);
 					shortSpan.MoveNext(minY - y1);
 					longSpanX.MoveNext(minY - y1);
@@ -440,8 +778,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x2, x3, y3 - y2);
 					SWImageGouraudInterpolator<level> shortSpan(v2, v3, y3 - y2);
-					int minY = std::max(0, y2);
-					int maxY = std::min(fbH, y3);
+					int minY = std::max(t.minY, y2);
+					int maxY = std::min(t.maxY, y3);
 					shortSpanX.MoveNext(minY - y2);
 					shortSpan.MoveNext(minY - y2);
 					longSpanX.MoveNext(minY - y2);
@@ -469,24 +807,29 @@ namespace spades {
 				// polygon, done!
 			}
 
-			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
-			                                const Vertex& v3, SWImageRenderer& r) {
+			static void Rasterize(SWImage* img, const Vertex& v1, const Vertex& v2,
+			                      const Vertex& v3, RasterTarget& t) {
 				if (v2.position.y < v1.position.y) {
 					if (v3.position.y < v2.position.y) {
-						DrawPolygonInternalInner(img, v3, v2, v1, r);
+						DrawPolygonInternalInner(img, v3, v2, v1, t);
 					} else if (v3.position.y < v1.position.y) {
-						DrawPolygonInternalInner(img, v2, v3, v1, r);
+						DrawPolygonInternalInner(img, v2, v3, v1, t);
 					} else {
-						DrawPolygonInternalInner(img, v2, v1, v3, r);
+						DrawPolygonInternalInner(img, v2, v1, v3, t);
 					}
 				} else if (v3.position.y < v1.position.y) {
-					DrawPolygonInternalInner(img, v3, v1, v2, r);
+					DrawPolygonInternalInner(img, v3, v1, v2, t);
 				} else if (v3.position.y < v2.position.y) {
-					DrawPolygonInternalInner(img, v1, v3, v2, r);
+					DrawPolygonInternalInner(img, v1, v3, v2, t);
 				} else {
-					DrawPolygonInternalInner(img, v1, v2, v3, r);
+					DrawPolygonInternalInner(img, v1, v2, v3, t);
 				}
 			}
+
+			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
+			                                const Vertex& v3, SWImageRenderer& r) {
+				r.Submit(&Rasterize, img, v1, v2, v3);
+			}
 		};
 
 		// TODO: Non-SSE2 renderer for solid polygons
@@ -499,26 +842,24 @@ namespace spades {
 		struct SWImageRenderer::PolygonRenderer<SWFeatureLevel::SSE2, false, false, depthTest,
 		                                        false, linearInterpolate> {
 
+			template <SWFeatureLevel spanLevel>
 			static void DrawPolygonInternalInner(SWImage* img, const Vertex& v1, const Vertex& v2,
-			                                     const Vertex& v3, SWImageRenderer& r) {
+			                                     const Vertex& v3, RasterTarget& t) {
 
-				Bitmap& fb = *r.frame;
-
-				if (v3.position.y <= 0.0F) {
+				if (v3.position.y <= static_cast<float>(t.minY)) {
 					// viewport cull
 					return;
 				}
 
-				const int fbW = fb.GetWidth();
-				const int fbH = fb.GetHeight();
-				uint32_t* const bmp = fb.GetPixels();
+				const int fbW = t.stride;
+				uint32_t* const bmp = t.pixels;
 
-				if (v1.position.y >= static_cast<float>(fbH)) {
+				if (v1.position.y >= static_cast<float>(t.maxY)) {
 					// viewport cull
 					return;
 				}
 
-				float* const depthBuffer = r.depthBuffer;
+				float* const depthBuffer = t.depthBuffer;
 				if (depthTest) {
 					SPAssert(depthBuffer != nullptr);
 				}
@@ -538,9 +879,9 @@ namespace spades {
 					return; // area cull
 				if (y1 == y3)
 					return; // area cull
-				if (std::min(std::min(x1, x2), x3) >= fbW)
+				if (std::min(std::min(x1, x2), x3) >= t.maxX)
 					return; // viewport cull
-				if (std::max(std::max(x1, x2), x3) <= 0)
+				if (std::max(std::max(x1, x2), x3) <= t.minX)
 					return; // viewport cull
 
 				auto convertColor = [](float v) {
@@ -708,7 +1049,7 @@ namespace spades {
 				};
 
 				auto drawScanline =
-				  [tw, th, tpixels, bmp, fbW, depthBuffer, &drawPixel, &drawPixel2, &r,
+				  [tw, th, tpixels, bmp, fbW, depthBuffer, mulCol, &drawPixel, &drawPixel2, &t,
 				   &ditherMap, &ditherMap2](int y, int x1, int x2, const SWImageVarying& vary1,
 				                            const SWImageVarying& vary2, float z1, float z2) {
 					  uint32_t* out = bmp + (y * fbW);
@@ -719,9 +1060,11 @@ namespace spades {
 					  SPAssert(x1 < x2);
 					  int width = x2 - x1;
 					  SWImageGouraudInterpolator<SWFeatureLevel::SSE2> vary(vary1, vary2, width);
-					  int minX = std::max(x1, 0);
-					  int maxX = std::min(x2, fbW);
-					  r.pixelsDrawn += maxX - minX;
+					  int minX = std::max(x1, t.minX);
+					  int maxX = std::min(x2, t.maxX);
+					  if (minX >= maxX)
+						  return; // outside the scissor rect
+					  t.pixelsDrawn += maxX - minX;
 					  vary.MoveNext(minX - x1);
 					  out += minX;
 					  if (depthTest) {
@@ -768,6 +1111,17 @@ namespace spades {
 						  unalignedPixel();
 						  minX++;
 					  }
+#if ENABLE_AVX2
+					  if (spanLevel == SWFeatureLevel::AVX2 && !depthTest) {
+						  const int16_t* dither =
+						    linearInterpolate ? ditherMap + ditherIndex * 2 : nullptr;
+						  int n = DrawTexturedSpanAVX2(out, maxX - minX, vary.uvU, vary.uvV,
+						                               vary.stepU, vary.stepV, tpixels, tw, th,
+						                               mulCol, dither);
+						  out += n;
+						  minX += n;
+					  }
+#endif
 					  int reminders = maxX & 1;
 					  maxX -= reminders;
 					  auto dither = ditherMap2[y & 1];
@@ -826,8 +1180,9 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x1, x2, y2 - y1);
 					SWImageGouraudInterpolator<SWFeatureLevel::SSE2> shortSpan(v1, v2, y2 - y1);
-					int minY = std::max(0, y1);
-					int maxY = std::min(fbH, y2);
+					// don't let the long span skip past y2 when the upper half is clipped away
+					int minY = std::min(std::max(t.minY, y1), y2);
+					int maxY = std::min(t.maxY, y2);
 					shortSpanX.MoveNext(minY - y1);
 					shortSpan.MoveNext(minY - y1);
 					longSpanX.MoveNext(minY - y1);
@@ -855,8 +1210,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x2, x3, y3 - y2);
 					SWImageGouraudInterpolator<SWFeatureLevel::SSE2> shortSpan(v2, v3, y3 - y2);
-					int minY = std::max(0, y2);
-					int maxY = std::min(fbH, y3);
+					int minY = std::max(t.minY, y2);
+					int maxY = std::min(t.maxY, y3);
 					shortSpanX.MoveNext(minY - y2);
 					shortSpan.MoveNext(minY - y2);
 					longSpanX.MoveNext(minY - y2);
@@ -884,24 +1239,30 @@ namespace spades {
 				// polygon, done!
 			}
 
-			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
-			                                const Vertex& v3, SWImageRenderer& r) {
+			template <SWFeatureLevel spanLevel>
+			static void Rasterize(SWImage* img, const Vertex& v1, const Vertex& v2,
+			                      const Vertex& v3, RasterTarget& t) {
 				if (v2.position.y < v1.position.y) {
 					if (v3.position.y < v2.position.y) {
-						DrawPolygonInternalInner(img, v3, v2, v1, r);
+						DrawPolygonInternalInner<spanLevel>(img, v3, v2, v1, t);
 					} else if (v3.position.y < v1.position.y) {
-						DrawPolygonInternalInner(img, v2, v3, v1, r);
+						DrawPolygonInternalInner<spanLevel>(img, v2, v3, v1, t);
 					} else {
-						DrawPolygonInternalInner(img, v2, v1, v3, r);
+						DrawPolygonInternalInner<spanLevel>(img, v2, v1, v3, t);
 					}
 				} else if (v3.position.y < v1.position.y) {
-					DrawPolygonInternalInner(img, v3, v1, v2, r);
+					DrawPolygonInternalInner<spanLevel>(img, v3, v1, v2, t);
 				} else if (v3.position.y < v2.position.y) {
-					DrawPolygonInternalInner(img, v1, v3, v2, r);
+					DrawPolygonInternalInner<spanLevel>(img, v1, v3, v2, t);
 				} else {
-					DrawPolygonInternalInner(img, v1, v2, v3, r);
+					DrawPolygonInternalInner<spanLevel>(img, v1, v2, v3, t);
 				}
 			}
+
+			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
+			                                const Vertex& v3, SWImageRenderer& r) {
+				r.Submit(&Rasterize<SWFeatureLevel::SSE2>, img, v1, v2, v3);
+			}
 		};
 
 #pragma mark Solid
@@ -909,26 +1270,24 @@ namespace spades {
 		struct SWImageRenderer::PolygonRenderer<SWFeatureLevel::SSE2, false, false, depthTest, true,
 		                                        lerp> {
 
+			template <SWFeatureLevel spanLevel>
 			static void DrawPolygonInternalInner(SWImage* img, const Vertex& v1, const Vertex& v2,
-			                                     const Vertex& v3, SWImageRenderer& r) {
+			                                     const Vertex& v3, RasterTarget& t) {
 
-				Bitmap& fb = *r.frame;
-
-				if (v3.position.y <= 0.f) {
+				if (v3.position.y <= static_cast<float>(t.minY)) {
 					// viewport cull
 					return;
 				}
 
-				const int fbW = fb.GetWidth();
-				const int fbH = fb.GetHeight();
-				uint32_t* const bmp = fb.GetPixels();
+				const int fbW = t.stride;
+				uint32_t* const bmp = t.pixels;
 
-				if (v1.position.y >= static_cast<float>(fbH)) {
+				if (v1.position.y >= static_cast<float>(t.maxY)) {
 					// viewport cull
 					return;
 				}
 
-				float* const depthBuffer = r.depthBuffer;
+				float* const depthBuffer = t.depthBuffer;
 				if (depthTest) {
 					SPAssert(depthBuffer != nullptr);
 				}
@@ -944,9 +1303,9 @@ namespace spades {
 					return; // area cull
 				if (y1 == y3)
 					return; // area cull
-				if (std::min(std::min(x1, x2), x3) >= fbW)
+				if (std::min(std::min(x1, x2), x3) >= t.maxX)
 					return; // viewport cull
-				if (std::max(std::max(x1, x2), x3) <= 0)
+				if (std::max(std::max(x1, x2), x3) <= t.minX)
 					return; // viewport cull
 
 				auto convertColor = [](float v) {
@@ -1035,8 +1394,9 @@ namespace spades {
 					_mm_store_sd(reinterpret_cast<double*>(dest), _mm_castsi128_pd(dcol));
 				};
 
-				auto drawScanline = [bmp, fbW, depthBuffer, &drawPixel, &drawPixel2, &r](int y, int x1, int x2,
-					const SWImageVarying& vary1, const SWImageVarying& vary2, float z1, float z2) {
+				auto drawScanline = [bmp, fbW, depthBuffer, mulCol, mulInv, &drawPixel, &drawPixel2,
+				                     &t](int y, int x1, int x2, const SWImageVarying& vary1,
+				                         const SWImageVarying& vary2, float z1, float z2) {
 					uint32_t* out = bmp + (y * fbW);
 					float* depthOut = nullptr;
 					if (depthTest) {
@@ -1044,9 +1404,11 @@ namespace spades {
 					}
 					SPAssert(x1 < x2);
 					// int width = x2 - x1;
-					int minX = std::max(x1, 0);
-					int maxX = std::min(x2, fbW);
-					r.pixelsDrawn += maxX - minX;
+					int minX = std::max(x1, t.minX);
+					int maxX = std::min(x2, t.maxX);
+					if (minX >= maxX)
+						return; // outside the scissor rect
+					t.pixelsDrawn += maxX - minX;
 					out += minX;
 					if (depthTest) {
 						depthOut += minX;
@@ -1065,6 +1427,13 @@ namespace spades {
 						unalignedPixel();
 						minX++;
 					}
+#if ENABLE_AVX2
+					if (spanLevel == SWFeatureLevel::AVX2 && !depthTest) {
+						int n = FillSpanAVX2(out, maxX - minX, mulCol, mulInv);
+						out += n;
+						minX += n;
+					}
+#endif
 					int reminders = maxX & 1;
 					maxX -= reminders;
 					/* for(int x = minX; x < maxX; x+=2) */
@@ -1090,8 +1459,9 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x1, x2, y2 - y1);
 					SWImageGouraudInterpolator<SWFeatureLevel::SSE2> shortSpan(v1, v2, y2 - y1);
-					int minY = std::max(0, y1);
-					int maxY = std::min(fbH, y2);
+					// don't let the long span skip past y2 when the upper half is clipped away
+					int minY = std::min(std::max(t.minY, y1), y2);
+					int maxY = std::min(t.maxY, y2);
 					shortSpanX.MoveNext(minY - y1);
 					shortSpan.MoveNext(minY - y1);
 					longSpanX.MoveNext(minY - y1);
@@ -1119,8 +1489,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x2, x3, y3 - y2);
 					SWImageGouraudInterpolator<SWFeatureLevel::SSE2> shortSpan(v2, v3, y3 - y2);
-					int minY = std::max(0, y2);
-					int maxY = std::min(fbH, y3);
+					int minY = std::max(t.minY, y2);
+					int maxY = std::min(t.maxY, y3);
 					shortSpanX.MoveNext(minY - y2);
 					shortSpan.MoveNext(minY - y2);
 					longSpanX.MoveNext(minY - y2);
@@ -1148,24 +1518,50 @@ namespace spades {
 				// polygon, done!
 			}
 
-			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
-			                                const Vertex& v3, SWImageRenderer& r) {
+			template <SWFeatureLevel spanLevel>
+			static void Rasterize(SWImage* img, const Vertex& v1, const Vertex& v2,
+			                      const Vertex& v3, RasterTarget& t) {
 				if (v2.position.y < v1.position.y) {
 					if (v3.position.y < v2.position.y) {
-						DrawPolygonInternalInner(img, v3, v2, v1, r);
+						DrawPolygonInternalInner<spanLevel>(img, v3, v2, v1, t);
 					} else if (v3.position.y < v1.position.y) {
-						DrawPolygonInternalInner(img, v2, v3, v1, r);
+						DrawPolygonInternalInner<spanLevel>(img, v2, v3, v1, t);
 					} else {
-						DrawPolygonInternalInner(img, v2, v1, v3, r);
+						DrawPolygonInternalInner<spanLevel>(img, v2, v1, v3, t);
 					}
 				} else if (v3.position.y < v1.position.y) {
-					DrawPolygonInternalInner(img, v3, v1, v2, r);
+					DrawPolygonInternalInner<spanLevel>(img, v3, v1, v2, t);
 				} else if (v3.position.y < v2.position.y) {
-					DrawPolygonInternalInner(img, v1, v3, v2, r);
+					DrawPolygonInternalInner<spanLevel>(img, v1, v3, v2, t);
 				} else {
-					DrawPolygonInternalInner(img, v1, v2, v3, r);
+					DrawPolygonInternalInner<spanLevel>(img, v1, v2, v3, t);
 				}
 			}
+
+			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
+			                                const Vertex& v3, SWImageRenderer& r) {
+				r.Submit(&Rasterize<SWFeatureLevel::SSE2>, img, v1, v2, v3);
+			}
+		};
+
+#endif
+
+#pragma mark - AVX2
+#if ENABLE_AVX2
+
+		// the SSE2 renderers with the wide spans. polygons with depth test (sprites) are
+		// drawn by the SSE2 spans.
+		template <bool depthTest, bool solidFill, bool linearInterpolate>
+		struct SWImageRenderer::PolygonRenderer<SWFeatureLevel::AVX2, false, false, depthTest,
+		                                        solidFill, linearInterpolate> {
+			typedef PolygonRenderer<SWFeatureLevel::SSE2, false, false, depthTest, solidFill,
+			                        linearInterpolate>
+			  SSE2Renderer;
+
+			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
+			                                const Vertex& v3, SWImageRenderer& r) {
+				r.Submit(&SSE2Renderer::template Rasterize<SWFeatureLevel::AVX2>, img, v1, v2, v3);
+			}
 		};
 
 #endif
@@ -1358,12 +1754,26 @@ namespace spades {
 			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
 			                                const Vertex& v3, SWImageRenderer& r,
 			                                SWFeatureLevel lvl) {
+#if ENABLE_AVX2
+				if (static_cast<int>(lvl) >= static_cast<int>(SWFeatureLevel::AVX2)) {
+					PolygonRenderer3<SWFeatureLevel::AVX2, needTransform, ndc, depthTest,
+					                 lerp>::DrawPolygonInternal(img, v1, v2, v3, r);
+					return;
+				}
+#endif
 #if ENABLE_SSE2
 				if (static_cast<int>(lvl) >= static_cast<int>(SWFeatureLevel::SSE2)) {
 					PolygonRenderer3<SWFeatureLevel::SSE2, needTransform, ndc, depthTest,
 					                 lerp>::DrawPolygonInternal(img, v1, v2, v3, r);
 					return;
 				}
+#endif
+#if ENABLE_NEON
+				if (static_cast<int>(lvl) >= static_cast<int>(SWFeatureLevel::NEON)) {
+					PolygonRenderer3<SWFeatureLevel::NEON, needTransform, ndc, depthTest,
+					                 lerp>::DrawPolygonInternal(img, v1, v2, v3, r);
+					return;
+				}
 #endif
 				PolygonRenderer3<SWFeatureLevel::None, needTransform, ndc, depthTest,
 				                 lerp>::DrawPolygonInternal(img, v1, v2, v3, r);
@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "SWFeatureLevel.h"
 #include <Core/Math.h>
 #include <Core/RefCountedObject.h>
@@ -39,6 +42,26 @@ namespace spades {
 			enum class ShaderType { Image, Sprite };
 
 		private:
+			/** The region of the framebuffer a polygon is rasterized into. */
+			struct RasterTarget {
+				std::uint32_t *pixels;
+				float *depthBuffer;
+				int stride;
+				int minX, minY, maxX, maxY;
+				unsigned long long pixelsDrawn;
+			};
+			typedef void (*RasterizeFunction)(SWImage *, const Vertex &, const Vertex &,
+			                                  const Vertex &, RasterTarget &);
+
+			/** A polygon in the screen space, recorded in the deferred mode. */
+			struct DeferredPolygon {
+				RasterizeFunction rasterize;
+				Handle<SWImage> image;
+				Vertex v1, v2, v3;
+			};
+
+			enum { TileSize = 64 };
+
 			Handle<Bitmap> frame;
 			float *depthBuffer;
 			ShaderType shader;
@@ -49,6 +72,17 @@ namespace spades {
 			SWFeatureLevel featureLevel;
 			unsigned long long pixelsDrawn;
 
+			bool deferred;
+			std::vector<DeferredPolygon> polygons;
+			/** The indices into `polygons` overlapping each tile, in the submission order. */
+			std::vector<std::vector<std::uint32_t>> tiles;
+			int numTilesX, numTilesY;
+
+			RasterTarget GetFullTarget();
+			/** Rasterizes a screen-space polygon, or records it in the deferred mode. */
+			void Submit(RasterizeFunction, SWImage *, const Vertex &, const Vertex &,
+			            const Vertex &);
+
 			template <SWFeatureLevel, bool, bool, bool, bool, bool> struct PolygonRenderer;
 
 			template <SWFeatureLevel, bool, bool, bool, bool> struct PolygonRenderer3;
@@ -68,6 +102,18 @@ namespace spades {
 
 			void DrawPolygon(SWImage *img, const Vertex &v1, const Vertex &v2, const Vertex &v3);
 
+			/**
+			 * In the deferred mode, `DrawPolygon` only records the polygons, which are binned
+			 * into screen tiles and rasterized in parallel by `Flush`. The polygons overlapping
+			 * a tile are drawn in the submission order, so the result is identical to the
+			 * immediate mode.
+			 *
+			 * The framebuffer must not be accessed in other ways until `Flush` is called.
+			 */
+			void SetDeferred(bool);
+			bool IsDeferred() { return deferred; }
+			void Flush();
+
 			unsigned long long GetPixelsDrawn() { return pixelsDrawn; }
 			void ResetPixelStatistics() { pixelsDrawn = 0; }
 		};
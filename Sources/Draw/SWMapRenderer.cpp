@@ -18,7 +18,9 @@
 
  */
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 
@@ -35,6 +37,8 @@
 using namespace std;
 
 DEFINE_SPADES_SETTING(r_swUndersampling, "0");
+DEFINE_SPADES_SETTING(r_swTargetFrameTime, "0");
+DEFINE_SPADES_SETTING(r_swReprojection, "1");
 
 namespace spades {
 	namespace draw {
@@ -67,6 +71,15 @@ namespace spades {
 
 		enum class Face : short { PosX, NegX, PosY, NegY, PosZ, NegZ };
 
+		// the horizontal distance a line is traced to
+		static const float lineLength = 128.0F;
+
+		// a line of the previous frame is reused if it was built at most this far from the
+		// camera and its pitch range covers the visible one. lines are built with a margin
+		// around the visible pitch range (in special tan) so they survive small rotations.
+		static const float reprojectionDistance = 1.0F / 64.0F;
+		static const float reprojectionMargin = 0.05F;
+
 		struct SWMapRenderer::LinePixel {
 			union {
 				struct {
@@ -83,25 +96,55 @@ namespace spades {
 				};
 			};
 
+			// the top 7 bits of `combined` hold the Z coordinate of the face so that `depth` can
+			// be recomputed for another view (see `depthOffsets`). empty pixels have the height
+			// `EmptyHeight`.
+			enum { HeightShift = 25, EmptyHeight = 127 };
+
 			// using "operator =" makes this struct non-POD
 			void Set(const LinePixel& p) { allData = p.allData; }
 
+			// replaces whatever the colour computation left above `filled`
+			inline void SetHeight(int z) {
+				combined = (combined & ((1U << HeightShift) - 1)) |
+				           static_cast<uint32_t>(z) << HeightShift;
+			}
+
 			inline void Clear() {
-				combined = 0;
+				combined = static_cast<uint32_t>(EmptyHeight) << HeightShift;
 				depth = 10000.0F;
 			}
 
-			inline bool IsEmpty() const { return combined == 0; }
+			inline bool IsEmpty() const {
+				return combined == static_cast<uint32_t>(EmptyHeight) << HeightShift;
+			}
 		};
 
 		// infinite length line from -z to +z
 		struct SWMapRenderer::Line {
 			std::vector<LinePixel> pixels;
+			// the horizontal distance of each pixel (0 if empty)
+			std::vector<float> distances;
 			Vector3 horizonDir;
 			float pitchTanMin;
+			float pitchTanMax;
 			float pitchScale;
 			int pitchTanMinI;
 			int pitchScaleI;
+
+			// travel distance -> view Z value factor
+			float zscale;
+
+			// the camera position and the yaw grid index (or -1) the pixels were built for
+			Vector3 origin;
+			int gridIndex = -1;
+
+			// the view the depths were computed for
+			Vector3 depthFront;
+			float depthOriginZ;
+
+			// set by `RenderInner` if the pixels of the previous frame can be reused
+			bool reusable = false;
 		};
 
 		SWMapRenderer::SWMapRenderer(SWRenderer& r, client::GameMap* m, SWFeatureLevel level)
@@ -112,6 +155,12 @@ namespace spades {
 		      map(m),
 		      frameBuf(nullptr),
 		      depthBuf(nullptr),
+		      linesPerTurn(0),
+		      firstLineIndex(0),
+		      numVisibleLines(0),
+		      undersampling(1),
+		      undersamplingCooldown(0),
+		      smoothedFrameTime(0.0),
 		      rleHeap(m->Width() * m->Height() * 64) {
 			rle.resize(w * h);
 			rleLen.resize(w * h);
@@ -213,10 +262,49 @@ namespace spades {
 
 			rle[idx] = ref;
 			rleLen[idx] = rleBuf.size() * sizeof(RleData);
+
+			InvalidateLines(x, y);
+		}
+
+		void SWMapRenderer::InvalidateLines(int x, int y) {
+			if (numVisibleLines == 0)
+				return;
+
+			// find the lines passing through the column (or its nearest wrapped copy), seen
+			// from anywhere the visible lines might have been built at
+			const Vector3& eye = sceneDef.viewOrigin;
+			float dx = static_cast<float>(x) + 0.5F - eye.x;
+			float dy = static_cast<float>(y) + 0.5F - eye.y;
+			dx -= static_cast<float>(w) * floorf(dx / static_cast<float>(w) + 0.5F);
+			dy -= static_cast<float>(h) * floorf(dy / static_cast<float>(h) + 0.5F);
+
+			float dist = sqrtf(dx * dx + dy * dy);
+			float radius = (0.5F + reprojectionDistance) * 1.5F;
+			if (dist > lineLength + radius)
+				return;
+
+			if (dist <= radius) {
+				for (size_t i = 0; i < numVisibleLines; i++)
+					lines[i].gridIndex = -1;
+				return;
+			}
+
+			float yaw = atan2f(dy, dx);
+			float spread = asinf(radius / dist);
+			float step = M_PI_F * 2.0F / static_cast<float>(linesPerTurn);
+			int minIndex = static_cast<int>(floorf((yaw - spread) / step)) - 1;
+			int maxIndex = static_cast<int>(ceilf((yaw + spread) / step)) + 1;
+			for (int k = minIndex; k <= maxIndex; k++) {
+				int i = (k - firstLineIndex) % linesPerTurn;
+				if (i < 0)
+					i += linesPerTurn;
+				if (static_cast<size_t>(i) < numVisibleLines)
+					lines[i].gridIndex = -1;
+			}
 		}
 
 		template <SWFeatureLevel flevel>
-		void SWMapRenderer::BuildLine(Line& line, float minPitch, float maxPitch) {
+		bool SWMapRenderer::BuildLine(Line& line, float minPitch, float maxPitch) {
 			// hard code for further optimization
 			enum { w = 512, h = 512 };
 			SPAssert(map->Width() == 512);
@@ -288,6 +376,40 @@ namespace spades {
 			float minTan = SpecialTan(minPitch);
 			float maxTan = SpecialTan(maxPitch);
 
+			line.zscale = Vector3::Dot(line.horizonDir, sceneDef.viewAxis[2]);
+
+			if (line.reusable) {
+				// reproject the previous frame's line unless its resolution has degraded
+				if (minPitch >= maxPitch)
+					return false;
+				if (minTan >= line.pitchTanMin && maxTan <= line.pitchTanMax &&
+				    line.pitchTanMax - line.pitchTanMin <=
+				      maxTan - minTan + reprojectionMargin * 4.0F) {
+					if (line.depthFront != sceneDef.viewAxis[2] ||
+					    line.depthOriginZ != sceneDef.viewOrigin.z) {
+						const float* depthOffsets = this->depthOffsets.data();
+						const float* distances = line.distances.data();
+						float zscale = line.zscale;
+						for (int i = 0; i < lineResolution; i++) {
+							auto& p = line.pixels[i];
+							p.depth = distances[i] * zscale +
+							          depthOffsets[p.combined >> LinePixel::HeightShift];
+						}
+						line.depthFront = sceneDef.viewAxis[2];
+						line.depthOriginZ = sceneDef.viewOrigin.z;
+					}
+					return false;
+				}
+			}
+
+			if (line.gridIndex >= 0 && minPitch < maxPitch) {
+				minTan = std::max(minTan - reprojectionMargin, -2.0F);
+				maxTan = std::min(maxTan + reprojectionMargin, 2.0F);
+			}
+			line.origin = sceneDef.viewOrigin;
+			line.depthFront = sceneDef.viewAxis[2];
+			line.depthOriginZ = sceneDef.viewOrigin.z;
+
 			{
 				float minDiff = lineResolution / 10000.0F;
 				if (maxTan < minTan + minDiff) {
@@ -297,6 +419,7 @@ namespace spades {
 			}
 
 			line.pitchTanMin = minTan;
+			line.pitchTanMax = maxTan;
 			line.pitchScale = lineResolution / (maxTan - minTan);
 			line.pitchTanMinI = static_cast<int>(minTan * 65536.0F);
 			line.pitchScaleI = static_cast<int>(line.pitchScale * 65536.0F);
@@ -343,14 +466,16 @@ namespace spades {
 			std::int_fast16_t irx = rx >> 9; // static_cast<int>(floorf(rx));
 			std::int_fast16_t iry = ry >> 9; // static_cast<int>(floorf(ry));
 
-			float fogDist = 128.0F;
+			float fogDist = lineLength;
 			float distance = 1.0E-20F; // traveled path
 			float invDist = 1.0F / distance;
 
 			// auto& pixels = line.pixels;
 
 			line.pixels.resize(lineResolution);
+			line.distances.assign(lineResolution, 0.0F);
 			auto* pixels = line.pixels.data(); // std::vector feels slow...
+			float* distances = line.distances.data();
 
 			const float transScale = static_cast<float>(lineResolution) / (maxTan - minTan);
 			const float transOffset = -minTan * transScale;
@@ -381,7 +506,7 @@ namespace spades {
 
 			// if culled out, bail out now (pixels are filled)
 			if (minPitch >= maxPitch)
-				return;
+				return true;
 
 			std::array<float, 65> zval; // precompute (z - cz) * some
 			for (size_t i = 0; i < zval.size(); i++)
@@ -395,18 +520,6 @@ namespace spades {
 				return static_cast<std::uint_fast16_t>(p);
 			};
 
-			// travel distance -> view Z value factor
-			float zscale = Vector3::Dot(line.horizonDir, sceneDef.viewAxis[2]);
-
-			// Z value -> view Z value factor
-			float heightScale = sceneDef.viewAxis[2].z;
-
-			std::array<float, 65> heightScaleVal; // precompute (heightScale * z)
-			for (size_t i = 0; i < zval.size(); i++)
-				heightScaleVal[i] = (static_cast<float>(i) * heightScale);
-
-			float depthBias = -cz * heightScale;
-
 			RleData* lastRle;
 			{
 				auto ref = rle[(irx & w - 1) + ((iry & h - 1) * w)];
@@ -519,15 +632,16 @@ namespace spades {
 
 				invDist = fastRcp(distance);
 
-				float medDist = distance * zscale + depthBias; //(distance + oldDistance) * 0.5F;
-
 				// check for new spans
 
-				auto BuildLinePixel = [&map](int x, int y, int z, Face face, float dist) {
+				auto BuildLinePixel = [&map, &line, this](int x, int y, int z, Face face, float dist,
+				                                          int height) {
 					LinePixel px;
-					px.depth = dist;
+					px.depth = dist * line.zscale + depthOffsets[height];
 #if ENABLE_SSE
-					if constexpr (flevel == SWFeatureLevel::SSE2) {
+					// the AVX2 level only differs in `RenderFinal`
+					if constexpr (static_cast<int>(flevel) >=
+					              static_cast<int>(SWFeatureLevel::SSE2)) {
 						__m128i m;
 						uint32_t col = map.GetColorWrapped(x, y, z);
 						m = _mm_setr_epi32(col, 0, 0, 0);
@@ -565,6 +679,7 @@ namespace spades {
 						px.combined = col;
 						px.filled = true;
 					}
+					px.SetHeight(height);
 					return px;
 				};
 
@@ -583,13 +698,14 @@ namespace spades {
 								std::uint_fast16_t p1 = transform(invDist, z);
 								std::uint_fast16_t p2 = transform(oldInvDist, z);
 								LinePixel px = BuildLinePixel(oirx, oiry, z,
-									Face::NegZ, medDist + heightScaleVal[z]);
+									Face::NegZ, distance, z);
 
 								for (std::uint_fast16_t j = p1; j < p2; j++) {
 									auto& p = pixels[j];
 									if (!p.IsEmpty())
 										continue;
 									p.Set(px);
+									distances[j] = distance;
 								}
 							}
 							ptr++;
@@ -601,13 +717,14 @@ namespace spades {
 								std::uint_fast16_t p1 = transform(invDist, z + 1);
 								std::uint_fast16_t p2 = transform(oldInvDist, z + 1);
 								LinePixel px = BuildLinePixel(oirx, oiry, z,
-									Face::PosZ, medDist + heightScaleVal[z + 1]);
+									Face::PosZ, distance, z + 1);
 
 								for (std::uint_fast16_t j = p2; j < p1; j++) {
 									auto& p = pixels[j];
 									if (!p.IsEmpty())
 										continue;
 									p.Set(px);
+									distances[j] = distance;
 								}
 							}
 							ptr++;
@@ -638,13 +755,14 @@ namespace spades {
 						savedZ = z + 1;
 						savedP = p2;
 
-						LinePixel px = BuildLinePixel(irx, iry, z, wallFace, medDist + heightScaleVal[z]);
+						LinePixel px = BuildLinePixel(irx, iry, z, wallFace, distance, z);
 
 						for (std::uint_fast16_t j = p1; j < p2; j++) {
 							auto& p = pixels[j];
 							if (!p.IsEmpty())
 								continue;
 							p.Set(px);
+							distances[j] = distance;
 						}
 					}
 
@@ -660,6 +778,8 @@ namespace spades {
 
 				// let's go to next voxel!
 			}
+
+			return true;
 		}
 
 #define tsize 5000
@@ -808,6 +928,20 @@ namespace spades {
 						std::int32_t pitchC = pitchA;
 						std::int32_t pitchDelta = (pitchB - pitchA) / blockSize;
 
+#if ENABLE_AVX2
+						if constexpr (flevel == SWFeatureLevel::AVX2) {
+							static_assert(blockSize == 8, "RenderColumnAVX2 draws 8 rows");
+							RenderColumnAVX2<under>(fb3, db3, fw, yawIndexC, yawDelta, pitchC,
+							                        pitchDelta, yawScale2, numLines);
+						} else
+#endif
+#if ENABLE_NEON
+						if constexpr (flevel == SWFeatureLevel::NEON) {
+							static_assert(blockSize == 8, "RenderColumnNEON draws 8 rows");
+							RenderColumnNEON<under>(fb3, db3, fw, yawIndexC, yawDelta, pitchC,
+							                        pitchDelta, yawScale2, numLines);
+						} else
+#endif
 						for (unsigned int y = 0; y < blockSize; y++) {
 							std::uint32_t yawIndex =
 							  static_cast<unsigned int>(yawIndexC << 8 >> 16);
@@ -897,6 +1031,132 @@ namespace spades {
 			} // fx
 		}
 
+#if ENABLE_AVX2
+		template <int under>
+		SPADES_TARGET_AVX2 void
+		SWMapRenderer::RenderColumnAVX2(uint32_t* fb, float* db, unsigned int fw,
+		                                std::int32_t yawIndex, std::int32_t yawDelta,
+		                                std::int32_t pitch, std::int32_t pitchDelta,
+		                                std::int32_t yawScale, unsigned int numLines) {
+			// the integer math of the scalar loop in `RenderFinal`, one row per lane
+			auto rows = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			auto yaw = _mm256_add_epi32(_mm256_set1_epi32(yawIndex),
+			                            _mm256_mullo_epi32(_mm256_set1_epi32(yawDelta), rows));
+			yaw = _mm256_srai_epi32(_mm256_slli_epi32(yaw, 8), 16);
+			yaw = _mm256_srli_epi32(_mm256_mullo_epi32(yaw, _mm256_set1_epi32(yawScale)), 16);
+			yaw = _mm256_srli_epi32(
+			  _mm256_mullo_epi32(yaw, _mm256_set1_epi32(static_cast<int>(numLines))), 16);
+
+			// fetch the pitch range of each row's line
+			const Line* lineList = lines.data();
+			auto lineOffsets =
+			  _mm256_mullo_epi32(yaw, _mm256_set1_epi32(static_cast<int>(sizeof(Line))));
+			auto pitchTanMin = _mm256_i32gather_epi32(&lineList->pitchTanMinI, lineOffsets, 1);
+			auto pitchScale = _mm256_i32gather_epi32(&lineList->pitchScaleI, lineOffsets, 1);
+
+			auto pitchIndex = _mm256_add_epi32(
+			  _mm256_set1_epi32(pitch), _mm256_mullo_epi32(_mm256_set1_epi32(pitchDelta), rows));
+			pitchIndex = _mm256_sub_epi32(_mm256_srai_epi32(pitchIndex, 13), pitchTanMin);
+
+			// keep the upper halves of the 64-bit products
+			auto productsEven = _mm256_mul_epi32(pitchIndex, pitchScale);
+			auto productsOdd = _mm256_mul_epi32(_mm256_srli_epi64(pitchIndex, 32),
+			                                    _mm256_srli_epi64(pitchScale, 32));
+			pitchIndex =
+			  _mm256_blend_epi32(_mm256_srli_epi64(productsEven, 32), productsOdd, 0xaa);
+			pitchIndex = _mm256_and_si256(pitchIndex, _mm256_set1_epi32(lineResolution - 1));
+
+			alignas(32) std::int32_t yaws[8], pitchIndices[8];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(yaws), yaw);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(pitchIndices), pitchIndex);
+
+			for (int y = 0; y < 8; y++) {
+				const auto& pix = lineList[yaws[y]].pixels[pitchIndices[y]];
+				if (under == 1) {
+					*fb = pix.combined;
+					*db = pix.depth;
+				} else if (under == 2) {
+					auto m = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pix));
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(fb), _mm_shuffle_epi32(m, 0));
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(db), _mm_shuffle_epi32(m, 0x55));
+				} else if (under == 4) {
+					auto m = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pix));
+					_mm_stream_si128(reinterpret_cast<__m128i*>(fb), _mm_shuffle_epi32(m, 0));
+					_mm_stream_si128(reinterpret_cast<__m128i*>(db), _mm_shuffle_epi32(m, 0x55));
+				}
+				fb += fw;
+				db += fw;
+			}
+		}
+#endif
+
+#if ENABLE_NEON
+		template <int under>
+		void SWMapRenderer::RenderColumnNEON(uint32_t* fb, float* db, unsigned int fw,
+		                                     std::int32_t yawIndex, std::int32_t yawDelta,
+		                                     std::int32_t pitch, std::int32_t pitchDelta,
+		                                     std::int32_t yawScale, unsigned int numLines) {
+			const Line* lineList = lines.data();
+			static const std::int32_t rowsData[] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+			for (int half = 0; half < 8; half += 4) {
+				int32x4_t rows = vld1q_s32(rowsData + half);
+				// the integer math of the scalar loop in `RenderFinal`, one row per lane
+				int32x4_t yawS = vaddq_s32(vdupq_n_s32(yawIndex),
+				                           vmulq_s32(vdupq_n_s32(yawDelta), rows));
+				yawS = vshrq_n_s32(vshlq_n_s32(yawS, 8), 16);
+				uint32x4_t yaw = vreinterpretq_u32_s32(yawS);
+				yaw = vshrq_n_u32(vmulq_u32(yaw, vdupq_n_u32(static_cast<uint32_t>(yawScale))), 16);
+				yaw = vshrq_n_u32(vmulq_u32(yaw, vdupq_n_u32(numLines)), 16);
+
+				uint32_t yaws[4];
+				std::int32_t pitchTanMins[4], pitchScales[4];
+				vst1q_u32(yaws, yaw);
+				for (int i = 0; i < 4; i++) {
+					pitchTanMins[i] = lineList[yaws[i]].pitchTanMinI;
+					pitchScales[i] = lineList[yaws[i]].pitchScaleI;
+				}
+
+				int32x4_t pitchIndex = vaddq_s32(vdupq_n_s32(pitch),
+				                                 vmulq_s32(vdupq_n_s32(pitchDelta), rows));
+				pitchIndex = vsubq_s32(vshrq_n_s32(pitchIndex, 13), vld1q_s32(pitchTanMins));
+
+				// keep the upper halves of the 64-bit products
+				int32x4_t pitchScale = vld1q_s32(pitchScales);
+				int64x2_t productsLow =
+				  vmull_s32(vget_low_s32(pitchIndex), vget_low_s32(pitchScale));
+				int64x2_t productsHigh =
+				  vmull_s32(vget_high_s32(pitchIndex), vget_high_s32(pitchScale));
+				pitchIndex =
+				  vcombine_s32(vshrn_n_s64(productsLow, 32), vshrn_n_s64(productsHigh, 32));
+				pitchIndex = vandq_s32(pitchIndex, vdupq_n_s32(lineResolution - 1));
+
+				std::int32_t pitchIndices[4];
+				vst1q_s32(pitchIndices, pitchIndex);
+
+				for (int y = 0; y < 4; y++) {
+					const auto& pix = lineList[yaws[y]].pixels[pitchIndices[y]];
+					if (under == 1) {
+						*fb = pix.combined;
+						*db = pix.depth;
+					} else {
+						uint32x4_t col = vdupq_n_u32(pix.combined);
+						float32x4_t depth = vdupq_n_f32(pix.depth);
+						if (under == 2) {
+							vst1_u32(fb, vget_low_u32(col));
+							vst1_f32(db, vget_low_f32(depth));
+						} else {
+							vst1q_u32(fb, col);
+							vst1q_f32(db, depth);
+						}
+					}
+					fb += fw;
+					db += fw;
+				}
+			}
+		}
+#endif
+
 		template <SWFeatureLevel flevel>
 		void SWMapRenderer::RenderInner(const client::SceneDefinition& def, Bitmap* frame,
 		                                float* depthBuffer) {
@@ -909,7 +1169,8 @@ namespace spades {
 			float pitchMin, pitchMax;
 			size_t numLines;
 
-			int under = r_swUndersampling;
+			int under = ChooseUndersampling();
+			bool reproject = r_swReprojection;
 
 			{
 				float fovX = tanf(def.fovX * 0.5F);
@@ -955,17 +1216,44 @@ namespace spades {
 				for (int i = lineResolution, j = 1; j <= i; j <<= 1)
 					lineResolution = j;
 
-				numLines = static_cast<size_t>((yawMax - yawMin) / interval);
-
-				int under = Clamp((int)r_swUndersampling, 1, 4);
-				numLines /= under;
+				int newLinesPerTurn = static_cast<int>(pi * 2.0F / interval) / under;
+				newLinesPerTurn = Clamp(newLinesPerTurn, 16, 16384);
+				if (newLinesPerTurn != linesPerTurn) {
+					for (Line& l : lines)
+						l.gridIndex = -1;
+					linesPerTurn = newLinesPerTurn;
+				}
 
-				if (numLines < 8)
-					numLines = 8;
-				if (numLines > 8192)
-					numLines = 8192;
+				// snap the lines to the yaw grid
+				float step = pi * 2.0F / static_cast<float>(linesPerTurn);
+				int first;
+				if (yawMax - yawMin >= pi * 2.0F) {
+					first = 0;
+					numLines = static_cast<size_t>(linesPerTurn);
+				} else {
+					first = static_cast<int>(floorf(yawMin / step));
+					numLines = static_cast<size_t>(ceilf((yawMax - first * step) / step));
+					numLines = std::min(numLines, static_cast<size_t>(linesPerTurn));
+					first %= linesPerTurn;
+					if (first < 0)
+						first += linesPerTurn;
+				}
+				yawMin = static_cast<float>(first) * step;
+				yawMax = yawMin + static_cast<float>(numLines) * step;
 
+				// move the previous frame's lines to their new places
 				lines.resize(std::max(numLines, lines.size()));
+				int shift = (first - firstLineIndex) % linesPerTurn;
+				if (shift > linesPerTurn / 2)
+					shift -= linesPerTurn;
+				if (shift < -linesPerTurn / 2)
+					shift += linesPerTurn;
+				if (shift > 0 && static_cast<size_t>(shift) < lines.size())
+					std::rotate(lines.begin(), lines.begin() + shift, lines.end());
+				else if (shift < 0 && static_cast<size_t>(-shift) < lines.size())
+					std::rotate(lines.begin(), lines.end() + shift, lines.end());
+				firstLineIndex = first;
+				numVisibleLines = numLines;
 			}
 
 			// calculate vector for each lines
@@ -974,28 +1262,55 @@ namespace spades {
 				Vector3 horiz = Vector3::Make(cosf(yawMin), sinf(yawMin), 0.0F);
 				float c = cosf(scl);
 				float s = sinf(scl);
+				float maxDistSq = reprojectionDistance * reprojectionDistance;
 				for (size_t i = 0; i < numLines; i++) {
 					Line& l = lines[i];
 					l.horizonDir = horiz;
 
+					int gridIndex =
+					  reproject ? (firstLineIndex + static_cast<int>(i)) % linesPerTurn : -1;
+					l.reusable = gridIndex >= 0 && l.gridIndex == gridIndex &&
+					             l.pixels.size() == static_cast<size_t>(lineResolution) &&
+					             (l.origin - def.viewOrigin).GetSquaredLength() <= maxDistSq;
+					l.gridIndex = gridIndex;
+
 					float x = horiz.x * c - horiz.y * s;
 					float y = horiz.x * s + horiz.y * c;
 					horiz.x = x;
 					horiz.y = y;
 				}
+				for (size_t i = numLines; i < lines.size(); i++)
+					lines[i].gridIndex = -1;
+			}
+
+			// view Z value of line pixels = horizontal distance * zscale + depthOffsets[height]
+			{
+				std::fill(depthOffsets.begin(), depthOffsets.end(), 10000.0F);
+				float heightScale = def.viewAxis[2].z;
+				for (int z = 0; z <= 64; z++)
+					depthOffsets[z] = (static_cast<float>(z) - def.viewOrigin.z) * heightScale;
 			}
 
+			std::atomic<unsigned int> numBuiltLines{0};
 			{
 				unsigned int nlines = static_cast<unsigned int>(numLines);
 				InvokeParallel2([&](unsigned int th, unsigned int numThreads) {
 					unsigned int start = th * nlines / numThreads;
 					unsigned int end = (th + 1) * nlines / numThreads;
+					unsigned int numBuilt = 0;
 
 					for (size_t i = start; i < end; i++)
-						BuildLine<flevel>(lines[i], pitchMin, pitchMax);
-				});
+						if (BuildLine<flevel>(lines[i], pitchMin, pitchMax))
+							numBuilt++;
+					numBuiltLines += numBuilt;
+				}, "SWMapRenderer::BuildLine");
 			}
 
+			auto& stats = renderer.frameStats;
+			stats.mapUndersampling = under;
+			stats.mapLines = static_cast<unsigned int>(numLines);
+			stats.mapLinesBuilt = numBuiltLines;
+
 			InvokeParallel2([&](unsigned int th, unsigned int numThreads) {
 				if (under <= 1) {
 					RenderFinal<flevel, 1>(yawMin, yawMax, static_cast<unsigned int>(numLines), th, numThreads);
@@ -1004,12 +1319,37 @@ namespace spades {
 				} else {
 					RenderFinal<flevel, 4>(yawMin, yawMax, static_cast<unsigned int>(numLines), th, numThreads);
 				}
-			});
+			}, "SWMapRenderer::RenderFinal");
 
 			frameBuf = nullptr;
 			depthBuf = nullptr;
 		}
 
+		int SWMapRenderer::ChooseUndersampling() {
+			int minUnder = Clamp((int)r_swUndersampling, 1, 4);
+			float targetTime = r_swTargetFrameTime;
+			if (targetTime <= 0.0F) {
+				undersampling = minUnder;
+				return undersampling;
+			}
+
+			// follow the smoothed render time of the last frames, giving each change a few
+			// frames to show its effect before deciding again
+			double frameTime = renderer.lastFrameStats.GetTotalTime() * 1000.0;
+			smoothedFrameTime += (frameTime - smoothedFrameTime) * 0.25;
+			if (undersamplingCooldown > 0) {
+				undersamplingCooldown--;
+			} else if (smoothedFrameTime > targetTime && undersampling < 4) {
+				undersampling *= 2;
+				undersamplingCooldown = 8;
+			} else if (smoothedFrameTime < targetTime * 0.5 && undersampling > minUnder) {
+				undersampling /= 2;
+				undersamplingCooldown = 8;
+			}
+			undersampling = Clamp(undersampling, minUnder, 4);
+			return undersampling;
+		}
+
 		void SWMapRenderer::Render(const client::SceneDefinition& def, Bitmap& frame,
 		                           float* depthBuffer) {
 			if (!depthBuffer)
@@ -1019,12 +1359,24 @@ namespace spades {
 			if (map->IsSolidWrapped(p.x, p.y, p.z))
 				return;
 
+#if ENABLE_AVX2
+			if (level >= SWFeatureLevel::AVX2) {
+				RenderInner<SWFeatureLevel::AVX2>(def, &frame, depthBuffer);
+				return;
+			}
+#endif
 #if ENABLE_SSE2
 			if (static_cast<int>(level) >= static_cast<int>(SWFeatureLevel::SSE2)) {
 				RenderInner<SWFeatureLevel::SSE2>(def, &frame, depthBuffer);
 				return;
 			}
 #endif
+#if ENABLE_NEON
+			if (level >= SWFeatureLevel::NEON) {
+				RenderInner<SWFeatureLevel::NEON>(def, &frame, depthBuffer);
+				return;
+			}
+#endif
 
 			RenderInner<SWFeatureLevel::None>(def, &frame, depthBuffer);
 		}
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -58,19 +59,53 @@ namespace spades {
 
 			int lineResolution;
 
+			// Lines are laid out on a fixed yaw grid of `linesPerTurn` lines per turn so that
+			// the lines of the previous frame can be reused when the camera barely moves.
+			// `lines[i]` is the grid line `firstLineIndex + i` (mod `linesPerTurn`).
+			int linesPerTurn;
+			int firstLineIndex;
+			size_t numVisibleLines;
+
+			/** The view Z value of a line pixel at the horizontal distance 0, by its height. */
+			std::array<float, 128> depthOffsets;
+
+			int undersampling;
+			int undersamplingCooldown;
+			double smoothedFrameTime;
+
 			typedef int8_t RleData;
 			std::vector<RleData> rleBuf;
 
 			MiniHeap rleHeap;
 
 			template <SWFeatureLevel level>
-			void BuildLine(Line& line, float minPitch, float maxPitch);
+			bool BuildLine(Line& line, float minPitch, float maxPitch);
 			void BuildRle(int x, int y, std::vector<RleData>&);
 
+			int ChooseUndersampling();
+			void InvalidateLines(int x, int y);
+
 			template <SWFeatureLevel level, int undersamp>
 			void RenderFinal(float yawMin, float yawMax, unsigned int numLines,
 			                 unsigned int threadId, unsigned int numThreads);
 
+#if ENABLE_AVX2
+			/** Draws a column of a `RenderFinal` block, computing its eight rows at once. */
+			template <int undersamp>
+			SPADES_TARGET_AVX2 void RenderColumnAVX2(std::uint32_t* fb, float* db, unsigned int fw,
+			                                         std::int32_t yawIndex, std::int32_t yawDelta,
+			                                         std::int32_t pitch, std::int32_t pitchDelta,
+			                                         std::int32_t yawScale, unsigned int numLines);
+#endif
+#if ENABLE_NEON
+			/** `RenderColumnAVX2` for NEON, four rows at a time. */
+			template <int undersamp>
+			void RenderColumnNEON(std::uint32_t* fb, float* db, unsigned int fw,
+			                      std::int32_t yawIndex, std::int32_t yawDelta, std::int32_t pitch,
+			                      std::int32_t pitchDelta, std::int32_t yawScale,
+			                      unsigned int numLines);
+#endif
+
 			template <SWFeatureLevel level>
 			void RenderInner(const client::SceneDefinition&, Bitmap* fb, float* depthBuffer);
 
@@ -34,11 +34,22 @@ namespace spades {
 			center *= 0.5F;
 			radius = center.GetLength();
 
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++) {
-
-					renderDataAddr.push_back(static_cast<uint32_t>(renderData.size()));
-
+			numPoints = 0;
+
+			auto addPoint = [&](int x, int y, int z, uint32_t data) {
+				if ((numPoints & 3) == 0)
+					points.push_back(PointGroup());
+				auto& g = points.back();
+				auto lane = numPoints & 3;
+				g.x[lane] = static_cast<float>(x);
+				g.y[lane] = static_cast<float>(y);
+				g.z[lane] = static_cast<float>(z);
+				g.data[lane] = data;
+				numPoints++;
+			};
+
+			for (int x = 0; x < w; x++) {
+				for (int y = 0; y < h; y++) {
 					uint64_t map = m.GetSolidBitsAt(x, y);
 					uint64_t map1 = x > 0 ? m.GetSolidBitsAt(x - 1, y) : 0;
 					uint64_t map2 = x < (w - 1) ? m.GetSolidBitsAt(x + 1, y) : 0;
@@ -58,8 +69,6 @@ namespace spades {
 							uint32_t encodedColor;
 							encodedColor =
 							  (col & 0xff00) | ((col & 0xff) << 16) | ((col & 0xff0000) >> 16);
-							encodedColor |= z << 24;
-							renderData.push_back(encodedColor);
 
 							auto material = static_cast<MaterialType>(col >> 24);
 
@@ -95,11 +104,9 @@ namespace spades {
 								normal = nx + ny * 3 + nz * 9;
 							}
 
-							renderData.push_back(normal);
+							addPoint(x, y, z, encodedColor | (normal << 24));
 						}
 					}
-
-					renderData.push_back(0xffffffffU);
 				}
 			}
 		}
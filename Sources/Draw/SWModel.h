@@ -33,12 +33,22 @@ namespace spades {
 		class SWModel : public client::IModel {
 			friend class SWModelRenderer;
 
+			/**
+			 * Four surface voxels in the SoA layout. `data` holds the color in the
+			 * framebuffer order and the normal index in the top 8 bits.
+			 */
+			struct PointGroup {
+				float x[4], y[4], z[4];
+				uint32_t data[4];
+			};
+
 			Handle<VoxelModel> rawModel;
 			float radius;
 			Vector3 center;
 
-			std::vector<uint32_t> renderData;
-			std::vector<uint32_t> renderDataAddr;
+			/** The surface voxels, the last group padded with zeros. */
+			std::vector<PointGroup> points;
+			std::size_t numPoints;
 
 		protected:
 			~SWModel();
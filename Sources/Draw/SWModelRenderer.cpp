@@ -18,6 +18,10 @@
 
  */
 
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
 #include "SWModelRenderer.h"
 #include "SWModel.h"
 #include "SWRenderer.h"
@@ -26,25 +30,16 @@
 #include <Core/Settings.h>
 #include <Core/Debug.h>
 #include <Core/Math.h>
+#include <Core/TraceProfiler.h>
 
 namespace spades {
 	namespace draw {
-		SWModelRenderer::SWModelRenderer(SWRenderer* r, SWFeatureLevel level) : r(r), level(level) {}
+		SWModelRenderer::SWModelRenderer(SWRenderer* r, SWFeatureLevel level)
+		    : r(r), level(level), immediate(false), numTilesX(0), numTilesY(0) {}
 		SWModelRenderer::~SWModelRenderer() {}
 
-		struct ZVals {
-			float zv[512];
-			ZVals() {
-				for (int i = 0; i < 512; i++)
-					zv[i] = static_cast<float>(i);
-			}
-			inline float operator[](size_t idx) const { return zv[idx]; }
-		};
-		static ZVals zvals;
-
-		template <SWFeatureLevel lvl>
-		void SWModelRenderer::RenderInner(spades::draw::SWModel& model,
-		                                  const client::ModelRenderParam& param) {
+		void SWModelRenderer::Render(spades::draw::SWModel& model,
+		                             const client::ModelRenderParam& param) {
 			auto& mat = param.matrix;
 			auto origin = mat.GetOrigin();
 			auto axis1 = mat.GetAxis(0);
@@ -56,12 +51,10 @@ namespace spades {
 			origin += axis2 * rawModelOrigin.y;
 			origin += axis3 * rawModelOrigin.z;
 
-			int w = rawModel.GetWidth();
-			int h = rawModel.GetHeight();
-			// int d = rawModel.GetDepth();
+			DrawCall dc;
 
 			// evaluate brightness for each normals
-			uint8_t brights[3 * 3 * 3 + 1];
+			std::array<uint8_t, 28>& brights = dc.brights;
 			{
 				auto lightVec = MakeVector3(0.f, -0.707f, -0.707f);
 				float dot1 = Vector3::Dot(axis1, lightVec) * fastRSqrt(axis1.GetSquaredLength());
@@ -140,149 +133,384 @@ namespace spades {
 
 				if (!r->SphereFrustrumCull(center, model.GetRadius() * sqrtf(largestAxis)))
 					return;
+
+				dc.depth = Vector3::Dot(center - r->sceneDef.viewOrigin, r->sceneDef.viewAxis[2]);
 			}
 
 			Bitmap& fbmp = *r->fb;
-			auto* fb = fbmp.GetPixels();
 			int fw = fbmp.GetWidth();
 			int fh = fbmp.GetHeight();
-			auto* db = r->depthBuffer.data();
 
 			Matrix4 viewproj = r->GetProjectionViewMatrix();
 			Vector4 ndc2scrscale = {fw * 0.5f, -fh * 0.5f, 1.f, 1.f};
-			// Vector4 ndc2scroff = {fw * 0.5f, fh * 0.5f, 0.f, 0.f};
-			int ndc2scroffX = fw >> 1;
-			int ndc2scroffY = fh >> 1;
 
-			// render each points
-			auto tOrigin = viewproj * MakeVector4(origin.x, origin.y, origin.z, 1.f);
-			auto tAxis1 = viewproj * MakeVector4(axis1.x, axis1.y, axis1.z, 0.f);
-			auto tAxis2 = viewproj * MakeVector4(axis2.x, axis2.y, axis2.z, 0.f);
-			auto tAxis3 = viewproj * MakeVector4(axis3.x, axis3.y, axis3.z, 0.f);
-			tOrigin *= ndc2scrscale;
-			tAxis1 *= ndc2scrscale;
-			tAxis2 *= ndc2scrscale;
-			tAxis3 *= ndc2scrscale;
-
-			float pointDiameter; // = largestAxis * 0.55f * fh * 0.5f;
+			dc.origin = viewproj * MakeVector4(origin.x, origin.y, origin.z, 1.f);
+			dc.axis1 = viewproj * MakeVector4(axis1.x, axis1.y, axis1.z, 0.f);
+			dc.axis2 = viewproj * MakeVector4(axis2.x, axis2.y, axis2.z, 0.f);
+			dc.axis3 = viewproj * MakeVector4(axis3.x, axis3.y, axis3.z, 0.f);
+			dc.origin *= ndc2scrscale;
+			dc.axis1 *= ndc2scrscale;
+			dc.axis2 *= ndc2scrscale;
+			dc.axis3 *= ndc2scrscale;
+
 			{
-				float largestAxis = tAxis1.GetSquaredLength();
-				largestAxis = std::max(largestAxis, tAxis2.GetSquaredLength());
-				largestAxis = std::max(largestAxis, tAxis3.GetSquaredLength());
-				pointDiameter = sqrtf(largestAxis);
+				float largestAxis = dc.axis1.GetSquaredLength();
+				largestAxis = std::max(largestAxis, dc.axis2.GetSquaredLength());
+				largestAxis = std::max(largestAxis, dc.axis3.GetSquaredLength());
+				dc.pointDiameter = sqrtf(largestAxis);
 			}
 
-			uint32_t customColor;
-			customColor = (ToFixed8(param.customColor.z)
-						| (ToFixed8(param.customColor.y) << 8)
-						| (ToFixed8(param.customColor.x) << 16));
+			dc.customColor = (ToFixed8(param.customColor.z)
+			                  | (ToFixed8(param.customColor.y) << 8)
+			                  | (ToFixed8(param.customColor.x) << 16));
 
-			auto v1 = tOrigin;
-			float zNear = r->sceneDef.zNear;
-			for (int x = 0; x < w; x++) {
-				auto v2 = v1;
-				for (int y = 0; y < h; y++) {
-					auto* mp = &model.renderData[model.renderDataAddr[x + y * w]];
-					while (*mp != -1) {
-						uint32_t data = *(mp++);
-						uint32_t normal = *(mp++);
-						int z = static_cast<int>(data >> 24);
-						// SPAssert(z < d);
-						SPAssert(z >= 0);
-
-						auto vv = v2 + tAxis3 * zvals[z];
-						if (vv.z < zNear)
-							continue;
+			dc.model = Handle<SWModel>(model);
+			drawCalls.push_back(std::move(dc));
+		}
 
-						// save Z value (don't divide this by W!)
-						float zval = vv.z;
+		namespace {
+			template <SWFeatureLevel lvl>
+			void FillSplat(uint32_t* fb, float* db, int fw, int minX, int minY, int maxX,
+			               int maxY, float zval, uint32_t color) {
+#if ENABLE_SSE2
+				auto zval4 = _mm_set1_ps(zval);
+				auto color4 = _mm_set1_epi32(static_cast<int>(color));
+#endif
+				for (int y = minY; y < maxY; y++) {
+					auto* fb2 = fb + y * fw;
+					auto* db2 = db + y * fw;
+					int x = minX;
+#if ENABLE_SSE2
+					if constexpr (lvl == SWFeatureLevel::SSE2) {
+						for (; x + 4 <= maxX; x += 4) {
+							auto depth = _mm_loadu_ps(db2 + x);
+							auto pass = _mm_cmplt_ps(zval4, depth);
+							depth = _mm_or_ps(_mm_and_ps(pass, zval4), _mm_andnot_ps(pass, depth));
+							_mm_storeu_ps(db2 + x, depth);
+
+							auto* p = reinterpret_cast<__m128i*>(fb2 + x);
+							auto passi = _mm_castps_si128(pass);
+							auto pixels = _mm_loadu_si128(p);
+							pixels = _mm_or_si128(_mm_and_si128(passi, color4),
+							                      _mm_andnot_si128(passi, pixels));
+							_mm_storeu_si128(p, pixels);
+						}
+					}
+#endif
+					for (; x < maxX; x++) {
+						if (zval < db2[x]) {
+							db2[x] = zval;
+							fb2[x] = color;
+						}
+					}
+				}
+			}
+		} // namespace
 
-						// use vv.z for point radius to be divided by W
-						vv.z = pointDiameter;
+		template <SWFeatureLevel lvl>
+		inline void SWModelRenderer::EmitSplat(int minX, int minY, int maxX, int maxY,
+		                                       float depth, uint32_t color,
+		                                       unsigned int thread) {
+			if (immediate) {
+				FillSplat<lvl>(r->fb->GetPixels(), r->depthBuffer.data(), r->fb->GetWidth(), minX,
+				               minY, maxX, maxY, depth, color);
+				return;
+			}
 
-						// perspective division
-						float scl = fastRcp(vv.w);
-						vv *= scl;
+			Splat s;
+			s.minX = static_cast<int16_t>(minX);
+			s.minY = static_cast<int16_t>(minY);
+			s.maxX = static_cast<int16_t>(maxX);
+			s.maxY = static_cast<int16_t>(maxY);
+			s.depth = depth;
+			s.color = color;
+
+			// the coordinates are clipped to the framebuffer and never negative
+			auto* threadBins = bins.data() + thread * numTilesX * numTilesY;
+			auto tx1 = static_cast<unsigned int>(minX) / TileSize;
+			auto tx2 = static_cast<unsigned int>(maxX - 1) / TileSize;
+			auto ty1 = static_cast<unsigned int>(minY) / TileSize;
+			auto ty2 = static_cast<unsigned int>(maxY - 1) / TileSize;
+			auto stride = static_cast<unsigned int>(numTilesX);
+			for (auto ty = ty1; ty <= ty2; ty++)
+				for (auto tx = tx1; tx <= tx2; tx++)
+					threadBins[tx + ty * stride].push_back(s);
+		}
 
-						int ix = static_cast<int>(vv.x) + ndc2scroffX;
-						int iy = static_cast<int>(vv.y) + ndc2scroffY;
-						int idm = static_cast<int>(vv.z + 0.99F);
-						idm = std::max(1, idm);
-						int minX = ix - (idm >> 1);
-						int minY = iy - (idm >> 1);
-						if (minX >= fw || minY >= fh)
-							continue;
-						int maxX = ix + idm;
-						int maxY = iy + idm;
-						if (maxX <= 0 || maxY <= 0)
-							continue;
+		template <SWFeatureLevel lvl>
+		void SWModelRenderer::SplatModel(const DrawCall& dc, unsigned int thread) {
+			SWModel& model = *dc.model;
+			int fw = r->fb->GetWidth();
+			int fh = r->fb->GetHeight();
+			int ndc2scroffX = fw >> 1;
+			int ndc2scroffY = fh >> 1;
+			float zNear = r->sceneDef.zNear;
+			const Vector4& o = dc.origin;
+			const Vector4& a1 = dc.axis1;
+			const Vector4& a2 = dc.axis2;
+			const Vector4& a3 = dc.axis3;
+			const auto& brights = dc.brights;
+			const SWModel::PointGroup* groups = model.points.data();
+			std::size_t numPoints = model.numPoints;
 
-						minX = std::max(minX, 0);
-						minY = std::max(minY, 0);
-						maxX = std::min(maxX, fw);
-						maxY = std::min(maxY, fh);
+#if ENABLE_SSE2
+			if constexpr (lvl == SWFeatureLevel::SSE2) {
+				auto ox = _mm_set1_ps(o.x), oy = _mm_set1_ps(o.y);
+				auto oz = _mm_set1_ps(o.z), ow = _mm_set1_ps(o.w);
+				auto a1x = _mm_set1_ps(a1.x), a1y = _mm_set1_ps(a1.y);
+				auto a1z = _mm_set1_ps(a1.z), a1w = _mm_set1_ps(a1.w);
+				auto a2x = _mm_set1_ps(a2.x), a2y = _mm_set1_ps(a2.y);
+				auto a2z = _mm_set1_ps(a2.z), a2w = _mm_set1_ps(a2.w);
+				auto a3x = _mm_set1_ps(a3.x), a3y = _mm_set1_ps(a3.y);
+				auto a3z = _mm_set1_ps(a3.z), a3w = _mm_set1_ps(a3.w);
+				auto zNear4 = _mm_set1_ps(zNear);
+				auto diameter4 = _mm_set1_ps(dc.pointDiameter);
+				auto roundUp4 = _mm_set1_ps(0.99F);
+				auto offX4 = _mm_set1_epi32(ndc2scroffX);
+				auto offY4 = _mm_set1_epi32(ndc2scroffY);
+				auto fw4 = _mm_set1_epi32(fw);
+				auto fh4 = _mm_set1_epi32(fh);
+				auto one4 = _mm_set1_epi32(1);
+				auto zero4 = _mm_setzero_si128();
+				auto colorMask4 = _mm_set1_epi32(0xFFFFFF);
+				auto customColor4 = _mm_set1_epi32(static_cast<int>(dc.customColor));
+
+				alignas(16) int32_t minX[4], minY[4], maxX[4], maxY[4];
+				alignas(16) float zval[4];
+				alignas(16) uint32_t colors[4];
+
+				std::size_t numGroups = (numPoints + 3) >> 2;
+				for (std::size_t i = 0; i < numGroups; i++) {
+					const auto& g = groups[i];
+					auto px = _mm_loadu_ps(g.x);
+					auto py = _mm_loadu_ps(g.y);
+					auto pz = _mm_loadu_ps(g.z);
+
+					// same evaluation order as the scalar path
+					auto x = _mm_add_ps(_mm_add_ps(_mm_add_ps(ox, _mm_mul_ps(a1x, px)),
+					                               _mm_mul_ps(a2x, py)),
+					                    _mm_mul_ps(a3x, pz));
+					auto y = _mm_add_ps(_mm_add_ps(_mm_add_ps(oy, _mm_mul_ps(a1y, px)),
+					                               _mm_mul_ps(a2y, py)),
+					                    _mm_mul_ps(a3y, pz));
+					auto z = _mm_add_ps(_mm_add_ps(_mm_add_ps(oz, _mm_mul_ps(a1z, px)),
+					                               _mm_mul_ps(a2z, py)),
+					                    _mm_mul_ps(a3z, pz));
+					auto w = _mm_add_ps(_mm_add_ps(_mm_add_ps(ow, _mm_mul_ps(a1w, px)),
+					                               _mm_mul_ps(a2w, py)),
+					                    _mm_mul_ps(a3w, pz));
+					auto visible = _mm_castps_si128(_mm_cmpnlt_ps(z, zNear4));
+
+					// perspective division
+					auto scl = _mm_rcp_ps(w);
+					auto ix = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(x, scl)), offX4);
+					auto iy = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(y, scl)), offY4);
+					auto idm =
+					  _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(diameter4, scl), roundUp4));
+					auto large = _mm_cmpgt_epi32(idm, one4);
+					idm = _mm_or_si128(_mm_and_si128(large, idm), _mm_andnot_si128(large, one4));
+
+					auto half = _mm_srai_epi32(idm, 1);
+					auto minX4 = _mm_sub_epi32(ix, half);
+					auto minY4 = _mm_sub_epi32(iy, half);
+					auto maxX4 = _mm_add_epi32(ix, idm);
+					auto maxY4 = _mm_add_epi32(iy, idm);
+					visible = _mm_and_si128(visible, _mm_cmplt_epi32(minX4, fw4));
+					visible = _mm_and_si128(visible, _mm_cmplt_epi32(minY4, fh4));
+					visible = _mm_and_si128(visible, _mm_cmpgt_epi32(maxX4, zero4));
+					visible = _mm_and_si128(visible, _mm_cmpgt_epi32(maxY4, zero4));
+
+					int mask = _mm_movemask_ps(_mm_castsi128_ps(visible));
+					std::size_t remaining = numPoints - (i << 2);
+					if (remaining < 4)
+						mask &= (1 << remaining) - 1;
+					if (mask == 0)
+						continue;
+
+					// lighting
+					uint32_t b[4];
+					for (int lane = 0; lane < 4; lane++) {
+						uint32_t normal = g.data[lane] >> 24;
+						SPAssert(normal < 28);
+						b[lane] = brights[normal];
+					}
+					auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g.data));
+					auto color = _mm_and_si128(data, colorMask4);
+					auto custom = _mm_cmpeq_epi32(color, zero4);
+					color = _mm_or_si128(_mm_andnot_si128(custom, color),
+					                     _mm_and_si128(custom, customColor4));
+					auto f = _mm_setr_epi32(static_cast<int>(b[0]), static_cast<int>(b[1]),
+					                        static_cast<int>(b[2]), static_cast<int>(b[3]));
+					f = _mm_slli_epi16(_mm_or_si128(f, _mm_slli_epi32(f, 16)), 8);
+					auto lo = _mm_unpacklo_epi8(color, zero4);
+					auto hi = _mm_unpackhi_epi8(color, zero4);
+					lo = _mm_mulhi_epu16(lo, _mm_unpacklo_epi32(f, f));
+					hi = _mm_mulhi_epu16(hi, _mm_unpackhi_epi32(f, f));
+					color = _mm_packus_epi16(lo, hi);
+
+					_mm_store_si128(reinterpret_cast<__m128i*>(minX), minX4);
+					_mm_store_si128(reinterpret_cast<__m128i*>(minY), minY4);
+					_mm_store_si128(reinterpret_cast<__m128i*>(maxX), maxX4);
+					_mm_store_si128(reinterpret_cast<__m128i*>(maxY), maxY4);
+					_mm_store_ps(zval, z);
+					_mm_store_si128(reinterpret_cast<__m128i*>(colors), color);
+
+					for (int lane = 0; lane < 4; lane++) {
+						if (!(mask & (1 << lane)))
+							continue;
+						EmitSplat<lvl>(std::max(minX[lane], 0), std::max(minY[lane], 0),
+						          std::min(maxX[lane], fw), std::min(maxY[lane], fh), zval[lane],
+						          colors[lane], thread);
+					}
+				}
+				return;
+			}
+#endif
 
-						auto* fb2 = fb + (minX + minY * fw);
-						auto* db2 = db + (minX + minY * fw);
-						int w = maxX - minX;
+			for (std::size_t i = 0; i < numPoints; i++) {
+				const auto& g = groups[i >> 2];
+				std::size_t lane = i & 3;
+				float px = g.x[lane], py = g.y[lane], pz = g.z[lane];
+
+				// save Z value (don't divide this by W!)
+				float zval = o.z + a1.z * px + a2.z * py + a3.z * pz;
+				if (zval < zNear)
+					continue;
+				float vx = o.x + a1.x * px + a2.x * py + a3.x * pz;
+				float vy = o.y + a1.y * px + a2.y * py + a3.y * pz;
+				float vw = o.w + a1.w * px + a2.w * py + a3.w * pz;
+
+				// perspective division
+				float scl = fastRcp(vw);
+
+				int ix = static_cast<int>(vx * scl) + ndc2scroffX;
+				int iy = static_cast<int>(vy * scl) + ndc2scroffY;
+				int idm = static_cast<int>(dc.pointDiameter * scl + 0.99F);
+				idm = std::max(1, idm);
+				int minX = ix - (idm >> 1);
+				int minY = iy - (idm >> 1);
+				if (minX >= fw || minY >= fh)
+					continue;
+				int maxX = ix + idm;
+				int maxY = iy + idm;
+				if (maxX <= 0 || maxY <= 0)
+					continue;
+
+				uint32_t data = g.data[lane];
+				uint32_t color = data & 0xFFFFFF;
+				if (color == 0)
+					color = dc.customColor;
+
+				uint32_t normal = data >> 24;
+				SPAssert(normal < 28);
+				uint32_t bright = brights[normal];
+				uint32_t c1 = color & 0xFF00;
+				uint32_t c2 = color & 0xFF00FF;
+				c1 *= bright;
+				c2 *= bright;
+				color = ((c1 & 0xFF0000) | (c2 & 0xFF00FF00)) >> 8;
+
+				EmitSplat<lvl>(std::max(minX, 0), std::max(minY, 0), std::min(maxX, fw),
+				          std::min(maxY, fh), zval, color, thread);
+			}
+		}
 
-						uint32_t color = data & 0xFFFFFF;
-						if (color == 0)
-							color = customColor;
+		template <SWFeatureLevel lvl> void SWModelRenderer::RasterizeTile(int tile) {
+			Bitmap& fbmp = *r->fb;
+			auto* fb = fbmp.GetPixels();
+			int fw = fbmp.GetWidth();
+			int fh = fbmp.GetHeight();
+			auto* db = r->depthBuffer.data();
+			int numTiles = numTilesX * numTilesY;
+
+			int tileMinX = (tile % numTilesX) * TileSize;
+			int tileMinY = (tile / numTilesX) * TileSize;
+			int tileMaxX = std::min(tileMinX + TileSize, fw);
+			int tileMaxY = std::min(tileMinY + TileSize, fh);
+
+			// the bins of the lower threads hold the nearer models
+			for (int thread = 0; thread < MaxThreads; thread++) {
+				auto& bin = bins[static_cast<std::size_t>(thread * numTiles + tile)];
+				for (const Splat& s : bin) {
+					FillSplat<lvl>(fb, db, fw, std::max<int>(s.minX, tileMinX),
+					               std::max<int>(s.minY, tileMinY), std::min<int>(s.maxX, tileMaxX),
+					               std::min<int>(s.maxY, tileMaxY), s.depth, s.color);
+				}
+				bin.clear();
+			}
+		}
 
-						SPAssert(normal < 28);
-						int bright = brights[normal];
-#if ENABLE_SSE2
-						if constexpr (lvl == SWFeatureLevel::SSE2) {
-							auto m = _mm_setr_epi32(color, 0, 0, 0);
-							auto f = _mm_set1_epi16(bright << 8);
+		void SWModelRenderer::Flush() {
+			if (drawCalls.empty())
+				return;
+			SPADES_TRACE_ZONE("SWModelRenderer::Flush");
 
-							m = _mm_unpacklo_epi8(m, _mm_setzero_si128());
-							m = _mm_mulhi_epu16(m, f);
-							m = _mm_packus_epi16(m, m);
+			// front to back, so that the occluded splats fail the depth test early
+			order.resize(drawCalls.size());
+			std::iota(order.begin(), order.end(), 0U);
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				return drawCalls[a].depth < drawCalls[b].depth;
+			});
 
-							_mm_store_ss(reinterpret_cast<float*>(&color), _mm_castsi128_ps(m));
-						} else
+			bool useSSE2 = false;
+#if ENABLE_SSE2
+			useSSE2 = static_cast<int>(level) >= static_cast<int>(SWFeatureLevel::SSE2);
 #endif
-						{
-							uint32_t c1 = color & 0xFF00;
-							uint32_t c2 = color & 0xFF00FF;
-							c1 *= bright;
-							c2 *= bright;
-							color = ((c1 & 0xFF0000) | (c2 & 0xFF00FF00)) >> 8;
-						}
-
-						for (int yy = minY; yy < maxY; yy++) {
-							auto* fb3 = fb2;
-							auto* db3 = db2;
-
-							for (int xx = w; xx > 0; xx--) {
-								if (zval < *db3) {
-									*db3 = zval;
-									*fb3 = color;
-								}
-								fb3++;
-								db3++;
-							}
-
-							fb2 += fw;
-							db2 += fw;
-						}
-					}
-					v2 += tAxis2;
+			auto splat = [&](const DrawCall& dc, unsigned int thread) {
+#if ENABLE_SSE2
+				if (useSSE2) {
+					SplatModel<SWFeatureLevel::SSE2>(dc, thread);
+					return;
 				}
-				v1 += tAxis1;
+#endif
+				SplatModel<SWFeatureLevel::None>(dc, thread);
+			};
+
+			// Binning only pays off with more than one thread. Filling the splats right
+			// away in the sorted order produces the same image.
+			immediate = GetNumSWRendererThreads() <= 1;
+			if (immediate) {
+				for (uint32_t index : order)
+					splat(drawCalls[index], 0);
+				drawCalls.clear();
+				return;
 			}
-		}
 
-		void SWModelRenderer::Render(spades::draw::SWModel& model,
-		                             const client::ModelRenderParam& param) {
+			Bitmap& fbmp = *r->fb;
+			numTilesX = (fbmp.GetWidth() + TileSize - 1) / TileSize;
+			numTilesY = (fbmp.GetHeight() + TileSize - 1) / TileSize;
+			const int numTiles = numTilesX * numTilesY;
+			bins.resize(static_cast<std::size_t>(numTiles * MaxThreads));
+
+			// each thread takes a contiguous range of the sorted models, so the bins
+			// concatenated in the thread order preserve the sorted order
+			InvokeParallel2(
+			  [&](unsigned int th, unsigned int numThreads) {
+				  std::size_t n = order.size();
+				  std::size_t begin = n * th / numThreads;
+				  std::size_t end = n * (th + 1) / numThreads;
+				  for (std::size_t i = begin; i < end; i++)
+					  splat(drawCalls[order[i]], th);
+			  },
+			  "SWModelRenderer::Splat");
+
+			std::atomic<int> nextTile{0};
+			InvokeParallel2(
+			  [&](unsigned int, unsigned int) {
+				  int tile;
+				  while ((tile = nextTile.fetch_add(1)) < numTiles) {
 #if ENABLE_SSE2
-			if (static_cast<int>(level) >= static_cast<int>(SWFeatureLevel::SSE2)) {
-				RenderInner<SWFeatureLevel::SSE2>(model, param);
-			} else
+					  if (useSSE2) {
+						  RasterizeTile<SWFeatureLevel::SSE2>(tile);
+						  continue;
+					  }
 #endif
-				RenderInner<SWFeatureLevel::None>(model, param);
+					  RasterizeTile<SWFeatureLevel::None>(tile);
+				  }
+			  },
+			  "SWModelRenderer::Rasterize");
+
+			drawCalls.clear();
 		}
 	} // namespace draw
-} // namespace spades
\ No newline at end of file
+} // namespace spades
@@ -20,26 +20,78 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <vector>
+
 #include "SWFeatureLevel.h"
 #include <Client/IRenderer.h>
+#include <Core/Math.h>
+#include <Core/RefCountedObject.h>
 
 namespace spades {
 	namespace draw {
 		class SWModel;
 		class SWRenderer;
+
+		/**
+		 * Renders voxel models as screen-aligned squares ("splats").
+		 *
+		 * `Render` only records the models. `Flush` sorts them front to back, transforms
+		 * their voxels in parallel into per-thread bins of screen tiles, and then fills
+		 * the tiles in parallel. The splats overlapping a tile are drawn in the sorted
+		 * order regardless of the number of threads, so the image does not depend on it.
+		 */
 		class SWModelRenderer {
 			friend class SWRenderer;
+
+			/** A model to be drawn, with everything `Flush` needs precomputed. */
+			struct DrawCall {
+				Handle<SWModel> model;
+				/** The model space axes in the screen space (before the perspective division). */
+				Vector4 origin, axis1, axis2, axis3;
+				float pointDiameter;
+				/** The view space depth of the model center, used for sorting. */
+				float depth;
+				std::array<std::uint8_t, 28> brights;
+				std::uint32_t customColor;
+			};
+
+			/** A lit voxel clipped to the framebuffer. */
+			struct Splat {
+				std::int16_t minX, minY, maxX, maxY;
+				float depth;
+				std::uint32_t color;
+			};
+
+			enum { TileSize = 64, MaxThreads = 32 };
+
 			SWRenderer *r;
 			SWFeatureLevel level;
 
+			std::vector<DrawCall> drawCalls;
+			std::vector<std::uint32_t> order;
+			/** Whether `Flush` fills the splats right away instead of binning them. */
+			bool immediate;
+			/** `bins[thread * numTiles + tile]` holds the splats a thread emitted for a tile. */
+			std::vector<std::vector<Splat>> bins;
+			int numTilesX, numTilesY;
+
 			template <SWFeatureLevel>
-			void RenderInner(SWModel &model, const client::ModelRenderParam &param);
+			void SplatModel(const DrawCall &, unsigned int thread);
+			template <SWFeatureLevel> void RasterizeTile(int tile);
+			template <SWFeatureLevel>
+			void EmitSplat(int minX, int minY, int maxX, int maxY, float depth,
+			               std::uint32_t color, unsigned int thread);
 
 		public:
 			SWModelRenderer(SWRenderer *, SWFeatureLevel level);
 			~SWModelRenderer();
 
 			void Render(SWModel &model, const client::ModelRenderParam &param);
+
+			/** Draws all models recorded by `Render` since the last call. */
+			void Flush();
 		};
 	} // namespace draw
 } // namespace spades
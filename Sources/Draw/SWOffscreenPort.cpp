@@ -0,0 +1,34 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "SWOffscreenPort.h"
+#include <Core/Debug.h>
+#include <Core/Exception.h>
+
+namespace spades {
+	namespace draw {
+		SWOffscreenPort::SWOffscreenPort(int width, int height) : numSwaps(0) {
+			SPADES_MARK_FUNCTION();
+			if (width <= 0 || height <= 0 || (width & 7) || (height & 7))
+				SPRaise("Invalid offscreen framebuffer size: %dx%d", width, height);
+			framebuffer = Handle<Bitmap>::New(width, height);
+		}
+	} // namespace draw
+} // namespace spades
@@ -0,0 +1,50 @@
+/*
+ Copyright (c) 2026 OpenSpades developers
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include "SWPort.h"
+
+namespace spades {
+	namespace draw {
+		/**
+		 * A `SWPort` rendering into an in-memory `Bitmap` without presenting it anywhere.
+		 * Useful for capturing images and for benchmarking the software renderer without a
+		 * window.
+		 */
+		class SWOffscreenPort : public SWPort {
+			Handle<Bitmap> framebuffer;
+			int numSwaps;
+
+		protected:
+			~SWOffscreenPort() {}
+
+		public:
+			/** `width` and `height` must be multiples of 8, as `SWRenderer` requires. */
+			SWOffscreenPort(int width, int height);
+
+			Bitmap &GetFramebuffer() override { return *framebuffer; }
+			void Swap() override { numSwaps++; }
+
+			/** Returns the number of frames presented so far. */
+			int GetNumSwaps() { return numSwaps; }
+		};
+	} // namespace draw
+} // namespace spades
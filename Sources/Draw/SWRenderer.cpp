@@ -34,11 +34,13 @@
 #include <Client/GameMap.h>
 #include <Core/Bitmap.h>
 #include <Core/Settings.h>
+#include <Core/TraceProfiler.h>
 
 #include "SWUtils.h"
 
 DEFINE_SPADES_SETTING(r_swStatistics, "0");
 DEFINE_SPADES_SETTING(r_swNumThreads, "4");
+DEFINE_SPADES_SETTING(r_swDeferredImages, "1");
 
 SPADES_SETTING(r_dlights);
 
@@ -75,6 +77,7 @@ namespace spades {
 			SPLog("creating image renderer");
 			imageRenderer = std::make_shared<SWImageRenderer>(featureLevel);
 			imageRenderer->ResetPixelStatistics();
+			imageRenderer->SetDeferred(r_swDeferredImages);
 			renderStopwatch.Reset();
 
 			SPLog("setting framebuffer.");
@@ -225,7 +228,195 @@ namespace spades {
 			  sceneDef.viewOrigin, sceneDef.viewAxis[2] * ySin + sceneDef.viewAxis[1] * yCos);
 		}
 
-		template <SWFeatureLevel> void SWRenderer::ApplyDynamicLight(const DynamicLight& light) {
+#if ENABLE_AVX2
+		namespace {
+			/**
+			 * Lights the pixels of a row of `ApplyDynamicLight` eight at a time, and returns
+			 * the number of pixels processed. The result is identical to the scalar path.
+			 */
+			SPADES_TARGET_AVX2 int LightSpanAVX2(uint32_t* fb, const float* db, const float* vxs,
+			                                     int width, float vy, const Vector3& center,
+			                                     float invRadius2, int lightR, int lightG,
+			                                     int lightB) {
+				auto vy8 = _mm256_set1_ps(vy);
+				auto centerX = _mm256_set1_ps(center.x);
+				auto centerY = _mm256_set1_ps(center.y);
+				auto centerZ = _mm256_set1_ps(center.z);
+				auto invRadius28 = _mm256_set1_ps(invRadius2);
+				auto one = _mm256_set1_ps(1.0F);
+				auto mask = _mm256_set1_epi32(0xff);
+				auto lightR8 = _mm256_set1_epi32(lightR);
+				auto lightG8 = _mm256_set1_epi32(lightG);
+				auto lightB8 = _mm256_set1_epi32(lightB);
+
+				int x = 0;
+				for (; x + 8 <= width; x += 8) {
+					auto z = _mm256_loadu_ps(db + x);
+					auto px = _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(vxs + x), z), centerX);
+					auto py = _mm256_sub_ps(_mm256_mul_ps(vy8, z), centerY);
+					auto pz = _mm256_sub_ps(z, centerZ);
+
+					auto dist = _mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py));
+					dist = _mm256_add_ps(dist, _mm256_mul_ps(pz, pz));
+					dist = _mm256_mul_ps(dist, invRadius28);
+
+					auto lit = _mm256_castps_si256(_mm256_cmp_ps(dist, one, _CMP_LT_OQ));
+					if (_mm256_testz_si256(lit, lit))
+						continue;
+
+					auto strength = _mm256_sub_ps(one, dist);
+					strength = _mm256_mul_ps(strength, strength);
+					strength = _mm256_mul_ps(strength, _mm256_set1_ps(256.0F));
+					auto factor = _mm256_cvttps_epi32(strength);
+
+					auto* out = reinterpret_cast<__m256i*>(fb + x);
+					auto src = _mm256_loadu_si256(out);
+					auto srcR = _mm256_and_si256(_mm256_srli_epi32(src, 16), mask);
+					auto srcG = _mm256_and_si256(_mm256_srli_epi32(src, 8), mask);
+					auto srcB = _mm256_and_si256(src, mask);
+
+					auto destR = _mm256_mullo_epi32(_mm256_mullo_epi32(lightR8, factor), srcR);
+					auto destG = _mm256_mullo_epi32(_mm256_mullo_epi32(lightG8, factor), srcG);
+					auto destB = _mm256_mullo_epi32(_mm256_mullo_epi32(lightB8, factor), srcB);
+					destR = _mm256_min_epu32(_mm256_add_epi32(_mm256_srli_epi32(destR, 16), srcR),
+					                         mask);
+					destG = _mm256_min_epu32(_mm256_add_epi32(_mm256_srli_epi32(destG, 16), srcG),
+					                         mask);
+					destB = _mm256_min_epu32(_mm256_add_epi32(_mm256_srli_epi32(destB, 16), srcB),
+					                         mask);
+
+					auto dest = _mm256_or_si256(destB, _mm256_slli_epi32(destG, 8));
+					dest = _mm256_or_si256(dest, _mm256_slli_epi32(destR, 16));
+					_mm256_storeu_si256(out, _mm256_blendv_epi8(src, dest, lit));
+				}
+				return x;
+			}
+
+			/** `ApplyFog<SSE2>` on a strip of four rows, two 4x4 blocks at once. */
+			SPADES_TARGET_AVX2 void FogStripAVX2(uint32_t* fb, const float* db, int fw,
+			                                     float vx, float dvx, float vy, float scale,
+			                                     int fogR, int fogG, int fogB) {
+				auto fog = _mm256_setr_epi16(fogB, fogG, fogR, 0, fogB, fogG, fogR, 0, fogB, fogG,
+				                             fogR, 0, fogB, fogG, fogR, 0);
+
+				for (int x = 0; x < fw; x += 8) {
+					float depthScale1 = (1.0F + vx * vx + vy * vy);
+					depthScale1 *= fastRSqrt(depthScale1) * scale;
+					vx += dvx;
+					float depthScale2 = (1.0F + vx * vx + vy * vy);
+					depthScale2 *= fastRSqrt(depthScale2) * scale;
+					vx += dvx;
+					auto depthScale8 = _mm256_setr_ps(depthScale1, depthScale1, depthScale1,
+					                                  depthScale1, depthScale2, depthScale2,
+					                                  depthScale2, depthScale2);
+
+					auto* fb2 = fb + x;
+					auto* db2 = db + x;
+					for (int by = 0; by < 4; by++) {
+						auto* out = reinterpret_cast<__m256i*>(fb2);
+						auto dist = _mm256_loadu_ps(db2);
+						auto color = _mm256_loadu_si256(out);
+
+						dist = _mm256_mul_ps(dist, depthScale8);
+						dist = _mm256_max_ps(dist, _mm256_set1_ps(0.0F));
+						dist = _mm256_min_ps(dist, _mm256_set1_ps(256.0F));
+						auto factorX = _mm256_cvtps_epi32(dist);
+						auto factorY = _mm256_sub_epi32(_mm256_set1_epi32(0x100), factorX);
+
+						factorX = _mm256_shufflelo_epi16(factorX, 0xa0);
+						factorX = _mm256_shufflehi_epi16(factorX, 0xa0);
+						factorY = _mm256_shufflelo_epi16(factorY, 0xa0);
+						factorY = _mm256_shufflehi_epi16(factorY, 0xa0);
+
+						// the 128-bit lanes are the two blocks; each is done like the SSE2 path
+						auto color1 = _mm256_unpacklo_epi8(color, _mm256_setzero_si256());
+						auto factor1X = _mm256_shuffle_epi32(factorY, 0x50);
+						auto factor1Y = _mm256_shuffle_epi32(factorX, 0x50);
+						color1 = _mm256_mullo_epi16(color1, factor1X);
+						auto fog1 = _mm256_mullo_epi16(fog, factor1Y);
+						fog1 = _mm256_adds_epu16(fog1, color1);
+						fog1 = _mm256_srli_epi16(fog1, 8);
+
+						auto color2 = _mm256_unpackhi_epi8(color, _mm256_setzero_si256());
+						auto factor2X = _mm256_shuffle_epi32(factorY, 0xfa);
+						auto factor2Y = _mm256_shuffle_epi32(factorX, 0xfa);
+						color2 = _mm256_mullo_epi16(color2, factor2X);
+						auto fog2 = _mm256_mullo_epi16(fog, factor2Y);
+						fog2 = _mm256_adds_epu16(fog2, color2);
+						fog2 = _mm256_srli_epi16(fog2, 8);
+
+						_mm256_storeu_si256(out, _mm256_packus_epi16(fog1, fog2));
+
+						fb2 += fw;
+						db2 += fw;
+					}
+				}
+			}
+		} // namespace
+#endif
+
+#if ENABLE_NEON
+		namespace {
+			/** `LightSpanAVX2` for NEON, four pixels at a time. */
+			int LightSpanNEON(uint32_t* fb, const float* db, const float* vxs, int width, float vy,
+			                  const Vector3& center, float invRadius2, int lightR, int lightG,
+			                  int lightB) {
+				auto vy4 = vdupq_n_f32(vy);
+				auto centerX = vdupq_n_f32(center.x);
+				auto centerY = vdupq_n_f32(center.y);
+				auto centerZ = vdupq_n_f32(center.z);
+				auto invRadius24 = vdupq_n_f32(invRadius2);
+				auto one = vdupq_n_f32(1.0F);
+				auto mask = vdupq_n_u32(0xff);
+				auto lightR4 = vdupq_n_u32(static_cast<uint32_t>(lightR));
+				auto lightG4 = vdupq_n_u32(static_cast<uint32_t>(lightG));
+				auto lightB4 = vdupq_n_u32(static_cast<uint32_t>(lightB));
+
+				int x = 0;
+				for (; x + 4 <= width; x += 4) {
+					float32x4_t z = vld1q_f32(db + x);
+					float32x4_t px = vsubq_f32(vmulq_f32(vld1q_f32(vxs + x), z), centerX);
+					float32x4_t py = vsubq_f32(vmulq_f32(vy4, z), centerY);
+					float32x4_t pz = vsubq_f32(z, centerZ);
+
+					float32x4_t dist = vaddq_f32(vmulq_f32(px, px), vmulq_f32(py, py));
+					dist = vaddq_f32(dist, vmulq_f32(pz, pz));
+					dist = vmulq_f32(dist, invRadius24);
+
+					uint32x4_t lit = vcltq_f32(dist, one);
+#if defined(__aarch64__)
+					if (vmaxvq_u32(lit) == 0)
+						continue;
+#endif
+
+					float32x4_t strength = vsubq_f32(one, dist);
+					strength = vmulq_f32(strength, strength);
+					strength = vmulq_f32(strength, vdupq_n_f32(256.0F));
+					uint32x4_t factor = vreinterpretq_u32_s32(vcvtq_s32_f32(strength));
+
+					uint32x4_t src = vld1q_u32(fb + x);
+					uint32x4_t srcR = vandq_u32(vshrq_n_u32(src, 16), mask);
+					uint32x4_t srcG = vandq_u32(vshrq_n_u32(src, 8), mask);
+					uint32x4_t srcB = vandq_u32(src, mask);
+
+					uint32x4_t destR = vmulq_u32(vmulq_u32(lightR4, factor), srcR);
+					uint32x4_t destG = vmulq_u32(vmulq_u32(lightG4, factor), srcG);
+					uint32x4_t destB = vmulq_u32(vmulq_u32(lightB4, factor), srcB);
+					destR = vminq_u32(vaddq_u32(vshrq_n_u32(destR, 16), srcR), mask);
+					destG = vminq_u32(vaddq_u32(vshrq_n_u32(destG, 16), srcG), mask);
+					destB = vminq_u32(vaddq_u32(vshrq_n_u32(destB, 16), srcB), mask);
+
+					uint32x4_t dest = vorrq_u32(destB, vshlq_n_u32(destG, 8));
+					dest = vorrq_u32(dest, vshlq_n_u32(destR, 16));
+					vst1q_u32(fb + x, vbslq_u32(lit, dest, src));
+				}
+				return x;
+			}
+		} // namespace
+#endif
+
+		template <SWFeatureLevel level>
+		void SWRenderer::ApplyDynamicLight(const DynamicLight& light) {
 			int fw = this->fb->GetWidth();
 			int fh = this->fb->GetHeight();
 
@@ -258,6 +449,18 @@ namespace spades {
 
 			float invRadius2 = 1.0F / (light.param.radius * light.param.radius);
 
+			// view vector X of each column; the same for every row
+			int lightWidth = maxX - minX;
+			lightViewX.resize(static_cast<std::size_t>(lightWidth));
+			{
+				float vx = fovX + dvx * minX;
+				for (float& v : lightViewX) {
+					v = vx;
+					vx += dvx;
+				}
+			}
+			const float* vxs = lightViewX.data();
+
 			InvokeParallel2([=](unsigned int threadId, unsigned int numThreads) {
 				int startY = lightHeight * threadId / numThreads;
 				int endY = lightHeight * (threadId + 1) / numThreads;
@@ -270,20 +473,27 @@ namespace spades {
 				db += startY * fw + minX;
 
 				float vy = fovY + dvy * startY;
-				float vx = fovX + dvx * minX;
-
-				int lightWidth = maxX - minX;
 
 				for (int y = startY; y < endY; y++) {
-					float vx2 = vx;
-					auto* fb2 = fb;
-					auto* db2 = db;
+					int x = 0;
+#if ENABLE_AVX2
+					if (level == SWFeatureLevel::AVX2)
+						x = LightSpanAVX2(fb, db, vxs, lightWidth, vy, lightCenter, invRadius2,
+						                  lightR, lightG, lightB);
+#endif
+#if ENABLE_NEON
+					if (level == SWFeatureLevel::NEON)
+						x = LightSpanNEON(fb, db, vxs, lightWidth, vy, lightCenter, invRadius2,
+						                  lightR, lightG, lightB);
+#endif
+					auto* fb2 = fb + x;
+					auto* db2 = db + x;
 
-					for (int x = lightWidth; x > 0; x--) {
+					for (; x < lightWidth; x++) {
 						Vector3 pos;
 
 						pos.z = *db2;
-						pos.x = vx2 * pos.z;
+						pos.x = vxs[x] * pos.z;
 						pos.y = vy * pos.z;
 
 						pos -= lightCenter;
@@ -325,7 +535,6 @@ namespace spades {
 							*fb2 = destColor;
 						}
 
-						vx2 += dvx;
 						fb2++;
 						db2++;
 					}
@@ -334,7 +543,7 @@ namespace spades {
 					fb += fw;
 					db += fw;
 				}
-			});
+			}, "SWRenderer::ApplyDynamicLight");
 		}
 
 		template <SWFeatureLevel level> void SWRenderer::ApplyFog() {
@@ -411,7 +620,7 @@ namespace spades {
 					fb += fw * 4;
 					db += fw * 4;
 				}
-			});
+			}, "SWRenderer::ApplyFog");
 
 		} // ApplyFog()
 
@@ -508,7 +717,133 @@ namespace spades {
 					fb += fw * 4;
 					db += fw * 4;
 				}
-			});
+			}, "SWRenderer::ApplyFog");
+
+		} // ApplyFog()
+
+#endif
+
+#if ENABLE_AVX2
+
+		template <> void SWRenderer::ApplyFog<SWFeatureLevel::AVX2>() {
+			int fw = this->fb->GetWidth();
+			int fh = this->fb->GetHeight();
+
+			float fovX = tanf(sceneDef.fovX * 0.5F);
+			float fovY = tanf(sceneDef.fovY * 0.5F);
+
+			float dvx = -fovX * 2.0F / static_cast<float>(fw / 4);
+			float dvy = -fovY * 2.0F / static_cast<float>(fh / 4);
+
+			int fogR = ToFixed8(fogColor.x);
+			int fogG = ToFixed8(fogColor.y);
+			int fogB = ToFixed8(fogColor.z);
+
+			float scale = 255.0F / fogDistance;
+
+			InvokeParallel2([&](unsigned int threadId, unsigned int numThreads) {
+				int startY = fh * threadId / numThreads;
+				int endY = fh * (threadId + 1) / numThreads;
+				startY &= ~3;
+				endY &= ~3;
+
+				float vy = fovY;
+				auto* fb = this->fb->GetPixels();
+				float* db = depthBuffer.data();
+
+				vy += dvy * (startY >> 2);
+				fb += fw * startY;
+				db += fw * startY;
+
+				for (int y = startY; y < endY; y += 4) {
+					FogStripAVX2(fb, db, fw, fovX, dvx, vy, scale, fogR, fogG, fogB);
+
+					vy += dvy;
+					fb += fw * 4;
+					db += fw * 4;
+				}
+			}, "SWRenderer::ApplyFog");
+
+		} // ApplyFog()
+
+#endif
+
+#if ENABLE_NEON
+
+		template <> void SWRenderer::ApplyFog<SWFeatureLevel::NEON>() {
+			int fw = this->fb->GetWidth();
+			int fh = this->fb->GetHeight();
+
+			float fovX = tanf(sceneDef.fovX * 0.5F);
+			float fovY = tanf(sceneDef.fovY * 0.5F);
+
+			float dvx = -fovX * 2.0F / static_cast<float>(fw / 4);
+			float dvy = -fovY * 2.0F / static_cast<float>(fh / 4);
+
+			int fogR = ToFixed8(fogColor.x);
+			int fogG = ToFixed8(fogColor.y);
+			int fogB = ToFixed8(fogColor.z);
+			auto fog1 = vdupq_n_u32(static_cast<uint32_t>(fogB + fogR * 0x10000));
+			auto fog2 = vdupq_n_u32(static_cast<uint32_t>(fogG * 0x100));
+
+			float scale = 255.0F / fogDistance;
+
+			InvokeParallel2([&](unsigned int threadId, unsigned int numThreads) {
+				int startY = fh * threadId / numThreads;
+				int endY = fh * (threadId + 1) / numThreads;
+				startY &= ~3;
+				endY &= ~3;
+
+				float vy = fovY;
+				auto* fb = this->fb->GetPixels();
+				float* db = depthBuffer.data();
+
+				vy += dvy * (startY >> 2);
+				fb += fw * startY;
+				db += fw * startY;
+
+				for (int y = startY; y < endY; y += 4) {
+					float vx = fovX;
+
+					for (int x = 0; x < fw; x += 4) {
+						float depthScale = (1.0F + vx * vx + vy * vy);
+						depthScale *= fastRSqrt(depthScale) * scale;
+						auto depthScale4 = vdupq_n_f32(depthScale);
+
+						auto* fb2 = fb + x;
+						auto* db2 = db + x;
+						for (int by = 0; by < 4; by++) {
+							// the same integer math as the scalar path, one row of the block
+							float32x4_t dist = vmulq_f32(vld1q_f32(db2), depthScale4);
+							int32x4_t factorI = vcvtq_s32_f32(dist);
+							factorI = vmaxq_s32(vminq_s32(factorI, vdupq_n_s32(256)),
+							                    vdupq_n_s32(0));
+							uint32x4_t factor = vreinterpretq_u32_s32(factorI);
+							uint32x4_t factor2 = vsubq_u32(vdupq_n_u32(256), factor);
+
+							uint32x4_t color = vld1q_u32(fb2);
+							uint32x4_t v1 = vmulq_u32(vandq_u32(color, vdupq_n_u32(0xFF00FF)),
+							                          factor2);
+							uint32x4_t v2 = vmulq_u32(vandq_u32(color, vdupq_n_u32(0xFF00)),
+							                          factor2);
+							v1 = vmlaq_u32(v1, fog1, factor);
+							v2 = vmlaq_u32(v2, fog2, factor);
+							v1 = vandq_u32(v1, vdupq_n_u32(0xFF00FF00));
+							v2 = vandq_u32(v2, vdupq_n_u32(0xFF0000));
+							vst1q_u32(fb2, vshrq_n_u32(vorrq_u32(v1, v2), 8));
+
+							fb2 += fw;
+							db2 += fw;
+						}
+
+						vx += dvx;
+					}
+
+					vy += dvy;
+					fb += fw * 4;
+					db += fw * 4;
+				}
+			}, "SWRenderer::ApplyFog");
 
 		} // ApplyFog()
 
@@ -698,9 +1033,17 @@ namespace spades {
 		}
 
 		void SWRenderer::EndScene() {
+			SPADES_TRACE_ZONE("SWRenderer::EndScene");
 			EnsureInitialized();
 			EnsureSceneStarted();
 
+			Stopwatch sw;
+
+			// 2D images drawn before the scene must land before the clear
+			imageRenderer->Flush();
+			frameStats.images += sw.GetTime();
+			sw.Reset();
+
 			// clear scene
 			auto* px = this->fb->GetPixels();
 			std::fill(px, px + fb->GetWidth() * fb->GetHeight(),
@@ -709,28 +1052,62 @@ namespace spades {
 			if (!sceneDef.skipWorld) {
 				// draw map
 				if (mapRenderer) {
+					SPADES_TRACE_ZONE("SWMapRenderer::Render");
 					// flat map renderer sends 'Update RLE' to map renderer.
 					// rendering map before this leads to the corrupted renderer image.
 					flatMapRenderer->Update();
 					mapRenderer->Render(sceneDef, *fb, depthBuffer.data());
 				}
+				frameStats.map += sw.GetTime();
+				sw.Reset();
 
 				// draw models
-				for (const auto& m : models)
-					modelRenderer->Render(*m.model, m.param);
-				models.clear();
+				{
+					SPADES_TRACE_ZONE("SWModelRenderer::Render");
+					for (const auto& m : models)
+						modelRenderer->Render(*m.model, m.param);
+					modelRenderer->Flush();
+					models.clear();
+				}
+				frameStats.models += sw.GetTime();
+				sw.Reset();
 
 				// deferred lighting
-				for (const auto& light : lights)
-					ApplyDynamicLight<SWFeatureLevel::None>(light);
+				for (const auto& light : lights) {
+#if ENABLE_AVX2
+					if (featureLevel >= SWFeatureLevel::AVX2)
+						ApplyDynamicLight<SWFeatureLevel::AVX2>(light);
+					else
+#endif
+#if ENABLE_NEON
+					if (featureLevel >= SWFeatureLevel::NEON)
+						ApplyDynamicLight<SWFeatureLevel::NEON>(light);
+					else
+#endif
+						ApplyDynamicLight<SWFeatureLevel::None>(light);
+				}
 				lights.clear();
+				frameStats.lights += sw.GetTime();
+				sw.Reset();
 
+#if ENABLE_AVX2
+				if (featureLevel >= SWFeatureLevel::AVX2)
+					ApplyFog<SWFeatureLevel::AVX2>();
+				else
+#endif
 #if ENABLE_SSE2
 				if (static_cast<int>(featureLevel) >= static_cast<int>(SWFeatureLevel::SSE2))
 					ApplyFog<SWFeatureLevel::SSE2>();
 				else
+#endif
+#if ENABLE_NEON
+				if (featureLevel >= SWFeatureLevel::NEON)
+					ApplyFog<SWFeatureLevel::NEON>();
+				else
 #endif
 					ApplyFog<SWFeatureLevel::None>();
+				frameStats.fog += sw.GetTime();
+				sw.Reset();
 
 				// render sprites
 				{
@@ -774,7 +1151,9 @@ namespace spades {
 						imageRenderer->DrawPolygon(spr.img.GetPointerOrNull(), v1, v2, v3);
 					}
 					sprites.clear();
+					imageRenderer->Flush();
 				}
+				frameStats.sprites += sw.GetTime();
 			}
 
 			// render debug lines
@@ -907,6 +1286,7 @@ namespace spades {
 			// all objects were rendered
 
 			duringSceneRendering = false;
+			imageStopwatch.Reset();
 		}
 
 		void SWRenderer::MultiplyScreenColor(spades::Vector3 v) { EnsureSceneNotStarted(); }
@@ -1038,16 +1418,33 @@ namespace spades {
 			EnsureValid();
 			EnsureSceneNotStarted();
 
+			imageRenderer->Flush();
+			frameStats.images += imageStopwatch.GetTime();
+			frameStats.polygonPixels = imageRenderer->GetPixelsDrawn();
+			lastFrameStats = frameStats;
+			frameStats = FrameStatistics();
+
 			if (r_swStatistics) {
 				double dur = renderStopwatch.GetTime();
+				const FrameStatistics& st = lastFrameStats;
 				SPLog("==== SWRenderer Statistics ====");
 				SPLog("Elapsed Time: %.3fus", dur * 1000000.0);
-				SPLog("Polygon pixels drawn: %llu", imageRenderer->GetPixelsDrawn());
+				SPLog("Map: %.3fus, Models: %.3fus, Lights: %.3fus, Fog: %.3fus",
+				      st.map * 1000000.0, st.models * 1000000.0, st.lights * 1000000.0,
+				      st.fog * 1000000.0);
+				SPLog("Sprites: %.3fus, Images: %.3fus", st.sprites * 1000000.0,
+				      st.images * 1000000.0);
+				SPLog("Map lines: %u traced, %u reprojected, %dx undersampling",
+				      st.mapLinesBuilt, st.mapLines - st.mapLinesBuilt, st.mapUndersampling);
+				SPLog("Polygon pixels drawn: %llu", st.polygonPixels);
 			}
 
 			imageRenderer->ResetPixelStatistics();
+			imageRenderer->SetDeferred(r_swDeferredImages);
 			renderStopwatch.Reset();
 			port->Swap();
+			// A frame without a scene is all 2D
+			imageStopwatch.Reset();
 
 			// next frame's framebuffer
 			SetFramebuffer(&port->GetFramebuffer());
@@ -1058,6 +1455,8 @@ namespace spades {
 			EnsureValid();
 			EnsureSceneNotStarted();
 
+			imageRenderer->Flush();
+
 			int w = fb->GetWidth();
 			int h = fb->GetHeight();
 			uint32_t* inPix = fb->GetPixels();
@@ -1106,5 +1505,14 @@ namespace spades {
 
 			flatMapRenderer->SetNeedsUpdate(x, y);
 		}
+
+		void SWRenderer::GameMapChangedRegion(const IntAABB3& region, client::GameMap* map) {
+			if (map != this->map.GetPointerOrNull())
+				return;
+
+			for (int x = region.min.x; x < region.max.x; x++)
+				for (int y = region.min.y; y < region.max.y; y++)
+					flatMapRenderer->SetNeedsUpdate(x, y);
+		}
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
@@ -50,6 +50,33 @@ namespace spades {
 			friend class SWModelRenderer;
 			friend class SWMapRenderer;
 
+		public:
+			/** The time spent in each stage of a frame, in seconds. */
+			struct FrameStatistics {
+				double map = 0.0;
+				double models = 0.0;
+				double lights = 0.0;
+				double fog = 0.0;
+				double sprites = 0.0;
+				/**
+				 * The 2D phase, from `EndScene` to `Flip`, plus the images drawn before the
+				 * scene. Includes the deferred rasterization.
+				 */
+				double images = 0.0;
+				unsigned long long polygonPixels = 0;
+
+				/** The map renderer's undersampling factor and number of lines. */
+				int mapUndersampling = 1;
+				unsigned int mapLines = 0;
+				/** The number of map lines that were traced instead of reprojected. */
+				unsigned int mapLinesBuilt = 0;
+
+				double GetTotalTime() const {
+					return map + models + lights + fog + sprites + images;
+				}
+			};
+
+		private:
 			SWFeatureLevel featureLevel;
 
 			Handle<SWPort> port;
@@ -57,6 +84,8 @@ namespace spades {
 
 			Handle<Bitmap> fb;
 			std::vector<float> depthBuffer;
+			/** Scratch space of `ApplyDynamicLight`. */
+			std::vector<float> lightViewX;
 
 			std::shared_ptr<SWImageManager> imageManager;
 			std::shared_ptr<SWModelManager> modelManager;
@@ -123,6 +152,10 @@ namespace spades {
 			unsigned int lastTime;
 
 			Stopwatch renderStopwatch;
+			/** Measures `FrameStatistics::images`. Reset at the end of the scene. */
+			Stopwatch imageStopwatch;
+			FrameStatistics frameStats;
+			FrameStatistics lastFrameStats;
 
 			bool duringSceneRendering;
 
@@ -193,6 +226,11 @@ namespace spades {
 			               const Vector2 &outTopRight, const Vector2 &outBottomLeft,
 			               const AABB2 &inRect) override;
 			
+			/** Returns the statistics of the frame presented by the last `Flip`. */
+			const FrameStatistics &GetLastFrameStatistics() { return lastFrameStats; }
+			/** Returns the depth buffer of the last rendered scene. */
+			const std::vector<float> &GetDepthBuffer() const { return depthBuffer; }
+
 			void UpdateFlatGameMap() override;
 			void DrawFlatGameMap(const AABB2 &outRect, const AABB2 &inRect) override;
 
@@ -208,6 +246,7 @@ namespace spades {
 			const Matrix4 &GetViewMatrix() const { return viewMatrix; }
 
 			void GameMapChanged(int x, int y, int z, client::GameMap *) override;
+			void GameMapChangedRegion(const IntAABB3 &, client::GameMap *) override;
 
 			const client::SceneDefinition &GetSceneDef() const { return sceneDef; }
 
@@ -21,46 +21,46 @@
 #pragma once
 
 #include <algorithm>
-#include <array>
-#include <memory>
+#include <cstddef>
 
-#include <Core/ConcurrentDispatch.h>
 #include <Core/Debug.h>
+#include <Core/ThreadPool.h>
+#include <Core/TraceProfiler.h>
 
 namespace spades {
 	namespace draw {
 		int GetNumSWRendererThreads();
 
+		/**
+		 * Calls `f(i)` for every `i` in `[0, numThreads)` on the shared thread pool and waits
+		 * for all of them to finish.
+		 */
 		template <class F> static void InvokeParallel(F f, unsigned int numThreads) {
 			SPAssert(numThreads <= 32);
-			std::array<std::unique_ptr<ConcurrentDispatch>, 32> disp;
-			for (auto i = 1U; i < numThreads; i++) {
-				auto ff = [i, &f]() { f(i); };
-				disp[i] = std::unique_ptr<ConcurrentDispatch>(
-				  static_cast<ConcurrentDispatch*>(new FunctionDispatch<decltype(ff)>(ff)));
-				disp[i]->Start();
-			}
-			f(0);
-			for (auto i = 1U; i < numThreads; i++)
-				disp[i]->Join();
+			ParallelFor(numThreads, 1, [&f](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; i++)
+					f(static_cast<unsigned int>(i));
+			});
 		}
 
-		template <class F> static void InvokeParallel2(F f) {
+		/**
+		 * Splits the work into `r_swNumThreads` parts and calls `f(i, numParts)` for each of
+		 * them on the shared thread pool. Each part is recorded as a trace zone named
+		 * `traceName`.
+		 */
+		template <class F> static void InvokeParallel2(F f, const char* traceName) {
 
 			unsigned int numThreads = static_cast<unsigned int>(GetNumSWRendererThreads());
 			numThreads = std::max(numThreads, 1U);
 			numThreads = std::min(numThreads, 32U);
 
-			std::array<std::unique_ptr<ConcurrentDispatch>, 32> disp;
-			for (auto i = 1U; i < numThreads; i++) {
-				auto ff = [i, &f, numThreads]() { f(i, numThreads); };
-				disp[i] = std::unique_ptr<ConcurrentDispatch>(
-				  static_cast<ConcurrentDispatch*>(new FunctionDispatch<decltype(ff)>(ff)));
-				disp[i]->Start();
-			}
-			f(0, numThreads);
-			for (auto i = 1U; i < numThreads; i++)
-				disp[i]->Join();
+			ParallelFor(numThreads, 1,
+			            [&f, numThreads, traceName](std::size_t begin, std::size_t end) {
+				            for (std::size_t i = begin; i < end; i++) {
+					            SPADES_TRACE_ZONE(traceName);
+					            f(static_cast<unsigned int>(i), numThreads);
+				            }
+			            });
 		}
 
 		static inline PURE int ToFixed8(float v) {
@@ -17,10 +17,15 @@
  along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
 
  */
+#include <ctime>
+
 #include <ScriptBindings/Config.h>
 #include <ScriptBindings/ScriptFunction.h>
 
 #include <Client/Fonts.h>
+#include <Core/FileManager.h>
+#include <Core/IStream.h>
+#include <Core/TraceProfiler.h>
 
 #include "ConfigConsoleResponder.h"
 #include "ConsoleCommand.h"
@@ -223,12 +228,32 @@ namespace spades {
 			constexpr const char* CMD_HELP = "help";
 			constexpr const char* CMD_CLEARGFXCACHE = "cleargfxcache";
 			constexpr const char* CMD_CLEARSFXCACHE = "clearsfxcache";
+			constexpr const char* CMD_TRACESTART = "tracestart";
+			constexpr const char* CMD_TRACESTOP = "tracestop";
+			constexpr const char* CMD_TRACESAVE = "tracesave";
 
 			std::map<std::string, std::string> const g_commands{
 			  {CMD_HELP, ": Display all available commands"},
 			  {CMD_CLEARGFXCACHE, ": Clear the GFX (models and images) cache, forcing reload"},
 			  {CMD_CLEARSFXCACHE, ": Clear the SFX cache, forcing reload"},
+			  {CMD_TRACESTART, ": Start recording a CPU trace of the last few seconds"},
+			  {CMD_TRACESTOP, ": Stop recording the CPU trace"},
+			  {CMD_TRACESAVE, ": Save the recorded CPU trace for chrome://tracing or Perfetto"},
 			};
+
+			void SaveTrace() {
+				char buf[256];
+				std::time_t t = std::time(nullptr);
+				std::strftime(buf, sizeof(buf), "Traces/trace_%Y%m%d%H%M%S.json",
+				              std::localtime(&t));
+				try {
+					auto stream = FileManager::OpenForWriting(buf);
+					trace::Save(*stream);
+					SPLog("CPU trace saved to '%s'", buf);
+				} catch (const std::exception& ex) {
+					SPLog("Failed to save the CPU trace to '%s' (%s)", buf, ex.what());
+				}
+			}
 		} // namespace
 
 		bool ConsoleScreen::ExecCommand(const Handle<ConsoleCommand>& command) {
@@ -254,6 +279,29 @@ namespace spades {
 				}
 				audioDevice->ClearCache();
 				return true;
+			} else if (command->GetName() == CMD_TRACESTART) {
+				if (command->GetNumArguments() != 0) {
+					SPLog("Usage: %s (no arguments)", CMD_TRACESTART);
+					return true;
+				}
+				trace::Start();
+				SPLog("CPU trace recording started");
+				return true;
+			} else if (command->GetName() == CMD_TRACESTOP) {
+				if (command->GetNumArguments() != 0) {
+					SPLog("Usage: %s (no arguments)", CMD_TRACESTOP);
+					return true;
+				}
+				trace::Stop();
+				SPLog("CPU trace recording stopped");
+				return true;
+			} else if (command->GetName() == CMD_TRACESAVE) {
+				if (command->GetNumArguments() != 0) {
+					SPLog("Usage: %s (no arguments)", CMD_TRACESAVE);
+					return true;
+				}
+				SaveTrace();
+				return true;
 			}
 			return ConfigConsoleResponder::ExecCommand(command) || subview->ExecCommand(command);
 		}
@@ -28,6 +28,7 @@
 #include "SDLGLDevice.h"
 #include <Audio/ALDevice.h>
 #include <Audio/NullDevice.h>
+#include <Audio/SoftDevice.h>
 #include <Audio/YsrDevice.h>
 #include <Client/Client.h>
 #include <Core/ConcurrentDispatch.h>
@@ -37,6 +38,7 @@
 #include <Core/IStream.h>
 #include <Core/Math.h>
 #include <Core/Settings.h>
+#include <Core/TraceProfiler.h>
 #include <Draw/GLRenderer.h>
 #include <Draw/SWPort.h>
 #include <Draw/SWRenderer.h>
@@ -67,10 +69,12 @@ namespace spades {
 				return new audio::ALDevice();
 			} else if (EqualsIgnoringCase(s_audioDriver, "ysr")) {
 				return new audio::YsrDevice();
+			} else if (EqualsIgnoringCase(s_audioDriver, "soft")) {
+				return new audio::SoftDevice();
 			} else if (EqualsIgnoringCase(s_audioDriver, "null")) {
 				return new audio::NullDevice();
 			} else {
-				SPRaise("Unknown audio driver name: %s (openal or ysr expected)",
+				SPRaise("Unknown audio driver name: %s (openal, ysr, or soft expected)",
 				        s_audioDriver.CString());
 			}
 		}
@@ -202,8 +206,10 @@ namespace spades {
 				bool absoluteMouseCoord = true;
 
 				SPLog("Starting Client Loop");
+				trace::SetThreadName("Main");
 
 				while (running) {
+					SPADES_TRACE_ZONE("Frame");
 					SDL_Event event;
 
 					DispatchQueue::GetThreadQueue()->ProcessQueue();